@@ -0,0 +1,58 @@
+/*
+ * Benchmarks for tc_calendar and tc_tz
+ *
+ * Numbers are host numbers; use them to compare
+ * changes, not to predict ESP32 timing.
+ */
+
+#include <string.h>
+
+#include "tc_calendar.h"
+#include "tc_tz.h"
+#include "host_test.h"
+
+#define N 2000000
+
+int main()
+{
+    const char *tz = "CET-1CEST,M3.5.0,M10.5.0/3";
+    tzZone z;
+    int y, m, d, h, mm, ctm;
+
+    #ifdef TC_JULIAN_CAL
+    calcJulianData();
+    printf("TC_JULIAN_CAL\n");
+    #endif
+
+    memset(&z, 0, sizeof(z));
+    tzParse(z, tz, 2025);
+
+    BENCH("isLeapYear", N, benchSink += isLeapYear(1 + (i % 9999)));
+    BENCH("dayOfWeek", N, benchSink += dayOfWeek(1 + (i % 28), 1 + (i % 12), 1 + (i % 9999)));
+    BENCH("mins2Date", N, benchSink += mins2Date(2025, 1 + (i % 12), 1 + (i % 28), i % 24, i % 60));
+    BENCH("dateToMins", N, benchSink += dateToMins(1 + (i % 9999), 1 + (i % 12), 1 + (i % 28), i % 24, i % 60));
+    BENCH("minsToDate", N, {
+        minsToDate((uint64_t)i * 2663, y, m, d, h, mm);
+        benchSink += y + m + d + h + mm;
+    });
+
+    BENCH("tzParse (cached year)", N, benchSink += tzParse(z, tz, 2020 + (i & 3)));
+    BENCH("tzParse (new year)", N / 10, benchSink += tzParse(z, tz, 1900 + (i % 200)));
+    tzParse(z, tz, 2025);
+    BENCH("tzIsDST", N, benchSink += tzIsDST(z, 2025, 1 + (i % 12), 1 + (i % 28), i % 24, i % 60, ctm));
+    BENCH("tzUTCtoLocal (same minute)", N, {
+        y = 2025; m = 6; d = 1; h = 12; mm = 0;
+        benchSink += tzUTCtoLocal(z, tz, y, m, d, h, mm) + h;
+    });
+    BENCH("tzUTCtoLocal (new minute)", N, {
+        y = 2025; m = 1 + (i % 12); d = 1 + (i % 28); h = i % 24; mm = i % 60;
+        benchSink += tzUTCtoLocal(z, tz, y, m, d, h, mm) + h;
+    });
+    BENCH("tzLocalToUTC", N, {
+        y = 2025; m = 1 + (i % 12); d = 1 + (i % 28); h = i % 24; mm = i % 60;
+        tzLocalToUTC(z, y, m, d, h, mm);
+        benchSink += h;
+    });
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef _HOST_GLOBAL_H
+#define _HOST_GLOBAL_H
+
+/*
+ * Force-included in place of tc_global.h for the host build.
+ * TC_JULIAN_CAL is set (or not) on the command line.
+ */
+#define _TC_GLOBAL_H
+
+#endif
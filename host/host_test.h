@@ -0,0 +1,43 @@
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+/*
+ * Minimal test/benchmark helpers for the host build
+ */
+
+static int testFails = 0;
+static int testChecks = 0;
+
+#define CHECK(c, ...) do {                                      \
+        testChecks++;                                           \
+        if(!(c)) {                                              \
+            if(++testFails <= 20) {                             \
+                printf("%s:%d: FAILED: %s: ", __FILE__, __LINE__, #c); \
+                printf(__VA_ARGS__);                            \
+                printf("\n");                                   \
+            }                                                   \
+        }                                                       \
+    } while(0)
+
+static inline int testResult(const char *name)
+{
+    printf("%s: %d checks, %d failures\n", name, testChecks, testFails);
+    return testFails ? 1 : 0;
+}
+
+// Compiler barrier for benchmark results
+static volatile uint64_t benchSink;
+
+#define BENCH(name, n, body) do {                               \
+        auto _t0 = std::chrono::steady_clock::now();            \
+        for(uint32_t i = 0; i < (n); i++) { body; }             \
+        auto _t1 = std::chrono::steady_clock::now();            \
+        double _ns = std::chrono::duration<double, std::nano>(_t1 - _t0).count(); \
+        printf("%-28s %10.1f ns/op\n", name, _ns / (n));        \
+    } while(0)
+
+#endif
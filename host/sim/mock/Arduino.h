@@ -0,0 +1,152 @@
+#ifndef _MOCK_ARDUINO_H
+#define _MOCK_ARDUINO_H
+
+/*
+ * Arduino/ESP32 core for the host simulator
+ *
+ * Time is simulated (see sim.h): millis(), micros() and
+ * esp_timer_get_time() return simulated time, delay() advances
+ * it. Every call of a time function costs a little simulated
+ * time, so polling loops terminate.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "IPAddress.h"
+#include "binary.h"
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define PULLUP          0x04
+#define INPUT_PULLUP    0x05
+#define PULLDOWN        0x08
+#define INPUT_PULLDOWN  0x09
+#define RISING          0x01
+#define FALLING         0x02
+#define CHANGE          0x03
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define PROGMEM
+#define F(s)            (s)
+#define pgm_read_byte(a) (*(const uint8_t *)(a))
+
+#define digitalPinToInterrupt(p) (p)
+
+#define ARDUINO_RUNNING_CORE 1
+
+bool          setCpuFrequencyMhz(uint32_t mhz);
+uint32_t      getCpuFrequencyMhz();
+
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+
+unsigned long millis();
+unsigned long micros();
+void          delay(uint32_t ms);
+void          delayMicroseconds(uint32_t us);
+void          yield();
+
+void          pinMode(uint8_t pin, uint8_t mode);
+void          digitalWrite(uint8_t pin, uint8_t val);
+int           digitalRead(uint8_t pin);
+uint16_t      analogRead(uint8_t pin);
+void          analogReadResolution(uint8_t bits);
+void          attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void          attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode);
+void          detachInterrupt(uint8_t pin);
+
+long          random(long max);
+long          random(long min, long max);
+void          randomSeed(unsigned long seed);
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buf, size_t len);
+        size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+        size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+        size_t print(const char *s) { return write(s); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int n);
+        size_t print(unsigned int n);
+        size_t print(long n);
+        size_t print(unsigned long n);
+        size_t print(double n, int digits = 2);
+        size_t println() { return write("\n"); }
+        size_t println(const char *s) { return print(s) + println(); }
+        size_t println(char c) { return print(c) + println(); }
+        size_t println(int n) { return print(n) + println(); }
+        size_t println(unsigned int n) { return print(n) + println(); }
+        size_t println(long n) { return print(n) + println(); }
+        size_t println(unsigned long n) { return print(n) + println(); }
+        size_t println(double n, int digits = 2) { return print(n, digits) + println(); }
+};
+
+class Stream : public Print {
+    public:
+        virtual int available() { return 0; }
+        virtual int read() { return -1; }
+        virtual int peek() { return -1; }
+        virtual void flush() {}
+};
+
+class HardwareSerial : public Stream {
+    public:
+        HardwareSerial(int num) : _num(num) {}
+        void   begin(unsigned long baud, uint32_t config = 0, int8_t rx = -1, int8_t tx = -1) {}
+        void   end() {}
+        void   setRxBufferSize(size_t s) {}
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buf, size_t len);
+        using Print::write;
+        operator bool() const { return true; }
+    private:
+        int    _num;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#define SERIAL_8N1 0x800001c
+
+class EspClass {
+    public:
+        uint32_t getCycleCount();
+        uint32_t getFreeHeap() { return 120000; }
+        uint32_t getMinFreeHeap() { return 100000; }
+        uint32_t getMaxAllocHeap() { return 100000; }
+        uint32_t getHeapSize() { return 300000; }
+        uint32_t getPsramSize() { return 0; }
+        uint32_t getFreePsram() { return 0; }
+        uint32_t getCpuFreqMHz() { return 240; }
+        const char *getSdkVersion() { return "sim"; }
+        void     restart();
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _MOCK_ASYNCUDP_H
+#define _MOCK_ASYNCUDP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+#include "IPAddress.h"
+
+/*
+ * UDP on the simulated network (see sim_net.cpp)
+ *
+ * Packets sent are handed to the simulated peers and counted;
+ * packets from peers are delivered to the callback of the 
+ * socket listening on the destination port.
+ */
+
+class AsyncUDPPacket {
+    public:
+        AsyncUDPPacket(const uint8_t *data, size_t len, IPAddress ip, uint16_t port)
+            : _data(data), _len(len), _ip(ip), _port(port) {}
+        const uint8_t *data() { return _data; }
+        size_t    length() { return _len; }
+        IPAddress remoteIP() { return _ip; }
+        uint16_t  remotePort() { return _port; }
+    private:
+        const uint8_t *_data;
+        size_t    _len;
+        IPAddress _ip;
+        uint16_t  _port;
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+class AsyncUDP {
+    public:
+        ~AsyncUDP();
+        bool   listen(uint16_t port);
+        bool   listenMulticast(IPAddress ip, uint16_t port);
+        void   onPacket(AuPacketHandlerFunction cb) { _cb = cb; }
+        size_t writeTo(const uint8_t *data, size_t len, IPAddress ip, uint16_t port);
+        void   close();
+
+        // Simulator: Deliver packet to this socket
+        void   deliver(const uint8_t *data, size_t len, IPAddress ip, uint16_t port);
+        uint16_t port() { return _port; }
+        bool   isMulticast() { return _mc; }
+
+    private:
+        AuPacketHandlerFunction _cb;
+        uint16_t _port = 0;
+        bool     _mc = false;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _MOCK_IPADDRESS_H
+#define _MOCK_IPADDRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+class IPAddress {
+    public:
+        IPAddress() : _a(0) {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+            : _a((uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24)) {}
+        IPAddress(uint32_t a) : _a(a) {}
+
+        operator uint32_t() const { return _a; }
+        uint8_t operator[](int i) const { return (_a >> (i * 8)) & 0xff; }
+        bool operator==(const IPAddress& o) const { return _a == o._a; }
+        bool operator!=(const IPAddress& o) const { return _a != o._a; }
+
+        bool fromString(const char *s)
+        {
+            unsigned int a, b, c, d;
+            if(sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+            *this = IPAddress(a, b, c, d);
+            return true;
+        }
+
+        // Static buffer; good enough for printf()
+        const char *toString() const
+        {
+            static char buf[4][16];
+            static int n = 0;
+            char *s = buf[n++ & 3];
+            snprintf(s, 16, "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+            return s;
+        }
+
+    private:
+        uint32_t _a;
+};
+
+#endif
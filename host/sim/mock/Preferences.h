@@ -0,0 +1,24 @@
+#ifndef _MOCK_PREFERENCES_H
+#define _MOCK_PREFERENCES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// NVS: Nothing is stored, every key reads as absent
+class Preferences {
+    public:
+        bool   begin(const char *name, bool readOnly = false) { return true; }
+        void   end() {}
+        bool   clear() { return true; }
+        bool   remove(const char *key) { return true; }
+        bool   isKey(const char *key) { return false; }
+        size_t putBytes(const char *key, const void *v, size_t len) { return len; }
+        size_t getBytes(const char *key, void *buf, size_t len) { return 0; }
+        size_t getBytesLength(const char *key) { return 0; }
+        size_t putUChar(const char *key, uint8_t v) { return 1; }
+        uint8_t getUChar(const char *key, uint8_t def = 0) { return def; }
+        size_t putUInt(const char *key, uint32_t v) { return 4; }
+        uint32_t getUInt(const char *key, uint32_t def = 0) { return def; }
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef _MOCK_WIFI_H
+#define _MOCK_WIFI_H
+
+#include <stdint.h>
+
+#include "IPAddress.h"
+
+typedef enum {
+    WL_NO_SHIELD = 255, WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL, WL_SCAN_COMPLETED,
+    WL_CONNECTED, WL_CONNECT_FAILED, WL_CONNECTION_LOST, WL_DISCONNECTED
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+class WiFiClass {
+    public:
+        wl_status_t status();
+        wifi_mode_t getMode() { return WIFI_STA; }
+        IPAddress   localIP() { return IPAddress(192, 168, 4, 10); }
+        IPAddress   softAPIP() { return IPAddress(192, 168, 4, 1); }
+        int8_t      RSSI() { return -50; }
+        int         hostByName(const char *host, IPAddress& ip);
+};
+
+extern WiFiClass WiFi;
+
+#endif
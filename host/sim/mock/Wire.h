@@ -0,0 +1,68 @@
+#ifndef _MOCK_WIRE_H
+#define _MOCK_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * I2C bus on simulated time
+ *
+ * Transactions go to the devices registered with the simulator
+ * (see sim_i2c.cpp). Every bit costs simulated bus time at the
+ * bus clock, and every byte (including address bytes) is
+ * counted per device address.
+ */
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire {
+
+    public:
+
+        TwoWire(int num) : _num(num) {}
+
+        bool    begin(int sda = -1, int scl = -1, uint32_t freq = 100000);
+        bool    end() { return true; }
+        bool    setClock(uint32_t freq) { _freq = freq; return true; }
+        uint32_t getClock() { return _freq; }
+        size_t  setBufferSize(size_t s) { return s; }
+        void    setTimeOut(uint16_t ms) {}
+
+        void    beginTransmission(uint16_t addr);
+        void    beginTransmission(int addr) { beginTransmission((uint16_t)addr); }
+        void    beginTransmission(uint8_t addr) { beginTransmission((uint16_t)addr); }
+        uint8_t endTransmission(bool sendStop = true);
+
+        size_t  write(uint8_t c);
+        size_t  write(const uint8_t *buf, size_t len);
+        size_t  write(int c) { return write((uint8_t)c); }
+
+        uint8_t requestFrom(uint16_t addr, uint8_t len, bool sendStop = true);
+        uint8_t requestFrom(uint8_t addr, uint8_t len) { return requestFrom((uint16_t)addr, len, true); }
+        uint8_t requestFrom(int addr, int len) { return requestFrom((uint16_t)addr, (uint8_t)len, true); }
+        uint8_t requestFrom(uint8_t addr, size_t len) { return requestFrom((uint16_t)addr, (uint8_t)len, true); }
+        uint8_t requestFrom(uint16_t addr, size_t len, bool sendStop = true) { return requestFrom(addr, (uint8_t)len, sendStop); }
+
+        int     available() { return _rxLen - _rxPos; }
+        int     read() { return (_rxPos < _rxLen) ? _rx[_rxPos++] : -1; }
+        int     peek() { return (_rxPos < _rxLen) ? _rx[_rxPos] : -1; }
+        void    flush() {}
+
+    private:
+
+        void    busTime(int bytes);
+
+        int      _num;
+        uint32_t _freq = 100000;
+        uint16_t _txAddr = 0;
+        uint8_t  _tx[I2C_BUFFER_LENGTH];
+        size_t   _txLen = 0;
+        uint8_t  _rx[I2C_BUFFER_LENGTH];
+        int      _rxLen = 0;
+        int      _rxPos = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef _MOCK_DRIVER_GPIO_H
+#define _MOCK_DRIVER_GPIO_H
+
+#include <stdint.h>
+#include "esp_system.h"
+
+typedef int gpio_num_t;
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level);
+
+#endif
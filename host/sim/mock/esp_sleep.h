@@ -0,0 +1,9 @@
+#ifndef _MOCK_ESP_SLEEP_H
+#define _MOCK_ESP_SLEEP_H
+
+#include "esp_system.h"
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us);
+esp_err_t esp_light_sleep_start();
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _MOCK_ESP_SYSTEM_H
+#define _MOCK_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+typedef enum {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC,
+    ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP,
+    ESP_RST_BROWNOUT, ESP_RST_SDIO
+} esp_reset_reason_t;
+
+typedef int esp_err_t;
+#define ESP_OK    0
+#define ESP_FAIL  -1
+
+esp_reset_reason_t esp_reset_reason();
+void               esp_restart();
+uint32_t           esp_random();
+
+#endif
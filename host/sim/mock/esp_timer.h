@@ -0,0 +1,33 @@
+#ifndef _MOCK_ESP_TIMER_H
+#define _MOCK_ESP_TIMER_H
+
+#include <stdint.h>
+#include "esp_system.h"
+
+/*
+ * esp_timer on simulated time: Callbacks run from sim time
+ * advances (see sim.cpp), like on the esp_timer task.
+ */
+
+typedef struct simTimer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t        callback;
+    void                  *arg;
+    esp_timer_dispatch_t  dispatch_method;
+    const char            *name;
+    bool                  skip_unhandled_events;
+} esp_timer_create_args_t;
+
+int64_t   esp_timer_get_time();
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t us);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t us);
+esp_err_t esp_timer_stop(esp_timer_handle_t t);
+esp_err_t esp_timer_delete(esp_timer_handle_t t);
+bool      esp_timer_is_active(esp_timer_handle_t t);
+
+#endif
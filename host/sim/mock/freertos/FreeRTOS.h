@@ -0,0 +1,52 @@
+#ifndef _MOCK_FREERTOS_H
+#define _MOCK_FREERTOS_H
+
+#include <stdint.h>
+
+/*
+ * The simulator is single-threaded: No task is ever started
+ * (creation fails), locks are no-ops.
+ */
+
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *QueueHandle_t;
+typedef int   BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdPASS            1
+#define pdFAIL            0
+#define pdTRUE            1
+#define pdFALSE           0
+#define portMAX_DELAY     0xffffffff
+#define pdMS_TO_TICKS(x)  (x)
+#define portTICK_PERIOD_MS 1
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY    0x7fffffff
+
+typedef struct { int dummy; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(m)      do { (void)(m); } while(0)
+#define portEXIT_CRITICAL(m)       do { (void)(m); } while(0)
+#define portENTER_CRITICAL_ISR(m)  do { (void)(m); } while(0)
+#define portEXIT_CRITICAL_ISR(m)   do { (void)(m); } while(0)
+#define taskENTER_CRITICAL(m)      do { (void)(m); } while(0)
+#define taskEXIT_CRITICAL(m)       do { (void)(m); } while(0)
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t   xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack,
+                                     void *arg, UBaseType_t prio, TaskHandle_t *h, BaseType_t core);
+void         vTaskDelay(TickType_t t);
+void         vTaskDelete(TaskHandle_t h);
+BaseType_t   xPortGetCoreID();
+TickType_t   xTaskGetTickCount();
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+BaseType_t   xSemaphoreTake(SemaphoreHandle_t s, TickType_t t);
+BaseType_t   xSemaphoreGive(SemaphoreHandle_t s);
+BaseType_t   xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t t);
+BaseType_t   xSemaphoreGiveRecursive(SemaphoreHandle_t s);
+
+#endif
@@ -0,0 +1,520 @@
+/*
+ * Host simulator: Simulated time, events, GPIO, and the
+ * Arduino/ESP-IDF/FreeRTOS functions used by the firmware
+ */
+
+#include <Arduino.h>
+#include <esp_rom_crc.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+#include <vector>
+
+#include "sim.h"
+
+uint64_t simUs = 1000;
+bool     simVerbose = false;
+
+/*
+ * Events
+ */
+
+typedef struct {
+    uint64_t              when;
+    int                   id;
+    std::function<void()> fn;
+} simEvent;
+
+static std::vector<simEvent> events;
+static int      nextId = 1;
+static int      inEvent = 0;
+
+int simAt(uint64_t when, std::function<void()> fn)
+{
+    simEvent e = { when, nextId++, fn };
+    events.push_back(e);
+    return e.id;
+}
+
+void simCancel(int id)
+{
+    for(size_t i = 0; i < events.size(); i++) {
+        if(events[i].id == id) {
+            events.erase(events.begin() + i);
+            return;
+        }
+    }
+}
+
+// Run all events due up to 'when' (in order of time, then
+// of scheduling), then set the time to 'when'
+void simAdvanceTo(uint64_t when)
+{
+    // Events run "on other tasks": Time does not advance
+    // from within, and they don't run nested
+    if(inEvent)
+        return;
+
+    for(;;) {
+        int best = -1;
+        for(size_t i = 0; i < events.size(); i++) {
+            if(events[i].when <= when &&
+               (best < 0 || events[i].when < events[best].when ||
+                (events[i].when == events[best].when && events[i].id < events[best].id))) {
+                best = i;
+            }
+        }
+        if(best < 0)
+            break;
+
+        simEvent e = events[best];
+        events.erase(events.begin() + best);
+        if(e.when > simUs) simUs = e.when;
+        inEvent++;
+        e.fn();
+        inEvent--;
+    }
+
+    if(when > simUs) simUs = when;
+}
+
+void simAdvance(uint64_t us)
+{
+    simAdvanceTo(simUs + us);
+}
+
+static uint64_t wallBaseUs = 0;     // UTC at simUs 0
+
+void simSetWallClock(uint64_t utcUs)
+{
+    wallBaseUs = utcUs - simUs;
+}
+
+uint64_t simWallUs()
+{
+    return wallBaseUs + simUs;
+}
+
+/*
+ * Time
+ */
+
+static void callCost()
+{
+    simAdvance(SIM_CALL_US);
+}
+
+unsigned long millis()
+{
+    callCost();
+    return (unsigned long)(simUs / 1000);
+}
+
+unsigned long micros()
+{
+    callCost();
+    return (unsigned long)simUs;
+}
+
+int64_t esp_timer_get_time()
+{
+    callCost();
+    return (int64_t)simUs;
+}
+
+void delay(uint32_t ms)
+{
+    simAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    simAdvance(us);
+}
+
+void yield()
+{
+    callCost();
+}
+
+/*
+ * esp_timer: Callbacks are events
+ */
+
+struct simTimer {
+    esp_timer_cb_t cb;
+    void     *arg;
+    uint64_t period;
+    int      ev;
+};
+
+static void timerFire(simTimer *t)
+{
+    if(t->period) {
+        t->ev = simAt(simUs + t->period, [t]() { timerFire(t); });
+    } else {
+        t->ev = 0;
+    }
+    t->cb(t->arg);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    simTimer *t = new simTimer;
+    t->cb = args->callback;
+    t->arg = args->arg;
+    t->period = 0;
+    t->ev = 0;
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t us)
+{
+    if(t->ev) return ESP_FAIL;
+    t->period = 0;
+    t->ev = simAt(simUs + us, [t]() { timerFire(t); });
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t us)
+{
+    if(t->ev) return ESP_FAIL;
+    t->period = us;
+    t->ev = simAt(simUs + us, [t]() { timerFire(t); });
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t)
+{
+    if(!t->ev) return ESP_FAIL;
+    simCancel(t->ev);
+    t->ev = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t)
+{
+    if(t->ev) simCancel(t->ev);
+    delete t;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t t)
+{
+    return t->ev != 0;
+}
+
+/*
+ * GPIO
+ */
+
+#define SIM_PINS 40
+
+static uint8_t pinModes[SIM_PINS];
+static uint8_t pinLevel[SIM_PINS];
+static bool    pinDriven[SIM_PINS];
+static void  (*pinISR[SIM_PINS])(void *);
+static void   *pinISRArg[SIM_PINS];
+static void  (*pinISRNoArg[SIM_PINS])(void);
+static int     pinISRMode[SIM_PINS];
+
+static void pinUpdate(uint8_t pin, int level)
+{
+    int old = pinLevel[pin];
+
+    pinLevel[pin] = level;
+
+    if(old == level || !pinISRMode[pin])
+        return;
+
+    if(pinISRMode[pin] == CHANGE ||
+       (pinISRMode[pin] == RISING && level) ||
+       (pinISRMode[pin] == FALLING && !level)) {
+        inEvent++;
+        if(pinISR[pin]) pinISR[pin](pinISRArg[pin]);
+        else if(pinISRNoArg[pin]) pinISRNoArg[pin]();
+        inEvent--;
+    }
+}
+
+// Level of an input nobody drives
+static int pinIdleLevel(uint8_t pin)
+{
+    return ((pinModes[pin] & PULLUP) == PULLUP) ? HIGH : LOW;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if(pin >= SIM_PINS) return;
+    pinModes[pin] = mode;
+    if(!pinDriven[pin] && mode != OUTPUT) {
+        pinLevel[pin] = pinIdleLevel(pin);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if(pin >= SIM_PINS) return;
+    pinLevel[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    if(pin >= SIM_PINS) return LOW;
+    return pinLevel[pin];
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    digitalWrite(pin, level);
+    return ESP_OK;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return 0;
+}
+
+void analogReadResolution(uint8_t bits)
+{
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+    if(pin >= SIM_PINS) return;
+    pinISRNoArg[pin] = isr;
+    pinISR[pin] = NULL;
+    pinISRMode[pin] = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode)
+{
+    if(pin >= SIM_PINS) return;
+    pinISR[pin] = isr;
+    pinISRArg[pin] = arg;
+    pinISRNoArg[pin] = NULL;
+    pinISRMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if(pin >= SIM_PINS) return;
+    pinISR[pin] = NULL;
+    pinISRNoArg[pin] = NULL;
+    pinISRMode[pin] = 0;
+}
+
+void simSetPin(uint8_t pin, int level)
+{
+    if(pin >= SIM_PINS) return;
+    pinDriven[pin] = true;
+    pinUpdate(pin, level ? HIGH : LOW);
+}
+
+void simReleasePin(uint8_t pin)
+{
+    if(pin >= SIM_PINS) return;
+    pinDriven[pin] = false;
+    pinUpdate(pin, pinIdleLevel(pin));
+}
+
+/*
+ * CPU, system
+ */
+
+static uint32_t cpuMHz = 240;
+
+bool setCpuFrequencyMhz(uint32_t mhz)
+{
+    cpuMHz = mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return cpuMHz;
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount()
+{
+    return (uint32_t)(simUs * cpuMHz);
+}
+
+void EspClass::restart()
+{
+    esp_restart();
+}
+
+esp_reset_reason_t esp_reset_reason()
+{
+    return ESP_RST_POWERON;
+}
+
+void esp_restart()
+{
+    printf("sim: esp_restart() at %.3fs\n", simUs / 1e6);
+    exit(1);
+}
+
+// Deterministic, so runs can be compared
+static uint32_t rndState = 0x12345678;
+
+uint32_t esp_random()
+{
+    rndState ^= rndState << 13;
+    rndState ^= rndState >> 17;
+    rndState ^= rndState << 5;
+    return rndState;
+}
+
+long random(long max)
+{
+    return max > 0 ? (long)(esp_random() % (uint32_t)max) : 0;
+}
+
+long random(long min, long max)
+{
+    return min < max ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while(len--) {
+        crc ^= *buf++;
+        for(int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t us)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start()
+{
+    return ESP_OK;
+}
+
+/*
+ * FreeRTOS: One task, the main loop
+ */
+
+static int mainTask;
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return &mainTask;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *h, BaseType_t core)
+{
+    return pdFAIL;
+}
+
+void vTaskDelay(TickType_t t)
+{
+    delay(t);
+}
+
+void vTaskDelete(TaskHandle_t h)
+{
+}
+
+BaseType_t xPortGetCoreID()
+{
+    return ARDUINO_RUNNING_CORE;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return millis();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return &mainTask;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+    return &mainTask;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t t)
+{
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t t)
+{
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s)
+{
+    return pdTRUE;
+}
+
+/*
+ * Serial: Only shown with -v
+ */
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+size_t Print::write(const uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while(len--) n += write(*buf++);
+    return n;
+}
+
+size_t Print::printf(const char *fmt, ...)
+{
+    char buf[512];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if(len < 0) return 0;
+    if(len >= (int)sizeof(buf)) len = sizeof(buf) - 1;
+
+    return write((const uint8_t *)buf, len);
+}
+
+size_t Print::print(int n)           { return printf("%d", n); }
+size_t Print::print(unsigned int n)  { return printf("%u", n); }
+size_t Print::print(long n)          { return printf("%ld", n); }
+size_t Print::print(unsigned long n) { return printf("%lu", n); }
+size_t Print::print(double n, int digits) { return printf("%.*f", digits, n); }
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if(simVerbose && !_num) fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t len)
+{
+    if(simVerbose && !_num) fwrite(buf, 1, len, stdout);
+    return len;
+}
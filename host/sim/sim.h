@@ -0,0 +1,129 @@
+#ifndef _SIM_H
+#define _SIM_H
+
+/*
+ * Host simulator of the TCD
+ *
+ * The firmware modules are built unchanged against the mocks in
+ * mock/ and run on simulated time. Simulated time advances by
+ * delay(), by I2C bus time, by a small cost per call of a time
+ * function, and by SIM_LOOP_US per loop() pass; all other CPU
+ * time is taken as zero. Timers, the RTC's SQW interrupt,
+ * network packets and the audio stream are events on the same
+ * time line, run as time advances.
+ *
+ * Single-threaded: Code that runs on other tasks on the ESP32
+ * (esp_timer callbacks, AsyncUDP callbacks, the audio task)
+ * runs from within time advances here, ie preempts the main
+ * loop at the points where it reads the time or waits.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// Cost of a time function call, and of a loop() pass
+#define SIM_CALL_US     1
+#define SIM_LOOP_US     50
+
+extern uint64_t simUs;
+extern bool     simVerbose;
+
+// Events
+int      simAt(uint64_t when, std::function<void()> fn);
+void     simCancel(int id);
+void     simAdvance(uint64_t us);
+void     simAdvanceTo(uint64_t when);
+
+// GPIO driven from outside (buttons, SQW); runs
+// attached interrupt handlers on matching edges
+void     simSetPin(uint8_t pin, int level);
+void     simReleasePin(uint8_t pin);
+
+// UTC of the simulated world, us since 1/1/1970
+void     simSetWallClock(uint64_t utcUs);
+uint64_t simWallUs();
+
+/*
+ * I2C (sim_i2c.cpp)
+ */
+
+class simI2CDev {
+    public:
+        virtual ~simI2CDev() {}
+        virtual void write(const uint8_t *buf, size_t len) = 0;
+        virtual void read(uint8_t *buf, size_t len) = 0;
+};
+
+typedef struct {
+    uint32_t txns;          // transactions (incl. NACKed)
+    uint32_t nacks;
+    uint64_t bytes;         // incl. address bytes
+    uint64_t busUs;
+} simI2CStats;
+
+void     simI2CAttach(uint8_t addr, simI2CDev *dev);
+const simI2CStats *simI2CGetStats(uint8_t addr);
+void     simI2CResetStats();
+
+// Devices
+void     simRTCInit(uint64_t utcUs, bool lostPower = false);
+int      simRTCAdjusts();
+void     simKeyPress(char key);
+void     simKeyRelease();
+void     simI2CDevsInit(bool speedo);
+uint32_t simDisplayWrites(uint8_t addr);
+
+/*
+ * Network (sim_net.cpp)
+ */
+
+typedef struct {
+    uint32_t pkts;
+    uint64_t bytes;
+} simNetCount;
+
+typedef struct {
+    simNetCount tx;         // TCD -> network
+    simNetCount rx;         // network -> TCD
+    simNetCount txMC;       // of tx: multicast
+    simNetCount ntpTx;      // of tx: to the NTP server
+} simNetStats;
+
+extern simNetStats simNet;
+
+void     simNetInit(int numClients, uint32_t pollMs, uint32_t latencyUs);
+void     simNetSetWiFi(bool up);
+void     simNetClientTT(int client);
+uint64_t simNetClientTTUs(int client);
+void     simNetReport();
+
+/*
+ * Audio (sim_audio.cpp)
+ */
+
+typedef struct {
+    uint32_t files;         // sound effects played
+    uint32_t songs;         // music player tracks started
+    uint64_t sdBytes;       // read from SD
+    uint64_t fsBytes;       // read from flash FS
+    uint64_t i2sBytes;      // written to I2S
+} simAudioStats;
+
+extern simAudioStats simAudio;
+
+/*
+ * Stubs for the modules not built (sim_stubs.cpp)
+ */
+
+typedef struct {
+    uint32_t pubs;
+    uint64_t bytes;
+    uint32_t cmds;
+} simMQTTStats;
+
+extern simMQTTStats simMQTT;
+
+int      simMQTTCmd(const char *cmd);
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ * Host simulator: Audio (replaces tc_audio.cpp)
+ *
+ * The tc_audio API on a model of the audio path: A playing
+ * sound or music track is a stream of MP3 frames (1152 samples
+ * at 44.1kHz); per frame, the compressed frame (128kbit/s) is
+ * read from SD or flash, and the decoded frame (16 bit stereo)
+ * is written to I2S. Keypad sounds and beeps are cached in RAM
+ * and only written to I2S. Decoding runs on the audio task, so
+ * frames are events here, independent of the main loop.
+ *
+ * Sound lengths are made up; music tracks are 3 minutes.
+ */
+
+#include <Arduino.h>
+
+#include "tc_audio.h"
+#include "sim.h"
+
+#define FRAME_US        26122           // 1152 / 44100
+#define FRAME_MP3       418             // 128kbit/s
+#define FRAME_I2S       (1152 * 4)
+#define TRACK_US        (180 * 1000000ULL)
+
+simAudioStats simAudio;
+
+int  volumePin = 32;
+
+bool audioInitDone = false;
+bool audioMute = false;
+bool muteBeep = false;
+
+bool haveMusic = false;
+bool mpActive = false;
+bool haveId3 = false;
+char id3[256];
+
+bool haveLineOut = false;
+bool useLineOut = false;
+
+int  curVolume = DEFAULT_VOLUME;
+
+enum { SRC_RAM, SRC_FS, SRC_SD };
+
+static bool     playing = false;
+static bool     playingMusic = false;
+static int      src;
+static uint64_t endUs;
+static int      frameEv = 0;
+static int      mpCurr = 0;
+
+static const struct {
+    const char *name;
+    uint32_t    ms;
+} soundLen[] = {
+    { "/intro.mp3",        6000 },
+    { "/startup.mp3",      1500 },
+    { "/travelstart.mp3",  6600 },
+    { "/travelstart2.mp3", 4000 },
+    { "/timetravel.mp3",   3000 },
+    { "/enter.mp3",         600 },
+    { "/baddate.mp3",       800 },
+    { NULL,                1500 }
+};
+
+static void frame()
+{
+    frameEv = 0;
+
+    if(!playing)
+        return;
+
+    switch(src) {
+    case SRC_SD:
+        simAudio.sdBytes += FRAME_MP3;
+        break;
+    case SRC_FS:
+        simAudio.fsBytes += FRAME_MP3;
+        break;
+    }
+    simAudio.i2sBytes += FRAME_I2S;
+
+    if(simUs >= endUs) {
+        playing = playingMusic = false;
+        return;
+    }
+
+    frameEv = simAt(simUs + FRAME_US, frame);
+}
+
+static void startStream(int source, uint64_t us, bool music)
+{
+    stopAudio();
+    playing = true;
+    playingMusic = music;
+    src = source;
+    endUs = simUs + us;
+    frameEv = simAt(simUs + FRAME_US, frame);
+}
+
+void audio_setup()
+{
+    audioInitDone = true;
+    haveMusic = true;
+}
+
+// Next track when the current one is done
+void audio_loop()
+{
+    if(mpActive && !playing) {
+        mp_next(true);
+    }
+}
+
+void play_file(const char *audio_file, uint16_t flags, float volumeFactor)
+{
+    int i;
+
+    if(audioMute) return;
+
+    if(flags & PA_INTRMUS) {
+        mpActive = false;
+    } else if(mpActive) {
+        // Keypad sounds are mixed over the music
+        return;
+    }
+
+    for(i = 0; soundLen[i].name; i++) {
+        if(!strcmp(soundLen[i].name, audio_file))
+            break;
+    }
+
+    simAudio.files++;
+    startStream((flags & PA_ISWAV) ? SRC_RAM : ((flags & PA_ALLOWSD) ? SRC_SD : SRC_FS),
+                soundLen[i].ms * 1000ULL, false);
+}
+
+uint16_t play_keypad_sound(char key)
+{
+    play_file("/Dtmf-0.wav", PA_ISWAV|PA_INTSPKR|PA_CHECKNM, 0.6);
+    return 0;
+}
+
+void play_hour_sound(int hour)
+{
+}
+
+void play_beep()
+{
+}
+
+void play_key(int k, uint16_t preDTMFkp)
+{
+}
+
+bool check_file_SD(const char *audio_file)
+{
+    return false;
+}
+
+int getSWVolFromHWVol()
+{
+    return 10;
+}
+
+bool checkAudioDone()
+{
+    return !playing;
+}
+
+bool checkMP3Done()
+{
+    return !playing;
+}
+
+void stopAudio()
+{
+    if(frameEv) simCancel(frameEv);
+    frameEv = 0;
+    playing = playingMusic = false;
+}
+
+void flushOpenAudioFiles()
+{
+}
+
+void decodeID3(char *artist, char *track)
+{
+    *artist = *track = 0;
+}
+
+uint32_t audio_bench_mp3(const char *audio_file, bool fromSD, uint32_t maxMs, uint32_t& frames)
+{
+    frames = 0;
+    return 0;
+}
+
+/*
+ * Music player
+ */
+
+void mp_init(bool isSetup)
+{
+}
+
+void mp_play(bool forcePlay)
+{
+    if(!haveMusic) return;
+
+    simAudio.songs++;
+    startStream(SRC_SD, TRACK_US, true);
+    mpActive = forcePlay;
+}
+
+bool mp_stop()
+{
+    bool ret = mpActive;
+
+    if(mpActive) {
+        stopAudio();
+        mpActive = false;
+    }
+
+    return ret;
+}
+
+void mp_next(bool forcePlay)
+{
+    mpCurr++;
+    mp_play(forcePlay);
+}
+
+void mp_prev(bool forcePlay)
+{
+    if(mpCurr) mpCurr--;
+    mp_play(forcePlay);
+}
+
+int mp_gotonum(int num, bool force)
+{
+    mpCurr = num;
+    mp_play(force);
+    return num;
+}
+
+void mp_makeShuffle(bool enable)
+{
+}
+
+int mp_checkForFolder(int num)
+{
+    return 1;
+}
+
+int mp_get_currently_playing()
+{
+    return mpCurr;
+}
@@ -0,0 +1,352 @@
+/*
+ * Host simulator: I2C bus and devices
+ *
+ * Bus time is 9 bits per byte (incl. the address byte) plus
+ * start and stop at the bus clock. Absent addresses NACK.
+ *
+ * Devices:
+ * - DS3231 RTC (0x68): Counts from what was last written to
+ *   its time registers; SQW (1Hz, if enabled in the control
+ *   register) drives SECONDS_IN_PIN, low for the first half
+ *   of each second. Writing the time restarts the second.
+ * - HT16K33 (0x71, 0x72, 0x74 displays; 0x70 speedo): Sinks;
+ *   RAM writes are counted.
+ * - PCF8574 (0x20 keypad): Quasi-bidirectional port; a pressed
+ *   key pulls its row pin low while its column pin is low.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include <map>
+
+#include "sim.h"
+
+#define SQW_PIN  15     // SECONDS_IN_PIN
+
+TwoWire Wire(0);
+TwoWire Wire1(1);
+
+static simI2CDev   *devs[128];
+static simI2CStats  stats[128];
+
+void simI2CAttach(uint8_t addr, simI2CDev *dev)
+{
+    devs[addr & 0x7f] = dev;
+}
+
+const simI2CStats *simI2CGetStats(uint8_t addr)
+{
+    return &stats[addr & 0x7f];
+}
+
+void simI2CResetStats()
+{
+    memset(stats, 0, sizeof(stats));
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t freq)
+{
+    _freq = freq ? freq : 100000;
+    return true;
+}
+
+void TwoWire::busTime(int bytes)
+{
+    uint64_t us = ((uint64_t)(bytes * 9 + 2) * 1000000 + _freq - 1) / _freq;
+    stats[_txAddr].bytes += bytes;
+    stats[_txAddr].busUs += us;
+    simAdvance(us);
+}
+
+void TwoWire::beginTransmission(uint16_t addr)
+{
+    _txAddr = addr & 0x7f;
+    _txLen = 0;
+}
+
+size_t TwoWire::write(uint8_t c)
+{
+    if(_txLen >= I2C_BUFFER_LENGTH)
+        return 0;
+    _tx[_txLen++] = c;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *buf, size_t len)
+{
+    size_t n = 0;
+    while(len-- && write(*buf++)) n++;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    stats[_txAddr].txns++;
+
+    if(!devs[_txAddr]) {
+        stats[_txAddr].nacks++;
+        busTime(1);
+        return 2;
+    }
+
+    busTime(1 + _txLen);
+    if(_txLen) {
+        devs[_txAddr]->write(_tx, _txLen);
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint16_t addr, uint8_t len, bool sendStop)
+{
+    _txAddr = addr & 0x7f;
+    _rxLen = _rxPos = 0;
+
+    stats[_txAddr].txns++;
+
+    if(!devs[_txAddr]) {
+        stats[_txAddr].nacks++;
+        busTime(1);
+        return 0;
+    }
+
+    if(len > I2C_BUFFER_LENGTH) len = I2C_BUFFER_LENGTH;
+
+    busTime(1 + len);
+    devs[_txAddr]->read(_rx, len);
+    _rxLen = len;
+
+    return len;
+}
+
+/*
+ * DS3231
+ */
+
+static uint8_t bcd(int v)   { return ((v / 10) << 4) | (v % 10); }
+static int     bin(uint8_t v) { return (v >> 4) * 10 + (v & 0x0f); }
+
+class simDS3231 : public simI2CDev {
+
+    public:
+
+        void init(uint64_t utcUs, bool lostPower)
+        {
+            _baseSecs = utcUs / 1000000;
+            _baseUs = simUs - (utcUs % 1000000);
+            _regs[0x0e] = 0x1c;                 // INTCN: No SQW
+            _regs[0x0f] = lostPower ? 0x80 : 0x00;
+            _regs[0x11] = 25;                   // 25.00C
+            _regs[0x12] = 0;
+            sqwSchedule();
+        }
+
+        void write(const uint8_t *buf, size_t len)
+        {
+            bool setTime = false;
+
+            _ptr = buf[0];
+            for(size_t i = 1; i < len; i++) {
+                if(_ptr <= 6) {
+                    if(!setTime) latchTime();
+                    setTime = true;
+                }
+                _regs[_ptr] = buf[i];
+                _ptr = (_ptr + 1) % sizeof(_regs);
+            }
+
+            if(setTime) {
+                struct tm t;
+                memset(&t, 0, sizeof(t));
+                t.tm_sec  = bin(_regs[0] & 0x7f);
+                t.tm_min  = bin(_regs[1] & 0x7f);
+                t.tm_hour = bin(_regs[2] & 0x3f);
+                t.tm_mday = bin(_regs[4] & 0x3f);
+                t.tm_mon  = bin(_regs[5] & 0x1f) - 1;
+                t.tm_year = bin(_regs[6]) + 100;
+                _baseSecs = timegm(&t);
+                _baseUs = simUs;
+                _adjusts++;
+            }
+
+            sqwSchedule();
+        }
+
+        void read(uint8_t *buf, size_t len)
+        {
+            for(size_t i = 0; i < len; i++) {
+                if(_ptr <= 6 && (!i || _ptr == 0)) latchTime();
+                buf[i] = _regs[_ptr];
+                _ptr = (_ptr + 1) % sizeof(_regs);
+            }
+        }
+
+        int adjusts() { return _adjusts; }
+
+    private:
+
+        // Copy the current time into the time registers
+        void latchTime()
+        {
+            time_t s = _baseSecs + (simUs - _baseUs) / 1000000;
+            struct tm t;
+            gmtime_r(&s, &t);
+            _regs[0] = bcd(t.tm_sec);
+            _regs[1] = bcd(t.tm_min);
+            _regs[2] = bcd(t.tm_hour);
+            _regs[3] = t.tm_wday + 1;
+            _regs[4] = bcd(t.tm_mday);
+            _regs[5] = bcd(t.tm_mon + 1);
+            _regs[6] = bcd(t.tm_year % 100);
+        }
+
+        bool sqwOn() { return !(_regs[0x0e] & 0x04); }
+
+        // (Re)schedule the next SQW edge
+        void sqwSchedule()
+        {
+            if(_sqwEv) simCancel(_sqwEv);
+            _sqwEv = 0;
+
+            if(!sqwOn()) {
+                simSetPin(SQW_PIN, HIGH);
+                return;
+            }
+
+            uint64_t phase = (simUs - _baseUs) % 1000000;
+            simSetPin(SQW_PIN, phase < 500000 ? LOW : HIGH);
+            uint64_t next = simUs - phase + (phase < 500000 ? 500000 : 1000000);
+            _sqwEv = simAt(next, [this]() { sqwEdge(); });
+        }
+
+        void sqwEdge()
+        {
+            _sqwEv = 0;
+            sqwSchedule();
+        }
+
+        time_t   _baseSecs = 0;     // time at _baseUs
+        uint64_t _baseUs = 0;
+        uint8_t  _regs[0x13] = { 0 };
+        uint8_t  _ptr = 0;
+        int      _sqwEv = 0;
+        int      _adjusts = 0;
+};
+
+static simDS3231 ds3231;
+
+void simRTCInit(uint64_t utcUs, bool lostPower)
+{
+    ds3231.init(utcUs, lostPower);
+    simI2CAttach(0x68, &ds3231);
+}
+
+int simRTCAdjusts()
+{
+    return ds3231.adjusts();
+}
+
+/*
+ * HT16K33
+ */
+
+class simHT16K33 : public simI2CDev {
+
+    public:
+
+        void write(const uint8_t *buf, size_t len)
+        {
+            if(buf[0] < 0x10) {
+                if(len > 1) _ramWrites++;
+            } else {
+                _cmds++;
+            }
+        }
+
+        void read(uint8_t *buf, size_t len)
+        {
+            memset(buf, 0, len);
+        }
+
+        uint32_t ramWrites() { return _ramWrites; }
+
+    private:
+
+        uint32_t _ramWrites = 0;
+        uint32_t _cmds = 0;
+};
+
+static std::map<uint8_t, simHT16K33> displays;
+
+uint32_t simDisplayWrites(uint8_t addr)
+{
+    auto d = displays.find(addr);
+    return (d == displays.end()) ? 0 : d->second.ramWrites();
+}
+
+/*
+ * PCF8574 keypad
+ */
+
+// Layout and wiring as in tc_keypad.cpp
+static const char    kpKeys[4][3] = { { '1', '2', '3' }, { '4', '5', '6' },
+                                      { '7', '8', '9' }, { '*', '0', '#' } };
+static const uint8_t kpRowPins[4] = { 1, 6, 5, 3 };
+static const uint8_t kpColPins[3] = { 2, 0, 4 };
+
+class simPCF8574 : public simI2CDev {
+
+    public:
+
+        void write(const uint8_t *buf, size_t len)
+        {
+            _latch = buf[len - 1];
+        }
+
+        void read(uint8_t *buf, size_t len)
+        {
+            uint8_t v = _latch;
+
+            for(int r = 0; _key && r < 4; r++) {
+                for(int c = 0; c < 3; c++) {
+                    if(kpKeys[r][c] == _key && !(_latch & (1 << kpColPins[c]))) {
+                        v &= ~(1 << kpRowPins[r]);
+                    }
+                }
+            }
+            memset(buf, v, len);
+        }
+
+        void press(char key) { _key = key; }
+
+    private:
+
+        uint8_t _latch = 0xff;
+        char    _key = 0;
+};
+
+static simPCF8574 keypadDev;
+
+void simKeyPress(char key)
+{
+    keypadDev.press(key);
+}
+
+void simKeyRelease()
+{
+    keypadDev.press(0);
+}
+
+/*
+ * Bus population
+ */
+
+void simI2CDevsInit(bool speedo)
+{
+    static const uint8_t addrs[] = { 0x71, 0x72, 0x74, 0x70 };
+
+    for(int i = 0; i < (speedo ? 4 : 3); i++) {
+        simI2CAttach(addrs[i], &displays[addrs[i]]);
+    }
+    simI2CAttach(0x20, &keypadDev);
+}
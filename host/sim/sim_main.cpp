@@ -0,0 +1,357 @@
+/*
+ * Host simulator: Scenarios
+ *
+ *   tcsim [-v] <scenario>
+ *
+ *   idle     Boot, then idle for a minute with 5 props polling
+ *   keypad   Music playing; enter a destination time on the
+ *            keypad, then time travel by holding "0"
+ *   props    16 props polling 5 times a second; one of them
+ *            triggers a BTTFN-wide time travel
+ *   mqtt     Time travel and return through MQTT commands,
+ *            with publishing on (so props are notified through
+ *            MQTT, not BTTFN)
+ *
+ * Every scenario runs setup() and then loop() like the Arduino
+ * core, and reports per phase the time loop() takes (in simulated
+ * time: I2C bus time, delays, SIM_LOOP_US per pass) and what went
+ * over the buses: I2C bytes per device, UDP packets, MQTT
+ * publishes, SD and I2S bytes. -v shows the firmware's Serial
+ * output.
+ */
+
+#include <Arduino.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "tc_global.h"
+#include "tc_settings.h"
+#include "tc_audio.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+// 2025-06-01 12:00:00 UTC
+#define SIM_START_UTC   1748779200ULL
+
+/*
+ * Phases and loop() timing
+ */
+
+typedef struct {
+    const char *name;
+    std::vector<uint32_t> passUs;
+    uint64_t    startUs;
+    uint64_t    i2cBytes;
+    uint32_t    udpTx, udpRx;
+    uint32_t    mqttPubs;
+    uint64_t    sdBytes, i2sBytes;
+} simPhase;
+
+static std::vector<simPhase> phases;
+
+static uint64_t i2cTotalBytes()
+{
+    uint64_t b = 0;
+    for(int a = 0; a < 128; a++) b += simI2CGetStats(a)->bytes;
+    return b;
+}
+
+static void phaseEnd()
+{
+    if(phases.empty()) return;
+
+    simPhase& p = phases.back();
+    p.startUs = simUs - p.startUs;
+    p.i2cBytes = i2cTotalBytes() - p.i2cBytes;
+    p.udpTx = simNet.tx.pkts - p.udpTx;
+    p.udpRx = simNet.rx.pkts - p.udpRx;
+    p.mqttPubs = simMQTT.pubs - p.mqttPubs;
+    p.sdBytes = simAudio.sdBytes - p.sdBytes;
+    p.i2sBytes = simAudio.i2sBytes - p.i2sBytes;
+}
+
+// Start a phase; counters are kept as start values until phaseEnd()
+static void phase(const char *name)
+{
+    phaseEnd();
+
+    simPhase p;
+    p.name = name;
+    p.startUs = simUs;
+    p.i2cBytes = i2cTotalBytes();
+    p.udpTx = simNet.tx.pkts;
+    p.udpRx = simNet.rx.pkts;
+    p.mqttPubs = simMQTT.pubs;
+    p.sdBytes = simAudio.sdBytes;
+    p.i2sBytes = simAudio.i2sBytes;
+    phases.push_back(p);
+}
+
+static void pass()
+{
+    uint64_t t = simUs;
+
+    loop();
+    simAdvance(SIM_LOOP_US);
+
+    phases.back().passUs.push_back(simUs - t);
+}
+
+static void runFor(uint32_t ms)
+{
+    uint64_t end = simUs + ms * 1000ULL;
+
+    while(simUs < end) pass();
+}
+
+/*
+ * Input
+ */
+
+#define ENTER_PIN   16      // ENTER_BUTTON_PIN, active high
+
+static void key(char k, uint32_t holdMs = 150)
+{
+    simKeyPress(k);
+    runFor(holdMs);
+    simKeyRelease();
+    runFor(150);
+}
+
+static void keys(const char *s)
+{
+    while(*s) key(*s++);
+}
+
+static void enter()
+{
+    simSetPin(ENTER_PIN, HIGH);
+    runFor(100);
+    simSetPin(ENTER_PIN, LOW);
+    runFor(150);
+}
+
+static void mqtt(const char *cmd)
+{
+    int r = simMQTTCmd(cmd);
+    if(simVerbose) printf("sim: MQTT %s -> %d\n", cmd, r);
+}
+
+/*
+ * Boot
+ */
+
+// With MQTT publishing on, the TCD notifies props through MQTT
+// instead of BTTFN (see sendNetWorkMsg())
+static void boot(bool speedo, int props, uint32_t pollMs, bool mqttPub)
+{
+    simSetWallClock(SIM_START_UTC * 1000000ULL);
+
+    // RTC 700ms behind NTP
+    simRTCInit((SIM_START_UTC * 1000000ULL) - 700000);
+    simI2CDevsInit(speedo);
+    simNetInit(props, pollMs, 2000);
+
+    if(speedo) strcpy(settings.speedoType, "0");
+    strcpy(settings.useETTO, "1");
+    strcpy(settings.useMQTT, "1");
+    strcpy(settings.pubMQTT, mqttPub ? "1" : "0");
+    strcpy(settings.timeZone, "CET-1CEST,M3.5.0,M10.5.0/3");
+
+    phase("setup");
+    uint64_t t = simUs;
+    setup();
+    phases.back().passUs.push_back(simUs - t);
+}
+
+/*
+ * Report
+ */
+
+static const struct {
+    uint8_t     addr;
+    const char *name;
+} i2cNames[] = {
+    { 0x71, "dest display" }, { 0x72, "pres display" }, { 0x74, "dept display" },
+    { 0x70, "speedo" },       { 0x20, "keypad" },       { 0x68, "RTC (DS3231)" },
+    { 0, NULL }
+};
+
+static void report(const char *scenario)
+{
+    phaseEnd();
+
+    printf("%s\n", scenario);
+    printf("  %-10s %8s %8s %7s %7s %7s %8s %6s %6s %5s %9s %9s\n",
+           "phase", "sim ms", "passes", "avg us", "p99 us", "max us",
+           "I2C B", "UDP tx", "UDP rx", "MQTT", "SD B", "I2S B");
+
+    for(simPhase& p : phases) {
+        std::vector<uint32_t> v = p.passUs;
+        uint64_t sum = 0;
+        for(uint32_t u : v) sum += u;
+        std::sort(v.begin(), v.end());
+        printf("  %-10s %8llu %8zu %7llu %7u %7u %8llu %6u %6u %5u %9llu %9llu\n",
+               p.name, (unsigned long long)(p.startUs / 1000), v.size(),
+               (unsigned long long)(v.empty() ? 0 : sum / v.size()),
+               v.empty() ? 0 : v[v.size() * 99 / 100], v.empty() ? 0 : v.back(),
+               (unsigned long long)p.i2cBytes, p.udpTx, p.udpRx, p.mqttPubs,
+               (unsigned long long)p.sdBytes, (unsigned long long)p.i2sBytes);
+    }
+
+    printf("  I2C (100kHz):\n");
+    for(int a = 0; a < 128; a++) {
+        const simI2CStats *s = simI2CGetStats(a);
+        if(!s->txns) continue;
+        const char *name = "(absent)";
+        for(int i = 0; i2cNames[i].name; i++) {
+            if(i2cNames[i].addr == a) name = i2cNames[i].name;
+        }
+        printf("    0x%02x %-13s %7u txns %9llu bytes %8.1f ms bus", a, name, s->txns,
+               (unsigned long long)s->bytes, s->busUs / 1000.0);
+        if(s->nacks) printf(" %6u NACKs", s->nacks);
+        printf("\n");
+    }
+    printf("  Display RAM writes: dest %u, pres %u, dept %u, speedo %u; RTC set %d times\n",
+           simDisplayWrites(0x71), simDisplayWrites(0x72), simDisplayWrites(0x74),
+           simDisplayWrites(0x70), simRTCAdjusts());
+
+    simNetReport();
+
+    printf("  MQTT: %u publishes, %llu bytes; %u commands\n", simMQTT.pubs,
+           (unsigned long long)simMQTT.bytes, simMQTT.cmds);
+    printf("  Audio: %u sounds, %u tracks; SD %llu bytes, flash %llu bytes, I2S %llu bytes\n",
+           simAudio.files, simAudio.songs, (unsigned long long)simAudio.sdBytes,
+           (unsigned long long)simAudio.fsBytes, (unsigned long long)simAudio.i2sBytes);
+}
+
+/*
+ * Scenarios
+ */
+
+static void scnIdle()
+{
+    boot(false, 5, 1000, false);
+    phase("idle");
+    runFor(60000);
+
+    report("idle");
+}
+
+// Props' view of a time travel: when each starts P1, relative
+// to the trigger; they should agree
+static void reportTT(int props, uint64_t triggerUs)
+{
+    for(int i = 0; i < props; i++) {
+        uint64_t t = simNetClientTTUs(i);
+        if(t >= triggerUs) printf("  prop %d: P1 %.1f ms after trigger\n", i, (t - triggerUs) / 1000.0);
+        else               printf("  prop %d: no TT notification\n", i);
+    }
+}
+
+static void scnKeypad()
+{
+    boot(true, 5, 1000, false);
+
+    phase("settle");
+    runFor(5000);
+
+    phase("music");
+    mqtt("MP_PLAY");
+    runFor(5000);
+
+    phase("keys");
+    keys("102619850121");
+    enter();
+    runFor(3000);
+
+    phase("tt");
+    uint64_t t = simUs;
+    key('0', 2500);
+    runFor(20000);
+
+    phase("after");
+    runFor(10000);
+
+    report("keypad");
+    reportTT(5, t);
+}
+
+static void scnProps()
+{
+    boot(true, 16, 200, false);
+
+    phase("settle");
+    runFor(10000);
+
+    phase("tt");
+    uint64_t t = simUs;
+    simNetClientTT(3);
+    runFor(20000);
+
+    phase("after");
+    runFor(10000);
+
+    report("props");
+    reportTT(16, t);
+}
+
+static void scnMQTT()
+{
+    boot(false, 5, 1000, true);
+
+    phase("settle");
+    runFor(5000);
+
+    phase("tt");
+    mqtt("TIMETRAVEL");
+    runFor(20000);
+
+    phase("return");
+    mqtt("RETURN");
+    runFor(10000);
+
+    phase("stats");
+    mqtt("LOOP_STATS");
+    mqtt("BTTFN_CLIENTS");
+    runFor(2000);
+
+    report("mqtt");
+}
+
+static const struct {
+    const char *name;
+    void      (*fn)();
+} scenarios[] = {
+    { "idle",   scnIdle   },
+    { "keypad", scnKeypad },
+    { "props",  scnProps  },
+    { "mqtt",   scnMQTT   },
+    { NULL,     NULL      }
+};
+
+int main(int argc, char *argv[])
+{
+    const char *name = NULL;
+
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-v")) simVerbose = true;
+        else name = argv[i];
+    }
+
+    for(int i = 0; name && scenarios[i].name; i++) {
+        if(!strcmp(scenarios[i].name, name)) {
+            scenarios[i].fn();
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "usage: tcsim [-v] <scenario>; scenarios:");
+    for(int i = 0; scenarios[i].name; i++) fprintf(stderr, " %s", scenarios[i].name);
+    fprintf(stderr, "\n");
+
+    return 1;
+}
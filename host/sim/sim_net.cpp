@@ -0,0 +1,317 @@
+/*
+ * Host simulator: Network
+ *
+ * A WiFi link with fixed one-way latency, an NTP server, and
+ * a number of BTTFN clients (props). Every packet the TCD sends
+ * or receives is counted.
+ *
+ * Clients poll the TCD like props do: A v2 request for date/time,
+ * speed and status every pollMs, echoing the RTT stamp of the
+ * last reply. They announce multicast support, so the TCD sends
+ * notifications by multicast, which every client receives.
+ */
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <WiFi.h>
+
+#include <vector>
+
+#include "sim.h"
+
+#define NTP_SERVER_IP   IPAddress(10, 0, 0, 123)
+#define CLIENT_IP(i)    IPAddress(192, 168, 4, 100 + (i))
+#define BTTFN_PORT      1338
+#define BTTFN_SIZE      48
+#define NTP_SIZE        48
+#define NTP_UNIX_OFFS   2208988800ULL
+
+simNetStats simNet;
+
+static bool     wifiUp = true;
+static uint32_t latency = 2000;
+
+static std::vector<AsyncUDP *> sockets;
+
+WiFiClass WiFi;
+
+wl_status_t WiFiClass::status()
+{
+    return wifiUp ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+int WiFiClass::hostByName(const char *host, IPAddress& ip)
+{
+    if(!wifiUp) return 0;
+    ip = NTP_SERVER_IP;
+    return 1;
+}
+
+void simNetSetWiFi(bool up)
+{
+    wifiUp = up;
+}
+
+/*
+ * Sockets
+ */
+
+AsyncUDP::~AsyncUDP()
+{
+    close();
+}
+
+bool AsyncUDP::listen(uint16_t port)
+{
+    close();
+    _port = port;
+    _mc = false;
+    sockets.push_back(this);
+    return true;
+}
+
+bool AsyncUDP::listenMulticast(IPAddress ip, uint16_t port)
+{
+    close();
+    _port = port;
+    _mc = true;
+    sockets.push_back(this);
+    return true;
+}
+
+void AsyncUDP::close()
+{
+    for(size_t i = 0; i < sockets.size(); i++) {
+        if(sockets[i] == this) {
+            sockets.erase(sockets.begin() + i);
+            break;
+        }
+    }
+    _port = 0;
+}
+
+void AsyncUDP::deliver(const uint8_t *data, size_t len, IPAddress ip, uint16_t port)
+{
+    AsyncUDPPacket p(data, len, ip, port);
+    if(_cb) _cb(p);
+}
+
+// Peer -> TCD, after latency
+static void sendToTCD(IPAddress from, uint16_t fromPort, uint16_t toPort, bool mc,
+                      const uint8_t *data, size_t len)
+{
+    std::vector<uint8_t> pkt(data, data + len);
+
+    simAt(simUs + latency, [=]() {
+        if(!wifiUp) return;
+        for(AsyncUDP *s : sockets) {
+            if(s->port() == toPort && s->isMulticast() == mc) {
+                simNet.rx.pkts++;
+                simNet.rx.bytes += pkt.size();
+                s->deliver(pkt.data(), pkt.size(), from, fromPort);
+                return;
+            }
+        }
+    });
+}
+
+/*
+ * BTTFN clients
+ */
+
+typedef struct {
+    IPAddress ip;
+    uint8_t   type;
+    uint32_t  serial;
+    uint16_t  stamp;        // last RTT stamp received
+    uint64_t  stampUs;      // when
+    uint32_t  requests;
+    uint32_t  replies;
+    uint32_t  notUC;        // notifications by unicast
+    uint32_t  notMC;        //                 multicast
+    uint32_t  beacons;      // time beacons
+    uint64_t  ttUs;         // when the last TT notification says P1 starts
+} simClient;
+
+static std::vector<simClient> clients;
+static uint32_t pollMs = 1000;
+
+static void bttfnChecksum(uint8_t *buf)
+{
+    uint8_t a = 0;
+    for(int i = 4; i < BTTFN_SIZE - 1; i++) {
+        a += buf[i] ^ 0x55;
+    }
+    buf[BTTFN_SIZE - 1] = a;
+}
+
+static void clientSend(int i, uint8_t req)
+{
+    simClient& c = clients[i];
+    uint8_t buf[BTTFN_SIZE];
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, "BTTF", 4);
+    buf[4] = 2 | 0x80;                  // v2, supports multicast
+    buf[5] = req;
+    c.serial++;
+    memcpy(buf + 6, &c.serial, 4);
+    snprintf((char *)buf + 10, 13, "SIMPROP%d", i);
+    buf[23] = c.type;
+    if(c.stamp) {
+        uint16_t hold = (simUs - c.stampUs) / 1000;
+        buf[43] = hold & 0xff;
+        buf[44] = hold >> 8;
+        buf[45] = c.stamp & 0xff;
+        buf[46] = c.stamp >> 8;
+    }
+    bttfnChecksum(buf);
+
+    c.requests++;
+    sendToTCD(c.ip, BTTFN_PORT, BTTFN_PORT, false, buf, sizeof(buf));
+}
+
+static void clientPoll(int i)
+{
+    clientSend(i, 0x01 | 0x02 | 0x10);
+    simAt(simUs + pollMs * 1000ULL, [i]() { clientPoll(i); });
+}
+
+static void clientReceive(simClient& c, const uint8_t *buf, size_t len, bool mc)
+{
+    if(len != BTTFN_SIZE || memcmp(buf, "BTTF", 4))
+        return;
+
+    if(buf[4] & 0x80) {
+        c.replies++;
+        c.stamp = buf[45] | (buf[46] << 8);
+        c.stampUs = simUs;
+    } else if(buf[4] & 0x40) {
+        if(buf[5] == 16) {              // BTTFN_NOT_TIME
+            c.beacons++;
+            return;
+        }
+        if(mc) c.notMC++;
+        else   c.notUC++;
+        // TT: P1 starts after the lead time in the payload
+        if(buf[5] == 2) {               // BTTFN_NOT_TT
+            c.ttUs = simUs + (buf[6] | (buf[7] << 8)) * 1000ULL;
+        } else if(buf[5] == 0xff) {     // aggregated
+            for(int j = 0, p = 11; j < buf[6] && p < 46; j++, p += 2 + buf[p + 1]) {
+                if(buf[p] == 2) c.ttUs = simUs + (buf[p + 2] | (buf[p + 3] << 8)) * 1000ULL;
+            }
+        }
+    }
+}
+
+void simNetInit(int numClients, uint32_t pollInterval, uint32_t latencyUs)
+{
+    latency = latencyUs;
+    pollMs = pollInterval;
+
+    for(int i = 0; i < numClients; i++) {
+        simClient c = {};
+        c.ip = CLIENT_IP(i);
+        c.type = 1 + (i % 5);
+        clients.push_back(c);
+        // Staggered start
+        simAt(simUs + (uint64_t)(i + 1) * pollMs * 1000 / (numClients + 1),
+              [i]() { clientPoll(i); });
+    }
+}
+
+// Prop triggers a time travel (BTTFN-wide TT)
+void simNetClientTT(int i)
+{
+    clientSend(i, 0x80);
+}
+
+/*
+ * NTP server
+ */
+
+static void putNTPTime(uint8_t *buf, uint64_t us)
+{
+    uint32_t secs = us / 1000000 + NTP_UNIX_OFFS;
+    uint32_t frac = (uint32_t)(((us % 1000000) << 32) / 1000000);
+
+    for(int i = 0; i < 4; i++) {
+        buf[i] = secs >> (24 - i * 8);
+        buf[4 + i] = frac >> (24 - i * 8);
+    }
+}
+
+static void ntpRequest(const uint8_t *req, size_t len, uint16_t fromPort)
+{
+    uint8_t buf[NTP_SIZE];
+
+    if(len != NTP_SIZE)
+        return;
+
+    memset(buf, 0, sizeof(buf));
+    buf[0] = 0x24;                      // LI 0, v4, server
+    buf[1] = 1;                         // stratum
+    memcpy(buf + 24, req + 40, 8);      // originate = client's transmit
+    putNTPTime(buf + 32, simWallUs());
+    putNTPTime(buf + 40, simWallUs() + 50);
+
+    sendToTCD(NTP_SERVER_IP, 123, fromPort, false, buf, sizeof(buf));
+}
+
+/*
+ * TCD -> network
+ */
+
+size_t AsyncUDP::writeTo(const uint8_t *data, size_t len, IPAddress ip, uint16_t port)
+{
+    if(!wifiUp)
+        return 0;
+
+    bool mc = (ip[0] >= 224 && ip[0] <= 239);
+    std::vector<uint8_t> pkt(data, data + len);
+    uint16_t fromPort = _port;
+
+    simNet.tx.pkts++;
+    simNet.tx.bytes += len;
+    if(mc) {
+        simNet.txMC.pkts++;
+        simNet.txMC.bytes += len;
+    }
+
+    if(ip == NTP_SERVER_IP && port == 123) {
+        simNet.ntpTx.pkts++;
+        simNet.ntpTx.bytes += len;
+        simAt(simUs + latency, [=]() { ntpRequest(pkt.data(), pkt.size(), fromPort); });
+        return len;
+    }
+
+    simAt(simUs + latency, [=]() {
+        for(simClient& c : clients) {
+            if(mc || c.ip == ip) {
+                clientReceive(c, pkt.data(), pkt.size(), mc);
+            }
+        }
+    });
+
+    return len;
+}
+
+void simNetReport()
+{
+    printf("  UDP sent      %8u pkts %10llu bytes  (multicast %u pkts, NTP %u pkts)\n",
+           simNet.tx.pkts, (unsigned long long)simNet.tx.bytes, simNet.txMC.pkts, simNet.ntpTx.pkts);
+    printf("  UDP received  %8u pkts %10llu bytes\n",
+           simNet.rx.pkts, (unsigned long long)simNet.rx.bytes);
+
+    for(size_t i = 0; i < clients.size(); i++) {
+        simClient& c = clients[i];
+        printf("  prop %s type %d: %u requests, %u replies, %u+%u notifications (uc+mc), %u time beacons\n",
+               c.ip.toString(), c.type, c.requests, c.replies, c.notUC, c.notMC, c.beacons);
+    }
+}
+
+// When each client starts P1 of the last time travel; for scenarios
+uint64_t simNetClientTTUs(int i)
+{
+    return (i < (int)clients.size()) ? clients[i].ttUs : 0;
+}
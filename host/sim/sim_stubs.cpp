@@ -0,0 +1,235 @@
+/*
+ * Host simulator: Stand-ins for the modules that are not built
+ *
+ * tc_settings (no file systems: settings are the defaults, as
+ * modified by the scenario), tc_wifi (link always up, see
+ * sim_net.cpp; MQTT publishes are counted, commands can be
+ * injected as if received on bttf/tcd/cmd), tc_mem, tc_bench
+ * and tc_ws.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "tc_global.h"
+#include "tc_settings.h"
+#include "tc_wifi.h"
+#include "tc_mem.h"
+#include "tc_bench.h"
+#include "tc_ws.h"
+#include "tc_cmd.h"
+#include "sim.h"
+
+simMQTTStats simMQTT;
+
+/*
+ * tc_settings
+ */
+
+bool haveFS = true;
+bool haveSD = true;
+bool FlashROMode = false;
+bool haveAudioFiles = true;
+uint8_t  musFolderNum = 0;
+uint8_t  sdClockMHz = 16;
+uint16_t sdKBps = 1000;
+
+Settings settings;
+IPSettings ipsettings;
+struct TypedSettings cfg;
+
+// String form to typed copy, as in tc_settings.cpp
+#define PB(f) cfg.f = (atoi(settings.f) > 0)
+#define PU(f) cfg.f = atoi(settings.f)
+#define PF(f) cfg.f = strtof(settings.f, NULL)
+
+void validateSettings()
+{
+    PB(timesPers); PB(alarmRTC); PB(playIntro); PB(mode24); PU(beep);
+    PU(wifiConRetries); PU(wifiConTimeout); PU(wifiOffDelay); PU(wifiAPOffDelay);
+    PB(wifiPRetry); PB(dtNmOff); PB(ptNmOff); PB(ltNmOff);
+    PU(autoNMPreset); PU(autoNMOn); PU(autoNMOff);
+    #ifdef TC_HAVELIGHT
+    PB(useLight); PU(luxLimit);
+    #endif
+    #ifdef TC_HAVETEMP
+    PB(tempUnit); PF(tempOffs);
+    #endif
+    #ifdef TC_HAVESPEEDO
+    PU(speedoType); PU(speedoBright); PB(speedoAF); PF(speedoFact);
+    #ifdef TC_HAVEGPS
+    PB(useGPSSpeed); PU(spdUpdRate);
+    #endif
+    #ifdef TC_HAVETEMP
+    PB(dispTemp); PU(tempBright); PB(tempOffNM);
+    #endif
+    #endif
+    #ifdef FAKE_POWER_ON
+    PB(fakePwrOn);
+    #endif
+    #ifdef EXTERNAL_TIMETRAVEL_IN
+    PU(ettDelay); PB(ettLong);
+    #endif
+    #ifdef EXTERNAL_TIMETRAVEL_OUT
+    PB(useETTO); PB(noETTOLead);
+    #endif
+    #ifdef TC_HAVEGPS
+    PB(quickGPS);
+    #endif
+    PB(playTTsnds);
+    #ifdef TC_HAVEMQTT
+    PB(useMQTT); PB(pubMQTT);
+    #endif
+    PB(shuffle); PB(CfgOnSD); PU(sdFreq);
+}
+
+#undef PB
+#undef PU
+#undef PF
+
+void settings_setup()
+{
+    validateSettings();
+}
+
+void unmount_fs() {}
+void write_settings() {}
+bool flushSecSettings(bool force) { return true; }
+void saveBrightness() {}
+void saveAutoInterval() {}
+bool loadAlarm() { return false; }
+void saveAlarm() {}
+bool loadReminder() { return false; }
+void saveReminder() {}
+void saveCarMode() {}
+bool loadCurVolume() { return false; }
+void saveCurVolume() {}
+bool loadMusFoldNum() { return false; }
+void saveMusFoldNum() {}
+void loadStaleTime(void *target, bool& currentOn) { currentOn = false; }
+void saveStaleTime(void *source, bool currentOn) {}
+void loadLineOut() {}
+void saveLineOut() {}
+void saveRemoteAllowed() {}
+bool check_allow_CPA() { return false; }
+void delete_ID_file() {}
+bool copy_audio_files(bool& delIDfile) { return false; }
+void formatFlashFS() {}
+void rewriteSecondarySettings() {}
+bool readFileFromSD(const char *fn, uint8_t *buf, int len) { return false; }
+bool writeFileToSD(const char *fn, uint8_t *buf, int len) { return false; }
+bool readFileFromFS(const char *fn, uint8_t *buf, int len) { return false; }
+bool writeFileToFS(const char *fn, uint8_t *buf, int len) { return false; }
+void sdHealthCheck() {}
+
+/*
+ * tc_wifi
+ */
+
+bool wifiIsOff = false;
+bool wifiAPIsOff = false;
+bool wifiInAPMode = false;
+bool wifiHaveSTAConf = true;
+bool carMode = false;
+#ifdef TC_HAVEMQTT
+bool useMQTT = false;
+const char *mqttAudioFile = "/ha-alert.mp3";
+bool pubMQTT = false;
+#endif
+
+void wifi_setup()
+{
+    #ifdef TC_HAVEMQTT
+    useMQTT = cfg.useMQTT;
+    pubMQTT = cfg.pubMQTT;
+    #endif
+}
+
+void wifi_loop() {}
+void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferConfigPortal) {}
+void wifiStartCP() {}
+void wifiBootPoll() {}
+bool wifiIsConnecting() { return false; }
+void updateConfigPortalValues() {}
+bool wifiPortalBusy() { return false; }
+void wifiSetModemSleep(bool doSleep) {}
+
+bool wifiGetNTPServerIP(IPAddress& ip)
+{
+    return WiFi.hostByName(settings.ntpServer, ip);
+}
+
+int wifi_getStatus()
+{
+    return WiFi.status();
+}
+
+bool wifi_getIP(uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d)
+{
+    IPAddress ip = WiFi.localIP();
+    a = ip[0]; b = ip[1]; c = ip[2]; d = ip[3];
+    return true;
+}
+
+void wifi_getMAC(char *buf)
+{
+    strcpy(buf, "24:0a:c4:00:00:01");
+}
+
+#ifdef TC_HAVEMQTT
+bool mqttState()
+{
+    return useMQTT;
+}
+
+void mqttPublish(const char *topic, const char *pl, unsigned int len, uint8_t flags)
+{
+    if(useMQTT) {
+        simMQTT.pubs++;
+        simMQTT.bytes += strlen(topic) + len;
+    }
+}
+
+void mqttRequestPub(int what)
+{
+}
+
+// As received on bttf/tcd/cmd
+int simMQTTCmd(const char *cmd)
+{
+    simMQTT.cmds++;
+    return cmdExecName(cmd, strlen(cmd), CMDT_MQTT);
+}
+#endif
+
+/*
+ * tc_mem, tc_bench, tc_ws
+ */
+
+void mem_loop() {}
+
+void memGetStats(memStats& ms, bool sampleNow)
+{
+    memset(&ms, 0, sizeof(ms));
+}
+
+const char *memTaskName(int idx)
+{
+    return "-";
+}
+
+void memBulkReport() {}
+
+bool benchGetResults(benchResults& br)
+{
+    return false;
+}
+
+const char *benchI2CName(int idx)
+{
+    return "-";
+}
+
+void benchRun() {}
+
+void wsKeyEvent(char key, char how) {}
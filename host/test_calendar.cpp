@@ -0,0 +1,129 @@
+/*
+ * Property tests for tc_calendar
+ *
+ * Built with and without TC_JULIAN_CAL (see Makefile)
+ */
+
+#include <stdint.h>
+
+#include "tc_calendar.h"
+#include "host_test.h"
+
+#ifdef TC_JULIAN_CAL
+#define JULIAN  1
+#else
+#define JULIAN  0
+#endif
+
+// Reference: Gregorian rule, or Julian rule up to 1752
+static bool refLeap(int y)
+{
+    if(JULIAN && y <= 1752) return !(y & 3);
+    return (!(y & 3) && (y % 100)) || !(y % 400);
+}
+
+static int refDaysInMonth(int m, int y)
+{
+    static const int md[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return (m == 2 && refLeap(y)) ? 29 : md[m - 1];
+}
+
+// Reference: Advance date by one day (including the 1752 switch)
+static void refNextDay(int& y, int& m, int& d)
+{
+    if(JULIAN && y == 1752 && m == 9 && d == 2) {
+        d = 14;
+        return;
+    }
+    if(++d > refDaysInMonth(m, y)) {
+        d = 1;
+        if(++m > 12) {
+            m = 1;
+            y++;
+        }
+    }
+}
+
+int main()
+{
+    #ifdef TC_JULIAN_CAL
+    calcJulianData();
+    #endif
+
+    // Leap years and month lengths
+    for(int y = 0; y <= 9999; y++) {
+        CHECK(isLeapYear(y) == refLeap(y), "year %d", y);
+        for(int m = 1; m <= 12; m++) {
+            CHECK(daysInMonth(m, y) == refDaysInMonth(m, y), "%d/%d", m, y);
+        }
+    }
+
+    // Walk every day from 1/1/1 to 12/31/9999:
+    // - dateToMins() advances by exactly one day per day
+    // - minsToDate() is the inverse of dateToMins()
+    // - dayOfWeek() advances by one per day
+    // - mins2Date() is minutes since 1/1 of the same year
+    {
+        int y = 1, m = 1, d = 1;
+        uint64_t prev = dateToMins(y, m, d, 0, 0);
+        int prevDow = dayOfWeek(d, m, y);
+
+        CHECK(dayOfWeek(1, 1, 2000) == 6, "1/1/2000 is a Saturday");
+        CHECK(dayOfWeek(14, 9, 1752) == 4, "9/14/1752 is a Thursday");
+        #ifdef TC_JULIAN_CAL
+        CHECK(dayOfWeek(2, 9, 1752) == 3, "9/2/1752 (Julian) is a Wednesday");
+        #endif
+
+        while(y <= 9999) {
+            int ny = y, nm = m, nd = d;
+            refNextDay(ny, nm, nd);
+            if(ny > 9999) break;
+
+            uint64_t t = dateToMins(ny, nm, nd, 0, 0);
+            CHECK(t - prev == 24*60, "%d-%d-%d", ny, nm, nd);
+
+            int dow = dayOfWeek(nd, nm, ny);
+            CHECK(dow == (prevDow + 1) % 7, "%d-%d-%d: dow %d after %d", ny, nm, nd, dow, prevDow);
+
+            if(nm == 1 && nd == 1) {
+                CHECK(mins2Date(ny, nm, nd, 0, 0) == 0, "%d", ny);
+            } else if(!(JULIAN && ny == 1752)) {
+                CHECK(mins2Date(ny, nm, nd, 0, 0) - mins2Date(y, m, d, 0, 0) == 24*60, "%d-%d-%d", ny, nm, nd);
+            }
+
+            int h = (nd * 7) % 24, mi = (nd * 13) % 60;
+            int ry, rm, rd, rh, rmi;
+            minsToDate(t + h * 60 + mi, ry, rm, rd, rh, rmi);
+            CHECK(ry == ny && rm == nm && rd == nd && rh == h && rmi == mi,
+                  "%d-%d-%d %d:%d -> %d-%d-%d %d:%d", ny, nm, nd, h, mi, ry, rm, rd, rh, rmi);
+
+            y = ny; m = nm; d = nd;
+            prev = t;
+            prevDow = dow;
+        }
+    }
+
+    #ifdef TC_JULIAN_CAL
+    // Days skipped in the switch are moved to the first Gregorian day
+    for(int d = 1; d <= 30; d++) {
+        int dd = d;
+        correctNonExistingDate(1752, 9, dd);
+        CHECK(dd == ((d > 2 && d < 14) ? 14 : d), "9/%d/1752 -> %d", d, dd);
+        dd = d;
+        correctNonExistingDate(1753, 9, dd);
+        CHECK(dd == d, "9/%d/1753 -> %d", d, dd);
+    }
+    #endif
+
+    // RTC year mapping keeps leap-ness and stays in RTC range
+    for(int y = 0; y <= 9999; y++) {
+        uint16_t ry = y;
+        int16_t offs;
+        correctYr4RTC(ry, offs);
+        CHECK(ry >= 2000 && ry <= 2098, "%d -> %d", y, ry);
+        CHECK(ry - offs == y, "%d -> %d%+d", y, ry, -offs);
+        CHECK(isLeapYear(ry) == isLeapYear(y), "%d -> %d", y, ry);
+    }
+
+    return testResult(JULIAN ? "calendar (julian)" : "calendar");
+}
@@ -0,0 +1,161 @@
+/*
+ * Property tests for tc_tz
+ *
+ * UTC->local is checked against the C library's POSIX TZ
+ * handling (which ignores DST before 1970, so only from 1970
+ * on); local->UTC is checked for being the inverse outside
+ * of DST transitions. Built with and without
+ * TC_JULIAN_CAL (see Makefile).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tc_calendar.h"
+#include "tc_tz.h"
+#include "host_test.h"
+
+static const char *zones[] = {
+    "",
+    "UTC0",
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    "EST5EDT,M3.2.0,M11.1.0",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    "<+0330>-3:30",
+    "<+1345>-13:45<+1245>-12:45,M9.5.0/2:45,M4.1.0/3:45",
+    "IST-1GMT0,M10.5.0,M3.5.0/1",
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    "XST3XDT,J60/1,J300/1",
+    "YST3YDT,59/1,299/1",
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1",
+    NULL
+};
+
+// Local time from the C library for UTC time (y, m, d, h, mm)
+static void libcLocal(int& y, int& m, int& d, int& h, int& mm)
+{
+    struct tm t;
+    time_t tt;
+
+    memset(&t, 0, sizeof(t));
+    t.tm_year = y - 1900; t.tm_mon = m - 1; t.tm_mday = d;
+    t.tm_hour = h; t.tm_min = mm;
+    tt = timegm(&t);
+
+    localtime_r(&tt, &t);
+
+    y = t.tm_year + 1900; m = t.tm_mon + 1; d = t.tm_mday;
+    h = t.tm_hour; mm = t.tm_min;
+}
+
+static void checkRange(tzZone& z, const char *tz, int fromYear, int toYear, int step, bool libc)
+{
+    int fails = testFails;
+    uint64_t start = dateToMins(fromYear, 1, 1, 0, 0);
+    uint64_t end   = dateToMins(toYear + 1, 1, 1, 0, 0);
+
+    for(uint64_t t = start; t < end; t += step) {
+        int y, m, d, h, mm;
+        minsToDate(t, y, m, d, h, mm);
+
+        int ly = y, lm = m, ld = d, lh = h, lmm = mm;
+        tzUTCtoLocal(z, tz, ly, lm, ld, lh, lmm);
+
+        if(libc) {
+            int ry = y, rm = m, rd = d, rh = h, rmm = mm;
+            libcLocal(ry, rm, rd, rh, rmm);
+
+            CHECK(ly == ry && lm == rm && ld == rd && lh == rh && lmm == rmm,
+                  "%s: UTC %d-%02d-%02d %02d:%02d: %d-%02d-%02d %02d:%02d, libc %d-%02d-%02d %02d:%02d",
+                  tz, y, m, d, h, mm, ly, lm, ld, lh, lmm, ry, rm, rd, rh, rmm);
+        }
+
+        // Cached result must match
+        int cy = y, cm = m, cd = d, ch = h, cmm = mm;
+        CHECK(!tzUTCtoLocal(z, tz, cy, cm, cd, ch, cmm), "%s: not cached", tz);
+        CHECK(cy == ly && cm == lm && cd == ld && ch == lh && cmm == lmm, "%s: cache", tz);
+
+        if(testFails - fails > 5) break;
+
+        // Inverse, unless within three hours of a DST transition
+        // (where local times are skipped or repeated)
+        int lt = mins2Date(ly, lm, ld, lh, lmm);
+        if(z.couldDST && (abs(lt - z.DSTonMins) < 180 || abs(lt - z.DSToffMins) < 180))
+            continue;
+        tzLocalToUTC(z, ly, lm, ld, lh, lmm);
+        CHECK(ly == y && lm == m && ld == d && lh == h && lmm == mm,
+              "%s: UTC %d-%02d-%02d %02d:%02d -> %d-%02d-%02d %02d:%02d",
+              tz, y, m, d, h, mm, ly, lm, ld, lh, lmm);
+    }
+}
+
+static void checkZone(const char *tz)
+{
+    tzZone z;
+
+    setenv("TZ", *tz ? tz : "UTC0", 1);
+    tzset();
+
+    memset(&z, 0, sizeof(z));
+    CHECK(tzParse(z, tz, 2000), "%s", tz);
+
+    // Every 7 minutes (hits every minute of the hour, and
+    // every transition within a few steps) for some years,
+    // every 61 minutes from 1970, and back to before the
+    // Julian/Gregorian switch without reference
+    checkRange(z, tz, 2020, 2030, 7, true);
+    checkRange(z, tz, 1970, 2099, 61, true);
+    checkRange(z, tz, 1600, 1969, 97, false);
+}
+
+int main()
+{
+    #ifdef TC_JULIAN_CAL
+    calcJulianData();
+    #endif
+
+    for(int i = 0; zones[i]; i++) {
+        checkZone(zones[i]);
+    }
+
+    // Bad strings
+    {
+        static const char *bad[] = { "CET", "<CET-1", "CET-1:99", "CET-25", NULL };
+        for(int i = 0; bad[i]; i++) {
+            tzZone z;
+            memset(&z, 0, sizeof(z));
+            CHECK(!tzParse(z, bad[i], 2024), "%s", bad[i]);
+            CHECK(!tzParse(z, bad[i], 2025), "%s (again)", bad[i]);
+        }
+        // Bad DST part: Fails once, then used without DST
+        tzZone z;
+        memset(&z, 0, sizeof(z));
+        CHECK(!tzParse(z, "CET-1CEST,M3.5.0", 2024), "no DST end");
+        CHECK(tzParse(z, "CET-1CEST,M3.5.0", 2024), "no DST end (again)");
+        CHECK(!z.couldDST, "no DST end: no DST");
+    }
+
+    // Changing the TZ string drops everything parsed from the old one
+    for(int i = 0; zones[i]; i++) {
+        for(int j = 0; zones[j]; j++) {
+            tzZone a, b;
+            memset(&a, 0, sizeof(a));
+            memset(&b, 0, sizeof(b));
+            tzParse(a, zones[i], 2024);
+            tzParse(a, "CET", 2024);                // Invalid in between
+            tzParse(a, zones[j], 2024);
+            tzParse(b, zones[j], 2024);
+            CHECK(a.isValid == b.isValid && a.hasDST == b.hasDST && a.couldDST == b.couldDST &&
+                  a.diffGMT == b.diffGMT && a.diffGMTDST == b.diffGMTDST &&
+                  a.DSTonMins == b.DSTonMins && a.DSToffMins == b.DSToffMins,
+                  "%s -> %s", zones[i], zones[j]);
+        }
+    }
+
+    #ifdef TC_JULIAN_CAL
+    return testResult("tz (julian)");
+    #else
+    return testResult("tz");
+    #endif
+}
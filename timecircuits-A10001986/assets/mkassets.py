@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#
+# Generate gzip-compressed static web assets for the config portal
+#
+# (C) 2022-2025 Thomas Winischhofer (A10001986)
+# https://github.com/realA10001986/Time-Circuits-Display
+# https://tcd.out-a-ti.me
+#
+# The portal's style sheets and scripts are stored in flash in
+# compressed form and served with "Content-Encoding: gzip" and
+# ETag/Cache-Control headers, so that browsers fetch them only
+# once per firmware version.
+#
+# Edit the files in this directory, then run
+#     python3 mkassets.py
+# from within this directory to regenerate the headers. Commit
+# the sources and the generated headers together.
+
+import gzip
+import hashlib
+import os
+
+here = os.path.dirname(os.path.abspath(__file__))
+
+# (output header, [(source, C name, ETag macro), ...])
+outputs = [
+    ("../src/WiFiManager/wm_assets.h", [
+        ("wm.js",  "wm_js_gz",  "WM_JS_ETAG"),
+        ("wm.css", "wm_css_gz", "WM_CSS_ETAG"),
+    ]),
+    ("../tc_assets.h", [
+        ("tcd.js",  "tcd_js_gz",  "TC_JS_ETAG"),
+        ("tcd.css", "tcd_css_gz", "TC_CSS_ETAG"),
+    ]),
+]
+
+def gz(data):
+    # mtime=0 keeps the output (and thereby the ETag) reproducible
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+for header, assets in outputs:
+    guard = "_" + os.path.basename(header).upper().replace(".", "_")
+    lines = [
+        "/*",
+        " * Generated by assets/mkassets.py - DO NOT EDIT",
+        " */",
+        "",
+        "#ifndef " + guard,
+        "#define " + guard,
+        "",
+    ]
+    for src, name, etag in assets:
+        with open(os.path.join(here, src), "rb") as f:
+            raw = f.read()
+        data = gz(raw)
+        tag = hashlib.sha1(data).hexdigest()[:8]
+        lines.append("// %s: %d bytes, %d compressed" % (src, len(raw), len(data)))
+        lines.append("#define %s \"%s\"" % (etag, tag))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % name)
+        for i in range(0, len(data), 16):
+            lines.append("    " + ",".join("0x%02x" % b for b in data[i:i+16]) + ",")
+        lines.append("};")
+        lines.append("")
+    lines.append("#endif")
+    with open(os.path.join(here, header), "w") as f:
+        f.write("\n".join(lines) + "\n")
+    print("Wrote", os.path.normpath(os.path.join(here, header)))
@@ -56,9 +56,23 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <Preferences.h>
+#include <esp_system.h>
+#include <esp_rom_crc.h>
 
 #include "clockdisplay.h"
 #include "tc_font.h"
+#include "tc_prof.h"
+
+// Two-digit 7-segment patterns for makeNum(), built at
+// compile time from numDigs. LSB = 10s, MSB = 1s.
+#define ND2(n)   (uint16_t)((numDigs[((n) % 10) + '0' - 32] << 8) | numDigs[((n) / 10) + '0' - 32])
+#define ND2R(t)  ND2(t*10+0), ND2(t*10+1), ND2(t*10+2), ND2(t*10+3), ND2(t*10+4), \
+                 ND2(t*10+5), ND2(t*10+6), ND2(t*10+7), ND2(t*10+8), ND2(t*10+9)
+static const uint16_t numDigs2[100] = {
+    ND2R(0), ND2R(1), ND2R(2), ND2R(3), ND2R(4), 
+    ND2R(5), ND2R(6), ND2R(7), ND2R(8), ND2R(9)
+};
 
 #define CD_MONTH_POS  0
 #ifdef IS_ACAR_DISPLAY      // A-Car (2-digit-month) ---------------------
@@ -120,6 +134,133 @@ static const char *fnSD[3] = {
 static const char *fnLastYear   = "/tcdly";
 static const char *fnLastYearSD = "/tcdly.bin";
 
+/*
+ * Persistent clock state is kept in three tiers:
+ *
+ * - RTC slow memory: Written on every save (a few microseconds),
+ *   survives resets, crashes and OTA, but not a power loss. Read
+ *   first at boot unless we come from power-on.
+ * - Checkpoint: NVS (or the files on SD if config is on SD), written
+ *   from time_loop's time slices (so not during a time travel, and
+ *   once the audio is done) when nothing has changed for
+ *   CD_CKPT_QUIET; a burst of time travels or keypad entries is one
+ *   write. If changes never settle, the write is deferred by no more
+ *   than CD_CKPT_MAXDEFER. Also written before reboot/power-off
+ *   (saveFlush(true)). Unplugging the TCD therefore loses only what
+ *   changed in the last CD_CKPT_QUIET.
+ *   NVS entries are CRC-protected by NVS, our data carries check sums.
+ * - Files on flash FS by previous versions: Only read if nothing
+ *   else is found.
+ *
+ * The RTC chips we support (DS3231, PCF2129) have no user RAM.
+ */
+#define CD_CKPT_QUIET    (30*1000)      // after the last change
+#define CD_CKPT_MAXDEFER (30*60*1000)   // if changes never settle
+#define CD_RTCM_MAGIC    0x54430001     // "TC", version 1
+#define CD_SLOT_LY       3              // slots 0-2: display data (_did)
+#define CD_NUM_SLOTS     4
+
+typedef struct {
+    uint32_t magic;
+    uint8_t  valid;                     // bit mask, by slot
+    uint8_t  data[CD_NUM_SLOTS][10];
+    uint32_t crc;                       // over all of the above
+} cdRTCMem;
+
+static RTC_NOINIT_ATTR cdRTCMem rtcMem;
+static bool rtcMemChecked = false;
+
+static Preferences cdPrefs;
+static bool nvsOpen = false;
+static const char *nvsKeys[CD_NUM_SLOTS] = { "dt", "pt", "lt", "ly" };
+
+// Checkpoint due: Quiet since the last change, or deferred long enough
+static bool ckptDue(unsigned long lastChange, unsigned long since)
+{
+    unsigned long now = millis();
+
+    return (now - lastChange >= CD_CKPT_QUIET) || (now - since >= CD_CKPT_MAXDEFER);
+}
+
+static uint32_t rtcMemCRC()
+{
+    return esp_rom_crc32_le(0, (uint8_t *)&rtcMem, offsetof(cdRTCMem, crc));
+}
+
+static void rtcMemCheck()
+{
+    esp_reset_reason_t r = esp_reset_reason();
+
+    rtcMemChecked = true;
+
+    if(r == ESP_RST_POWERON || r == ESP_RST_BROWNOUT || r == ESP_RST_UNKNOWN ||
+       rtcMem.magic != CD_RTCM_MAGIC || rtcMem.crc != rtcMemCRC()) {
+        memset(&rtcMem, 0, sizeof(rtcMem));
+        rtcMem.magic = CD_RTCM_MAGIC;
+        rtcMem.crc = rtcMemCRC();
+    }
+}
+
+static bool rtcMemGet(int slot, uint8_t *buf, int len)
+{
+    if(!rtcMemChecked) rtcMemCheck();
+
+    if(!(rtcMem.valid & (1 << slot)))
+        return false;
+
+    memcpy(buf, rtcMem.data[slot], len);
+    return true;
+}
+
+static void rtcMemPut(int slot, const uint8_t *buf, int len)
+{
+    if(!rtcMemChecked) rtcMemCheck();
+
+    memcpy(rtcMem.data[slot], buf, len);
+    rtcMem.valid |= (1 << slot);
+    rtcMem.crc = rtcMemCRC();
+}
+
+static bool nvsBegin()
+{
+    if(!nvsOpen) {
+        nvsOpen = cdPrefs.begin("tcdstate", false);
+    }
+    return nvsOpen;
+}
+
+static bool nvsGet(int slot, uint8_t *buf, int len)
+{
+    if(!nvsBegin())
+        return false;
+
+    return (cdPrefs.getBytes(nvsKeys[slot], buf, len) == len);
+}
+
+static bool nvsPut(int slot, const uint8_t *buf, int len)
+{
+    // NVS lives in flash, too
+    if(FlashROMode || !nvsBegin())
+        return false;
+
+    return (cdPrefs.putBytes(nvsKeys[slot], buf, len) == len);
+}
+
+static bool nvmSumOk(const uint8_t *buf)
+{
+    uint16_t sum = 0;
+
+    for(int i = 0; i < 9; i++) {
+        sum += (buf[i] ^ 0x55);
+    }
+    return ((sum & 0xff) == buf[9]);
+}
+
+static bool clockStateOk(const uint8_t *buf)
+{
+    return ((buf[0] == (buf[2] ^ 0xff)) && (buf[1] == (buf[3] ^ 0xff)));
+}
+
 
 /*
  * ClockDisplay class
@@ -135,6 +276,9 @@ clockDisplay::clockDisplay(uint8_t did, uint8_t address)
 // Start the display
 void clockDisplay::begin()
 {
+    _onCache = _briCache = 0xff;
+    _holdCmds = false;
+
     directCmd(0x20 | 1); // turn on oscillator
 
     clearBuf();          // clear buffer
@@ -146,26 +290,70 @@ void clockDisplay::begin()
 // Turn on the display
 void clockDisplay::on()
 {
-    directCmd(0x80 | 1);
+    queueCmd(0x80 | 1);
 }
 
 // Turn on the display unless off due to night mode
 void clockDisplay::onCond()
 {
     if(!_nightmode || !_NmOff) {
-        directCmd(0x80 | 1);
+        queueCmd(0x80 | 1);
     }
 }
 
 // Turn off the display
 void clockDisplay::off()
 {
-    directCmd(0x80);
+    queueCmd(0x80);
 }
 
 void clockDisplay::onBlink(uint8_t blink)
 {
-    directCmd(0x80 | 1 | ((blink & 0x03) << 1)); 
+    queueCmd(0x80 | 1 | ((blink & 0x03) << 1)); 
+}
+
+// Hold back display setup and dimming commands until
+// flushCmds(); only the last of each kind is sent.
+void clockDisplay::holdCmds()
+{
+    _holdCmds = true;
+}
+
+// Hold back frames from show() and friends (and commands)
+// until commitFrame(); used to update several displays 
+// back-to-back.
+void clockDisplay::holdFrame()
+{
+    _holdFrame = true;
+    holdCmds();
+}
+
+void clockDisplay::commitFrame()
+{
+    _holdFrame = false;
+
+    if(_framePending) {
+        _framePending = false;
+        sendFrame(_frameBuf);
+    }
+
+    flushCmds();
+}
+
+void clockDisplay::flushCmds()
+{
+    _holdCmds = false;
+
+    // Dimming first, so a display turned on comes up
+    // at its final brightness
+    if(_pendBri != 0xff) {
+        queueCmd(_pendBri);
+        _pendBri = 0xff;
+    }
+    if(_pendOn != 0xff) {
+        queueCmd(_pendOn);
+        _pendOn = 0xff;
+    }
 }
 
 // Turn on all LEDs
@@ -176,13 +364,14 @@ void clockDisplay::onBlink(uint8_t blink)
 #if 0
 void clockDisplay::realLampTest()
 {
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);  // start address
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(0x00);  // start address
 
     for(int i = 0; i < CD_BUF_SIZE*2; i++) {
-        Wire.write(0xff);
+        TC_FASTWIRE.write(0xff);
     }
-    Wire.endTransmission();
+    TC_FASTWIRE.endTransmission();
 }
 #endif
 
@@ -190,17 +379,23 @@ void clockDisplay::realLampTest()
 // Used for effects and brightness keypad menu
 void clockDisplay::lampTest(bool randomize)
 {
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);  // start address
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(0x00);  // start address
 
     uint32_t rnd = esp_random();
+    uint16_t frame[CD_BUF_SIZE];
 
     for(int i = 0; i < CD_BUF_SIZE; i++) {
-        Wire.write(randomize ? ((rand() % 0x7f) ^ rnd) & 0x7f : 0xaa);
-        Wire.write(randomize ? (((rand() % 0x7f) ^ (rnd >> 8))) & 0x77 : 0x55);
+        frame[i]  = randomize ? ((rand() % 0x7f) ^ rnd) & 0x7f : 0xaa;
+        frame[i] |= (randomize ? (((rand() % 0x7f) ^ (rnd >> 8))) & 0x77 : 0x55) << 8;
+        TC_FASTWIRE.write(frame[i] & 0xff);
+        TC_FASTWIRE.write(frame[i] >> 8);
     }
     
-    Wire.endTransmission();
+    TC_FASTWIRE.endTransmission();
+
+    liveCols(0, frame, CD_BUF_SIZE);
 }
 
 // Clear the buffer
@@ -239,7 +434,7 @@ uint8_t clockDisplay::setBrightnessDirect(uint8_t level)
     if(level > 15)
         level = 15;
 
-    directCmd(0xe0 | level);
+    queueCmd(0xe0 | level);
 
     return level;
 }
@@ -350,13 +545,7 @@ void clockDisplay::showAnimate2()
     if(_nightmode && _NmOff)
         return;
 
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);
-    for(int i = 0; i < CD_BUF_SIZE; i++) {
-        Wire.write(_displayBuffer[i] & 0xff);
-        Wire.write(_displayBuffer[i] >> 8);
-    }
-    Wire.endTransmission();
+    putFrame(_displayBuffer);
 }
 
 #else
@@ -366,17 +555,21 @@ void clockDisplay::showAnimate2(int until)
     if(_nightmode && _NmOff)
         return;
 
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(0x00);
     for(int i = 0; i < until; i++) {
-        Wire.write(_displayBuffer[i] & 0xff);
-        Wire.write(_displayBuffer[i] >> 8);
+        TC_FASTWIRE.write(_displayBuffer[i] & 0xff);
+        TC_FASTWIRE.write(_displayBuffer[i] >> 8);
     }
     for(int i = until; i < CD_BUF_SIZE; i++) {
-        Wire.write(0x00);
-        Wire.write(0x00);
+        TC_FASTWIRE.write(0x00);
+        TC_FASTWIRE.write(0x00);
     }
-    Wire.endTransmission();
+    TC_FASTWIRE.endTransmission();
+
+    liveCols(0, _displayBuffer, until);
+    liveCols(until, NULL, CD_BUF_SIZE - until);
 }
 
 void clockDisplay::showAnimate3(int mystep)
@@ -427,39 +620,7 @@ void clockDisplay::showAlt()
 // Put the given text into _displayBufferAlt
 void clockDisplay::setAltText(const char *text)
 {
-    int idx = 0, pos = CD_MONTH_POS;
-    int temp = 0;
-
-#ifdef IS_ACAR_DISPLAY
-    while(text[idx] && pos < (CD_MONTH_POS+CD_MONTH_SIZE)) {
-        temp = getLED7AlphaChar(text[idx++]);
-        if(text[idx]) {
-            temp |= (getLED7AlphaChar(text[idx++]) << 8);
-        }
-        _displayBufferAlt[pos++] = temp;
-    }
-#else
-    while(text[idx] && pos < (CD_MONTH_POS+CD_MONTH_SIZE)) {
-        _displayBufferAlt[pos++] = getLEDAlphaChar(text[idx++]);
-    }
-#endif
-
-    while(pos < CD_DAY_POS) {
-        _displayBufferAlt[pos++] = 0;
-    }
-    
-    pos = CD_DAY_POS;
-    while(text[idx] && pos <= CD_MIN_POS) {
-        temp = getLED7AlphaChar(text[idx++]);
-        if(text[idx]) {
-            temp |= (getLED7AlphaChar(text[idx++]) << 8);
-        }
-        _displayBufferAlt[pos++] = temp;
-    }
-
-    while(pos <= CD_MIN_POS) {
-        _displayBufferAlt[pos++] = 0;
-    }
+    renderText(_displayBufferAlt, text);
 }
 
 
@@ -715,12 +876,20 @@ void clockDisplay::showMinuteDirect(int minuteNum, uint16_t dflags)
 
 // Show the given text
 void clockDisplay::showTextDirect(const char *text, uint16_t flags)
+{
+    uint16_t frame[CD_BUF_SIZE];
+    
+    showFrameDirect(frame, renderText(frame, text, flags));
+}
+
+// Render text into a frame; returns the number of columns
+// rendered (all unless CDT_CLEAR is not given)
+int clockDisplay::renderText(uint16_t *frame, const char *text, uint16_t flags)
 {
     int idx = 0, pos = CD_MONTH_POS;
     int temp = 0;
 
     _corr6 = (flags & CDT_CORR6) ? true : false;
-    _withColon = (flags & CDT_COLON) ? true : false;
 
 #ifdef IS_ACAR_DISPLAY
     while(text[idx] && pos < (CD_MONTH_POS+CD_MONTH_SIZE)) {
@@ -728,16 +897,16 @@ void clockDisplay::showTextDirect(const char *text, uint16_t flags)
         if(text[idx]) {
             temp |= (getLED7AlphaChar(text[idx++]) << 8);
         }
-        directCol(pos++, temp);
+        frame[pos++] = temp;
     }
 #else
     while(text[idx] && pos < (CD_MONTH_POS+CD_MONTH_SIZE)) {
-        directCol(pos++, getLEDAlphaChar(text[idx++]));
+        frame[pos++] = getLEDAlphaChar(text[idx++]);
     }
 #endif
 
     while(pos < CD_DAY_POS) {
-        directCol(pos++, 0);
+        frame[pos++] = 0;
     }
     
     pos = CD_DAY_POS;
@@ -746,16 +915,113 @@ void clockDisplay::showTextDirect(const char *text, uint16_t flags)
         if(text[idx]) {
             temp |= (getLED7AlphaChar(text[idx++]) << 8);
         }
-        directCol(pos++, temp);
+        frame[pos++] = temp;
     }
 
     if(flags & CDT_CLEAR) {
         while(pos <= CD_MIN_POS) {
-            directCol(pos++, 0);
+            frame[pos++] = 0;
+        }
+    }
+
+    if((flags & CDT_COLON) && pos > CD_YEAR_POS) {
+        frame[CD_YEAR_POS] |= 0x8080;
+    }
+    
+    _corr6 = false;
+
+    return pos;
+}
+
+// Render text into a scroll strip; returns the text length.
+// showStripDirect(strip, n) then shows the same as 
+// showTextDirect(text + n) would.
+int clockDisplay::renderStrip(cdStrip *strip, const char *text)
+{
+    int len = strlen(text);
+    uint16_t segs;
+
+    if(len > CD_STRIP_TEXT) len = CD_STRIP_TEXT;
+
+    memset(strip, 0, sizeof(cdStrip));
+    strip->len = len;
+
+    for(int i = 0; i < len; i++) {
+        #ifndef IS_ACAR_DISPLAY
+        strip->alpha[i] = getLEDAlphaChar(text[i]);
+        #endif
+        segs = getLED7AlphaChar(text[i]);
+        strip->pairs[i & 1][i >> 1] |= segs;
+        if(i) {
+            strip->pairs[(i - 1) & 1][(i - 1) >> 1] |= (segs << 8);
+        }
+    }
+
+    return len;
+}
+
+// Show a strip from char offset on (directly write to display)
+void clockDisplay::showStripDirect(const cdStrip *strip, int offset)
+{
+    uint16_t frame[CD_BUF_SIZE];
+    int i;
+
+    if(offset < 0) offset = 0;
+    else if(offset > strip->len) offset = strip->len;
+
+    #ifdef IS_ACAR_DISPLAY
+    memcpy(&frame[CD_MONTH_POS], &strip->pairs[offset & 1][offset >> 1], CD_MONTH_SIZE * 2);
+    #else
+    memcpy(&frame[CD_MONTH_POS], &strip->alpha[offset], CD_MONTH_SIZE * 2);
+    #endif
+    for(i = CD_MONTH_POS + CD_MONTH_SIZE; i < CD_DAY_POS; i++) {
+        frame[i] = 0;
+    }
+
+    i = offset + CD_MONTH_DIGS;
+    memcpy(&frame[CD_DAY_POS], &strip->pairs[i & 1][i >> 1], (CD_MIN_POS - CD_DAY_POS + 1) * 2);
+
+    showFrameDirect(frame, CD_BUF_SIZE);
+}
+
+// Send (the first cols columns of) a frame in one transaction
+// (leave buffer intact, directly write to display)
+void clockDisplay::showFrameDirect(const uint16_t *frame, int cols)
+{
+    uint16_t segments;
+
+    // If we know what the remaining columns hold, make 
+    // it a full frame (which can be held and diffed)
+    if(cols >= CD_BUF_SIZE || _framePending || _shadowValid) {
+        const uint16_t *rest = _framePending ? _frameBuf : _shadowBuf;
+        uint16_t full[CD_BUF_SIZE];
+        for(int i = 0; i < CD_BUF_SIZE; i++) {
+            if(i < cols) {
+                full[i] = frame[i];
+                if((i == CD_YEAR_POS + 1) && _yearDot) {
+                    full[i] |= 0x8000;
+                }
+            } else {
+                full[i] = rest[i];
+            }
         }
+        putFrame(full);
+        return;
     }
     
-    _corr6 = _withColon = false;
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(0x00);
+    for(int i = 0; i < cols; i++) {
+        segments = frame[i];
+        if((i == CD_YEAR_POS + 1) && _yearDot) {
+            segments |= 0x8000;
+        }
+        TC_FASTWIRE.write(segments & 0xff);
+        TC_FASTWIRE.write(segments >> 8);
+        liveCols(i, &segments, 1);
+    }
+    TC_FASTWIRE.endTransmission();
 }
 
 // Clear the display RAM and only show the provided 2 numbers (parts of IP)
@@ -874,14 +1140,18 @@ int16_t clockDisplay::loadClockStateData(int16_t& yoffs)
     if(!_rtc)
         return -2;
 
-    if(FlashROMode) {
-        readFileFromSD(fnLastYearSD, loadBuf, 8);
-    } else {
-        readFileFromFS(fnLastYear, loadBuf, 8);
+    if(!rtcMemGet(CD_SLOT_LY, loadBuf, 8) || !clockStateOk(loadBuf)) {
+        if(FlashROMode) {
+            readFileFromSD(fnLastYearSD, loadBuf, 8);
+        } else if(!nvsGet(CD_SLOT_LY, loadBuf, 8) || !clockStateOk(loadBuf)) {
+            readFileFromFS(fnLastYear, loadBuf, 8);
+        }
+        if(clockStateOk(loadBuf)) {
+            rtcMemPut(CD_SLOT_LY, loadBuf, 8);
+        }
     }
 
-    if( (loadBuf[0] == (loadBuf[2] ^ 0xff)) &&
-        (loadBuf[1] == (loadBuf[3] ^ 0xff)) ) {
+    if(clockStateOk(loadBuf)) {
 
         if( (loadBuf[4] == (loadBuf[6] ^ 0x55)) &&
             (loadBuf[5] == (loadBuf[7] ^ 0x55)) ) {
@@ -904,7 +1174,7 @@ int16_t clockDisplay::loadClockStateData(int16_t& yoffs)
  * recovering previous time state at boot.
  * Returns true if FS was accessed during operation
  */
-bool clockDisplay::saveClockStateData(uint16_t curYear)
+bool clockDisplay::saveClockStateData(uint16_t curYear, bool force)
 {
     uint8_t savBuf[8];
 
@@ -912,38 +1182,53 @@ bool clockDisplay::saveClockStateData(uint16_t curYear)
         return false;
 
     // Check if values identical to last ones written
-    if((_lastWrittenLY == curYear) && (_lastWrittenYO == _yearoffset))
-        return false;
+    if((_lastWrittenLY != curYear) || (_lastWrittenYO != _yearoffset)) {
 
-    // If not, read to check if identical to stored
-    if(!_lastWrittenRead) {
-        _lastWrittenLY = loadClockStateData(_lastWrittenYO);
-        _lastWrittenRead = true;
-        if((_lastWrittenLY == curYear) && (_lastWrittenYO == _yearoffset))
-            return true;
+        // If not, read to check if identical to stored
+        if(!_lastWrittenRead) {
+            _lastWrittenLY = loadClockStateData(_lastWrittenYO);
+            _lastWrittenRead = true;
+        }
+
+        if((_lastWrittenLY != curYear) || (_lastWrittenYO != _yearoffset)) {
+            _lastWrittenLY = curYear;
+            _lastWrittenYO = _yearoffset;
+            makeClockStateBuf(savBuf);
+            rtcMemPut(CD_SLOT_LY, savBuf, 8);
+            if(!_lyCkptPending) _lyCkptSince = millis();
+            _lyCkptPending = true;
+            _lyLastChange = millis();
+        }
     }
-    
-    savBuf[0] = curYear & 0xff;
-    savBuf[1] = (curYear >> 8) & 0xff;    
-    savBuf[2] = savBuf[0] ^ 0xff;
-    savBuf[3] = savBuf[1] ^ 0xff;
-    savBuf[4] = ((uint16_t)_yearoffset) & 0xff;
-    savBuf[5] = (((uint16_t)_yearoffset) >> 8) & 0xff;
-    savBuf[6] = savBuf[4] ^ 0x55;
-    savBuf[7] = savBuf[5] ^ 0x55;
 
-    _lastWrittenLY = curYear;
-    _lastWrittenYO = _yearoffset;
+    if(!_lyCkptPending || !(force || ckptDue(_lyLastChange, _lyCkptSince)))
+        return false;
+
+    makeClockStateBuf(savBuf);
 
     if(FlashROMode) {
         writeFileToSD(fnLastYearSD, savBuf, 8);
     } else {
-        writeFileToFS(fnLastYear, savBuf, 8);
+        nvsPut(CD_SLOT_LY, savBuf, 8);
     }
 
+    _lyCkptPending = false;
+
     return true;
 }
 
+void clockDisplay::makeClockStateBuf(uint8_t *savBuf)
+{
+    savBuf[0] = ((uint16_t)_lastWrittenLY) & 0xff;
+    savBuf[1] = (((uint16_t)_lastWrittenLY) >> 8) & 0xff;    
+    savBuf[2] = savBuf[0] ^ 0xff;
+    savBuf[3] = savBuf[1] ^ 0xff;
+    savBuf[4] = ((uint16_t)_lastWrittenYO) & 0xff;
+    savBuf[5] = (((uint16_t)_lastWrittenYO) >> 8) & 0xff;
+    savBuf[6] = savBuf[4] ^ 0x55;
+    savBuf[7] = savBuf[5] ^ 0x55;
+}
+
 /*
  * Load display specific data from NVM storage
  *
@@ -1006,9 +1291,15 @@ void clockDisplay::savePending()
 }
 
 // Returns true if FS was accessed
-bool clockDisplay::saveFlush()
+bool clockDisplay::saveFlush(bool force)
 {    
-    return (_savePending == 1) ? save() : false;
+    // Delayed save only goes to RTC memory
+    if(_savePending == 1) save();
+
+    if(!_ckptPending || !(force || ckptDue(_lastChange, _ckptSince)))
+        return false;
+
+    return writeCheckpoint();
 }
 
 /*
@@ -1052,52 +1343,62 @@ bool clockDisplay::save(bool force)
 
 // Private functions ###########################################################
 
+// Saves to RTC memory; checkpoint done by saveFlush() unless force. 
 // Returns true if FS was accessed
-// Returns false if not (data identical to cached)
-bool clockDisplay::saveNVMData(uint8_t *savBuf, bool noReadChk)
+// Returns false if not (data identical to cached, or checkpoint pending)
+bool clockDisplay::saveNVMData(uint8_t *savBuf, bool force)
 {
     uint16_t sum = 0;
     uint8_t loadBuf[10];
-    bool skipSave = false;
     bool flashAccess = false;
 
     // Read to check if values identical to currently stored (reduce wear)        
-    if(!noReadChk && loadNVMData(loadBuf, flashAccess)) {
-        skipSave = true;
-        for(int i = 0; i < 9; i++) {
-            if(savBuf[i] != loadBuf[i]) {
-                skipSave = false;
-                break;
-            }
-        }
+    if(!force && loadNVMData(loadBuf, flashAccess)) {
+        if(!memcmp(savBuf, loadBuf, 9))
+            return flashAccess;
+    }
+
+    for(int i = 0; i < 9; i++) {
+        sum += (savBuf[i] ^ 0x55);
     }
+    savBuf[9] = sum & 0xff;
 
-    if(skipSave)
-        return flashAccess;
+    rtcMemPut(_did, savBuf, 10);
 
+    memcpy(_CacheData, savBuf, 10);
+    _Cache = 2;
+
+    if(!_ckptPending) _ckptSince = millis();
+    _ckptPending = true;
+    _lastChange = millis();
+
+    if(force) {
+        return writeCheckpoint();
+    }
+
+    return flashAccess;
+}
+
+// Write cached data to checkpoint storage
+bool clockDisplay::writeCheckpoint()
+{
     #ifdef TC_DBG
     unsigned long now = millis();
     #endif
 
-    for(int i = 0; i < 9; i++) {
-        sum += (savBuf[i] ^ 0x55);
-    }
-    savBuf[9] = sum & 0xff;
+    _ckptPending = false;
+
+    if(_Cache != 2)
+        return false;
 
     if(_configOnSD) {
-        writeFileToSD(fnSD[_did], savBuf, 10);
+        writeFileToSD(fnSD[_did], (uint8_t *)_CacheData, 10);
     } else {
-        writeFileToFS(fnEEPROM[_did], savBuf, 10);
+        nvsPut(_did, (uint8_t *)_CacheData, 10);
     }
 
-    // Copy to cache regardless of result of write; otherwise
-    // the load function would read corrupt data instead of
-    // using the ok data in the cache.
-    memcpy(_CacheData, savBuf, 10);
-    _Cache = 2;
-
     #ifdef TC_DBG
-    Serial.printf("saveNVMdata took %ld\n", millis()-now);
+    Serial.printf("NVM checkpoint took %ld\n", millis()-now);
     #endif
 
     return true;
@@ -1106,49 +1407,52 @@ bool clockDisplay::saveNVMData(uint8_t *savBuf, bool noReadChk)
 // Returns true if loaded data is valid, otherwise false
 bool clockDisplay::loadNVMData(uint8_t *loadBuf, bool& flashAccess)
 {
-    uint16_t sum = 0;
     bool dataOk = false;
-    #ifdef TC_DBG
-    unsigned long now = millis();
-    #endif
 
     flashAccess = false;
     memset(loadBuf, 0, 10);
 
     if(_Cache == 2) {
         memcpy(loadBuf, _CacheData, 10);
-        for(int i = 0; i < 9; i++) {
-           sum += (loadBuf[i] ^ 0x55);
-        }
-        dataOk = ((sum & 0xff) == loadBuf[9]);
+        dataOk = nvmSumOk(loadBuf);
     }
 
     if(!dataOk) {
 
         _Cache = -1;  // Invalidate; either empty or corrupt
-        flashAccess = true;
+
+        if(!(dataOk = (rtcMemGet(_did, loadBuf, 10) && nvmSumOk(loadBuf)))) {
             
-        if(_configOnSD) {
-            dataOk = readFileFromSD(fnSD[_did], loadBuf, 10);
-        } 
-        if(!dataOk) {
-            readFileFromFS(fnEEPROM[_did], loadBuf, 10);
-        }
+            #ifdef TC_DBG
+            unsigned long now = millis();
+            #endif
+
+            flashAccess = true;
 
-        for(int i = 0; i < 9; i++) {
-           sum += (loadBuf[i] ^ 0x55);
+            if(_configOnSD) {
+                dataOk = readFileFromSD(fnSD[_did], loadBuf, 10) && nvmSumOk(loadBuf);
+            } 
+            if(!dataOk) {
+                dataOk = nvsGet(_did, loadBuf, 10) && nvmSumOk(loadBuf);
+            }
+            if(!dataOk) {
+                dataOk = readFileFromFS(fnEEPROM[_did], loadBuf, 10) && nvmSumOk(loadBuf);
+            }
+            if(dataOk) {
+                rtcMemPut(_did, loadBuf, 10);
+            }
+
+            #ifdef TC_DBG
+            Serial.printf("loadNVMdata took %ld\n", millis()-now);
+            #endif
         }
-        dataOk = ((sum & 0xff) == loadBuf[9]);
+
         if(dataOk) {
             memcpy(_CacheData, loadBuf, 10);
             _Cache = 2;
         }
     }
 
-    #ifdef TC_DBG
-    Serial.printf("loadNVMdata took %ld\n", millis()-now);
-    #endif
-
     return dataOk;
 }
 
@@ -1204,6 +1508,14 @@ uint16_t clockDisplay::makeNum(uint8_t num, uint16_t dflags)
     // Each position holds two digits
     // MSB = 1s, LSB = 10s
 
+    if(num < 100) {
+        segments = numDigs2[num];
+        if((dflags & CDD_NOLEAD0) && num < 10) {
+            segments &= 0xff00;
+        }
+        return segments;
+    }
+
     segments = getLED7NumChar(num % 10) << 8;     
     if(!(dflags & CDD_NOLEAD0) || (num / 10)) {
         segments |= getLED7NumChar(num / 10);   
@@ -1218,27 +1530,32 @@ void clockDisplay::directCol(int col, int segments)
 {
     if((col == CD_YEAR_POS + 1) && _yearDot) {
         segments |= 0x8000;
-    } else if((col == CD_YEAR_POS) && _withColon) {
-        segments |= 0x8080;
     }
-    Wire.beginTransmission(_address);
-    Wire.write(col * 2);
-    Wire.write(segments & 0xff);
-    Wire.write(segments >> 8);
-    Wire.endTransmission();
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(col * 2);
+    TC_FASTWIRE.write(segments & 0xff);
+    TC_FASTWIRE.write(segments >> 8);
+    TC_FASTWIRE.endTransmission();
+
+    uint16_t s = segments;
+    liveCols(col, &s, 1);
 }
 
 // Directly clear the display
 void clockDisplay::clearDisplay()
 {
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(0x00);
 
     for(int i = 0; i < CD_BUF_SIZE*2; i++) {
-        Wire.write(0x00);
+        TC_FASTWIRE.write(0x00);
     }
 
-    Wire.endTransmission();
+    TC_FASTWIRE.endTransmission();
+
+    liveCols(0, NULL, CD_BUF_SIZE);
 }
 
 bool clockDisplay::handleNM()
@@ -1264,17 +1581,89 @@ bool clockDisplay::handleNM()
     return true;
 }
 
+// Send frame, or keep it for commitFrame() if held
+void clockDisplay::putFrame(const uint16_t *frame)
+{
+    if(_holdFrame) {
+        memcpy(_frameBuf, frame, sizeof(_frameBuf));
+        _framePending = true;
+    } else {
+        sendFrame(frame);
+    }
+}
+
+// Compare frame with what the display already has; only
+// send the range of words that changed.
+void clockDisplay::sendFrame(const uint16_t *frame)
+{
+    int i, first = CD_BUF_SIZE, last = -1;
+
+    for(i = 0; i < CD_BUF_SIZE; i++) {
+        if(!_shadowValid || frame[i] != _shadowBuf[i]) {
+            if(first > i) first = i;
+            last = i;
+        }
+    }
+
+    if(last < 0)
+        return;
+
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(first * 2);
+    for(i = first; i <= last; i++) {
+        TC_FASTWIRE.write(frame[i] & 0xff);
+        TC_FASTWIRE.write(frame[i] >> 8);
+    }
+    if(!TC_FASTWIRE.endTransmission()) {
+        memcpy(_shadowBuf, frame, sizeof(_shadowBuf));
+        _shadowValid = true;
+        liveCols(first, &frame[first], last - first + 1);
+    } else {
+        _shadowValid = false;
+    }
+}
+
+// Keep track of what was written to display RAM;
+// frame NULL means cleared columns
+void clockDisplay::liveCols(int first, const uint16_t *frame, int num)
+{
+    if(frame) {
+        memcpy(&_liveBuf[first], frame, num * sizeof(uint16_t));
+    } else {
+        memset(&_liveBuf[first], 0, num * sizeof(uint16_t));
+    }
+    _liveSeq++;
+}
+
+uint16_t clockDisplay::getLiveFrame(uint16_t *frame, bool& isOn, uint8_t& bri)
+{
+    memcpy(frame, _liveBuf, sizeof(_liveBuf));
+    isOn = (_onCache != 0xff) && (_onCache & 0x01);
+    bri = _briCache & 0x0f;
+
+    return _liveSeq;
+}
+
 // Show the buffer
-void clockDisplay::showInt(bool animate, bool Alt)
+void TC_HOT clockDisplay::showInt(bool animate, bool Alt)
 {
     int i = 0;
     uint16_t *db = Alt ? _displayBufferAlt : _displayBuffer;
+    CYC_START();
 
-    if(!handleNM())
+    // Commands from NM handling go out with the frame
+    holdCmds();
+
+    if(!handleNM()) {
+        if(!_holdFrame) flushCmds();
+        CYC_END(CYC_SHOWINT);
         return;
+    }
 
     if(animate) off();
 
+    if(!_holdFrame) flushCmds();
+
     if(!_mode24) {
         (_hour < 12) ? AM() : PM();
     } else {
@@ -1283,26 +1672,19 @@ void clockDisplay::showInt(bool animate, bool Alt)
 
     (_colon) ? colonOn() : colonOff();
 
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);
-
-    if(animate) {
-        for(i = 0; i < CD_DAY_POS; i++) {
-            Wire.write(0x00);  // blank month
-            Wire.write(0x00);
-        }
-    }
+    uint16_t frame[CD_BUF_SIZE];
 
-    for(; i < CD_BUF_SIZE; i++) {
-        Wire.write(db[i] & 0xff);
-        Wire.write(db[i] >> 8);
+    for(i = 0; i < CD_BUF_SIZE; i++) {
+        frame[i] = (animate && i < CD_DAY_POS) ? 0 : db[i];   // blank month if animating
     }
 
-    Wire.endTransmission();
+    putFrame(frame);
 
     if(animate || (_NmOff && (_oldnm > 0)) ) on();
 
     if(_NmOff) _oldnm = 0;
+
+    CYC_END(CYC_SHOWINT);
 }
 
 void clockDisplay::colonOn()
@@ -1344,11 +1726,15 @@ void clockDisplay::AMPMoff()
 
 void clockDisplay::directAMPM(int val1, int val2)
 {
-    Wire.beginTransmission(_address);
-    Wire.write(CD_AMPM_POS * 2);
-    Wire.write(val1 & 0xff);
-    Wire.write(val2 & 0xff);
-    Wire.endTransmission();
+    _shadowValid = false;
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(CD_AMPM_POS * 2);
+    TC_FASTWIRE.write(val1 & 0xff);
+    TC_FASTWIRE.write(val2 & 0xff);
+    TC_FASTWIRE.endTransmission();
+
+    uint16_t s = (val1 & 0xff) | ((val2 & 0xff) << 8);
+    liveCols(CD_AMPM_POS, &s, 1);
 }
 
 void clockDisplay::directAM()
@@ -1374,9 +1760,28 @@ void clockDisplay::directAMPMoff()
     directAMPM(0x00, 0x00);
 }
 
-void clockDisplay::directCmd(uint8_t val)
+// Display setup (0x8x) and dimming (0xex) commands:
+// Skip if the display already has this setting.
+void clockDisplay::queueCmd(uint8_t val)
+{
+    uint8_t *cache = ((val & 0xf0) == 0xe0) ? &_briCache : &_onCache;
+
+    if(_holdCmds) {
+        if(cache == &_briCache) _pendBri = val;
+        else                    _pendOn = val;
+        return;
+    }
+    
+    if(*cache == val)
+        return;
+
+    *cache = directCmd(val) ? val : 0xff;
+    _liveSeq++;
+}
+
+bool clockDisplay::directCmd(uint8_t val)
 {
-    Wire.beginTransmission(_address);
-    Wire.write(val);
-    Wire.endTransmission();
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(val);
+    return !TC_FASTWIRE.endTransmission();
 }
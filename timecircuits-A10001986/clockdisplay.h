@@ -77,16 +77,35 @@ struct dateStruct {
 #define CDD_FORCE24 0x0001
 #define CDD_NOLEAD0 0x0002
 
+// Pre-rendered text strip for scrolling; holds each character's
+// glyph(s) for every kind of field it may end up in, so that any
+// offset can be shown without re-rendering (see renderStrip())
+#define CD_STRIP_TEXT  256
+#define CD_STRIP_CHARS (CD_STRIP_TEXT + DISP_LEN + 2)
+
+typedef struct {
+    #ifndef IS_ACAR_DISPLAY
+    uint16_t alpha[CD_STRIP_CHARS];                 // 14-segment, by char
+    #endif
+    uint16_t pairs[2][(CD_STRIP_CHARS + 1) / 2];    // 7-segment pairs starting at even/odd char
+    int16_t  len;
+} cdStrip;
+
 class clockDisplay {
 
     public:
 
         clockDisplay(uint8_t did, uint8_t address);
         void begin();
+        uint8_t getAddress() { return _address; }
         void on();
         void onCond();
         void off();
         void onBlink(uint8_t blink);
+        void holdCmds();
+        void flushCmds();
+        void holdFrame();
+        void commitFrame();
         #if 0
         void realLampTest();
         #endif
@@ -156,9 +175,19 @@ class clockDisplay {
         void showYearDirect(int yearNum, uint16_t dflags = 0);
 
         void showTextDirect(const char *text, uint16_t flags = CDT_CLEAR);
+
+        // Pre-rendered frames: Render once, show repeatedly
+        int  renderText(uint16_t *frame, const char *text, uint16_t flags = CDT_CLEAR);
+        void showFrameDirect(const uint16_t *frame, int cols = CD_BUF_SIZE);
+        int  renderStrip(cdStrip *strip, const char *text);
+        void showStripDirect(const cdStrip *strip, int offset);
         void showHalfIPDirect(int a, int b, uint16_t flags = 0);
         void showSettingValDirect(const char* setting, int8_t val = -1, uint16_t flags = 0);
 
+        // What the display currently shows (for observers);
+        // returns a sequence number that changes with every write
+        uint16_t getLiveFrame(uint16_t *frame, bool& isOn, uint8_t& bri);
+
         #ifdef TC_HAVETEMP
         void showTempDirect(float temp, bool tempUnit, bool animate = false);
         void showHumDirect(int hum, bool animate = false);
@@ -166,17 +195,19 @@ class clockDisplay {
 
         bool    load();
         void    savePending();
-        bool    saveFlush();
+        bool    saveFlush(bool force = false);
         bool    save(bool force = false);
         bool    _configOnSD = false;
 
-        bool    saveClockStateData(uint16_t curYear);
+        bool    saveClockStateData(uint16_t curYear, bool force = false);
         int16_t loadClockStateData(int16_t& yoffs);
 
     private:
 
-        bool     saveNVMData(uint8_t *savBuf, bool noReadChk = false);
+        bool     saveNVMData(uint8_t *savBuf, bool force = false);
         bool     loadNVMData(uint8_t *loadBuf, bool& flashAccess);
+        bool     writeCheckpoint();
+        void     makeClockStateBuf(uint8_t *savBuf);
 
         uint8_t  getLED7NumChar(uint8_t value);
         uint8_t  getLED7AlphaChar(uint8_t value);
@@ -203,12 +234,24 @@ class clockDisplay {
         void directPM();
         void directAMPMoff();
 
-        void directCmd(uint8_t val);
+        void putFrame(const uint16_t *frame);
+        void sendFrame(const uint16_t *frame);
+        void liveCols(int first, const uint16_t *frame, int num);
+
+        void queueCmd(uint8_t val);
+        bool directCmd(uint8_t val);
 
         uint8_t  _did = 0;
         uint8_t  _address = 0;
         uint16_t _displayBuffer[CD_BUF_SIZE];
         uint16_t _displayBufferAlt[CD_BUF_SIZE];
+        uint16_t _shadowBuf[CD_BUF_SIZE];   // What showInt() last sent
+        bool     _shadowValid = false;      // false if display RAM was written otherwise
+        uint16_t _frameBuf[CD_BUF_SIZE];    // Frame held for commitFrame()
+        bool     _holdFrame = false;
+        bool     _framePending = false;
+        uint16_t _liveBuf[CD_BUF_SIZE];     // Mirror of display RAM
+        uint16_t _liveSeq = 0;
 
         uint16_t _year = 2021;          // keep track of these
         int16_t  _yearoffset = 0;       // Offset for faking years < 2000, > 2098
@@ -231,12 +274,24 @@ class clockDisplay {
         int     _oldnm = -1;
         bool    _corr6 = false;
         bool    _yearDot = false;
-        bool    _withColon = false;
 
         int8_t  _Cache = -1;
         char    _CacheData[10];
 
+        uint8_t _onCache = 0xff;        // Last display setup cmd sent
+        uint8_t _briCache = 0xff;       // Last dimming cmd sent
+        bool    _holdCmds = false;
+        uint8_t _pendOn = 0xff;         // Held back cmds
+        uint8_t _pendBri = 0xff;
+
         int     _savePending = 0;
+
+        bool          _ckptPending = false;     // Checkpoint of NVM data due
+        unsigned long _ckptSince = 0;           // First change since last checkpoint
+        unsigned long _lastChange = 0;
+        bool          _lyCkptPending = false;   // Same for clock state data
+        unsigned long _lyCkptSince = 0;
+        unsigned long _lyLastChange = 0;
 };
 
 #endif
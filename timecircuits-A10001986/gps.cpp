@@ -57,11 +57,23 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <esp_timer.h>
 #include "gps.h"
 
 #define GPS_MPH_PER_KNOT  1.15077945
+#define GPS_MPH_PER_KNOT_E7 11507795
 #define GPS_KMPH_PER_KNOT 1.852
 
+// Typical sentence lengths (bytes, including CR/LF)
+#define GPS_LEN_RMC       75
+#define GPS_LEN_VTG       40
+#define GPS_LEN_ZDA       38
+
+// i2c read size limits
+#define GPS_READ_MIN      16
+#define GPS_READ_MAX     128    // Wire buffer size
+#define GPS_READ_MARGIN   16
+
 // For deeper debugging
 #ifdef TC_DBG
 //#define TC_DBG_GPS
@@ -97,13 +109,6 @@ static void defaultDelay(unsigned long mydelay)
     delay(mydelay);
 }
 
-static bool mystrcmp3(char *src, const char *cmp)
-{
-    if(*(src++) != *(cmp++)) return true;
-    if(*(src++) != *(cmp++)) return true;
-    return (*src != *cmp);
-}
-
 static uint8_t parseHex(char c)
 {
     if(c < '0')   return 0;
@@ -115,45 +120,6 @@ static uint8_t parseHex(char c)
     return 0;
 }
 
-static uint8_t AToI2(char *buf)
-{
-    return ((*buf - '0') * 10) + (*(buf+1) - '0');
-}
-
-static uint16_t AToI4(char *buf)
-{
-    return (AToI2(buf) * 100) + AToI2(buf+2);
-}
-
-static unsigned long getFracs(char *buf)
-{
-    uint16_t f = 0, c = 1000;
-    
-    while(*buf && *buf != ',') {
-        c /= 10;
-        f *= 10;
-        f += (*buf - '0');
-        buf++;
-    }
-
-    return (unsigned long)(f * c);
-}
-
-static char * gotoNext(char *t)
-{
-    return strchr(t, ',') + 1;
-}
-
-static void copy6chars(char *a, char *b)
-{
-    *a++ = *b++;
-    *a++ = *b++;
-    *a++ = *b++;
-    *a++ = *b++;
-    *a++ = *b++;
-    *a = *b;
-}
-
 static void calcNMEAcheckSum(char *cmdbuf)
 {
     int checksum = 0;
@@ -186,8 +152,7 @@ bool tcGPS::begin(unsigned long powerupTime, int quickUpdates, int speedRate, vo
     
     _customDelayFunc = defaultDelay;
 
-    _currentline = _line1;
-    _lenIdx = 0;
+    _nState = 0;
 
     fix = false;
     _speed = -1;
@@ -203,6 +168,35 @@ bool tcGPS::begin(unsigned long powerupTime, int quickUpdates, int speedRate, vo
         delay(1000 - (millisNow - powerupTime));
     }
 
+    #ifdef TC_GPS_UART
+
+    // Receiver on UART: The driver fills its RX ring
+    // buffer by interrupt; we only fetch what's there.
+    _uart = &Serial2;
+    _uart->setRxBufferSize(GPS_UART_RXBUF);
+    _uart->begin(GPS_UART_BAUD, SERIAL_8N1, GPS_UART_RX_PIN, GPS_UART_TX_PIN);
+
+    // Wait for 8 bytes of data (receiver sends once per second)
+    millisNow = millis();
+    while(_uart->available() < 8) {
+        if(millis() - millisNow > 1500) {
+            _uart->end();
+            _uart = NULL;
+            return false;
+        }
+        delay(10);
+    }
+    for(int i = 0; i < 8; i++) {
+        testBuf = _uart->read();
+        if(testBuf != 0x0a && testBuf != 0x0d && (testBuf < ' ' || testBuf > 0x7e)) {
+            _uart->end();
+            _uart = NULL;
+            return false;
+        }
+    }
+
+    #else
+    
     // Check for GPS module on i2c bus
     Wire.beginTransmission(_address);
     if(Wire.endTransmission(true))
@@ -221,6 +215,8 @@ bool tcGPS::begin(unsigned long powerupTime, int quickUpdates, int speedRate, vo
     } else
         return false;
 
+    #endif
+
     // Send xxRMC and xxZDA only, for high rates also xxVTG
     // If we use GPS for speed, we need more frequent updates.
     // The value in PKT 314 is a multiplier for the value of PKT 220.
@@ -230,9 +226,15 @@ bool tcGPS::begin(unsigned long powerupTime, int quickUpdates, int speedRate, vo
         idx = (!speedRate) ? 1 : 2;
     } else {
         idx = speedRate + 3;
-        // For reading 128 bytes per call:
-        _lenLimit = 0x01;
-        _lenArr[0] = 128; _lenArr[1] = 127;
+    }
+
+    // Calculate NMEA output rate (bytes per second) to
+    // size our reads accordingly
+    {
+        uint32_t perFix = (GPS_LEN_RMC * 1000) / GPSSetup[idx].rmc +
+                          (GPS_LEN_ZDA * 1000) / GPSSetup[idx].zda;
+        if(GPSSetup[idx].vtg) perFix += (GPS_LEN_VTG * 1000) / GPSSetup[idx].vtg;
+        _bytesPerSec = perFix / atoi(GPSSetup[idx].cmd2);
     }
     sprintf(cmdbuf, "$PMTK314,0,%d,%d,0,0,0,0,0,0,0,0,0,0,0,0,0,0,%d,0,0", 
           GPSSetup[idx].rmc, GPSSetup[idx].vtg, GPSSetup[idx].zda);
@@ -253,7 +255,9 @@ bool tcGPS::begin(unsigned long powerupTime, int quickUpdates, int speedRate, vo
     //delay(800);
     // No, might lose fix in the process; empty
     // buffer by reading it
-    for(int i = 0; i <= _lenLimit; i++) {
+    _readLen = GPS_READ_MAX;
+    _drained = false;
+    for(int i = 0; i < 8 && !_drained; i++) {
         readAndParse(false);
     }
 
@@ -311,8 +315,6 @@ void tcGPS::loop(bool doDelay)
  */
 int16_t tcGPS::getSpeed()
 {
-    float speedfk;
-    
     if(_haveSpeed) {
         #ifdef GPS_SPEED_SIMU
         // Speed "simulator" for debugging
@@ -323,12 +325,12 @@ int16_t tcGPS::getSpeed()
         // low speeds, need to ignore everything below
         // 2.17(=2.5mph) as this much might appear even
         // at stand-still.
-        speedfk = strtof(_sbuf, NULL);
-        if(speedfk >= 2.61) {        // 3.00mph
-            _speed = (int)roundf(speedfk * GPS_MPH_PER_KNOT);
-        } else if(speedfk <= 2.17) { // 2.50mph
+        // (_spdKn100 is knots * 100)
+        if(_spdKn100 >= 261) {        // 3.00mph
+            _speed = (int)(((uint64_t)_spdKn100 * GPS_MPH_PER_KNOT_E7 + 500000000) / 1000000000);
+        } else if(_spdKn100 <= 217) { // 2.50mph
             _speed = 0;
-        } else if(speedfk <= 2.40) { // 2.76mph
+        } else if(_spdKn100 <= 240) { // 2.76mph
             _speed = 1;
         } else {
             _speed = 2;
@@ -349,8 +351,10 @@ bool tcGPS::haveTime()
 /*
  * Get GPS time
  * timeinfo returned is UTC
+ * secStartUs is the esp_timer time at which the 
+ * returned second started.
  */
-bool tcGPS::getDateTime(struct tm *timeinfo, unsigned long *fixAge, unsigned long updInt)
+bool tcGPS::getDateTime(struct tm *timeinfo, int64_t *secStartUs)
 {
 
     if(_haveDateTime) {
@@ -359,13 +363,13 @@ bool tcGPS::getDateTime(struct tm *timeinfo, unsigned long *fixAge, unsigned lon
         timeinfo->tm_mon  = _curMonth - 1;
         timeinfo->tm_year = _curYear - 1900;
 
-        timeinfo->tm_hour = AToI2(&_curTime[0]);
-        timeinfo->tm_min  = AToI2(&_curTime[2]);
-        timeinfo->tm_sec  = AToI2(&_curTime[4]);
+        timeinfo->tm_hour = _curHour;
+        timeinfo->tm_min  = _curMin;
+        timeinfo->tm_sec  = _curSec;
         
         timeinfo->tm_wday = 0;
 
-        *fixAge = (unsigned long)(millis() - _curTS + _curFrac + updInt);
+        *secStartUs = _curTSUs - (int64_t)_curFrac * 1000;
 
         return true;
 
@@ -378,13 +382,13 @@ bool tcGPS::getDateTime(struct tm *timeinfo, unsigned long *fixAge, unsigned lon
         if(timeinfo->tm_year < (TCEPOCH_GEN-1900))
             timeinfo->tm_year += 100;
 
-        timeinfo->tm_hour = AToI2(&_curTime2[0]);
-        timeinfo->tm_min  = AToI2(&_curTime2[2]);
-        timeinfo->tm_sec  = AToI2(&_curTime2[4]);
+        timeinfo->tm_hour = _curHour2;
+        timeinfo->tm_min  = _curMin2;
+        timeinfo->tm_sec  = _curSec2;
 
         timeinfo->tm_wday = 0;
 
-        *fixAge = (unsigned long)(millis() - _curTS2 + _curFrac2 + updInt);
+        *secStartUs = _curTS2Us - (int64_t)_curFrac2 * 1000;
 
         return true;
 
@@ -446,6 +450,16 @@ bool tcGPS::setDateTime(struct tm *timeinfo)
 
 void tcGPS::sendCommand(const char *prefix, const char *str)
 { 
+    if(_uart) {
+        #if defined(TC_GPS_UART) && (GPS_UART_TX_PIN >= 0)
+        if(prefix) _uart->print(prefix);
+        _uart->print(str);
+        _uart->print("\r\n");
+        _uart->flush();
+        #endif
+        return;
+    }
+    
     Wire.beginTransmission(_address);
     if(prefix) {
         for(int i = 0; i < strlen(prefix); i++) {
@@ -465,203 +479,286 @@ bool tcGPS::readAndParse(bool doDelay)
 {
     char   curr_char = 0;
     size_t i2clen = 0;
-    int    buff_max = 0;
-    int    buff_idx = 0;
     bool   haveParsedSome = false;
     unsigned long myNow = millis();
+    int64_t myNowUs = esp_timer_get_time();
+    int64_t lineUs = myNowUs - 1000000;
+    bool    sawFiller = false;
+
+    // The GPS queued the data some time after our previous
+    // read (max 1 sec ago); assume the middle as the time 
+    // a sentence started.
+    if(_lastReadUs > lineUs) lineUs = _lastReadUs;
+    _readTS = myNow;
+    _readTSUs = (lineUs + myNowUs) / 2;
+    _lastReadUs = myNowUs;
+
+    if(_uart) {
+        // Take what the UART driver has buffered
+        i2clen = _uart->available();
+        if(i2clen > GPS_MAX_I2C_LEN) i2clen = GPS_MAX_I2C_LEN;
+    } else {
+        // The receiver has no "bytes available" register; it
+        // sends LFs as filler when its buffer is empty. So we 
+        // estimate how much accumulated since the last read 
+        // from the configured output rate. If the last read 
+        // did not see filler, there was more: Read more now.
+        uint32_t len = (uint32_t)_bytesPerSec * (uint32_t)((myNowUs - lineUs) / 1000) / 1000;
+        len += GPS_READ_MARGIN;
+        if(!_drained) len += _readLen;
+        if(len < GPS_READ_MIN) len = GPS_READ_MIN;
+        if(len > GPS_READ_MAX) len = GPS_READ_MAX;
+        _readLen = len;
+        i2clen = Wire.requestFrom(_address, _readLen);
+    }
 
-    i2clen = Wire.requestFrom(_address, _lenArr[_lenIdx++]);
-    _lenIdx &= _lenLimit;
-
-    if(i2clen) {
-
-        // Read i2c data to _buffer
-        for(int i = 0; i < i2clen; i++) {
-            curr_char = Wire.read();
-            // Skip "empty data" (ie LF if not preceeded by CR)
-            if((curr_char != 0x0a) || (_last_char == 0x0d)) {
-                 _buffer[buff_max++] = curr_char;
+    // Feed data straight into the parser
+    for(int i = 0; i < i2clen; i++) {
+        curr_char = _uart ? _uart->read() : Wire.read();
+        // Skip "empty data" (ie LF if not preceeded by CR)
+        if((curr_char != 0x0a) || (_last_char == 0x0d)) {
+            if(parseNMEAChar(curr_char)) {
+                haveParsedSome = true;
             }
-            _last_char = curr_char;
+        } else {
+            sawFiller = true;
         }
+        _last_char = curr_char;
+    }
 
-        if(doDelay) (*_customDelayFunc)(1);
-
-    }  
-
-    // Form line(s) out of buffer data
+    _drained = _uart ? true : sawFiller;
 
-    buff_max--;
-    buff_idx = 0;
-    while(buff_idx <= buff_max) {
-      
-        if(!_lineidx) _currentTS = myNow;
-        
-        curr_char = _currentline[_lineidx++] = _buffer[buff_idx++];
+    if(i2clen && doDelay) (*_customDelayFunc)(1);
 
-        if(_lineidx >= GPS_MAXLINELEN) {
-            _lineidx = GPS_MAXLINELEN - 1;
-        }
+    return haveParsedSome;
+}
 
-        // Finish a line on LF
-        if(curr_char == 0x0a) {
+/*
+ * NMEA parser, fed one character at a time
+ *
+ * Only RMC, VTG and ZDA are evaluated; their fields are
+ * converted to integers as they come in, and committed 
+ * only after the checksum was found correct.
+ * Returns true when a sentence was completed.
+ */
+bool tcGPS::parseNMEAChar(char c)
+{
+    #if defined(TC_DBG_GPS) && defined(TC_DBG_PRINT_NMEA)
+    Serial.write(c);
+    #endif
 
-            // terminate current line
-            _currentline[_lineidx] = 0;
+    if(c == '$') {
+        _nState = 1;
+        _nSum = 0;
+        _nLen = 0;
+        _nType = 0;
+        _nField = 0;
+        _nVal = 0;
+        _nDigits = 0;
+        _nDec = -1;
+        _nC0 = 0;
+        _nValid = false;
+        _nSpd = -1;
+        _nTS = _readTS;
+        _nTSUs = _readTSUs;
+        return false;
+    }
 
-            // parse this line
-            parseNMEA(_currentline, _currentTS);
-            haveParsedSome = true;
-            
-            _lineidx = 0;
+    switch(_nState) {
+    case 1:
+        if(c == '*') {
+            parseNMEAField();
+            _nState = 2;
+            return false;
         }
-
-        // Continue loop and write remaining data into new line
-
+        if(c < ' ' || c > 0x7e || ++_nLen > GPS_MAXSENTLEN) {
+            _nState = 0;
+            return false;
+        }
+        _nSum ^= c;
+        if(c == ',') {
+            parseNMEAField();
+            _nField++;
+            _nVal = 0;
+            _nDigits = 0;
+            _nDec = -1;
+            _nC0 = 0;
+        } else {
+            if(!_nC0) _nC0 = c;
+            if(!_nField) {
+                // Sentence type is chars 3-5 of address field
+                if(_nLen >= 3 && _nLen <= 5) _nVal = (_nVal << 8) | c;
+            } else if(c >= '0' && c <= '9') {
+                if(_nDigits < 9) {
+                    _nVal = (_nVal * 10) + (c - '0');
+                    _nDigits++;
+                    if(_nDec >= 0) _nDec++;
+                }
+            } else if(c == '.') {
+                _nDec = 0;
+            }
+        }
+        // Stop parsing sentences we don't use
+        if(_nField && !_nType) {
+            _nState = 0;
+        }
+        return false;
+    case 2:
+        _nChk = parseHex(c) << 4;
+        _nState = 3;
+        return false;
+    case 3:
+        _nChk |= parseHex(c);
+        _nState = 0;
+        if(_nChk != _nSum || _nLen < 10) {
+            #ifdef TC_DBG
+            Serial.printf("parseNMEA: Bad NMEA (%c)\n", _nType ? _nType : '?');
+            #endif
+            return false;
+        }
+        commitNMEA();
+        return true;
     }
 
-    return haveParsedSome;
+    return false;
 }
 
-#if defined(TC_DBG_GPS) && defined(TC_DBG_PRINT_NMEA)
-unsigned long lastMillis = 0;
-#endif
-
-bool tcGPS::parseNMEA(char *nmea, unsigned long nmeaTS)
+/*
+ * Evaluate field just completed
+ */
+void tcGPS::parseNMEAField()
 {
-    char *t = nmea, *t2;
-    char *bufp = _sbuf;
-
-    if(!checkNMEA(nmea)) {
-        #ifdef TC_DBG
-        Serial.printf("parseNMEA: Bad NMEA %s", nmea);
-        #endif
-        return false;
+    uint32_t v = _nVal;
+    int d = _nDec;
+
+    if(!_nField) {
+        switch(v) {
+        case ('R' << 16) | ('M' << 8) | 'C':
+        case ('V' << 16) | ('T' << 8) | 'G':
+        case ('Z' << 16) | ('D' << 8) | 'A':
+            _nType = v >> 16;
+        }
+        return;
     }
 
-    #if defined(TC_DBG_GPS) && defined(TC_DBG_PRINT_NMEA)
-    Serial.printf("%d ", millis() - lastMillis);
-    lastMillis = millis();
-    Serial.print(nmea);
-    #endif
+    // Time (hhmmss.sss) for RMC and ZDA
+    if(_nField == 1 && _nType != 'V') {
+        uint32_t div = 1, frac;
+        if(d < 0) d = 0;
+        for(int i = 0; i < d; i++) div *= 10;
+        frac = v % div;
+        v /= div;
+        while(d < 3) { frac *= 10; d++; }
+        while(d > 3) { frac /= 10; d--; }
+        _nHour = v / 10000;
+        _nMin = (v / 100) % 100;
+        _nSec = v % 100;
+        _nFrac = frac;
+        return;
+    }
 
-    if(*(t+3) == 'R') {   // RMC
+    switch(_nType) {
+    case 'R':
+        switch(_nField) {
+        case 2:                       // Validity
+            _nValid = (_nC0 == 'A');
+            break;
+        case 7:                       // Speed (knots)
+            if(_nDigits) _nSpd = toKn100(v, d);
+            break;
+        case 9:                       // Date (ddmmyy)
+            _nDay = v / 10000;
+            _nMonth = (v / 100) % 100;
+            _nYear = (v % 100) + 2000;
+            break;
+        }
+        break;
+    case 'V':
+        switch(_nField) {
+        case 5:                       // Speed (knots)
+            if(_nDigits) _nSpd = toKn100(v, d);
+            break;
+        case 9:                       // Mode
+            _nValid = (_nC0 != 'N');
+            break;
+        }
+        break;
+    case 'Z':
+        switch(_nField) {
+        case 2: _nDay = v;   break;
+        case 3: _nMonth = v; break;
+        case 4: _nYear = v;  break;
+        }
+        break;
+    }
+}
 
-        t2 = t = gotoNext(t);   // Skip to time
-        t = gotoNext(t);        // Skip to validity
-        fix = (*t == 'A');
+// Convert number with d decimals into value * 100
+int32_t tcGPS::toKn100(uint32_t v, int d)
+{
+    if(d < 0) d = 0;
+    while(d < 2) { v *= 10; d++; }
+    while(d > 2) { v /= 10; d--; }
+    return (int32_t)v;
+}
 
-        if(!fix) return true;
-        
-        copy6chars(_curTime2, t2);
-        _curFrac2 = (*(t2+6) == '.') ? getFracs(t2+7) : 0;
-
-        t = gotoNext(t);        // Skip to lat
-        t = gotoNext(t);        // Skip to n/s
-        t = gotoNext(t);        // Skip to long
-        t = gotoNext(t);        // Skip to e/w
-        t2 = t = gotoNext(t);   // Skip to speed
-        *bufp = 0;
-        while(*t2 && *t2 != ',' && (bufp - 16 < _sbuf))
-            *bufp++ = *t2++;
-        *bufp = 0;
-        if(*_sbuf) {
+/*
+ * Take over data from validated sentence
+ */
+void tcGPS::commitNMEA()
+{
+    switch(_nType) {
+    case 'R':   // RMC
+        fix = _nValid;
+        if(!fix) return;
+
+        _curHour2 = _nHour;
+        _curMin2 = _nMin;
+        _curSec2 = _nSec;
+        _curFrac2 = _nFrac;
+
+        if(_nSpd >= 0) {
+            _spdKn100 = _nSpd;
             _haveSpeed = true;
-            _curspdTS = nmeaTS;
+            _curspdTS = _nTS;
         }
 
-        t = gotoNext(t);        // Skip to track made good
-        t = gotoNext(t);        // Skip to date
-        _curDay2   = AToI2(t);
-        _curMonth2 = AToI2(t+2);
-        _curYear2  = AToI2(t+4) + 2000;
-          
-        _curTS2 = nmeaTS;
+        _curDay2   = _nDay;
+        _curMonth2 = _nMonth;
+        _curYear2  = _nYear;
+
+        _curTS2 = _nTS;
+        _curTS2Us = _nTSUs;
         _haveDateTime2 = true;
+        break;
 
-    } else if(*(t+3) == 'V') {
-
-        t = gotoNext(t);        // Skip to Course
-        t = gotoNext(t);        // Skip to Reference
-        t = gotoNext(t);        // Skip to Course (2)
-        t = gotoNext(t);        // Skip to Reference (2)
-        t2 = t = gotoNext(t);   // Skip to speed (knots)
-        t = gotoNext(t);        // Skip to Unit
-        t = gotoNext(t);        // Skip to speed (kph)
-        t = gotoNext(t);        // Skip to Unit
-        t = gotoNext(t);        // Skip to Mode
-        fix = (*t != 'N');
-        
-        if(fix) {
-            *bufp = 0;
-            while(*t2 && *t2 != ',' && (bufp - 16 < _sbuf))
-                *bufp++ = *t2++;
-            *bufp = 0;
-            if(*_sbuf) {
-                _haveSpeed = true;
-                _curspdTS = nmeaTS;
-            }
+    case 'V':   // VTG
+        fix = _nValid;
+        if(fix && _nSpd >= 0) {
+            _spdKn100 = _nSpd;
+            _haveSpeed = true;
+            _curspdTS = _nTS;
         }
+        break;
 
-    } else {      // ZDA
-
+    case 'Z':   // ZDA
         // Only use ZDA if we have a fix, no point in reading back
         // the GPS' own RTC.
         if(fix) {
-            t = gotoNext(t);    // Skip to time
-            copy6chars(_curTime, t);
-            _curFrac = (*(t+6) == '.') ? getFracs(t+7) : 0;
-            t = gotoNext(t);    // Skip to day
-            _curDay = AToI2(t);
-            t = gotoNext(t);    // Skip to month
-            _curMonth = AToI2(t);
-            t = gotoNext(t);    // Skip to year
-            _curYear = AToI4(t);
+            _curHour = _nHour;
+            _curMin = _nMin;
+            _curSec = _nSec;
+            _curFrac = _nFrac;
+            _curDay = _nDay;
+            _curMonth = _nMonth;
+            _curYear = _nYear;
             
-            _curTS = nmeaTS;
+            _curTS = _nTS;
+            _curTSUs = _nTSUs;
             _haveDateTime = true;
         }
-
+        break;
     }
-
-    return true;
-}
-
-bool tcGPS::checkNMEA(char *nmea)
-{
-    uint16_t sum = 0;
-    char *p = nmea;
-
-    // check sentence type
-
-    if(*nmea != '$')
-        return false;
-
-    char *ast = nmea;
-    while(*ast)
-        ast++;
-
-    if(ast - nmea < 16)
-        return false;
-
-    if(mystrcmp3(nmea+3, "VTG") && mystrcmp3(nmea+3, "RMC") && mystrcmp3(nmea+3, "ZDA"))
-        return false;
-
-    // check checksum
-
-    while(*ast != '*' && ast > nmea)
-        ast--;
-
-    if(*ast != '*')
-        return false;
-
-    sum = parseHex(*(ast+1)) << 4;
-    sum += parseHex(*(ast+2));
-
-    for(char *p1 = p + 1; p1 < ast; p1++)
-        sum ^= *p1;
-
-    return (sum == 0);
 }
 
 #endif
@@ -55,7 +55,10 @@
 #define _tcGPS_H
 
 #define GPS_MAX_I2C_LEN   255
-#define GPS_MAXLINELEN    128
+#define GPS_MAXSENTLEN    100
+#define GPS_UART_RXBUF   1024
+
+class HardwareSerial;
 
 class tcGPS {
 
@@ -63,12 +66,13 @@ class tcGPS {
 
         tcGPS(uint8_t address);
         bool    begin(unsigned long powerupTime, int quickUpdates, int speedRate, void (*myDelay)(unsigned long));
+        uint8_t getAddress() { return _address; }
 
         void    loop(bool doDelay);
 
         int16_t getSpeed();
         bool    haveTime();
-        bool    getDateTime(struct tm *timeInfo, unsigned long *fixAge, unsigned long updInt);
+        bool    getDateTime(struct tm *timeInfo, int64_t *secStartUs);
         bool    setDateTime(struct tm *timeinfo);
         
         bool    fix = false;
@@ -79,43 +83,63 @@ class tcGPS {
 
         void    sendCommand(const char *, const char *);
 
-        bool    parseNMEA(char *nmea, unsigned long nmeaTS);
-        bool    checkNMEA(char *nmea);
+        bool    parseNMEAChar(char c);
+        void    parseNMEAField();
+        void    commitNMEA();
+        static int32_t toKn100(uint32_t v, int d);
 
         uint8_t _address;
+        HardwareSerial *_uart = NULL;   // Non-NULL: UART mode (TC_GPS_UART)
 
-        #define GPS_LENBUFLIMIT 0x03
-        uint8_t _lenArr[4] = { 64, 64, 64, 63 };
-        //#define GPS_LENBUFLIMIT 0x07
-        //uint8_t _lenArr[8] = { 32, 32, 32, 32, 32, 32, 32, 31 };
-        int     _lenIdx = 0;
-        int     _lenLimit = GPS_LENBUFLIMIT;
+        // i2c read sizing
+        uint16_t _bytesPerSec = 100;    // Expected NMEA output rate
+        uint8_t _readLen = 64;
+        bool    _drained = false;
 
-        char    _buffer[GPS_MAX_I2C_LEN];
         char    _last_char = 0;
 
-        char    _line1[GPS_MAXLINELEN];
-        char    *_currentline;
-        uint8_t _lineidx = 0;
-        unsigned long _currentTS = 0;
+        unsigned long _readTS = 0;
+        int64_t _readTSUs = 0;
+        int64_t _lastReadUs = 0;
+
+        // NMEA parser state
+        uint8_t  _nState = 0;
+        uint8_t  _nSum, _nChk;
+        uint8_t  _nLen;
+        char     _nType;
+        uint8_t  _nField;
+        uint32_t _nVal;
+        int8_t   _nDigits, _nDec;
+        char     _nC0;
+        // Values of sentence being parsed
+        bool     _nValid;
+        int32_t  _nSpd;
+        uint8_t  _nHour, _nMin, _nSec;
+        uint16_t _nFrac;
+        uint8_t  _nDay, _nMonth;
+        uint16_t _nYear;
+        unsigned long _nTS;
+        int64_t  _nTSUs;
 
         int     _speed = -1;
         bool    _haveSpeed = false;
         unsigned long _curspdTS = 0;
-        char     _sbuf[16];
+        int32_t  _spdKn100 = 0;
 
-        char    _curTime[8]   = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        uint8_t  _curHour = 0, _curMin = 0, _curSec = 0;
         unsigned long _curFrac;
         uint8_t  _curDay;
         uint8_t  _curMonth;
         uint16_t _curYear;
-        char    _curTime2[8]  = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        uint8_t  _curHour2 = 0, _curMin2 = 0, _curSec2 = 0;
         unsigned long _curFrac2;
         uint8_t  _curDay2;
         uint8_t  _curMonth2;
         uint16_t _curYear2;
         unsigned long _curTS = 0;
         unsigned long _curTS2 = 0;
+        int64_t _curTSUs = 0;
+        int64_t _curTS2Us = 0;
         bool    _haveDateTime = false;
         bool    _haveDateTime2 = false;
 
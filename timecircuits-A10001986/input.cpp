@@ -154,7 +154,9 @@ Keypad_I2C::Keypad_I2C(char *userKeymap, const uint8_t *row, const uint8_t *col,
 }
 
 // Initialize I2C
-void Keypad_I2C::begin(unsigned int scanInterval, unsigned int holdTime, void (*myDelay)(unsigned long))
+// If intPin is given (>= 0), the PCF8574's INT output is connected
+// to this GPIO, and scanning only happens after a change.
+void Keypad_I2C::begin(unsigned int scanInterval, unsigned int holdTime, void (*myDelay)(unsigned long), int intPin)
 {
     _scanInterval = scanInterval;
     _holdTime = holdTime;
@@ -171,8 +173,19 @@ void Keypad_I2C::begin(unsigned int scanInterval, unsigned int holdTime, void (*
     for(int i = 0; i < _rows; i++) {
         _rowMask |= (1 << _rowPins[i]);
     }
+    _colMask = 0;
+    for(int i = 0; i < _columns; i++) {
+        _colMask |= (1 << _columnPins[i]);
+    }
 
     _customDelayFunc = myDelay;
+
+    if(intPin >= 0) {
+        _intPin = intPin;
+        pinMode(_intPin, INPUT);
+        attachInterruptArg(_intPin, intISR, this, FALLING);
+        intArm(true);
+    }
 }
 
 void Keypad_I2C::addEventListener(void (*listener)(char, KeyState))
@@ -185,11 +198,25 @@ bool Keypad_I2C::scanKeypad()
 {
     bool keyChanged = false;
 
+    // With INT: While idle, only scan after a change was
+    // reported, and after the contacts had _scanInterval
+    // ms to settle (debounce)
+    if(_armed) {
+        if(!_intFlag || (millis() - _intTime) <= _scanInterval)
+            return false;
+        _intFlag = false;
+        intArm(false);
+    }
+
     if((millis() - _scanTime) > _scanInterval) {
         keyChanged = scanKeys();
         _scanTime = millis();
     }
 
+    if(_intPin >= 0 && _key.kState == TCKS_IDLE) {
+        intArm(true);
+    }
+
     return keyChanged;
 }
 
@@ -335,6 +362,35 @@ void Keypad_I2C::port_write(uint8_t val)
     _pinState = val;
 }
 
+// Arm: Drive all columns low, so that any key press pulls its 
+// row low and the PCF8574 signals a change on INT.
+// Disarm: Columns back high, as required by scanKeys().
+void Keypad_I2C::intArm(bool arm)
+{
+    if(arm) {
+        port_write(_pinState & ~_colMask);
+        // Read port to clear INT; if a key is already 
+        // down, we'd miss its edge, so flag it here
+        _intFlag = false;
+        _wire->requestFrom(_i2caddr, (int)1);
+        if((_wire->read() & _rowMask) != _rowMask) {
+            _intTime = millis();
+            _intFlag = true;
+        }
+    } else {
+        port_write(_pinState | _colMask);
+    }
+    _armed = arm;
+}
+
+void IRAM_ATTR Keypad_I2C::intISR(void *arg)
+{
+    Keypad_I2C *_this = (Keypad_I2C *)arg;
+
+    _this->_intTime = millis();
+    _this->_intFlag = true;
+}
+
 
 
 /*
@@ -475,6 +531,15 @@ void TCButton::transitionTo(ButtonState nextState)
 
 #define HWUPD_DELAY_VOL 150 // ms between hw polls for volume
 
+// Poll rate adapts to activity: While the knob is turned, we poll
+// at half the above interval; after RE_IDLE_AFTER ms without 
+// movement, we back off to RE_IDLE_POLL.
+#define RE_IDLE_AFTER  1000
+#define RE_IDLE_POLL   300
+// For encoders with a status register, the position is read only
+// if the status reports a change, or after RE_FULLREAD_INT ms.
+#define RE_FULLREAD_INT 2000
+
 // Ada4991
 
 #define SEESAW_STATUS_BASE  0x00
@@ -502,6 +567,7 @@ void TCButton::transitionTo(ButtonState nextState)
 
 #define DUV2_BASE     0x100
 #define DUV2_CONF     0x00
+#define DUV2_ESTATUS  0x05
 #define DUV2_CONF2    0x30
 #define DUV2_CVALB4   0x08
 #define DUV2_CMAXB4   0x0c
@@ -526,6 +592,12 @@ enum DUV2_CONF_PARAM {
     DU2_EEPROM_BANK2 = 0x00,
     DU2_RESET        = 0x80
 };
+enum DUV2_ESTATUS_PARAM {
+    DU2_RINC = 0x08,
+    DU2_RDEC = 0x10,
+    DU2_RMAX = 0x20,
+    DU2_RMIN = 0x40
+};
 enum DUV2_CONF2_PARAM {
     DU2_CLK_STRECH_ENABLE  = 0x01,
     DU2_CLK_STRECH_DISABLE = 0x00,
@@ -721,7 +793,7 @@ void TCRotEnc::speedPos(int16_t speed)
 
 int16_t TCRotEnc::updateFakeSpeed(bool force)
 {
-    bool timeout = (millis() - lastUpd > HWUPD_DELAY);
+    bool timeout = (millis() - lastUpd > pollIntv(HWUPD_DELAY));
     int32_t updRotPos;
     
     if(force || timeout || (fakeSpeed != targetSpeed)) {
@@ -730,7 +802,8 @@ int16_t TCRotEnc::updateFakeSpeed(bool force)
             lastUpd = millis();
             
             int32_t t = rotEncPos;
-            rotEncPos = updRotPos = getEncPos();
+            rotEncPos = updRotPos = readEncPos(force);
+            if(rotEncPos != t) lastMove = lastUpd;
 
             //Serial.printf("Rot pos %x\n", rotEncPos);
 
@@ -781,12 +854,13 @@ int TCRotEnc::updateVolume(int curVol, bool force)
     if(curVol == 255)
         return curVol;
     
-    if(force || (millis() - lastUpd > HWUPD_DELAY_VOL)) {
+    if(force || (millis() - lastUpd > pollIntv(HWUPD_DELAY_VOL))) {
 
         lastUpd = millis();
         
         int32_t t = rotEncPos;
-        rotEncPos = getEncPos();
+        rotEncPos = readEncPos(force);
+        if(rotEncPos != t) lastMove = lastUpd;
 
         curVol += (rotEncPos - t);
 
@@ -797,6 +871,38 @@ int TCRotEnc::updateVolume(int curVol, bool force)
     return curVol;
 }
 
+// Current poll interval: Faster while turned, slow when idle
+unsigned long TCRotEnc::pollIntv(unsigned long normal)
+{
+    unsigned long sinceMove = millis() - lastMove;
+
+    if(sinceMove < normal * 2) return normal / 2;
+    if(sinceMove > RE_IDLE_AFTER) return RE_IDLE_POLL;
+    return normal;
+}
+
+// Read position, unless the status register tells us 
+// there was no movement since the last read
+int32_t TCRotEnc::readEncPos(bool force)
+{
+    uint8_t buf[1];
+
+    if(!force && (millis() - lastFullRead < RE_FULLREAD_INT)) {
+        switch(_st) {
+        case TC_RE_TYPE_DUPPAV2:
+            // Reading ESTATUS clears it
+            if(read(DUV2_BASE, DUV2_ESTATUS, buf, 1) == 1) {
+                if(!(buf[0] & (DU2_RINC|DU2_RDEC|DU2_RMAX|DU2_RMIN)))
+                    return rotEncPos;
+            }
+            break;
+        }
+    }
+
+    lastFullRead = millis();
+    return getEncPos();
+}
+
 int32_t TCRotEnc::getEncPos()
 {
     uint8_t buf[4];
@@ -134,12 +134,15 @@ class Keypad_I2C {
                    uint8_t numRows, uint8_t numCols,
                    int address, TwoWire *awire = &Wire);
 
-        void begin(unsigned int scanInterval, unsigned int holdTime, void (*myDelay)(unsigned long));
+        void begin(unsigned int scanInterval, unsigned int holdTime, void (*myDelay)(unsigned long), int intPin = -1);
 
         void addEventListener(void (*listener)(char, KeyState));
 
         bool scanKeypad();
 
+        bool          isKeyActive() { return (_key.kState != TCKS_IDLE); }
+        unsigned long nextScan() { return _scanTime + _scanInterval + 1; }
+
     private:
 
         bool scanKeys();
@@ -151,6 +154,9 @@ class Keypad_I2C {
         void pin_write(uint8_t pinNum, bool level);
         void port_write(uint8_t i2cportval);
 
+        void intArm(bool arm);
+        static void intISR(void *arg);
+
         unsigned int  _scanInterval;
         unsigned int  _holdTime;
         const uint8_t *_rowPins;
@@ -162,6 +168,12 @@ class Keypad_I2C {
 
         unsigned long _scanTime = 0;        
         uint16_t      _rowMask;
+        uint16_t      _colMask;
+
+        int           _intPin = -1;
+        volatile bool _intFlag = false;
+        volatile unsigned long _intTime = 0;
+        bool          _armed = false;
 
         uint8_t       _pinState;  // shadow for output pins
 
@@ -246,6 +258,8 @@ class TCRotEnc {
 
     private:
         int32_t getEncPos();
+        int32_t readEncPos(bool force);
+        unsigned long pollIntv(unsigned long normal);
         int     read(uint16_t base, uint8_t reg, uint8_t *buf, uint8_t num);
         void    write(uint16_t base, uint8_t reg, uint8_t *buf, uint8_t num);
 
@@ -266,6 +280,8 @@ class TCRotEnc {
         int32_t       rotEncPos = 0;
         unsigned long lastUpd = 0;
         unsigned long lastFUpd = 0;
+        unsigned long lastMove = 0;
+        unsigned long lastFullRead = 0;
 
         int           dfrgain;
         int           dfroffslots;
@@ -407,6 +407,12 @@ bool PubSubClient::loop()
                   
                     pingOutstanding = false;
                     
+                } else if(type == MQTTPUBACK) {
+
+                    if(pubAckCB && len >= 4) {
+                        pubAckCB((this->buffer[llen+1] << 8) | this->buffer[llen+2]);
+                    }
+                    
                 }
 
             } else if(!connected()) {
@@ -452,6 +458,51 @@ bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned i
     return false;
 }
 
+// QoS 1 publish; the caller keeps the message until 
+// the PUBACK callback reports msgId, and re-sends it 
+// with dup set if none arrives
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, bool retained, uint16_t msgId, bool dup)
+{
+    if(connected()) {
+        if (this->bufferSize < MQTT_MAX_HEADER_SIZE + 2+strnlen(topic, this->bufferSize) + 2 + plength) {
+            // Too long
+            return false;
+        }
+        
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        length = writeString(topic, this->buffer, length);
+
+        this->buffer[length++] = msgId >> 8;
+        this->buffer[length++] = msgId & 0xff;
+
+        uint16_t i;
+        for(i = 0; i < plength; i++) {
+            this->buffer[length++] = payload[i];
+        }
+
+        uint8_t header = MQTTPUBLISH | MQTTQOS1;
+        
+        if(retained) header |= 1;
+        if(dup)      header |= 8;
+        
+        return write(header, this->buffer, length - MQTT_MAX_HEADER_SIZE);
+    }
+    
+    return false;
+}
+
+uint16_t PubSubClient::newMsgId()
+{
+    if(++nextMsgId == 0) nextMsgId = 1;
+    
+    return nextMsgId;
+}
+
+void PubSubClient::setPubAckCallback(void (*pubAckCB)(uint16_t))
+{
+    this->pubAckCB = pubAckCB;
+}
+
 size_t PubSubClient::buildHeader(uint8_t header, uint8_t *buf, uint16_t length)
 {
     uint8_t lenBuf[4];
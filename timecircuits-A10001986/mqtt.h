@@ -146,6 +146,9 @@ class PubSubClient {
         void disconnect();
 
         bool publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained = false);
+        bool publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained, uint16_t msgId, bool dup);
+        uint16_t newMsgId();
+        void setPubAckCallback(void (*pubAckCB)(uint16_t));
              
         bool subscribe(const char *topic, const char *topic2 = NULL, uint8_t qos = 0);
         bool unsubscribe(const char *topic);
@@ -185,6 +188,7 @@ class PubSubClient {
         bool pingOutstanding;
         void (*callback)(char *, uint8_t *, unsigned int);
         void (*looper)();
+        void (*pubAckCB)(uint16_t) = NULL;
 
         IPAddress ip;
         const char* domain;
@@ -112,8 +112,8 @@ bool tcRTC::begin(unsigned long powerupTime)
     for(int i = 0; i < _numTypes * 2; i += 2) {
 
         // Check for RTC on i2c bus
-        Wire.beginTransmission(_addrArr[i]);
-        if(!(Wire.endTransmission(true))) {
+        TC_FASTWIRE.beginTransmission(_addrArr[i]);
+        if(!(TC_FASTWIRE.endTransmission(true))) {
 
             _address = _addrArr[i];
             _rtcType = _addrArr[i+1];
@@ -143,6 +143,8 @@ void tcRTC::adjust(byte second, byte minute, byte hour, byte dayOfWeek, byte day
     uint8_t buffer[8];
     uint8_t statreg;
 
+    _adjustCount++;
+
     buffer[1] = bin2bcd(second);
     buffer[2] = bin2bcd(minute);
     buffer[3] = bin2bcd(hour);
@@ -364,20 +366,20 @@ uint8_t tcRTC::read_register(uint8_t reg)
 
 void tcRTC::write_bytes(uint8_t *buffer, uint8_t num)
 {
-    Wire.beginTransmission(_address);
+    TC_FASTWIRE.beginTransmission(_address);
     for(int i = 0; i < num; i++) {
-        Wire.write(buffer[i]);
+        TC_FASTWIRE.write(buffer[i]);
     }
-    Wire.endTransmission();   
+    TC_FASTWIRE.endTransmission();   
 }
 
 void tcRTC::read_bytes(uint8_t reg, uint8_t *buffer, uint8_t num)
 {
-    Wire.beginTransmission(_address);
-    Wire.write(reg);
-    Wire.endTransmission();
-    Wire.requestFrom(_address, num);
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write(reg);
+    TC_FASTWIRE.endTransmission();
+    TC_FASTWIRE.requestFrom(_address, num);
     for(int i = 0; i < num; i++) {
-        buffer[i] = Wire.read();
+        buffer[i] = TC_FASTWIRE.read();
     }
 }
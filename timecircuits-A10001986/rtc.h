@@ -130,6 +130,7 @@ class tcRTC
         tcRTC(int numTypes, uint8_t addrArr[]);
 
         bool begin(unsigned long powerupTime);
+        uint8_t getAddress() { return _address; }
 
         void adjust(byte second, byte minute, byte hour, byte dayOfWeek, byte dayOfMonth, byte month, byte year);
 
@@ -145,7 +146,10 @@ class tcRTC
         bool lostPower(void);
         bool battLow(void);
 
+        uint32_t adjustCount() { return _adjustCount; }
+
         float getTemperature();
+        bool  haveTemperature() { return (_rtcType == RTCT_DS3231); }
 
     private:
 
@@ -162,6 +166,8 @@ class tcRTC
         uint8_t _addrArr[2*2];
         uint8_t _address;
         uint8_t _rtcType = RTCT_DS3231;
+
+        uint32_t _adjustCount = 0;
 };
 
 #endif
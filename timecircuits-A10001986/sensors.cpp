@@ -106,9 +106,9 @@ static uint8_t crc8(uint8_t initVal, uint8_t poly, uint8_t len, uint8_t *buf)
 
 void tcSensor::prepareRead(uint16_t regno)
 {
-    Wire.beginTransmission(_address);
-    Wire.write((uint8_t)(regno));
-    Wire.endTransmission(false);
+    TC_FASTWIRE.beginTransmission(_address);
+    TC_FASTWIRE.write((uint8_t)(regno));
+    TC_FASTWIRE.endTransmission(false);
 }
 
 uint16_t tcSensor::read16(uint16_t regno, bool LSBfirst)
@@ -120,11 +120,11 @@ uint16_t tcSensor::read16(uint16_t regno, bool LSBfirst)
         prepareRead(regno);
     }
 
-    i2clen = Wire.requestFrom(_address, (uint8_t)2);
+    i2clen = TC_FASTWIRE.requestFrom(_address, (uint8_t)2);
 
     if(i2clen > 0) {
-        value = (Wire.read() << 8);
-        value |= Wire.read();
+        value = (TC_FASTWIRE.read() << 8);
+        value |= TC_FASTWIRE.read();
     }
     
     if(LSBfirst) {
@@ -140,13 +140,13 @@ void tcSensor::read16x2(uint16_t regno, uint16_t& t1, uint16_t& t2)
 
     prepareRead(regno);
 
-    i2clen = Wire.requestFrom(_address, (uint8_t)4);
+    i2clen = TC_FASTWIRE.requestFrom(_address, (uint8_t)4);
 
     if(i2clen > 0) {
-        t1 = Wire.read();
-        t1 |= (Wire.read() << 8);
-        t2 = Wire.read();
-        t2 |= (Wire.read() << 8);
+        t1 = TC_FASTWIRE.read();
+        t1 |= (TC_FASTWIRE.read() << 8);
+        t2 = TC_FASTWIRE.read();
+        t2 |= (TC_FASTWIRE.read() << 8);
     } else {
         t1 = t2 = 0;
     }
@@ -158,35 +158,35 @@ uint8_t tcSensor::read8(uint16_t regno)
 
     prepareRead(regno);
 
-    Wire.requestFrom(_address, (uint8_t)1);
+    TC_FASTWIRE.requestFrom(_address, (uint8_t)1);
 
-    value = Wire.read();
+    value = TC_FASTWIRE.read();
 
     return value;
 }
 
 void tcSensor::write16(uint16_t regno, uint16_t value, bool LSBfirst)
 {
-    Wire.beginTransmission(_address);
+    TC_FASTWIRE.beginTransmission(_address);
     if(regno <= 0xff) {
-        Wire.write((uint8_t)(regno));
+        TC_FASTWIRE.write((uint8_t)(regno));
     }
     if(LSBfirst) {
         value = (value >> 8) | (value << 8);
     } 
-    Wire.write((uint8_t)(value >> 8));
-    Wire.write((uint8_t)(value & 0xff));
-    Wire.endTransmission();
+    TC_FASTWIRE.write((uint8_t)(value >> 8));
+    TC_FASTWIRE.write((uint8_t)(value & 0xff));
+    TC_FASTWIRE.endTransmission();
 }
 
 void tcSensor::write8(uint16_t regno, uint8_t value)
 {
-    Wire.beginTransmission(_address);
+    TC_FASTWIRE.beginTransmission(_address);
     if(regno <= 0xff) {
-        Wire.write((uint8_t)(regno));
+        TC_FASTWIRE.write((uint8_t)(regno));
     }
-    Wire.write((uint8_t)(value & 0xff));
-    Wire.endTransmission();
+    TC_FASTWIRE.write((uint8_t)(value & 0xff));
+    TC_FASTWIRE.endTransmission();
 }
 
 #endif
@@ -340,8 +340,8 @@ bool tempSensor::begin(unsigned long powerupTime, void (*myDelay)(unsigned long)
 
         _address = _addrArr[i];
 
-        Wire.beginTransmission(_address);
-        if(!Wire.endTransmission(true)) {
+        TC_FASTWIRE.beginTransmission(_address);
+        if(!TC_FASTWIRE.endTransmission(true)) {
         
             switch(_addrArr[i+1]) {
             case MCP9808:
@@ -361,16 +361,16 @@ bool tempSensor::begin(unsigned long powerupTime, void (*myDelay)(unsigned long)
                 // Do a test-measurement for id
                 write8(SHT40_DUMMY, SHT40_CMD_RTEMPL);
                 (*_customDelayFunc)(5);
-                if(Wire.requestFrom(_address, (uint8_t)6) == 6) {
-                    for(uint8_t i = 0; i < 6; i++) buf[i] = Wire.read();
+                if(TC_FASTWIRE.requestFrom(_address, (uint8_t)6) == 6) {
+                    for(uint8_t i = 0; i < 6; i++) buf[i] = TC_FASTWIRE.read();
                     if(crc8(SHT40_CRC_INIT, SHT40_CRC_POLY, 2, buf) == buf[2]) {
                         foundSt = true;
                     }
                 }
                 break;
             case MS8607:
-                Wire.beginTransmission(MS8607_ADDR_RH);
-                if(!Wire.endTransmission(true)) {
+                TC_FASTWIRE.beginTransmission(MS8607_ADDR_RH);
+                if(!TC_FASTWIRE.endTransmission(true)) {
                     foundSt = true;
                 }
                 break;
@@ -389,9 +389,9 @@ bool tempSensor::begin(unsigned long powerupTime, void (*myDelay)(unsigned long)
                 break;
             case HDC302X:
                 write16(HDC302x_DUMMY, HDC302x_READID);
-                if(Wire.requestFrom(_address, (uint8_t)3) == 3) {
-                    t16 = Wire.read() << 8;
-                    t16 |= Wire.read();
+                if(TC_FASTWIRE.requestFrom(_address, (uint8_t)3) == 3) {
+                    t16 = TC_FASTWIRE.read() << 8;
+                    t16 |= TC_FASTWIRE.read();
                     if(t16 == 0x3000) {
                         foundSt = true;
                     }
@@ -588,18 +588,61 @@ bool tempSensor::begin(unsigned long powerupTime, void (*myDelay)(unsigned long)
     return true;
 }
 
-// Read temperature
+// Trigger a new conversion (for sensors that need one)
+void tempSensor::startConversion()
+{
+    switch(_st) {
+    case SHT40:
+        write8(SHT40_DUMMY, SHT40_CMD_RTEMPM);
+        break;
+    case SI7021:
+        write8(SI7021_DUMMY, SI7021_CMD_RHUM);
+        break;
+    case AHT20:
+        write16(0xac, 0x3300);
+        break;
+    case HTU31:
+        write8(HTU31_DUMMY, HTU31_CONV);
+        break;
+    case MS8607:
+        _address = MS8607_ADDR_T;
+        write8(MS8607_DUMMY, 0x54);
+        _address = MS8607_ADDR_RH;
+        write8(MS8607_DUMMY, 0xf5);
+        break;
+    case HDC302X:
+        write16(HDC302x_DUMMY, HDC302x_TRIGGER);
+        break;
+    }
+
+    _tempReadNow = millis();
+}
+
+// Check if the conversion started last is complete
+bool tempSensor::poll()
+{
+    return (millis() - _tempReadNow >= _delayNeeded);
+}
+
+// Read temperature, wait for conversion if necessary
 float tempSensor::readTemp(bool celsius)
 {
-    float temp = NAN;
-    uint16_t t = 0, h = 0;
-    uint8_t buf[8];
-    
     if(_delayNeeded > 0) {
         unsigned long elapsed = millis() - _tempReadNow;
         if(elapsed < _delayNeeded) (*_customDelayFunc)(_delayNeeded - elapsed);
     }
 
+    return collect(celsius);
+}
+
+// Read temperature from finished conversion, and trigger 
+// a new one. Does not wait; caller needs to check poll().
+float tempSensor::collect(bool celsius)
+{
+    float temp = NAN;
+    uint16_t t = 0, h = 0;
+    uint8_t buf[8];
+
     switch(_st) {
 
     case MCP9808:
@@ -613,10 +656,10 @@ float tempSensor::readTemp(bool celsius)
     case BMx280:
         write8(BMx280_DUMMY, BMx280_REG_TEMP);
         t = _haveHum ? 5 : 3;
-        if(Wire.requestFrom(_address, (uint8_t)t) == t) {
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)t) == t) {
             uint32_t t1; 
             uint16_t t2 = 0;
-            for(uint8_t i = 0; i < t; i++) buf[i] = Wire.read();
+            for(uint8_t i = 0; i < t; i++) buf[i] = TC_FASTWIRE.read();
             t1 = (buf[0] << 16) | (buf[1] << 8) | buf[2];
             if(_haveHum) t2 = (buf[3] << 8) | buf[4];
             temp = BMx280_CalcTemp(t1, t2);
@@ -629,12 +672,11 @@ float tempSensor::readTemp(bool celsius)
             _hum = (int8_t)(((125.0 * (float)h) / 65535.0) - 6.0);
            if(_hum < 0) _hum = 0;
         }
-        write8(SHT40_DUMMY, SHT40_CMD_RTEMPM);    // Trigger new measurement
         break;
 
     case SI7021:
-        if(Wire.requestFrom(_address, (uint8_t)3) == 3) {
-            for(uint8_t i = 0; i < 3; i++) buf[i] = Wire.read();
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)3) == 3) {
+            for(uint8_t i = 0; i < 3; i++) buf[i] = TC_FASTWIRE.read();
             if(crc8(SI7021_CRC_INIT, SI7021_CRC_POLY, 2, buf) == buf[2]) {
                 t = (buf[0] << 8) | buf[1];
                 _hum = (int8_t)(((125.0 * (float)t) / 65536.0) - 6.0);
@@ -642,12 +684,11 @@ float tempSensor::readTemp(bool celsius)
             }
         }
         write8(SI7021_DUMMY, SI7021_CMD_RTEMPQ);
-        if(Wire.requestFrom(_address, (uint8_t)2) == 2) {
-            for(uint8_t i = 0; i < 2; i++) buf[i] = Wire.read();
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)2) == 2) {
+            for(uint8_t i = 0; i < 2; i++) buf[i] = TC_FASTWIRE.read();
             t = (buf[0] << 8) | buf[1];
             temp = ((175.72 * (float)t) / 65536.0) - 46.85;
         }
-        write8(SI7021_DUMMY, SI7021_CMD_RHUM);    // Trigger new measurement
         break;
 
     case TMP117:
@@ -658,14 +699,13 @@ float tempSensor::readTemp(bool celsius)
         break;
 
     case AHT20:
-        if(Wire.requestFrom(_address, (uint8_t)7) == 7) {
-            for(uint8_t i = 0; i < 7; i++) buf[i] = Wire.read();
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)7) == 7) {
+            for(uint8_t i = 0; i < 7; i++) buf[i] = TC_FASTWIRE.read();
             if(crc8(AHT20_CRC_INIT, AHT20_CRC_POLY, 6, buf) == buf[6]) {
                 _hum = ((uint32_t)((buf[1] << 12) | (buf[2] << 4) | (buf[3] >> 4))) * 100 >> 20; // / 1048576;
                 temp = ((float)((uint32_t)(((buf[3] & 0x0f) << 16) | (buf[4] << 8) | buf[5]))) * 200.0 / 1048576.0 - 50.0;
             }
         }
-        write16(0xac, 0x3300);    // Trigger new measurement
         break;
 
     case HTU31:
@@ -675,34 +715,29 @@ float tempSensor::readTemp(bool celsius)
             _hum = (int8_t)((100.0 * (float)h) / 65535.0);
             if(_hum < 0) _hum = 0;
         }
-        write8(HTU31_DUMMY, HTU31_CONV);  // Trigger new conversion
         break;
 
     case MS8607:
         _address = MS8607_ADDR_T;
         write8(MS8607_DUMMY, 0x00);
-        if(Wire.requestFrom(_address, (uint8_t)3) == 3) {
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)3) == 3) {
             int32_t dT = 0;
-            for(uint8_t i = 0; i < 3; i++) { dT<<=8; dT |= Wire.read(); }
+            for(uint8_t i = 0; i < 3; i++) { dT<<=8; dT |= TC_FASTWIRE.read(); }
             dT -= _MS8607_C5;
             temp = (2000.0F + ((float)dT * _MS8607_FA)) / 100.0F;
         }
-        // Trigger new conversion t
-        write8(MS8607_DUMMY, 0x54);
         _address = MS8607_ADDR_RH;
-        if(Wire.requestFrom(_address, (uint8_t)3) == 3) {
-            t = Wire.read() << 8; 
-            t |= Wire.read();
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)3) == 3) {
+            t = TC_FASTWIRE.read() << 8; 
+            t |= TC_FASTWIRE.read();
             t &= ~0x03;
-            Wire.read();
+            TC_FASTWIRE.read();
             _hum = (int8_t)(((((float)t * (12500.0 / 65536.0))) - 600.0F) / 100.0F);
             //if(temp > 0.0F && temp <= 85.0F) {
             //    _hum += ((int8_t)((float)(20.0F - temp) * -0.18F));   // rh compensated; not worth the computing time
             //}
             if(_hum < 0) _hum = 0;
         }
-        // Trigger new conversion rH
-        write8(MS8607_DUMMY, 0xf5);
         break;
 
     case HDC302X:
@@ -711,11 +746,11 @@ float tempSensor::readTemp(bool celsius)
             _hum = (int8_t)((100.0 * (float)h) / 65535.0);
             if(_hum < 0) _hum = 0;
         }
-        write16(HDC302x_DUMMY, HDC302x_TRIGGER);  // Trigger new conversion
         break;
     }
 
-    _tempReadNow = millis();
+    // Trigger new conversion
+    startConversion();
 
     if(!isnan(temp)) {
         if(!celsius) temp = temp * 9.0 / 5.0 + 32.0;
@@ -782,8 +817,8 @@ void tempSensor::HDC302x_setDefault(uint16_t reg, uint8_t val1, uint8_t val2)
     
     write16(HDC302x_DUMMY, reg);
     (*_customDelayFunc)(5);
-    if(Wire.requestFrom(_address, (uint8_t)3) == 3) {
-        for(uint8_t i = 0; i < 3; i++) buf[i] = Wire.read();
+    if(TC_FASTWIRE.requestFrom(_address, (uint8_t)3) == 3) {
+        for(uint8_t i = 0; i < 3; i++) buf[i] = TC_FASTWIRE.read();
         if(crc8(HDC302x_CRC_INIT, HDC302x_CRC_POLY, 2, buf) == buf[2]) {
             #ifdef TC_DBG
             Serial.printf("HDC302x: Read 0x%x\n", reg);
@@ -795,11 +830,11 @@ void tempSensor::HDC302x_setDefault(uint16_t reg, uint8_t val1, uint8_t val2)
                 buf[0] = reg >> 8; buf[1] = reg & 0xff;
                 buf[2] = val1; buf[3] = val2;
                 buf[4] = crc8(HDC302x_CRC_INIT, HDC302x_CRC_POLY, 2, &buf[2]);
-                Wire.beginTransmission(_address);
+                TC_FASTWIRE.beginTransmission(_address);
                 for(int i=0; i < 5; i++) {
-                    Wire.write(buf[i]);
+                    TC_FASTWIRE.write(buf[i]);
                 }
-                Wire.endTransmission();
+                TC_FASTWIRE.endTransmission();
                 (*_customDelayFunc)(80);
             } else {
                 #ifdef TC_DBG
@@ -820,8 +855,8 @@ void tempSensor::HDC302x_setDefault(uint16_t reg, uint8_t val1, uint8_t val2)
 
 bool tempSensor::readAndCheck6(uint8_t *buf, uint16_t& t, uint16_t& h, uint8_t crcinit, uint8_t crcpoly)
 {
-    if(Wire.requestFrom(_address, (uint8_t)6) == 6) {
-        for(int i = 0; i < 6; i++) buf[i] = Wire.read();
+    if(TC_FASTWIRE.requestFrom(_address, (uint8_t)6) == 6) {
+        for(int i = 0; i < 6; i++) buf[i] = TC_FASTWIRE.read();
         if(crc8(crcinit, crcpoly, 2, buf) == buf[2]) {
             t = (buf[0] << 8) | buf[1];
             if(crc8(crcinit, crcpoly, 2, buf+3) == buf[5]) {
@@ -1009,8 +1044,8 @@ bool lightSensor::begin(bool skipLast, unsigned long powerupTime, void (*myDelay
 
         _address = _addrArr[i];
 
-        Wire.beginTransmission(_address);
-        if(!Wire.endTransmission(true)) {
+        TC_FASTWIRE.beginTransmission(_address);
+        if(!TC_FASTWIRE.endTransmission(true)) {
 
             switch(_addrArr[i+1]) {
             case LST_LTR3xx:
@@ -1152,11 +1187,11 @@ void lightSensor::loop()
             return;
 
         write8(LTR303_DUMMY, LTR303_DATA1);
-        if(Wire.requestFrom(_address, (uint8_t)4) == 4) {
-            temp1 = Wire.read();
-            temp1 |= (Wire.read() << 8);
-            temp  = Wire.read();
-            temp  |= (Wire.read() << 8);
+        if(TC_FASTWIRE.requestFrom(_address, (uint8_t)4) == 4) {
+            temp1 = TC_FASTWIRE.read();
+            temp1 |= (TC_FASTWIRE.read() << 8);
+            temp  = TC_FASTWIRE.read();
+            temp  |= (TC_FASTWIRE.read() << 8);
             if(temp + temp1 == 0) {
                 _lux = 0;
             } else {
@@ -1240,6 +1275,57 @@ void lightSensor::loop()
     }
 
     _lastAccess = millis();
+
+    evalThreshold();
+}
+
+/*
+ * Threshold crossing (for night mode)
+ * "Dark" is lux <= limit; it takes lux > limit + hyst to become
+ * "bright" again. A new state must persist for dwell ms before 
+ * it is taken over and reported through thresholdEvent().
+ */
+void lightSensor::setThreshold(int32_t limit, int32_t hyst, unsigned long dwell)
+{
+    _thrLimit = limit;
+    _thrHyst = hyst;
+    _thrDwell = dwell;
+}
+
+bool lightSensor::thresholdEvent()
+{
+    bool ret = _thrEvent;
+    _thrEvent = false;
+    return ret;
+}
+
+void lightSensor::evalThreshold()
+{
+    int8_t ns;
+
+    if(_lux < 0) {
+        ns = -1;
+    } else if(_thrState == 1) {
+        ns = (_lux > _thrLimit + _thrHyst) ? 0 : 1;
+    } else {
+        ns = (_lux > _thrLimit) ? 0 : 1;
+    }
+
+    if(ns == _thrState) {
+        _thrCand = ns;
+        return;
+    }
+
+    if(ns != _thrCand) {
+        _thrCand = ns;
+        _thrCandNow = millis();
+    }
+
+    // First valid reading is taken over immediately
+    if((_thrState == -1 && ns >= 0) || (millis() - _thrCandNow >= _thrDwell)) {
+        _thrState = ns;
+        _thrEvent = true;
+    }
 }
 
 // Private functions ###########################################################
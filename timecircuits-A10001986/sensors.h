@@ -98,8 +98,12 @@ class tempSensor : tcSensor {
 
         tempSensor(int numTypes, uint8_t addrArr[]);
         bool begin(unsigned long powerupTime, void (*myDelay)(unsigned long));
+        uint8_t getAddress() { return _address; }
 
         float readTemp(bool celsius = true);
+        void  startConversion();
+        bool  poll();
+        float collect(bool celsius = true);
         float readLastTemp() { return _lastTemp; };
         bool lastTempNan() { return _lastTempNan; };
 
@@ -162,12 +166,19 @@ class lightSensor : tcSensor {
 
         lightSensor(int numTypes, uint8_t addrArr[]);
         bool begin(bool skipLast, unsigned long powerupTime, void (*myDelay)(unsigned long));
+        uint8_t getAddress() { return _address; }
 
         int32_t readLux();
         
         void loop();
 
+        void   setThreshold(int32_t limit, int32_t hyst, unsigned long dwell);
+        int8_t thresholdState() { return _thrState; };
+        bool   thresholdEvent();
+
     private:
+        void evalThreshold();
+
         void VEML7700SetGain(uint16_t gain, bool doWrite = true);
         void VEML7700SetAIT(uint16_t ait, bool doWrite = true);
         void VEML7700OnOff(bool enable, bool doWait = true);
@@ -185,6 +196,14 @@ class lightSensor : tcSensor {
         int32_t _lux = -1;
 
         uint16_t _con0 = 0;
+
+        int32_t       _thrLimit = 3;
+        int32_t       _thrHyst = 0;
+        unsigned long _thrDwell = 0;
+        int8_t        _thrState = -1;   // -1 unknown/bad, 0 bright, 1 dark
+        int8_t        _thrCand = -1;
+        unsigned long _thrCandNow = 0;
+        bool          _thrEvent = false;
 };
 
 #endif
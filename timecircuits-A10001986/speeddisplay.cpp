@@ -381,6 +381,15 @@ bool speedDisplay::begin(int dispType)
     
     _fontXSeg = displays[dispType].fontSeg;
 
+    // Pre-render speeds
+    for(int i = 0; i < 100; i++) {
+        _spdFrames[i][0] = *(_fontXSeg + (i / 10)) << _dig10_shift;
+        _spdFrames[i][1] = *(_fontXSeg + (i % 10)) << _dig01_shift;
+    }
+    _spdDot = *(_fontXSeg + 36) << _dot01_shift;
+
+    _shadowValid = false;
+
     directCmd(0x20 | 1); // turn on oscillator
 
     clearBuf();          // clear buffer
@@ -394,6 +403,10 @@ bool speedDisplay::begin(int dispType)
 // Turn on the display
 void speedDisplay::on()
 {
+    if(_holdCmds) {
+        _pendOn = 1;
+        return;
+    }
     if(_onCache > 0) return;
     directCmd(0x80 | 1);
     _onCache = 1;
@@ -403,6 +416,10 @@ void speedDisplay::on()
 // Turn off the display
 void speedDisplay::off()
 {
+    if(_holdCmds) {
+        _pendOn = 0;
+        return;
+    }
     if(!_onCache) return;
     directCmd(0x80);
     _onCache = 0;
@@ -413,6 +430,45 @@ bool speedDisplay::getOnOff()
     return !!_onCache;
 }
 
+// Hold back on/off and dimming commands until
+// flushCmds(); only the last of each kind is sent.
+void speedDisplay::holdCmds()
+{
+    _holdCmds = true;
+}
+
+void speedDisplay::flushCmds()
+{
+    _holdCmds = false;
+
+    // on() invalidates _briCache, so on/off first
+    if(_pendOn >= 0) {
+        _pendOn ? on() : off();
+        _pendOn = -1;
+    }
+    if(_pendBri != 0xff) {
+        setBrightnessDirect(_pendBri);
+        _pendBri = 0xff;
+    }
+}
+
+// Hold back show() until commitFrame(); used to 
+// update several displays back-to-back.
+void speedDisplay::holdFrame()
+{
+    _holdFrame = true;
+}
+
+void speedDisplay::commitFrame()
+{
+    _holdFrame = false;
+
+    if(_framePending) {
+        _framePending = false;
+        show();
+    }
+}
+
 // Turn on all LEDs
 #if 0
 void speedDisplay::lampTest()
@@ -425,6 +481,7 @@ void speedDisplay::lampTest()
     }
     Wire.endTransmission();
 
+    _shadowValid = false;
     _lastBufPosCol = 0xffff;
 }
 #endif
@@ -460,7 +517,9 @@ uint8_t speedDisplay::setBrightnessDirect(uint8_t level)
     if(level > 15)
         level = 15;
 
-    if(level != _briCache) {
+    if(_holdCmds) {
+        _pendBri = level;
+    } else if(level != _briCache) {
         directCmd(0xE0 | level);  // Dimming command
         _briCache = level;
     }
@@ -492,6 +551,14 @@ void speedDisplay::show()
 {
     int i;
 
+    if(_holdFrame) {
+        _framePending = true;
+        return;
+    }
+
+    // Commands from NM handling go out with the frame
+    holdCmds();
+
     if(_nightmode) {
         if(_oldnm < 1) {
             setBrightness(0);
@@ -521,15 +588,33 @@ void speedDisplay::show()
         }
     }
 
-    Wire.beginTransmission(_address);
-    Wire.write(0x00);  // start address
+    flushCmds();
 
+    // Only send the range of words that changed
+    int first = 8, last = -1;
     for(i = 0; i < 8; i++) {
-        Wire.write(_displayBuffer[i] & 0xFF);
-        Wire.write(_displayBuffer[i] >> 8);
+        if(!_shadowValid || _displayBuffer[i] != _shadowBuf[i]) {
+            if(first > i) first = i;
+            last = i;
+        }
     }
 
-    Wire.endTransmission();
+    if(last >= 0) {
+        Wire.beginTransmission(_address);
+        Wire.write(first * 2);  // start address
+
+        for(i = first; i <= last; i++) {
+            Wire.write(_displayBuffer[i] & 0xFF);
+            Wire.write(_displayBuffer[i] >> 8);
+        }
+
+        if(!Wire.endTransmission()) {
+            memcpy(_shadowBuf, _displayBuffer, sizeof(_shadowBuf));
+            _shadowValid = true;
+        } else {
+            _shadowValid = false;
+        }
+    }
 
     // Save last value written to _colon_pos
     if(_colon_pos < 255) {
@@ -590,6 +675,22 @@ void speedDisplay::setSpeed(int8_t speedNum)
 
     _speed = speedNum;
 
+    // Common case: Use pre-rendered frame
+    if(speedNum >= 0 && speedNum <= 99) {
+        _posSpdNow = now;
+        _lastPosSpd = speedNum;
+        #ifdef SP_CS_0ON
+        if(_dispType == SP_CIRCSETUP) {
+            // Hack to display "0" after dot
+            _displayBuffer[2] = b3;
+        }
+        #endif
+        _displayBuffer[_speed_pos10] |= _spdFrames[speedNum][0];
+        _displayBuffer[_speed_pos01] |= _spdFrames[speedNum][1];
+        if(_dot01) _displayBuffer[_dot_pos01] |= _spdDot;
+        return;
+    }
+
     if(speedNum < 0) {
         if((_lastPosSpd > 3) && (now - _posSpdNow < NO_FIX_DASHES)) {
             b1 = b2 = 37;
@@ -619,7 +720,7 @@ void speedDisplay::setSpeed(int8_t speedNum)
     _displayBuffer[_speed_pos10] |= (b1 << _dig10_shift);
     _displayBuffer[_speed_pos01] |= (b2 << _dig01_shift);
     
-    if(_dot01) _displayBuffer[_dot_pos01] |= (*(_fontXSeg + 36) << _dot01_shift);
+    if(_dot01) _displayBuffer[_dot_pos01] |= _spdDot;
 }
 
 #ifdef TC_HAVETEMP
@@ -749,6 +850,8 @@ void speedDisplay::directCol(int col, int segments)
     Wire.write(segments >> 8);
     Wire.endTransmission();
 
+    _shadowValid = false;
+
     if(col == _colon_pos)
         _lastBufPosCol = segments;
 }
@@ -766,6 +869,7 @@ void speedDisplay::clearDisplay()
 
     Wire.endTransmission();
 
+    _shadowValid = false;
     _lastBufPosCol = 0;
 }
 
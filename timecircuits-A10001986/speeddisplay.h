@@ -104,9 +104,14 @@ class speedDisplay {
 
         speedDisplay(uint8_t address);
         bool begin(int dispType);
+        uint8_t getAddress() { return _address; }
         void on();
         void off();
         bool getOnOff();
+        void holdCmds();
+        void flushCmds();
+        void holdFrame();
+        void commitFrame();
         #if 0
         void lampTest();
         #endif
@@ -146,9 +151,21 @@ class speedDisplay {
 
         uint8_t _address;
         uint16_t _displayBuffer[8];
+        uint16_t _shadowBuf[8];                 // What show() last sent
+        bool     _shadowValid = false;
+
+        // Pre-rendered speeds 0-99: Words for
+        // _speed_pos10 and _speed_pos01
+        uint16_t _spdFrames[100][2];
+        uint16_t _spdDot;                       // Dot at _dot_pos01
 
         int8_t _onCache = -1;                   // Cache for on/off
         uint8_t _briCache = 0xfe;               // Cache for brightness
+        bool    _holdCmds = false;
+        int8_t  _pendOn = -1;                   // Held back on/off
+        uint8_t _pendBri = 0xff;                // Held back brightness
+        bool    _holdFrame = false;
+        bool    _framePending = false;
 
         bool _dot01 = false;
         bool _colon = false;
@@ -0,0 +1,89 @@
+/*
+  AudioFileCache
+  Keeps recently used files open for AudioFileSourceFS/SD
+  
+  Copyright (C) 2026  Thomas Winischhofer (A10001986)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioFileCache.h"
+
+AudioFileCache::AudioFileCache(int maxFiles, bool (*filter)(const char *filename))
+{
+  this->maxFiles = (maxFiles > AFC_MAX) ? AFC_MAX : maxFiles;
+  this->filter = filter;
+  tick = 0;
+  for (int i = 0; i < AFC_MAX; i++) e[i].name[0] = 0;
+}
+
+AudioFileCache::~AudioFileCache()
+{
+  flush();
+}
+
+// Hand out a parked file, rewound. The entry is removed
+// while in use, so it can't be evicted under the source.
+bool AudioFileCache::take(const char *filename, fs::File &f)
+{
+  for (int i = 0; i < maxFiles; i++) {
+    if (e[i].name[0] && !strcmp(e[i].name, filename)) {
+      f = e[i].f;
+      e[i].f = fs::File();
+      e[i].name[0] = 0;
+      if (f && f.seek(0)) return true;
+      f.close();
+      f = fs::File();
+      return false;
+    }
+  }
+  return false;
+}
+
+// Park an open file; evicts the least recently used one if full.
+// Returns false if the file should be closed by the caller.
+bool AudioFileCache::put(const char *filename, fs::File &f)
+{
+  int i, slot = 0;
+
+  if (!maxFiles || !f || !filter || !filter(filename)) return false;
+  if (strlen(filename) >= AFC_NAMELEN) return false;
+
+  for (i = 0; i < maxFiles; i++) {
+    if (!e[i].name[0]) {
+      slot = i;
+      break;
+    }
+    if (e[i].used < e[slot].used) slot = i;
+  }
+  if (e[slot].name[0]) e[slot].f.close();
+
+  e[slot].f = f;
+  strcpy(e[slot].name, filename);
+  e[slot].used = ++tick;
+  f = fs::File();
+
+  return true;
+}
+
+void AudioFileCache::flush()
+{
+  for (int i = 0; i < AFC_MAX; i++) {
+    if (e[i].name[0]) {
+      e[i].f.close();
+      e[i].f = fs::File();
+      e[i].name[0] = 0;
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/*
+  AudioFileCache
+  Keeps recently used files open for AudioFileSourceFS/SD
+  
+  Copyright (C) 2026  Thomas Winischhofer (A10001986)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AUDIOFILECACHE_H
+#define _AUDIOFILECACHE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// A small LRU of open file objects. A source attached to a cache
+// parks its file here on close() instead of closing it, provided the
+// filter accepts the file name; open() takes it back and rewinds it,
+// saving the directory lookup. One cache can be shared by several
+// sources on the same file system. flush() closes all parked files;
+// it must be called before files are overwritten or removed.
+
+#define AFC_MAX     4
+#define AFC_NAMELEN 24
+
+class AudioFileCache
+{
+  public:
+    AudioFileCache(int maxFiles, bool (*filter)(const char *filename) = NULL);
+    ~AudioFileCache();
+
+    bool take(const char *filename, fs::File &f);
+    bool put(const char *filename, fs::File &f);
+    void flush();
+
+  private:
+    struct {
+      fs::File f;
+      char name[AFC_NAMELEN];
+      uint32_t used;
+    } e[AFC_MAX];
+    int maxFiles;
+    uint32_t tick;
+    bool (*filter)(const char *filename);
+};
+
+#endif
@@ -0,0 +1,168 @@
+/*
+  AudioFileSourceBuffer
+  Read-ahead buffer in front of another AudioFileSource
+  
+  Copyright (C) 2026  Thomas Winischhofer (A10001986)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioFileSourceBuffer.h"
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+AudioFileSourceBuffer::AudioFileSourceBuffer(AudioFileSource *in, uint32_t bufferBytes)
+{
+  src = in;
+  // Multiple of fillChunk, so full chunks always fit at the wrap point
+  buffSize = bufferBytes & ~(fillChunk - 1);
+  // Filled by SD reads, drained by the decoder: Keep it out of PSRAM
+  #ifdef ESP32
+  buffer = buffSize ? reinterpret_cast<uint8_t *>(heap_caps_malloc(buffSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) : NULL;
+  #else
+  buffer = buffSize ? reinterpret_cast<uint8_t *>(malloc(buffSize)) : NULL;
+  #endif
+  if (!buffer) {
+    audioLogger->printf_P(PSTR("AudioFileSourceBuffer: Unable to allocate %d bytes, passing through\n"), bufferBytes);
+    buffSize = 0;
+  }
+  reset(0);
+}
+
+AudioFileSourceBuffer::~AudioFileSourceBuffer()
+{
+  free(buffer);
+  buffer = NULL;
+}
+
+void AudioFileSourceBuffer::reset(uint32_t pos)
+{
+  readPtr = writePtr = length = 0;
+  srcPos = pos;
+  eof = false;
+}
+
+// Fetch one chunk from src. The first chunk after open or seek is cut
+// short so that subsequent reads start on a sector boundary.
+uint32_t AudioFileSourceBuffer::fill()
+{
+  uint32_t len, contig, got;
+
+  if (eof || (length == buffSize)) return 0;
+
+  // Rewind when empty, gives us the largest contiguous space
+  if (!length) readPtr = writePtr = 0;
+
+  contig = (writePtr >= readPtr) ? buffSize - writePtr : readPtr - writePtr;
+  len = fillChunk - (srcPos & (sectorSize - 1));
+  if (len > contig) len = contig;
+
+  got = src->read(buffer + writePtr, len);
+  if (!got) {
+    eof = true;
+    return 0;
+  }
+
+  writePtr += got;
+  if (writePtr >= buffSize) writePtr = 0;
+  length += got;
+  srcPos += got;
+
+  return got;
+}
+
+bool AudioFileSourceBuffer::open(const char *filename)
+{
+  reset(0);
+  return src->open(filename);
+}
+
+uint32_t AudioFileSourceBuffer::read(void *data, uint32_t len)
+{
+  uint8_t *p = reinterpret_cast<uint8_t *>(data);
+  uint32_t done = 0, n;
+
+  if (!buffer) return src->read(data, len);
+
+  while (done < len) {
+    if (!length && !fill()) break;
+    n = len - done;
+    if (n > length) n = length;
+    if (n > buffSize - readPtr) n = buffSize - readPtr;
+    memcpy(p + done, buffer + readPtr, n);
+    readPtr += n;
+    if (readPtr >= buffSize) readPtr = 0;
+    length -= n;
+    done += n;
+  }
+
+  return done;
+}
+
+bool AudioFileSourceBuffer::seek(int32_t pos, int dir)
+{
+  uint32_t target, cur;
+
+  if (!buffer) return src->seek(pos, dir);
+
+  cur = getPos();
+  if (dir == SEEK_SET) target = pos;
+  else if (dir == SEEK_CUR) target = cur + pos;
+  else if (dir == SEEK_END) target = src->getSize() + pos;
+  else return false;
+
+  // Forward within what we have buffered: Just skip
+  if (target >= cur && target <= srcPos) {
+    uint32_t skip = target - cur;
+    readPtr = (readPtr + skip) % buffSize;
+    length -= skip;
+    return true;
+  }
+
+  if (!src->seek(target, SEEK_SET)) return false;
+  reset(target);
+  return true;
+}
+
+bool AudioFileSourceBuffer::close()
+{
+  reset(0);
+  return src->close();
+}
+
+bool AudioFileSourceBuffer::isOpen()
+{
+  return src->isOpen();
+}
+
+uint32_t AudioFileSourceBuffer::getSize()
+{
+  return src->getSize();
+}
+
+uint32_t AudioFileSourceBuffer::getPos()
+{
+  if (!buffer) return src->getPos();
+  return srcPos - length;
+}
+
+bool AudioFileSourceBuffer::loop()
+{
+  // One chunk per call to keep each pass short
+  if (buffer && (buffSize - length >= fillChunk)) {
+    fill();
+  }
+  return src->loop();
+}
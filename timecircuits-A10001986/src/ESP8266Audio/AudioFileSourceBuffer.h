@@ -0,0 +1,65 @@
+/*
+  AudioFileSourceBuffer
+  Read-ahead buffer in front of another AudioFileSource
+  
+  Copyright (C) 2026  Thomas Winischhofer (A10001986)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AUDIOFILESOURCEBUFFER_H
+#define _AUDIOFILESOURCEBUFFER_H
+
+#include "AudioFileSource.h"
+
+// Keeps a ring buffer of data ahead of the decoder's read position.
+// The ring is topped up from loop() in sector-aligned chunks, so the
+// decoder's read() is normally served from RAM; only if the ring runs
+// dry, read() fetches from the underlying source synchronously.
+// If the buffer can't be allocated, all calls are passed through.
+
+class AudioFileSourceBuffer : public AudioFileSource
+{
+  public:
+    AudioFileSourceBuffer(AudioFileSource *in, uint32_t bufferBytes);
+    virtual ~AudioFileSourceBuffer() override;
+    
+    virtual bool open(const char *filename) override;
+    virtual uint32_t read(void *data, uint32_t len) override;
+    virtual bool seek(int32_t pos, int dir) override;
+    virtual bool close() override;
+    virtual bool isOpen() override;
+    virtual uint32_t getSize() override;
+    virtual uint32_t getPos() override;
+    virtual bool loop() override;
+
+    static constexpr uint32_t sectorSize = 512;
+    static constexpr uint32_t fillChunk = 2048;
+
+  private:
+    void reset(uint32_t pos);
+    uint32_t fill();
+
+    AudioFileSource *src;
+    uint8_t *buffer;
+    uint32_t buffSize;
+    uint32_t readPtr;
+    uint32_t writePtr;
+    uint32_t length;
+    uint32_t srcPos;    // Position of next byte to be fetched from src
+    bool eof;
+};
+
+#endif
+
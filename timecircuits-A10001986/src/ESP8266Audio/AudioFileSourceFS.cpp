@@ -34,7 +34,14 @@ bool AudioFileSourceFS::open(const char *filename)
 #ifndef ESP32
   filesystem->begin();
 #endif
+  if (f) close();
+  name[0] = 0;
+  if (cache && cache->take(filename, f)) {
+    strcpy(name, filename);
+    return true;
+  }
   f = filesystem->open(filename, "r");
+  if (f && cache && strlen(filename) < AFC_NAMELEN) strcpy(name, filename);
   return f;
 }
 
@@ -55,7 +62,8 @@ bool AudioFileSourceFS::seek(int32_t pos, int dir)
 
 bool AudioFileSourceFS::close()
 {
-  f.close();
+  if (!name[0] || !cache->put(name, f)) f.close();
+  name[0] = 0;
   return true;
 }
 
@@ -25,6 +25,7 @@
 #include <FS.h>
 
 #include "AudioFileSource.h"
+#include "AudioFileCache.h"
 
 class AudioFileSourceFS : public AudioFileSource
 {
@@ -41,9 +42,13 @@ class AudioFileSourceFS : public AudioFileSource
     virtual uint32_t getSize() override;
     virtual uint32_t getPos() override { if (!f) return 0; else return f.position(); };
 
+    void setCache(AudioFileCache *c) { cache = c; }
+
   private:
     fs::FS *filesystem;
     fs::File f;
+    AudioFileCache *cache = NULL;
+    char name[AFC_NAMELEN] = { 0 };
 };
 
 
@@ -31,7 +31,14 @@ AudioFileSourceSD::AudioFileSourceSD(const char *filename)
 
 bool AudioFileSourceSD::open(const char *filename)
 {
+  if (f) close();
+  name[0] = 0;
+  if (cache && cache->take(filename, f)) {
+    strcpy(name, filename);
+    return true;
+  }
   f = SD.open(filename, FILE_READ);
+  if (f && cache && strlen(filename) < AFC_NAMELEN) strcpy(name, filename);
   return f;
 }
 
@@ -40,9 +47,14 @@ AudioFileSourceSD::~AudioFileSourceSD()
   if (f) f.close();
 }
 
+uint32_t AudioFileSourceSD::readErrors = 0;
+
 uint32_t AudioFileSourceSD::read(void *data, uint32_t len)
 {
-  return f.read(reinterpret_cast<uint8_t*>(data), len);
+  uint32_t avail = f.size() - f.position();
+  uint32_t ret = f.read(reinterpret_cast<uint8_t*>(data), len);
+  if (ret < len && ret < avail) readErrors++;
+  return ret;
 }
 
 bool AudioFileSourceSD::seek(int32_t pos, int dir)
@@ -56,7 +68,8 @@ bool AudioFileSourceSD::seek(int32_t pos, int dir)
 
 bool AudioFileSourceSD::close()
 {
-  f.close();
+  if (!name[0] || !cache->put(name, f)) f.close();
+  name[0] = 0;
   return true;
 }
 
@@ -22,6 +22,7 @@
 #define _AUDIOFILESOURCESD_H
 
 #include "AudioFileSource.h"
+#include "AudioFileCache.h"
 #include <SD.h>
 
 
@@ -40,8 +41,15 @@ class AudioFileSourceSD : public AudioFileSource
     virtual uint32_t getSize() override;
     virtual uint32_t getPos() override;
 
+    // Short reads before end of file (all instances)
+    static uint32_t readErrors;
+
+    void setCache(AudioFileCache *c) { cache = c; }
+
   private:
     File f;
+    AudioFileCache *cache = NULL;
+    char name[AFC_NAMELEN] = { 0 };
 };
 
 
@@ -21,6 +21,9 @@
 
 #include "AudioGeneratorMP3.h"
 
+uint32_t AudioGeneratorMP3::allocCount = 0;
+uint32_t AudioGeneratorMP3::allocFails = 0;
+
 AudioGeneratorMP3::AudioGeneratorMP3()
 {
   running = false;
@@ -164,16 +167,34 @@ void AudioGeneratorMP3::desync ()
 
 bool AudioGeneratorMP3::DecodeNextFrame()
 {
+  uint32_t t = micros();
   if (mad_frame_decode(frame, stream) == -1) {
     ErrorToFlow(); // Always returns CONTINUE
     return false;
   }
+  benchUs += micros() - t;
+  benchFrames++;
   nsCountMax  = MAD_NSBSAMPLES(&frame->header);
   return true;
 }
 
-bool AudioGeneratorMP3::GetOneSample(int16_t sample[2])
+// Synthesize the next 32 PCM samples of the current frame and
+// interleave them into block[] for the output's block interface
+bool AudioGeneratorMP3::GetNextBlock()
 {
+  uint32_t t = micros();
+  enum mad_flow flow = mad_synth_frame_onens(synth, frame, nsCount++);
+  benchUs += micros() - t;
+
+  switch (flow) {
+      case MAD_FLOW_STOP:
+      case MAD_FLOW_BREAK: audioLogger->printf_P(PSTR("msf1ns failed\n"));
+        return false; // Either way we're done
+      default:
+        break; // Do nothing
+  }
+  // for IGNORE and CONTINUE, just play what we have now
+
   if (synth->pcm.samplerate != lastRate) {
     output->SetRate(synth->pcm.samplerate);
     lastRate = synth->pcm.samplerate;
@@ -182,43 +203,34 @@ bool AudioGeneratorMP3::GetOneSample(int16_t sample[2])
     output->SetChannels(synth->pcm.channels);
     lastChannels = synth->pcm.channels;
   }
-    
-  // If we're here, we have one decoded frame and sent 0 or more samples out
-  if (samplePtr < synth->pcm.length) {
-    sample[AudioOutput::LEFTCHANNEL ] = synth->pcm.samples[0][samplePtr];
-    sample[AudioOutput::RIGHTCHANNEL] = synth->pcm.samples[1][samplePtr];
-    samplePtr++;
-  } else {
-    samplePtr = 0;
-    
-    switch ( mad_synth_frame_onens(synth, frame, nsCount++) ) {
-        case MAD_FLOW_STOP:
-        case MAD_FLOW_BREAK: audioLogger->printf_P(PSTR("msf1ns failed\n"));
-          return false; // Either way we're done
-        default:
-          break; // Do nothing
-    }
-    // for IGNORE and CONTINUE, just play what we have now
-    sample[AudioOutput::LEFTCHANNEL ] = synth->pcm.samples[0][samplePtr];
-    sample[AudioOutput::RIGHTCHANNEL] = synth->pcm.samples[1][samplePtr];
-    samplePtr++;
+
+  int16_t *p = block;
+  for (int i = 0; i < synth->pcm.length; i++) {
+    *p++ = synth->pcm.samples[0][i];
+    *p++ = synth->pcm.samples[1][i];
   }
+  blockLen = synth->pcm.length;
+  blockPtr = 0;
+
   return true;
 }
 
 
-bool AudioGeneratorMP3::loop()
+bool AUDIO_IRAM AudioGeneratorMP3::loop()
 {
   if (!running) goto done; // Nothing to do here!
 
-  // First, try and push in the stored sample.  If we can't, then punt and try later
-  if (!output->ConsumeSample(lastSample)) goto done; // Can't send, but no error detected
-
-  // Try and stuff the buffer one sample at a time
   do
   {
+    // First, try and push out what is left of the current block.
+    // If the output can't take all of it, punt and try later.
+    if (blockPtr < blockLen) {
+      blockPtr += output->ConsumeSamples(&block[blockPtr * 2], blockLen - blockPtr);
+      if (blockPtr < blockLen) goto done; // Can't send, but no error detected
+    }
+
     // Decode next frame if we're beyond the existing generated data
-    if ( (samplePtr >= synth->pcm.length) && (nsCount >= nsCountMax) ) {
+    if (nsCount >= nsCountMax) {
 retry:
       if (Input() == MAD_FLOW_STOP) {
         return false;
@@ -239,16 +251,15 @@ retry:
         }
         goto retry;
       }
-      samplePtr = 9999;
       nsCount = 0;
     }
 
-    if (!GetOneSample(lastSample)) {
-      audioLogger->printf_P(PSTR("G1S failed\n"));
+    if (!GetNextBlock()) {
+      audioLogger->printf_P(PSTR("GNB failed\n"));
       running = false;
       goto done;
     }
-  } while (running && output->ConsumeSample(lastSample));
+  } while (running);
 
 done:
   file->loop();
@@ -278,9 +289,12 @@ bool AudioGeneratorMP3::begin(AudioFileSource *source, AudioOutput *output)
 
   if (!output->begin()) return false;
 
-  // Where we are in generating one frame's data, set to invalid so we will run loop on first getsample()
-  samplePtr = 9999;
+  // Where we are in generating one frame's data, set to invalid so we will decode on first loop()
+  blockPtr = 0;
+  blockLen = 0;
   nsCount = 9999;
+  benchFrames = 0;
+  benchUs = 0;
   lastRate = 0;
   lastChannels = 0;
   lastReadPos = 0;
@@ -323,7 +337,9 @@ bool AudioGeneratorMP3::begin(AudioFileSource *source, AudioOutput *output)
     stream = reinterpret_cast<struct mad_stream *>(malloc(sizeof(struct mad_stream)));
     frame = reinterpret_cast<struct mad_frame *>(malloc(sizeof(struct mad_frame)));
     synth = reinterpret_cast<struct mad_synth *>(malloc(sizeof(struct mad_synth)));
+    allocCount++;
     if (!buff || !stream || !frame || !synth) {
+      allocFails++;
       free(buff);
       free(stream);
       free(frame);
@@ -347,6 +363,38 @@ bool AudioGeneratorMP3::begin(AudioFileSource *source, AudioOutput *output)
   return true;
 }
 
+// Continue with another file without stopping the output (gapless
+// playback). Meant to be called once loop() returned false at the end
+// of the current file. The current file is closed.
+bool AudioGeneratorMP3::nextFile(AudioFileSource *source)
+{
+  if (!running || !source || !source->isOpen()) return false;
+
+  file->close();
+  file = source;
+
+  if (madInitted) {
+    mad_synth_finish(synth);
+    mad_frame_finish(frame);
+    mad_stream_finish(stream);
+  }
+  mad_stream_init(stream);
+  mad_frame_init(frame);
+  mad_synth_init(synth);
+  synth->pcm.length = 0;
+  mad_stream_options(stream, 0);
+  madInitted = true;
+
+  // Any samples still in block[] belong to the previous file and are
+  // played out first. Rate/channels are re-checked on the next block.
+  nsCount = 9999;
+  lastReadPos = 0;
+  lastBuffLen = 0;
+  unrecoverable = 0;
+
+  return true;
+}
+
 // The following are helper routines for use in libmad to check stack/heap free
 // and to determine if there's enough stack space to allocate some blocks there
 // instead of precious heap.
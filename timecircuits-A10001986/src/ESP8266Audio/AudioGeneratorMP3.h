@@ -37,6 +37,17 @@ class AudioGeneratorMP3 : public AudioGenerator
     virtual bool stop() override;
     virtual bool isRunning() override;
     virtual void desync () override;
+    bool nextFile(AudioFileSource *source);
+
+    // Decoder benchmark: Frames decoded since begin(), and
+    // average time for decoding and synthesis per frame
+    uint32_t GetDecodedFrames() { return benchFrames; }
+    uint32_t GetFrameTimeUs() { return benchFrames ? (uint32_t)(benchUs / benchFrames) : 0; }
+
+    // Heap statistics (all instances): begin() calls that malloc'd
+    // the decoder buffers (preAllocSize() bytes each), and failures
+    static uint32_t GetAllocCount() { return allocCount; }
+    static uint32_t GetAllocFails() { return allocFails; }
 
     static constexpr int preAllocSize () { return preAllocBuffSize() + preAllocStreamSize() + preAllocFrameSize() + preAllocSynthSize(); }
     static constexpr int preAllocBuffSize () { return ((buffLen + 7) & ~7); }
@@ -45,6 +56,8 @@ class AudioGeneratorMP3 : public AudioGenerator
     static constexpr int preAllocSynthSize () { return (sizeof(struct mad_synth) + 7) & ~7; }
 
   protected:   
+    static uint32_t allocCount;
+    static uint32_t allocFails;
     void *preallocateSpace = nullptr;
     int preallocateSize = 0;
     void *preallocateStreamSpace = nullptr;
@@ -66,15 +79,22 @@ class AudioGeneratorMP3 : public AudioGenerator
     struct mad_stream *stream;
     struct mad_frame *frame;
     struct mad_synth *synth;
-    int samplePtr;
     int nsCount;
     int nsCountMax;
 
+    // One synth block (32 samples/channel), interleaved L/R
+    int16_t block[32 * 2];
+    int blockLen;
+    int blockPtr;
+
+    uint32_t benchFrames = 0;
+    uint64_t benchUs = 0;
+
     // The internal helpers
     enum mad_flow ErrorToFlow();
     enum mad_flow Input();
     bool DecodeNextFrame();
-    bool GetOneSample(int16_t sample[2]);
+    bool GetNextBlock();
 
   private:
     int unrecoverable = 0;
@@ -29,11 +29,20 @@ AudioGeneratorWAV::AudioGeneratorWAV()
   buff = NULL;
   buffPtr = 0;
   buffLen = 0;
+  blockPtr = 0;
+  blockLen = 0;
+}
+
+// Buffer in caller's memory; buffSize is limited to preallocateSize
+AudioGeneratorWAV::AudioGeneratorWAV(void *space, int size): AudioGeneratorWAV()
+{
+  preallocateSpace = space;
+  preallocateSize = size;
 }
 
 AudioGeneratorWAV::~AudioGeneratorWAV()
 {
-  free(buff);
+  if (!preallocateSpace) free(buff);
   buff = NULL;
 }
 
@@ -41,7 +50,7 @@ bool AudioGeneratorWAV::stop()
 {
   if (!running) return true;
   running = false;
-  free(buff);
+  if (!preallocateSpace) free(buff);
   buff = NULL;
   output->stop();
   return file->close();
@@ -73,35 +82,54 @@ bool AudioGeneratorWAV::GetBufferedData(int bytes, void *dest)
   return true;
 }
 
-bool AudioGeneratorWAV::loop()
+// Convert the next up to blockFrames frames into block[], returns
+// number of frames available
+int AudioGeneratorWAV::GetNextBlock()
 {
-  if (!running) goto done; // Nothing to do here!
-
-  // First, try and push in the stored sample.  If we can't, then punt and try later
-  if (!output->ConsumeSample(lastSample)) goto done; // Can't send, but no error detected
+  int16_t *p = block;
+  int n;
 
-  // Try and stuff the buffer one sample at a time
-  do
-  {
+  for (n = 0; n < blockFrames; n++) {
     if (bitsPerSample == 8) {
-      uint8_t l, r;
-      if (!GetBufferedData(1, &l)) stop();
+      uint8_t l, r = 0;
+      if (!GetBufferedData(1, &l)) break;
       if (channels == 2) {
-        if (!GetBufferedData(1, &r)) stop();
-      } else {
-        r = 0;
+        if (!GetBufferedData(1, &r)) break;
       }
-      lastSample[AudioOutput::LEFTCHANNEL] = l;
-      lastSample[AudioOutput::RIGHTCHANNEL] = r;
-    } else if (bitsPerSample == 16) {
-      if (!GetBufferedData(2, &lastSample[AudioOutput::LEFTCHANNEL])) stop();
+      *p++ = l;
+      *p++ = r;
+    } else {
+      int16_t r = 0;
+      if (!GetBufferedData(2, p)) break;
       if (channels == 2) {
-        if (!GetBufferedData(2, &lastSample[AudioOutput::RIGHTCHANNEL])) stop();
-      } else {
-        lastSample[AudioOutput::RIGHTCHANNEL] = 0;
+        if (!GetBufferedData(2, &r)) break;
       }
+      p++;
+      *p++ = r;
+    }
+  }
+
+  blockLen = n;
+  blockPtr = 0;
+
+  return n;
+}
+
+bool AudioGeneratorWAV::loop()
+{
+  if (!running) goto done; // Nothing to do here!
+
+  do
+  {
+    // First, try and push out what is left of the current block.
+    // If the output can't take all of it, punt and try later.
+    if (blockPtr < blockLen) {
+      blockPtr += output->ConsumeSamples(&block[blockPtr * 2], blockLen - blockPtr);
+      if (blockPtr < blockLen) goto done; // Can't send, but no error detected
     }
-  } while (running && output->ConsumeSample(lastSample));
+
+    if (!GetNextBlock()) stop();
+  } while (running);
 
 done:
   file->loop();
@@ -259,13 +287,20 @@ bool AudioGeneratorWAV::ReadWAVInfo()
   availBytes = u32;
 
   // Now set up the buffer or fail
-  buff = reinterpret_cast<uint8_t *>(malloc(buffSize));
+  if (preallocateSpace) {
+    if (buffSize > (uint32_t)preallocateSize) buffSize = preallocateSize;
+    buff = reinterpret_cast<uint8_t *>(preallocateSpace);
+  } else {
+    buff = reinterpret_cast<uint8_t *>(malloc(buffSize));
+  }
   if (!buff) {
     Serial.printf_P(PSTR("AudioGeneratorWAV::ReadWAVInfo: cannot read WAV, failed to set up buffer \n"));
     return false;
   };
   buffPtr = 0;
   buffLen = 0;
+  blockPtr = 0;
+  blockLen = 0;
 
   return true;
 }
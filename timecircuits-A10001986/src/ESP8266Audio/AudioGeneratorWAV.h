@@ -27,6 +27,7 @@ class AudioGeneratorWAV : public AudioGenerator
 {
   public:
     AudioGeneratorWAV();
+    AudioGeneratorWAV(void *preallocateSpace, int preallocateSize);
     virtual ~AudioGeneratorWAV() override;
     virtual bool begin(AudioFileSource *source, AudioOutput *output) override;
     virtual bool loop() override;
@@ -39,6 +40,7 @@ class AudioGeneratorWAV : public AudioGenerator
     bool ReadU16(uint16_t *dest) { return file->read(reinterpret_cast<uint8_t*>(dest), 2); }
     bool ReadU8(uint8_t *dest) { return file->read(reinterpret_cast<uint8_t*>(dest), 1); }
     bool GetBufferedData(int bytes, void *dest);
+    int GetNextBlock();
     bool ReadWAVInfo();
 
     
@@ -53,8 +55,16 @@ class AudioGeneratorWAV : public AudioGenerator
     // We need to buffer some data in-RAM to avoid doing 1000s of small reads
     uint32_t buffSize;
     uint8_t *buff;
+    void *preallocateSpace = nullptr;
+    int preallocateSize = 0;
     uint16_t buffPtr;
     uint16_t buffLen;
+
+    // Decoded frames, interleaved L/R, handed to the output as a block
+    static constexpr int blockFrames = 64;
+    int16_t block[blockFrames * 2];
+    int blockLen;
+    int blockPtr;
 };
 
 #endif
@@ -24,6 +24,15 @@
 #include <Arduino.h>
 #include "AudioStatus.h"
 
+// Per-sample output path: In IRAM on ESP32, like libmad's synthesis
+// (MAD_IRAM), so it runs without flash cache misses
+#if defined(ESP32)
+#include <esp_attr.h>
+#define AUDIO_IRAM IRAM_ATTR
+#else
+#define AUDIO_IRAM
+#endif
+
 class AudioOutput
 {
   public:
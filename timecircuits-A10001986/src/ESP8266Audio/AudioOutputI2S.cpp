@@ -227,7 +227,7 @@ bool AudioOutputI2S::begin(bool txDAC)
           .communication_format = comm_fmt,
           .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1, // lowest interrupt priority
           .dma_buf_count = dma_buf_count,
-          .dma_buf_len = 64,
+          .dma_buf_len = dmaBufLen,
           .use_apll = use_apll // Use audio PLL
       };
       audioLogger->printf("+%d %p\n", portNo, &i2s_config_dac);
@@ -283,13 +283,9 @@ bool AudioOutputI2S::begin(bool txDAC)
   return true;
 }
 
-bool AudioOutputI2S::ConsumeSample(int16_t sample[2])
+#ifdef ESP32
+uint32_t AUDIO_IRAM AudioOutputI2S::MakeFrame(int16_t sample[2])
 {
-
-  //return if we haven't called ::begin yet
-  if (!i2sOn)
-    return false;
-
   int16_t ms[2];
 
   ms[0] = sample[0];
@@ -301,25 +297,57 @@ bool AudioOutputI2S::ConsumeSample(int16_t sample[2])
     int32_t ttl = ms[LEFTCHANNEL] + ms[RIGHTCHANNEL];
     ms[LEFTCHANNEL] = ms[RIGHTCHANNEL] = (ttl>>1) & 0xffff;
   }
+
+  if (output_mode == INTERNAL_DAC)
+  {
+    int16_t l = Amplify(ms[LEFTCHANNEL]) + 0x8000;
+    int16_t r = Amplify(ms[RIGHTCHANNEL]) + 0x8000;
+    return (r << 16) | (l & 0xffff);
+  }
+
+  return ((Amplify(ms[RIGHTCHANNEL])) << 16) | (Amplify(ms[LEFTCHANNEL]) & 0xffff);
+}
+
+// Hand whatever is left in the staging buffer to the driver without
+// blocking. Returns true once the staging buffer is empty.
+bool AudioOutputI2S::WriteStage()
+{
+  if (stagePtr < stageLen) {
+    size_t i2s_bytes_written = 0;
+    i2s_write((i2s_port_t)portNo, (const char*)&stage[stagePtr], (stageLen - stagePtr) * sizeof(uint32_t), &i2s_bytes_written, 0);
+    stagePtr += i2s_bytes_written / sizeof(uint32_t);
+    if (stagePtr < stageLen)
+      return false;
+  }
+  stagePtr = stageLen = 0;
+  return true;
+}
+#endif
+
+bool AUDIO_IRAM AudioOutputI2S::ConsumeSample(int16_t sample[2])
+{
+
+  //return if we haven't called ::begin yet
+  if (!i2sOn)
+    return false;
+
   #ifdef ESP32
-    uint32_t s32;
-    if (output_mode == INTERNAL_DAC)
-    {
-      int16_t l = Amplify(ms[LEFTCHANNEL]) + 0x8000;
-      int16_t r = Amplify(ms[RIGHTCHANNEL]) + 0x8000;
-      s32 = (r << 16) | (l & 0xffff);
-    }
-    else
-    {
-      s32 = ((Amplify(ms[RIGHTCHANNEL])) << 16) | (Amplify(ms[LEFTCHANNEL]) & 0xffff);
-    }
-//"i2s_write_bytes" has been removed in the ESP32 Arduino 2.0.0,  use "i2s_write" instead.
-//    return i2s_write_bytes((i2s_port_t)portNo, (const char *)&s32, sizeof(uint32_t), 0);
+    // Goes through the staging buffer to keep sample order intact
+    return (ConsumeSamples(sample, 1) == 1);
+  #else
+    int16_t ms[2];
 
-    size_t i2s_bytes_written;
-    i2s_write((i2s_port_t)portNo, (const char*)&s32, sizeof(uint32_t), &i2s_bytes_written, 0);
-    return i2s_bytes_written;
-  #elif defined(ESP8266)
+    ms[0] = sample[0];
+    ms[1] = sample[1];
+    MakeSampleStereo16( ms );
+
+    if (this->mono) {
+      // Average the two samples and overwrite
+      int32_t ttl = ms[LEFTCHANNEL] + ms[RIGHTCHANNEL];
+      ms[LEFTCHANNEL] = ms[RIGHTCHANNEL] = (ttl>>1) & 0xffff;
+    }
+  #endif
+  #if defined(ESP8266)
     uint32_t s32 = ((Amplify(ms[RIGHTCHANNEL])) << 16) | (Amplify(ms[LEFTCHANNEL]) & 0xffff);
     return i2s_write_sample_nb(s32); // If we can't store it, return false.  OTW true
   #elif defined(ARDUINO_ARCH_RP2040)
@@ -327,19 +355,67 @@ bool AudioOutputI2S::ConsumeSample(int16_t sample[2])
   #endif
 }
 
+// Block interface: Converts up to one DMA buffer worth of frames into
+// the staging buffer and hands it to the driver in a single i2s_write.
+// Returns the number of frames taken; frames taken but not yet accepted
+// by the driver stay staged and go out first on the next call (or in
+// loop()), so the caller never has to re-submit anything.
+uint16_t AUDIO_IRAM AudioOutputI2S::ConsumeSamples(int16_t *samples, uint16_t count)
+{
+  #ifdef ESP32
+    uint16_t done = 0;
+
+    if (!i2sOn)
+      return 0;
+
+    while (WriteStage() && (done < count)) {
+      uint16_t n = count - done;
+      if (n > dmaBufLen) n = dmaBufLen;
+      for (uint16_t i = 0; i < n; i++) {
+        stage[i] = MakeFrame(samples);
+        samples += 2;
+      }
+      stageLen = n;
+      done += n;
+    }
+
+    return done;
+  #else
+    return AudioOutput::ConsumeSamples(samples, count);
+  #endif
+}
+
+bool AudioOutputI2S::loop()
+{
+  #ifdef ESP32
+    if (i2sOn)
+      WriteStage();
+  #endif
+  return true;
+}
+
 void AudioOutputI2S::flush()
 {
   #ifdef ESP32
     // makes sure that all stored DMA samples are consumed / played
-    int buffersize = 64 * this->dma_buf_count;
-    int16_t samples[2] = {0x0, 0x0};
-    for (int i = 0; i < buffersize; i++)
+    int16_t samples[dmaBufLen * 2] = { 0 };
+    if (!i2sOn)
+      return;
+    while (!WriteStage())
     {
-      while (!ConsumeSample(samples))
+      delay(10);
+    }
+    for (int i = 0; i < this->dma_buf_count; i++)
+    {
+      while (!ConsumeSamples(samples, dmaBufLen))
       {
         delay(10);
       }
     }
+    while (!WriteStage())
+    {
+      delay(10);
+    }
   #elif defined(ARDUINO_ARCH_RP2040)
     I2S.flush();
   #endif
@@ -351,6 +427,7 @@ bool AudioOutputI2S::stop()
     return false;
 
   #ifdef ESP32
+    stagePtr = stageLen = 0;
     i2s_zero_dma_buffer((i2s_port_t)portNo);
     i2s_driver_uninstall((i2s_port_t)portNo); //stop & destroy i2s driver
   #elif defined(ESP8266)
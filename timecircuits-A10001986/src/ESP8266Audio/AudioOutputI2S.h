@@ -39,16 +39,25 @@ class AudioOutputI2S : public AudioOutput
     virtual bool SetChannels(int channels) override;
     virtual bool begin() override { return begin(true); }
     virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual uint16_t ConsumeSamples(int16_t *samples, uint16_t count) override;
     virtual void flush() override;
     virtual bool stop() override;
+    virtual bool loop() override;
     
     bool begin(bool txDAC);
     bool SetOutputModeMono(bool mono);  // Force mono output no matter the input
     bool SetLsbJustified(bool lsbJustified);  // Allow supporting non-I2S chips, e.g. PT8211 
 
+    // Frames per DMA buffer; also the size of the staging buffer
+    static constexpr int dmaBufLen = 64;
+
   protected:
     bool SetPinout();
     virtual int AdjustI2SRate(int hz) { return hz; }
+#ifdef ESP32
+    uint32_t MakeFrame(int16_t sample[2]);
+    bool WriteStage();
+#endif
     uint8_t portNo;
     int output_mode;
     bool mono;
@@ -63,4 +72,11 @@ class AudioOutputI2S : public AudioOutput
     uint8_t bclkPin;
     uint8_t wclkPin;
     uint8_t doutPin;
+
+#ifdef ESP32
+    // Converted frames waiting to be handed to the driver in one i2s_write
+    uint32_t stage[dmaBufLen];
+    uint16_t stageLen = 0;
+    uint16_t stagePtr = 0;
+#endif
 };
@@ -0,0 +1,317 @@
+/*
+  AudioOutputMixer
+  Simple mixer which sums several inputs ("voices") into one output
+  
+  Copyright (C) 2026  Thomas Winischhofer (A10001986)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioOutputMixer.h"
+
+AudioOutputMixerStub::AudioOutputMixerStub(AudioOutputMixer *parent, int id)
+{
+  this->parent = parent;
+  this->id = id;
+  active = false;
+  draining = false;
+  hertz = 44100;
+  bps = 16;
+  channels = 2;
+  step = 0x10000;
+  maxOut = 1;
+  SetGain(1.0);
+  Reset();
+}
+
+void AudioOutputMixerStub::Reset()
+{
+  rd = wr = cnt = 0;
+  frac = 0;
+  prev[0] = prev[1] = 0;
+}
+
+bool AudioOutputMixerStub::SetRate(int hz)
+{
+  hertz = hz;
+  if (active) parent->UpdateRates();
+  return true;
+}
+
+bool AudioOutputMixerStub::begin()
+{
+  return parent->VoiceBegin(id);
+}
+
+bool AudioOutputMixerStub::stop()
+{
+  parent->VoiceStop(id);
+  return true;
+}
+
+bool AudioOutputMixerStub::loop()
+{
+  return parent->loop();
+}
+
+// Queue one frame at the sink's rate
+void AUDIO_IRAM AudioOutputMixerStub::Put(int16_t sample[2])
+{
+  if (step == 0x10000) {
+    ring[wr * 2] = sample[0];
+    ring[wr * 2 + 1] = sample[1];
+    if (++wr >= ringLen) wr = 0;
+    cnt++;
+    return;
+  }
+
+  while (frac < 0x10000) {
+    int32_t w = frac >> 1;   // 15 bit, keeps the product within 32 bits
+    ring[wr * 2]     = prev[0] + (((sample[0] - prev[0]) * w) >> 15);
+    ring[wr * 2 + 1] = prev[1] + (((sample[1] - prev[1]) * w) >> 15);
+    if (++wr >= ringLen) wr = 0;
+    cnt++;
+    frac += step;
+  }
+  frac -= 0x10000;
+  prev[0] = sample[0];
+  prev[1] = sample[1];
+}
+
+uint16_t AUDIO_IRAM AudioOutputMixerStub::ConsumeSamples(int16_t *samples, uint16_t count)
+{
+  uint16_t i;
+  int16_t ms[2];
+
+  if (!active || draining) return 0;
+
+  for (i = 0; i < count; i++) {
+    if (ringLen - cnt < maxOut) {
+      // Full: Try to make room by mixing out what we have
+      parent->loop();
+      if (ringLen - cnt < maxOut) break;
+    }
+    ms[0] = samples[0];
+    ms[1] = samples[1];
+    MakeSampleStereo16(ms);
+    ms[LEFTCHANNEL] = Amplify(ms[LEFTCHANNEL]);
+    ms[RIGHTCHANNEL] = Amplify(ms[RIGHTCHANNEL]);
+    Put(ms);
+    samples += 2;
+  }
+
+  return i;
+}
+
+bool AudioOutputMixerStub::ConsumeSample(int16_t sample[2])
+{
+  return (ConsumeSamples(sample, 1) == 1);
+}
+
+
+AudioOutputMixer::AudioOutputMixer(AudioOutput *sink)
+{
+  this->sink = sink;
+  sinkOn = false;
+  sinkRate = 0;
+  numVoices = 0;
+  mixPtr = mixCnt = 0;
+  for (int i = 0; i < maxVoices; i++) voice[i] = NULL;
+}
+
+AudioOutputMixer::~AudioOutputMixer()
+{
+  stop();
+  for (int i = 0; i < numVoices; i++) {
+    delete voice[i];
+    voice[i] = NULL;
+  }
+}
+
+AudioOutputMixerStub *AudioOutputMixer::NewInput()
+{
+  if (numVoices >= maxVoices) return NULL;
+  voice[numVoices] = new AudioOutputMixerStub(this, numVoices);
+  return voice[numVoices++];
+}
+
+// Sink rate follows the lowest-numbered active voice; the others
+// are resampled to it.
+void AudioOutputMixer::UpdateRates()
+{
+  int rate = 0;
+
+  for (int i = 0; i < numVoices; i++) {
+    if (voice[i]->active) {
+      rate = voice[i]->hertz;
+      break;
+    }
+  }
+  if (!rate) return;
+
+  if (rate != sinkRate) {
+    sink->SetRate(rate);
+    sinkRate = rate;
+  }
+
+  for (int i = 0; i < numVoices; i++) {
+    AudioOutputMixerStub *v = voice[i];
+    v->step = (uint32_t)(((uint64_t)v->hertz << 16) / sinkRate);
+    if (!v->step) v->step = 1;
+    v->maxOut = (0x10000 + v->step - 1) / v->step;
+    if (!v->maxOut) v->maxOut = 1;
+  }
+}
+
+bool AudioOutputMixer::VoiceBegin(int id)
+{
+  AudioOutputMixerStub *v = voice[id];
+
+  v->Reset();
+  v->active = true;
+  v->draining = false;
+
+  if (!sinkOn) {
+    sink->SetBitsPerSample(16);
+    sink->SetChannels(2);
+    sinkRate = 0;
+    mixPtr = mixCnt = 0;
+    sinkOn = sink->begin();
+  }
+
+  UpdateRates();
+
+  return sinkOn;
+}
+
+// Frames still queued are played out first; loop() then
+// deactivates the voice
+void AudioOutputMixer::VoiceStop(int id)
+{
+  AudioOutputMixerStub *v = voice[id];
+  bool any = false;
+
+  if (!v->active || v->draining) return;
+
+  if (sinkOn && v->cnt) {
+    v->draining = true;
+    return;
+  }
+  
+  v->active = false;
+  v->Reset();
+
+  for (int i = 0; i < numVoices; i++) {
+    if (voice[i]->active) any = true;
+  }
+
+  if (any) {
+    UpdateRates();
+  } else {
+    stop();
+  }
+}
+
+bool AudioOutputMixer::stop()
+{
+  for (int i = 0; i < numVoices; i++) {
+    voice[i]->active = false;
+    voice[i]->draining = false;
+    voice[i]->Reset();
+  }
+  mixPtr = mixCnt = 0;
+  if (sinkOn) {
+    sink->stop();
+    sinkOn = false;
+  }
+  return true;
+}
+
+bool AudioOutputMixer::loop()
+{
+  if (!sinkOn) return true;
+
+  for (;;) {
+    int n = mixLen;
+    int live = 0, drain = 0;
+    bool retired = false;
+
+    // Push out what is left of the last mix block first
+    if (mixPtr < mixCnt) {
+      mixPtr += sink->ConsumeSamples(&mixBuf[mixPtr * 2], mixCnt - mixPtr);
+      if (mixPtr < mixCnt) break;
+    }
+
+    // We can mix as many frames as all live voices have; draining
+    // voices contribute what they have left. With no live voices,
+    // the longest draining one sets the pace.
+    for (int i = 0; i < numVoices; i++) {
+      AudioOutputMixerStub *v = voice[i];
+      if (!v->active) continue;
+      if (v->draining) {
+        drain++;
+      } else {
+        live++;
+        if (v->cnt < n) n = v->cnt;
+      }
+    }
+    if (!live && !drain) {
+      // All played out
+      stop();
+      return true;
+    }
+    if (!live) {
+      n = 0;
+      for (int i = 0; i < numVoices; i++) {
+        if (voice[i]->draining && voice[i]->cnt > n) n = voice[i]->cnt;
+      }
+      if (n > mixLen) n = mixLen;
+    }
+    if (!n) break;
+
+    for (int j = 0; j < n; j++) {
+      int32_t l = 0, r = 0;
+      for (int i = 0; i < numVoices; i++) {
+        AudioOutputMixerStub *v = voice[i];
+        if (v->active && v->cnt) {
+          l += v->ring[v->rd * 2];
+          r += v->ring[v->rd * 2 + 1];
+          if (++v->rd >= AudioOutputMixerStub::ringLen) v->rd = 0;
+          v->cnt--;
+        }
+      }
+      if (l < -32767) l = -32767; else if (l > 32767) l = 32767;
+      if (r < -32767) r = -32767; else if (r > 32767) r = 32767;
+      mixBuf[j * 2] = l;
+      mixBuf[j * 2 + 1] = r;
+    }
+    mixCnt = n;
+    mixPtr = 0;
+
+    // Draining voices that are played out are done. The sink
+    // is stopped (above) once the last block has gone out.
+    for (int i = 0; i < numVoices; i++) {
+      AudioOutputMixerStub *v = voice[i];
+      if (v->draining && !v->cnt) {
+        v->active = false;
+        v->draining = false;
+        v->Reset();
+        retired = true;
+      }
+    }
+    if (retired && live) UpdateRates();
+  }
+
+  return sink->loop();
+}
@@ -0,0 +1,107 @@
+/*
+  AudioOutputMixer
+  Simple mixer which sums several inputs ("voices") into one output
+  
+  Copyright (C) 2026  Thomas Winischhofer (A10001986)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AUDIOOUTPUTMIXER_H
+#define _AUDIOOUTPUTMIXER_H
+
+#include "AudioOutput.h"
+
+// Each generator gets its own AudioOutputMixerStub (from NewInput())
+// as its output. The stub converts to 16-bit stereo, applies its own
+// gain (SetGain() on the stub), resamples to the sink's rate and
+// queues the result. The mixer sums all active voices and hands the
+// mix to the sink in blocks.
+// The sink runs at the rate of the lowest-numbered active voice, so
+// the first voice created should be the "main" one (music).
+// The sink's own gain should be left at 1.0.
+// A voice whose generator stops keeps playing what it has queued
+// ("draining"); the sink stops when all voices have played out.
+// So loop() must be called until then, also when no generator runs.
+
+class AudioOutputMixer;
+
+class AudioOutputMixerStub : public AudioOutput
+{
+  public:
+    AudioOutputMixerStub(AudioOutputMixer *parent, int id);
+    virtual ~AudioOutputMixerStub() override {};
+    virtual bool SetRate(int hz) override;
+    virtual bool begin() override;
+    virtual bool ConsumeSample(int16_t sample[2]) override;
+    virtual uint16_t ConsumeSamples(int16_t *samples, uint16_t count) override;
+    virtual bool stop() override;
+    virtual bool loop() override;
+
+    bool isActive() { return active; }
+
+    static constexpr int ringLen = 512;   // frames
+
+  protected:
+    friend class AudioOutputMixer;
+    void Reset();
+    void Put(int16_t sample[2]);
+
+    AudioOutputMixer *parent;
+    int id;
+    bool active;
+    bool draining;      // Stopped, ring still being played out
+
+    int16_t ring[ringLen * 2];
+    uint16_t rd, wr, cnt;
+
+    // Linear interpolation resampler, 16.16 fixed point
+    uint32_t step;
+    uint32_t frac;
+    uint16_t maxOut;    // Max output frames per input frame
+    int16_t prev[2];
+};
+
+class AudioOutputMixer : public AudioOutput
+{
+  public:
+    AudioOutputMixer(AudioOutput *sink);
+    virtual ~AudioOutputMixer() override;
+    AudioOutputMixerStub *NewInput();
+    virtual bool begin() override { return true; }
+    virtual bool stop() override;
+    virtual bool loop() override;
+
+    static constexpr int maxVoices = 3;
+    static constexpr int mixLen = 64;     // frames per mix block
+
+  protected:
+    friend class AudioOutputMixerStub;
+    bool VoiceBegin(int id);
+    void VoiceStop(int id);
+    void UpdateRates();
+
+    AudioOutput *sink;
+    bool sinkOn;
+    int sinkRate;
+    int numVoices;
+    AudioOutputMixerStub *voice[maxVoices];
+
+    int16_t mixBuf[mixLen * 2];
+    uint16_t mixPtr;
+    uint16_t mixCnt;
+};
+
+#endif
+
@@ -46,7 +46,20 @@ extern int stackfree();
 /* Define if your MIPS CPU supports a 2-operand MADD16 instruction. */
 /* #undef HAVE_MADD16_ASM */
 
-#define FPM_DEFAULT
+#if defined(ESP32) && defined(__XTENSA__)
+# define FPM_XTENSA
+#else
+# define FPM_DEFAULT
+#endif
+
+/* Place the hot synthesis and IMDCT routines in IRAM on ESP32; this
+   avoids flash cache misses while WiFi and SD compete for the cache. */
+#if defined(ESP32)
+# include "esp_attr.h"
+# define MAD_IRAM IRAM_ATTR
+#else
+# define MAD_IRAM
+#endif
 
 /* Define if your MIPS CPU supports a 2-operand MADD instruction. */
 #define HAVE_MADD_ASM 1
@@ -1595,7 +1595,7 @@ enum mad_error III_stereo(mad_fixed_t xr[2][576],
    NAME:	III_aliasreduce()
    DESCRIPTION:	perform frequency line alias reduction
 */
-static
+static MAD_IRAM
 void III_aliasreduce(mad_fixed_t xr[576], int lines)
 {
   mad_fixed_t const *bound;
@@ -1635,7 +1635,7 @@ void III_aliasreduce(mad_fixed_t xr[576], int lines)
 void III_imdct_l(mad_fixed_t const [18], mad_fixed_t [36], unsigned int);
 # else
 #  if 1
-static
+static MAD_IRAM
 void fastsdct(mad_fixed_t const x[9], mad_fixed_t y[18])
 {
   mad_fixed_t a0,  a1,  a2,  a3,  a4,  a5,  a6,  a7,  a8,  a9,  a10, a11, a12;
@@ -2122,7 +2122,7 @@ void imdct36(mad_fixed_t const X[18], mad_fixed_t x[36])
    NAME:	III_imdct_l()
    DESCRIPTION:	perform IMDCT and windowing for long blocks
 */
-static
+static MAD_IRAM
 void III_imdct_l(mad_fixed_t const X[18], mad_fixed_t z[36],
                  unsigned int block_type)
 {
@@ -2210,7 +2210,7 @@ void III_imdct_l(mad_fixed_t const X[18], mad_fixed_t z[36],
    NAME:	III_imdct_s()
    DESCRIPTION:	perform IMDCT and windowing for short blocks
 */
-static
+static MAD_IRAM
 void III_imdct_s(mad_fixed_t const X[18], mad_fixed_t z[36])
 {
   mad_fixed_t y[36], *yptr;
@@ -2293,7 +2293,7 @@ void III_imdct_s(mad_fixed_t const X[18], mad_fixed_t z[36])
    NAME:	III_overlap()
    DESCRIPTION:	perform overlap-add of windowed IMDCT outputs
 */
-static
+static MAD_IRAM
 void III_overlap(mad_fixed_t const output[36], mad_fixed_t overlap[18],
                  mad_fixed_t sample[18][32], unsigned int sb)
 {
@@ -2382,7 +2382,7 @@ void III_overlap_z(mad_fixed_t overlap[18],
    NAME:	III_freqinver()
    DESCRIPTION:	perform subband frequency inversion for odd sample lines
 */
-static
+static MAD_IRAM
 void III_freqinver(mad_fixed_t sample[18][32], unsigned int sb)
 {
   unsigned int i;
@@ -462,6 +462,31 @@ mad_fixed_t mad_f_mul_inline(mad_fixed_t x, mad_fixed_t y)
 
 #  define MAD_F_SCALEBITS  MAD_F_FRACBITS
 
+/* --- Xtensa -------------------------------------------------------------- */
+
+# elif defined(FPM_XTENSA)
+
+/*
+ * ESP32 (Xtensa LX6/LX7 with MUL32_HIGH). The 64-bit product is written
+ * in C so that GCC emits MULL/MULSH directly, and drops the MULL wherever
+ * only the high word is used (the OPT_DCTO path in synth.c). This is as
+ * accurate as FPM_64BIT and costs one or two cycles per multiply.
+ */
+#  define MAD_F_MLX(hi, lo, x, y)  \
+    ({ mad_fixed64_t __p = (mad_fixed64_t) (x) * (y);  \
+       (lo) = (mad_fixed64lo_t) __p;  \
+       (hi) = (mad_fixed64hi_t) (__p >> 32);  \
+    })
+
+#  define MAD_F_MLA(hi, lo, x, y)  \
+    ({ mad_fixed64_t __a = ((mad_fixed64_t) (hi) << 32) | (lo);  \
+       __a += (mad_fixed64_t) (x) * (y);  \
+       (lo) = (mad_fixed64lo_t) __a;  \
+       (hi) = (mad_fixed64hi_t) (__a >> 32);  \
+    })
+
+#  define MAD_F_SCALEBITS  MAD_F_FRACBITS
+
 /* --- Default ------------------------------------------------------------- */
 
 # elif defined(FPM_DEFAULT)
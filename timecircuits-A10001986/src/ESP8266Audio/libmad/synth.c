@@ -140,7 +140,7 @@ void mad_synth_mute(struct mad_synth *synth)
    NAME:	dct32()
    DESCRIPTION:	perform fast in[32]->out[32] DCT
 */
-static
+static MAD_IRAM
 void dct32(mad_fixed_t const in[32], unsigned int slot,
            mad_fixed_t lo[16][8], mad_fixed_t hi[16][8])
 {
@@ -575,7 +575,7 @@ void synth_full(struct mad_synth *, struct mad_frame const *,
    NAME:	synth->full()
    DESCRIPTION:	perform full frequency PCM synthesis
 */
-static
+static MAD_IRAM
 enum mad_flow synth_full(struct mad_synth *synth, struct mad_frame const *frame,
                 unsigned int nch, unsigned int startns, unsigned int endns,
                 enum mad_flow (*output_func)(void *s, struct mad_header const *, struct mad_pcm *), void *cbdata)
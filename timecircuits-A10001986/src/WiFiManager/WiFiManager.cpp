@@ -12,10 +12,21 @@
 
 #include "WiFiManager.h"
 
+#ifdef WM_GZASSETS
+#include "wm_assets.h"
+
+// Asset URLs carry the ETag, so that a firmware update busts the cache
+const char R_assetjs[]      PROGMEM = "/wm.js";
+const char R_assetcss[]     PROGMEM = "/wm.css";
+const char HTTP_HEAD_ASSETS[] PROGMEM = "<script src='/wm.js?v=" WM_JS_ETAG "'></script>"
+                                        "<link rel='stylesheet' href='/wm.css?v=" WM_CSS_ETAG "'>";
+#endif
+
 #if defined(ESP8266) || defined(ESP32)
 
 #ifdef ESP32
 uint8_t WiFiManager::_lastconxresulttmp = WL_IDLE_STATUS;
+uint32_t WiFiManagerParameter::_allocCount = 0;
 #endif
 
 /**
@@ -94,6 +105,7 @@ void WiFiManagerParameter::setValue(const char *defaultValue, int length) {
       delete[] _value;
     }
     _value  = new char[_length + 1];  
+    _allocCount++;
   }
 
   memset(_value, 0, _length + 1); // explicit null
@@ -102,6 +114,9 @@ void WiFiManagerParameter::setValue(const char *defaultValue, int length) {
     strncpy(_value, defaultValue, _length);
   }
 }
+uint32_t WiFiManagerParameter::getAllocCount() {
+  return _allocCount;
+}
 const char* WiFiManagerParameter::getValue() const {
   // Serial.println(printf("Address of _value is %p\n", (void *)_value)); 
   return _value;
@@ -388,6 +403,191 @@ boolean WiFiManager::autoConnect(char const *apName, char const *apPassword) {
   return res;
 }
 
+/**
+ * Non-blocking variant of autoConnect()
+ *
+ * Does what autoConnect() does, but instead of waiting for the
+ * connection result (which might take _connectTimeout times
+ * _connectRetries), all waits are states which autoConnectPoll()
+ * advances. Call autoConnectPoll() from the main loop until it
+ * returns something other than WM_AC_PENDING.
+ */
+#define WM_ACS_IDLE     0
+#define WM_ACS_PREP     1   // idle time before (re)connect
+#define WM_ACS_BEGIN    2   // STA enabled, waiting to call begin()
+#define WM_ACS_WAIT     3   // waiting for connection result
+#define WM_ACS_DONE     4   // already connected
+#define WM_ACS_FAIL     5   // fall back to config portal
+
+void WiFiManager::autoConnectStart(char const *apName, char const *apPassword) {
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(F("AutoConnect (async)"));
+  #endif
+
+  _acAPName = apName;
+  _acAPPass = apPassword ? apPassword : "";
+
+  #ifdef ESP32
+  setupHostname(true);
+
+  if(_hostname != ""){
+    // disable wifi if already on
+    if(WiFi.getMode() & WIFI_STA){
+      WiFi.mode(WIFI_OFF);
+      int timeout = millis()+1200;
+      // async loop for mode change
+      while(WiFi.getMode()!= WIFI_OFF && millis()<timeout){
+        delay(0);
+      }
+    }
+  }
+  #endif
+
+  _startconn = millis();
+  _begin();
+
+  if(!WiFi.enableSTA(true)){
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_ERROR,F("[FATAL] Unable to enable wifi!"));
+    #endif
+    _acState = WM_ACS_FAIL;
+    return;
+  }
+
+  WiFiSetCountry();
+
+  #ifdef ESP32
+  if(esp32persistent) WiFi.persistent(false); // disable persistent for esp32 after esp_wifi_start or else saves wont work
+  #endif
+
+  _usermode = WIFI_STA;
+
+  WiFi_autoReconnect();
+
+  #ifdef ESP8266
+  if(_hostname != ""){
+    setupHostname(true);
+  }
+  #endif
+
+  if (WiFi.status() == WL_CONNECTED){
+    setSTAConfig();
+    _acState = WM_ACS_DONE;
+    return;
+  }
+
+  if (_defaultssid == "" && !WiFi_hasAutoConnect()) {
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(F("No wifi saved, skipping"));
+    #endif
+    _acState = WM_ACS_FAIL;
+    return;
+  }
+
+  setSTAConfig();
+  if(_cleanConnect) WiFi_Disconnect();
+
+  _acRetry = 1;
+  _acState = WM_ACS_PREP;
+  _acNow = millis();
+  _acWait = (_connectRetries > 1 && _aggresiveReconn) ? 1000 : 0;
+}
+
+int8_t WiFiManager::autoConnectPoll() {
+  uint8_t status;
+  unsigned long timeout;
+
+  switch(_acState) {
+
+  case WM_ACS_PREP:
+    if(millis() - _acNow < _acWait) return WM_AC_PENDING;
+    #ifdef WM_DEBUG_LEVEL
+    if(_connectRetries > 1){
+      DEBUG_WM(F("Connect Wifi, ATTEMPT #"),(String)_acRetry+" of "+(String)_connectRetries);
+    }
+    #endif
+    if (_defaultssid != "") {
+      wifiConnectNew(_defaultssid,_defaultpass,true);
+      _acState = WM_ACS_WAIT;
+    } else {
+      WiFi_enableSTA(true,storeSTAmode);
+      _acState = WM_ACS_BEGIN;
+    }
+    _acNow = millis();
+    return WM_AC_PENDING;
+
+  case WM_ACS_BEGIN:
+    if(millis() - _acNow < 500) return WM_AC_PENDING;   // see wifiConnectDefault()
+    if(!WiFi.begin()) {
+      #ifdef WM_DEBUG_LEVEL
+      DEBUG_WM(DEBUG_ERROR,F("[ERROR] wifi begin failed"));
+      #endif
+    }
+    _acState = WM_ACS_WAIT;
+    _acNow = millis();
+    return WM_AC_PENDING;
+
+  case WM_ACS_WAIT:
+    status = WiFi.status();
+    if(status == WL_CONNECTED) {
+      updateConxResult(status);
+      _acState = WM_ACS_DONE;
+      break;
+    }
+    timeout = _defaultssid != "" && _saveTimeout ? _saveTimeout : _connectTimeout;
+    if(!timeout) timeout = 10000;
+    if(status != WL_CONNECT_FAILED && millis() - _acNow < timeout) {
+      return WM_AC_PENDING;
+    }
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_VERBOSE,F("Connection result:"),getWLStatusString(status));
+    #endif
+    if(++_acRetry <= _connectRetries) {
+      _acState = WM_ACS_PREP;
+      _acNow = millis();
+      _acWait = _aggresiveReconn ? 1000 : 0;
+      return WM_AC_PENDING;
+    }
+    if(status != WL_SCAN_COMPLETED){
+      updateConxResult(status);
+    }
+    _acState = WM_ACS_FAIL;
+    break;
+
+  case WM_ACS_DONE:
+  case WM_ACS_FAIL:
+    break;
+
+  default:
+    return WM_AC_FAILED;
+  }
+
+  if(_acState == WM_ACS_DONE) {
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(F("AutoConnect: SUCCESS"));
+    DEBUG_WM(DEBUG_VERBOSE,F("Connected in"),(String)((millis()-_startconn)) + " ms");
+    DEBUG_WM(F("STA IP Address:"),WiFi.localIP());
+    #endif
+    _lastconxresult = WL_CONNECTED;
+    _acState = WM_ACS_IDLE;
+    return WM_AC_CONNECTED;
+  }
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(F("AutoConnect: FAILED for "),(String)((millis()-_startconn)) + " ms");
+  #endif
+
+  _acState = WM_ACS_IDLE;
+
+  if (!_enableConfigPortal) {
+    return WM_AC_FAILED;
+  }
+
+  startConfigPortal(_acAPName.c_str(), _acAPPass.c_str());
+
+  return WM_AC_CP;
+}
+
 bool WiFiManager::setupHostname(bool restart){
   if(_hostname == "") {
     #ifdef WM_DEBUG_LEVEL
@@ -652,6 +852,14 @@ void WiFiManager::setupHTTPServer(){
   server->on(WM_G(R_close),      std::bind(&WiFiManager::handleClose, this));
   server->on(WM_G(R_erase),      std::bind(&WiFiManager::handleErase, this, false));
   server->on(WM_G(R_status),     std::bind(&WiFiManager::handleWiFiStatus, this));
+  #ifdef WM_GZASSETS
+  server->on(WM_G(R_assetjs),    HTTP_GET, std::bind(&WiFiManager::handleAssetJS, this));
+  server->on(WM_G(R_assetcss),   HTTP_GET, std::bind(&WiFiManager::handleAssetCSS, this));
+  {
+    const char *hdrs[] = { "If-None-Match" };
+    server->collectHeaders(hdrs, 1);
+  }
+  #endif
   server->onNotFound (std::bind(&WiFiManager::handleNotFound, this));
   
   server->on(WM_G(R_update), std::bind(&WiFiManager::handleUpdate, this));
@@ -1275,8 +1483,12 @@ String WiFiManager::getHTTPHead(String title){
   String page;
   page += FPSTR(HTTP_HEAD_START);
   page.replace(FPSTR(T_v), title);
+  #ifdef WM_GZASSETS
+  page += FPSTR(HTTP_HEAD_ASSETS);
+  #else
   page += FPSTR(HTTP_SCRIPT);
   page += FPSTR(HTTP_STYLE);
+  #endif
   page += _customHeadElement;
 
   if(_bodyClass != ""){
@@ -1293,8 +1505,112 @@ String WiFiManager::getHTTPHead(String title){
 
 void WiFiManager::HTTPSend(const String &content){
   server->send(200, FPSTR(HTTP_HEAD_CT), content);
+  notePageServed();
+}
+
+// Page content is still allocated at this point, so the free heap
+// reflects the peak demand of building a page
+void WiFiManager::notePageServed(){
+  uint32_t fh = ESP.getFreeHeap();
+  _pagesServed++;
+  if(!_pageMinHeap || fh < _pageMinHeap) _pageMinHeap = fh;
 }
 
+/**
+ * Chunked page output: Pages are assembled in a fixed-size buffer
+ * and sent out using chunked transfer encoding whenever the buffer
+ * is full, instead of building the entire page in a String first.
+ * HTTPSendStart() sends the response header and the page head,
+ * HTTPSendEnd() flushes the buffer and terminates the response.
+ */
+void WiFiManager::HTTPSendStart(String title){
+  _chunkLen = 0;
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, FPSTR(HTTP_HEAD_CT), "");
+
+  String str = FPSTR(HTTP_HEAD_START);
+  str.replace(FPSTR(T_v), title);
+  HTTPSendChunk(str);
+  #ifdef WM_GZASSETS
+  HTTPSendChunk_P(HTTP_HEAD_ASSETS);
+  #else
+  HTTPSendChunk_P(HTTP_SCRIPT);
+  HTTPSendChunk_P(HTTP_STYLE);
+  #endif
+  HTTPSendChunk(_customHeadElement, strlen(_customHeadElement));
+
+  if(_bodyClass != ""){
+    str = FPSTR(HTTP_HEAD_END);
+    str.replace(FPSTR(T_c), _bodyClass); // add class str
+    HTTPSendChunk(str);
+  }
+  else {
+    HTTPSendChunk_P(HTTP_HEAD_END);
+  }
+}
+
+void WiFiManager::HTTPSendChunk(const char *content, size_t len){
+  while(len) {
+    size_t n = WM_CHUNKSIZE - _chunkLen;
+    if(n > len) n = len;
+    memcpy(_chunkBuf + _chunkLen, content, n);
+    _chunkLen += n;
+    content += n;
+    len -= n;
+    if(_chunkLen == WM_CHUNKSIZE) {
+      server->sendContent(_chunkBuf, _chunkLen);
+      _chunkLen = 0;
+    }
+  }
+}
+
+void WiFiManager::HTTPSendChunk(const String &content){
+  HTTPSendChunk(content.c_str(), content.length());
+}
+
+void WiFiManager::HTTPSendChunk_P(PGM_P content){
+  // On the ESP32, PROGMEM is memory mapped
+  HTTPSendChunk(content, strlen_P(content));
+}
+
+void WiFiManager::HTTPSendEnd(){
+  if(_chunkLen) {
+    server->sendContent(_chunkBuf, _chunkLen);
+    _chunkLen = 0;
+  }
+  server->sendContent("");    // terminating chunk
+  notePageServed();
+}
+
+#ifdef WM_GZASSETS
+/**
+ * Static assets: Stored gzip-compressed in flash, sent as-is with
+ * "Content-Encoding: gzip". Since the URL carries the ETag, browsers
+ * may cache them forever; a conditional request is answered with 304.
+ */
+void WiFiManager::sendGzAsset(PGM_P mimeType, const uint8_t *data, size_t len, const char *etag){
+  String tag = "\"";
+  tag += etag;
+  tag += "\"";
+  server->sendHeader(F("Cache-Control"), F("public, max-age=31536000, immutable"));
+  server->sendHeader(F("ETag"), tag);
+  if(server->header(F("If-None-Match")) == tag){
+    server->send(304);
+    return;
+  }
+  server->sendHeader(F("Content-Encoding"), F("gzip"));
+  server->send_P(200, mimeType, (PGM_P)data, len);
+}
+
+void WiFiManager::handleAssetJS(){
+  sendGzAsset(PSTR("application/javascript"), wm_js_gz, sizeof(wm_js_gz), WM_JS_ETAG);
+}
+
+void WiFiManager::handleAssetCSS(){
+  sendGzAsset(PSTR("text/css"), wm_css_gz, sizeof(wm_css_gz), WM_CSS_ETAG);
+}
+#endif
+
 /** 
  * HTTPD handler for page requests
  */
@@ -1356,19 +1672,21 @@ void WiFiManager::handleWifi(boolean scan) {
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Wifi"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titlewifi)); // @token titlewifi
   if (scan) {
     #ifdef WM_DEBUG_LEVEL
     // DEBUG_WM(DEBUG_DEV,"refresh flag:",server->hasArg(F("refresh")));
     #endif
     WiFi_scanNetworks(server->hasArg(F("refresh")),false); //wifiscan, force if arg refresh
-    page += getScanItemOut();
+  }
+  HTTPSendStart(FPSTR(S_titlewifi)); // @token titlewifi
+  if (scan) {
+    getScanItemOut(true);
   }
   String pitem = "";
 
   pitem = FPSTR(HTTP_FORM_START);
   pitem.replace(FPSTR(T_v), F("wifisave")); // set form action
-  page += pitem;
+  HTTPSendChunk(pitem);
 
   pitem = FPSTR(HTTP_FORM_WIFI);
   pitem.replace(FPSTR(T_v), WiFi_SSID());
@@ -1383,21 +1701,23 @@ void WiFiManager::handleWifi(boolean scan) {
     pitem.replace(FPSTR(T_p),"");    
   }
 
-  page += pitem;
+  HTTPSendChunk(pitem);
 
-  page += getStaticOut();
-  page += FPSTR(HTTP_FORM_WIFI_END);
+  HTTPSendChunk(getStaticOut());
+  HTTPSendChunk_P(HTTP_FORM_WIFI_END);
   if(_paramsInWifi && _paramsCount>0){
-    page += FPSTR(HTTP_FORM_PARAM_HEAD);
-    page += getParamOut();
+    HTTPSendChunk_P(HTTP_FORM_PARAM_HEAD);
+    getParamOut(true);
   }
-  page += FPSTR(HTTP_FORM_END);
-  page += FPSTR(HTTP_SCAN_LINK);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  reportStatus(page);
-  page += FPSTR(HTTP_END);
+  HTTPSendChunk_P(HTTP_FORM_END);
+  HTTPSendChunk_P(HTTP_SCAN_LINK);
+  if(_showBack) HTTPSendChunk_P(HTTP_BACKBTN);
+  pitem = "";
+  reportStatus(pitem);
+  HTTPSendChunk(pitem);
+  HTTPSendChunk_P(HTTP_END);
 
-  HTTPSend(page);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent config page"));
@@ -1412,21 +1732,23 @@ void WiFiManager::handleParam(){
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Param"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleparam)); // @token titlewifi
+  HTTPSendStart(FPSTR(S_titleparam)); // @token titlewifi
 
   String pitem = "";
 
   pitem = FPSTR(HTTP_FORM_START);
   pitem.replace(FPSTR(T_v), F("paramsave"));
-  page += pitem;
+  HTTPSendChunk(pitem);
 
-  page += getParamOut();
-  page += FPSTR(HTTP_FORM_END);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  reportStatus(page);
-  page += FPSTR(HTTP_END);
+  getParamOut(true);
+  HTTPSendChunk_P(HTTP_FORM_END);
+  if(_showBack) HTTPSendChunk_P(HTTP_BACKBTN);
+  pitem = "";
+  reportStatus(pitem);
+  HTTPSendChunk(pitem);
+  HTTPSendChunk_P(HTTP_END);
 
-  HTTPSend(page);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent param page"));
@@ -1551,7 +1873,7 @@ bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
     return false;
 }
 
-String WiFiManager::WiFiManager::getScanItemOut(){
+String WiFiManager::WiFiManager::getScanItemOut(bool stream){
     String page;
 
     if(!_numNetworks) WiFi_scanNetworks(); // scan in case this gets called before any scans
@@ -1656,7 +1978,8 @@ String WiFiManager::WiFiManager::getScanItemOut(){
           #ifdef WM_DEBUG_LEVEL
           DEBUG_WM(DEBUG_DEV,item);
           #endif
-          page += item;
+          if(stream) HTTPSendChunk(item);
+          else       page += item;
           delay(0);
         } else {
           #ifdef WM_DEBUG_LEVEL
@@ -1668,6 +1991,11 @@ String WiFiManager::WiFiManager::getScanItemOut(){
       page += FPSTR(HTTP_BR);
     }
 
+    if(stream) {
+      HTTPSendChunk(page);
+      page = "";
+    }
+
     return page;
 }
 
@@ -1710,7 +2038,7 @@ String WiFiManager::getStaticOut(){
   return page;
 }
 
-String WiFiManager::getParamOut(){
+String WiFiManager::getParamOut(bool stream){
   String page;
 
   #ifdef WM_DEBUG_LEVEL
@@ -1779,7 +2107,8 @@ String WiFiManager::getParamOut(){
         pitem = _params[i]->getCustomHTML();
       }
 
-      page += pitem;
+      if(stream) HTTPSendChunk(pitem);
+      else       page += pitem;
     }
   }
 
@@ -1974,8 +2303,10 @@ void WiFiManager::handleInfo() {
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Info"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleinfo)); // @token titleinfo
+  HTTPSendStart(FPSTR(S_titleinfo)); // @token titleinfo
+  String page;
   reportStatus(page);
+  HTTPSendChunk(page);
 
   uint16_t infos = 0;
 
@@ -2050,27 +2381,26 @@ void WiFiManager::handleInfo() {
   #endif
 
   for(size_t i=0; i<infos;i++){
-    if(infoids[i] != NULL) page += getInfoData(infoids[i]);
+    if(infoids[i] != NULL) HTTPSendChunk(getInfoData(infoids[i]));
   }
-  page += F("</dl>");
+  HTTPSendChunk_P(PSTR("</dl><h3>About</h3><hr><dl>"));
 
-  page += F("<h3>About</h3><hr><dl>");
-  page += getInfoData("aboutver");
-  page += getInfoData("aboutarduinover");
-  page += getInfoData("aboutidfver");
-  page += getInfoData("aboutdate");
-  page += F("</dl>");
+  HTTPSendChunk(getInfoData("aboutver"));
+  HTTPSendChunk(getInfoData("aboutarduinover"));
+  HTTPSendChunk(getInfoData("aboutidfver"));
+  HTTPSendChunk(getInfoData("aboutdate"));
+  HTTPSendChunk_P(PSTR("</dl>"));
 
   if(_showInfoUpdate){
-    page += HTTP_PORTAL_MENU[8];
-    page += HTTP_PORTAL_MENU[9];
+    HTTPSendChunk_P(HTTP_PORTAL_MENU[8]);
+    HTTPSendChunk_P(HTTP_PORTAL_MENU[9]);
   }
-  if(_showInfoErase) page += FPSTR(HTTP_ERASEBTN);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  page += FPSTR(HTTP_HELP);
-  page += FPSTR(HTTP_END);
+  if(_showInfoErase) HTTPSendChunk_P(HTTP_ERASEBTN);
+  if(_showBack) HTTPSendChunk_P(HTTP_BACKBTN);
+  HTTPSendChunk_P(HTTP_HELP);
+  HTTPSendChunk_P(HTTP_END);
 
-  HTTPSend(page);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent info page"));
@@ -2845,6 +3175,25 @@ void WiFiManager::setPreOtaUpdateCallback( std::function<void()> func ) {
   _preotaupdatecallback = func;
 }
 
+/**
+ * setOtaProgressCallback, set a callback to fire repeatedly while an OTA image is received
+ * @access public
+ * @param {[type]} void (*func)(void)
+ */
+void WiFiManager::setOtaProgressCallback( std::function<void()> func ) {
+  _otaprogresscallback = func;
+}
+
+/**
+ * setPostOtaUpdateCallback, set a callback to fire after a successful OTA update;
+ * if set, WM does not reboot, the callback is responsible for rebooting
+ * @access public
+ * @param {[type]} void (*func)(bool rebootNow)
+ */
+void WiFiManager::setPostOtaUpdateCallback( std::function<void(bool)> func ) {
+  _postotaupdatecallback = func;
+}
+
 /**
  * setConfigPortalTimeoutCallback, set a callback to config portal is timeout
  * @access public
@@ -3098,6 +3447,22 @@ bool WiFiManager::getWebPortalActive(){
   return webPortalActive;
 }
 
+unsigned long WiFiManager::getWebPortalAccessed(){
+  return _webPortalAccessed;
+}
+
+uint32_t WiFiManager::getPagesServed(){
+  return _pagesServed;
+}
+
+uint32_t WiFiManager::getPageMinHeap(){
+  return _pageMinHeap;
+}
+
+uint32_t WiFiManager::getOtaStackFree(){
+  return _otaStackFree;
+}
+
 
 String WiFiManager::getWiFiHostname(){
   #ifdef ESP32
@@ -3908,21 +4273,41 @@ void WiFiManager::handleUpdating(){
         #endif
         error = true;
         Update.end(); // Not sure the best way to abort, I think client will keep sending..
-  	}
+  	} else {
+        // MD5 of image can be given as url arg (/u?md5=xxx); the image's own 
+        // SHA256 (if appended by the build) is verified by Update.end()
+        if (server->hasArg(F("md5"))) {
+          Update.setMD5(server->arg(F("md5")).c_str());
+        }
+        #ifdef WM_OTA_TASK
+        otaStart();
+        #endif
+    }
 	}
   // UPLOAD WRITE
   else if (upload.status == UPLOAD_FILE_WRITE) {
 		// Serial.print(".");
+    #ifdef WM_OTA_TASK
+		if (!otaWrite(upload.buf, upload.currentSize)) {
+    #else
 		if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
+    #endif
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(DEBUG_ERROR,F("[ERROR] OTA Update WRITE ERROR"), Update.getError());
 			//Update.printError(Serial); // write failure
       #endif
       error = true;
 		}
+    if (_otaprogresscallback != NULL) {
+      _otaprogresscallback();  // @CALLBACK
+    }
 	}
   // UPLOAD FILE END
   else if (upload.status == UPLOAD_FILE_END) {
+    #ifdef WM_OTA_TASK
+    otaFlush();
+    otaStop();
+    #endif
 		if (Update.end(true)) { // true to set the size to the current progress
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(DEBUG_VERBOSE,F("\n\n[OTA] OTA FILE END bytes: "), upload.totalSize);
@@ -3936,7 +4321,10 @@ void WiFiManager::handleUpdating(){
 	}
   // UPLOAD ABORT
   else if (upload.status == UPLOAD_FILE_ABORTED) {
-		Update.end();
+    #ifdef WM_OTA_TASK
+    otaStop();
+    #endif
+		Update.abort();
 		DEBUG_WM(F("[OTA] Update was aborted"));
     error = true;
   }
@@ -3965,17 +4353,149 @@ void WiFiManager::handleUpdateDone() {
 		DEBUG_WM(F("[OTA] update failed"));
 	}
 	else {
-		page += FPSTR(HTTP_UPDATE_SUCCESS);
+		page += FPSTR((_postotaupdatecallback != NULL && !server->hasArg(F("rbnow"))) ? HTTP_UPDATE_SCHED : HTTP_UPDATE_SUCCESS);
 		DEBUG_WM(F("[OTA] update ok"));
 	}
 	page += FPSTR(HTTP_END);
 
 	HTTPSend(page);
 
+  // Let the application decide when to reboot
+  if (!Update.hasError() && _postotaupdatecallback != NULL) {
+    _postotaupdatecallback(server->hasArg(F("rbnow")));  // @CALLBACK
+    return;
+  }
+
 	delay(1000); // send page
 	if (!Update.hasError()) {
 		ESP.restart();
 	}
 }
 
+#ifdef WM_OTA_TASK
+/*
+ * OTA image writer
+ * Received data is collected in two buffers; full buffers are written to
+ * flash by a task on core 0 while the web server fills the other one. 
+ * Flash erase/write then no longer stalls reception (and whatever the 
+ * application does in its progress callback). If the task cannot be 
+ * created, data is written directly.
+ */
+#define WM_OTA_TASK_STACK  4096
+#define WM_OTA_TASK_PRIO   1      // below audio (3) and upload writer (2)
+
+typedef struct {
+  int    idx;     // buffer index; -1 = stop task
+  size_t len;
+} wmOtaChunk;
+
+void WiFiManager::otaWriterTask(void *arg) {
+  WiFiManager *wm = (WiFiManager *)arg;
+  wmOtaChunk c;
+
+  for(;;) {
+    xQueueReceive(wm->_otaFullQ, &c, portMAX_DELAY);
+    if(c.idx < 0) break;
+    // On error, Update ignores further writes, and hasError() is set
+    if(!Update.hasError()) Update.write(wm->_otaBuf[c.idx], c.len);
+    xQueueSend(wm->_otaFreeQ, &c.idx, portMAX_DELAY);
+  }
+
+  wm->_otaStackFree = uxTaskGetStackHighWaterMark(NULL);
+  xSemaphoreGive(wm->_otaDoneSem);
+  vTaskDelete(NULL);
+}
+
+bool WiFiManager::otaStart() {
+  int i;
+
+  _otaCur = 0;
+  _otaFill = 0;
+  _otaTask = NULL;
+
+  for(i = 0; i < 2; i++) {
+    _otaBuf[i] = (uint8_t *)malloc(WM_OTA_BUFSIZE);
+  }
+
+  if(_otaBuf[0] && _otaBuf[1]) {
+    _otaFullQ = xQueueCreate(2, sizeof(wmOtaChunk));
+    _otaFreeQ = xQueueCreate(2, sizeof(int));
+    _otaDoneSem = xSemaphoreCreateBinary();
+    if(_otaFullQ && _otaFreeQ && _otaDoneSem) {
+      i = 1;
+      xQueueSend(_otaFreeQ, &i, 0);
+      if(xTaskCreatePinnedToCore(otaWriterTask, "otawr", WM_OTA_TASK_STACK, this,
+                                 WM_OTA_TASK_PRIO, &_otaTask, 0) != pdPASS) {
+        _otaTask = NULL;
+      }
+    }
+  }
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("[OTA] writer task"), _otaTask ? "started" : "failed");
+  #endif
+
+  if(!_otaTask) {
+    otaStop();
+    return false;
+  }
+
+  return true;
+}
+
+bool WiFiManager::otaFlush() {
+  if(!_otaFill)
+    return !Update.hasError();
+
+  wmOtaChunk c = { _otaCur, _otaFill };
+  xQueueSend(_otaFullQ, &c, portMAX_DELAY);
+  // Wait for a free buffer; blocks only if flash is slower than WiFi
+  xQueueReceive(_otaFreeQ, &_otaCur, portMAX_DELAY);
+  _otaFill = 0;
+
+  return !Update.hasError();
+}
+
+bool WiFiManager::otaWrite(const uint8_t *buf, size_t len) {
+  size_t n;
+
+  if(!_otaTask)
+    return (Update.write((uint8_t *)buf, len) == len);
+
+  while(len) {
+    n = WM_OTA_BUFSIZE - _otaFill;
+    if(n > len) n = len;
+    memcpy(_otaBuf[_otaCur] + _otaFill, buf, n);
+    _otaFill += n;
+    buf += n;
+    len -= n;
+    if(_otaFill == WM_OTA_BUFSIZE) {
+      if(!otaFlush()) return false;
+    }
+  }
+
+  return true;
+}
+
+// Stop task (after writing what was queued) and free resources
+void WiFiManager::otaStop() {
+  if(_otaTask) {
+    wmOtaChunk c = { -1, 0 };
+    xQueueSend(_otaFullQ, &c, portMAX_DELAY);
+    xSemaphoreTake(_otaDoneSem, portMAX_DELAY);
+    _otaTask = NULL;
+  }
+  for(int i = 0; i < 2; i++) {
+    if(_otaBuf[i]) free(_otaBuf[i]);
+    _otaBuf[i] = NULL;
+  }
+  if(_otaFullQ)   vQueueDelete(_otaFullQ);
+  if(_otaFreeQ)   vQueueDelete(_otaFreeQ);
+  if(_otaDoneSem) vSemaphoreDelete(_otaDoneSem);
+  _otaFullQ = _otaFreeQ = NULL;
+  _otaDoneSem = NULL;
+  _otaFill = 0;
+}
+#endif
+
 #endif
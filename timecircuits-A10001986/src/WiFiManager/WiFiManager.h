@@ -68,8 +68,17 @@
 
 #define WM_WEBSERVERSHIM      // use webserver shim lib
 
+#define WM_GZASSETS           // serve css/js as external, gzip-compressed and cacheable files (see assets/mkassets.py)
+
 #define WM_G(string_literal)  (String(FPSTR(string_literal)).c_str())
 
+#define WM_CHUNKSIZE          1024  // chunk size for streamed (chunked) portal pages
+
+#ifdef ESP32
+#define WM_OTA_TASK           // write OTA images to flash from a background task (double-buffered)
+#endif
+#define WM_OTA_BUFSIZE        (8 * 1024)  // multiple of flash sector size
+
 #ifdef ESP8266
 
     extern "C" {
@@ -224,6 +233,9 @@ class WiFiManagerParameter {
     virtual const char *getCustomHTML() const;
     void        setValue(const char *defaultValue, int length);
 
+    // number of value buffer (re)allocations, all parameters
+    static uint32_t getAllocCount();
+
   protected:
     void init(const char *id, const char *label, const char *defaultValue, int length, const char *custom, int labelPlacement);
 
@@ -234,12 +246,19 @@ class WiFiManagerParameter {
     char       *_value;
     int         _length;
     int         _labelPlacement;
+    static uint32_t _allocCount;
   protected:
     const char *_customHTML;
     friend class WiFiManager;
 };
 
 
+// autoConnectPoll() results
+#define WM_AC_PENDING   0   // still connecting
+#define WM_AC_CONNECTED 1   // connected
+#define WM_AC_CP        2   // connection failed, config portal started
+#define WM_AC_FAILED    -1  // connection failed, config portal disabled
+
 class WiFiManager
 {
   public:
@@ -252,6 +271,12 @@ class WiFiManager
     boolean       autoConnect();
     boolean       autoConnect(char const *apName, char const *apPassword = NULL);
 
+    // non-blocking autoConnect: autoConnectStart() initiates the connection,
+    // autoConnectPoll() must then be called repeatedly until it returns
+    // something else than WM_AC_PENDING
+    void          autoConnectStart(char const *apName, char const *apPassword = NULL);
+    int8_t        autoConnectPoll();
+
     //manually start the config portal, autoconnect does this automatically on connect failure
     boolean       startConfigPortal(); // auto generates apname
     boolean       startConfigPortal(char const *apName, char const *apPassword = NULL);
@@ -320,6 +345,12 @@ class WiFiManager
     //called just before doing OTA update
     void          setPreOtaUpdateCallback( std::function<void()> func );
 
+    //called repeatedly while an OTA image is received (keep the application alive)
+    void          setOtaProgressCallback( std::function<void()> func );
+
+    //called after a successful OTA update instead of rebooting; arg: immediate reboot requested
+    void          setPostOtaUpdateCallback( std::function<void(bool)> func );
+
     //called when config portal is timeout
     void          setConfigPortalTimeoutCallback( std::function<void()> func );
 
@@ -486,6 +517,16 @@ class WiFiManager
     // check if web portal is active (true)
     bool          getWebPortalActive();
 
+    // get ms time of last web portal page access (0 = never)
+    unsigned long getWebPortalAccessed();
+
+    // memory statistics: number of pages served, lowest free heap
+    // seen when finishing a page (0 = no page yet), stack high-water
+    // mark of the last OTA writer task (0 = never ran)
+    uint32_t      getPagesServed();
+    uint32_t      getPageMinHeap();
+    uint32_t      getOtaStackFree();
+
     // to preload autoconnect for test fixtures or other uses that skip esp sta config
     bool          preloadWiFi(String ssid, String pass);
 
@@ -503,6 +544,11 @@ class WiFiManager
     
     std::unique_ptr<WM_WebServer> server;
 
+    #ifdef WM_GZASSETS
+    // send a gzip-compressed static asset with ETag and Cache-Control headers
+    void          sendGzAsset(PGM_P mimeType, const uint8_t *data, size_t len, const char *etag);
+    #endif
+
   private:
     // vars
     std::vector<uint8_t> _menuIds;
@@ -526,6 +572,12 @@ class WiFiManager
     unsigned long _lastscan               = 0; // ms for timing wifi scans
     unsigned long _startscan              = 0; // ms for timing wifi scans
     unsigned long _startconn              = 0; // ms for timing wifi connects
+    uint8_t       _acState                = 0; // autoConnectStart/Poll state
+    uint8_t       _acRetry                = 0; // autoConnectStart/Poll attempt
+    unsigned long _acNow                  = 0; // autoConnectStart/Poll state timer
+    unsigned long _acWait                 = 0; // autoConnectStart/Poll state delay
+    String        _acAPName               = "";
+    String        _acAPPass               = "";
 
     // defaults
     const byte    DNS_PORT                = 53;
@@ -593,6 +645,20 @@ class WiFiManager
     const char*   _customHeadElement      = ""; // store custom head element html from user isnide <head>
     const char*   _customMenuHTML         = ""; // store custom head element html from user inside <>
     String        _bodyClass              = ""; // class to add to body
+    char          _chunkBuf[WM_CHUNKSIZE];          // chunked page output buffer
+    size_t        _chunkLen               = 0;
+    uint32_t      _pagesServed            = 0;
+    uint32_t      _pageMinHeap            = 0;
+    uint32_t      _otaStackFree           = 0;
+    #ifdef WM_OTA_TASK
+    uint8_t       *_otaBuf[2]             = { NULL, NULL }; // OTA buffers; full ones go to writer task
+    int           _otaCur                 = 0;
+    size_t        _otaFill                = 0;
+    TaskHandle_t  _otaTask                = NULL;
+    QueueHandle_t _otaFullQ               = NULL;
+    QueueHandle_t _otaFreeQ               = NULL;
+    SemaphoreHandle_t _otaDoneSem         = NULL;
+    #endif
     String        _title                  = FPSTR(S_brand); // app title -  default WiFiManager
 
     // internal options
@@ -652,6 +718,12 @@ class WiFiManager
 
     // webserver handlers
     void          HTTPSend(const String &content);
+    void          HTTPSendStart(String title);
+    void          HTTPSendChunk(const char *content, size_t len);
+    void          HTTPSendChunk(const String &content);
+    void          HTTPSendChunk_P(PGM_P content);
+    void          HTTPSendEnd();
+    void          notePageServed();
     void          handleRoot();
     void          handleWifi(boolean scan);
     void          handleWifiSave();
@@ -663,6 +735,10 @@ class WiFiManager
     // void          handleErase();
     void          handleErase(boolean opt);
     void          handleParam();
+    #ifdef WM_GZASSETS
+    void          handleAssetJS();
+    void          handleAssetCSS();
+    #endif
     void          handleWiFiStatus();
     void          handleRequest();
     void          handleParamSave();
@@ -676,6 +752,13 @@ class WiFiManager
 	void          handleUpdate();
 	void          handleUpdating();
 	void          handleUpdateDone();
+    #ifdef WM_OTA_TASK
+    bool          otaStart();
+    bool          otaWrite(const uint8_t *buf, size_t len);
+    bool          otaFlush();
+    void          otaStop();
+    static void   otaWriterTask(void *arg);
+    #endif
 
 
     // wifi platform abstractions
@@ -733,9 +816,9 @@ class WiFiManager
     #endif
 
     // output helpers
-    String        getParamOut();
+    String        getParamOut(bool stream = false);
     String        getIpForm(String id, String title, String value);
-    String        getScanItemOut();
+    String        getScanItemOut(bool stream = false);
     String        getStaticOut();
     String        getHTTPHead(String title);
     String        getMenuOut();
@@ -824,6 +907,8 @@ class WiFiManager
     std::function<void()> _saveparamscallback;
     std::function<void()> _resetcallback;
     std::function<void()> _preotaupdatecallback;
+    std::function<void()> _otaprogresscallback;
+    std::function<void(bool)> _postotaupdatecallback;
     std::function<void()> _configportaltimeoutcallback;
 
     template <class T>
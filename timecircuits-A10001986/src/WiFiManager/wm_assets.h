@@ -0,0 +1,122 @@
+/*
+ * Generated by assets/mkassets.py - DO NOT EDIT
+ */
+
+#ifndef _WM_ASSETS_H
+#define _WM_ASSETS_H
+
+// wm.js: 346 bytes, 220 compressed
+#define WM_JS_ETAG "3f294e8f"
+static const uint8_t wm_js_gz[] PROGMEM = {
+    0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x7d,0x4f,0xcb,0x4e,0x03,0x31,
+    0x0c,0xbc,0xf3,0x15,0xe1,0xe4,0xe4,0x40,0x3e,0x80,0x28,0x42,0x80,0x7a,0xa8,0xc4,
+    0x0d,0x7e,0x20,0x9b,0x47,0x65,0xc9,0xf5,0x46,0x1b,0x6f,0xd9,0xaa,0xed,0xbf,0x93,
+    0x95,0xda,0xde,0xe8,0xc9,0xf6,0xcc,0x78,0x34,0x53,0x66,0x8e,0x82,0x23,0xab,0xa8,
+    0xc9,0x9c,0xd2,0x18,0xe7,0x7d,0x66,0xb1,0xbb,0x2c,0x1b,0xca,0xeb,0xfa,0x71,0xdc,
+    0x26,0x0d,0x0d,0x8c,0x3d,0x04,0x9a,0xb3,0xa7,0x95,0x7b,0x17,0x99,0x70,0x98,0x25,
+    0x6b,0x48,0x41,0xc2,0x4b,0x6b,0x98,0xc0,0x9c,0xcf,0x64,0x91,0x39,0x4f,0x3f,0x79,
+    0x91,0xf5,0x90,0x3e,0x3f,0x47,0x96,0x6e,0xe3,0xaa,0xf2,0x8a,0x2c,0x77,0xe4,0x6a,
+    0xfc,0x8d,0x03,0x21,0xef,0x6c,0xa4,0xd0,0xda,0x17,0x36,0xb1,0xb1,0x4b,0x03,0x72,
+    0xd3,0x40,0x60,0xdc,0xbf,0x59,0x6a,0xcf,0x92,0xb0,0x85,0x81,0x72,0xea,0xa6,0xcf,
+    0xd5,0x61,0xd1,0xd5,0x3c,0xd4,0x97,0x4e,0x36,0x6d,0xdc,0xc5,0x95,0x5b,0xe1,0xa2,
+    0x8d,0x3a,0x1d,0xc2,0xa4,0x96,0x6e,0xf2,0xe8,0xd9,0x2d,0x56,0x8e,0x35,0x7b,0xef,
+    0xa1,0xf6,0xa8,0xbf,0xe3,0x94,0xe0,0xed,0x8a,0xc1,0x5a,0x11,0x5e,0x6f,0xd7,0x9d,
+    0x77,0x97,0xa7,0x3f,0x91,0x35,0x83,0x58,0x5a,0x01,0x00,0x00,
+};
+
+// wm.css: 2954 bytes, 1434 compressed
+#define WM_CSS_ETAG "0eac4778"
+static const uint8_t wm_css_gz[] PROGMEM = {
+    0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0xad,0x56,0xe9,0x6f,0xe2,0x38,
+    0x14,0xff,0xbe,0x7f,0x45,0x56,0xa3,0x11,0x53,0x71,0x05,0x92,0x40,0x08,0x1a,0x69,
+    0x21,0x40,0x87,0x02,0x2d,0x47,0x39,0xda,0x51,0x3f,0x38,0xb1,0x49,0x0c,0x49,0x1c,
+    0x72,0x70,0x34,0xe2,0x7f,0x5f,0x3b,0x09,0xd3,0xb4,0xc3,0x56,0xab,0xd5,0x92,0x0f,
+    0xd8,0xef,0xfd,0xde,0xe1,0x77,0xf8,0xb9,0xa4,0x17,0x34,0x02,0x4f,0x51,0x80,0x8e,
+    0x41,0x11,0x58,0xd8,0x70,0x14,0x1d,0x39,0x01,0xf2,0x9a,0x6b,0xe2,0x04,0xc5,0x35,
+    0xb0,0xb1,0x75,0x52,0xf6,0xc8,0x83,0xc0,0x01,0x67,0x88,0xf7,0x05,0xec,0xb8,0x61,
+    0x50,0xf0,0x91,0x85,0xf4,0x20,0x72,0x01,0x84,0xd8,0x31,0x14,0xc9,0x3d,0x26,0x02,
+    0x3e,0x7e,0x45,0x4a,0x05,0xd9,0x4d,0x1b,0x78,0x06,0x76,0x18,0x83,0xe3,0x9b,0x1a,
+    0x39,0x32,0x0e,0x43,0x6a,0xc4,0x83,0xc8,0x2b,0x52,0xca,0x39,0xd1,0xa4,0x85,0x41,
+    0x40,0x9c,0x54,0x61,0xa1,0x64,0xfb,0x46,0x94,0x62,0x3c,0x00,0x71,0xe8,0x2b,0x25,
+    0xc1,0xa3,0xfa,0x0e,0x18,0x06,0xa6,0xc2,0x55,0x78,0xfe,0x6b,0x22,0xf8,0x33,0x38,
+    0xb9,0xe8,0x3b,0xc3,0x90,0x97,0x42,0x86,0xa2,0x9b,0x48,0xdf,0x52,0xf5,0x2f,0x51,
+    0x22,0x02,0xc2,0x80,0x9c,0x53,0x23,0x19,0x58,0x2e,0x21,0xe5,0xde,0xc9,0xe6,0xfc,
+    0x50,0xb3,0x71,0x90,0x7b,0x89,0xf4,0xd0,0xf3,0x89,0xa7,0xb8,0x04,0xc7,0xc1,0x48,
+    0x3c,0x52,0xe8,0x49,0x80,0xbe,0x35,0x3c,0x12,0x3a,0xb0,0xa8,0x13,0x8b,0x22,0xbe,
+    0x54,0xd6,0x40,0x40,0x7a,0x33,0xdd,0xad,0xd7,0xeb,0xa6,0x85,0x1d,0x54,0x34,0x11,
+    0x36,0xcc,0x40,0xa9,0x96,0x44,0xe6,0x7d,0x26,0x36,0xa5,0xea,0xdb,0x71,0x3e,0x9e,
+    0x26,0xb7,0xc6,0x16,0xa2,0xd6,0x53,0x73,0x15,0x1a,0x3c,0x9f,0x58,0x18,0x72,0xa9,
+    0x95,0x73,0xe9,0xe0,0x01,0x97,0xcb,0x66,0xcb,0x42,0xeb,0xa0,0x09,0xb1,0xef,0x5a,
+    0xe0,0xa4,0x60,0x27,0xb6,0xad,0x59,0x44,0xdf,0x36,0x6d,0xec,0x14,0x13,0x33,0xd5,
+    0x1a,0x4f,0xf3,0x63,0x83,0x63,0xba,0x97,0x78,0xba,0x3f,0x83,0x28,0xf5,0x99,0xe7,
+    0xf9,0xc4,0xc1,0x43,0xe2,0x73,0x9d,0xee,0x63,0x0b,0x10,0xe9,0xc4,0x03,0x01,0x26,
+    0x8e,0xe2,0x10,0x07,0x9d,0x81,0x62,0x12,0x5a,0x0a,0xd1,0xfb,0x93,0x7f,0x84,0xd2,
+    0xd8,0x20,0x8f,0xf9,0x71,0x2e,0xed,0xa2,0x34,0x0c,0x95,0x5a,0xec,0x40,0x5c,0x12,
+    0x7c,0xf3,0x52,0x35,0x3c,0xc7,0xea,0x26,0x73,0x18,0x8f,0x81,0x33,0x8e,0x0b,0x32,
+    0xab,0x2b,0x8b,0x80,0x20,0x61,0x51,0x8d,0xa5,0x5d,0x91,0x57,0xc0,0x9a,0x26,0x25,
+    0xca,0xe4,0xc2,0x25,0x3e,0x66,0xc6,0x8b,0x47,0x85,0x4f,0x40,0x95,0x4f,0x41,0x45,
+    0xe6,0x50,0x02,0xac,0x7e,0x0e,0x14,0xaa,0x17,0xa0,0xf0,0x39,0x50,0x94,0x2f,0x40,
+    0xf1,0x73,0x60,0x4d,0x4c,0x80,0x96,0xa2,0xa1,0x35,0xf1,0xd0,0x3f,0xe1,0x64,0x96,
+    0xb4,0x34,0x54,0xc5,0xf8,0xf8,0xac,0x9b,0xa8,0xa4,0xc5,0xd1,0xc0,0x26,0x51,0x61,
+    0xd9,0xa7,0x94,0xc4,0x60,0x81,0x2e,0x52,0x95,0x3a,0x4d,0x27,0x6d,0x63,0x25,0x97,
+    0xbb,0x54,0x1a,0x4b,0x40,0x36,0x19,0x57,0x4b,0x26,0xe3,0x89,0x87,0x5c,0x44,0x0d,
+    0x38,0x24,0x5d,0x35,0xaf,0x78,0x49,0xdb,0xb1,0x96,0xf4,0xf7,0x1b,0x0f,0xdb,0xc0,
+    0x40,0x4a,0xe8,0x59,0xdf,0x72,0x10,0x04,0x40,0x89,0xf7,0x65,0xd7,0x31,0x28,0xc8,
+    0x47,0x35,0xb1,0x80,0x17,0xed,0x87,0xe9,0x81,0x1f,0xdc,0x1a,0xa4,0x45,0x7f,0xf7,
+    0xb3,0xb9,0xd9,0x9d,0x1b,0x74,0x75,0xcb,0xb6,0xad,0x89,0xda,0x1a,0xd1,0xbf,0x0e,
+    0x7a,0xee,0x7b,0x43,0x46,0xb8,0xeb,0xb5,0x47,0x8b,0xee,0xaa,0x5c,0x2e,0xcb,0xad,
+    0x7f,0xff,0xeb,0xfc,0xb8,0xdb,0x48,0x16,0x5b,0xa9,0xc2,0x74,0xf6,0x68,0x8d,0x5a,
+    0xfd,0xcd,0xbd,0x80,0xef,0xec,0x5d,0x28,0xbf,0xc2,0xfa,0xbe,0x27,0xbb,0xaf,0x3a,
+    0xe5,0xb6,0xfd,0xd9,0x7c,0xda,0x5e,0xfc,0xd8,0x80,0xfa,0x53,0xa5,0xad,0xfa,0xad,
+    0x83,0xda,0x9a,0xdd,0xcf,0x16,0x44,0x28,0xef,0xf3,0xe5,0xf6,0xbc,0x8b,0x57,0x4e,
+    0x9f,0xac,0xb6,0x64,0x25,0x6d,0x5a,0x93,0xd1,0xf1,0xf1,0xc7,0xeb,0xa0,0xa1,0x2f,
+    0x66,0xce,0xbe,0x73,0x3c,0x74,0x64,0xad,0x77,0x94,0xc7,0xe6,0x73,0x63,0x27,0xf7,
+    0x6c,0xc3,0x5c,0xb5,0xcd,0x5d,0x8b,0x76,0xc5,0x71,0xdb,0xa8,0x8e,0xfd,0xe3,0x7e,
+    0xaa,0x57,0x55,0x55,0xed,0x41,0x73,0xa2,0x6a,0xd3,0xed,0x90,0xb4,0x26,0xc2,0xae,
+    0x7c,0x58,0xce,0xdb,0xbb,0x5b,0x41,0x7a,0x3e,0x06,0x8b,0xd7,0xa5,0xd8,0x85,0xb5,
+    0xa1,0x63,0x8c,0x4f,0xed,0x79,0x55,0x25,0x1a,0xec,0x77,0x26,0x12,0x19,0x2f,0xfb,
+    0x92,0xa3,0xce,0x0f,0xf1,0x49,0x66,0xf3,0xc5,0xc3,0x74,0x20,0xa9,0x4f,0xfd,0xfe,
+    0xf7,0xdc,0x4d,0xf3,0xfc,0x97,0x8d,0x20,0x06,0xdc,0x37,0xda,0xad,0xda,0x16,0x07,
+    0x45,0xd6,0x2d,0x10,0xed,0xb1,0x8e,0x8a,0x2e,0x3e,0x22,0xab,0x18,0xb7,0xa1,0xc2,
+    0x55,0x6f,0x0a,0xdf,0x18,0xcf,0x43,0xf4,0x0a,0x09,0xd3,0x74,0x35,0xaa,0xd0,0xc5,
+    0x37,0xd1,0xaf,0x42,0x29,0x5c,0x6a,0x87,0x8b,0xfe,0x97,0x1c,0x0e,0x63,0x9f,0x8d,
+    0x24,0x87,0xea,0x7a,0x94,0x1f,0x98,0x8c,0x30,0x5c,0xfc,0x97,0x1c,0xbe,0xcb,0x67,
+    0xeb,0xc1,0x7b,0x30,0xe2,0x95,0x93,0xe4,0xb3,0x3b,0xeb,0xbf,0x4e,0x6f,0x9f,0xdf,
+    0x72,0x6a,0x0c,0x36,0xea,0x70,0xc2,0xec,0xda,0x49,0x4e,0x8d,0x76,0x1d,0x76,0xda,
+    0x2a,0x19,0x1d,0xba,0xdd,0xd5,0xd4,0x1e,0x58,0x8b,0x27,0x61,0x58,0x2e,0x0b,0xf7,
+    0x43,0xf3,0xf4,0xba,0xeb,0xef,0x66,0x73,0xc3,0x38,0xc9,0xe1,0xd1,0x31,0xd5,0xa9,
+    0x34,0x22,0xf2,0x71,0x18,0xe4,0x2b,0x22,0x78,0xae,0x1f,0x0e,0x86,0xbf,0xdf,0x8f,
+    0x5b,0x65,0xb2,0xde,0x37,0xf2,0xa2,0x28,0x08,0xe2,0x7c,0xb5,0x72,0x8c,0xbd,0x56,
+    0x5b,0xf9,0x3d,0xf3,0xa1,0xbc,0x20,0x6a,0x75,0xea,0xcf,0xf6,0x8d,0xbb,0xfa,0x51,
+    0x6e,0x3b,0x4f,0xc3,0x65,0xbe,0xb5,0x79,0x94,0x6a,0x21,0x2c,0x87,0x68,0x3c,0x82,
+    0x5a,0xbd,0x3f,0x96,0xdb,0xbe,0x5e,0x46,0x75,0x53,0x56,0xd7,0xdb,0x46,0xa5,0x6a,
+    0x98,0xfe,0xfd,0x6a,0x39,0x76,0x3b,0xaa,0x68,0xee,0xef,0xf3,0x9d,0x8a,0x54,0xe3,
+    0x5b,0x95,0xc9,0xf8,0x61,0x7a,0x32,0x65,0x71,0x31,0x18,0x6e,0x36,0x70,0xbf,0x1e,
+    0xf7,0xec,0x7c,0x1e,0x37,0xba,0xcb,0x1d,0x2f,0x88,0x32,0xb5,0xb9,0x31,0xcd,0xc7,
+    0xbc,0x08,0xfb,0x9a,0xba,0xcc,0x2f,0x37,0xcf,0xd8,0x6e,0xb4,0x06,0x5b,0x71,0xfe,
+    0x3c,0x72,0x1c,0xb5,0x1b,0xc6,0xa1,0xe9,0x5a,0xbd,0xc7,0xed,0x2c,0x9c,0xd8,0xaa,
+    0x4a,0xeb,0x23,0x93,0xc6,0x78,0xde,0x70,0x0d,0x36,0x82,0xe3,0x96,0x3f,0x9f,0xe3,
+    0xe9,0x7a,0xb9,0x7d,0xab,0xfc,0xdb,0x9d,0xcc,0xd6,0xf1,0x9c,0xfe,0x38,0x77,0x10,
+    0x42,0x29,0xb5,0xc8,0xee,0x9a,0xcb,0x00,0xa1,0x92,0x59,0x6a,0x3a,0x10,0xea,0xf5,
+    0x7a,0x6c,0x82,0x33,0xc5,0x28,0x51,0x5c,0x0c,0x88,0x4b,0x2f,0xfc,0x74,0xa3,0x11,
+    0x3a,0x72,0xed,0xe4,0x16,0xa3,0xb0,0xd2,0x38,0xba,0xa2,0xe4,0x32,0xe9,0x62,0x00,
+    0xd3,0x74,0x85,0xde,0xb9,0x26,0x08,0x75,0xa1,0x26,0xf0,0x29,0x20,0x23,0x98,0xa5,
+    0xcf,0xae,0x08,0x72,0x5f,0x24,0x5d,0x93,0xa5,0x54,0xf5,0xec,0x4d,0xf2,0x17,0x03,
+    0x06,0x51,0x76,0x3e,0x6a,0xc4,0x82,0x67,0x08,0xa3,0x2b,0xf3,0x8c,0x7e,0x25,0x09,
+    0xd9,0x34,0x94,0xac,0xf5,0x2e,0xf7,0x2d,0x1b,0x21,0x01,0x8c,0xe8,0xe8,0x0c,0xb0,
+    0x0e,0xac,0x74,0xd8,0x71,0x34,0x36,0xcd,0x73,0xc9,0x8c,0x2e,0x57,0x71,0x3c,0x63,
+    0x93,0x67,0x49,0x14,0x78,0xc0,0xb9,0x5c,0xb2,0xbc,0xcf,0x11,0x17,0xe8,0x38,0x38,
+    0x35,0xdf,0xc8,0xb4,0xe7,0x99,0x0c,0x27,0xf8,0xef,0x88,0x61,0x3a,0x84,0xa9,0x50,
+    0x33,0x7d,0xc3,0x70,0xe9,0x23,0x26,0x55,0xcd,0x82,0xf7,0xdb,0x23,0x26,0x8d,0x51,
+    0x82,0x50,0x80,0x1e,0xe0,0x3d,0x8a,0x52,0xa3,0xf4,0xb9,0xf0,0x95,0xfb,0x13,0xdb,
+    0x2e,0xf1,0x02,0xe0,0x04,0x17,0xb5,0x07,0x80,0x83,0x2b,0xfe,0xf0,0xfe,0x99,0x3d,
+    0x28,0x4b,0xd8,0x61,0xc7,0x2d,0x64,0xd6,0x1c,0x78,0xb7,0x33,0x2b,0xdc,0x15,0x47,
+    0xf8,0x1a,0xfb,0xb2,0xaf,0xa9,0xac,0x3a,0x2e,0x2e,0xe0,0x0c,0xf3,0x77,0x05,0x55,
+    0x99,0x7d,0x97,0xea,0x64,0xe5,0x97,0xa9,0x66,0x49,0x92,0x2e,0x9c,0x64,0xa0,0x5e,
+    0xe7,0xa5,0x75,0xfa,0x81,0xf9,0xde,0x91,0xdd,0x4f,0x8f,0x58,0xe8,0x3b,0xb6,0x8d,
+    0x97,0xe8,0x72,0x15,0xd3,0xd7,0x1b,0x8d,0xb3,0x92,0x40,0xbe,0x55,0x6e,0x9a,0xbf,
+    0x11,0xce,0x0a,0x4d,0x36,0xd0,0x2c,0x04,0xb9,0x5f,0xe1,0x65,0x25,0xd3,0x3c,0xff,
+    0xf1,0x37,0xeb,0xdb,0x9e,0x01,0x8a,0x0b,0x00,0x00,
+};
+
+#endif
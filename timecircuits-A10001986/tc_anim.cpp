@@ -0,0 +1,188 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Display animation timelines
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+
+#include "tc_anim.h"
+
+/*
+ * Steps are scheduled against the start time, not against
+ * the previous step; a late step does not delay the ones 
+ * after it. If more than one step is due (loop was busy), 
+ * only the last one due is executed, so the animation
+ * catches up instead of rushing through stale frames.
+ * 
+ * anim_loop() is called from time_loop() and mydelay().
+ */
+
+typedef struct {
+    animStepFunc  func;
+    int           step;
+    int           numSteps;
+    unsigned long interval;
+    unsigned long firstDelay;
+    unsigned long startNow;
+} animTimeline;
+
+static animTimeline tl[ANIM_MAX] = { { NULL } };
+static bool         inAnimLoop = false;
+
+static int anim_find(animStepFunc func)
+{
+    for(int i = 0; i < ANIM_MAX; i++) {
+        if(tl[i].func == func) return i;
+    }
+    return -1;
+}
+
+static unsigned long anim_stepTime(animTimeline *t, int step)
+{
+    return t->firstDelay + (step - 1) * t->interval;
+}
+
+// (Re)start timeline; step 0 is run from here
+bool anim_start(animStepFunc func, int numSteps, unsigned long interval, unsigned long firstDelay)
+{
+    int i;
+
+    if((i = anim_find(func)) < 0) {
+        if((i = anim_find(NULL)) < 0)
+            return false;
+    }
+
+    tl[i].func = NULL;
+    
+    func(0);
+
+    if(numSteps > 1) {
+        tl[i].step = 1;
+        tl[i].numSteps = numSteps;
+        tl[i].interval = interval;
+        tl[i].firstDelay = firstDelay ? firstDelay : interval;
+        tl[i].startNow = millis();
+        tl[i].func = func;
+    }
+
+    return true;
+}
+
+void anim_cancel(animStepFunc func)
+{
+    int i;
+    
+    if((i = anim_find(func)) >= 0) {
+        tl[i].func = NULL;
+    }
+}
+
+bool anim_running(animStepFunc func)
+{
+    return (anim_find(func) >= 0);
+}
+
+// Any timeline running?
+bool anim_active()
+{
+    for(int i = 0; i < ANIM_MAX; i++) {
+        if(tl[i].func) return true;
+    }
+    return false;
+}
+
+// Run the last step of a timeline now
+void anim_finish(animStepFunc func)
+{
+    int i;
+    
+    if((i = anim_find(func)) >= 0) {
+        int last = tl[i].numSteps - 1;
+        tl[i].func = NULL;
+        func(last);
+    }
+}
+
+void anim_loop()
+{
+    unsigned long elapsed;
+    animTimeline *t;
+    animStepFunc func;
+    int step;
+
+    // Step functions may end up here through 
+    // mydelay() etc; do not recurse
+    if(inAnimLoop) return;
+    inAnimLoop = true;
+
+    for(int i = 0; i < ANIM_MAX; i++) {
+        t = &tl[i];
+        if(!t->func) continue;
+        elapsed = millis() - t->startNow;
+        if(elapsed < anim_stepTime(t, t->step)) continue;
+
+        // Skip to the last step due
+        step = t->step;
+        while(step + 1 < t->numSteps && elapsed >= anim_stepTime(t, step + 1)) {
+            step++;
+        }
+        
+        func = t->func;
+        if(step + 1 >= t->numSteps) {
+            t->func = NULL;
+        } else {
+            t->step = step + 1;
+        }
+        func(step);
+    }
+
+    inAnimLoop = false;
+}
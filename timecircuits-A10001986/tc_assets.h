@@ -0,0 +1,205 @@
+/*
+ * Generated by assets/mkassets.py - DO NOT EDIT
+ */
+
+#ifndef _TC_ASSETS_H
+#define _TC_ASSETS_H
+
+// tcd.js: 3928 bytes, 1772 compressed
+#define TC_JS_ETAG "dbf0e662"
+static const uint8_t tcd_js_gz[] PROGMEM = {
+    0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0xcd,0x56,0x59,0x53,0xdb,0xc8,
+    0x16,0x7e,0xbf,0xbf,0x42,0x57,0xb7,0x2a,0x2d,0x8d,0x89,0x17,0x6c,0x42,0x06,0x59,
+    0x4e,0xb5,0x37,0xcc,0xe2,0xe0,0x0d,0x08,0x4c,0xe6,0xa1,0x25,0xb5,0xa5,0x86,0xd6,
+    0x12,0xa9,0x85,0x30,0xe0,0xff,0x7e,0x4f,0x4b,0xb6,0x63,0x48,0x08,0x53,0x35,0x73,
+    0xab,0xae,0x5e,0xd4,0xcb,0xd9,0xcf,0x77,0x4e,0x9f,0x79,0x1a,0xd8,0x82,0x85,0x81,
+    0x92,0xf1,0x48,0xd3,0x1f,0x63,0x2a,0xd2,0x18,0x36,0x2c,0x70,0xc2,0xac,0xcc,0x43,
+    0x9b,0xc8,0xcb,0x72,0x44,0x84,0x17,0x10,0x9f,0x1a,0xcb,0xf9,0x9a,0xde,0xa5,0x22,
+    0xd0,0xee,0x37,0x1c,0x4e,0x68,0xa7,0x3e,0x0d,0x44,0x19,0xce,0x7b,0x9c,0xca,0x65,
+    0xd2,0x5e,0xcc,0x88,0xfb,0x19,0xd8,0x80,0x6e,0x9b,0xf1,0xd7,0x6c,0xed,0xc5,0x91,
+    0xf3,0x8c,0xc1,0xd6,0xb8,0xfe,0x08,0x5c,0x28,0x41,0x7a,0xf9,0x8e,0xf0,0x94,0x9a,
+    0x5c,0xd2,0x63,0x21,0x62,0x66,0xa5,0x02,0x6e,0x1c,0x22,0xc8,0xfb,0x24,0x61,0x0e,
+    0xd2,0x9f,0x9e,0x78,0x99,0x05,0x01,0x8d,0x67,0xf4,0x5e,0xc8,0x8d,0x80,0x7f,0x27,
+    0x0c,0x04,0x88,0x36,0x22,0xe0,0x0c,0x60,0xbf,0x52,0x35,0x65,0x16,0x67,0x81,0x5b,
+    0xb6,0x39,0x49,0x92,0x53,0x96,0x88,0xb2,0x0d,0x84,0x84,0x05,0x89,0x86,0x38,0xd2,
+    0x0d,0xa9,0x34,0x02,0xa5,0x0e,0x4b,0x88,0xc5,0xa9,0x63,0xfe,0x3b,0x32,0xd8,0x5c,
+    0x8b,0x0a,0x73,0xe4,0x4d,0xc4,0x89,0x4d,0xbd,0x90,0x3b,0x34,0x36,0x11,0xda,0x30,
+    0xcc,0xc1,0xad,0x44,0xd3,0x8d,0xe5,0x32,0x25,0x76,0x52,0x33,0x55,0x6d,0xed,0x8d,
+    0x46,0xc1,0x99,0xd7,0xbc,0x46,0x40,0x6d,0x01,0x7b,0x22,0x16,0x9c,0x4a,0xad,0x20,
+    0x7e,0xa1,0x98,0x0a,0xe5,0x2b,0xbf,0x41,0x87,0xf2,0x49,0x41,0x41,0x18,0x50,0xa4,
+    0x1c,0x28,0x88,0x05,0x4c,0x30,0xc2,0x91,0xb1,0xd4,0x35,0xe1,0xb1,0x44,0x57,0x0d,
+    0xa9,0x50,0xc4,0xa6,0x7a,0x1e,0xf1,0x90,0x38,0x0a,0x49,0x1d,0x16,0x2a,0x32,0x3e,
+    0x8a,0x36,0xeb,0x74,0x71,0xd9,0x62,0x81,0xae,0x90,0xc0,0xa9,0x84,0xb1,0x92,0x84,
+    0x69,0xe0,0x28,0x73,0xc6,0x69,0xd2,0xb4,0xe2,0x56,0x73,0x1e,0xc6,0xbe,0xe2,0x53,
+    0xe1,0x85,0x8e,0x89,0x46,0x67,0xd3,0x19,0x52,0x48,0x6e,0xb5,0x29,0x2d,0x43,0x0a,
+    0x05,0x1f,0x16,0x11,0x35,0x91,0x9f,0x72,0xc1,0x22,0x12,0x8b,0x8a,0x64,0x79,0x2f,
+    0xc5,0x23,0x25,0x0c,0x6c,0x8f,0x04,0x2e,0x35,0xbf,0xaa,0x6a,0x29,0xf7,0xbb,0xa4,
+    0x7e,0x55,0x5b,0x4d,0x16,0x44,0xa9,0x50,0x0a,0x46,0xa9,0x0b,0x29,0x12,0x4a,0x20,
+    0x32,0x92,0x32,0x0b,0x51,0x9c,0x82,0x26,0x9b,0x46,0xc2,0x44,0xd2,0xc2,0x9d,0xb2,
+    0x1f,0xd5,0x77,0xca,0x19,0xb9,0xdb,0x21,0x51,0xc4,0x59,0x01,0xc3,0x4a,0x68,0x0b,
+    0x2a,0xde,0x83,0x7b,0x94,0xf8,0x3b,0xb9,0x67,0x15,0x3f,0xa2,0xee,0x6a,0x09,0xd4,
+    0xa8,0x35,0x4c,0x13,0x66,0x2b,0xf3,0x3c,0x23,0x8a,0xe6,0xcb,0xdd,0x17,0xfd,0x0d,
+    0x13,0x32,0x6a,0xdd,0x32,0xe1,0xb0,0x98,0xda,0x22,0x8c,0x17,0xad,0x26,0x80,0x4a,
+    0x00,0xf0,0x98,0x63,0x16,0x19,0x59,0x71,0x26,0xa9,0xe5,0x33,0x81,0x94,0x1c,0x2e,
+    0x26,0xf2,0x94,0x2e,0x6a,0x15,0x61,0x6e,0x56,0x0a,0x96,0x56,0x33,0x0f,0x48,0x4b,
+    0x35,0x56,0x15,0x14,0x06,0xf2,0xda,0xdc,0x64,0x5f,0x7f,0xbc,0xbf,0x37,0xe7,0x84,
+    0x27,0xd4,0xd8,0x80,0x40,0x30,0xc1,0x41,0xfa,0x8c,0xf9,0x54,0xe9,0xb0,0xd8,0x4e,
+    0x99,0x48,0x90,0xc4,0xd9,0x0a,0xf3,0xef,0xde,0xc9,0x85,0x13,0xc0,0x32,0x67,0x17,
+    0x71,0x4a,0x8d,0x7b,0x58,0x3c,0x97,0x60,0x2c,0x16,0x0b,0x13,0x01,0xd2,0xe7,0xcc,
+    0x4d,0x63,0xaa,0x5c,0xb2,0x3e,0x43,0x06,0x21,0xe6,0xba,0x74,0x20,0x5f,0x40,0xbc,
+    0xc2,0x9b,0x61,0x59,0x26,0x21,0x45,0xa5,0x0c,0x66,0xc3,0x53,0xc3,0x71,0x4c,0xcb,
+    0x2a,0x27,0x94,0xc4,0xb6,0xa7,0xa1,0xa6,0x17,0xb7,0xa0,0x00,0x28,0x7d,0x76,0x58,
+    0x38,0x09,0xe7,0xb6,0x6d,0xa2,0xa6,0xc3,0xee,0x56,0xa1,0x50,0x13,0x88,0x5c,0xa2,
+    0xb6,0x50,0x49,0x52,0xa7,0x16,0x64,0x08,0xca,0x4a,0xab,0xee,0x38,0x8e,0x5e,0x42,
+    0xcd,0x0a,0x50,0xb6,0xde,0x26,0x77,0x9c,0x52,0x63,0x87,0xd2,0x0d,0xc7,0x8b,0x6b,
+    0xb8,0x31,0xb6,0x2d,0x36,0x6d,0xfb,0x7b,0x0c,0xbf,0xa5,0x34,0x5e,0x4c,0x29,0xcf,
+    0x33,0x88,0x39,0xd7,0x10,0xf9,0xc3,0x8b,0xe9,0xdc,0x54,0xff,0x13,0xa9,0x7f,0xe6,
+    0x15,0x19,0xf7,0x08,0x38,0xa1,0xa5,0x09,0x8d,0x8f,0x04,0xf5,0x75,0xb3,0xf5,0xb8,
+    0x5e,0x43,0x9a,0x6c,0x00,0xd9,0xed,0x76,0x9e,0xec,0xa2,0xa0,0x8c,0x55,0xa3,0x2a,
+    0x72,0xb6,0x5c,0xea,0x32,0x31,0xdf,0x83,0xaa,0x3f,0x82,0x49,0x61,0x90,0xe3,0x6b,
+    0x9b,0x1b,0x88,0x24,0xfb,0x76,0x7f,0x28,0x73,0x1a,0xb8,0xc2,0x6b,0x55,0xdf,0xbd,
+    0xcb,0xaf,0xf2,0x8a,0x5e,0x1d,0x9a,0x66,0xf5,0x95,0x9e,0xf2,0xdb,0xea,0x83,0x12,
+    0x87,0x6f,0x05,0x8a,0x34,0x07,0x1d,0xd4,0x49,0x61,0x80,0xf9,0xf3,0xe6,0xdb,0x91,
+    0xc1,0xce,0xdb,0x2f,0xca,0x62,0x02,0x92,0x0b,0xd3,0x37,0x76,0x48,0xd6,0x3f,0xaa,
+    0x7f,0x42,0x44,0x21,0x0c,0x02,0x3b,0x37,0xa0,0x36,0x10,0x32,0xb4,0x1a,0xb2,0x28,
+    0x04,0x8c,0xd2,0xc0,0x41,0x3b,0x45,0x43,0x91,0xbd,0xec,0x47,0xed,0x4f,0x4f,0xf9,
+    0xb3,0x01,0x7d,0xa9,0x92,0xa2,0xed,0x0d,0x94,0xd5,0xd6,0x36,0x63,0x73,0xe8,0xa0,
+    0x77,0x74,0xfb,0x0c,0xd0,0x48,0xfc,0xfc,0xf0,0x4d,0x50,0x6b,0x3f,0x0a,0xd2,0x3f,
+    0xbd,0x44,0xfa,0x81,0xf6,0x13,0xd1,0x9f,0xd0,0x14,0xd2,0x17,0xa1,0x03,0xd4,0x67,
+    0xb1,0x9f,0x41,0x01,0x28,0x69,0x04,0xdd,0x0a,0x04,0x18,0x7f,0x23,0x6e,0xb0,0xd7,
+    0xa0,0x7e,0x5e,0xa6,0x62,0x1d,0xd0,0xa2,0x7d,0xcb,0x77,0x07,0x73,0xe6,0x42,0xf3,
+    0x94,0x71,0xa5,0x31,0x82,0x9a,0x7b,0x5e,0x84,0x80,0x9c,0xa2,0xa7,0x6c,0x43,0x67,
+    0x05,0xae,0x2d,0xc1,0x85,0xfe,0x1c,0x6a,0x9b,0x97,0x28,0x8f,0xd7,0xb3,0x72,0x40,
+    0x23,0x4e,0x49,0x42,0x95,0x8c,0x40,0x8f,0x5a,0xae,0xa5,0xe4,0x0f,0xca,0x6b,0x02,
+    0x96,0x4b,0x63,0xdb,0x95,0x9c,0xf6,0x1f,0xf6,0xe2,0x97,0xfa,0xff,0x8a,0x03,0x6f,
+    0x87,0x41,0x16,0x46,0x4e,0x0d,0x03,0x09,0x1a,0xd4,0x5f,0xc5,0x79,0x4c,0xfd,0xf0,
+    0x8e,0x6a,0xfa,0x16,0x71,0xed,0x6d,0xe2,0x0d,0xec,0x61,0xda,0x88,0x9e,0x21,0x3e,
+    0x87,0xd9,0xdb,0xe8,0x5d,0x41,0xd0,0x58,0xcb,0xa1,0x56,0x40,0xb3,0xed,0x56,0x9e,
+    0x87,0x7f,0x63,0xfb,0x73,0xe3,0xa4,0xcc,0x75,0x95,0xae,0x3b,0xb5,0x14,0x6a,0x59,
+    0xcf,0xcf,0xe6,0xf3,0x15,0x59,0x91,0x99,0xcf,0xa1,0x43,0xe1,0x6c,0x95,0xc3,0x28,
+    0x4c,0x58,0xf1,0x8a,0xc7,0x94,0xc3,0x4b,0x0a,0x85,0x91,0x5b,0x73,0x0f,0x73,0xd8,
+    0xc3,0x83,0xa9,0x0d,0x61,0xba,0x2b,0xc7,0x30,0x13,0x84,0xbe,0xa6,0xb7,0xaa,0xe5,
+    0x8f,0xba,0x7c,0x0d,0x36,0xae,0xd8,0xf0,0xdc,0x0a,0xba,0x4a,0x36,0x3c,0x44,0xec,
+    0x0e,0x49,0x82,0xad,0xa9,0x89,0x38,0x30,0xbb,0x88,0xc8,0xaf,0x16,0x17,0x5b,0x29,
+    0xdd,0xee,0xfa,0x40,0xa0,0xc2,0x90,0xd0,0xc9,0x3b,0xad,0xfa,0x62,0xc4,0x34,0xbf,
+    0xa2,0xca,0x57,0xa4,0xb6,0x5e,0x30,0xec,0xca,0xf9,0xc1,0x77,0x95,0x24,0xb6,0x4d,
+    0x55,0x8e,0x19,0x07,0xcc,0x27,0x2e,0xad,0x44,0x81,0x6b,0x58,0x00,0x96,0x0f,0x8d,
+    0x1d,0x54,0xd2,0x1e,0x1e,0x3e,0x21,0x76,0xd1,0x3e,0x9b,0x64,0xd5,0x93,0x43,0x37,
+    0xc4,0xf0,0x7d,0x9e,0x9e,0x7b,0xbd,0x73,0x17,0x56,0x3d,0xb9,0x6d,0xe3,0x0e,0x1e,
+    0xc2,0xbf,0xe3,0x88,0xc6,0x20,0x91,0x27,0x87,0x5f,0x26,0xfd,0xcb,0xc1,0x64,0x66,
+    0xed,0x5e,0x57,0x9d,0xdd,0xfe,0xe2,0x7a,0xdc,0x6e,0x5f,0x1f,0xfe,0xce,0xae,0xa7,
+    0xed,0x63,0xeb,0xb2,0x1f,0x5c,0x5f,0x1c,0xf3,0xab,0xcb,0xc9,0x9e,0x6d,0x73,0x3e,
+    0x92,0x0c,0xf8,0x7a,0x3c,0xeb,0x4f,0xfa,0xd3,0xa8,0x26,0xe4,0xee,0x43,0x7d,0xcf,
+    0x4e,0xa5,0x7c,0x7c,0x5c,0x3d,0xbf,0xdd,0x9b,0x55,0xb2,0x2e,0x17,0x0f,0xed,0x13,
+    0x79,0x62,0x9d,0xf3,0xde,0xf8,0x62,0xd2,0xd8,0x15,0x0f,0x5f,0xb2,0xc9,0x21,0x1e,
+    0xe3,0xac,0x3b,0x74,0xfa,0x95,0xea,0xef,0xe3,0xf1,0x78,0xb7,0x31,0x3c,0xbd,0xed,
+    0xde,0xec,0xef,0x87,0x74,0xc6,0x46,0xb8,0x96,0xf5,0x0f,0xc7,0x6c,0x80,0x67,0x67,
+    0x6e,0xf7,0x10,0x47,0x35,0xdc,0x3f,0xf3,0xba,0x97,0x38,0xe1,0x78,0x30,0xf4,0xa6,
+    0x1f,0xf0,0xf8,0xc4,0xed,0x4c,0x8f,0xc6,0xbe,0xdb,0x03,0xc7,0x12,0xd6,0x1b,0x84,
+    0xed,0xf1,0x37,0xdc,0x3f,0xf2,0x26,0x04,0x5f,0x76,0x5c,0x98,0x1b,0x2f,0xbe,0xe0,
+    0x61,0x8a,0x1d,0x1b,0x7f,0xb8,0x6a,0xf3,0x0c,0x9f,0xe2,0x13,0x3a,0x7a,0x70,0x9d,
+    0xfd,0xda,0x18,0xb7,0x17,0xa3,0xfd,0x5a,0x8a,0xf1,0xb8,0x53,0xba,0xcf,0xee,0x1c,
+    0xbb,0xef,0xee,0x9f,0x67,0x79,0x3c,0x8e,0x27,0xe7,0x7b,0xbd,0xf8,0xf6,0xd8,0x75,
+    0x5d,0xc0,0xf2,0xc1,0xff,0x55,0xf8,0xdc,0xde,0xf7,0xf0,0x8d,0xc7,0xdf,0xba,0xa0,
+    0xbe,0x97,0xd9,0x71,0x65,0xb4,0x57,0x1d,0xed,0xb6,0xdb,0xe7,0xce,0xd0,0xa3,0xf4,
+    0xc3,0xcd,0x7e,0x89,0x67,0x1f,0x59,0xa3,0xdd,0xe9,0x7e,0x1c,0xb2,0x31,0xbe,0x19,
+    0x5c,0x4d,0xb0,0xeb,0x61,0x6f,0x1f,0x77,0x2f,0x87,0x43,0x6c,0x8f,0xb3,0x6c,0xef,
+    0x06,0x77,0x07,0xc3,0x04,0x5f,0xc1,0xfa,0x3e,0x7e,0x6d,0xed,0x9e,0xba,0x67,0xa3,
+    0xec,0x84,0xe2,0x1b,0x37,0x8e,0x71,0xc7,0xee,0xdf,0x5e,0xe1,0x07,0x37,0xad,0xe3,
+    0xcf,0x8d,0x4e,0x1d,0x5f,0x34,0xba,0x75,0x3c,0x6a,0xf4,0xea,0x78,0x60,0x77,0xfb,
+    0xa5,0x8f,0x4e,0xe5,0x6a,0xdc,0x6e,0x54,0x46,0x41,0xa9,0x73,0x83,0xf1,0x90,0x1c,
+    0x1d,0x1d,0xa7,0x57,0x17,0xe3,0x6a,0x23,0xf7,0x72,0x7a,0x7e,0x71,0x36,0x39,0xd9,
+    0xeb,0x5c,0x1d,0x1d,0x99,0x08,0x46,0x19,0x75,0x0b,0xcc,0x75,0x00,0x73,0x31,0x0b,
+    0x0d,0x6a,0x5b,0xc7,0x5e,0x4d,0x5d,0x61,0x58,0xc9,0xeb,0xd5,0x54,0x7d,0x12,0xbb,
+    0x2c,0x78,0xcf,0xe9,0x5c,0x1c,0xd4,0xca,0xbb,0xd4,0x57,0x21,0x43,0x52,0x1a,0xcc,
+    0x44,0xd0,0x11,0xe4,0x80,0x34,0xa8,0xc1,0x1a,0x35,0x07,0xf5,0x6d,0x41,0xf5,0x97,
+    0x82,0x22,0xa8,0x4c,0x98,0x9d,0x0a,0x49,0x8d,0xf2,0xde,0x33,0x49,0xd0,0x47,0x36,
+    0xc3,0x59,0x31,0x70,0xfd,0xd8,0xa3,0x8a,0x3e,0xb3,0x6e,0x86,0xc6,0xba,0x37,0xe6,
+    0x23,0xca,0x25,0x13,0x1e,0x0c,0x6d,0x7a,0xce,0xf5,0xb3,0x61,0xf5,0xe9,0xe9,0x7f,
+    0x31,0x2e,0x14,0x52,0x5f,0xed,0xc6,0xff,0xd0,0x38,0xd4,0xce,0x07,0x20,0x70,0x6f,
+    0xa7,0x38,0x9d,0xb3,0x38,0x11,0x1d,0x8f,0x71,0x67,0x1d,0x85,0x5f,0xf4,0xd6,0xe5,
+    0xf2,0x5f,0xff,0x05,0x00,0x28,0x6a,0xcf,0x58,0x0f,0x00,0x00,
+};
+
+// tcd.css: 2151 bytes, 1210 compressed
+#define TC_CSS_ETAG "a1335b97"
+static const uint8_t tcd_css_gz[] PROGMEM = {
+    0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x8d,0x55,0x59,0x6f,0xea,0x38,
+    0x14,0x7e,0x9f,0x5f,0x91,0x51,0x75,0xc5,0xad,0x20,0x60,0xc2,0x1e,0x74,0x47,0x0a,
+    0x4b,0x0a,0x94,0x2e,0x84,0xa5,0xb7,0x8c,0xe6,0xc1,0x49,0x4c,0xe2,0xe2,0xd8,0x21,
+    0x31,0x4b,0x1a,0xf1,0xdf,0xc7,0x49,0x80,0x72,0xdb,0xd1,0xcc,0x18,0x05,0xdb,0x67,
+    0xf9,0x7c,0x7c,0xec,0xf3,0xd9,0x64,0x76,0x14,0xaf,0x18,0xe5,0xf2,0x0a,0x7a,0x98,
+    0x44,0xaa,0x0c,0x7d,0x9f,0x20,0x39,0x8c,0x42,0x8e,0xbc,0x42,0x87,0x60,0xba,0x7e,
+    0x80,0xd6,0x34,0x9d,0xea,0xc2,0xae,0x90,0x69,0xe4,0x2d,0x2e,0xe4,0xa6,0xc8,0x61,
+    0x48,0x9a,0x0f,0x73,0x05,0x83,0x99,0x8c,0xb3,0x42,0x6e,0x80,0xc8,0x0e,0x71,0x6c,
+    0x41,0xe9,0x11,0x6d,0x51,0xae,0xb0,0x40,0x81,0x0d,0x29,0x2c,0x5c,0xe4,0xc7,0x41,
+    0xb9,0x30,0x50,0x62,0x0f,0x06,0x0e,0xa6,0x32,0x67,0xbe,0x0a,0xfc,0x43,0xfb,0x34,
+    0x15,0x18,0x9c,0x79,0xa9,0x84,0xa3,0x03,0x97,0x21,0xc1,0x0e,0x55,0x2d,0x44,0x39,
+    0x0a,0xda,0xc7,0x41,0xe5,0xdf,0xdd,0x6a,0xff,0xec,0x66,0xe3,0x5d,0xd1,0x0b,0x9d,
+    0xd8,0x64,0x81,0x8d,0x02,0xb5,0xec,0x1f,0xa4,0x90,0x11,0x6c,0x4b,0x37,0x96,0x65,
+    0xb5,0x33,0xa9,0x4c,0xd0,0x8a,0xcb,0x7b,0x6c,0x73,0x57,0x2d,0x27,0x38,0x27,0x71,
+    0x00,0x6d,0xbc,0x0d,0x55,0x25,0x59,0xcc,0x84,0xd6,0xda,0x09,0xd8,0x96,0xda,0xaa,
+    0x48,0x0a,0x82,0x81,0xec,0x24,0x6a,0xb1,0xca,0xf7,0x8a,0x02,0x6c,0xe4,0x14,0x02,
+    0xc7,0xfc,0xae,0xd4,0x6a,0x85,0xd3,0x77,0x2b,0x81,0x6f,0x99,0xac,0x22,0xe6,0x95,
+    0xaa,0xf8,0x2a,0xb7,0x52,0x19,0x80,0x6f,0xb7,0xed,0xa3,0xb9,0x15,0x31,0xd3,0x98,
+    0x07,0x90,0x86,0x98,0x63,0x46,0x65,0x1b,0x11,0x18,0xa9,0x4a,0x0d,0x78,0x61,0xfb,
+    0x6a,0x9f,0xe5,0xaf,0x1b,0x4d,0x45,0x16,0x23,0x2c,0x50,0x6f,0x56,0xab,0xd5,0x55,
+    0x64,0xf2,0x49,0xaa,0x28,0x35,0xd8,0x6a,0xb6,0xd3,0x73,0xdd,0xc1,0x00,0x43,0xd1,
+    0x5b,0xd0,0x0f,0x55,0x48,0x88,0x1c,0x7a,0xc9,0x7f,0x32,0x3d,0x87,0x51,0xec,0xf5,
+    0xe2,0x93,0x27,0x00,0xe0,0xb4,0x79,0xb5,0x2a,0x32,0x15,0x60,0xdb,0x41,0xd2,0x4d,
+    0xab,0xd5,0xfa,0x9c,0x92,0x5f,0x33,0x72,0x83,0x80,0xd5,0xaa,0x2a,0xd7,0xa1,0x60,
+    0x0f,0x3a,0x48,0xdd,0x06,0xe4,0x7b,0xce,0x86,0x1c,0xaa,0xe9,0xbc,0xe4,0x53,0x47,
+    0x18,0x85,0xa8,0x5e,0x2d,0xe0,0x45,0xe7,0xc9,0xd8,0x83,0xfb,0x3b,0x87,0x69,0xa2,
+    0x3d,0x4e,0xe7,0x6e,0x7f,0xee,0x88,0x51,0x37,0x99,0x6a,0x4e,0x57,0x7b,0x10,0x5d,
+    0xa7,0xef,0x0f,0x83,0xbb,0x44,0x70,0xf7,0xd3,0xd0,0x5f,0x06,0xc6,0xcc,0x54,0x96,
+    0xc0,0x56,0xf4,0x68,0x39,0xe9,0x74,0x96,0x77,0x2d,0xbc,0x9c,0x76,0x46,0xe6,0x8b,
+    0x4e,0x97,0x8b,0x11,0x79,0x7d,0x31,0x6a,0x96,0x45,0xc8,0x73,0xe2,0xd0,0xeb,0x4c,
+    0x66,0xba,0xa1,0x97,0x44,0x4b,0xa6,0x0f,0xd1,0x3a,0x6c,0xe6,0x35,0x6d,0x3b,0x7a,
+    0xc5,0x95,0xc7,0xc1,0x88,0xd5,0xe0,0x44,0xfb,0x1f,0xcd,0x7c,0x2e,0xb7,0xfa,0xfb,
+    0x64,0xe4,0x82,0xf9,0xba,0x36,0x2b,0x9d,0xdb,0xbe,0x87,0x9c,0x46,0x79,0x99,0x68,
+    0xaa,0x7d,0xd2,0x9f,0x2c,0x8c,0xaa,0xb2,0x99,0xce,0xa2,0xc3,0xb8,0x37,0xd4,0x5c,
+    0xbd,0x11,0x75,0xdd,0x69,0xa9,0x51,0x32,0xf7,0x9c,0xe9,0x63,0xe3,0x51,0x57,0xe6,
+    0x9e,0x11,0x80,0x41,0x73,0xa8,0x57,0x4b,0xb3,0x4e,0xf8,0x5a,0x1f,0xd1,0x89,0xbe,
+    0x9b,0x8d,0x9a,0x3d,0x40,0xad,0xae,0x6b,0x82,0xc9,0x1d,0xe9,0xed,0xb4,0xbc,0xbb,
+    0xde,0x97,0xa2,0x6e,0xf5,0xd0,0xef,0x29,0x4b,0x65,0x5c,0xa9,0x1d,0xf6,0x3d,0x63,
+    0x6a,0x6f,0xc6,0x4b,0x5f,0x1f,0x3e,0xcd,0x2b,0xce,0x83,0xc2,0x0e,0x75,0x4f,0xab,
+    0x70,0xda,0x7b,0x86,0xcd,0xf9,0x72,0x05,0x94,0x5d,0x65,0x53,0x77,0xee,0x8d,0x41,
+    0xa9,0x1f,0x39,0xf5,0xd1,0xb2,0xb3,0x31,0xe6,0x5d,0xe3,0x25,0x9f,0x8f,0xf4,0xd7,
+    0xe1,0xae,0xfb,0xf6,0xa8,0x0f,0x79,0xeb,0x69,0xda,0xad,0xba,0x8c,0x94,0x86,0x7c,
+    0x50,0xd6,0xd7,0xf7,0xc6,0xc4,0xd1,0x4c,0x0c,0x78,0xd4,0x5a,0x95,0xf4,0xc6,0xf8,
+    0xa1,0xae,0x63,0x6f,0x02,0xad,0x67,0x53,0xb3,0xef,0x6a,0xef,0xcb,0x05,0x79,0xb1,
+    0x57,0x3b,0x27,0xcf,0xfa,0x3e,0x01,0xaf,0xf9,0xb7,0xf7,0xcd,0x70,0xb4,0xcc,0xe7,
+    0xeb,0xab,0xf1,0x86,0x78,0x1e,0xdd,0x34,0x4c,0xbc,0xac,0xb2,0x7a,0x83,0x38,0x6f,
+    0x1d,0x57,0x03,0xeb,0xdd,0x28,0x9a,0xed,0xf7,0xa5,0xc5,0x3d,0x70,0x47,0x41,0x69,
+    0x3c,0xd8,0x75,0x82,0x6d,0xf3,0xd9,0x68,0xf4,0xfc,0x43,0xeb,0x61,0x06,0x56,0x4d,
+    0xd4,0x50,0xc8,0x4e,0x9b,0xbc,0x6a,0x63,0xa2,0xfd,0xcc,0xdf,0xaf,0xf6,0xc0,0xe8,
+    0xa7,0xf9,0x9d,0xce,0x17,0x4f,0xc6,0x7d,0xad,0xfb,0x3a,0x1c,0xfe,0xc8,0xdd,0x5e,
+    0x5f,0xa1,0x00,0xf9,0x08,0x72,0x95,0xb2,0xd3,0xe8,0x5a,0xc7,0x02,0x2c,0x4a,0x42,
+    0xb5,0xc4,0x15,0x17,0x25,0x28,0x4a,0xe3,0xfa,0x3e,0xca,0x21,0x7e,0x47,0xa9,0x0e,
+    0x62,0x2a,0x6e,0x79,0x10,0xdb,0x38,0xf4,0x93,0xfa,0x32,0x09,0xb3,0xd6,0x59,0x61,
+    0xa4,0x36,0xe5,0xb4,0x94,0x52,0x0c,0x35,0x97,0x3b,0x62,0xea,0x6f,0xf9,0x9f,0x3c,
+    0xf2,0xd1,0x8f,0x9c,0xe5,0x22,0x6b,0x2d,0x70,0x73,0x7f,0x5d,0xbc,0x31,0x4d,0x4a,
+    0x5f,0xce,0x40,0x3e,0x15,0x69,0xe6,0x7b,0xa6,0x19,0xee,0x62,0x2a,0x61,0x1a,0x22,
+    0x7e,0x4c,0xeb,0xed,0x02,0x41,0x19,0x45,0x47,0xe4,0x49,0x7f,0x48,0xbf,0xca,0x33,
+    0xe8,0xe3,0x8a,0x05,0xde,0x99,0xe6,0xd2,0x65,0x64,0x24,0xca,0x0b,0xb4,0x8f,0x45,
+    0xee,0x7b,0xb1,0xb5,0x0d,0x42,0x51,0xa5,0x3e,0xc3,0x29,0xb7,0x7d,0xa1,0x34,0x93,
+    0x88,0x14,0x7c,0xaa,0xd4,0x84,0xce,0x7c,0x68,0xdb,0x98,0x3a,0x2a,0x90,0xd2,0x5f,
+    0xc2,0x28,0x02,0xff,0xc4,0x77,0x4d,0xe4,0x65,0xf0,0x4a,0xec,0xb3,0x8c,0x8c,0x54,
+    0x68,0x0a,0xc0,0x2d,0x47,0xed,0x64,0x77,0x32,0x28,0x36,0x84,0xcd,0xbb,0x8c,0xa9,
+    0x8d,0x0e,0x6a,0xb9,0x02,0xda,0x09,0x5f,0xaa,0x99,0x38,0x75,0xad,0xc4,0x19,0x58,
+    0x55,0x08,0x5c,0x84,0x1d,0x97,0xa7,0xc3,0x54,0xe7,0x96,0xe3,0xff,0x24,0xa2,0xd4,
+    0x60,0x9f,0x39,0x52,0x91,0x02,0x48,0xce,0xe9,0x4d,0x57,0x52,0x2e,0x58,0x95,0xf8,
+    0x9a,0x75,0x12,0xb6,0xfa,0x38,0x4b,0x50,0xac,0x0b,0xbb,0x0b,0x31,0xc2,0xf3,0xb6,
+    0x33,0x8c,0x24,0xd6,0x6b,0x4c,0x50,0xac,0x7d,0x48,0x82,0x74,0xe5,0x4c,0xf4,0x25,
+    0x7d,0xc7,0x62,0x88,0x2c,0x1e,0xc6,0x5f,0x79,0x16,0x21,0xf4,0xc9,0xbc,0xf1,0x85,
+    0xad,0xd3,0xc7,0xe3,0x1c,0xc9,0x49,0xd6,0xb8,0x12,0x25,0x19,0x6e,0x24,0x8b,0x88,
+    0xed,0x81,0x8f,0x13,0x08,0xc4,0x73,0xc0,0xf1,0x0e,0xb5,0xb3,0xc4,0x2a,0xe0,0x12,
+    0xac,0x38,0x45,0xb8,0xe5,0x4c,0xca,0x3a,0x91,0x17,0x17,0x41,0x9b,0xc4,0x17,0x25,
+    0x90,0x44,0xcc,0x12,0xf8,0x38,0xf4,0x63,0xd1,0xf2,0x7c,0x70,0x31,0xf8,0x50,0xb4,
+    0x93,0x9d,0x11,0x10,0x7f,0xa4,0xb0,0x05,0xbe,0x9d,0x16,0x4c,0xb1,0xaf,0xf3,0x95,
+    0xbe,0x3a,0x3b,0x14,0x24,0xaf,0x38,0x39,0xbd,0xb1,0x09,0x93,0x27,0xd7,0x56,0x00,
+    0x79,0xbc,0x76,0xfd,0x3c,0x8b,0x10,0x7e,0xc7,0x9e,0xcf,0x02,0x2e,0x8e,0xfc,0xf8,
+    0xdb,0xdf,0xbc,0xd9,0x1f,0x55,0x67,0x08,0x00,0x00,
+};
+
+#endif
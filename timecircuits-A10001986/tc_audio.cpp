@@ -65,18 +65,27 @@
 #include "src/ESP8266Audio/AudioFileSourceLittleFS.h"
 #endif
 #include "src/ESP8266Audio/AudioFileSourceSD.h"
+#include "src/ESP8266Audio/AudioFileSourceBuffer.h"
+#include "src/ESP8266Audio/AudioFileCache.h"
 #include "src/ESP8266Audio/AudioFileSourcePROGMEM.h"
 
 #include "src/ESP8266Audio/AudioGeneratorMP3.h"
 #include "src/ESP8266Audio/AudioGeneratorWAV.h"
 
 #include "src/ESP8266Audio/AudioOutputI2S.h"
+#include "src/ESP8266Audio/AudioOutputMixer.h"
+#ifdef TC_SNDPART
+#include <esp_partition.h>
+#endif
+#include <esp_timer.h>
 
 #include "tc_time.h"
 #include "tc_settings.h"
 #include "tc_audio.h"
 #include "tc_keypad.h"
 #include "tc_wifi.h"
+#include "tc_mem.h"
+#include "tc_prof.h"
 
 static AudioGeneratorMP3 *mp3;
 static AudioGeneratorWAV *wav;
@@ -87,10 +96,49 @@ static AudioFileSourceSPIFFS *myFS0;
 static AudioFileSourceLittleFS *myFS0;
 #endif
 static AudioFileSourceSD *mySD0;
+static AudioFileSourceBuffer *myBSD0;   // Read-ahead in front of mySD0
+static AudioFileSourceSD *mySD1;
+static AudioFileSourceBuffer *myBSD1;   // Second SD source for gapless MP
+static AudioFileSourceBuffer *curBSD;   // SD source used by play_file()
+#define SD_READAHEAD_SIZE (8*1024)
 static AudioFileSourcePROGMEM *myPM;
 
+// Files of frequently played sounds are kept open after
+// playback, and rewound instead of being looked up again.
+// SD has fewer handles to spare (music player, config).
+static bool snd_keep_open(const char *audio_file);
+static AudioFileCache fsFileCache(4, snd_keep_open);
+static AudioFileCache sdFileCache(2, snd_keep_open);
+
 static AudioOutputI2S *out;
 
+// Decoder memory: Static, reused for every play instead of
+// being malloc'd and freed per file (heap fragmentation)
+#define WAV_BUFF_SIZE 128
+static uint8_t mp3Arena[AudioGeneratorMP3::preAllocSize()] __attribute__((aligned(8)));
+static uint8_t wavArena[WAV_BUFF_SIZE] __attribute__((aligned(4)));
+
+// The mixer sums music (mp3) and effects (wav) into out. Normally
+// only one of them plays; the exception are keypad sounds while the
+// music player is active: These are mixed over the (ducked) music.
+static AudioOutputMixer     *mixer;
+static AudioOutputMixerStub *musOut;
+static AudioOutputMixerStub *fxOut;
+static bool                 fxOverlay = false;
+#define MUS_DUCK_FACT       0.4
+
+#ifdef TC_AUDIO_TASK
+// The audio task runs on core 0, the main loop on core 1. All access
+// to decoders, sources and output is serialized through audioMutex,
+// which is recursive since the task itself reaches play_file() through
+// the music player.
+#define AUDIO_TASK_CORE   0
+#define AUDIO_TASK_PRIO   3
+#define AUDIO_TASK_STACK  10240     // libmad's layer III decoder is stack-hungry
+static TaskHandle_t      audioTaskHandle = NULL;
+static SemaphoreHandle_t audioMutex = NULL;
+#endif
+
 bool audioInitDone = false;
 bool audioMute     = false;
 
@@ -109,6 +157,16 @@ bool            haveId3 = false;
 int             Id3Size;
 char            id3[MAXID3LEN];
 
+// Gapless playback: The next track is opened on the other
+// SD source during the last seconds of the current one
+#define         MP_PRELOAD_BYTES (64*1024)
+static AudioFileSourceBuffer *mpNextSrc = NULL;
+static bool     mpNextTried = false;
+static int      mpNextIdx = 0;
+static bool     haveId3Next = false;
+static int      Id3SizeNext;
+static char     id3Next[MAXID3LEN];
+
 static const float volTable[20] = {
     0.00, 0.02, 0.04, 0.06,
     0.08, 0.10, 0.13, 0.16,
@@ -125,6 +183,20 @@ static int    rawVol[VOL_SMOOTH_SIZE];
 static int    rawVolIdx = 0;
 static int    anaReadCount = 0;
 static long   prev_avg, prev_raw, prev_raw2;
+// The pot is sampled in the background by a periodic esp_timer,
+// averaging the last VOL_ADC_AVG conversions. getRawVolume() only
+// picks up the latest average, so there is no ADC conversion in 
+// the audio path. The timer only runs while the pot is in use and
+// something is playing.
+#define VOL_ADC_INT_US  20000
+#define VOL_ADC_AVG     4
+static esp_timer_handle_t volTimer = NULL;
+static bool               volTimerOn = false;
+static uint16_t           volAdcBuf[VOL_ADC_AVG] = { 0 };
+static uint32_t           volAdcSum = 0;
+static uint8_t            volAdcIdx = 0;
+static uint8_t            volAdcCnt = 0;
+static volatile int       volAdcAvg = -1;
 
 static float  curVolFact = 1.0;
 static bool   curChkNM   = true;
@@ -151,20 +223,130 @@ static char       shsnd[]   = "/hour-00.mp3";   // Not const
 static bool       haveHrSnd = false;
 static uint32_t   haveSpHrSnd = 0;
 
+// RAM cache for short, latency-critical sounds (keypad,
+// enter). Filled once in audio_setup(), played through myPM.
+#define SND_CACHE_SIZE  (24*1024)
+#define SND_CACHE_MAX   12
+typedef struct {
+    char     name[24];    // Names that don't fit are not cached
+    uint32_t offs;
+    uint32_t len;
+    uint16_t flags;       // PA_ISWAV/PA_ALLOWSD as used when caching
+} sndCacheEntry;
+static uint8_t        *sndCachePool = NULL;
+static uint32_t       sndCacheUsed = 0;
+static int            sndCacheNum = 0;
+static sndCacheEntry  sndCache[SND_CACHE_MAX];
+// Reloaded this long after files were replaced (upload, install)
+#define SND_CACHE_RELOAD_DELAY 3000
+static bool           sndCacheReload = false;
+static unsigned long  sndCacheFlushNow = 0;
+
+#ifdef TC_SNDPART
+// Flash partition for effect sounds: An archive of all sound files
+// on flash FS (as many as fit). Layout: Header and directory in first
+// sector, file data from SND_PART_DATA. The directory is sorted by
+// name hash for binary search. Played in place from memory-mapped
+// flash through myPM, no file system access involved.
+#define SND_PART_LABEL  "tcdsnd"
+#define SND_PART_MAGIC  0x32534354    // "TCS2"
+#define SND_PART_MAX    64          // Max 64, see sndPartOnSD
+#define SND_PART_DATA   4096
+typedef struct {
+    uint32_t magic;
+    char     ver[4];      // Audio data version (/VER) it was built from
+    uint32_t num;
+    uint32_t dataLen;
+} sndPartHeader;
+typedef struct {
+    uint32_t hash;
+    uint32_t offs;
+    uint32_t len;
+    uint16_t flags;       // PA_ISWAV
+    char     name[22];
+} sndPartEntry;
+static const esp_partition_t  *sndPart = NULL;
+static spi_flash_mmap_handle_t sndPartHandle;
+static const uint8_t          *sndPartMap = NULL;
+static const sndPartEntry     *sndPartDir = NULL;
+static int                    sndPartNum = 0;
+static uint64_t               sndPartOnSD = 0;  // Entries shadowed by a file on SD
+// Put in first, in this order, should space be short
+static const char *sndPartFiles[] = {
+    "/travelstart.mp3", "/travelstart2.mp3", "/timetravel.mp3",
+    "/enter.mp3", "/baddate.mp3", "/ping.mp3", NULL
+};
+#endif
+
+static void   volTimerCB(void *arg);
+static void   volTimerSet(bool on);
 static float  getVolume();
+static float  getVolumeFact(float volFact, bool chkNM);
+static void   setMusGain();
+static void   setGains();
 #ifdef TC_HAVELINEOUT
 static void   setLineOut(bool doLineOut);
 #endif
 
 static int    mp_findMaxNum();
+static int    mp_readIndex();
+static void   mp_writeIndex(int maxNum);
 static void   mp_nextprev(bool forcePlay, bool next);
 static bool   mp_play_int(bool force);
 static void   mp_buildFileName(char *fnbuf, int num);
 static bool   mp_renameFilesInDir(bool isSetup);
 static void   mpren_quickSort(char **a, int s, int e);
+static void   mp_prepareNext();
+static void   mp_cancelNext();
+static void   mp_handOver();
+static int    readID3(AudioFileSource *src, char *buf, int *size, bool *have);
+
+static void   audio_loop_int();
+static void   snd_cache_setup();
+static void   snd_cache_clear();
+static int    skipID3(char *buf);
+static void   play_file_int(const char *audio_file, uint16_t flags, float volumeFactor);
+static void   play_beep_int();
+static void   play_fx_overlay(const char *audio_file, uint16_t flags, float volumeFactor);
+static int    snd_cache_find(const char *audio_file, uint16_t flags);
+static bool   snd_open_mem(const char *audio_file, uint16_t flags);
+#ifdef TC_SNDPART
+static void   snd_part_setup();
+static void   snd_part_check_sd();
+static int    snd_part_find(const char *audio_file, uint16_t flags);
+#endif
+static void   decodeID3_int(char *artist, char *track);
 
 #include "tc_beep.h"
 
+static inline void audioLock()
+{
+    #ifdef TC_AUDIO_TASK
+    if(audioMutex) xSemaphoreTakeRecursive(audioMutex, portMAX_DELAY);
+    #endif
+}
+
+static inline void audioUnlock()
+{
+    #ifdef TC_AUDIO_TASK
+    if(audioMutex) xSemaphoreGiveRecursive(audioMutex);
+    #endif
+}
+
+#ifdef TC_AUDIO_TASK
+static void audioTask(void *parm)
+{
+    for(;;) {
+        audioLock();
+        audio_loop_int();
+        audioUnlock();
+        // Give the idle task (watchdog!) and others a chance; we
+        // have ~45ms of DMA buffers, so one tick is nothing.
+        vTaskDelay(1);
+    }
+}
+#endif
+
 /*
  * audio_setup()
  */
@@ -174,6 +356,10 @@ void audio_setup()
     audioLogger = &Serial;
     #endif
 
+    #ifdef TC_AUDIO_TASK
+    audioMutex = xSemaphoreCreateRecursiveMutex();
+    #endif
+
     // Init line-out
     if(haveLineOut) {
         // Switch to internal speaker
@@ -189,21 +375,44 @@ void audio_setup()
     analogReadResolution(POT_RESOLUTION);
     analogSetWidth(POT_RESOLUTION);
 
+    {
+        const esp_timer_create_args_t volArgs = {
+            .callback = &volTimerCB,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "volpot"
+        };
+        if(esp_timer_create(&volArgs, &volTimer) != ESP_OK) {
+            volTimer = NULL;
+        }
+    }
+
     out = new AudioOutputI2S(0, AudioOutputI2S::EXTERNAL_I2S, 32, AudioOutputI2S::APLL_DISABLE);
     out->SetOutputModeMono(true);
     out->SetPinout(I2S_BCLK_PIN, I2S_LRCLK_PIN, I2S_DIN_PIN);
 
-    mp3 = new AudioGeneratorMP3();
-    wav = new AudioGeneratorWAV();
+    mixer = new AudioOutputMixer(out);
+    musOut = mixer->NewInput();     // First: Its rate rules
+    fxOut = mixer->NewInput();
+
+    mp3 = new AudioGeneratorMP3(mp3Arena, sizeof(mp3Arena));
+    wav = new AudioGeneratorWAV(wavArena, sizeof(wavArena));
 
     #ifdef USE_SPIFFS
     myFS0 = new AudioFileSourceSPIFFS();
     #else
     myFS0 = new AudioFileSourceLittleFS();
     #endif
+    myFS0->setCache(&fsFileCache);
 
     if(haveSD) {
         mySD0 = new AudioFileSourceSD();
+        myBSD0 = new AudioFileSourceBuffer(mySD0, SD_READAHEAD_SIZE);
+        mySD1 = new AudioFileSourceSD();
+        myBSD1 = new AudioFileSourceBuffer(mySD1, SD_READAHEAD_SIZE);
+        mySD0->setCache(&sdFileCache);
+        mySD1->setCache(&sdFileCache);
+        curBSD = myBSD0;
     }
 
     myPM = new AudioFileSourcePROGMEM();
@@ -211,7 +420,7 @@ void audio_setup()
     loadCurVolume();
 
     loadMusFoldNum();
-    mpShuffle = (settings.shuffle[0] != '0');
+    mpShuffle = cfg.shuffle;
 
     #ifdef TC_HAVELINEOUT
     if(haveLineOut) {
@@ -242,8 +451,26 @@ void audio_setup()
         }
     }
 
+    snd_cache_setup();
+
+    #ifdef TC_SNDPART
+    snd_part_setup();
+    #endif
+
     audioInitDone = true;
 
+    #ifdef TC_AUDIO_TASK
+    if(audioMutex) {
+        if(xTaskCreatePinnedToCore(audioTask, "audio", AUDIO_TASK_STACK, NULL, 
+                                   AUDIO_TASK_PRIO, &audioTaskHandle, AUDIO_TASK_CORE) != pdPASS) {
+            audioTaskHandle = NULL;
+        }
+    }
+    #ifdef TC_DBG
+    Serial.printf("Audio task %s\n", audioTaskHandle ? "started" : "failed, using main loop");
+    #endif
+    #endif
+
     #ifdef TC_DBG
     Serial.printf("haveKeySnd 0x%x, haveSPHrSnd 0x%x\n", haveKeySnd, haveSpHrSnd);
     #endif
@@ -252,38 +479,499 @@ void audio_setup()
 /*
  * audio_loop()
  *
+ * If the audio task is running, this is a no-op; the
+ * task does the work. The calls throughout the main loop
+ * are kept as the fallback in case the task could not be
+ * created.
  */
 void audio_loop()
+{
+    #ifdef TC_AUDIO_TASK
+    if(audioTaskHandle) return;
+    #endif
+
+    audio_loop_int();
+}
+
+static void audio_loop_int()
 {
     //float vol;
+    bool volWant;
+
+    // Sample the pot only if it is used and audio is playing
+    volWant = (curVolume == 255) && (mp3->isRunning() || wav->isRunning());
+    if(volWant != volTimerOn) {
+        volTimerSet(volWant);
+    }
+
+    if(sndCacheReload && !mp3->isRunning() && !wav->isRunning() &&
+       millis() - sndCacheFlushNow > SND_CACHE_RELOAD_DELAY) {
+        sndCacheReload = false;
+        snd_cache_setup();
+        #ifdef TC_SNDPART
+        snd_part_check_sd();
+        #endif
+    }
+
+    // Play out what the mixer still holds of stopped sounds
+    if(!mp3->isRunning() && !wav->isRunning()) {
+        mixer->loop();
+    }
 
     if(wav->isRunning()) {
-        if(!wav->loop()) {
+        bool wavOk;
+        CYC_CALL(CYC_WAV, wavOk = wav->loop());
+        if(!wavOk) {
             wav->stop();
             beepRunning = false;
+            if(fxOverlay) {
+                fxOverlay = false;
+                setMusGain();
+            }
         }
-    } else if(mp3->isRunning()) {
-        if(!mp3->loop()) {
-            mp3->stop();
-            key_playing = 0;
-            if(mpActive) {
-                mp_next(true);
+        // Unless mixed over music, wav and mp3 don't play together
+        if(!fxOverlay) return;
+    }
+
+    if(mp3->isRunning()) {
+        bool mp3Ok;
+        CYC_CALL(CYC_MP3, mp3Ok = mp3->loop());
+        if(!mp3Ok) {
+            // End of track: If the next one is ready, continue
+            // with it without stopping the output
+            if(mpActive && mpNextSrc && mp3->isRunning() && mp3->nextFile(mpNextSrc)) {
+                mp_handOver();
+            } else {
+                #ifdef TC_DBG
+                Serial.printf("Audio: MP3 decoding took %d us/frame (%d frames)\n",
+                    mp3->GetFrameTimeUs(), mp3->GetDecodedFrames());
+                #endif
+                mp3->stop();
+                mp_cancelNext();
+                key_playing = 0;
+                if(mpActive) {
+                    mp_next(true);
+                }
             }
-        } else if(dynVol) {
-            sampleCnt++;
-            if(sampleCnt > 1) {
-                //vol = getVolume();
-                //if(dynVol) out->SetGain(vol);
-                out->SetGain(getVolume());
-                sampleCnt = 0;
+        } else {
+            if(mpActive && !mpNextTried && curBSD->isOpen() &&
+               (curBSD->getSize() - curBSD->getPos() < MP_PRELOAD_BYTES)) {
+                mp_prepareNext();
+            }
+            if(dynVol) {
+                sampleCnt++;
+                if(sampleCnt > 1) {
+                    setMusGain();
+                    sampleCnt = 0;
+                }
             }
         }
-    } else if(mpActive) {
+    } else if(mpActive && !wav->isRunning()) {
         pwrNeedFullNow();
         mp_next(true);
     }
 }
 
+/*
+ * Sound cache
+ */
+
+// Load a file into the cache, taking it from where
+// play_file() would take it given the same flags.
+static void snd_cache_add(const char *audio_file, uint16_t flags)
+{
+    AudioFileSource *src = NULL;
+    sndCacheEntry *e = &sndCache[sndCacheNum];
+    char buf[10];
+    uint32_t sz, pos = 0;
+
+    if(sndCacheNum >= SND_CACHE_MAX || strlen(audio_file) >= sizeof(e->name))
+        return;
+
+    flags &= (PA_ISWAV|PA_ALLOWSD);
+
+    if(haveSD && ((flags & PA_ALLOWSD) || FlashROMode) && mySD0->open(audio_file)) {
+        src = mySD0;
+    }
+    #ifdef USE_SPIFFS
+      else if(haveFS && SPIFFS.exists(audio_file) && myFS0->open(audio_file))
+    #else    
+      else if(haveFS && myFS0->open(audio_file))
+    #endif
+    {
+        src = myFS0;
+    }
+    if(!src) return;
+
+    if(!(flags & PA_ISWAV)) {
+        buf[0] = 0;
+        src->read((void *)buf, 10);
+        pos = skipID3(buf);
+    }
+
+    sz = src->getSize();
+    if(sz > pos && (sz - pos) <= SND_CACHE_SIZE - sndCacheUsed) {
+        sz -= pos;
+        src->seek(pos, SEEK_SET);
+        if(src->read(sndCachePool + sndCacheUsed, sz) == sz) {
+            strcpy(e->name, audio_file);
+            e->offs = sndCacheUsed;
+            e->len = sz;
+            e->flags = flags;
+            sndCacheUsed += (sz + 3) & ~3;
+            if(sndCacheUsed > SND_CACHE_SIZE) sndCacheUsed = SND_CACHE_SIZE;
+            sndCacheNum++;
+        }
+    }
+    
+    src->close();
+}
+
+static void snd_cache_setup()
+{
+    if(!(sndCachePool = (uint8_t *)memIntAlloc(SND_CACHE_SIZE)))
+        return;
+
+    // enter/baddate first, they are the most latency critical
+    snd_cache_add("/enter.mp3", PA_ALLOWSD);
+    snd_cache_add("/baddate.mp3", PA_ALLOWSD);
+    for(int i = 0; i <= 9; i++) {
+        dtmfBuf[6] = '0' + i;
+        snd_cache_add(dtmfBuf, PA_ISWAV);
+    }
+
+    if(!sndCacheNum) {
+        free(sndCachePool);
+        sndCachePool = NULL;
+    } else {
+        // Shrink to what is actually used; entries are offsets,
+        // so it doesn't matter should the block move.
+        uint8_t *t = (uint8_t *)realloc(sndCachePool, sndCacheUsed);
+        if(t) sndCachePool = t;
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("Sound cache: %d files, %d bytes\n", sndCacheNum, sndCacheUsed);
+    #endif
+}
+
+static void snd_cache_clear()
+{
+    sndCacheNum = 0;
+    sndCacheUsed = 0;
+    if(sndCachePool) {
+        free(sndCachePool);
+        sndCachePool = NULL;
+    }
+}
+
+// Open myPM on a cached or flash-partition copy of the file
+static bool snd_open_mem(const char *audio_file, uint16_t flags)
+{
+    int i;
+    
+    if((i = snd_cache_find(audio_file, flags)) >= 0) {
+        return myPM->open(sndCachePool + sndCache[i].offs, sndCache[i].len);
+    }
+
+    #ifdef TC_SNDPART
+    if(sndPartNum) {
+        // Partition holds copies of flash FS files; a file on 
+        // SD takes precedence if the caller allows SD.
+        if((i = snd_part_find(audio_file, flags)) >= 0) {
+            if((flags & PA_ALLOWSD) && (sndPartOnSD & (1ULL << i)))
+                return false;
+            return myPM->open(sndPartMap + sndPartDir[i].offs, sndPartDir[i].len);
+        }
+    }
+    #endif
+
+    return false;
+}
+
+static int snd_cache_find(const char *audio_file, uint16_t flags)
+{
+    flags &= (PA_ISWAV|PA_ALLOWSD);
+    
+    for(int i = 0; i < sndCacheNum; i++) {
+        if(sndCache[i].flags == flags && !strcmp(sndCache[i].name, audio_file))
+            return i;
+    }
+    return -1;
+}
+
+#ifdef TC_SNDPART
+static uint32_t snd_part_hash(const char *name)
+{
+    uint32_t h = 2166136261UL;      // FNV-1a
+
+    while(*name) {
+        h ^= (uint8_t)*name++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+// Binary search in directory; returns index or -1
+static int snd_part_find(const char *audio_file, uint16_t flags)
+{
+    uint32_t h = snd_part_hash(audio_file);
+    int l = 0, r = sndPartNum - 1, m;
+
+    while(l <= r) {
+        m = (l + r) / 2;
+        if(sndPartDir[m].hash < h) l = m + 1;
+        else if(sndPartDir[m].hash > h) r = m - 1;
+        else {
+            // Step back to first entry with this hash
+            while(m > 0 && sndPartDir[m - 1].hash == h) m--;
+            for( ; m < sndPartNum && sndPartDir[m].hash == h; m++) {
+                if((sndPartDir[m].flags & PA_ISWAV) == (flags & PA_ISWAV) &&
+                   !strcmp(sndPartDir[m].name, audio_file))
+                    return m;
+            }
+            return -1;
+        }
+    }
+    return -1;
+}
+
+static bool snd_part_map()
+{
+    const void *p;
+    
+    if(esp_partition_mmap(sndPart, 0, sndPart->size, SPI_FLASH_MMAP_DATA, &p, &sndPartHandle) != ESP_OK)
+        return false;
+        
+    sndPartMap = (const uint8_t *)p;
+    return true;
+}
+
+// Copy one file from flash FS to the partition at *offs
+static bool snd_part_add(const char *audio_file, sndPartEntry *e, uint32_t *offs)
+{
+    uint8_t buf[1024];
+    char hdr[10];
+    uint32_t sz, pos = 0, t;
+    int fnlen = strlen(audio_file);
+    bool isWav;
+
+    if(fnlen < 5 || fnlen >= (int)sizeof(e->name))
+        return false;
+    isWav = !strcasecmp(audio_file + fnlen - 4, ".wav");
+    if(!isWav && strcasecmp(audio_file + fnlen - 4, ".mp3"))
+        return false;
+
+    #ifdef USE_SPIFFS
+    if(!SPIFFS.exists(audio_file)) return false;
+    #endif
+    if(!myFS0->open(audio_file)) return false;
+
+    if(!isWav) {
+        hdr[0] = 0;
+        myFS0->read((void *)hdr, 10);
+        pos = skipID3(hdr);
+    }
+    sz = myFS0->getSize();
+    if(sz <= pos || *offs + sz - pos > sndPart->size) {
+        myFS0->close();
+        return false;
+    }
+    sz -= pos;
+    myFS0->seek(pos, SEEK_SET);
+
+    strcpy(e->name, audio_file);
+    e->hash = snd_part_hash(audio_file);
+    e->offs = *offs;
+    e->len = sz;
+    e->flags = isWav ? PA_ISWAV : 0;
+
+    while(sz) {
+        t = (sz < sizeof(buf)) ? sz : sizeof(buf);
+        if(myFS0->read(buf, t) != t ||
+           esp_partition_write(sndPart, *offs, buf, t) != ESP_OK) {
+            myFS0->close();
+            return false;
+        }
+        *offs += t;
+        sz -= t;
+    }
+    *offs = (*offs + 3) & ~3;
+    
+    myFS0->close();
+    return true;
+}
+
+static bool snd_part_have(const sndPartEntry *dir, int num, const char *audio_file)
+{
+    for(int i = 0; i < num; i++) {
+        if(!strcmp(dir[i].name, audio_file)) return true;
+    }
+    return false;
+}
+
+// Rebuild partition contents from flash FS. The header is written 
+// last, so an interrupted build is simply redone on next boot.
+static void snd_part_build(const char *ver)
+{
+    sndPartHeader hdr;
+    sndPartEntry *dir, te;
+    uint32_t offs = SND_PART_DATA;
+    char fnbuf[sizeof(te.name) + 1];
+    int num = 0;
+
+    if(!(dir = (sndPartEntry *)calloc(SND_PART_MAX, sizeof(sndPartEntry))))
+        return;
+
+    #ifdef TC_DBG
+    Serial.println("Sound partition: Rebuilding");
+    #endif
+
+    if(esp_partition_erase_range(sndPart, 0, sndPart->size) == ESP_OK) {
+
+        // Most important ones first
+        for(int i = 0; sndPartFiles[i] && num < SND_PART_MAX; i++) {
+            if(snd_part_add(sndPartFiles[i], &dir[num], &offs)) num++;
+        }
+        for(int i = 0; i <= 9 && num < SND_PART_MAX; i++) {
+            dtmfBuf[6] = '0' + i;
+            if(snd_part_add(dtmfBuf, &dir[num], &offs)) num++;
+        }
+
+        // Then all other sounds on flash FS, as far as they fit
+        #ifdef USE_SPIFFS
+        File root = SPIFFS.open("/");
+        #else
+        File root = LittleFS.open("/");
+        #endif
+        if(root) {
+            File file = root.openNextFile();
+            while(file && num < SND_PART_MAX) {
+                const char *n = file.name();
+                bool isDir = file.isDirectory();
+                fnbuf[0] = '/';
+                strncpy(fnbuf + 1, (*n == '/') ? n + 1 : n, sizeof(fnbuf) - 2);
+                fnbuf[sizeof(fnbuf) - 1] = 0;
+                file.close();
+                if(!isDir && !snd_part_have(dir, num, fnbuf)) {
+                    if(snd_part_add(fnbuf, &dir[num], &offs)) num++;
+                }
+                file = root.openNextFile();
+            }
+            root.close();
+        }
+
+        // Sort directory by hash
+        for(int i = 1; i < num; i++) {
+            te = dir[i];
+            int j = i - 1;
+            for( ; j >= 0 && dir[j].hash > te.hash; j--) {
+                dir[j + 1] = dir[j];
+            }
+            dir[j + 1] = te;
+        }
+
+        if(num &&
+           esp_partition_write(sndPart, sizeof(hdr), dir, num * sizeof(sndPartEntry)) == ESP_OK) {
+            hdr.magic = SND_PART_MAGIC;
+            memcpy(hdr.ver, ver, 4);
+            hdr.num = num;
+            hdr.dataLen = offs - SND_PART_DATA;
+            esp_partition_write(sndPart, 0, &hdr, sizeof(hdr));
+        }
+    }
+    
+    free(dir);
+
+    #ifdef TC_DBG
+    Serial.printf("Sound partition: %d files, %d bytes\n", num, offs - SND_PART_DATA);
+    #endif
+}
+
+// Find out which files are also on SD once, instead of
+// asking SD on every play
+static void snd_part_check_sd()
+{
+    sndPartOnSD = 0;
+    if(!haveSD) return;
+    
+    for(int i = 0; i < sndPartNum; i++) {
+        if(SD.exists(sndPartDir[i].name)) {
+            sndPartOnSD |= (1ULL << i);
+        }
+    }
+}
+
+static void snd_part_setup()
+{
+    const sndPartHeader *hdr;
+    char ver[4] = { 0 };
+
+    if(!(sndPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, 
+                                            ESP_PARTITION_SUBTYPE_ANY, SND_PART_LABEL)))
+        return;
+
+    if(sndPart->size < SND_PART_DATA * 2)
+        return;
+        
+    // Only files from flash FS are put into the partition
+    if(haveFS && !FlashROMode && haveAudioFiles) {
+        if(myFS0->open("/VER")) {
+            myFS0->read((void *)ver, 4);
+            myFS0->close();
+        }
+    }
+        
+    if(!snd_part_map())
+        return;
+
+    hdr = (const sndPartHeader *)sndPartMap;
+    if(ver[0] && (hdr->magic != SND_PART_MAGIC || memcmp(hdr->ver, ver, 4))) {
+        // Unmap while writing; the mapping would
+        // otherwise show stale cached contents
+        spi_flash_munmap(sndPartHandle);
+        sndPartMap = NULL;
+        snd_part_build(ver);
+        if(!snd_part_map())
+            return;
+        hdr = (const sndPartHeader *)sndPartMap;
+    }
+
+    // Use only if built from the installed audio data
+    if(ver[0] && hdr->magic == SND_PART_MAGIC && !memcmp(hdr->ver, ver, 4) &&
+       hdr->num <= SND_PART_MAX) {
+        sndPartDir = (const sndPartEntry *)(sndPartMap + sizeof(sndPartHeader));
+        sndPartNum = hdr->num;
+        snd_part_check_sd();
+    } else {
+        spi_flash_munmap(sndPartHandle);
+        sndPartMap = NULL;
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("Sound partition: %d files\n", sndPartNum);
+    #endif
+}
+#endif
+
+// Read ID3 tag (if any) into buf, returns position of audio data
+static int readID3(AudioFileSource *src, char *buf, int *size, bool *have)
+{
+    int pos;
+
+    buf[0] = 0;
+    src->read((void *)buf, 10);
+    if((pos = skipID3(buf))) {
+        *size = pos <= MAXID3LEN ? pos : MAXID3LEN;
+        src->read((void *)(buf + 10), *size - 10);
+        *have = true;
+    } else {
+        *have = false;
+    }
+
+    return pos;
+}
+
 static int skipID3(char *buf)
 {
     if(buf[0] == 'I' && buf[1] == 'D' && buf[2] == '3' && 
@@ -302,16 +990,29 @@ static int skipID3(char *buf)
 }
 
 void play_file(const char *audio_file, uint16_t flags, float volumeFactor)
+{
+    if(audioMute) return;
+
+    audioLock();
+    play_file_int(audio_file, flags, volumeFactor);
+    audioUnlock();
+}
+
+static void play_file_int(const char *audio_file, uint16_t flags, float volumeFactor)
 {
     char buf[10];
     int pos;
-    
-    if(audioMute) return;
 
     if(flags & PA_INTRMUS) {
         mpActive = false;
     } else {
-        if(mpActive) return;
+        if(mpActive) {
+            // Keypad sounds are mixed over the music
+            if((flags & PA_ISWAV) && !playLineOut) {
+                play_fx_overlay(audio_file, flags, volumeFactor);
+            }
+            return;
+        }
     }
 
     pwrNeedFullNow();
@@ -343,22 +1044,29 @@ void play_file(const char *audio_file, uint16_t flags, float volumeFactor)
     rawVolIdx = 0;
     anaReadCount = 0;
 
-    out->SetGain(getVolume());
+    setGains();
 
-    if(haveSD && ((flags & PA_ALLOWSD) || FlashROMode) && mySD0->open(audio_file)) {
+    // Cached sounds are played from RAM or mapped flash (myPM 
+    // is free here; stopAudio() above also stopped the beep)
+    if(snd_open_mem(audio_file, flags)) {
+        haveId3 = false;
+        if(flags & PA_ISWAV) {
+            wav->begin(myPM, fxOut);
+        } else {
+            mp3->begin(myPM, musOut);
+        }
+        #ifdef TC_DBG
+        Serial.println(F("Playing from RAM cache"));
+        #endif
+        return;
+    }
+
+    if(haveSD && ((flags & PA_ALLOWSD) || FlashROMode) && curBSD->open(audio_file)) {
         if(!(flags & PA_NOID3TS)) {
-            id3[0] = 0;
-            mySD0->read((void *)id3, 10);
-            if((pos = skipID3(id3))) {
-                Id3Size = pos <= MAXID3LEN ? pos : MAXID3LEN;
-                mySD0->read((void *)((char *)id3 + 10), Id3Size - 10);
-                haveId3 = true;
-            } else {
-                haveId3 = false;
-            }
-            mySD0->seek(pos, SEEK_SET);
+            pos = readID3(curBSD, id3, &Id3Size, &haveId3);
+            curBSD->seek(pos, SEEK_SET);
         }
-        mp3->begin(mySD0, out);
+        mp3->begin(curBSD, musOut);
         #ifdef TC_DBG
         Serial.println(F("Playing from SD"));
         #endif
@@ -375,9 +1083,9 @@ void play_file(const char *audio_file, uint16_t flags, float volumeFactor)
                 myFS0->read((void *)buf, 10);
                 myFS0->seek(skipID3(buf), SEEK_SET);
             }
-            mp3->begin(myFS0, out);
+            mp3->begin(myFS0, musOut);
         } else {
-            wav->begin(myFS0, out);
+            wav->begin(myFS0, fxOut);
         }
         #ifdef TC_DBG
         Serial.println(F("Playing from flash FS"));
@@ -391,6 +1099,41 @@ void play_file(const char *audio_file, uint16_t flags, float volumeFactor)
     }
 }
 
+// Mix a (wav) effect over the music. Only from RAM cache, sound
+// partition or flash FS; the SD source is busy with the music.
+static void play_fx_overlay(const char *audio_file, uint16_t flags, float volumeFactor)
+{
+    if(wav->isRunning()) {
+        wav->stop();
+    }
+    beepRunning = false;
+    fxOverlay = false;
+
+    fxOut->SetGain(getVolumeFact(volumeFactor, (flags & PA_CHECKNM) ? true : false));
+
+    if(snd_open_mem(audio_file, flags)) {
+        fxOverlay = wav->begin(myPM, fxOut);
+    } else if(haveSD && ((flags & PA_ALLOWSD) || FlashROMode)) {
+        return;
+    }
+    #ifdef USE_SPIFFS
+      else if(haveFS && SPIFFS.exists(audio_file) && myFS0->open(audio_file))
+    #else    
+      else if(haveFS && myFS0->open(audio_file))
+    #endif
+    {
+        fxOverlay = wav->begin(myFS0, fxOut);
+    }
+
+    if(fxOverlay) {
+        setMusGain();
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("Audio: Mixing %s over music: %d\n", audio_file, fxOverlay);
+    #endif
+}
+
 /*
  * Play specific sounds
  * 
@@ -398,9 +1141,14 @@ void play_file(const char *audio_file, uint16_t flags, float volumeFactor)
 
 uint16_t play_keypad_sound(char key)
 {
-    uint16_t kp = key_playing;
+    uint16_t kp;
+
+    audioLock();
+    kp = key_playing;
     dtmfBuf[6] = key;
     play_file(dtmfBuf, PA_ISWAV|PA_INTSPKR|PA_CHECKNM, 0.6);
+    audioUnlock();
+
     return kp;
 }
 
@@ -419,6 +1167,13 @@ void play_hour_sound(int hour)
 }
 
 void play_beep()
+{
+    audioLock();
+    play_beep_int();
+    audioUnlock();
+}
+
+static void play_beep_int()
 {
     if(!FPBUnitIsOn     || 
        muteBeep         || 
@@ -447,10 +1202,10 @@ void play_beep()
     // (user might have turned the pot while no sound was played)
     rawVolIdx = 0;
     anaReadCount = 0;
-    out->SetGain(getVolume());
+    setGains();
 
     myPM->open(data_beep_wav, data_beep_wav_len);
-    wav->begin(myPM, out);
+    wav->begin(myPM, fxOut);
     beepRunning = true;
     key_playing = 0;
 }
@@ -467,14 +1222,47 @@ void play_key(int k, uint16_t preDTMFkp)
     if(pa_key == preDTMFkp) {
         return;
     }
+
+    audioLock();
     if(pa_key == key_playing) {
         stopAudio();
-        return;
+    } else {
+        keySnd[4] = '0' + k;
+        play_file(keySnd, pa_key|PA_LINEOUT|PA_CHECKNM|PA_INTRMUS|PA_ALLOWSD|PA_DYNVOL);
     }
+    audioUnlock();
+}
+
+// Runs in the esp_timer task
+static void volTimerCB(void *arg)
+{
+    uint16_t s = analogRead(volumePin);
+
+    volAdcSum -= volAdcBuf[volAdcIdx];
+    volAdcBuf[volAdcIdx] = s;
+    volAdcSum += s;
+    if(++volAdcIdx >= VOL_ADC_AVG) volAdcIdx = 0;
+    if(volAdcCnt < VOL_ADC_AVG) volAdcCnt++;
+
+    volAdcAvg = (volAdcSum + volAdcCnt / 2) / volAdcCnt;
+}
+
+static void volTimerSet(bool on)
+{
+    volTimerOn = on;
     
-    keySnd[4] = '0' + k;
-    
-    play_file(keySnd, pa_key|PA_LINEOUT|PA_CHECKNM|PA_INTRMUS|PA_ALLOWSD|PA_DYNVOL);
+    if(!volTimer) return;
+
+    if(on) {
+        // Start with a fresh average
+        volAdcSum = volAdcIdx = volAdcCnt = 0;
+        memset(volAdcBuf, 0, sizeof(volAdcBuf));
+        volTimerCB(NULL);
+        esp_timer_start_periodic(volTimer, VOL_ADC_INT_US);
+    } else {
+        esp_timer_stop(volTimer);
+        volAdcAvg = -1;
+    }
 }
 
 // Returns value for volume based on the position of the pot
@@ -485,7 +1273,10 @@ static float getRawVolume()
     long avg = 0, avg1 = 0, avg2 = 0;
     long raw;
 
-    raw = analogRead(volumePin);
+    // Latest average from background sampler; direct read
+    // if it is not running (eg at start of playback, in
+    // volume menu), or could not be set up
+    raw = (volTimerOn && volAdcAvg >= 0) ? volAdcAvg : analogRead(volumePin);
 
     if(anaReadCount > 1) {
       
@@ -543,6 +1334,11 @@ static float getRawVolume()
 }
 
 static float getVolume()
+{
+    return getVolumeFact(curVolFact, curChkNM);
+}
+
+static float getVolumeFact(float volFact, bool chkNM)
 {
     float vol_val = 1.0;
 
@@ -557,10 +1353,10 @@ static float getVolume()
         if(vol_val == 0.0) return vol_val;
     }
 
-    vol_val *= curVolFact;
+    vol_val *= volFact;
 
     // Reduce volume in night mode, if requested
-    if(curChkNM && presentTime.getNightMode()) {
+    if(chkNM && presentTime.getNightMode()) {
         vol_val *= 0.3;
     }
 
@@ -571,6 +1367,28 @@ static float getVolume()
     return vol_val;
 }
 
+// Music gain, ducked while an effect is mixed over it
+static void setMusGain()
+{
+    float vol_val = getVolume();
+
+    if(fxOverlay) {
+        vol_val *= MUS_DUCK_FACT;
+        if(vol_val < 0.02) vol_val = 0.02;
+    }
+    
+    musOut->SetGain(vol_val);
+}
+
+// Gain for a sound played on its own (through either voice)
+static void setGains()
+{
+    float vol_val = getVolume();
+    
+    musOut->SetGain(vol_val);
+    fxOut->SetGain(vol_val);
+}
+
 #ifdef TC_HAVELINEOUT
 static void setLineOut(bool doLineOut)
 {
@@ -616,24 +1434,139 @@ int getSWVolFromHWVol()
 
 bool checkAudioDone()
 {
-    if(mp3->isRunning() || wav->isRunning()) return false;
-    return true;
+    bool ret;
+
+    audioLock();
+    ret = !(mp3->isRunning() || wav->isRunning());
+    audioUnlock();
+
+    return ret;
 }
 
 bool checkMP3Done()
 {
-    if(mp3->isRunning() || (wav->isRunning() && !beepRunning)) return false;
-    return true;
+    bool ret;
+
+    audioLock();
+    ret = !(mp3->isRunning() || (wav->isRunning() && !beepRunning));
+    audioUnlock();
+
+    return ret;
+}
+
+// Close all files kept open. Must be called before sound
+// files are overwritten or removed (upload, audio install).
+// RAM cached sounds are dropped as well, and reloaded from
+// audio_loop() once nothing was replaced for a while.
+void flushOpenAudioFiles()
+{
+    audioLock();
+    fsFileCache.flush();
+    sdFileCache.flush();
+    if(audioInitDone) {
+        snd_cache_clear();
+        #ifdef TC_SNDPART
+        // Until checked again, let SD be asked
+        sndPartOnSD = ~0ULL;
+        #endif
+        sndCacheReload = true;
+        sndCacheFlushNow = millis();
+    }
+    audioUnlock();
+}
+
+static bool snd_keep_open(const char *audio_file)
+{
+    static const char *hot[] = {
+        "/ttaccel.mp3", "/travelstart.mp3", "/travelstart2.mp3", 
+        "/timetravel.mp3", "/alarm.mp3", "/enter.mp3", NULL
+    };
+
+    if(!strncmp(audio_file, "/hour", 5))
+        return true;
+        
+    for(int i = 0; hot[i]; i++) {
+        if(!strcmp(audio_file, hot[i])) return true;
+    }
+    return false;
 }
 
 void stopAudio()
 {
+    audioLock();
     if(mp3->isRunning()) {
         mp3->stop();
-    } else if(wav->isRunning()) {
+    }
+    if(wav->isRunning()) {
         wav->stop();
     }
+    mp_cancelNext();
+    fxOverlay = false;
     key_playing = 0;
+    audioUnlock();
+}
+
+/*
+ * Decoder benchmark: Decode an mp3 file (for at most maxMs) into a
+ * sink that discards everything, so decoding runs as fast as it can.
+ * Returns the decoding time per frame in us, 0 if the file was not 
+ * found. Stops whatever is playing.
+ */
+
+namespace {
+class AudioOutputNull : public AudioOutput
+{
+  public:
+    virtual bool begin() override { return true; }
+    virtual bool ConsumeSample(int16_t sample[2]) override { (void)sample; return true; }
+    virtual uint16_t ConsumeSamples(int16_t *samples, uint16_t count) override { (void)samples; return count; }
+    virtual bool stop() override { return true; }
+};
+}
+
+uint32_t audio_bench_mp3(const char *audio_file, bool fromSD, uint32_t maxMs, uint32_t& frames)
+{
+    static AudioOutputNull nullOut;
+    AudioFileSource *src = NULL;
+    uint32_t us = 0;
+    char buf[10];
+
+    frames = 0;
+
+    audioLock();
+
+    stopAudio();
+
+    if(fromSD) {
+        if(haveSD && curBSD->open(audio_file)) {
+            int pos = readID3(curBSD, id3, &Id3Size, &haveId3);
+            curBSD->seek(pos, SEEK_SET);
+            src = curBSD;
+        }
+    } else if(haveFS && myFS0->open(audio_file)) {
+        buf[0] = 0;
+        myFS0->read((void *)buf, 10);
+        myFS0->seek(skipID3(buf), SEEK_SET);
+        src = myFS0;
+    }
+
+    if(src && mp3->begin(src, &nullOut)) {
+        unsigned long now = millis();
+        while(mp3->isRunning() && mp3->loop() && (millis() - now < maxMs)) {
+            if(fromSD) curBSD->loop();
+        }
+        frames = mp3->GetDecodedFrames();
+        us = mp3->GetFrameTimeUs();
+        if(mp3->isRunning()) mp3->stop();
+    } else if(src) {
+        src->close();
+    }
+
+    haveId3 = false;
+
+    audioUnlock();
+
+    return us;
 }
 
 /*
@@ -693,6 +1626,15 @@ static void copyId3String(char *src, char *dst, int tagSz, int maxChrs)
 }
 
 void decodeID3(char *artist, char *track)
+{
+    *artist = *track = 0;
+
+    audioLock();
+    decodeID3_int(artist, track);
+    audioUnlock();
+}
+
+static void decodeID3_int(char *artist, char *track)
 {
     uint8_t rev = id3[3];
     char *ptr  = id3 + 10;
@@ -703,8 +1645,6 @@ void decodeID3(char *artist, char *track)
     unsigned long tagSz, offSet;
     char tFlags[2] = { 0, 0 };
 
-    *artist = *track = 0;
-    
     if(!haveId3) return;
 
     // Unsynchronizing not supported
@@ -803,6 +1743,10 @@ void decodeID3(char *artist, char *track)
 void mp_init(bool isSetup) 
 {
     char fnbuf[20];
+
+    audioLock();
+
+    mp_cancelNext();
     
     haveMusic = false;
 
@@ -815,23 +1759,33 @@ void mp_init(bool isSetup)
     
     if(haveSD) {
         int i, j;
+        bool renOk;
 
         #ifdef TC_DBG_MP
         Serial.println("MusicPlayer: Checking for music files");
         #endif
 
-        mp_renameFilesInDir(isSetup);
+        renOk = mp_renameFilesInDir(isSetup);
 
         mp_buildFileName(fnbuf, 0);
         if(SD.exists(fnbuf)) {
             haveMusic = true;
             
-            maxMusic = mp_findMaxNum();
+            // Use the folder index if it is still valid,
+            // otherwise determine the last number anew.
+            // The index is the DONE file; only write it if
+            // the renamer has completed, otherwise renaming 
+            // would be skipped from now on.
+            if((i = mp_readIndex()) < 0) {
+                i = mp_findMaxNum();
+                if(renOk) mp_writeIndex(i);
+            }
+            maxMusic = i;
             #ifdef TC_DBG_MP
             Serial.printf("MusicPlayer: last file num %d\n", maxMusic);
             #endif
 
-            playList = (uint16_t *)malloc((maxMusic + 1) * 2);
+            playList = (uint16_t *)memBulkAlloc((maxMusic + 1) * 2, MEM_BLK_PLIST);
 
             if(!playList) {
 
@@ -853,6 +1807,8 @@ void mp_init(bool isSetup)
             #endif
         }
     }
+
+    audioUnlock();
 }
 
 static bool mp_checkForFile(int num)
@@ -889,6 +1845,53 @@ static int mp_findMaxNum()
     return i;
 }
 
+/*
+ * Folder index
+ * The DONE file doubles as index; it holds the number
+ * of the last file in the folder. The index is valid if 
+ * that file exists and the next number does not; this
+ * costs two lookups instead of the binary search above.
+ */
+
+static int mp_readIndex()
+{
+    char fnbuf[32];
+    char buf[16];
+    int  num = -1, len;
+
+    sprintf(fnbuf, "/music%1d%s", musFolderNum, tcdrdone);
+    File idx = SD.open(fnbuf);
+    if(!idx) return -1;
+    len = idx.read((uint8_t *)buf, sizeof(buf) - 1);
+    idx.close();
+    
+    if(len < 8) return -1;
+    buf[len] = 0;
+    if(strncmp(buf, "TCDIDX ", 7)) return -1;
+    num = atoi(buf + 7);
+
+    if(num < 0 || num > 999 || !mp_checkForFile(num) || mp_checkForFile(num + 1)) {
+        #ifdef TC_DBG_MP
+        Serial.printf("MusicPlayer: Index %d stale\n", num);
+        #endif
+        return -1;
+    }
+
+    return num;
+}
+
+static void mp_writeIndex(int maxNum)
+{
+    char fnbuf[32];
+
+    sprintf(fnbuf, "/music%1d%s", musFolderNum, tcdrdone);
+    File idx = SD.open(fnbuf, FILE_WRITE);
+    if(idx) {
+        idx.printf("TCDIDX %03d\n", maxNum);
+        idx.close();
+    }
+}
+
 void mp_makeShuffle(bool enable)
 {
     int numMsx = maxMusic + 1;
@@ -896,6 +1899,11 @@ void mp_makeShuffle(bool enable)
     mpShuffle = enable;
 
     if(!haveMusic) return;
+
+    audioLock();
+
+    // Prepared next track is from the old order
+    mp_cancelNext();
     
     for(int i = 0; i < numMsx; i++) {
         playList[i] = i;
@@ -915,13 +1923,19 @@ void mp_makeShuffle(bool enable)
         }
         #endif
     }
+
+    audioUnlock();
 }
 
 void mp_play(bool forcePlay)
 {
-    int oldIdx = mpCurrIdx;
+    int oldIdx;
 
     if(!haveMusic) return;
+
+    audioLock();
+
+    oldIdx = mpCurrIdx;
     
     do {
         if(mp_play_int(forcePlay)) {
@@ -931,16 +1945,25 @@ void mp_play(bool forcePlay)
         mpCurrIdx++;
         if(mpCurrIdx > maxMusic) mpCurrIdx = 0;
     } while(oldIdx != mpCurrIdx);
+
+    audioUnlock();
 }
 
 bool mp_stop()
 {
-    bool ret = mpActive;
+    bool ret;
+
+    audioLock();
+
+    ret = mpActive;
     
     if(mpActive) {
         mp3->stop();
+        mp_cancelNext();
         mpActive = false;
     }
+
+    audioUnlock();
     
     return ret;
 }
@@ -957,9 +1980,13 @@ void mp_prev(bool forcePlay)
 
 static void mp_nextprev(bool forcePlay, bool next)
 {
-    int oldIdx = mpCurrIdx;
+    int oldIdx;
 
     if(!haveMusic) return;
+
+    audioLock();
+
+    oldIdx = mpCurrIdx;
     
     do {
         if(next) {
@@ -974,12 +2001,18 @@ static void mp_nextprev(bool forcePlay, bool next)
             break;
         }
     } while(oldIdx != mpCurrIdx);
+
+    audioUnlock();
 }
 
 int mp_gotonum(int num, bool forcePlay)
 {
+    int ret;
+
     if(!haveMusic) return 0;
 
+    audioLock();
+
     if(num < 0) num = 0;
     else if(num > maxMusic) num = maxMusic;
 
@@ -995,7 +2028,11 @@ int mp_gotonum(int num, bool forcePlay)
 
     mp_play(forcePlay);
 
-    return playList[mpCurrIdx];
+    ret = playList[mpCurrIdx];
+
+    audioUnlock();
+
+    return ret;
 }
 
 static bool mp_play_int(bool force)
@@ -1011,6 +2048,64 @@ static bool mp_play_int(bool force)
     return false;
 }
 
+// Open the track following the current one on the SD source
+// not in use, skip its ID3 tag and prime the read-ahead
+static void mp_prepareNext()
+{
+    char fnbuf[20];
+    int  idx = mpCurrIdx;
+    AudioFileSourceBuffer *src = (curBSD == myBSD0) ? myBSD1 : myBSD0;
+
+    mpNextTried = true;
+
+    if(!haveMusic || !src) return;
+
+    do {
+        idx++;
+        if(idx > maxMusic) idx = 0;
+        mp_buildFileName(fnbuf, playList[idx]);
+        if(SD.exists(fnbuf) && src->open(fnbuf)) {
+            src->seek(readID3(src, id3Next, &Id3SizeNext, &haveId3Next), SEEK_SET);
+            src->loop();
+            mpNextSrc = src;
+            mpNextIdx = idx;
+            #ifdef TC_DBG_MP
+            Serial.printf("MusicPlayer: Prepared %s\n", fnbuf);
+            #endif
+            return;
+        }
+    } while(idx != mpCurrIdx);
+}
+
+static void mp_cancelNext()
+{
+    if(mpNextSrc) {
+        mpNextSrc->close();
+        mpNextSrc = NULL;
+    }
+    mpNextTried = false;
+}
+
+// Decoder continues with mpNextSrc; make it current
+static void mp_handOver()
+{
+    curBSD = mpNextSrc;
+    mpNextSrc = NULL;
+    mpNextTried = false;
+    
+    mpCurrIdx = mpNextIdx;
+    currPlaying = playList[mpCurrIdx];
+
+    if((haveId3 = haveId3Next)) {
+        Id3Size = Id3SizeNext;
+        memcpy(id3, id3Next, Id3Size);
+    }
+
+    #ifdef TC_DBG_MP
+    Serial.printf("MusicPlayer: Gapless handover to %d\n", currPlaying);
+    #endif
+}
+
 int mp_get_currently_playing()
 {
     if(!haveMusic || !mpActive)
@@ -1201,13 +2296,13 @@ static bool mp_renameFilesInDir(bool isSetup)
     }
         
     // Allocate pointer array
-    if(!(a = (char **)malloc(1000*sizeof(char *)))) {
+    if(!(a = (char **)memBulkAlloc(1000*sizeof(char *), MEM_BLK_MPSORT))) {
         origin.close();
         return false;
     }
 
     // Allocate (first) buffer for file names
-    if(!(bufs[0] = (char *)malloc(bufSizes[0]))) {
+    if(!(bufs[0] = (char *)memBulkAlloc(bufSizes[0], MEM_BLK_MPSORT))) {
         origin.close();
         free(a);
         return false;
@@ -1242,7 +2337,7 @@ static bool mp_renameFilesInDir(bool isSetup)
             sz = strLength - nameOffs + 1;
             if((sz > bufSize) && (allocBufIdx < 7)) {
                 allocBufIdx++;
-                if(!(bufs[allocBufIdx] = (char *)malloc(bufSizes[allocBufIdx]))) {
+                if(!(bufs[allocBufIdx] = (char *)memBulkAlloc(bufSizes[allocBufIdx], MEM_BLK_MPSORT))) {
                     #ifdef TC_DBG_MP
                     Serial.printf("%sFailed to allocate additional sort buffer\n", funcName);
                     #endif
@@ -1280,7 +2375,7 @@ static bool mp_renameFilesInDir(bool isSetup)
             sz = strLength - nameOffs + 1;
             if((sz > bufSize) && (allocBufIdx < 7)) {
                 allocBufIdx++;
-                if(!(bufs[allocBufIdx] = (char *)malloc(bufSizes[allocBufIdx]))) {
+                if(!(bufs[allocBufIdx] = (char *)memBulkAlloc(bufSizes[allocBufIdx], MEM_BLK_MPSORT))) {
                     #ifdef TC_DBG_MP
                     Serial.printf("%sFailed to allocate additional sort buffer\n", funcName);
                     #endif
@@ -81,8 +81,11 @@ int   getSWVolFromHWVol();
 bool  checkAudioDone();
 bool  checkMP3Done();
 void  stopAudio();
+void  flushOpenAudioFiles();
 void  decodeID3(char *artist, char *track);
 
+uint32_t audio_bench_mp3(const char *audio_file, bool fromSD, uint32_t maxMs, uint32_t& frames);
+
 void  mp_init(bool isSetup = false);
 void  mp_play(bool forcePlay = true);
 bool  mp_stop();
@@ -0,0 +1,292 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * On-device benchmark
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SD.h>
+#include <FS.h>
+#ifdef USE_SPIFFS
+#include <SPIFFS.h>
+#else
+#define SPIFFS LittleFS
+#include <LittleFS.h>
+#endif
+
+#include "tc_bench.h"
+#include "tc_audio.h"
+#include "tc_settings.h"
+#include "tc_time.h"
+
+// Test file: Exists on flash FS (default audio), and usually on SD
+#define BENCH_FILE      "/travelstart.mp3"
+#define BENCH_MP3_MS    3000
+#define BENCH_RD_BUF    4096
+#define BENCH_I2C_ITER  20
+#define BENCH_CAL_ITER  2000
+
+static const char *benchI2CNames[BENCH_NUM_I2C] = {
+    "dest", "pres", "dept", "speedo", "gps", "rtc", "temp", "light"
+};
+
+static benchResults benchRes = { 0 };
+
+static uint32_t benchRead(fs::FS& fs, const char *fn)
+{
+    uint8_t *buf;
+    uint32_t total = 0;
+    unsigned long t;
+    File f;
+
+    if(!(buf = (uint8_t *)malloc(BENCH_RD_BUF)))
+        return BENCH_NA;
+
+    if(!(f = fs.open(fn, FILE_READ))) {
+        free(buf);
+        return BENCH_NA;
+    }
+
+    t = micros();
+    while(f.available()) {
+        size_t r = f.read(buf, BENCH_RD_BUF);
+        if(!r) break;
+        total += r;
+    }
+    t = micros() - t;
+    
+    f.close();
+    free(buf);
+
+    return (uint32_t)(((uint64_t)total * 1000000ULL) / (1024ULL * (t ? t : 1)));
+}
+
+// Address-only transaction (START, address, STOP); 
+// returns average in tenths of us
+static uint32_t benchI2C(TwoWire& bus, uint8_t addr)
+{
+    unsigned long t;
+
+    if(!addr)
+        return BENCH_NA;
+
+    bus.beginTransmission(addr);
+    if(bus.endTransmission(true))
+        return BENCH_NA;
+
+    t = micros();
+    for(int i = 0; i < BENCH_I2C_ITER; i++) {
+        bus.beginTransmission(addr);
+        bus.endTransmission(true);
+    }
+    t = micros() - t;
+
+    return t * 10 / BENCH_I2C_ITER;
+}
+
+static void benchCalendar()
+{
+    volatile uint64_t vsum = 0;
+    uint64_t mins;
+    int y, m, d, h, mi;
+    unsigned long t;
+    DateTime dtu, dtl;
+
+    t = micros();
+    for(int i = 0; i < BENCH_CAL_ITER; i++) {
+        vsum += dateToMins(1 + (i * 7) % 9998, 1 + i % 12, 1 + i % 28, i % 24, i % 60);
+    }
+    benchRes.d2mNs = (micros() - t) * 1000 / BENCH_CAL_ITER;
+
+    mins = vsum / BENCH_CAL_ITER;
+    t = micros();
+    for(int i = 0; i < BENCH_CAL_ITER; i++) {
+        minsToDate(mins + (uint64_t)i * 104729, y, m, d, h, mi);
+        vsum += y;
+    }
+    benchRes.m2dNs = (micros() - t) * 1000 / BENCH_CAL_ITER;
+
+    myrtcnow(dtu);
+    t = micros();
+    for(int i = 0; i < BENCH_CAL_ITER; i++) {
+        UTCtoLocal(dtu, dtl, 0);
+        vsum += dtl.minute();
+    }
+    benchRes.u2lNs = (micros() - t) * 1000 / BENCH_CAL_ITER;
+}
+
+void benchRun()
+{
+    uint8_t addrs[BENCH_NUM_I2C] = { 0 };
+    TwoWire *buses[BENCH_NUM_I2C];
+
+    Serial.println("Benchmark: Running");
+
+    benchRes.cpuMHz = getCpuFrequencyMhz();
+
+    // MP3 decoding
+    benchRes.mp3SDUs = benchRes.mp3FSUs = BENCH_NA;
+    benchRes.mp3SDFrames = benchRes.mp3FSFrames = 0;
+    if(haveSD && SD.exists(BENCH_FILE)) {
+        benchRes.mp3SDUs = audio_bench_mp3(BENCH_FILE, true, BENCH_MP3_MS, benchRes.mp3SDFrames);
+        if(!benchRes.mp3SDFrames) benchRes.mp3SDUs = BENCH_NA;
+    }
+    if(haveFS) {
+        benchRes.mp3FSUs = audio_bench_mp3(BENCH_FILE, false, BENCH_MP3_MS, benchRes.mp3FSFrames);
+        if(!benchRes.mp3FSFrames) benchRes.mp3FSUs = BENCH_NA;
+    }
+
+    // File system throughput
+    benchRes.sdKBps = haveSD ? benchRead(SD, BENCH_FILE) : BENCH_NA;
+    benchRes.fsKBps = haveFS ? benchRead(SPIFFS, BENCH_FILE) : BENCH_NA;
+
+    // i2c
+    for(int i = 0; i < BENCH_NUM_I2C; i++) {
+        buses[i] = &TC_FASTWIRE;
+    }
+    addrs[BENCH_I2C_DEST] = destinationTime.getAddress();
+    addrs[BENCH_I2C_PRES] = presentTime.getAddress();
+    addrs[BENCH_I2C_DEPT] = departedTime.getAddress();
+    #ifdef TC_HAVESPEEDO
+    if(useSpeedo) addrs[BENCH_I2C_SPEEDO] = speedo.getAddress();
+    buses[BENCH_I2C_SPEEDO] = &Wire;
+    #endif
+    #if defined(TC_HAVEGPS) && !defined(TC_GPS_UART)
+    if(useGPS) addrs[BENCH_I2C_GPS] = myGPS.getAddress();
+    buses[BENCH_I2C_GPS] = &Wire;
+    #endif
+    addrs[BENCH_I2C_RTC] = rtc.getAddress();
+    #ifdef TC_HAVETEMP
+    if(useTemp) addrs[BENCH_I2C_TEMP] = tempSens.getAddress();
+    #endif
+    #ifdef TC_HAVELIGHT
+    if(useLight) addrs[BENCH_I2C_LIGHT] = lightSens.getAddress();
+    #endif
+    for(int i = 0; i < BENCH_NUM_I2C; i++) {
+        benchRes.i2cUs[i] = benchI2C(*buses[i], addrs[i]);
+    }
+
+    // Calendar
+    benchCalendar();
+
+    // BTTFN
+    bttfnGetPktStats(benchRes.bttfnPkts, benchRes.bttfnNs);
+    if(!benchRes.bttfnPkts) benchRes.bttfnNs = BENCH_NA;
+
+    benchRes.runs++;
+
+    #define BENCH_PR(n, v, u) \
+        if((v) != BENCH_NA) Serial.printf("  %-14s %8u %s\n", n, v, u); \
+        else                Serial.printf("  %-14s %8s\n", n, "n/a");
+    Serial.printf("Benchmark results (%dMHz):\n", benchRes.cpuMHz);
+    BENCH_PR("mp3 sd", benchRes.mp3SDUs, "us/frame");
+    BENCH_PR("mp3 flash", benchRes.mp3FSUs, "us/frame");
+    BENCH_PR("read sd", benchRes.sdKBps, "KB/s");
+    BENCH_PR("read flash", benchRes.fsKBps, "KB/s");
+    for(int i = 0; i < BENCH_NUM_I2C; i++) {
+        char buf[16];
+        sprintf(buf, "i2c %s", benchI2CNames[i]);
+        BENCH_PR(buf, benchRes.i2cUs[i], "us/10");
+    }
+    BENCH_PR("dateToMins", benchRes.d2mNs, "ns");
+    BENCH_PR("minsToDate", benchRes.m2dNs, "ns");
+    BENCH_PR("UTCtoLocal", benchRes.u2lNs, "ns");
+    BENCH_PR("bttfn packet", benchRes.bttfnNs, "ns");
+    #undef BENCH_PR
+}
+
+bool benchGetResults(benchResults& br)
+{
+    br = benchRes;
+    return (benchRes.runs != 0);
+}
+
+const char *benchI2CName(int idx)
+{
+    return (idx >= 0 && idx < BENCH_NUM_I2C) ? benchI2CNames[idx] : "";
+}
+
+// For /api/bench; unavailable values are -1
+int benchToJSON(char *buf, int bufSize)
+{
+    int len;
+
+    #define BENCH_JV(v) ((v) != BENCH_NA ? (int32_t)(v) : -1)
+
+    if(!benchRes.runs) {
+        return snprintf(buf, bufSize, "{\"runs\":0}");
+    }
+
+    len = snprintf(buf, bufSize, 
+        "{\"runs\":%u,\"cpuMHz\":%u,"
+        "\"mp3\":{\"sd\":%d,\"sdFrames\":%u,\"flash\":%d,\"flashFrames\":%u},"
+        "\"readKBps\":{\"sd\":%d,\"flash\":%d},"
+        "\"calNs\":{\"dateToMins\":%u,\"minsToDate\":%u,\"UTCtoLocal\":%u},"
+        "\"bttfn\":{\"packets\":%u,\"ns\":%d},\"i2cUs10\":{",
+        benchRes.runs, benchRes.cpuMHz,
+        BENCH_JV(benchRes.mp3SDUs), benchRes.mp3SDFrames, 
+        BENCH_JV(benchRes.mp3FSUs), benchRes.mp3FSFrames,
+        BENCH_JV(benchRes.sdKBps), BENCH_JV(benchRes.fsKBps),
+        benchRes.d2mNs, benchRes.m2dNs, benchRes.u2lNs,
+        benchRes.bttfnPkts, BENCH_JV(benchRes.bttfnNs));
+
+    for(int i = 0; i < BENCH_NUM_I2C && len < bufSize; i++) {
+        len += snprintf(buf + len, bufSize - len, "%s\"%s\":%d", 
+                    i ? "," : "", benchI2CNames[i], BENCH_JV(benchRes.i2cUs[i]));
+    }
+    if(len < bufSize) {
+        len += snprintf(buf + len, bufSize - len, "}}");
+    }
+
+    #undef BENCH_JV
+
+    return (len < bufSize) ? len : bufSize - 1;
+}
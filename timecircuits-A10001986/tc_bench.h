@@ -0,0 +1,105 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * On-device benchmark
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_BENCH_H
+#define _TC_BENCH_H
+
+/*
+ * On-device benchmark
+ *
+ * Run from the keypad menu (hold ENTER on "VERSION"). Measures MP3 
+ * decoding time per frame from SD and flash FS, read throughput of
+ * both, i2c transaction latency per device, the cost of the calendar
+ * conversions, and the average cost of BTTFN packet handling (from 
+ * live traffic since boot). Results are printed to Serial, shown on
+ * the displays and served as JSON at /api/bench.
+ *
+ * Audio is stopped, and the main loop blocked, while the suite runs
+ * (a few seconds).
+ */
+
+enum {
+    BENCH_I2C_DEST = 0,
+    BENCH_I2C_PRES,
+    BENCH_I2C_DEPT,
+    BENCH_I2C_SPEEDO,
+    BENCH_I2C_GPS,
+    BENCH_I2C_RTC,
+    BENCH_I2C_TEMP,
+    BENCH_I2C_LIGHT,
+    BENCH_NUM_I2C
+};
+
+#define BENCH_NA    0xffffffff
+
+typedef struct {
+    uint32_t runs;
+    uint32_t cpuMHz;
+    uint32_t mp3SDUs;           // us per frame; BENCH_NA if no file
+    uint32_t mp3SDFrames;
+    uint32_t mp3FSUs;
+    uint32_t mp3FSFrames;
+    uint32_t sdKBps;            // BENCH_NA if no file
+    uint32_t fsKBps;
+    uint32_t i2cUs[BENCH_NUM_I2C];  // per transaction (x10); BENCH_NA if absent
+    uint32_t d2mNs;             // dateToMins(), ns per call
+    uint32_t m2dNs;             // minsToDate()
+    uint32_t u2lNs;             // UTCtoLocal()
+    uint32_t bttfnPkts;
+    uint32_t bttfnNs;           // per packet; BENCH_NA if none yet
+} benchResults;
+
+void benchRun();
+bool benchGetResults(benchResults& br);
+const char *benchI2CName(int idx);
+int  benchToJSON(char *buf, int bufSize);
+
+#endif
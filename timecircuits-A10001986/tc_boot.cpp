@@ -0,0 +1,110 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Boot profiler
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include "tc_boot.h"
+
+static struct {
+    const char *phase;
+    uint32_t   us;              // since power-on
+    uint32_t   freeHeap;
+} bootMarks[BOOT_MAX_MARKS];
+static int bootNumMarks = 0;
+
+/*
+ * Record end of a boot phase (or a milestone). The phase
+ * name must be a string constant. Marks beyond
+ * BOOT_MAX_MARKS are only printed.
+ */
+void bootMark(const char *phase)
+{
+    uint32_t us = (uint32_t)esp_timer_get_time();
+    uint32_t prev = bootNumMarks ? bootMarks[bootNumMarks - 1].us : 0;
+
+    if(bootNumMarks < BOOT_MAX_MARKS) {
+        bootMarks[bootNumMarks].phase = phase;
+        bootMarks[bootNumMarks].us = us;
+        bootMarks[bootNumMarks].freeHeap = ESP.getFreeHeap();
+        bootNumMarks++;
+    }
+
+    Serial.printf("Boot: %-12s %9uus (+%uus)\n", phase, us, us - prev);
+}
+
+bool bootMarked(const char *phase)
+{
+    for(int i = 0; i < bootNumMarks; i++) {
+        if(!strcmp(bootMarks[i].phase, phase))
+            return true;
+    }
+
+    return false;
+}
+
+// Plain text, one line per mark
+int bootLogToText(char *buf, int bufSize)
+{
+    int len = snprintf(buf, bufSize, "%-12s %10s %10s %8s\n", "phase", "us", "delta", "heap");
+    uint32_t prev = 0;
+
+    for(int i = 0; i < bootNumMarks && len < bufSize; i++) {
+        len += snprintf(buf + len, bufSize - len, "%-12s %10u %10u %8u\n",
+                    bootMarks[i].phase, bootMarks[i].us, bootMarks[i].us - prev, 
+                    bootMarks[i].freeHeap);
+        prev = bootMarks[i].us;
+    }
+
+    return (len < bufSize) ? len : bufSize - 1;
+}
@@ -0,0 +1,324 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2021-2022 John deGlavina https://circuitsetup.us
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Calendar calculations
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Apart from tc_global.h and debug output, nothing in here
+ * depends on the platform, so this can also be built on a host.
+ */
+
+#include "tc_global.h"
+
+#ifdef TC_DBG
+#include <Arduino.h>
+#endif
+#include <stdint.h>
+
+#include "tc_calendar.h"
+
+const uint8_t monthDays[12] =
+{
+    31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+static const unsigned int mon_yday[2][13] =
+{
+    { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+    { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+};
+
+#ifdef TC_JULIAN_CAL
+#ifndef JSWITCH_1582
+static int jSwitchYear  = 1752;      // Year in which switch to Gregorian Cal took place
+static int jSwitchMon   = 9;         // Month in which switch to Gregorian Cal took place
+static int jSwitchDay   = 2;         // Last day of Julian Cal
+static int jSwitchSkipD = 11;        // Number of days skipped
+static int jSwitchSkipH = 11 * 24;   // Num hours skipped
+#else
+static int jSwitchYear  = 1582;      // Year in which switch to Gregorian Cal took place
+static int jSwitchMon   = 10;        // Month in which switch to Gregorian Cal took place
+static int jSwitchDay   = 4;         // Last day of Julian Cal
+static int jSwitchSkipD = 10;        // Number of days skipped
+static int jSwitchSkipH = 10 * 24;   // Num hours skipped
+#endif
+static unsigned int mon_yday_jSwitch[13]; // Accumulated days per month in year of Switch
+static int jSwitchYrHrs;
+static uint32_t jSwitchHash = 0;
+#endif
+
+/*
+ * Return doW from given date (year=yyyy)
+ */
+#ifndef TC_JULIAN_CAL
+uint8_t dayOfWeek(int d, int m, int y)
+{
+    // Sakamoto's method
+    const int t[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+    if(y > 0) {
+        if(m < 3) y -= 1;
+        return (y + y/4 - y/100 + y/400 + t[m-1] + d) % 7;
+    }
+    return (mon_yday[1][m-1] + d + 5) % 7;
+}
+#else
+uint8_t dayOfWeek(int d, int m, int y)
+{
+    const int t[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+    const int u[] = { 5, 1, 0, 3, 5, 1, 3, 6, 2, 4, 0, 2 };
+    
+    // Sakamoto's method
+    if(((y << 16) | (m << 8) | d) > jSwitchHash) {
+        if(m < 3) y -= 1;
+        return (y + y/4 - y/100 + y/400 + t[m-1] + d) % 7;
+    }
+    // For Julian Calendar
+    if(y > 0) {
+        if(m < 3) y -= 1;
+        return (y + y/4 + u[m-1] + d) % 7;
+    }
+    return (mon_yday[1][m-1] + d + 3) % 7;
+}
+#endif
+
+/* 
+ * Find number of days in a month 
+ */
+int daysInMonth(int month, int year)
+{
+    if(month == 2 && isLeapYear(year)) {
+        return 29;
+    }
+    return monthDays[month - 1];
+}
+
+/* 
+ * Determine if provided year is a leap year 
+ */
+#ifndef TC_JULIAN_CAL 
+bool isLeapYear(int year)
+{
+    if((year & 3) == 0) { 
+        if((year % 100) == 0) {
+            if((year % 400) == 0) {
+                return true;
+            } else {
+                return false;
+            }
+        } else {
+            return true;
+        }
+    } else {
+        return false;
+    }
+}
+#else
+bool isLeapYear(int year)
+{
+    if((year & 3) == 0) {
+        if((year > jSwitchYear) && ((year % 100) == 0)) {
+            if((year % 400) == 0) {
+                return true;
+            } else {
+                return false;
+            }
+        } else {
+            return true;
+        }
+    } else {
+        return false;
+    }
+}
+#endif
+
+/*
+ *  Number of days from 1/1/0 to 1/1 of given year
+ *  (Year 0 is a leap year)
+ */
+static uint32_t daysToYear(int year)
+{
+    // Number of multiples of n in [0, year-1] is (year + n - 1) / n
+    #ifdef TC_JULIAN_CAL
+    if(year <= jSwitchYear) {
+        return (uint32_t)year * 365 + (year + 3) / 4;
+    }
+    return daysToYear(jSwitchYear) + (jSwitchYrHrs / 24) +
+           ((uint32_t)year * 365 + (year + 3) / 4 - (year + 99) / 100 + (year + 399) / 400) -
+           ((uint32_t)(jSwitchYear + 1) * 365 + (jSwitchYear + 4) / 4 - (jSwitchYear + 100) / 100 + (jSwitchYear + 400) / 400);
+    #else
+    return (uint32_t)year * 365 + (year + 3) / 4 - (year + 99) / 100 + (year + 399) / 400;
+    #endif
+}
+
+/*
+ *  Convert a date into "minutes since 1/1/0 0:0"
+ */
+uint64_t dateToMins(int year, int month, int day, int hour, int minute)
+{
+    uint32_t total32;
+
+    total32 = daysToYear(year);
+    
+    #ifdef TC_JULIAN_CAL
+    if(year == jSwitchYear) {
+        total32 += mon_yday_jSwitch[month - 1];
+        if(month == jSwitchMon && day > jSwitchDay) {
+            if(day > jSwitchDay + jSwitchSkipD) {
+                day -= jSwitchSkipD;
+            } else {
+                #ifdef TC_DBG
+                Serial.printf("Bad date!\n");
+                #endif
+                day = 1;
+            }
+        }
+    } else
+    #endif
+        total32 += mon_yday[isLeapYear(year) ? 1 : 0][month - 1];
+        
+    total32 += day - 1;
+    total32 = total32 * 24 + hour;
+    
+    return ((uint64_t)total32 * 60) + minute;
+}
+
+/*
+ *  Convert "minutes since 1/1/0 0:0" into date
+ */
+void minsToDate(uint64_t total64, int& year, int& month, int& day, int& hour, int& minute)
+{
+    uint32_t days = total64 / (24*60);
+    uint32_t mins = total64 - ((uint64_t)days * (24*60));
+    const unsigned int *yday;
+    int c;
+
+    // Estimate year from mean Gregorian year length, 
+    // then correct (by one at most)
+    year = ((uint64_t)days * 400) / 146097;
+    while(year > 0 && daysToYear(year) > days) year--;
+    while(daysToYear(year + 1) <= days) year++;
+    
+    days -= daysToYear(year);
+
+    #ifdef TC_JULIAN_CAL
+    if(year == jSwitchYear) {
+        yday = mon_yday_jSwitch;
+    } else
+    #endif
+        yday = mon_yday[isLeapYear(year) ? 1 : 0];
+
+    // No month is longer than 32 days, so this is
+    // off by one at most
+    c = (days >> 5) + 1;
+    while(c < 12 && days >= yday[c]) c++;
+    
+    month = c;
+    day = days - yday[c - 1] + 1;
+
+    #ifdef TC_JULIAN_CAL
+    if(year == jSwitchYear && month == jSwitchMon && day > jSwitchDay) {
+        day += jSwitchSkipD;
+    }
+    #endif
+
+    hour = mins / 60;
+    minute = mins - (hour * 60);
+}
+
+#ifdef TC_JULIAN_CAL
+void calcJulianData()
+{
+    int l = isLeapYear(jSwitchYear) ? 1 : 0;
+  
+    for(int i = 0; i < 13; i++) {
+        mon_yday_jSwitch[i] = mon_yday[l][i];
+    }
+    for(int i = jSwitchMon; i < 13; i++) {
+        mon_yday_jSwitch[i] -= jSwitchSkipD;
+    }
+    
+    jSwitchYrHrs = (l ? (8760+24) : 8760) - jSwitchSkipH;
+
+    jSwitchHash = (jSwitchYear << 16) | (jSwitchMon << 8) | jSwitchDay;
+} 
+
+void correctNonExistingDate(int year, int month, int& day)
+{
+  if(year == jSwitchYear && month == jSwitchMon) {
+      if((day > jSwitchDay) && (day <= jSwitchDay + jSwitchSkipD)) {
+          day = jSwitchDay + jSwitchSkipD + 1;
+      }
+  }
+}
+#endif
+
+/*
+ * Return RTC-fit year & offs for given real year
+ */
+void correctYr4RTC(uint16_t& year, int16_t& offs)
+{
+    offs = 0;
+    if(year >= 2000 && year <= 2098) return;
+    
+    if(isLeapYear(year)) {
+        offs = 2000 - year;
+        year = 2000;
+    } else {
+        offs = 2001 - year;
+        year = 2001;
+    }
+}
+
+/*
+ * Convert date into minutes since 1/1 00:00 of given year
+ */
+int mins2Date(int year, int month, int day, int hour, int mins)
+{
+    return ((((mon_yday[isLeapYear(year) ? 1 : 0][month - 1] + (day - 1)) * 24) + hour) * 60) + mins;
+}
@@ -0,0 +1,263 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Command registry
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+
+#include "tc_audio.h"
+#include "tc_keypad.h"
+#include "tc_menus.h"
+#include "tc_time.h"
+#include "tc_wifi.h"
+#include "tc_state.h"
+#include "tc_cmd.h"
+
+#define CMD_MAX_NAME    31
+#define CMD_MAX_CODE    15
+
+static void cmdTimeTravel(const cmdCtx *c)
+{
+    #ifdef EXTERNAL_TIMETRAVEL_IN
+    isEttKeyPressed = isEttKeyImmediate = true;
+    #endif
+}
+
+static void cmdReturn(const cmdCtx *c)
+{
+    #ifdef EXTERNAL_TIMETRAVEL_IN
+    isEttKeyHeld = true;
+    #endif
+}
+
+static void cmdAlarm(const cmdCtx *c)
+{
+    if(c->arg) alarmOn();
+    else       alarmOff();
+}
+
+static void cmdNightMode(const cmdCtx *c)
+{
+    if(c->arg) nightModeOn();
+    else       nightModeOff();
+    manualNightMode = c->arg;
+    manualNMNow = millis();
+}
+
+static void cmdShuffle(const cmdCtx *c)
+{
+    mp_makeShuffle(!!c->arg);
+}
+
+static void cmdMusic(const cmdCtx *c)
+{
+    switch(c->arg) {
+    case 0: mp_play();        break;
+    case 1: mp_stop();        break;
+    case 2: mp_next(mpActive); break;
+    case 3: mp_prev(mpActive); break;
+    }
+}
+
+static void cmdBeep(const cmdCtx *c)
+{
+    setBeepMode(c->arg);
+}
+
+#ifdef TC_HAVEMQTT
+static void cmdPublish(const cmdCtx *c)
+{
+    mqttRequestPub(c->arg);
+}
+#endif
+
+/*
+ * The registry. MUST be sorted by name (strcmp order;
+ * note that '_' sorts after letters and digits).
+ */
+static const tcCmd cmdTable[] = {
+  { "ALARM_OFF",      cmdAlarm,      0,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "ALARM_ON",       cmdAlarm,      1,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "BEEP_30",        cmdBeep,       2,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "BEEP_60",        cmdBeep,       3,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "BEEP_OFF",       cmdBeep,       0,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "BEEP_ON",        cmdBeep,       1,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  #ifdef TC_HAVEMQTT
+  { "BTTFN_CLIENTS",  cmdPublish,    MQTT_REQ_CLIENTS,  0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "LOOP_STATS",     cmdPublish,    MQTT_REQ_LOOP,     0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "MEM_STATS",      cmdPublish,    MQTT_REQ_MEM,      0,                     CMDT_MQTT,  CMDF_IDLE  },
+  #endif
+  { "MP_NEXT",        cmdMusic,      2,                 0,                     CMDT_MQTT,  CMDF_IDLE|CMDF_MUSIC },
+  { "MP_PLAY",        cmdMusic,      0,                 0,                     CMDT_MQTT,  CMDF_IDLE|CMDF_MUSIC },
+  { "MP_PREV",        cmdMusic,      3,                 0,                     CMDT_MQTT,  CMDF_IDLE|CMDF_MUSIC },
+  { "MP_SHUFFLE_OFF", cmdShuffle,    0,                 0,                     CMDT_MQTT,  CMDF_IDLE|CMDF_MUSIC },
+  { "MP_SHUFFLE_ON",  cmdShuffle,    1,                 0,                     CMDT_MQTT,  CMDF_IDLE|CMDF_MUSIC },
+  { "MP_STOP",        cmdMusic,      1,                 0,                     CMDT_MQTT,  CMDF_IDLE|CMDF_MUSIC },
+  { "NIGHTMODE_OFF",  cmdNightMode,  0,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "NIGHTMODE_ON",   cmdNightMode,  1,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  #ifdef TC_HAVE_REMOTE
+  { "RC_BYE",         bttfnRcBye,    0,                 BTTFN_REMCMD_BYE,      CMDT_BTTFN, 0          },
+  { "RC_COMBINED",    bttfnRcCombined, 0,               BTTFN_REMCMD_COMBINED, CMDT_BTTFN, 0          },
+  { "RC_KP_BYE",      bttfnRcKpBye,  0,                 BTTFN_REMCMD_KP_BYE,   CMDT_BTTFN, 0          },
+  { "RC_KP_KEY",      bttfnRcKpKey,  0,                 BTTFN_REMCMD_KP_KEY,   CMDT_BTTFN, 0          },
+  { "RC_KP_PING",     bttfnRcPing,   0,                 BTTFN_REMCMD_KP_PING,  CMDT_BTTFN, 0          },
+  { "RC_PING",        bttfnRcPing,   0,                 BTTFN_REMCMD_PING,     CMDT_BTTFN, 0          },
+  #endif
+  { "RETURN",         cmdReturn,     0,                 0,                     CMDT_MQTT,  CMDF_IDLE  },
+  #ifdef TC_HAVEMQTT
+  { "SENSOR_HISTORY", cmdPublish,    MQTT_REQ_HIST,     0,                     CMDT_MQTT,  CMDF_IDLE  },
+  { "STALL_STATS",    cmdPublish,    MQTT_REQ_STALL,    0,                     CMDT_MQTT,  CMDF_IDLE  },
+  #endif
+  { "TIMETRAVEL",     cmdTimeTravel, 0,                 0,                     CMDT_MQTT,  CMDF_IDLE  }
+};
+
+#define CMD_NUM (sizeof(cmdTable) / sizeof(cmdTable[0]))
+
+static const tcCmd *cmdByCode[CMD_MAX_CODE + 1];
+static bool cmdIndexDone = false;
+
+static void cmdIndex()
+{
+    for(int i = 0; i < (int)CMD_NUM; i++) {
+        if(cmdTable[i].code && cmdTable[i].code <= CMD_MAX_CODE) {
+            cmdByCode[cmdTable[i].code] = &cmdTable[i];
+        }
+        #ifdef TC_DBG
+        if(i && strcmp(cmdTable[i - 1].name, cmdTable[i].name) >= 0) {
+            Serial.printf("cmdIndex: Table not sorted at %s\n", cmdTable[i].name);
+        }
+        #endif
+    }
+    cmdIndexDone = true;
+}
+
+// Compare table name with a (not terminated) token, ignoring
+// the token's case
+static int cmdCompare(const char *name, const char *tok, int tl)
+{
+    for(int i = 0; i < tl; i++) {
+        char c = tok[i];
+        if(c >= 'a' && c <= 'z') c &= ~0x20;
+        if(name[i] != c) return (int)(uint8_t)name[i] - (int)(uint8_t)c;
+    }
+    return name[tl] ? 1 : 0;
+}
+
+static const tcCmd *cmdFind(const char *tok, int tl)
+{
+    int lo = 0, hi = (int)CMD_NUM - 1;
+
+    while(lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int r = cmdCompare(cmdTable[mid].name, tok, tl);
+        if(!r) return &cmdTable[mid];
+        if(r < 0) lo = mid + 1;
+        else      hi = mid - 1;
+    }
+
+    return NULL;
+}
+
+static int cmdRun(const tcCmd *cmd, cmdCtx *c)
+{
+    if(!(cmd->trans & c->transport))
+        return CMD_DENIED;
+
+    if(cmd->flags & CMDF_IDLE) {
+        tcState st;
+        stateGet(st);
+        if(stateBusy(st))
+            return CMD_BUSY;
+    }
+
+    if((cmd->flags & CMDF_MUSIC) && !haveMusic)
+        return CMD_UNAVAIL;
+
+    c->arg = cmd->arg;
+    cmd->func(c);
+
+    return CMD_OK;
+}
+
+/*
+ * Execute a named command. The name is the leading run of
+ * letters, digits and '_' in text (case-insensitive); 
+ * anything after it is ignored.
+ */
+int cmdExecName(const char *text, int len, uint8_t transport)
+{
+    const tcCmd *cmd;
+    cmdCtx c = { transport, 0, 0, 0, 0 };
+    int tl = 0;
+
+    if(!cmdIndexDone) cmdIndex();
+
+    while(tl < len && tl <= CMD_MAX_NAME && (isalnum((uint8_t)text[tl]) || text[tl] == '_'))
+        tl++;
+
+    if(!tl || tl > CMD_MAX_NAME || !(cmd = cmdFind(text, tl)))
+        return CMD_UNKNOWN;
+
+    return cmdRun(cmd, &c);
+}
+
+// Execute a command by its BTTFN remote command code
+int cmdExecCode(uint8_t code, uint32_t seq, uint8_t p1, uint8_t p2, uint8_t transport)
+{
+    cmdCtx c = { transport, 0, seq, p1, p2 };
+
+    if(!cmdIndexDone) cmdIndex();
+
+    if(code > CMD_MAX_CODE || !cmdByCode[code])
+        return CMD_UNKNOWN;
+
+    return cmdRun(cmdByCode[code], &c);
+}
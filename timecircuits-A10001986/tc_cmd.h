@@ -0,0 +1,102 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Command registry
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_CMD_H
+#define _TC_CMD_H
+
+/*
+ * Command registry
+ *
+ * One table for all commands the TCD takes from outside: Named 
+ * commands (MQTT bttf/tcd/cmd) are looked up by binary search in 
+ * the name-sorted table, BTTFN remote commands by their code through 
+ * a direct index. Which transport may issue a command, and under 
+ * what circumstances, is part of the table entry, so all transports 
+ * share the same checks.
+ */
+
+// Transports (tcCmd.trans mask, cmdCtx.transport)
+#define CMDT_MQTT     0x01    // bttf/tcd/cmd
+#define CMDT_BTTFN    0x02    // BTTFN remote/remote keypad
+
+// Flags (tcCmd.flags)
+#define CMDF_IDLE     0x01    // Not while busy (off, menu, time travel; see stateBusy())
+#define CMDF_MUSIC    0x02    // Requires music player
+
+// Results
+#define CMD_OK         0
+#define CMD_UNKNOWN   -1
+#define CMD_DENIED    -2      // Not for this transport
+#define CMD_BUSY      -3
+#define CMD_UNAVAIL   -4      // Required feature not present
+
+typedef struct {
+    uint8_t  transport;
+    int16_t  arg;             // from table entry
+    uint32_t seq;             // BTTFN: packet sequence number
+    uint8_t  p1, p2;          // BTTFN: parameters
+} cmdCtx;
+
+typedef void (*cmdFunc)(const cmdCtx *c);
+
+typedef struct {
+    const char *name;
+    cmdFunc     func;
+    int16_t     arg;
+    uint8_t     code;         // BTTFN remote command code, 0 if none
+    uint8_t     trans;        // CMDT_xx mask
+    uint8_t     flags;        // CMDF_xx
+} tcCmd;
+
+int  cmdExecName(const char *text, int len, uint8_t transport);
+int  cmdExecCode(uint8_t code, uint32_t seq, uint8_t p1, uint8_t p2, uint8_t transport);
+
+#endif
@@ -56,6 +56,20 @@
 // speedo with integrated GPS receiver.
 #define TC_HAVEGPS
 
+// Uncomment to connect the GPS receiver (PA1010D/MT3333) via UART instead
+// of i2c. The UART driver buffers incoming NMEA data by interrupt, so
+// reading it causes no bus traffic. The pins are given by GPS_UART_RX_PIN/
+// GPS_UART_TX_PIN below; if GPS_UART_TX_PIN is -1, no commands are sent
+// to the receiver, which then runs with its default settings (no speed
+// update rate configuration, RTC not pre-set).
+//#define TC_GPS_UART
+
+// Uncomment if the keypad's PCF8574 INT output is wired to KEYPAD_INT_PIN
+// (see below; needs an external pull-up). The keypad is then only scanned
+// after the expander reports a change, instead of every 20ms; while a key
+// is down, it is scanned as usual to detect release and hold.
+//#define TC_KEYPAD_INT
+
 // Uncomment for support of speedo-display connected via i2c (0x70).
 // See speeddisplay.h for details
 #define TC_HAVESPEEDO
@@ -130,6 +144,22 @@
 // Uncomment for HomeAssistant MQTT protocol support
 #define TC_HAVEMQTT
 
+// Uncomment to run the MQTT client (connecting, reconnecting, receiving,
+// publishing) in a dedicated task on core 0. An unreachable broker then
+// no longer stalls the main loop. Requires TC_HAVEMQTT.
+#define TC_MQTT_TASK
+
+// Uncomment to run the web server (config portal, OTA and audio upload,
+// JSON API) in a dedicated task on core 0, so that slow or stalled 
+// clients no longer block the main loop. This task also resolves the
+// NTP server's address in the background.
+#define TC_NET_TASK
+
+// Uncomment to push live events (display contents, time travel phases,
+// keypad input, BTTFN clients) to browsers through a WebSocket on port
+// 81 (see tc_ws.h). One persistent connection replaces polling.
+#define TC_WEBSOCKET
+
 // Uncomment for bttfn discover (multicast) and notification broadcast.
 // This is REQUIRED for operating a Futaba remote control, and very
 // useful for other props' quicker speed updates. Supported by the 
@@ -137,6 +167,9 @@
 // Flux >= 1.60, SID >= 1.40, DG >= 1.10, VSR >= 1.10, Remote >= 0.90
 #define TC_BTTFN_MC
 
+// Maximum number of BTTFN clients (props) the TCD keeps track of (max 64)
+#define BTTFN_MAX_CLIENTS   16
+
 // Uncomment to include Exhibition mode
 // 99mmddyyyyhhMM sets (and enables) EM with fixed present time as given; 
 // 999 toggles between EM and normal operation
@@ -153,11 +186,74 @@
  ***                           Miscellaneous                           ***
  *************************************************************************/
 
+// Uncomment to let the power governor put the ESP32 into light sleep 
+// in short naps between the RTC's SQW ticks when nothing demands CPU 
+// (WiFi off, no GPS, no audio, no user input for 2 minutes). This 
+// lowers the average draw for battery-powered installations. Cannot 
+// be used with TC_KEYPAD_INT (the key interrupt might be missed).
+//#define TC_PWR_NAP
+
 // If this is uncommented, support for line-out audio (CB 1.4.5) is included.
 // If enabled (350/351 on keypad), Time travel sounds as well as music from 
 // the Music Player will be played over line-out, and not the built-in speaker.
 #define TC_HAVELINEOUT
 
+// Uncomment to run the audio pipeline (MP3/WAV decoding, music player
+// advancing to the next track) in a dedicated task on core 0, instead of
+// from the main loop. Audio playback then no longer depends on how long
+// the main loop's other tasks (network, time, i2c peripherals) take.
+#define TC_AUDIO_TASK
+
+// Uncomment to use PSRAM (WROVER-class modules) for large buffers that
+// are neither accessed by DMA nor in time-critical code: JSON documents,
+// the music player's play list and file name sorting, web page buffers.
+// Decoder state, audio caches and read-ahead buffers stay in internal 
+// RAM. Without PSRAM on the module, this has no effect. Where things
+// landed is printed to Serial at the end of boot.
+//#define TC_PSRAM
+
+// Uncomment to record the duration of the main loop's subsystem calls
+// (keypad, time, wifi, audio, etc) and the loop period in histograms.
+// Viewable in the keypad menu ("LOOP TIMES") and through MQTT.
+#define TC_LOOPPROF
+
+// Uncomment to watch the main loop from a separate task: Stalls longer 
+// than STALL_THRESHOLD ms are logged along with the task and function 
+// that was running. The log survives software resets and is viewable
+// in the Config Portal (/stalls) and through MQTT (bttf/tcd/stalls).
+#define TC_STALLMON
+#define STALL_THRESHOLD 1000
+
+// Uncomment to place a small set of hot functions (display update, BTTFN
+// packet handling) in IRAM, so they don't suffer from flash cache misses
+// while SD access or flash writes compete for the cache. (The audio 
+// output path and libmad's synthesis/IMDCT are always in IRAM.)
+#define TC_IRAM_HOT
+
+// Uncomment to additionally measure these functions, and the MP3/WAV
+// decoders' loop, in CPU cycles per call. Shown along with the loop
+// times (LOOP_STATS, bttf/tcd/loop). Build with and without TC_IRAM_HOT
+// to compare. Requires TC_LOOPPROF.
+//#define TC_CYCPROF
+
+// Uncomment to run the three displays, the RTC and the temperature/light
+// sensors on a second i2c bus at 400kHz (ESP32 i2c controller 1, pins
+// FASTBUS_SDA_PIN/FASTBUS_SCL_PIN below). Keypad, GPS, speedo and rotary
+// encoders stay on the first bus at 100kHz. This requires these devices
+// to be wired to the pins of the second bus; the stock Control Board has
+// only one bus.
+//#define TC_FASTBUS
+
+// If this is uncommented, sounds from flash FS (time travel, keypad, hour 
+// sounds, alarm, etc) are played from a raw flash partition, memory-mapped
+// and indexed, instead of through the flash file system. Comment to always
+// play them through the file system.
+// Requires a custom partition table with a data partition labeled "tcdsnd",
+// eg "tcdsnd, data, 0x40, , 512K". The partition is filled from the flash 
+// FS on boot after audio data was installed. Without such a partition,
+// this option has no effect.
+#define TC_SNDPART
+
 // If this is commented, the TCD uses the Gregorian calendar all the way,
 // ie since year 1. If this is uncommented, the Julian calendar is used
 // until either Sep 2, 1752 or Oct 4, 1582, depending on JSWITCH_1582.
@@ -214,6 +310,18 @@
 #ifdef IS_ACAR_DISPLAY
 #undef BTTF3_ANIM
 #endif
+#ifdef TC_KEYPAD_INT
+#undef TC_PWR_NAP
+#endif
+#ifndef TC_LOOPPROF
+#undef TC_CYCPROF
+#endif
+
+#ifdef TC_IRAM_HOT
+#define TC_HOT IRAM_ATTR
+#else
+#define TC_HOT
+#endif
 
 /*************************************************************************
  ***                  esp32-arduino version detection                  ***
@@ -260,6 +368,25 @@
 #define EXTERNAL_TIMETRAVEL_IN_PIN  27  // Externally triggered TT (input)
 #define EXTERNAL_TIMETRAVEL_OUT_PIN 14  // TT trigger output
 
+// Second i2c bus (TC_FASTBUS); needs external pull-ups
+#define FASTBUS_SDA_PIN     4
+#define FASTBUS_SCL_PIN     0
+
+// Keypad expander INT line (TC_KEYPAD_INT)
+#define KEYPAD_INT_PIN     39      // input only
+
+// GPS receiver on UART (TC_GPS_UART)
+#define GPS_UART_RX_PIN    36      // input only
+#define GPS_UART_TX_PIN    -1      // -1: none, receiver not configured
+#define GPS_UART_BAUD    9600      // PA1010D default
+
+// Bus for displays, RTC and sensors
+#ifdef TC_FASTBUS
+#define TC_FASTWIRE   Wire1
+#else
+#define TC_FASTWIRE   Wire
+#endif
+
 /*************************************************************************
  ***             Display IDs (Do not change, used as index)            ***
  *************************************************************************/
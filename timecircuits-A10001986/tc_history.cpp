@@ -0,0 +1,199 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Sensor history
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+
+#include "tc_history.h"
+
+#define SH_MINUTE_MS (60*1000)
+
+void sensHistory::add(int32_t val)
+{
+    if(!_started) {
+        _minStart = millis();
+        _started = true;
+    } else {
+        tick();
+    }
+
+    push(_smp, _smpIdx, _smpCnt, SH_NUM_SAMPLE, val);
+
+    _minSum += val;
+    _minN++;
+    _hrSum += val;
+    _hrN++;
+}
+
+// Close minute (and hour) buckets that have passed
+void sensHistory::tick()
+{
+    unsigned long now = millis();
+
+    // After a long gap (> 1 day), there is nothing to 
+    // keep; restart buckets at now
+    if(now - _minStart > (SH_NUM_HOUR + 1) * 60 * SH_MINUTE_MS) {
+        _minCnt = _hrCnt = 0;
+        _minSum = _hrSum = 0;
+        _minN = _hrN = 0;
+        _minsInHr = 0;
+        _minStart = now;
+        return;
+    }
+
+    while(now - _minStart >= SH_MINUTE_MS) {
+        push(_min, _minIdx, _minCnt, SH_NUM_MINUTE, _minN ? (int32_t)(_minSum / _minN) : SH_NOVAL);
+        _minSum = 0;
+        _minN = 0;
+        _minStart += SH_MINUTE_MS;
+        if(++_minsInHr >= 60) {
+            push(_hr, _hrIdx, _hrCnt, SH_NUM_HOUR, _hrN ? (int32_t)(_hrSum / _hrN) : SH_NOVAL);
+            _hrSum = 0;
+            _hrN = 0;
+            _minsInHr = 0;
+        }
+    }
+}
+
+void sensHistory::push(int32_t *arr, uint8_t& idx, uint8_t& cnt, uint8_t size, int32_t val)
+{
+    arr[idx] = val;
+    if(++idx >= size) idx = 0;
+    if(cnt < size) cnt++;
+}
+
+// Copy history of given resolution to buf, oldest first
+int sensHistory::get(int res, int32_t *buf, int maxNum)
+{
+    int32_t *arr;
+    uint8_t idx, cnt, size;
+    int i, j;
+
+    if(_started) tick();
+
+    switch(res) {
+    case SH_RES_SAMPLE:
+        arr = _smp; idx = _smpIdx; cnt = _smpCnt; size = SH_NUM_SAMPLE;
+        break;
+    case SH_RES_MINUTE:
+        arr = _min; idx = _minIdx; cnt = _minCnt; size = SH_NUM_MINUTE;
+        break;
+    case SH_RES_HOUR:
+        arr = _hr;  idx = _hrIdx;  cnt = _hrCnt;  size = SH_NUM_HOUR;
+        break;
+    default:
+        return 0;
+    }
+
+    if(cnt > maxNum) cnt = maxNum;
+
+    j = (int)idx - cnt;
+    if(j < 0) j += size;
+
+    for(i = 0; i < cnt; i++) {
+        buf[i] = arr[j];
+        if(++j >= size) j = 0;
+    }
+
+    return cnt;
+}
+
+// Min/max of all we have (up to 24 hours)
+bool sensHistory::range(int32_t& minVal, int32_t& maxVal)
+{
+    int32_t *arrs[3] = { _smp, _min, _hr };
+    uint8_t cnts[3];
+    bool    haveVal = false;
+
+    if(_started) tick();
+
+    cnts[0] = _smpCnt; cnts[1] = _minCnt; cnts[2] = _hrCnt;
+
+    // As long as a ring is not full, its entries are at 
+    // 0..cnt-1; when it is full, all entries are valid.
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < cnts[i]; j++) {
+            int32_t v = arrs[i][j];
+            if(v == SH_NOVAL) continue;
+            if(!haveVal || v < minVal) minVal = v;
+            if(!haveVal || v > maxVal) maxVal = v;
+            haveVal = true;
+        }
+    }
+
+    return haveVal;
+}
+
+// Write history as comma-separated list, oldest first
+int sensHistory::toText(int res, char *buf, int bufLen, const char *noVal)
+{
+    int32_t vals[SH_NUM_SAMPLE];    // largest ring
+    int num = get(res, vals, SH_NUM_SAMPLE);
+    int len = 0, l;
+
+    buf[0] = 0;
+
+    for(int i = 0; i < num; i++) {
+        if(vals[i] == SH_NOVAL) {
+            l = snprintf(buf + len, bufLen - len, "%s%s", i ? "," : "", noVal);
+        } else {
+            l = snprintf(buf + len, bufLen - len, "%s%d", i ? "," : "", (int)vals[i]);
+        }
+        if(l >= bufLen - len) {
+            buf[len] = 0;
+            break;
+        }
+        len += l;
+    }
+
+    return len;
+}
@@ -0,0 +1,106 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Sensor history
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_HISTORY_H
+#define _TC_HISTORY_H
+
+/*
+ * Sensor history
+ *
+ * Keeps the last SH_NUM_SAMPLE values as read, plus minute and
+ * hour averages. Buckets are relative to uptime, not wall clock
+ * time (which changes on time travel). Empty buckets (eg minutes 
+ * without a reading) hold SH_NOVAL. Values are integers; the 
+ * caller chooses the scale (eg temperature * 100).
+ */
+
+#define SH_RES_SAMPLE  0
+#define SH_RES_MINUTE  1
+#define SH_RES_HOUR    2
+
+#define SH_NUM_SAMPLE  60
+#define SH_NUM_MINUTE  60
+#define SH_NUM_HOUR    24
+
+#define SH_NOVAL       INT32_MIN
+
+class sensHistory {
+
+    public:
+
+        void add(int32_t val);
+
+        int  get(int res, int32_t *buf, int maxNum);
+        bool range(int32_t& minVal, int32_t& maxVal);
+        int  toText(int res, char *buf, int bufLen, const char *noVal);
+
+    private:
+
+        void tick();
+        void push(int32_t *arr, uint8_t& idx, uint8_t& cnt, uint8_t size, int32_t val);
+
+        int32_t       _smp[SH_NUM_SAMPLE];
+        int32_t       _min[SH_NUM_MINUTE];
+        int32_t       _hr[SH_NUM_HOUR];
+        uint8_t       _smpIdx = 0, _smpCnt = 0;
+        uint8_t       _minIdx = 0, _minCnt = 0;
+        uint8_t       _hrIdx = 0,  _hrCnt = 0;
+
+        int64_t       _minSum = 0;
+        uint16_t      _minN = 0;
+        int64_t       _hrSum = 0;
+        uint16_t      _hrN = 0;
+        uint8_t       _minsInHr = 0;
+        unsigned long _minStart = 0;
+        bool          _started = false;
+};
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * I2C bus scheduling
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+
+#include "tc_i2c.h"
+
+/*
+ * All bus users share one bus and run from the main loop, so a
+ * transaction is never interrupted by another one. What matters
+ * is order: A long low-priority transaction (GPS NMEA burst,
+ * sensor read) must not run right before a display frame or a
+ * keypad scan is due, otherwise that one is delayed by exactly
+ * the time the low-priority transaction takes.
+ *
+ * High-priority users announce their next due time through 
+ * i2c_due(). Low-priority users ask i2c_slot() with an estimate
+ * of their bus time, and skip this loop pass if the answer is 
+ * no. A deferred user is let through after I2C_MAX_DEFER ms in 
+ * any case.
+ */
+
+#define I2C_GUARD      2      // ms kept free before a due transaction
+#define I2C_MAX_DEFER  100
+
+static unsigned long dueTime[I2C_DUE_NUM];
+static bool          dueSet[I2C_DUE_NUM] = { false };
+static unsigned long deferStart = 0;
+static bool          deferring = false;
+
+void i2c_due(int slot, unsigned long when)
+{
+    dueTime[slot] = when;
+    dueSet[slot] = true;
+}
+
+void i2c_due_clear(int slot)
+{
+    dueSet[slot] = false;
+}
+
+bool i2c_slot(unsigned long estMs)
+{
+    unsigned long now = millis();
+
+    for(int i = 0; i < I2C_DUE_NUM; i++) {
+        if(dueSet[i]) {
+            long d = (long)(dueTime[i] - now);
+            // Due (or overdue) within our estimated
+            // time: Defer, unless deferred too long
+            if(d > -50 && d < (long)(estMs + I2C_GUARD)) {
+                if(!deferring) {
+                    deferring = true;
+                    deferStart = now;
+                } else if(now - deferStart >= I2C_MAX_DEFER) {
+                    break;
+                }
+                return false;
+            }
+        }
+    }
+
+    deferring = false;
+    return true;
+}
+
+/*
+ * Poll scheduler
+ *
+ * Periodic low-priority users (GPS, temperature, light sensor) 
+ * register their period, the maximum lateness they accept, and 
+ * their estimated bus time. i2c_poll() tells them whether to 
+ * poll now. Only one poll with bus cost runs per loop pass 
+ * (started by i2c_pass()); if several are due, the one that is
+ * most overdue goes first. A poll that is later than its 
+ * maximum lateness is let through in any case.
+ *
+ * A poller not asking for some time (eg because its caller is 
+ * not run in menus) does not make others wait.
+ */
+
+#define I2C_PASS_MAX   20     // ms after which a pass counts as finished
+#define I2C_ASK_STALE  100    // ms after which a poller counts as idle
+
+typedef struct {
+    unsigned long period;
+    unsigned long maxLate;
+    unsigned long est;
+    unsigned long nextDue;
+    unsigned long lastRun;
+    unsigned long lastAsk;
+    bool          active;
+} i2cPoll;
+
+static i2cPoll       polls[I2C_POLL_NUM] = { 0 };
+static unsigned long passStart = 0;
+static bool          passBusy = false;
+
+void i2c_pass()
+{
+    passStart = millis();
+    passBusy = false;
+}
+
+void i2c_poll_register(int id, unsigned long periodMs, unsigned long maxLateMs, unsigned long estMs)
+{
+    i2cPoll *p = &polls[id];
+    unsigned long now = millis();
+
+    p->period = periodMs;
+    p->maxLate = maxLateMs;
+    p->est = estMs;
+    p->nextDue = p->lastRun = p->lastAsk = now;
+    p->active = true;
+}
+
+void i2c_poll_period(int id, unsigned long periodMs)
+{
+    i2cPoll *p = &polls[id];
+
+    if(p->period != periodMs) {
+        p->period = periodMs;
+        p->nextDue = p->lastRun + periodMs;
+    }
+}
+
+void i2c_poll_reset(int id, unsigned long inMs)
+{
+    polls[id].nextDue = millis() + inMs;
+}
+
+bool i2c_poll(int id)
+{
+    i2cPoll *p = &polls[id];
+    unsigned long now = millis();
+    long late;
+
+    if(!p->active)
+        return false;
+        
+    p->lastAsk = now;
+
+    late = (long)(now - p->nextDue);
+    if(late < 0)
+        return false;
+
+    if(p->est && late < (long)p->maxLate) {
+
+        if(passBusy && (now - passStart < I2C_PASS_MAX))
+            return false;
+
+        // Let a more overdue poller go first
+        for(int i = 0; i < I2C_POLL_NUM; i++) {
+            i2cPoll *o = &polls[i];
+            if(i == id || !o->active || !o->est)
+                continue;
+            if(now - o->lastAsk >= I2C_ASK_STALE)
+                continue;
+            if((long)(now - o->nextDue) > late)
+                return false;
+        }
+
+        if(!i2c_slot(p->est))
+            return false;
+    }
+
+    if(p->est) {
+        passStart = now;
+        passBusy = true;
+    }
+
+    p->lastRun = now;
+    p->nextDue += p->period;
+    if((long)(now - p->nextDue) >= 0) {
+        p->nextDue = now + p->period;
+    }
+
+    return true;
+}
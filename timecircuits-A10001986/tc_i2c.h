@@ -0,0 +1,82 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * I2C bus scheduling
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_I2C_H
+#define _TC_I2C_H
+
+// High-priority bus users announce when their next
+// transaction is due
+#define I2C_DUE_DISPLAY   0     // Display frame on next SQW edge
+#define I2C_DUE_KEYPAD    1     // Keypad scan while a key is active
+#define I2C_DUE_NUM       2
+
+// Estimated bus time of low-priority transactions (ms)
+#define I2C_EST_GPS       13
+#define I2C_EST_SENSOR    5
+
+// Periodic low-priority pollers
+#define I2C_POLL_GPS      0
+#define I2C_POLL_TEMP     1
+#define I2C_POLL_LIGHT    2
+#define I2C_POLL_RTCTEMP  3
+#define I2C_POLL_NUM      4
+
+void i2c_due(int slot, unsigned long when);
+void i2c_due_clear(int slot);
+bool i2c_slot(unsigned long estMs);
+
+void i2c_pass();
+void i2c_poll_register(int id, unsigned long periodMs, unsigned long maxLateMs, unsigned long estMs);
+void i2c_poll_period(int id, unsigned long periodMs);
+void i2c_poll_reset(int id, unsigned long inMs);
+bool i2c_poll(int id);
+
+#endif
@@ -64,6 +64,10 @@
 #include "tc_settings.h"
 #include "tc_time.h"
 #include "tc_wifi.h"
+#include "tc_i2c.h"
+#ifdef TC_WEBSOCKET
+#include "tc_ws.h"
+#endif
 
 #define KEYPAD_ADDR     0x20    // I2C address of the PCF8574 port expander (keypad)
 
@@ -205,8 +209,41 @@ static TCButton ettKey = TCButton(EXTERNAL_TIMETRAVEL_IN_PIN,
 );
 #endif
 
-static void keypadEvent(char key, KeyState kstate);
-static void recordKey(char key);
+/*
+ * Keypad event queues
+ *
+ * Keypad events are not handled from within the scan, but queued 
+ * with a time stamp, and handled in order by keypadDrain(). Remote
+ * keys (BTTFN) go the same way. Each queue has exactly one producer
+ * and one consumer, so no locking is required; a new event source
+ * running in another task gets a queue of its own.
+ */
+#define KP_EVQ_SIZE 16  // Power of 2
+
+typedef struct {
+    unsigned long ts;
+    char          key;
+    KeyState      kstate;
+} kpEvent;
+
+typedef struct {
+    kpEvent           ev[KP_EVQ_SIZE];
+    volatile uint32_t head;     // Written by producer only
+    volatile uint32_t tail;     // Written by consumer only
+} kpEvQueue;
+
+static kpEvQueue kpQLocal;
+#ifdef TC_HAVE_REMOTE
+static kpEvQueue kpQRemote;
+#endif
+static bool      kpDraining = false;
+
+static bool kpEvPost(kpEvQueue *q, char key, KeyState kstate);
+static void keypadDrain();
+static void keypadEventQ(char key, KeyState kstate);
+
+static void keypadEvent(char key, KeyState kstate, unsigned long ts);
+static void recordKey(char key, unsigned long ts);
 static void recordSetTimeKey(char key, bool isYear);
 
 static void enterKeyPressed();
@@ -235,9 +272,13 @@ static void dt_showTextDirect(const char *text, uint16_t flags = CDT_CLEAR)
 void keypad_setup()
 {
     // Set up the keypad
+    #ifdef TC_KEYPAD_INT
+    keypad.begin(20, ENTER_HOLD_TIME, myCustomDelay_KP, KEYPAD_INT_PIN);
+    #else
     keypad.begin(20, ENTER_HOLD_TIME, myCustomDelay_KP);
+    #endif
 
-    keypad.addEventListener(keypadEvent);
+    keypad.addEventListener(keypadEventQ);
 
     // Set up pin for white LED
     pinMode(WHITE_LED_PIN, OUTPUT);
@@ -254,10 +295,10 @@ void keypad_setup()
     ettKey.attachPress(ettKeyPressed);
     ettKey.attachLongPressStart(ettKeyHeld);
 
-    ettDelay = atoi(settings.ettDelay);
+    ettDelay = cfg.ettDelay;
     if(ettDelay > ETT_MAX_DEL) ettDelay = ETT_MAX_DEL;
 
-    ettLong = (atoi(settings.ettLong) > 0);
+    ettLong = cfg.ettLong;
 #endif
 
     dateBuffer[0] = '\0';
@@ -269,15 +310,122 @@ void keypad_setup()
  */
 bool scanKeypad()
 {
-    return keypad.scanKeypad();
+    bool ret = keypad.scanKeypad();
+
+    keypadDrain();
+
+    // While a key is pressed, release and hold must be
+    // detected in time; scans then rank above GPS/sensors
+    if(keypad.isKeyActive()) {
+        i2c_due(I2C_DUE_KEYPAD, keypad.nextScan());
+    } else {
+        i2c_due_clear(I2C_DUE_KEYPAD);
+    }
+
+    return ret;
+}
+
+/*
+ * Event queue
+ */
+static bool kpEvPost(kpEvQueue *q, char key, KeyState kstate)
+{
+    uint32_t h = q->head;
+    kpEvent *e;
+
+    if(h - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) >= KP_EVQ_SIZE) {
+        #ifdef TC_DBG
+        Serial.println("Keypad event queue full");
+        #endif
+        return false;
+    }
+
+    e = &q->ev[h & (KP_EVQ_SIZE - 1)];
+    e->ts = millis();
+    e->key = key;
+    e->kstate = kstate;
+
+    __atomic_store_n(&q->head, h + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static kpEvent *kpEvPeek(kpEvQueue *q)
+{
+    uint32_t t = q->tail;
+
+    if(__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == t)
+        return NULL;
+
+    return &q->ev[t & (KP_EVQ_SIZE - 1)];
+}
+
+static void kpEvPop(kpEvQueue *q)
+{
+    __atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+}
+
+// Handle all queued events, oldest first. A handler might
+// block (eg time travel) and scan the keypad meanwhile;
+// events arriving then are handled after it returns.
+static void keypadDrain()
+{
+    kpEvQueue *q;
+    kpEvent   *e, ev;
+    #ifdef TC_HAVE_REMOTE
+    kpEvent   *r;
+    #endif
+
+    if(kpDraining)
+        return;
+
+    kpDraining = true;
+
+    for(;;) {
+        q = &kpQLocal;
+        e = kpEvPeek(q);
+        #ifdef TC_HAVE_REMOTE
+        if((r = kpEvPeek(&kpQRemote))) {
+            if(!e || (long)(r->ts - e->ts) < 0) {
+                q = &kpQRemote;
+                e = r;
+            }
+        }
+        #endif
+        if(!e) break;
+
+        // Copy and free slot before calling the handler
+        ev = *e;
+        kpEvPop(q);
+
+        #ifdef TC_HAVE_REMOTE
+        if(ev.key == 'E') {
+            isEnterKeyPressed = true;
+            isEnterKeyHeld = false;
+            continue;
+        }
+        #endif
+
+        keypadEvent(ev.key, ev.kstate, ev.ts);
+    }
+
+    kpDraining = false;
+}
+
+static void keypadEventQ(char key, KeyState kstate)
+{
+    // Drop right away what keypadEvent() would ignore
+    if(!FPBUnitIsOn || startup || timeTravelP0 || timeTravelP1 || timeTravelRE)
+        return;
+
+    kpEvPost(&kpQLocal, key, kstate);
 }
 
 /*
  *  The keypad event handler
  */
-static void keypadEvent(char key, KeyState kstate)
+static void keypadEvent(char key, KeyState kstate, unsigned long ts)
 {
-    bool mpWasActive = false;
     bool playBad = false;
     int i;
     
@@ -286,6 +434,10 @@ static void keypadEvent(char key, KeyState kstate)
 
     pwrNeedFullNow();
 
+    #ifdef TC_WEBSOCKET
+    wsKeyEvent(key, (kstate == TCKS_PRESSED) ? 'p' : ((kstate == TCKS_HOLD) ? 'h' : 'r'));
+    #endif
+
     switch(kstate) {
     case TCKS_PRESSED:
         if(key != '#' && key != '*') {
@@ -332,18 +484,11 @@ static void keypadEvent(char key, KeyState kstate)
             break;
         case '7':    // "7" held down -> re-enable/re-connect WiFi
             doKey = false;
-            if(!wifiOnWillBlock()) {
-                play_file("/ping.mp3", PA_INTSPKR|PA_CHECKNM|PA_ALLOWSD);
-            } else {
-                if(haveMusic) mpWasActive = mp_stop();
-                play_file("/ping.mp3", PA_INTSPKR|PA_CHECKNM|PA_INTRMUS|PA_ALLOWSD);
-                waitAudioDone();
-            }
+            play_file("/ping.mp3", PA_INTSPKR|PA_CHECKNM|PA_ALLOWSD);
             // Enable WiFi / even if in AP mode / with CP
+            // (Re-connecting does not block)
             wifiOn(0, true, false);
             syncTrigger = true;
-            // Restart mp if it was active before
-            if(mpWasActive) mp_play();   
             break;
         case '2':    // "2" held down -> musicplayer prev
             doKey = false;
@@ -378,7 +523,7 @@ static void keypadEvent(char key, KeyState kstate)
             if(keypadInMenu) {
                 recordSetTimeKey(key, isYearUpdate);
             } else {
-                recordKey(key);
+                recordKey(key, ts);
             }
         }
         break;
@@ -400,12 +545,18 @@ static void enterKeyPressed()
 {
     isEnterKeyPressed = true;
     pwrNeedFullNow();
+    #ifdef TC_WEBSOCKET
+    wsKeyEvent('E', 'p');
+    #endif
 }
 
 static void enterKeyHeld()
 {
     isEnterKeyHeld = true;
     pwrNeedFullNow();
+    #ifdef TC_WEBSOCKET
+    wsKeyEvent('E', 'h');
+    #endif
 }
 
 #ifdef EXTERNAL_TIMETRAVEL_IN
@@ -423,13 +574,13 @@ static void ettKeyHeld()
 }
 #endif
 
-static void recordKey(char key)
+static void recordKey(char key, unsigned long ts)
 {
     dateBuffer[dateIndex++] = key;
     dateBuffer[dateIndex] = '\0';
     // Don't wrap around, overwrite end of date instead
     if(dateIndex >= DATELEN_MAX) dateIndex = DATELEN_MAX - 1;  
-    lastKeyPressed = millis();
+    lastKeyPressed = ts;
 }
 
 static void recordSetTimeKey(char key, bool isYear)
@@ -467,24 +618,22 @@ void injectKeypadKey(char key, int kaction)
     if(key == 'E') {
         switch(kaction) {
         case BTTFN_KP_KS_PRESSED:
-            isEnterKeyPressed = true;
-            isEnterKeyHeld = false;
+            kpEvPost(&kpQRemote, 'E', TCKS_PRESSED);
             break;
         case BTTFN_KP_KS_HOLD:
-            //isEnterKeyPressed = false;    // No, we don't enter the keypad menu remotely.
-            //isEnterKeyHeld = true;
+            // No, we don't enter the keypad menu remotely.
             break;
         }
     } else if(key >= '0' && key <= '9') {
         switch(kaction) {
         case BTTFN_KP_KS_PRESSED:
-            keypadEvent(key, TCKS_PRESSED);
-            keypadEvent(key, TCKS_RELEASED);
+            kpEvPost(&kpQRemote, key, TCKS_PRESSED);
+            kpEvPost(&kpQRemote, key, TCKS_RELEASED);
             break;
         case BTTFN_KP_KS_HOLD:
-            keypadEvent(key, TCKS_PRESSED);
-            keypadEvent(key, TCKS_HOLD);
-            keypadEvent(key, TCKS_RELEASED);
+            kpEvPost(&kpQRemote, key, TCKS_PRESSED);
+            kpEvPost(&kpQRemote, key, TCKS_HOLD);
+            kpEvPost(&kpQRemote, key, TCKS_RELEASED);
             break;
         }
     }
@@ -503,6 +652,8 @@ void keypad_loop()
 
     enterkeyScan();
 
+    keypadDrain();
+
     // Discard keypad input after 2 minutes of inactivity
     if(millis() - lastKeyPressed >= 2*60*1000) {
         discardKeypadInput();
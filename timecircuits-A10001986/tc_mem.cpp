@@ -0,0 +1,274 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Memory telemetry
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+#ifdef TC_PSRAM
+#include <esp_heap_caps.h>
+#endif
+
+#include "src/ESP8266Audio/AudioGeneratorMP3.h"
+
+#include "tc_mem.h"
+#include "tc_wifi.h"
+
+// Sampled by name; transient tasks (upload and OTA writers)
+// report their own high-water mark when they finish.
+static const struct {
+    const char *name;
+    bool        transient;
+} memTasks[MEM_NUM_TASKS] = {
+    { "loopTask", false },
+    { "audio",    false },
+    { "mqtt",     false },
+    { "uplwr",    true  },
+    { "otawr",    true  },
+    { "tiT",      false },      // lwIP
+    { "wifi",     false },
+    { "net",      false }
+};
+#define MEM_TSK_OTAWR 4
+
+static memStats      memCur = { 0 };
+static unsigned long memLastSample = 0;
+static uint32_t      memJsonDocs = 0;
+static uint32_t      memJsonMax = 0;
+static uint16_t      memTransStack[MEM_NUM_TASKS] = { 0 };   // 0 = n/a
+
+// Bulk allocations per class: Count, how many were placed in
+// PSRAM, and the largest one
+static struct {
+    const char *name;
+    uint32_t   num;
+    uint32_t   numExt;
+    uint32_t   maxSize;
+} memBlk[MEM_NUM_BLK] = {
+    { "json" }, { "playlist" }, { "mpsort" }, { "web" }
+};
+
+static void memSample();
+
+void mem_loop()
+{
+    if(memCur.samples && millis() - memLastSample < MEM_SAMPLE_INT)
+        return;
+
+    memSample();
+    memLastSample = millis();
+}
+
+static void memSample()
+{
+    uint32_t otaStack;
+
+    if(!memCur.samples) {
+        for(int i = 0; i < MEM_NUM_TASKS; i++) {
+            memCur.stackFree[i] = MEM_STK_UNKNOWN;
+        }
+        memCur.minLargest = UINT32_MAX;
+    }
+
+    memCur.freeHeap    = ESP.getFreeHeap();
+    memCur.minFreeHeap = ESP.getMinFreeHeap();
+    memCur.totalHeap   = ESP.getHeapSize();
+    memCur.largest     = ESP.getMaxAllocHeap();
+    #ifdef TC_PSRAM
+    memCur.psramSize   = ESP.getPsramSize();
+    memCur.psramFree   = ESP.getFreePsram();
+    #endif
+
+    if(memCur.largest < memCur.minLargest) memCur.minLargest = memCur.largest;
+    memCur.frag = memCur.freeHeap ? 100 - (uint8_t)((uint64_t)memCur.largest * 100 / memCur.freeHeap) : 0;
+    if(memCur.frag > memCur.maxFrag) memCur.maxFrag = memCur.frag;
+
+    wifiGetMemStats(memCur.wmParmAllocs, memCur.wmPages, memCur.wmPageMinHeap, otaStack);
+    if(otaStack) memTransStack[MEM_TSK_OTAWR] = otaStack;
+
+    for(int i = 0; i < MEM_NUM_TASKS; i++) {
+        if(memTasks[i].transient) {
+            if(memTransStack[i]) memCur.stackFree[i] = memTransStack[i];
+        } else {
+            // We run in loopTask, no need to look it up
+            TaskHandle_t th = i ? xTaskGetHandle(memTasks[i].name) : xTaskGetCurrentTaskHandle();
+            if(th) {
+                memCur.stackFree[i] = uxTaskGetStackHighWaterMark(th);
+            }
+        }
+    }
+
+    memCur.mp3Allocs = AudioGeneratorMP3::GetAllocCount();
+    memCur.mp3Fails  = AudioGeneratorMP3::GetAllocFails();
+    memCur.jsonDocs  = memJsonDocs;
+    memCur.jsonMax   = memJsonMax;
+
+    memCur.samples++;
+
+    #ifdef TC_DBG
+    if(!(memCur.samples % 30)) {
+        Serial.printf("mem: free %d largest %d frag %d%% min %d\n", 
+            memCur.freeHeap, memCur.largest, memCur.frag, memCur.minFreeHeap);
+    }
+    #endif
+}
+
+void memGetStats(memStats& ms, bool sampleNow)
+{
+    if(sampleNow || !memCur.samples) memSample();
+    ms = memCur;
+}
+
+const char *memTaskName(int idx)
+{
+    return (idx >= 0 && idx < MEM_NUM_TASKS) ? memTasks[idx].name : "";
+}
+
+// key=value pairs, comma-separated; for MQTT
+int memStatsToText(char *buf, int bufSize)
+{
+    memStats ms;
+    int len;
+
+    memGetStats(ms);
+
+    len = snprintf(buf, bufSize, 
+        "free=%u,min=%u,largest=%u,minlargest=%u,frag=%u,maxfrag=%u,"
+        "mp3=%u,mp3fail=%u,json=%u,jsonmax=%u,wmparm=%u,wmpages=%u,wmminheap=%u",
+        ms.freeHeap, ms.minFreeHeap, ms.largest, ms.minLargest, ms.frag, ms.maxFrag,
+        ms.mp3Allocs, ms.mp3Fails, ms.jsonDocs, ms.jsonMax, 
+        ms.wmParmAllocs, ms.wmPages, ms.wmPageMinHeap);
+
+    for(int i = 0; i < MEM_NUM_TASKS && len < bufSize; i++) {
+        if(ms.stackFree[i] != MEM_STK_UNKNOWN) {
+            len += snprintf(buf + len, bufSize - len, ",stk_%s=%u", memTasks[i].name, ms.stackFree[i]);
+        }
+    }
+
+    if(ms.psramSize && len < bufSize) {
+        len += snprintf(buf + len, bufSize - len, ",psram=%u,psramfree=%u", ms.psramSize, ms.psramFree);
+    }
+
+    return (len < bufSize) ? len : bufSize - 1;
+}
+
+// Called whenever a JSON document is allocated on the heap
+void memNoteJson(size_t size)
+{
+    memJsonDocs++;
+    if(size > memJsonMax) memJsonMax = size;
+}
+
+// Called by transient tasks right before they delete themselves
+void memNoteStack(const char *taskName)
+{
+    for(int i = 0; i < MEM_NUM_TASKS; i++) {
+        if(memTasks[i].transient && !strcmp(memTasks[i].name, taskName)) {
+            memTransStack[i] = uxTaskGetStackHighWaterMark(NULL);
+            return;
+        }
+    }
+}
+
+// Large, non-DMA, non-hot buffers: PSRAM if we have some, 
+// internal heap otherwise. Freed with free().
+void *memBulkAlloc(size_t size, int blk)
+{
+    void *p = NULL;
+    bool ext = false;
+
+    #ifdef TC_PSRAM
+    if(psramFound()) {
+        p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ext = (p != NULL);
+    }
+    #endif
+    if(!p) p = malloc(size);
+
+    if(p && blk >= 0 && blk < MEM_NUM_BLK) {
+        memBlk[blk].num++;
+        if(ext) memBlk[blk].numExt++;
+        if(size > memBlk[blk].maxSize) memBlk[blk].maxSize = size;
+    }
+
+    return p;
+}
+
+// Buffers accessed by DMA or in hot paths. If PSRAM is part
+// of the malloc() pool, large blocks might otherwise end up
+// there. Freed with free().
+void *memIntAlloc(size_t size)
+{
+    #ifdef TC_PSRAM
+    return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    #else
+    return malloc(size);
+    #endif
+}
+
+// Called at the end of setup()
+void memBulkReport()
+{
+    #ifdef TC_PSRAM
+    if(psramFound()) {
+        Serial.printf("mem: PSRAM %d, free %d; internal free %d\n", 
+            ESP.getPsramSize(), ESP.getFreePsram(), 
+            heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    } else {
+        Serial.println("mem: No PSRAM found, bulk data in internal RAM");
+    }
+    for(int i = 0; i < MEM_NUM_BLK; i++) {
+        if(memBlk[i].num) {
+            Serial.printf("mem: %s: %d allocs (max %d bytes), %d in PSRAM\n",
+                memBlk[i].name, memBlk[i].num, memBlk[i].maxSize, memBlk[i].numExt);
+        }
+    }
+    #endif
+}
@@ -0,0 +1,124 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Memory telemetry
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_MEM_H
+#define _TC_MEM_H
+
+/*
+ * Memory telemetry
+ *
+ * Sampled every MEM_SAMPLE_INT ms from the main loop: Free heap,
+ * largest free block, fragmentation (share of free heap not
+ * available as one block), lowest values seen since boot, stack
+ * high-water marks of our (and some system) tasks, and allocation
+ * counters of the MP3 decoder, WiFiManager and ArduinoJson.
+ *
+ * Shown in the keypad menu ("HEAP INFO"), published via MQTT
+ * (bttf/tcd/mem) and included in the JSON status API.
+ *
+ * Bulk memory (TC_PSRAM)
+ *
+ * Large buffers that are neither used for DMA nor touched in hot
+ * paths (JSON documents, music player play list and file name
+ * sorting, web page buffers) are allocated through memBulkAlloc(). 
+ * With TC_PSRAM, and if the module has PSRAM, they are placed there;
+ * otherwise, and if PSRAM is exhausted, they come from the normal
+ * heap. memIntAlloc() is for the opposite: Buffers that must stay
+ * in internal RAM even if malloc() would put them into PSRAM.
+ * Where each class of buffer landed is printed after boot.
+ */
+
+#define MEM_SAMPLE_INT  10000
+
+#define MEM_NUM_TASKS   8
+#define MEM_STK_UNKNOWN 0xffff
+
+typedef struct {
+    uint32_t samples;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;       // lowest free heap since boot (from IDF)
+    uint32_t totalHeap;
+    uint32_t largest;           // largest free block
+    uint32_t minLargest;        // smallest "largest free block" sampled
+    uint8_t  frag;              // percent
+    uint8_t  maxFrag;
+    uint16_t stackFree[MEM_NUM_TASKS];  // bytes; MEM_STK_UNKNOWN = n/a
+    uint32_t mp3Allocs;         // MP3 decoder buffer allocations
+    uint32_t mp3Fails;
+    uint32_t jsonDocs;          // heap-allocated JSON documents
+    uint32_t jsonMax;           // largest capacity requested
+    uint32_t wmParmAllocs;      // WiFiManager parameter value buffers
+    uint32_t wmPages;           // WiFiManager pages served
+    uint32_t wmPageMinHeap;     // lowest free heap at end of page
+    uint32_t psramSize;         // 0 if no PSRAM (or not used)
+    uint32_t psramFree;
+} memStats;
+
+#define MEM_BLK_JSON    0       // JSON documents, JSON file buffers
+#define MEM_BLK_PLIST   1       // Music player play list
+#define MEM_BLK_MPSORT  2       // Music player file name sorting
+#define MEM_BLK_WEB     3       // Dynamically built web pages
+#define MEM_NUM_BLK     4
+
+void mem_loop();
+
+void memGetStats(memStats& ms, bool sampleNow = false);
+const char *memTaskName(int idx);
+int  memStatsToText(char *buf, int bufSize);
+
+void memNoteJson(size_t size);
+void memNoteStack(const char *taskName);
+
+void *memBulkAlloc(size_t size, int blk);
+void *memIntAlloc(size_t size);
+void memBulkReport();
+
+#endif
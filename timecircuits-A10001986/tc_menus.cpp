@@ -85,6 +85,9 @@
  *     - enter dates/times for the three displays/set built-in RTC,
  *     - show currently measured data from connected sensors ("SENSORS"),
  *     - show currently registered BTTF clients ("BTTF CLIENTS"),
+ *     - show heap and stack statistics ("HEAP INFO"),
+ *     - show subsystem call durations ("LOOP TIMES"),
+ *     - show SD card clock and read throughput ("SD CARD"),
  *     - quit the menu ("END").
  *
  * Pressing ENTER cycles through the list, holding ENTER selects an item.
@@ -219,6 +222,34 @@
  *       press ENTER to toggle between their data.
  *     - Hold ENTER to leave the menu
  *
+ * How to view heap and stack statistics:
+ *
+ *     - Hold ENTER to invoke main menu
+ *     - Press ENTER until "HEAP INFO" is shown
+ *     - Hold ENTER, free heap and lowest free heap since boot are shown
+ *     - Press ENTER to cycle through largest free block, fragmentation,
+ *       free stack space of each task, and allocation counters of MP3 
+ *       decoder, JSON documents and Config Portal
+ *     - Hold ENTER to leave the menu
+ *
+ * How to view loop timing statistics:
+ *
+ *     - Hold ENTER to invoke main menu
+ *     - Press ENTER until "LOOP TIMES" is shown
+ *     - Hold ENTER, the loop period is shown: Median and 99th percentile
+ *       in the second line, maximum in the third line
+ *     - Press ENTER to cycle through the subsystems
+ *     - Hold ENTER to leave the menu
+ *
+ * How to run the benchmark:
+ *
+ *     - Hold ENTER to invoke main menu
+ *     - Press ENTER until "VERSION" is shown
+ *     - Hold ENTER, "BENCHMARK" is shown while the suite runs (a few
+ *       seconds). Results are printed to Serial and served at /api/bench.
+ *     - Press ENTER to cycle through the results
+ *     - Hold ENTER to leave the menu
+ *
  * How to leave the menu:
  *
  *     While the menu is active, repeatedly press ENTER until "END" is displayed.
@@ -237,6 +268,10 @@
 #include "tc_audio.h"
 #include "tc_settings.h"
 #include "tc_wifi.h"
+#include "tc_mem.h"
+#include "tc_prof.h"
+#include "tc_sched.h"
+#include "tc_bench.h"
 
 #include "tc_menus.h"
 
@@ -252,8 +287,11 @@
 #define MODE_SENS 9
 #define MODE_LTS  10
 #define MODE_CLI  11
-#define MODE_VER  12
-#define MODE_END  13
+#define MODE_MEM  12
+#define MODE_LOOP 13
+#define MODE_SD   14
+#define MODE_VER  15
+#define MODE_END  16
 #define MODE_MAX  MODE_END
 
 #define FIELD_MONTH   0
@@ -323,6 +361,11 @@ static void doShowSensors();
 static void displayIP();
 static void doShowNetInfo();
 static void doShowBTTFNInfo();
+static void doShowMemInfo();
+#ifdef TC_LOOPPROF
+static void doShowLoopInfo();
+static void doBenchmark();
+#endif
 static bool menuWaitForRelease();
 static bool checkEnterPress();
 static void prepareInput(int number);
@@ -509,7 +552,7 @@ void enter_menu()
 
             // Update & save lastYear & yearOffset
             lastYear = ny;
-            displaySet->saveClockStateData(lastYear);
+            displaySet->saveClockStateData(lastYear, true);
 
             // Resetting the RTC invalidates our timeDifference, ie
             // fake present time. Make the user return to present
@@ -538,7 +581,7 @@ void enter_menu()
         displaySet->setMinute(minSet);
 
         // Save to NVM (regardless of persistence mode)
-        displaySet->save();
+        displaySet->save(true);
 
         menudelay(1000);
 
@@ -639,6 +682,22 @@ void enter_menu()
 
         // Show client info
         doShowBTTFNInfo();
+
+    } else if(menuItemNum == MODE_MEM) {   // Show heap/stack info
+
+        allOff();
+        waitForEnterRelease();
+
+        doShowMemInfo();
+
+    #ifdef TC_LOOPPROF
+    } else if(menuItemNum == MODE_LOOP) {  // Show loop timing
+
+        allOff();
+        waitForEnterRelease();
+
+        doShowLoopInfo();
+    #endif
  
     #if defined(TC_HAVELIGHT) || defined(TC_HAVETEMP)
     } else if(menuItemNum == MODE_SENS) {   // Show light sensor info
@@ -649,7 +708,14 @@ void enter_menu()
         doShowSensors();
     #endif
 
-    }                                      // LTS, VERSION, END: Bail out
+    } else if(menuItemNum == MODE_VER) {   // Hidden: Benchmark
+
+        allOff();
+        waitForEnterRelease();
+
+        doBenchmark();
+
+    }                                      // LTS, SD, END: Bail out
 
 quitMenu:
 
@@ -704,7 +770,7 @@ quitMenu:
 
     // all displays on and show
 
-    animate();
+    animate(false, true);
 
     // Restore night mode
     destinationTime.setNightMode(desNM);
@@ -756,6 +822,10 @@ static bool menuSelect(int& number, int mode_min, DateTime& dtu, DateTime& dtl)
             #else
             if(number == MODE_SENS) number++;
             #endif
+            #ifndef TC_LOOPPROF
+            if(number == MODE_LOOP) number++;
+            #endif
+            if(number == MODE_SD && !haveSD) number++;
             if(number > MODE_MAX) number = mode_min;
 
             if(number == MODE_PRES) {
@@ -916,6 +986,32 @@ static void menuShow(int number)
         dt_on();
         lt_off();
         break;
+    case MODE_MEM:
+        dt_showTextDirect("HEAP INFO");
+        dt_on();
+        pt_off();
+        lt_off();
+        break;
+    case MODE_LOOP:
+        dt_showTextDirect("LOOP TIMES");
+        dt_on();
+        pt_off();
+        lt_off();
+        break;
+    case MODE_SD:   // SD clock & throughput
+        dt_showTextDirect("SD CARD");
+        dt_on();
+        sprintf(buf, "%d MHZ", sdClockMHz);
+        pt_showTextDirect(buf);
+        pt_on();
+        if(sdKBps) {
+            sprintf(buf, "%d KB/S", sdKBps);
+            lt_showTextDirect(buf);
+            lt_on();
+        } else {
+            lt_off();
+        }
+        break;
     case MODE_VER:  // Version info
         dt_showTextDirect("VERSION");
         dt_on();
@@ -1794,7 +1890,9 @@ static bool doSetBrightness(clockDisplay* displaySet)
 #if defined(TC_HAVETEMP) || defined(TC_HAVELIGHT)
 static void doShowSensors()
 {
-    char buf[13];
+    char buf[13], rbuf[16];
+    int32_t rmin, rmax;
+    sensHistory *hist;
     bool luxDone = false;
     unsigned sensNow = 0;
     uint8_t numberArr[3];
@@ -1818,7 +1916,8 @@ static void doShowSensors()
     dt_on();
     pt_showTextDirect("");
     pt_on();
-    lt_off();
+    lt_showTextDirect("");
+    lt_on();
 
     isEnterKeyHeld = false;
 
@@ -1839,6 +1938,7 @@ static void doShowSensors()
                     if(numIdx > maxIdx) numIdx = 0;
                     dt_showTextDirect("WAIT");
                     pt_showTextDirect("");
+                    lt_showTextDirect("");
                 }
             }
             
@@ -1847,6 +1947,7 @@ static void doShowSensors()
             menudelay(50);
 
             if(millis() - sensNow > 3000) {
+                hist = NULL;
                 switch(numberArr[numIdx]) {
                 case 0:
                     #ifdef TC_HAVELIGHT
@@ -1857,6 +1958,7 @@ static void doShowSensors()
                     //#else
                     sprintf(buf, "%d LUX", lightSens.readLux());
                     //#endif
+                    hist = &luxHist;
                     #else
                     buf[0] = 0;
                     #endif
@@ -1870,6 +1972,7 @@ static void doShowSensors()
                     } else {
                         sprintf(buf, "%.2f~%c", temp, tempUnit ? 'C' : 'F');
                     }
+                    hist = &tempHist;
                     #else
                     buf[0] = 0;
                     #endif
@@ -1892,12 +1995,23 @@ static void doShowSensors()
                         sprintf(buf, "%2d \x7f\x80", hum);
                         #endif
                     }
+                    hist = &humHist;
                     #else
                     buf[0] = 0;
                     #endif
                     break;
                 }
                 pt_showTextDirect(buf);
+                // Last time dep. display: Range over last 24 hours
+                rbuf[0] = 0;
+                if(hist && hist->range(rmin, rmax)) {
+                    if(numberArr[numIdx] == 1) {
+                        sprintf(rbuf, "%.1f-%.1f", (float)rmin / 100.0f, (float)rmax / 100.0f);
+                    } else {
+                        sprintf(rbuf, "%d-%d", (int)rmin, (int)rmax);
+                    }
+                }
+                lt_showTextDirect(rbuf);
                 sensNow = millis();
             }
 
@@ -2065,7 +2179,7 @@ static bool bttfnValChar(char *s, int i)
     return false; 
 }
 
-static void displayClient(int numCli, int number)
+static void displayClient(int numCli, int number, bool showRTT = false)
 {
     uint8_t *ip;
     char *id;
@@ -2107,6 +2221,14 @@ static void displayClient(int numCli, int number)
             strncpy(idbuf, id, 12);
             idbuf[12] = 0;
         }
+
+        if(showRTT) {
+            int rtt = bttfnGetClientRTT(number);
+            if(rtt >= 0) {
+                if(rtt > BTTFN_RTT_MAX) rtt = BTTFN_RTT_MAX;
+                snprintf(idbuf, sizeof(idbuf), "RTT %dMS", rtt);
+            }
+        }
       
         dt_showTextDirect(idbuf);
         
@@ -2130,6 +2252,8 @@ void doShowBTTFNInfo()
     bool netDone = false;
     int numCli = bttfnNumClients();
     int oldNumCli;
+    bool showRTT = false;
+    unsigned long rttNow = millis();
 
     oldNumCli = numCli;
 
@@ -2146,10 +2270,19 @@ void doShowBTTFNInfo()
 
         if(oldNumCli != numCli) {
             number = 0;
+            showRTT = false;
+            rttNow = millis();
             displayClient(numCli, number);
             oldNumCli = numCli;
         }
 
+        // Alternate between name and round trip time
+        if(millis() - rttNow > 2000) {
+            showRTT = !showRTT;
+            rttNow = millis();
+            displayClient(numCli, number, showRTT);
+        }
+
         // If pressed
         if(checkEnterPress()) {
 
@@ -2163,6 +2296,8 @@ void doShowBTTFNInfo()
                 } else
                     number = 0;
 
+                showRTT = false;
+                rttNow = millis();
                 displayClient(numCli, number);
 
             }
@@ -2177,6 +2312,348 @@ void doShowBTTFNInfo()
     }
 }
 
+/*
+ * Show heap and stack statistics ##############################
+ */
+
+#define MEM_PG_HEAP   0
+#define MEM_PG_LARG   1
+#define MEM_PG_FRAG   2
+#define MEM_PG_TASK   3
+#define MEM_PG_MP3    (MEM_PG_TASK + MEM_NUM_TASKS)
+#define MEM_PG_JSON   (MEM_PG_MP3 + 1)
+#define MEM_PG_WMPG   (MEM_PG_MP3 + 2)
+#define MEM_PG_WMPA   (MEM_PG_MP3 + 3)
+#define MEM_PG_NUM    (MEM_PG_MP3 + 4)
+
+// Returns false if there is nothing to show on this page
+static bool displayMemPage(int page, memStats& ms)
+{
+    char buf[16], buf2[16];
+
+    buf2[0] = 0;
+
+    switch(page) {
+    case MEM_PG_HEAP:
+        dt_showTextDirect("FREE HEAP");
+        sprintf(buf, "%dK", ms.freeHeap / 1024);
+        sprintf(buf2, "MIN %dK", ms.minFreeHeap / 1024);
+        break;
+    case MEM_PG_LARG:
+        dt_showTextDirect("LARGEST BLK");
+        sprintf(buf, "%d", ms.largest);
+        sprintf(buf2, "MIN %d", ms.minLargest);
+        break;
+    case MEM_PG_FRAG:
+        dt_showTextDirect("FRAGMENTED");
+        sprintf(buf, "%d PCT", ms.frag);
+        sprintf(buf2, "MAX %d PCT", ms.maxFrag);
+        break;
+    case MEM_PG_MP3:
+        dt_showTextDirect("MP3 DECODER");
+        sprintf(buf, "%d ALLOCS", ms.mp3Allocs);
+        sprintf(buf2, "%d FAILED", ms.mp3Fails);
+        break;
+    case MEM_PG_JSON:
+        dt_showTextDirect("JSON DOCS");
+        sprintf(buf, "%d", ms.jsonDocs);
+        if(ms.jsonMax) sprintf(buf2, "MAX %d", ms.jsonMax);
+        break;
+    case MEM_PG_WMPG:
+        dt_showTextDirect("WM PAGES");
+        sprintf(buf, "%d", ms.wmPages);
+        if(ms.wmPageMinHeap) sprintf(buf2, "MIN %dK", ms.wmPageMinHeap / 1024);
+        break;
+    case MEM_PG_WMPA:
+        dt_showTextDirect("WM PARAMS");
+        sprintf(buf, "%d ALLOCS", ms.wmParmAllocs);
+        break;
+    default:
+        {
+            int t = page - MEM_PG_TASK;
+            if(t < 0 || t >= MEM_NUM_TASKS || ms.stackFree[t] == MEM_STK_UNKNOWN)
+                return false;
+            strncpy(buf, memTaskName(t), 12);
+            buf[12] = 0;
+            for(char *p = buf; *p; p++) {
+                if(*p >= 'a' && *p <= 'z') *p &= ~0x20;
+            }
+            dt_showTextDirect(buf);
+            sprintf(buf, "%d BYTES", ms.stackFree[t]);
+            strcpy(buf2, "STACK FREE");
+        }
+    }
+
+    dt_on();
+    pt_showTextDirect(buf);
+    pt_on();
+    if(*buf2) {
+        lt_showTextDirect(buf2);
+        lt_on();
+    } else {
+        lt_off();
+    }
+
+    return true;
+}
+
+static void doShowMemInfo()
+{
+    int page = MEM_PG_HEAP;
+    bool memDone = false;
+    unsigned long memNow = millis();
+    memStats ms;
+
+    memGetStats(ms, true);
+    displayMemPage(page, ms);
+
+    isEnterKeyHeld = false;
+
+    timeout = 0;  // reset timeout
+
+    // Wait for enter
+    while(!checkTimeOut() && !memDone) {
+
+        // If pressed
+        if(checkEnterPress()) {
+
+            timeout = 0;  // button pressed, reset timeout
+
+            if(!(memDone = menuWaitForRelease())) {
+
+                // Skip tasks not (yet) seen
+                do {
+                    if(++page >= MEM_PG_NUM) page = MEM_PG_HEAP;
+                } while(!displayMemPage(page, ms));
+                memNow = millis();
+
+            }
+
+        } else {
+
+            menudelay(50);
+
+            // Re-sample and update every 2 seconds
+            if(millis() - memNow > 2000) {
+                memGetStats(ms, true);
+                displayMemPage(page, ms);
+                memNow = millis();
+            }
+
+        }
+
+    }
+}
+
+#ifdef TC_LOOPPROF
+static void formatProfTime(char *buf, uint32_t us)
+{
+    if(us < 1000)           sprintf(buf, "%dUS", (int)us);
+    else if(us < 10000)     sprintf(buf, "%d.%dMS", (int)(us / 1000), (int)((us / 100) % 10));
+    else if(us < 1000000)   sprintf(buf, "%dMS", (int)(us / 1000));
+    else                    sprintf(buf, "%dS", (int)(us / 1000000));
+}
+
+static void displayLoopPage(int id)
+{
+    profStats ps;
+    char buf[16], t1[8], t2[8];
+
+    profGetStats(id, ps);
+
+    if(id == PROF_LOOP) {
+        dt_showTextDirect("LOOP PERIOD");
+    } else {
+        strcpy(buf, profName(id));
+        for(char *p = buf; *p; p++) {
+            if(*p >= 'a' && *p <= 'z') *p &= ~0x20;
+        }
+        dt_showTextDirect(buf);
+    }
+    dt_on();
+
+    if(ps.count) {
+        formatProfTime(t1, ps.p50);
+        formatProfTime(t2, ps.p99);
+        sprintf(buf, "%s/%s", t1, t2);
+        pt_showTextDirect(buf);
+        formatProfTime(t1, ps.max);
+        sprintf(buf, "MAX %s", t1);
+        lt_showTextDirect(buf);
+    } else {
+        pt_showTextDirect("NO DATA");
+        lt_showTextDirect("");
+    }
+    pt_on();
+    lt_on();
+}
+
+static void doShowLoopInfo()
+{
+    int page = PROF_LOOP;
+    bool loopDone = false;
+    unsigned long loopNow = millis();
+
+    displayLoopPage(page);
+
+    profPrint();
+
+    isEnterKeyHeld = false;
+
+    timeout = 0;  // reset timeout
+
+    // Wait for enter
+    while(!checkTimeOut() && !loopDone) {
+
+        // If pressed
+        if(checkEnterPress()) {
+
+            timeout = 0;  // button pressed, reset timeout
+
+            if(!(loopDone = menuWaitForRelease())) {
+
+                if(++page >= PROF_NUM) page = PROF_LOOP;
+                displayLoopPage(page);
+                loopNow = millis();
+
+            }
+
+        } else {
+
+            menudelay(50);
+
+            // Update every 2 seconds
+            if(millis() - loopNow > 2000) {
+                displayLoopPage(page);
+                loopNow = millis();
+            }
+
+        }
+
+    }
+}
+#endif
+
+/*
+ * Benchmark
+ */
+
+#define BENCH_PG_MP3  0
+#define BENCH_PG_READ 1
+#define BENCH_PG_CAL1 2
+#define BENCH_PG_CAL2 3
+#define BENCH_PG_I2C  4
+#define BENCH_PG_NUM  (BENCH_PG_I2C + BENCH_NUM_I2C)
+
+static void formatBenchVal(char *buf, const char *pfx, uint32_t val, const char *unit)
+{
+    if(val == BENCH_NA) sprintf(buf, "%s N/A", pfx);
+    else                sprintf(buf, "%s %d%s", pfx, (int)val, unit);
+}
+
+// Returns false if there is nothing to show on this page
+static bool displayBenchPage(int page, benchResults& br)
+{
+    char buf[20], buf2[20];
+
+    buf2[0] = 0;
+
+    switch(page) {
+    case BENCH_PG_MP3:
+        dt_showTextDirect("MP3 US/FRAME");
+        formatBenchVal(buf, "SD", br.mp3SDUs, "");
+        formatBenchVal(buf2, "FLASH", br.mp3FSUs, "");
+        break;
+    case BENCH_PG_READ:
+        dt_showTextDirect("READ KB/S");
+        formatBenchVal(buf, "SD", br.sdKBps, "");
+        formatBenchVal(buf2, "FLASH", br.fsKBps, "");
+        break;
+    case BENCH_PG_CAL1:
+        dt_showTextDirect("CALENDAR NS");
+        formatBenchVal(buf, "D2M", br.d2mNs, "");
+        formatBenchVal(buf2, "M2D", br.m2dNs, "");
+        break;
+    case BENCH_PG_CAL2:
+        dt_showTextDirect("TZ/BTTFN NS");
+        formatBenchVal(buf, "U2L", br.u2lNs, "");
+        formatBenchVal(buf2, "PKT", br.bttfnNs, "");
+        break;
+    default:
+        {
+            int d = page - BENCH_PG_I2C;
+            if(d < 0 || d >= BENCH_NUM_I2C || br.i2cUs[d] == BENCH_NA)
+                return false;
+            strcpy(buf, "I2C ");
+            strcat(buf, benchI2CName(d));
+            for(char *p = buf; *p; p++) {
+                if(*p >= 'a' && *p <= 'z') *p &= ~0x20;
+            }
+            dt_showTextDirect(buf);
+            sprintf(buf, "%d.%dUS", (int)(br.i2cUs[d] / 10), (int)(br.i2cUs[d] % 10));
+        }
+        break;
+    }
+
+    dt_on();
+    pt_showTextDirect(buf);
+    pt_on();
+    if(buf2[0]) {
+        lt_showTextDirect(buf2);
+        lt_on();
+    } else {
+        lt_off();
+    }
+
+    return true;
+}
+
+static void doBenchmark()
+{
+    int page = BENCH_PG_MP3;
+    bool benchDone = false;
+    benchResults br;
+
+    dt_showTextDirect("BENCHMARK");
+    dt_on();
+    pt_showTextDirect("RUNNING");
+    pt_on();
+
+    benchRun();
+    benchGetResults(br);
+
+    displayBenchPage(page, br);
+
+    isEnterKeyHeld = false;
+
+    timeout = 0;  // reset timeout
+
+    // Wait for enter
+    while(!checkTimeOut() && !benchDone) {
+
+        // If pressed
+        if(checkEnterPress()) {
+
+            timeout = 0;  // button pressed, reset timeout
+
+            if(!(benchDone = menuWaitForRelease())) {
+
+                // Skip absent i2c devices
+                do {
+                    if(++page >= BENCH_PG_NUM) page = BENCH_PG_MP3;
+                } while(!displayBenchPage(page, br));
+
+            }
+
+        } else {
+
+            menudelay(50);
+
+        }
+
+    }
+}
+
 /*
  * Install default audio files from SD to flash FS #############
  */
@@ -2339,12 +2816,7 @@ static bool checkTimeOut()
  */
 static void menudelay(unsigned long mydel)
 {
-    unsigned long startNow = millis();
-    myloops(true);
-    while(millis() - startNow < mydel) {
-        delay(5);
-        myloops(true);
-    }
+    schedWait(mydel, SC_MENU);
 }
 
 /*
@@ -2353,13 +2825,7 @@ static void menudelay(unsigned long mydel)
  */
 static void myssdelay(unsigned long mydel)
 {
-    unsigned long startNow = millis();
-    audio_loop();
-    while(millis() - startNow < mydel) {
-        ntp_short_loop();
-        delay(10);
-        audio_loop();
-    }
+    schedWait(mydel, SC_SHORT, 10);
 }
 
 /*
@@ -2370,18 +2836,5 @@ static void myssdelay(unsigned long mydel)
  */
 void myloops(bool menuMode)
 {
-    audio_loop();
-    if(menuMode) {
-        enterkeyScan();   // >= 19ms
-        audio_loop();
-        wifi_loop();
-        audio_loop();
-        ntp_loop();
-        audio_loop();
-    }
-    #if defined(TC_HAVEGPS) || defined(TC_HAVE_RE)
-    gps_loop(menuMode);  // 6-12ms without delay, 8-13ms with delay
-    audio_loop();
-    #endif
-    bttfn_loop();
+    schedRun(menuMode ? SC_MENU : SC_DELAY);
 }
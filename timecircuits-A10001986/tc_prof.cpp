@@ -0,0 +1,258 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Loop profiler
+ *
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#ifdef TC_LOOPPROF
+
+#include <Arduino.h>
+
+#include "tc_prof.h"
+
+// Bucket b < 4 holds b us; above, bucket 2*o+h holds values
+// with highest bit o, h being the next lower bit. Counters are 
+// halved when one saturates, so old data slowly ages out.
+#define PROF_MAX_OCT    22
+#define PROF_BUCKETS    (2 * PROF_MAX_OCT + 2)
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint16_t hist[PROF_BUCKETS];
+} profHist;
+
+static const char *profNames[PROF_NUM] = {
+    "loop", "keypad", "scankp", "ntp", "time", 
+    "wifi", "bttfn", "audio", "gps", "enter"
+};
+
+static profHist      profData[PROF_NUM];
+static unsigned long profLast = 0;
+
+#ifdef TC_CYCPROF
+typedef struct {
+    uint32_t count;
+    uint64_t total;
+    uint32_t max;
+} cycData;
+
+static const char *cycNames[CYC_NUM] = {
+    "c_mp3", "c_wav", "c_showint", "c_bttfnpkt"
+};
+
+static cycData cycProbes[CYC_NUM];
+
+// Called from the audio task as well; a torn update
+// only skews the statistics, so no lock
+void cycNote(int id, uint32_t cycles)
+{
+    cycData *c = &cycProbes[id];
+
+    c->count++;
+    c->total += cycles;
+    if(cycles > c->max) c->max = cycles;
+}
+#endif
+
+static inline int profBucket(uint32_t us)
+{
+    int o;
+    
+    if(us < 4) return us;
+    o = 31 - __builtin_clz(us);
+    if(o > PROF_MAX_OCT) return PROF_BUCKETS - 1;
+    return 2 * o + ((us >> (o - 1)) & 1);
+}
+
+static uint32_t profBucketTop(int b)
+{
+    int o;
+
+    if(b < 4) return b;
+    o = b / 2;
+    return (1UL << o) + ((b & 1) + 1) * (1UL << (o - 1)) - 1;
+}
+
+void profNote(int id, uint32_t us)
+{
+    profHist *h = &profData[id];
+    int b = profBucket(us);
+
+    if(!h->count || us < h->min) h->min = us;
+    if(us > h->max) h->max = us;
+    h->count++;
+
+    if(++h->hist[b] == 0xffff) {
+        for(int i = 0; i < PROF_BUCKETS; i++) {
+            h->hist[i] >>= 1;
+        }
+    }
+}
+
+// Called at the top of loop()
+void profLoop()
+{
+    unsigned long now = micros();
+
+    if(profLast) {
+        profNote(PROF_LOOP, now - profLast);
+    }
+    profLast = now;
+}
+
+void profReset()
+{
+    memset(profData, 0, sizeof(profData));
+    profLast = 0;
+    #ifdef TC_CYCPROF
+    memset(cycProbes, 0, sizeof(cycProbes));
+    #endif
+}
+
+static uint32_t profPercentile(profHist *h, uint32_t total, int pct)
+{
+    uint32_t want = (total * pct + 99) / 100, sum = 0;
+
+    for(int i = 0; i < PROF_BUCKETS; i++) {
+        sum += h->hist[i];
+        if(sum >= want) {
+            uint32_t t = profBucketTop(i);
+            return (t > h->max) ? h->max : t;
+        }
+    }
+    return h->max;
+}
+
+bool profGetStats(int id, profStats& ps)
+{
+    profHist *h;
+    uint32_t total = 0;
+
+    if(id < 0 || id >= PROF_NUM)
+        return false;
+
+    h = &profData[id];
+    
+    memset(&ps, 0, sizeof(ps));
+    if(!(ps.count = h->count))
+        return true;
+
+    for(int i = 0; i < PROF_BUCKETS; i++) {
+        total += h->hist[i];
+    }
+
+    ps.min = h->min;
+    ps.max = h->max;
+    ps.p50 = profPercentile(h, total, 50);
+    ps.p99 = profPercentile(h, total, 99);
+
+    return true;
+}
+
+const char *profName(int id)
+{
+    return (id >= 0 && id < PROF_NUM) ? profNames[id] : "";
+}
+
+// name=count/min/p50/p99/max (us), comma-separated; for MQTT
+int profStatsToText(char *buf, int bufSize)
+{
+    profStats ps;
+    int len = 0;
+
+    buf[0] = 0;
+
+    for(int i = 0; i < PROF_NUM && len < bufSize; i++) {
+        profGetStats(i, ps);
+        if(!ps.count) continue;
+        len += snprintf(buf + len, bufSize - len, "%s%s=%u/%u/%u/%u/%u",
+                    len ? "," : "", profNames[i],
+                    ps.count, ps.min, ps.p50, ps.p99, ps.max);
+    }
+
+    #ifdef TC_CYCPROF
+    // name=count/avg/max (cycles)
+    for(int i = 0; i < CYC_NUM && len < bufSize; i++) {
+        cycData *c = &cycProbes[i];
+        if(!c->count) continue;
+        len += snprintf(buf + len, bufSize - len, "%s%s=%u/%u/%u",
+                    len ? "," : "", cycNames[i],
+                    c->count, (uint32_t)(c->total / c->count), c->max);
+    }
+    #endif
+
+    return (len < bufSize) ? len : bufSize - 1;
+}
+
+void profPrint()
+{
+    profStats ps;
+
+    Serial.println("Loop times (us)   count      min      p50      p99      max");
+    for(int i = 0; i < PROF_NUM; i++) {
+        profGetStats(i, ps);
+        Serial.printf("%-10s %12u %8u %8u %8u %8u\n", profNames[i],
+                    ps.count, ps.min, ps.p50, ps.p99, ps.max);
+    }
+
+    #ifdef TC_CYCPROF
+    Serial.printf("Cycles @%dMHz     count      avg      max\n", getCpuFrequencyMhz());
+    for(int i = 0; i < CYC_NUM; i++) {
+        cycData *c = &cycProbes[i];
+        Serial.printf("%-10s %12u %8u %8u\n", cycNames[i], c->count,
+                    c->count ? (uint32_t)(c->total / c->count) : 0, c->max);
+    }
+    #endif
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Loop profiler
+ *
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_PROF_H
+#define _TC_PROF_H
+
+/*
+ * Loop profiler
+ *
+ * Records the duration of each call of the main loop's subsystems,
+ * as well as the period of loop() itself, in histograms with two
+ * buckets per octave (1us - 8s). Calls made from within other calls
+ * (eg through mydelay()) are counted separately, and are included in
+ * the duration of the outer call.
+ *
+ * Shown in the keypad menu ("LOOP TIMES"), published via MQTT
+ * (bttf/tcd/loop, along with the scheduler's late counts) and printed to Serial upon LOOP_STATS command.
+ *
+ * Overhead is two micros() calls plus a few instructions per
+ * call, so this can stay enabled.
+ *
+ * With TC_CYCPROF, a few hot functions are also measured in CPU
+ * cycles (count, average, maximum), to compare builds with and 
+ * without IRAM placement (TC_IRAM_HOT).
+ */
+
+#ifdef TC_LOOPPROF
+
+enum {
+    PROF_LOOP = 0,      // loop() period, not a call
+    PROF_KEYPAD,
+    PROF_SCANKP,
+    PROF_NTP,
+    PROF_TIME,
+    PROF_WIFI,
+    PROF_BTTFN,
+    PROF_AUDIO,
+    PROF_GPS,
+    PROF_ENTER,
+    PROF_NUM
+};
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;       // us
+    uint32_t p50;       // us; upper bound of bucket
+    uint32_t p99;
+    uint32_t max;
+} profStats;
+
+#define PROF_CALL(id, x) do { uint32_t _pst = micros(); x; profNote(id, micros() - _pst); } while(0)
+
+void profNote(int id, uint32_t us);
+void profLoop();
+void profReset();
+
+bool profGetStats(int id, profStats& ps);
+const char *profName(int id);
+int  profStatsToText(char *buf, int bufSize);
+void profPrint();
+
+#ifdef TC_CYCPROF
+
+// Cycle probes (TC_CYCPROF): CPU cycles per call of hot functions.
+// Include time spent in interrupts and, on the same core, other tasks.
+enum {
+    CYC_MP3 = 0,        // AudioGeneratorMP3::loop()
+    CYC_WAV,            // AudioGeneratorWAV::loop()
+    CYC_SHOWINT,        // clockDisplay::showInt()
+    CYC_BTTFNPKT,       // bttfn_handlePacket()
+    CYC_NUM
+};
+
+#define CYC_START()     uint32_t _cst = ESP.getCycleCount()
+#define CYC_END(id)     cycNote(id, ESP.getCycleCount() - _cst)
+#define CYC_CALL(id, x) do { uint32_t _cst = ESP.getCycleCount(); x; cycNote(id, ESP.getCycleCount() - _cst); } while(0)
+
+void cycNote(int id, uint32_t cycles);
+
+#endif
+
+#else
+
+#define PROF_CALL(id, x) x
+
+#endif
+
+#ifndef TC_CYCPROF
+#define CYC_START()
+#define CYC_END(id)
+#define CYC_CALL(id, x) x
+#endif
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Cooperative scheduler
+ *
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+
+#include "tc_audio.h"
+#include "tc_keypad.h"
+#include "tc_menus.h"
+#include "tc_time.h"
+#include "tc_wifi.h"
+#include "tc_mem.h"
+#include "tc_anim.h"
+#include "tc_prof.h"
+#include "tc_state.h"
+
+#include "tc_sched.h"
+#include "tc_stall.h"
+
+#define SCH_BETWEEN 0x01    // Run after every other task
+
+#ifdef TC_LOOPPROF
+#define SP(x) x
+#else
+#define SP(x) -1
+#endif
+
+typedef struct {
+    const char    *name;
+    void          (*func)(uint8_t ctx);
+    uint16_t      period;     // ms; 0 = every pass
+    uint16_t      deadline;   // ms; 0 = none
+    uint8_t       prio;       // 0 = highest
+    uint8_t       ctx;        // SC_xx mask
+    uint8_t       flags;
+    int8_t        prof;       // PROF_xx id, -1 = none
+    bool          running;
+    unsigned long lastRun;
+    uint32_t      late;
+} schedTask;
+
+static void t_audio(uint8_t ctx)  { audio_loop(); }
+static void t_keypad(uint8_t ctx) { keypad_loop(); }
+static void t_scankp(uint8_t ctx) { scanKeypad(); }
+static void t_enter(uint8_t ctx)  { enterkeyScan(); }   // >= 19ms
+static void t_time(uint8_t ctx)   { time_loop(); }
+static void t_wifi(uint8_t ctx)   { wifi_loop(); }
+static void t_bttfn(uint8_t ctx)  { bttfn_loop(); }
+static void t_anim(uint8_t ctx)   { anim_loop(); }
+static void t_mem(uint8_t ctx)    { mem_loop(); }
+static void t_pwr(uint8_t ctx)    { pwr_loop(); }
+static void t_state(uint8_t ctx)  { statePublish(); }
+
+// Full NTP loop (with time sync) only from loop() and the menu
+static void t_ntp(uint8_t ctx)
+{
+    if(ctx & (SC_MAIN|SC_MENU)) ntp_loop();
+    else                        ntp_short_loop();
+}
+
+#if defined(TC_HAVEGPS) || defined(TC_HAVE_RE)
+// Called from time_loop() in SC_MAIN; RotEnc must not 
+// be polled while time_loop() is running (SC_DELAY).
+static void t_gps(uint8_t ctx)
+{
+    gps_loop(!(ctx & SC_DELAY));    // 6-12ms without delay, 8-13ms with delay
+}
+#endif
+
+#define SC_ALL      (SC_MAIN|SC_MENU|SC_DELAY|SC_INTRO|SC_INTNG|SC_SHORT)
+
+static schedTask schedTasks[] = {
+  // name      func      period deadl prio  contexts                                           flags        prof
+  { "audio",   t_audio,  0,     10,   0,    SC_ALL,                                            SCH_BETWEEN, SP(PROF_AUDIO)  },
+  { "keypad",  t_keypad, 0,     50,   1,    SC_MAIN,                                           0,           SP(PROF_KEYPAD) },
+  { "scankp",  t_scankp, 0,     50,   1,    SC_MAIN,                                           0,           SP(PROF_SCANKP) },
+  { "enter",   t_enter,  0,     50,   1,    SC_MENU,                                           0,           SP(PROF_ENTER)  },
+  { "ntp",     t_ntp,    0,     100,  2,    SC_MAIN|SC_MENU|SC_INTRO|SC_INTNG|SC_SHORT,        0,           SP(PROF_NTP)    },
+  { "time",    t_time,   0,     50,   2,    SC_MAIN,                                           0,           SP(PROF_TIME)   },
+  { "wifi",    t_wifi,   0,     100,  3,    SC_MAIN|SC_MENU|SC_INTRO,                          0,           SP(PROF_WIFI)   },
+  #if defined(TC_HAVEGPS) || defined(TC_HAVE_RE)
+  { "gps",     t_gps,    0,     50,   4,    SC_MENU|SC_DELAY|SC_INTRO,                         0,           SP(PROF_GPS)    },
+  #endif
+  { "bttfn",   t_bttfn,  0,     100,  4,    SC_MAIN|SC_MENU|SC_DELAY|SC_INTRO|SC_INTNG,        0,           SP(PROF_BTTFN)  },
+  { "anim",    t_anim,   0,     20,   4,    SC_DELAY,                                          0,           -1              },
+  { "mem",     t_mem,    1000,  0,    5,    SC_MAIN,                                           0,           -1              },
+  { "pwr",     t_pwr,    0,     0,    5,    SC_MAIN,                                           0,           -1              },
+  { "state",   t_state,  0,     0,    5,    SC_ALL,                                            0,           -1              }
+};
+#define SCHED_NUM ((int)(sizeof(schedTasks) / sizeof(schedTasks[0])))
+
+static bool schedSorted = false;
+
+// Sort by priority; stable, so table order is kept within a priority
+static void schedSort()
+{
+    schedTask t;
+
+    for(int i = 1; i < SCHED_NUM; i++) {
+        t = schedTasks[i];
+        int j = i - 1;
+        for( ; j >= 0 && schedTasks[j].prio > t.prio; j--) {
+            schedTasks[j + 1] = schedTasks[j];
+        }
+        schedTasks[j + 1] = t;
+    }
+    schedSorted = true;
+}
+
+static void schedCall(schedTask *t, uint8_t ctx, unsigned long now)
+{
+    if(t->deadline && t->lastRun && now - t->lastRun > t->deadline) {
+        t->late++;
+    }
+
+    t->running = true;
+    STALL_TASK_SET(t->name);
+    #ifdef TC_LOOPPROF
+    if(t->prof >= 0) {
+        PROF_CALL(t->prof, t->func(ctx));
+    } else
+    #endif
+        t->func(ctx);
+    STALL_TASK_END();
+    t->running = false;
+
+    t->lastRun = millis();
+}
+
+static void schedBetween(uint8_t ctx)
+{
+    for(int i = 0; i < SCHED_NUM; i++) {
+        schedTask *t = &schedTasks[i];
+        if((t->flags & SCH_BETWEEN) && (t->ctx & ctx) && !t->running) {
+            schedCall(t, ctx, millis());
+        }
+    }
+}
+
+// One pass: Run all tasks due in context ctx, by priority
+void schedRun(uint8_t ctx)
+{
+    unsigned long now;
+    
+    if(!schedSorted) schedSort();
+
+    STALL_BEAT();
+
+    schedBetween(ctx);
+
+    for(int i = 0; i < SCHED_NUM; i++) {
+        schedTask *t = &schedTasks[i];
+        
+        if(!(t->ctx & ctx) || t->running || (t->flags & SCH_BETWEEN))
+            continue;
+
+        now = millis();
+        if(t->period && t->lastRun && now - t->lastRun < t->period)
+            continue;
+
+        schedCall(t, ctx, now);
+        schedBetween(ctx);
+    }
+}
+
+// Wait ms milliseconds, running context ctx's tasks
+// with a delay() of gran ms between passes
+void schedWait(unsigned long ms, uint8_t ctx, uint32_t gran)
+{
+    unsigned long startNow = millis();
+
+    schedRun(ctx);
+    while(millis() - startNow < ms) {
+        delay(gran);
+        schedRun(ctx);
+    }
+}
+
+// late_name=count for late tasks, comma-separated; for MQTT
+int schedStatsToText(char *buf, int bufSize)
+{
+    int len = 0;
+
+    buf[0] = 0;
+
+    for(int i = 0; i < SCHED_NUM && len < bufSize; i++) {
+        if(!schedTasks[i].late) continue;
+        len += snprintf(buf + len, bufSize - len, "%slate_%s=%u",
+                    len ? "," : "", schedTasks[i].name, schedTasks[i].late);
+    }
+
+    return (len < bufSize) ? len : bufSize - 1;
+}
@@ -0,0 +1,87 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Cooperative scheduler
+ *
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_SCHED_H
+#define _TC_SCHED_H
+
+/*
+ * Cooperative scheduler
+ *
+ * All periodic subsystem calls (audio_loop(), time_loop(), wifi_loop()
+ * etc) are listed in one task table in tc_sched.cpp, each with a
+ * period, a deadline, a priority and the contexts it may run in.
+ * loop() and all waits (mydelay(), menudelay() etc) run the same 
+ * scheduler, only with a different context; this replaces the 
+ * hand-written call chains formerly found in each delay function.
+ *
+ * A task is never entered while it is already running (eg time_loop() 
+ * calling mydelay()). Tasks flagged SCH_BETWEEN (audio) are run after 
+ * every other task, for bounded audio latency. A task whose calls are 
+ * further apart than its deadline counts as late; this includes gaps 
+ * caused by long calls of other tasks (eg the keypad menu, which runs 
+ * inside keypad_loop()).
+ */
+
+// Contexts
+#define SC_MAIN     0x01    // loop()
+#define SC_MENU     0x02    // menudelay(), myloops(true)
+#define SC_DELAY    0x04    // mydelay(), myloops(false)
+#define SC_INTRO    0x08    // myIntroDelay()
+#define SC_INTNG    0x10    // myIntroDelay() without GPS and WiFi
+#define SC_SHORT    0x20    // myssdelay(), myCustomDelay_xx()
+
+void schedRun(uint8_t ctx);
+void schedWait(unsigned long ms, uint8_t ctx, uint32_t gran = 5);
+
+int  schedStatsToText(char *buf, int bufSize);
+
+#endif
@@ -63,6 +63,7 @@
 #include <SD.h>
 #include <SPI.h>
 #include <FS.h>
+#include <esp_rom_crc.h>
 #ifdef USE_SPIFFS
 #include <SPIFFS.h>
 #else
@@ -75,19 +76,45 @@
 #include "tc_audio.h"
 #include "tc_time.h"
 #include "tc_wifi.h"
+#include "tc_mem.h"
 #ifdef HAVE_STALE_PRESENT
 #include "clockdisplay.h"
 #endif
 
+#include "src/ESP8266Audio/AudioFileSourceSD.h"
+
 // Size of main config JSON
 // Needs to be adapted when config grows
 #define JSON_SIZE 2500
 #if ARDUINOJSON_VERSION_MAJOR >= 7
-#define DECLARE_S_JSON(x,n) JsonDocument n;
-#define DECLARE_D_JSON(x,n) JsonDocument n;
+// JSON documents are allocated from one fixed-size arena instead of 
+// piecemeal from the heap. The arena is held during settings_setup(), 
+// so all config files read at boot share one block; otherwise it is 
+// allocated for as long as a document exists. Should a document not 
+// fit, the rest comes from the heap.
+#define JSON_ARENA_SIZE 8192
+class JsonArena : public ArduinoJson::Allocator {
+  public:
+    void hold(bool doHold);
+    size_t peak() { return _peak; }
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t newSize) override;
+  private:
+    bool inArena(void *ptr) { return _buf && (uint8_t *)ptr >= _buf && (uint8_t *)ptr < _buf + JSON_ARENA_SIZE; }
+    void release();
+    uint8_t *_buf = NULL;
+    size_t   _used = 0;
+    size_t   _peak = 0;
+    int      _live = 0;
+    bool     _hold = false;
+};
+static JsonArena jsonArena;
+#define DECLARE_S_JSON(x,n) JsonDocument n(&jsonArena); memNoteJson(0);
+#define DECLARE_D_JSON(x,n) JsonDocument n(&jsonArena); memNoteJson(0);
 #else
 #define DECLARE_S_JSON(x,n) StaticJsonDocument<x> n;
-#define DECLARE_D_JSON(x,n) DynamicJsonDocument n(x);
+#define DECLARE_D_JSON(x,n) DynamicJsonDocument n(x); memNoteJson(x);
 #endif 
 
 #define NUM_AUDIOFILES 20
@@ -110,22 +137,7 @@ static uint8_t*   f(uint8_t *d, uint32_t m, int y) { return d; }
 
 static const char *cfgName    = "/config.json";     // Main config (flash)
 static const char *ipCfgName  = "/ipconfig.json";   // IP config (flash)
-static const char *briCfgName = "/tcdbricfg.json";  // Brightness (flash/SD)
-static const char *ainCfgName = "/tcdaicfg.json";   // Auto-interval (flash/SD)
-static const char *volCfgName = "/tcdvolcfg.json";  // Volume config (flash/SD)
-static const char *almCfgName = "/tcdalmcfg.json";  // Alarm config (flash/SD)
-static const char *remCfgName = "/tcdremcfg.json";  // Reminder config (flash/SD)
-#ifdef HAVE_STALE_PRESENT
-static const char *stCfgName  = "/stconfig";        // Exhib Mode (flash/SD)
-#endif
-static const char *musCfgName = "/tcdmcfg.json";    // Music config (SD)
-static const char *cmCfgName  = "/cmconfig.json";   // Carmode (flash/SD)
-#ifdef TC_HAVELINEOUT
-static const char *loCfgName  = "/loconfig.json";   // LineOut (flash/SD)
-#endif
-#ifdef TC_HAVE_REMOTE
-static const char *raCfgName  = "/raconfig.json";   // RemoteAllowed (flash/SD)
-#endif
+// Secondary settings: See "Secondary settings store" below
 
 
 static const char *fsNoAvail = "File System not available";
@@ -155,12 +167,13 @@ bool haveAudioFiles = false;
 /* Music Folder Number */
 uint8_t musFolderNum = 0;
 
-/* Cache */
-static uint8_t  preSavedDBri = 20;
-static uint8_t  preSavedPBri = 20;
-static uint8_t  preSavedLBri = 20;
-static uint8_t  preSavedAI   = 99;
-static uint8_t  prevSavedVol = 254;
+/* Typed copy of numeric settings, see validateSettings() */
+struct TypedSettings cfg;
+
+/* SD clock (MHz) and measured read throughput (KB/s; 0 = unknown) */
+uint8_t  sdClockMHz = 0;
+uint16_t sdKBps = 0;
+
 static uint8_t* (*r)(uint8_t *, uint32_t, int);
 
 static bool read_settings(File configFile);
@@ -171,6 +184,7 @@ static bool CopyCheckValidNumParmF(const char *json, char *text, uint8_t psize,
 static bool checkValidNumParm(char *text, int lowerLim, int upperLim, int setDefault);
 static bool checkValidNumParmF(char *text, float lowerLim, float upperLim, float setDefault);
 
+static void loadSecSettings();
 static bool loadBrightness();
 static bool loadAutoInterval();
 
@@ -184,7 +198,27 @@ static void loadRemoteAllowed();
 static void setupDisplayConfigOnSD();
 static void saveDisplayData();
 
-static void cfc(File& sfile, int& haveErr, int& haveWriteErr);
+static void sdTune(uint32_t mountFreq);
+
+#define CPA_NUM_FILES (NUM_AUDIOFILES+10+1)
+#define CPA_BLOCK     16384         // Copy block size, multiple of CPA_CHUNK
+#define CPA_CHUNK     1024          // Unit of container encoding
+#define CPA_MF_HDR    12
+#define CPA_MF_REC    9
+typedef struct {
+    uint8_t  *buf;
+    uint32_t bufSize;
+    uint8_t  sbuf[CPA_CHUNK];       // Fall-back if out of memory
+    bool     done[CPA_NUM_FILES];   // in manifest
+    uint32_t len[CPA_NUM_FILES];
+    uint32_t crc[CPA_NUM_FILES];
+    int      copied;
+    int      skipped;
+} cpaState;
+static const char *CPA_MANIFEST = "/tcdacopy.bin";
+
+static void cpaLoadManifest(cpaState& cs, uint32_t conSize);
+static void cfc(cpaState& cs, int idx, File& sfile, int& haveErr, int& haveWriteErr);
 static bool audio_files_present();
 
 static bool CopyIPParm(const char *json, char *text, uint8_t psize);
@@ -214,6 +248,10 @@ void settings_setup()
     bool writedefault = false;
     bool SDres = false;
 
+    #if ARDUINOJSON_VERSION_MAJOR >= 7
+    jsonArena.hold(true);
+    #endif
+
     // Pre-maturely use ENTER button (initialized again in keypad_setup())
     // Pin pulled-down on control board
     pinMode(ENTER_BUTTON_PIN, INPUT);
@@ -302,13 +340,16 @@ void settings_setup()
         Serial.println(F("*** Settings will be stored on SD card (if available)"));
 
     }
+
+    // Fill typed copy (settings from flash FS or defaults)
+    validateSettings();
     
     // Set up SD card
     SPI.begin(SPI_SCK_PIN, SPI_MISO_PIN, SPI_MOSI_PIN);
 
     haveSD = false;
 
-    uint32_t sdfreq = (settings.sdFreq[0] == '0') ? 16000000 : 4000000;
+    uint32_t sdfreq = cfg.sdFreq ? 4000000 : 16000000;
     #ifdef TC_DBG
     Serial.printf("%s: SD/SPI frequency %dMHz\n", funcName, sdfreq / 1000000);
     #endif
@@ -322,6 +363,7 @@ void settings_setup()
         Serial.printf("Retrying at 25Mhz... ");
         #endif
         SDres = SD.begin(SD_CS_PIN, SPI, 25000000);
+        sdfreq = 25000000;
     }
 
     if(SDres) {
@@ -339,6 +381,12 @@ void settings_setup()
 
         haveSD = ((cardType != CARD_NONE) && (cardType != CARD_UNKNOWN));
 
+        // Select fastest reliable clock (unless fixed by user)
+        sdClockMHz = sdfreq / 1000000;
+        if(haveSD && !cfg.sdFreq) {
+            sdTune(sdfreq);
+        }
+
     } else {
 
         Serial.println(F("No SD card found"));
@@ -367,6 +415,7 @@ void settings_setup()
                 #endif
                 write_settings();
             }
+            validateSettings();
         }
     }
 
@@ -380,11 +429,14 @@ void settings_setup()
     }
 
     // Determine if secondary settings are to be stored on SD
-    configOnSD = (haveSD && ((settings.CfgOnSD[0] != '0') || FlashROMode));
+    configOnSD = (haveSD && (cfg.CfgOnSD || FlashROMode));
 
     // Setup save target for display objects
     setupDisplayConfigOnSD();
 
+    // Read secondary settings store(s)
+    loadSecSettings();
+
     // Load display brightness config
     loadBrightness();
 
@@ -428,10 +480,22 @@ void settings_setup()
         }
         digitalWrite(WHITE_LED_PIN, LOW);
     }
+
+    #if ARDUINOJSON_VERSION_MAJOR >= 7
+    jsonArena.hold(false);
+    memNoteJson(jsonArena.peak());
+    #ifdef TC_DBG
+    Serial.printf("%s: JSON arena peak %d (of %d)\n", funcName, jsonArena.peak(), JSON_ARENA_SIZE);
+    #endif
+    #endif
 }
 
 void unmount_fs()
 {
+    flushSecSettings(true);
+
+    flushOpenAudioFiles();
+
     if(haveFS) {
         SPIFFS.end();
         #ifdef TC_DBG
@@ -448,6 +512,328 @@ void unmount_fs()
     }
 }
 
+/*
+ * SD clock tuning
+ *
+ * At boot, a test file is written at the lowest clock and read back
+ * at increasing clocks; the fastest clock at which all reads return
+ * correct data (CRC) is used. The result is stored on the card
+ * itself, so a new card is probed again; deleting the file forces a
+ * new probe. Read errors during operation (audio, readFileFromSD)
+ * step the stored clock down; this takes effect at the next boot as
+ * re-mounting would invalidate open files.
+ */
+
+#define SD_TUNE_MAGIC   "TCSC"
+#define SD_TUNE_VERSION 1
+#define SD_PRB_SIZE     8192
+#define SD_PRB_READS    3
+#define SD_ERR_LIMIT    3
+
+static const char *sdTuneName = "/tcdsdclk.bin";
+static const char *sdPrbName  = "/tcdsdprb.bin";
+
+static const uint8_t sdFreqs[] = { 4, 8, 10, 16, 20 };     // MHz
+#define SD_NUM_FREQS (int)(sizeof(sdFreqs) / sizeof(sdFreqs[0]))
+
+typedef struct {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  fidx;
+    uint16_t kbps;
+    uint32_t crc;                   // over all of the above
+} sdTuneRec;
+
+static int      sdFidx = -1;        // index into sdFreqs; -1 = not tuned
+static uint32_t sdReadErrs = 0;     // readFileFromSD()
+static uint32_t sdErrBase = 0;
+static bool     sdDowngraded = false;
+
+static bool sdMount(uint32_t freq)
+{
+    SD.end();
+    return SD.begin(SD_CS_PIN, SPI, freq);
+}
+
+static bool sdLoadTune(int& fidx, uint16_t& kbps)
+{
+    sdTuneRec t;
+
+    if(!readFileFromSD(sdTuneName, (uint8_t *)&t, sizeof(t)))
+        return false;
+
+    if(memcmp(t.magic, SD_TUNE_MAGIC, 4) || t.version != SD_TUNE_VERSION ||
+       t.fidx >= SD_NUM_FREQS ||
+       t.crc != esp_rom_crc32_le(0, (uint8_t *)&t, sizeof(t) - 4))
+        return false;
+
+    fidx = t.fidx;
+    kbps = t.kbps;
+    return true;
+}
+
+static void sdSaveTune(int fidx, uint16_t kbps)
+{
+    sdTuneRec t;
+
+    memcpy(t.magic, SD_TUNE_MAGIC, 4);
+    t.version = SD_TUNE_VERSION;
+    t.fidx = fidx;
+    t.kbps = kbps;
+    t.crc = esp_rom_crc32_le(0, (uint8_t *)&t, sizeof(t) - 4);
+
+    writeFileToSD(sdTuneName, (uint8_t *)&t, sizeof(t));
+}
+
+// Returns index of fastest good clock, -1 if none (or no test possible)
+static int sdProbe(uint16_t& kbps)
+{
+    uint8_t *buf;
+    uint32_t crc, rnd = 0x1955;
+    int best = -1;
+
+    if(!(buf = (uint8_t *)malloc(SD_PRB_SIZE)))
+        return -1;
+
+    if(sdMount(sdFreqs[0] * 1000000)) {
+        for(int i = 0; i < SD_PRB_SIZE; i++) {
+            rnd = (rnd * 1103515245) + 12345;
+            buf[i] = rnd >> 16;
+        }
+        crc = esp_rom_crc32_le(0, buf, SD_PRB_SIZE);
+        if(!writeFileToSD(sdPrbName, buf, SD_PRB_SIZE)) {
+            #ifdef TC_DBG
+            Serial.println(F("SD: Probe file not writable; clock not tuned"));
+            #endif
+        } else {
+            for(int i = 0; i < SD_NUM_FREQS; i++) {
+                unsigned long t;
+                bool ok;
+                if(!sdMount(sdFreqs[i] * 1000000))
+                    break;
+                t = micros();
+                ok = true;
+                for(int j = 0; j < SD_PRB_READS && ok; j++) {
+                    memset(buf, 0, SD_PRB_SIZE);
+                    ok = readFileFromSD(sdPrbName, buf, SD_PRB_SIZE) &&
+                         (esp_rom_crc32_le(0, buf, SD_PRB_SIZE) == crc);
+                }
+                t = micros() - t;
+                #ifdef TC_DBG
+                Serial.printf("SD: Probe at %dMHz: %s, %luus\n", sdFreqs[i], ok ? "ok" : "failed", t);
+                #endif
+                if(!ok)
+                    break;
+                best = i;
+                kbps = (uint16_t)(((uint64_t)SD_PRB_SIZE * SD_PRB_READS * 1000000ULL) / (1024ULL * (t ? t : 1)));
+            }
+        }
+    }
+
+    free(buf);
+
+    return best;
+}
+
+static void sdTune(uint32_t mountFreq)
+{
+    int fidx;
+    uint16_t kbps = 0;
+    bool probed = false;
+
+    if(!sdLoadTune(fidx, kbps)) {
+        fidx = sdProbe(kbps);
+        probed = true;
+    }
+
+    if(fidx >= 0 && sdMount(sdFreqs[fidx] * 1000000)) {
+        sdFidx = fidx;
+        sdClockMHz = sdFreqs[fidx];
+        sdKBps = kbps;
+        if(probed) {
+            sdSaveTune(fidx, kbps);
+        }
+    } else {
+        // Back to where we came from
+        if(!sdMount(mountFreq)) {
+            haveSD = false;
+            return;
+        }
+    }
+
+    if(probed) {
+        SD.remove(sdPrbName);
+    }
+
+    // Errors during probing don't count
+    sdErrBase = sdReadErrs;
+
+    #ifdef TC_DBG
+    Serial.printf("SD: Clock %dMHz", sdClockMHz);
+    if(sdKBps) Serial.printf(", %dKB/s", sdKBps);
+    Serial.println("");
+    #endif
+}
+
+/*
+ * Check for read errors; if there were too many, store the next 
+ * lower clock for next boot. Called periodically from main loop.
+ */
+void sdHealthCheck()
+{
+    uint32_t errs;
+
+    if(!haveSD || sdFidx < 0 || sdDowngraded)
+        return;
+
+    errs = sdReadErrs + AudioFileSourceSD::readErrors;
+    if(errs - sdErrBase < SD_ERR_LIMIT)
+        return;
+
+    sdErrBase = errs;
+
+    if(sdFidx > 0) {
+        #ifdef TC_DBG
+        Serial.printf("SD: %d read errors, clock %dMHz -> %dMHz at next boot\n", errs, sdFreqs[sdFidx], sdFreqs[sdFidx - 1]);
+        #endif
+        sdSaveTune(sdFidx - 1, 0);
+        sdDowngraded = true;
+    }
+}
+
+/*
+ * Numeric settings: JSON key (NULL = not stored), string form,
+ * typed form, limits and default. Used for reading, writing and
+ * validating the config, and for filling the typed copy in cfg.
+ */
+#define PT_BOOL  0
+#define PT_U8    1
+#define PT_U16   2
+#define PT_FLOAT 3
+
+static const struct {
+    const char *key;
+    char       *text;
+    uint8_t    size;
+    uint8_t    type;
+    void       *val;
+    float      lowerLim;
+    float      upperLim;
+    float      setDefault;
+} numParms[] = {
+#define NP(k, f, t, l, u, d) { k, settings.f, sizeof(settings.f), t, (void *)&cfg.f, l, u, d }
+    NP("timeTrPers",     timesPers,      PT_BOOL,  0,           1,           DEF_TIMES_PERS),
+    NP("alarmRTC",       alarmRTC,       PT_BOOL,  0,           1,           DEF_ALARM_RTC),
+    NP("playIntro",      playIntro,      PT_BOOL,  0,           1,           DEF_PLAY_INTRO),
+    NP("mode24",         mode24,         PT_BOOL,  0,           1,           DEF_MODE24),
+    NP("beep",           beep,           PT_U8,    0,           3,           DEF_BEEP),
+    NP("wifiConRetries", wifiConRetries, PT_U8,    1,           10,          DEF_WIFI_RETRY),
+    NP("wifiConTimeout", wifiConTimeout, PT_U8,    7,           25,          DEF_WIFI_TIMEOUT),
+    NP("wifiOffDelay",   wifiOffDelay,   PT_U8,    0,           99,          DEF_WIFI_OFFDELAY),
+    NP("wifiAPOffDelay", wifiAPOffDelay, PT_U8,    0,           99,          DEF_WIFI_APOFFDELAY),
+    NP("wifiPRetry",     wifiPRetry,     PT_BOOL,  0,           1,           DEF_WIFI_PRETRY),
+    NP("dtNmOff",        dtNmOff,        PT_BOOL,  0,           1,           DEF_DT_OFF),
+    NP("ptNmOff",        ptNmOff,        PT_BOOL,  0,           1,           DEF_PT_OFF),
+    NP("ltNmOff",        ltNmOff,        PT_BOOL,  0,           1,           DEF_LT_OFF),
+    NP("autoNMPreset",   autoNMPreset,   PT_U8,    0,           10,          DEF_AUTONM_PRESET),
+    NP("autoNMOn",       autoNMOn,       PT_U8,    0,           23,          DEF_AUTONM_ON),
+    NP("autoNMOff",      autoNMOff,      PT_U8,    0,           23,          DEF_AUTONM_OFF),
+#ifdef TC_HAVELIGHT
+    NP("useLight",       useLight,       PT_BOOL,  0,           1,           DEF_USE_LIGHT),
+    NP("luxLimit",       luxLimit,       PT_U16,   0,           50000,       DEF_LUX_LIMIT),
+#endif
+#ifdef TC_HAVETEMP
+    NP("tempUnit",       tempUnit,       PT_BOOL,  0,           1,           DEF_TEMP_UNIT),
+    NP("tempOffs",       tempOffs,       PT_FLOAT, -3.0,        3.0,         DEF_TEMP_OFFS),
+#endif
+#ifdef TC_HAVESPEEDO
+    NP("speedoType",     speedoType,     PT_U8,    SP_MIN_TYPE, 99,          DEF_SPEEDO_TYPE),
+    NP("speedoBright",   speedoBright,   PT_U8,    0,           15,          DEF_BRIGHT_SPEEDO),
+    NP("speedoAF",       speedoAF,       PT_BOOL,  0,           1,           DEF_SPEEDO_ACCELFIG),
+    NP("speedoFact",     speedoFact,     PT_FLOAT, 0.5,         5.0,         DEF_SPEEDO_FACT),
+#ifdef TC_HAVEGPS
+    NP("useGPSSpeed",    useGPSSpeed,    PT_BOOL,  0,           1,           DEF_USE_GPS_SPEED),
+    NP("spdUpdRate",     spdUpdRate,     PT_U8,    0,           3,           DEF_SPD_UPD_RATE),
+#endif
+#ifdef TC_HAVETEMP
+    NP("dispTemp",       dispTemp,       PT_BOOL,  0,           1,           DEF_DISP_TEMP),
+    NP("tempBright",     tempBright,     PT_U8,    0,           15,          DEF_TEMP_BRIGHT),
+    NP("tempOffNM",      tempOffNM,      PT_BOOL,  0,           1,           DEF_TEMP_OFF_NM),
+#endif
+#endif // HAVESPEEDO
+#ifdef FAKE_POWER_ON
+    NP("fakePwrOn",      fakePwrOn,      PT_BOOL,  0,           1,           DEF_FAKE_PWR),
+#endif
+#ifdef EXTERNAL_TIMETRAVEL_IN
+    NP("ettDelay",       ettDelay,       PT_U16,   0,           ETT_MAX_DEL, DEF_ETT_DELAY),
+    NP(NULL,             ettLong,        PT_BOOL,  0,           1,           DEF_ETT_LONG),
+#endif
+#ifdef EXTERNAL_TIMETRAVEL_OUT
+    NP("useETTO",        useETTO,        PT_BOOL,  0,           1,           DEF_USE_ETTO),
+    NP("noETTOLead",     noETTOLead,     PT_BOOL,  0,           1,           DEF_NO_ETTO_LEAD),
+#endif
+#ifdef TC_HAVEGPS
+    NP("quickGPS",       quickGPS,       PT_BOOL,  0,           1,           DEF_QUICK_GPS),
+#endif
+    NP("playTTsnds",     playTTsnds,     PT_BOOL,  0,           1,           DEF_PLAY_TT_SND),
+#ifdef TC_HAVEMQTT
+    NP("useMQTT",        useMQTT,        PT_BOOL,  0,           1,           0),
+#ifdef EXTERNAL_TIMETRAVEL_OUT
+    NP("pubMQTT",        pubMQTT,        PT_BOOL,  0,           1,           0),
+#endif
+#endif
+    NP("shuffle",        shuffle,        PT_BOOL,  0,           1,           DEF_SHUFFLE),
+    NP("CfgOnSD",        CfgOnSD,        PT_BOOL,  0,           1,           DEF_CFG_ON_SD),
+    NP(NULL,             sdFreq,         PT_U8,    0,           1,           DEF_SD_FREQ),
+#undef NP
+};
+#define NUM_NUMPARMS (int)(sizeof(numParms) / sizeof(numParms[0]))
+
+// Convert string form to typed copy; strings are valid at this point
+static void updateTypedSettings()
+{
+    for(int i = 0; i < NUM_NUMPARMS; i++) {
+        switch(numParms[i].type) {
+        case PT_BOOL:
+            *(bool *)numParms[i].val = (atoi(numParms[i].text) > 0);
+            break;
+        case PT_U8:
+            *(uint8_t *)numParms[i].val = (uint8_t)atoi(numParms[i].text);
+            break;
+        case PT_U16:
+            *(uint16_t *)numParms[i].val = (uint16_t)atoi(numParms[i].text);
+            break;
+        case PT_FLOAT:
+            *(float *)numParms[i].val = strtof(numParms[i].text, NULL);
+            break;
+        }
+    }
+}
+
+// Check (and correct) string form, then update typed copy. 
+// Returns true if anything was corrected.
+static bool checkNumParms()
+{
+    bool wd = false;
+
+    for(int i = 0; i < NUM_NUMPARMS; i++) {
+        if(numParms[i].type == PT_FLOAT) {
+            wd |= checkValidNumParmF(numParms[i].text, numParms[i].lowerLim, numParms[i].upperLim, numParms[i].setDefault);
+        } else {
+            wd |= checkValidNumParm(numParms[i].text, (int)numParms[i].lowerLim, (int)numParms[i].upperLim, (int)numParms[i].setDefault);
+        }
+    }
+
+    updateTypedSettings();
+
+    return wd;
+}
+
+void validateSettings()
+{
+    checkNumParms();
+}
+
 static bool read_settings(File configFile)
 {
     #ifdef TC_DBG
@@ -475,12 +861,17 @@ static bool read_settings(File configFile)
 
     if(!error) {
 
-        wd |= CopyCheckValidNumParm(json["timeTrPers"], settings.timesPers, sizeof(settings.timesPers), 0, 1, DEF_TIMES_PERS);
-        wd |= CopyCheckValidNumParm(json["alarmRTC"], settings.alarmRTC, sizeof(settings.alarmRTC), 0, 1, DEF_ALARM_RTC);
-        wd |= CopyCheckValidNumParm(json["playIntro"], settings.playIntro, sizeof(settings.playIntro), 0, 1, DEF_PLAY_INTRO);
-        wd |= CopyCheckValidNumParm(json["mode24"], settings.mode24, sizeof(settings.mode24), 0, 1, DEF_MODE24);
-        wd |= CopyCheckValidNumParm(json["beep"], settings.beep, sizeof(settings.beep), 0, 3, DEF_BEEP);
-        
+        for(int i = 0; i < NUM_NUMPARMS; i++) {
+            if(!numParms[i].key) continue;
+            if(numParms[i].type == PT_FLOAT) {
+                wd |= CopyCheckValidNumParmF(json[numParms[i].key], numParms[i].text, numParms[i].size, 
+                                             numParms[i].lowerLim, numParms[i].upperLim, numParms[i].setDefault);
+            } else {
+                wd |= CopyCheckValidNumParm(json[numParms[i].key], numParms[i].text, numParms[i].size,
+                                            (int)numParms[i].lowerLim, (int)numParms[i].upperLim, (int)numParms[i].setDefault);
+            }
+        }
+
         if(json["hostName"]) {
             CopyTextParm(settings.hostName, json["hostName"], sizeof(settings.hostName));
         } else wd = true;
@@ -493,12 +884,6 @@ static bool read_settings(File configFile)
             CopyTextParm(settings.appw, json["appw"], sizeof(settings.appw));
         } else wd = true;
         
-        wd |= CopyCheckValidNumParm(json["wifiConRetries"], settings.wifiConRetries, sizeof(settings.wifiConRetries), 1, 10, DEF_WIFI_RETRY);
-        wd |= CopyCheckValidNumParm(json["wifiConTimeout"], settings.wifiConTimeout, sizeof(settings.wifiConTimeout), 7, 25, DEF_WIFI_TIMEOUT);
-        wd |= CopyCheckValidNumParm(json["wifiOffDelay"], settings.wifiOffDelay, sizeof(settings.wifiOffDelay), 0, 99, DEF_WIFI_OFFDELAY);
-        wd |= CopyCheckValidNumParm(json["wifiAPOffDelay"], settings.wifiAPOffDelay, sizeof(settings.wifiAPOffDelay), 0, 99, DEF_WIFI_APOFFDELAY);
-        wd |= CopyCheckValidNumParm(json["wifiPRetry"], settings.wifiPRetry, sizeof(settings.wifiPRetry), 0, 1, DEF_WIFI_PRETRY);
-        
         if(json["timeZone"]) {
             CopyTextParm(settings.timeZone, json["timeZone"], sizeof(settings.timeZone));
         } else wd = true;
@@ -519,60 +904,7 @@ static bool read_settings(File configFile)
             CopyTextParm(settings.timeZoneNDep, json["timeZoneNDep"], sizeof(settings.timeZoneNDep));
         } else wd = true;
 
-        wd |= CopyCheckValidNumParm(json["dtNmOff"], settings.dtNmOff, sizeof(settings.dtNmOff), 0, 1, DEF_DT_OFF);
-        wd |= CopyCheckValidNumParm(json["ptNmOff"], settings.ptNmOff, sizeof(settings.ptNmOff), 0, 1, DEF_PT_OFF);
-        wd |= CopyCheckValidNumParm(json["ltNmOff"], settings.ltNmOff, sizeof(settings.ltNmOff), 0, 1, DEF_LT_OFF);
-
-        wd |= CopyCheckValidNumParm(json["autoNMPreset"], settings.autoNMPreset, sizeof(settings.autoNMPreset), 0, 10, DEF_AUTONM_PRESET);
-        
-        wd |= CopyCheckValidNumParm(json["autoNMOn"], settings.autoNMOn, sizeof(settings.autoNMOn), 0, 23, DEF_AUTONM_ON);
-        wd |= CopyCheckValidNumParm(json["autoNMOff"], settings.autoNMOff, sizeof(settings.autoNMOff), 0, 23, DEF_AUTONM_OFF);
-        #ifdef TC_HAVELIGHT
-        wd |= CopyCheckValidNumParm(json["useLight"], settings.useLight, sizeof(settings.useLight), 0, 1, DEF_USE_LIGHT);
-        wd |= CopyCheckValidNumParm(json["luxLimit"], settings.luxLimit, sizeof(settings.luxLimit), 0, 50000, DEF_LUX_LIMIT);
-        #endif
-
-        #ifdef TC_HAVETEMP
-        wd |= CopyCheckValidNumParm(json["tempUnit"], settings.tempUnit, sizeof(settings.tempUnit), 0, 1, DEF_TEMP_UNIT);
-        wd |= CopyCheckValidNumParmF(json["tempOffs"], settings.tempOffs, sizeof(settings.tempOffs), -3.0, 3.0, DEF_TEMP_OFFS);
-        #endif
-
-        #ifdef TC_HAVESPEEDO
-        wd |= CopyCheckValidNumParm(json["speedoType"], settings.speedoType, sizeof(settings.speedoType), SP_MIN_TYPE, 99, DEF_SPEEDO_TYPE);
-        wd |= CopyCheckValidNumParm(json["speedoBright"], settings.speedoBright, sizeof(settings.speedoBright), 0, 15, DEF_BRIGHT_SPEEDO);
-        wd |= CopyCheckValidNumParm(json["speedoAF"], settings.speedoAF, sizeof(settings.speedoAF), 0, 1, DEF_SPEEDO_ACCELFIG);
-        wd |= CopyCheckValidNumParmF(json["speedoFact"], settings.speedoFact, sizeof(settings.speedoFact), 0.5, 5.0, DEF_SPEEDO_FACT);
-        #ifdef TC_HAVEGPS
-        wd |= CopyCheckValidNumParm(json["useGPSSpeed"], settings.useGPSSpeed, sizeof(settings.useGPSSpeed), 0, 1, DEF_USE_GPS_SPEED);
-        wd |= CopyCheckValidNumParm(json["spdUpdRate"], settings.spdUpdRate, sizeof(settings.spdUpdRate), 0, 3, DEF_SPD_UPD_RATE);
-        #endif
-        #ifdef TC_HAVETEMP
-        wd |= CopyCheckValidNumParm(json["dispTemp"], settings.dispTemp, sizeof(settings.dispTemp), 0, 1, DEF_DISP_TEMP);
-        wd |= CopyCheckValidNumParm(json["tempBright"], settings.tempBright, sizeof(settings.tempBright), 0, 15, DEF_TEMP_BRIGHT);
-        wd |= CopyCheckValidNumParm(json["tempOffNM"], settings.tempOffNM, sizeof(settings.tempOffNM), 0, 1, DEF_TEMP_OFF_NM);
-        #endif
-        #endif // HAVESPEEDO
-        
-        #ifdef FAKE_POWER_ON
-        wd |= CopyCheckValidNumParm(json["fakePwrOn"], settings.fakePwrOn, sizeof(settings.fakePwrOn), 0, 1, DEF_FAKE_PWR);
-        #endif
-
-        #ifdef EXTERNAL_TIMETRAVEL_IN
-        wd |= CopyCheckValidNumParm(json["ettDelay"], settings.ettDelay, sizeof(settings.ettDelay), 0, ETT_MAX_DEL, DEF_ETT_DELAY);
-        //wd |= CopyCheckValidNumParm(json["ettLong"], settings.ettLong, sizeof(settings.ettLong), 0, 1, DEF_ETT_LONG);
-        #endif
-        
-        #ifdef EXTERNAL_TIMETRAVEL_OUT
-        wd |= CopyCheckValidNumParm(json["useETTO"], settings.useETTO, sizeof(settings.useETTO), 0, 1, DEF_USE_ETTO);
-        wd |= CopyCheckValidNumParm(json["noETTOLead"], settings.noETTOLead, sizeof(settings.noETTOLead), 0, 1, DEF_NO_ETTO_LEAD);
-        #endif
-        #ifdef TC_HAVEGPS
-        wd |= CopyCheckValidNumParm(json["quickGPS"], settings.quickGPS, sizeof(settings.quickGPS), 0, 1, DEF_QUICK_GPS);
-        #endif
-        wd |= CopyCheckValidNumParm(json["playTTsnds"], settings.playTTsnds, sizeof(settings.playTTsnds), 0, 1, DEF_PLAY_TT_SND);
-
         #ifdef TC_HAVEMQTT
-        wd |= CopyCheckValidNumParm(json["useMQTT"], settings.useMQTT, sizeof(settings.useMQTT), 0, 1, 0);
         if(json["mqttServer"]) {
             CopyTextParm(settings.mqttServer, json["mqttServer"], sizeof(settings.mqttServer));
         } else wd = true;
@@ -582,15 +914,7 @@ static bool read_settings(File configFile)
         if(json["mqttTopic"]) {
             CopyTextParm(settings.mqttTopic, json["mqttTopic"], sizeof(settings.mqttTopic));
         } else wd = true;
-        #ifdef EXTERNAL_TIMETRAVEL_OUT
-        wd |= CopyCheckValidNumParm(json["pubMQTT"], settings.pubMQTT, sizeof(settings.pubMQTT), 0, 1, 0);
         #endif
-        #endif
-
-        wd |= CopyCheckValidNumParm(json["shuffle"], settings.shuffle, sizeof(settings.shuffle), 0, 1, DEF_SHUFFLE);
-
-        wd |= CopyCheckValidNumParm(json["CfgOnSD"], settings.CfgOnSD, sizeof(settings.CfgOnSD), 0, 1, DEF_CFG_ON_SD);
-        //wd |= CopyCheckValidNumParm(json["sdFreq"], settings.sdFreq, sizeof(settings.sdFreq), 0, 1, DEF_SD_FREQ);
 
     } else {
 
@@ -616,21 +940,14 @@ void write_settings()
     #ifdef TC_DBG
     Serial.printf("%s: Writing config file\n", funcName);
     #endif
-    
-    json["timeTrPers"] = (const char *)settings.timesPers;
-    json["alarmRTC"] = (const char *)settings.alarmRTC;
-    json["mode24"] = (const char *)settings.mode24;
-    json["beep"] = (const char *)settings.beep;
-    json["playIntro"] = (const char *)settings.playIntro;
+
+    for(int i = 0; i < NUM_NUMPARMS; i++) {
+        if(numParms[i].key) json[numParms[i].key] = (const char *)numParms[i].text;
+    }
 
     json["hostName"] = (const char *)settings.hostName;
     json["systemID"] = (const char *)settings.systemID;
     json["appw"] = (const char *)settings.appw;
-    json["wifiConRetries"] = (const char *)settings.wifiConRetries;
-    json["wifiConTimeout"] = (const char *)settings.wifiConTimeout;
-    json["wifiOffDelay"] = (const char *)settings.wifiOffDelay;
-    json["wifiAPOffDelay"] = (const char *)settings.wifiAPOffDelay;
-    json["wifiPRetry"] = (const char *)settings.wifiPRetry;
     
     json["timeZone"] = (const char *)settings.timeZone;
     json["ntpServer"] = (const char *)settings.ntpServer;
@@ -640,72 +957,12 @@ void write_settings()
     json["timeZoneNDest"] = (const char *)settings.timeZoneNDest;
     json["timeZoneNDep"] = (const char *)settings.timeZoneNDep;
 
-    json["dtNmOff"] = (const char *)settings.dtNmOff;
-    json["ptNmOff"] = (const char *)settings.ptNmOff;
-    json["ltNmOff"] = (const char *)settings.ltNmOff;
-    
-    json["autoNMPreset"] = (const char *)settings.autoNMPreset;
-    json["autoNMOn"] = (const char *)settings.autoNMOn;
-    json["autoNMOff"] = (const char *)settings.autoNMOff;
-    #ifdef TC_HAVELIGHT
-    json["useLight"] = (const char *)settings.useLight;
-    json["luxLimit"] = (const char *)settings.luxLimit;
-    #endif
-
-    #ifdef TC_HAVETEMP
-    json["tempUnit"] = (const char *)settings.tempUnit;
-    json["tempOffs"] = (const char *)settings.tempOffs;
-    #endif
-
-    #ifdef TC_HAVESPEEDO    
-    json["speedoType"] = (const char *)settings.speedoType;
-    json["speedoBright"] = (const char *)settings.speedoBright;
-    json["speedoAF"] = (const char *)settings.speedoAF;
-    json["speedoFact"] = (const char *)settings.speedoFact;
-    #ifdef TC_HAVEGPS
-    json["useGPSSpeed"] = (const char *)settings.useGPSSpeed;
-    json["spdUpdRate"] = (const char *)settings.spdUpdRate;
-    #endif
-    #ifdef TC_HAVETEMP
-    json["dispTemp"] = (const char *)settings.dispTemp;
-    json["tempBright"] = (const char *)settings.tempBright;
-    json["tempOffNM"] = (const char *)settings.tempOffNM;
-    #endif
-    #endif // HAVESPEEDO
-    
-    #ifdef FAKE_POWER_ON
-    json["fakePwrOn"] = (const char *)settings.fakePwrOn;
-    #endif
-
-    #ifdef EXTERNAL_TIMETRAVEL_IN
-    json["ettDelay"] = (const char *)settings.ettDelay;
-    //json["ettLong"] = (const char *)settings.ettLong;
-    #endif
-
-    #ifdef EXTERNAL_TIMETRAVEL_OUT
-    json["useETTO"] = (const char *)settings.useETTO;
-    json["noETTOLead"] = (const char *)settings.noETTOLead;
-    #endif
-    #ifdef TC_HAVEGPS
-    json["quickGPS"] = (const char *)settings.quickGPS;
-    #endif
-    json["playTTsnds"] = (const char *)settings.playTTsnds;
-
     #ifdef TC_HAVEMQTT
-    json["useMQTT"] = (const char *)settings.useMQTT;
     json["mqttServer"] = (const char *)settings.mqttServer;
     json["mqttUser"] = (const char *)settings.mqttUser;
     json["mqttTopic"] = (const char *)settings.mqttTopic;
-    #ifdef EXTERNAL_TIMETRAVEL_OUT
-    json["pubMQTT"] = (const char *)settings.pubMQTT;
-    #endif
     #endif
 
-    json["shuffle"] = (const char *)settings.shuffle;
-
-    json["CfgOnSD"] = (const char *)settings.CfgOnSD;
-    //json["sdFreq"] = (const char *)settings.sdFreq;
-
     writeJSONCfgFile(json, cfgName, FlashROMode);
 }
 
@@ -827,205 +1084,606 @@ static bool openCfgFileRead(const char *fn, File& f)
 }
 
 /*
- *  Load/save Brightness settings
+ * Secondary settings store
+ *
+ * The small secondary settings (brightness, time cycling interval,
+ * volume, alarm, reminder, car mode, line-out, remote-allowed and
+ * exhibition mode time) are kept in one binary file, on flash FS or
+ * SD as per configOnSD. The music folder number lives in another
+ * one on the SD card.
+ *
+ * A file consists of a header (magic, format version), followed by
+ * records: id, data length, data, CRC32 (over id, length and data).
+ * A changed setting is appended as a new record; when reading, the
+ * last valid record of each id wins, a damaged tail (eg from a power
+ * loss during a write) is ignored. Once the file grows beyond
+ * SEC_COMPACT_SIZE, it is re-written holding only current records.
+ * A record of length 0 deletes a setting.
+ *
+ * Files are read in one go at boot, from then on records are served
+ * from memory. Unchanged records are never written.
+ *
+ * Setters only update the record in memory and mark it dirty. All
+ * dirty records are written together by flushSecSettings() once no
+ * setting changed for SEC_QUIET_TIME (eg the volume knob came to
+ * rest), and immediately before reboot, OTA or fake power-off.
+ *
+ * Older firmware versions stored each setting in a JSON file; these
+ * are read once for conversion and left in place. For backups, the settings
+ * can be exported in that JSON format (exportSecSettings()).
  */
 
-static void updateBriCache()
+#define SEC_MAGIC        "TCSS"
+#define SEC_VERSION      1
+#define SEC_HDR_SIZE     8          // magic (4), version (1), reserved (3)
+#define SEC_REC_OVH      6          // id (1), length (1), CRC32 (4)
+#define SEC_REC_MAXLEN   16
+#define SEC_COMPACT_SIZE 2048
+#define SEC_FILE_MAX     4096       // anything larger is bad
+#define SEC_QUIET_TIME   10000      // ms without changes until written
+#define SEC_IMG_SIZE     (SEC_HDR_SIZE + (SEC_NUM_IDS * (SEC_REC_OVH + SEC_REC_MAXLEN)))
+
+#define SEC_BRI     0
+#define SEC_AI      1
+#define SEC_VOL     2
+#define SEC_ALM     3
+#define SEC_REM     4
+#define SEC_CM      5
+#define SEC_LO      6
+#define SEC_RA      7
+#define SEC_ST      8
+#define SEC_MUS     9
+#define SEC_NUM_IDS 10
+#define SEC_NONE    0xff            // recLen: No record
+
+typedef struct {
+    const char *fn;
+    const char *tmpFn;
+    bool       sdOnly;              // true: always on SD; false: as per configOnSD
+    bool       loaded;
+    uint16_t   fileSize;            // size of file on target medium; 0 = none or damaged
+    uint16_t   dirty;               // records not written yet (bit mask)
+    unsigned long lastChange;       // millis() of last change
+    uint8_t    recLen[SEC_NUM_IDS];
+    uint8_t    rec[SEC_NUM_IDS][SEC_REC_MAXLEN];
+} secStore;
+
+static secStore secCfg = { "/tcdsec.bin", "/tcdsec.new", false };
+static secStore secMus = { "/tcdsecsd.bin", "/tcdsecsd.new", true };
+
+// Only update records in memory (used when copying)
+static bool secNoWrite = false;
+
+// Legacy JSON files: id, name, keys (all values are numbers as strings)
+#define SEC_LEG_KEYS 4
+static const struct {
+    uint8_t    id;
+    const char *name;
+    const char *keys[SEC_LEG_KEYS];
+} secLegacy[] = {
+    { SEC_BRI, "tcdbricfg", { "dBri", "pBri", "lBri" } },
+    { SEC_AI,  "tcdaicfg",  { "ai" } },
+    { SEC_VOL, "tcdvolcfg", { "volume" } },
+    { SEC_ALM, "tcdalmcfg", { "alarmonoff", "alarmhour", "alarmmin" } },
+    { SEC_REM, "tcdremcfg", { "month", "day", "hour", "min" } },
+    { SEC_CM,  "cmconfig",  { "CarMode" } },
+    { SEC_LO,  "loconfig",  { "LineOut" } },
+    { SEC_RA,  "raconfig",  { "Remote", "RemoteKP" } },
+    { SEC_MUS, "tcdmcfg",   { "folder" } }      // SD only
+};
+#define SEC_NUM_LEGACY (int)(sizeof(secLegacy) / sizeof(secLegacy[0]))
+#ifdef HAVE_STALE_PRESENT
+static const char *stLegName = "/stconfig";    // Exhib Mode, binary
+#define ST_LEN (1 + (2 * sizeof(dateStruct)))
+#endif
+
+static bool secOnSD(secStore& s)
 {
-    preSavedDBri = atoi(settings.destTimeBright);
-    preSavedPBri = atoi(settings.presTimeBright);
-    preSavedLBri = atoi(settings.lastTimeBright); 
+    return (s.sdOnly || configOnSD);
 }
 
-static bool loadBrightness()
+static fs::FS& secFS(bool useSD)
 {
-    #ifdef TC_DBG
-    const char *funcName = "loadBrightness";
-    #endif
-    bool wd = true;
-    File configFile;
+    if(useSD) return SD;
+    return SPIFFS;
+}
 
-    if(!haveFS && !configOnSD)
+static bool secMediumOk(bool useSD)
+{
+    return useSD ? haveSD : (haveFS && !FlashROMode);
+}
+
+// Parse a store file; returns true if a valid file was found
+static bool secReadFile(secStore& s, const char *fn, bool useSD, bool isTarget)
+{
+    uint8_t *buf;
+    size_t size, pos = SEC_HDR_SIZE;
+    uint32_t crc;
+    File f;
+
+    if(useSD ? !haveSD : !haveFS)
         return false;
 
-    #ifdef TC_DBG
-    Serial.printf("%s: Loading from %s\n", funcName, configOnSD ? "SD" : "flash FS");
-    #endif
+    if(!secFS(useSD).exists(fn))
+        return false;
 
-    if(openCfgFileRead(briCfgName, configFile)) {
+    if(!(f = secFS(useSD).open(fn, FILE_READ)))
+        return false;
 
-        DECLARE_S_JSON(512,json);
+    size = f.size();
+    if(size < SEC_HDR_SIZE || size > SEC_FILE_MAX || !(buf = (uint8_t *)malloc(size))) {
+        f.close();
+        return false;
+    }
 
-        if(!readJSONCfgFile(json, configFile)) {
-            wd =  CopyCheckValidNumParm(json["dBri"], settings.destTimeBright, sizeof(settings.destTimeBright), 0, 15, DEF_BRIGHT_DEST);
-            wd |= CopyCheckValidNumParm(json["pBri"], settings.presTimeBright, sizeof(settings.presTimeBright), 0, 15, DEF_BRIGHT_PRES);
-            wd |= CopyCheckValidNumParm(json["lBri"], settings.lastTimeBright, sizeof(settings.lastTimeBright), 0, 15, DEF_BRIGHT_DEPA);
-        } 
-        configFile.close();
+    if(f.read(buf, size) != size || memcmp(buf, SEC_MAGIC, 4) || buf[4] != SEC_VERSION) {
+        free(buf);
+        f.close();
+        return false;
     }
+    f.close();
 
-    if(wd) {
-        #ifdef TC_DBG
-        Serial.printf("%s: %s\n", funcName, badConfig);
-        #endif
-        saveBrightness();
-    } else {
-        updateBriCache();
+    while(pos + SEC_REC_OVH <= size) {
+        uint8_t id = buf[pos], len = buf[pos + 1];
+        if(id >= SEC_NUM_IDS || len > SEC_REC_MAXLEN || pos + SEC_REC_OVH + len > size)
+            break;
+        memcpy(&crc, buf + pos + 2 + len, 4);
+        if(crc != esp_rom_crc32_le(0, buf + pos, 2 + len))
+            break;
+        memcpy(s.rec[id], buf + pos + 2, len);
+        s.recLen[id] = len ? len : SEC_NONE;
+        pos += SEC_REC_OVH + len;
+    }
+
+    free(buf);
+
+    // Never append after a damaged tail; write anew instead
+    if(isTarget) {
+        s.fileSize = (pos == size) ? size : 0;
     }
 
+    #ifdef TC_DBG
+    Serial.printf("secStore: Read %s from %s, %d bytes%s\n", fn, useSD ? "SD" : "FS", size, (pos == size) ? "" : " (damaged)");
+    #endif
+
     return true;
 }
 
-void saveBrightness(bool useCache)
+static bool secLoad(secStore& s)
 {
-    DECLARE_S_JSON(512,json);
+    bool useSD = secOnSD(s);
+    bool found;
 
-    if(useCache && 
-       (preSavedDBri == atoi(settings.destTimeBright)) &&
-       (preSavedPBri == atoi(settings.presTimeBright)) &&
-       (preSavedLBri == atoi(settings.presTimeBright))) {
-        return;
+    memset(s.recLen, SEC_NONE, sizeof(s.recLen));
+    s.fileSize = 0;
+    s.loaded = true;
+
+    // A left-over tmpFn means we were interrupted while compacting
+    found = secReadFile(s, s.fn, useSD, true) || secReadFile(s, s.tmpFn, useSD, false);
+
+    // Like with the JSON files: If there's nothing on the SD, try flash
+    if(!found && useSD && !s.sdOnly) {
+        found = secReadFile(s, s.fn, false, false);
     }
 
-    if(!haveFS && !configOnSD)
-        return;
+    return found;
+}
 
-    json["dBri"] = (const char *)settings.destTimeBright;
-    json["pBri"] = (const char *)settings.presTimeBright;
-    json["lBri"] = (const char *)settings.lastTimeBright;
+static int secBuildRec(uint8_t *buf, int id, const uint8_t *data, int len)
+{
+    uint32_t crc;
 
-    writeJSONCfgFile(json, briCfgName, configOnSD);
+    buf[0] = id;
+    buf[1] = len;
+    if(len) memcpy(buf + 2, data, len);
+    crc = esp_rom_crc32_le(0, buf, 2 + len);
+    memcpy(buf + 2 + len, &crc, 4);
 
-    updateBriCache();
+    return SEC_REC_OVH + len;
 }
 
-/*
- *  autoInterval
- *
- */
-static bool loadAutoInterval()
+// Write file with current records only
+static bool secWriteAll(secStore& s, bool useSD)
 {
-    #ifdef TC_DBG
-    const char *funcName = "loadAutoInterval";
-    #endif
-    bool wd = true;
-    File configFile;
+    uint8_t img[SEC_IMG_SIZE];
+    int len = SEC_HDR_SIZE;
+    bool ret = false;
 
-    if(!haveFS && !configOnSD)
+    if(!secMediumOk(useSD))
         return false;
 
-    #ifdef TC_DBG
-    Serial.printf("%s: Loading from %s\n", funcName, configOnSD ? "SD" : "flash FS");
-    #endif
+    memset(img, 0, SEC_HDR_SIZE);
+    memcpy(img, SEC_MAGIC, 4);
+    img[4] = SEC_VERSION;
 
-    if(openCfgFileRead(ainCfgName, configFile)) {
+    for(int i = 0; i < SEC_NUM_IDS; i++) {
+        if(s.recLen[i] != SEC_NONE) {
+            len += secBuildRec(img + len, i, s.rec[i], s.recLen[i]);
+        }
+    }
 
-        DECLARE_S_JSON(512,json);
+    fs::FS& fs = secFS(useSD);
 
-        if(!readJSONCfgFile(json, configFile)) {
-            wd = CopyCheckValidNumParm(json["ai"], settings.autoRotateTimes, sizeof(settings.autoRotateTimes), 0, 5, DEF_AUTOROTTIMES);
-        }
-        configFile.close();
+    File f = fs.open(s.tmpFn, FILE_WRITE);
+    if(f) {
+        ret = ((int)f.write(img, len) == len);
+        f.close();
+    }
+    if(ret) {
+        fs.remove(s.fn);
+        ret = fs.rename(s.tmpFn, s.fn);
     }
 
-    if(wd) {
-        #ifdef TC_DBG
-        Serial.printf("%s: %s\n", funcName, badConfig);
-        #endif
-        saveAutoInterval();
-    } else {
-        autoInterval = (uint8_t)atoi(settings.autoRotateTimes);
-        preSavedAI = autoInterval;
+    if(useSD == secOnSD(s)) {
+        s.fileSize = ret ? len : 0;
+        if(ret) s.dirty = 0;
     }
 
-    return true;
+    #ifdef TC_DBG
+    Serial.printf("secStore: Wrote %s to %s, %d bytes\n", s.fn, useSD ? "SD" : "FS", len);
+    #endif
+
+    if(!ret) {
+        Serial.printf("secStore: %s - %s\n", s.fn, failFileWrite);
+    }
+
+    return ret;
 }
 
-void saveAutoInterval(bool useCache)
+// Append all dirty records in one go; deleted ones with length 0
+static bool secAppend(secStore& s, bool useSD)
 {
-    DECLARE_S_JSON(512,json);
+    uint8_t buf[SEC_IMG_SIZE];
+    int len = 0;
+    bool ret = false;
+
+    for(int i = 0; i < SEC_NUM_IDS; i++) {
+        if(s.dirty & (1 << i)) {
+            len += secBuildRec(buf + len, i, s.rec[i], (s.recLen[i] == SEC_NONE) ? 0 : s.recLen[i]);
+        }
+    }
+
+    if(s.fileSize + len > SEC_COMPACT_SIZE)
+        return false;
+
+    File f = secFS(useSD).open(s.fn, FILE_APPEND);
+    if(f) {
+        ret = ((int)f.write(buf, len) == len);
+        f.close();
+    }
 
-    if(useCache && (preSavedAI == autoInterval))
+    if(ret) {
+        s.fileSize += len;
+        s.dirty = 0;
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("secStore: Appended %d bytes to %s\n", len, s.fn);
+    #endif
+
+    return ret;
+}
+
+static void secFlush(secStore& s)
+{
+    bool useSD = secOnSD(s);
+
+    if(!secMediumOk(useSD)) {
+        // Nowhere to write to; keep in memory only
+        s.dirty = 0;
         return;
+    }
 
-    if(!haveFS && !configOnSD)
+    if(s.fileSize && secAppend(s, useSD))
         return;
 
-    sprintf(settings.autoRotateTimes, "%d", autoInterval);
+    if(!secWriteAll(s, useSD)) {
+        // Retry after another quiet period
+        s.lastChange = millis();
+    }
+}
 
-    json["ai"] = (const char *)settings.autoRotateTimes;
-    
-    writeJSONCfgFile(json, ainCfgName, configOnSD);
+// Returns true if a record of exactly len bytes exists
+static bool secGet(secStore& s, int id, uint8_t *data, int len)
+{
+    if(!s.loaded) secLoad(s);
+
+    if(s.recLen[id] != len)
+        return false;
 
-    preSavedAI = autoInterval;
+    memcpy(data, s.rec[id], len);
+    return true;
 }
 
+// Store record; len 0 deletes it. The record is only marked
+// dirty here, flushSecSettings() writes it.
+static void secPut(secStore& s, int id, const uint8_t *data, int len)
+{
+    if(!s.loaded) secLoad(s);
+
+    if(len) {
+        if(s.recLen[id] == len && !memcmp(s.rec[id], data, len))
+            return;
+        memcpy(s.rec[id], data, len);
+        s.recLen[id] = len;
+    } else {
+        if(s.recLen[id] == SEC_NONE)
+            return;
+        s.recLen[id] = SEC_NONE;
+    }
+
+    if(secNoWrite)
+        return;
+
+    s.dirty |= (1 << id);
+    s.lastChange = millis();
+}
 
 /*
- *  Load/save the Volume
+ * Write changed secondary settings once nothing was changed
+ * for SEC_QUIET_TIME, or immediately if force is set.
+ * Returns true if a file was written.
  */
+bool flushSecSettings(bool force)
+{
+    secStore *stores[2] = { &secCfg, &secMus };
+    bool ret = false;
+
+    for(int i = 0; i < 2; i++) {
+        secStore& s = *stores[i];
+        if(s.dirty && (force || (millis() - s.lastChange >= SEC_QUIET_TIME))) {
+            secFlush(s);
+            ret = true;
+        }
+    }
 
-bool loadCurVolume()
+    return ret;
+}
+
+// Convert legacy JSON files into records (files are not removed)
+static void secImportLegacy(secStore& s)
 {
-    #ifdef TC_DBG
-    const char *funcName = "loadCurVolume";
-    #endif
-    char temp[6];
-    bool writedefault = true;
+    char fn[20];
+    bool found = false;
     File configFile;
 
-    curVolume = DEFAULT_VOLUME;
+    for(int i = 0; i < SEC_NUM_LEGACY; i++) {
+        uint8_t b[SEC_LEG_KEYS];
+        int n = 0;
+        bool haveFile;
 
-    if(!haveFS && !configOnSD)
-        return false;
+        if(s.sdOnly != (secLegacy[i].id == SEC_MUS))
+            continue;
 
-    #ifdef TC_DBG
-    Serial.printf("%s: Loading from %s\n", funcName, configOnSD ? "SD" : "flash FS");
-    #endif
+        sprintf(fn, "/%s.json", secLegacy[i].name);
+
+        if(s.sdOnly) {
+            haveFile = (haveSD && SD.exists(fn) && (configFile = SD.open(fn, FILE_READ)));
+        } else {
+            haveFile = openCfgFileRead(fn, configFile);
+        }
+        if(!haveFile)
+            continue;
 
-    if(openCfgFileRead(volCfgName, configFile)) {
         DECLARE_S_JSON(512,json);
-        if(!readJSONCfgFile(json, configFile)) {
-            if(!CopyCheckValidNumParm(json["volume"], temp, sizeof(temp), 0, 255, 255)) {
-                int ncv = atoi(temp);
-                if((ncv >= 0 && ncv <= 19) || ncv == 255) {
-                    curVolume = ncv;
-                    writedefault = false;
-                }
+
+        if(!readJSONCfgFile(json, configFile) && json[secLegacy[i].keys[0]]) {
+            for(n = 0; n < SEC_LEG_KEYS && secLegacy[i].keys[n]; n++) {
+                const char *v = json[secLegacy[i].keys[n]];
+                b[n] = v ? atoi(v) : 0;
             }
-        } 
+            memcpy(s.rec[secLegacy[i].id], b, n);
+            s.recLen[secLegacy[i].id] = n;
+            found = true;
+        }
         configFile.close();
     }
 
-    if(writedefault) {
+    #ifdef HAVE_STALE_PRESENT
+    if(!s.sdOnly) {
+        uint8_t loadBuf[ST_LEN + 1];
+        uint16_t sum = 0;
+        if((configOnSD && readFileFromSD(stLegName, loadBuf, sizeof(loadBuf))) ||
+           readFileFromFS(stLegName, loadBuf, sizeof(loadBuf))) {
+            for(int i = 0; i < ST_LEN; i++) {
+                sum += (loadBuf[i] ^ 0x55);
+            }
+            if((sum & 0xff) == loadBuf[ST_LEN]) {
+                memcpy(s.rec[SEC_ST], loadBuf, ST_LEN);
+                s.recLen[SEC_ST] = ST_LEN;
+                found = true;
+            }
+        }
+    }
+    #endif
+
+    if(!found)
+        return;
+
+    #ifdef TC_DBG
+    Serial.printf("secStore: Converting legacy settings files to %s\n", s.fn);
+    #endif
+
+    // The old files are kept, so that settings are not lost if
+    // the firmware is downgraded. They are only read if the new
+    // store is missing.
+    secWriteAll(s, secOnSD(s));
+}
+
+static void loadSecSettings()
+{
+    if(!secLoad(secCfg)) {
+        secImportLegacy(secCfg);
+    }
+    if(haveSD && !secLoad(secMus)) {
+        secImportLegacy(secMus);
+    }
+}
+
+/*
+ * Export secondary settings as JSON, in the format of the
+ * legacy files: { "<file name>": { "<key>": "<value>", ... }, ... }
+ * Exhibition mode time as hex string. Returns length.
+ */
+int exportSecSettings(char *buf, int bufSize)
+{
+    char vbuf[(SEC_REC_MAXLEN * 2) + 1];
+    DECLARE_S_JSON(1024,json);
+
+    json.to<JsonObject>();
+
+    for(int i = 0; i < SEC_NUM_LEGACY; i++) {
+        int id = secLegacy[i].id;
+        secStore& s = (id == SEC_MUS) ? secMus : secCfg;
+        if(!s.loaded || s.recLen[id] == SEC_NONE)
+            continue;
+        JsonObject o = json.createNestedObject(secLegacy[i].name);
+        for(int n = 0; n < SEC_LEG_KEYS && n < s.recLen[id] && secLegacy[i].keys[n]; n++) {
+            sprintf(vbuf, "%d", s.rec[id][n]);
+            o[secLegacy[i].keys[n]] = vbuf;
+        }
+    }
+
+    #ifdef HAVE_STALE_PRESENT
+    if(secCfg.recLen[SEC_ST] != SEC_NONE) {
+        for(int n = 0; n < secCfg.recLen[SEC_ST]; n++) {
+            sprintf(vbuf + (n * 2), "%02x", secCfg.rec[SEC_ST][n]);
+        }
+        json["stconfig"] = vbuf;
+    }
+    #endif
+
+    return serializeJson(json, buf, bufSize);
+}
+
+/*
+ *  Load/save Brightness settings
+ */
+
+static bool loadBrightness()
+{
+    #ifdef TC_DBG
+    const char *funcName = "loadBrightness";
+    #endif
+    bool wd = true;
+    uint8_t b[3];
+
+    if(!haveFS && !configOnSD)
+        return false;
+
+    if(secGet(secCfg, SEC_BRI, b, 3) && b[0] <= 15 && b[1] <= 15 && b[2] <= 15) {
+        sprintf(settings.destTimeBright, "%d", b[0]);
+        sprintf(settings.presTimeBright, "%d", b[1]);
+        sprintf(settings.lastTimeBright, "%d", b[2]);
+        wd = false;
+    }
+
+    if(wd) {
         #ifdef TC_DBG
         Serial.printf("%s: %s\n", funcName, badConfig);
         #endif
-        saveCurVolume(false);
-    } else {
-        prevSavedVol = curVolume;
+        saveBrightness();
     }
 
     return true;
 }
 
-void saveCurVolume(bool useCache)
+void saveBrightness()
 {
-    char buf[6];
-    DECLARE_S_JSON(512,json);
+    uint8_t b[3];
 
-    if(useCache && (prevSavedVol == curVolume))
+    if(!haveFS && !configOnSD)
         return;
 
+    b[0] = atoi(settings.destTimeBright);
+    b[1] = atoi(settings.presTimeBright);
+    b[2] = atoi(settings.lastTimeBright);
+
+    secPut(secCfg, SEC_BRI, b, 3);
+}
+
+/*
+ *  autoInterval
+ *
+ */
+static bool loadAutoInterval()
+{
+    #ifdef TC_DBG
+    const char *funcName = "loadAutoInterval";
+    #endif
+    uint8_t b;
+
+    if(!haveFS && !configOnSD)
+        return false;
+
+    if(secGet(secCfg, SEC_AI, &b, 1) && b <= 5) {
+        sprintf(settings.autoRotateTimes, "%d", b);
+        autoInterval = b;
+    } else {
+        #ifdef TC_DBG
+        Serial.printf("%s: %s\n", funcName, badConfig);
+        #endif
+        autoInterval = (uint8_t)atoi(settings.autoRotateTimes);
+        if(autoInterval > 5) {
+            autoInterval = DEF_AUTOROTTIMES;
+        }
+        saveAutoInterval();
+    }
+
+    return true;
+}
+
+void saveAutoInterval()
+{
+    uint8_t b;
+
     if(!haveFS && !configOnSD)
         return;
 
-    sprintf(buf, "%d", curVolume);
-    json["volume"] = (const char *)buf;
+    sprintf(settings.autoRotateTimes, "%d", autoInterval);
+
+    b = autoInterval;
+    secPut(secCfg, SEC_AI, &b, 1);
+}
+
+
+/*
+ *  Load/save the Volume
+ */
+
+bool loadCurVolume()
+{
+    #ifdef TC_DBG
+    const char *funcName = "loadCurVolume";
+    #endif
+    uint8_t b;
+
+    curVolume = DEFAULT_VOLUME;
+
+    if(!haveFS && !configOnSD)
+        return false;
 
-    if(writeJSONCfgFile(json, volCfgName, configOnSD)) {
-        prevSavedVol = curVolume;
+    if(secGet(secCfg, SEC_VOL, &b, 1) && (b <= 19 || b == 255)) {
+        curVolume = b;
+    } else {
+        #ifdef TC_DBG
+        Serial.printf("%s: %s\n", funcName, badConfig);
+        #endif
+        saveCurVolume();
     }
+
+    return true;
+}
+
+void saveCurVolume()
+{
+    uint8_t b;
+
+    if(!haveFS && !configOnSD)
+        return;
+
+    b = curVolume;
+    secPut(secCfg, SEC_VOL, &b, 1);
 }
 
 /*
@@ -1038,35 +1696,21 @@ bool loadAlarm()
     const char *funcName = "lAl";
     #endif
     bool writedefault = true;
-    bool haveConfigFile = false;
-    File configFile;
+    uint8_t b[3];
 
     if(!haveFS && !configOnSD)
         return false;
 
-    #ifdef TC_DBG
-    Serial.printf("%s: Loading from %s\n", funcName, configOnSD ? "SD" : "flash FS");
-    #endif
-
-    if(openCfgFileRead(almCfgName, configFile)) {
-
-        DECLARE_S_JSON(512,json);
-        
-        if(!readJSONCfgFile(json, configFile)) {
-            if(json["alarmonoff"] && json["alarmhour"] && json["alarmmin"]) {
-                int aoo = atoi(json["alarmonoff"]);
-                alarmHour = atoi(json["alarmhour"]);
-                alarmMinute = atoi(json["alarmmin"]);
-                alarmOnOff = ((aoo & 0x0f) != 0);
-                alarmWeekday = (aoo & 0xf0) >> 4;
-                if(alarmWeekday > 9) alarmWeekday = 0;
-                if(((alarmHour   == 255) || (alarmHour   >= 0 && alarmHour   <= 23)) &&
-                   ((alarmMinute == 255) || (alarmMinute >= 0 && alarmMinute <= 59))) {
-                    writedefault = false;
-                }
-            }
-        } 
-        configFile.close();
+    if(secGet(secCfg, SEC_ALM, b, 3)) {
+        alarmHour = b[1];
+        alarmMinute = b[2];
+        alarmOnOff = ((b[0] & 0x0f) != 0);
+        alarmWeekday = (b[0] & 0xf0) >> 4;
+        if(alarmWeekday > 9) alarmWeekday = 0;
+        if(((alarmHour   == 255) || (alarmHour   <= 23)) &&
+           ((alarmMinute == 255) || (alarmMinute <= 59))) {
+            writedefault = false;
+        }
     }
 
     if(writedefault) {
@@ -1084,24 +1728,16 @@ bool loadAlarm()
 
 void saveAlarm()
 {
-    char aooBuf[8];
-    char hourBuf[8];
-    char minBuf[8];
-    DECLARE_S_JSON(512,json);
+    uint8_t b[3];
 
     if(!haveFS && !configOnSD)
         return;
 
-    sprintf(aooBuf, "%d", (alarmWeekday * 16) + (alarmOnOff ? 1 : 0));
-    json["alarmonoff"] = (const char *)aooBuf;
+    b[0] = (alarmWeekday * 16) + (alarmOnOff ? 1 : 0);
+    b[1] = alarmHour;
+    b[2] = alarmMinute;
 
-    sprintf(hourBuf, "%d", alarmHour);
-    sprintf(minBuf, "%d", alarmMinute);
-
-    json["alarmhour"] = (const char *)hourBuf;
-    json["alarmmin"] = (const char *)minBuf;
-
-    writeJSONCfgFile(json, almCfgName, configOnSD);
+    secPut(secCfg, SEC_ALM, b, 3);
 }
 
 /*
@@ -1113,43 +1749,26 @@ bool loadReminder()
     #ifdef TC_DBG
     const char *funcName = "lRem";
     #endif
-    bool writedefault = false;
-    File configFile;
+    uint8_t b[4];
 
     if(!haveFS && !configOnSD)
         return false;
 
-    #ifdef TC_DBG
-    Serial.printf("%s: Loading from %s\n", funcName, configOnSD ? "SD" : "flash FS");
-    #endif
-
-    if(openCfgFileRead(remCfgName, configFile)) {
-
-        DECLARE_S_JSON(512,json);
-        
-        if(!readJSONCfgFile(json, configFile)) {
-            if(json["month"] && json["hour"] && json["min"]) {
-                remMonth  = atoi(json["month"]);
-                remDay  = atoi(json["day"]);
-                remHour = atoi(json["hour"]);
-                remMin  = atoi(json["min"]);
-                if(remMonth > 12 ||               // month can be zero (=monthly reminder)
-                   remDay   > 31 || remDay < 1 ||
-                   remHour  > 23 || 
-                   remMin   > 59)
-                    writedefault = true;
-            }
-        } 
-        configFile.close();
-
-        if(writedefault) {
+    if(secGet(secCfg, SEC_REM, b, 4)) {
+        remMonth = b[0];
+        remDay   = b[1];
+        remHour  = b[2];
+        remMin   = b[3];
+        if(remMonth > 12 ||               // month can be zero (=monthly reminder)
+           remDay   > 31 || remDay < 1 ||
+           remHour  > 23 ||
+           remMin   > 59) {
             #ifdef TC_DBG
             Serial.printf("%s: %s\n", funcName, badConfig);
             #endif
             remMonth = remDay = remHour = remMin = 0;
             deleteReminder();
         }
-        
     }
 
     return true;
@@ -1157,11 +1776,7 @@ bool loadReminder()
 
 void saveReminder()
 {
-    char monBuf[8];
-    char dayBuf[8];
-    char hourBuf[8];
-    char minBuf[8];
-    DECLARE_S_JSON(512,json);
+    uint8_t b[4];
 
     if(!haveFS && !configOnSD)
         return;
@@ -1171,26 +1786,17 @@ void saveReminder()
         return;
     }
 
-    sprintf(monBuf, "%d", remMonth);
-    sprintf(dayBuf, "%d", remDay);
-    sprintf(hourBuf, "%d", remHour);
-    sprintf(minBuf, "%d", remMin);
-    
-    json["month"] = (const char *)monBuf;
-    json["day"] = (const char *)dayBuf;
-    json["hour"] = (const char *)hourBuf;
-    json["min"] = (const char *)minBuf;
+    b[0] = remMonth;
+    b[1] = remDay;
+    b[2] = remHour;
+    b[3] = remMin;
 
-    writeJSONCfgFile(json, remCfgName, configOnSD);
+    secPut(secCfg, SEC_REM, b, 4);
 }
 
 static void deleteReminder()
 {
-    if(configOnSD) {
-        SD.remove(remCfgName);
-    } else if(haveFS) {
-        SPIFFS.remove(remCfgName);
-    }
+    secPut(secCfg, SEC_REM, NULL, 0);
 }
 
 /*
@@ -1199,36 +1805,25 @@ static void deleteReminder()
 
 static void loadCarMode()
 {
-    bool haveConfigFile = false;
-    File configFile;
+    uint8_t b;
 
     if(!haveFS && !configOnSD)
         return;
 
-    if(openCfgFileRead(cmCfgName, configFile)) {
-        DECLARE_S_JSON(512,json);
-        if(!readJSONCfgFile(json, configFile)) {
-            if(json["CarMode"]) {
-                carMode = (atoi(json["CarMode"]) > 0);
-            }
-        } 
-        configFile.close();
+    if(secGet(secCfg, SEC_CM, &b, 1)) {
+        carMode = (b > 0);
     }
 }
 
 void saveCarMode()
 {
-    char buf[2];
-    DECLARE_S_JSON(512,json);
+    uint8_t b;
 
     if(!haveFS && !configOnSD)
         return;
 
-    buf[0] = carMode ? '1' : '0';
-    buf[1] = 0;
-    json["CarMode"] = (const char *)buf;
-
-    writeJSONCfgFile(json, cmCfgName, configOnSD);
+    b = carMode ? 1 : 0;
+    secPut(secCfg, SEC_CM, &b, 1);
 }
 
 /*
@@ -1238,51 +1833,26 @@ void saveCarMode()
 #ifdef HAVE_STALE_PRESENT
 void loadStaleTime(void *target, bool& currentOn)
 {
-    bool haveConfigFile = false;
-    uint8_t loadBuf[1+(2*sizeof(dateStruct))+1];
-    uint16_t sum = 0;
-    
+    uint8_t loadBuf[ST_LEN];
+
     if(!haveFS && !configOnSD)
         return;
 
-    if(configOnSD) {
-        haveConfigFile = readFileFromSD(stCfgName, loadBuf, sizeof(loadBuf));
-    }
-    if(!haveConfigFile && haveFS) {
-        haveConfigFile = readFileFromFS(stCfgName, loadBuf, sizeof(loadBuf));
-    }
-
-    if(!haveConfigFile) 
+    if(!secGet(secCfg, SEC_ST, loadBuf, ST_LEN))
         return;
 
-    for(uint8_t i = 0; i < 1+(2*sizeof(dateStruct)); i++) {
-        sum += (loadBuf[i] ^ 0x55);
-    }
-    if(((sum & 0xff) == loadBuf[1+(2*sizeof(dateStruct))])) {
-        currentOn = loadBuf[0] ? true : false;
-        memcpy(target, (void *)&loadBuf[1], 2*sizeof(dateStruct));
-    }
-
-    return;
+    currentOn = loadBuf[0] ? true : false;
+    memcpy(target, (void *)&loadBuf[1], 2*sizeof(dateStruct));
 }
 
 void saveStaleTime(void *source, bool currentOn)
 {
-    uint8_t savBuf[1+(2*sizeof(dateStruct))+1];
-    uint16_t sum = 0;
+    uint8_t savBuf[ST_LEN];
 
     savBuf[0] = currentOn;
     memcpy((void *)&savBuf[1], source, 2*sizeof(dateStruct));
-    for(uint8_t i = 0; i < 1+(2*sizeof(dateStruct)); i++) {
-        sum += (savBuf[i] ^ 0x55);
-    }
-    savBuf[1+(2*sizeof(dateStruct))] = sum & 0xff;
-    
-    if(configOnSD) {
-        writeFileToSD(stCfgName, savBuf, sizeof(savBuf));
-    } else if(haveFS) {
-        writeFileToFS(stCfgName, savBuf, sizeof(savBuf));
-    }
+
+    secPut(secCfg, SEC_ST, savBuf, ST_LEN);
 }
 #endif
 
@@ -1293,8 +1863,7 @@ void saveStaleTime(void *source, bool currentOn)
 #ifdef TC_HAVELINEOUT
 void loadLineOut()
 {
-    bool haveConfigFile = false;
-    File configFile;
+    uint8_t b;
 
     if(!haveFS && !configOnSD)
         return;
@@ -1302,21 +1871,14 @@ void loadLineOut()
     if(!haveLineOut)
         return;
 
-    if(openCfgFileRead(loCfgName, configFile)) {
-        DECLARE_S_JSON(512,json);
-        if(!readJSONCfgFile(json, configFile)) {
-            if(json["LineOut"]) {
-                useLineOut = (atoi(json["LineOut"]) > 0);
-            }
-        }
-        configFile.close();
+    if(secGet(secCfg, SEC_LO, &b, 1)) {
+        useLineOut = (b > 0);
     }
 }
 
 void saveLineOut()
 {
-    char buf[2];
-    DECLARE_S_JSON(512,json);
+    uint8_t b;
 
     if(!haveFS && !configOnSD)
         return;
@@ -1324,11 +1886,8 @@ void saveLineOut()
     if(!haveLineOut)
         return;
 
-    buf[0] = useLineOut ? '1' : '0';
-    buf[1] = 0;
-    json["LineOut"] = (const char *)buf;
-
-    writeJSONCfgFile(json, loCfgName, configOnSD);
+    b = useLineOut ? 1 : 0;
+    secPut(secCfg, SEC_LO, &b, 1);
 }
 #endif
 
@@ -1339,43 +1898,28 @@ void saveLineOut()
 #ifdef TC_HAVE_REMOTE
 static void loadRemoteAllowed()
 {
-    bool haveConfigFile = false;
-    File configFile;
+    uint8_t b[2];
 
     if(!haveFS && !configOnSD)
         return;
 
-    if(openCfgFileRead(raCfgName, configFile)) {
-        DECLARE_S_JSON(512,json);
-        if(!readJSONCfgFile(json, configFile)) {
-            if(json["Remote"]) {
-                remoteAllowed = (atoi(json["Remote"]) > 0);
-            }
-            if(json["RemoteKP"]) {
-                remoteKPAllowed = (atoi(json["RemoteKP"]) > 0);
-            }
-        } 
-        configFile.close();
+    if(secGet(secCfg, SEC_RA, b, 2)) {
+        remoteAllowed = (b[0] > 0);
+        remoteKPAllowed = (b[1] > 0);
     }
 }
 
 void saveRemoteAllowed()
 {
-    char buf[2];
-    char buf2[2];
-    DECLARE_S_JSON(512,json);
+    uint8_t b[2];
 
     if(!haveFS && !configOnSD)
         return;
 
-    buf[0] = remoteAllowed ? '1' : '0';
-    buf[1] = 0;
-    json["Remote"] = (const char *)buf;
-    buf2[0] = remoteKPAllowed ? '1' : '0';
-    buf2[1] = 0;
-    json["RemoteKP"] = (const char *)buf2;
+    b[0] = remoteAllowed ? 1 : 0;
+    b[1] = remoteKPAllowed ? 1 : 0;
 
-    writeJSONCfgFile(json, raCfgName, configOnSD);
+    secPut(secCfg, SEC_RA, b, 2);
 }
 #endif
 
@@ -1385,29 +1929,14 @@ void saveRemoteAllowed()
 
 bool loadMusFoldNum()
 {
-    bool writedefault = true;
-    char temp[4];
+    uint8_t b;
 
     if(!haveSD)
         return false;
 
-    if(SD.exists(musCfgName)) {
-
-        File configFile = SD.open(musCfgName, "r");
-        if(configFile) {
-            DECLARE_S_JSON(512,json);
-            if(!readJSONCfgFile(json, configFile)) {
-                if(!CopyCheckValidNumParm(json["folder"], temp, sizeof(temp), 0, 9, 0)) {
-                    musFolderNum = atoi(temp);
-                    writedefault = false;
-                }
-            }
-            configFile.close();
-        }
-
-    }
-
-    if(writedefault) {
+    if(secGet(secMus, SEC_MUS, &b, 1) && b <= 9) {
+        musFolderNum = b;
+    } else {
         musFolderNum = 0;
         saveMusFoldNum();
     }
@@ -1417,16 +1946,13 @@ bool loadMusFoldNum()
 
 void saveMusFoldNum()
 {
-    DECLARE_S_JSON(512,json);
-    char buf[4];
+    uint8_t b;
 
     if(!haveSD)
         return;
 
-    sprintf(buf, "%1d", musFolderNum);
-    json["folder"] = (const char *)buf;
-
-    writeJSONCfgFile(json, musCfgName, true);
+    b = musFolderNum;
+    secPut(secMus, SEC_MUS, &b, 1);
 }
 
 /*
@@ -1593,6 +2119,15 @@ bool check_if_default_audio_present()
     return ic;
 }
 
+/*
+ * The files are copied in CPA_BLOCK sized blocks; each file is 
+ * verified by re-reading it and comparing its CRC32. Completed
+ * files are logged in a manifest on the destination; if the copy
+ * is interrupted (eg by a power loss), files in the manifest are
+ * not copied again. Files already present with identical contents 
+ * (eg when installing an updated sound pack) are not re-written.
+ */
+
 // Returns false if copy failed because of a write error (which 
 //    might be cured by a reformat of the FlashFS)
 // Returns true if ok or source error (file missing, read error)
@@ -1601,12 +2136,15 @@ bool copy_audio_files(bool& delIDfile)
 {
     int i, haveErr = 0, haveWriteErr = 0;
     char dtmfBuf[] = "/Dtmf-0.mp3\0";
+    cpaState cs;
 
     if(!allowCPA) {
         delIDfile = false;
         return true;
     }
 
+    flushOpenAudioFiles();
+
     start_file_copy();
 
     for(i = 0; i < 10; i++) {
@@ -1621,12 +2159,20 @@ bool copy_audio_files(bool& delIDfile)
         }
     }
 
+    if(!(cs.buf = (uint8_t *)malloc(CPA_BLOCK))) {
+        cs.buf = cs.sbuf;
+        cs.bufSize = sizeof(cs.sbuf);
+    } else {
+        cs.bufSize = CPA_BLOCK;
+    }
+
     if(ic) {
         File sfile;
         if(sfile = SD.open(CONFN, FILE_READ)) {
+            cpaLoadManifest(cs, sfile.size());
             sfile.seek(14);
-            for(i = 0; i < NUM_AUDIOFILES+10+1; i++) {
-               cfc(sfile, haveErr, haveWriteErr);
+            for(i = 0; i < CPA_NUM_FILES; i++) {
+               cfc(cs, i, sfile, haveErr, haveWriteErr);
                if(haveErr) break;
             }
             sfile.close();
@@ -1637,6 +2183,18 @@ bool copy_audio_files(bool& delIDfile)
         haveErr++;
     }
 
+    if(cs.buf != cs.sbuf) free(cs.buf);
+
+    // Manifest only needed for resuming
+    if(!haveErr) {
+        if(FlashROMode) SD.remove(CPA_MANIFEST);
+        else            SPIFFS.remove(CPA_MANIFEST);
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("Audio install: %d copied, %d skipped, %d errors\n", cs.copied, cs.skipped, haveErr);
+    #endif
+
     file_copy_done(haveErr);
 
     delIDfile = (haveErr == 0);
@@ -1652,40 +2210,190 @@ static bool dfile_open(File &file, const char *fn, const char *md)
     return (file = SPIFFS.open(fn, md));
 }
 
-static void cfc(File& sfile, int& haveErr, int& haveWriteErr)
+// Manifest: Header (container id) plus one record (index, length,
+// CRC32) per completed file. Discarded if container changed.
+static void cpaLoadManifest(cpaState& cs, uint32_t conSize)
+{
+    uint8_t hdr[CPA_MF_HDR], rec[CPA_MF_REC];
+    File file;
+    bool valid = false;
+
+    memset(cs.done, 0, sizeof(cs.done));
+    cs.copied = cs.skipped = 0;
+
+    memcpy(hdr, "TCAM", 4);
+    memcpy(hdr + 4, SND_REQ_VERSION, 4);
+    memcpy(hdr + 8, &conSize, 4);
+
+    if(dfile_open(file, CPA_MANIFEST, FILE_READ)) {
+        uint8_t fhdr[CPA_MF_HDR];
+        if(file.read(fhdr, CPA_MF_HDR) == CPA_MF_HDR && !memcmp(fhdr, hdr, CPA_MF_HDR)) {
+            valid = true;
+            while(file.read(rec, CPA_MF_REC) == CPA_MF_REC) {
+                if(rec[0] < CPA_NUM_FILES) {
+                    cs.done[rec[0]] = true;
+                    cs.len[rec[0]] = getuint32(rec + 1);
+                    cs.crc[rec[0]] = getuint32(rec + 5);
+                }
+            }
+        }
+        file.close();
+    }
+
+    if(!valid) {
+        memset(cs.done, 0, sizeof(cs.done));
+        if(dfile_open(file, CPA_MANIFEST, FILE_WRITE)) {
+            file.write(hdr, CPA_MF_HDR);
+            file.close();
+        }
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("Audio install: Manifest %s\n", valid ? "found, resuming" : "created");
+    #endif
+}
+
+static void cpaLogFile(int idx, uint32_t len, uint32_t crc)
+{
+    uint8_t rec[CPA_MF_REC];
+    File file;
+
+    rec[0] = idx;
+    memcpy(rec + 1, &len, 4);
+    memcpy(rec + 5, &crc, 4);
+
+    if(dfile_open(file, CPA_MANIFEST, FILE_APPEND)) {
+        file.write(rec, CPA_MF_REC);
+        file.close();
+    }
+}
+
+// CRC32 of destination file; false if missing or size differs
+static bool cpaFileCRC(cpaState& cs, const char *fn, uint32_t len, uint32_t& crc)
+{
+    File file;
+    uint32_t total = 0;
+    size_t n;
+
+    crc = 0;
+
+    if(!FlashROMode && !SPIFFS.exists(fn))
+        return false;
+    if(!dfile_open(file, fn, FILE_READ))
+        return false;
+
+    if(file.size() == len) {
+        while((n = file.read(cs.buf, cs.bufSize)) > 0) {
+            crc = esp_rom_crc32_le(crc, cs.buf, n);
+            total += n;
+            file_copy_progress();
+        }
+    }
+    file.close();
+
+    return (total == len);
+}
+
+// Read and decode the next block of a file; the container is
+// encoded in CPA_CHUNK units counted from the start of each file.
+static bool cpaReadBlock(cpaState& cs, File& sfile, uint32_t t)
+{
+    if(sfile.read(cs.buf, t) != t)
+        return false;
+
+    for(uint32_t o = 0; o < t; o += CPA_CHUNK) {
+        (*r)(cs.buf + o, soa, (t - o < CPA_CHUNK) ? t - o : CPA_CHUNK);
+    }
+
+    return true;
+}
+
+static void cfc(cpaState& cs, int idx, File& sfile, int& haveErr, int& haveWriteErr)
 {
     #ifdef TC_DBG
     const char *funcName = "cfc";
     #endif
     uint8_t buf1[1+32+4];
-    uint8_t buf2[1024];
+    const char *fn;
     File dfile;
+    uint32_t s, t, len, dataPos, crc = 0, dcrc;
 
     buf1[0] = '/';
-    sfile.read(buf1 + 1, 32+4);   
-    if((dfile_open(dfile, (const char *)(*r)(buf1 + 1, soa, 32) - 1, FILE_WRITE))) {
-        uint32_t s = getuint32(buf1 + 1 + 32), t = 1024;
+    if(sfile.read(buf1 + 1, 32+4) != 32+4) {
+        haveErr++;
+        return;
+    }
+    fn = (const char *)(*r)(buf1 + 1, soa, 32) - 1;
+    len = getuint32(buf1 + 1 + 32);
+    dataPos = sfile.position();
+
+    // Completed before interruption, and still intact?
+    if(cs.done[idx] && cs.len[idx] == len &&
+       cpaFileCRC(cs, fn, len, dcrc) && dcrc == cs.crc[idx]) {
         #ifdef TC_DBG
-        Serial.printf("%s: Opened destination file: %s, length %d\n", funcName, (const char *)buf1, s);
+        Serial.printf("%s: %s in manifest, skipped\n", funcName, fn);
         #endif
-        while(s > 0) {
-            t = (s < t) ? s : t;
-            if(sfile.read(buf2, t) != t) {
+        sfile.seek(dataPos + len);
+        cs.skipped++;
+        return;
+    }
+
+    // Already present with identical contents?
+    if(!cs.done[idx] && cpaFileCRC(cs, fn, len, dcrc)) {
+        for(s = len; s > 0; s -= t) {
+            t = (s < cs.bufSize) ? s : cs.bufSize;
+            if(!cpaReadBlock(cs, sfile, t)) {
+                haveErr++;
+                return;
+            }
+            crc = esp_rom_crc32_le(crc, cs.buf, t);
+        }
+        if(crc == dcrc) {
+            #ifdef TC_DBG
+            Serial.printf("%s: %s unchanged, skipped\n", funcName, fn);
+            #endif
+            cpaLogFile(idx, len, crc);
+            cs.skipped++;
+            return;
+        }
+        sfile.seek(dataPos);
+        crc = 0;
+    }
+
+    if((dfile_open(dfile, fn, FILE_WRITE))) {
+        #ifdef TC_DBG
+        Serial.printf("%s: Opened destination file: %s, length %d\n", funcName, fn, len);
+        #endif
+        for(s = len; s > 0; s -= t) {
+            t = (s < cs.bufSize) ? s : cs.bufSize;
+            if(!cpaReadBlock(cs, sfile, t)) {
                 haveErr++;
                 break;
             }
-            if(dfile.write((*r)(buf2, soa, t), t) != t) {
+            crc = esp_rom_crc32_le(crc, cs.buf, t);
+            if(dfile.write(cs.buf, t) != t) {
                 haveErr++;
                 haveWriteErr++;
                 break;
             }
-            s -= t;
             file_copy_progress();
         }
+        dfile.close();
+        if(!haveErr) {
+            // Verify
+            if(!cpaFileCRC(cs, fn, len, dcrc) || dcrc != crc) {
+                Serial.printf("Verification failed: %s\n", fn);
+                haveErr++;
+                haveWriteErr++;
+            } else {
+                cpaLogFile(idx, len, crc);
+                cs.copied++;
+            }
+        }
     } else {
         haveErr++;
         haveWriteErr++;
-        Serial.printf("Error opening destination file: %s\n", buf1);
+        Serial.printf("Error opening destination file: %s\n", fn);
     }
 }
 
@@ -1731,6 +2439,7 @@ void formatFlashFS()
     #ifdef TC_DBG
     Serial.println(F("Formatting flash FS"));
     #endif
+    flushOpenAudioFiles();
     SPIFFS.format();
 }
 
@@ -1741,17 +2450,29 @@ void formatFlashFS()
 
 static void writeAllSecSettings()
 {
-    saveBrightness(false);
-    saveAutoInterval(false);
-    saveCurVolume(false);
+    // Update records with current values, then
+    // write them in one go
+    secNoWrite = true;
+    saveBrightness();
+    saveAutoInterval();
+    saveCurVolume();
     saveAlarm();
     saveReminder();
     saveCarMode();
+    #ifdef TC_HAVELINEOUT
+    saveLineOut();
+    #endif
+    #ifdef TC_HAVE_REMOTE
+    saveRemoteAllowed();
+    #endif
     #ifdef HAVE_STALE_PRESENT
     if(stalePresent) {
         saveStaleTime((void *)&stalePresentTime[0], stalePresent);
     }
     #endif
+    secNoWrite = false;
+    secWriteAll(secCfg, configOnSD);
+    
     saveDisplayData();
 }
 
@@ -1830,31 +2551,144 @@ static void saveDisplayData()
 /*
  * Helpers for JSON config files
  */
+// Custom reader for ArduinoJson: Parses straight from the file 
+// through a small buffer, no copy of the whole file in memory.
+class cfgFileReader {
+  public:
+    cfgFileReader(File& f) : _f(f) { }
+    int read() {
+        if(_pos == _len) {
+            _pos = 0;
+            if(!(_len = _f.read(_buf, sizeof(_buf)))) return -1;
+        }
+        return _buf[_pos++];
+    }
+    size_t readBytes(char *buffer, size_t length) {
+        size_t n = 0;
+        int c;
+        while(n < length && (c = read()) >= 0) {
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+  private:
+    File&   _f;
+    uint8_t _buf[128];
+    size_t  _pos = 0;
+    size_t  _len = 0;
+};
+
 static DeserializationError readJSONCfgFile(JsonDocument& json, File& configFile)
 {
-    const char *buf = NULL;
-    size_t bufSize = configFile.size();
+    cfgFileReader reader(configFile);
     DeserializationError ret;
 
-    if(!(buf = (const char *)malloc(bufSize + 1))) {
-        Serial.printf("rJSON: malloc failed (%d)\n", bufSize);
-        return DeserializationError::NoMemory;
+    ret = deserializeJson(json, reader);
+
+    #ifdef TC_DBG
+    if(ret) {
+        Serial.printf("rJSON: %s: %s\n", configFile.name(), ret.c_str());
+    }
+    #endif
+
+    return ret;
+}
+
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+/*
+ * JSON arena
+ * Bump allocator; each block has a 4-byte size header. Only the
+ * topmost block can be freed or resized in place; all space is 
+ * reclaimed when the last document is gone.
+ */
+
+void JsonArena::hold(bool doHold)
+{
+    _hold = doHold;
+    if(!doHold && !_live) release();
+}
+
+void JsonArena::release()
+{
+    free(_buf);
+    _buf = NULL;
+    _used = 0;
+}
+
+void *JsonArena::allocate(size_t size)
+{
+    size_t need = (size + 4 + 3) & ~3;
+    uint32_t *h;
+
+    if(!_buf) {
+        _buf = (uint8_t *)memBulkAlloc(JSON_ARENA_SIZE, MEM_BLK_JSON);
+        _used = 0;
     }
+    if(!_buf || _used + need > JSON_ARENA_SIZE) {
+        void *p = malloc(size);
+        if(p) _live++;
+        return p;
+    }
+
+    h = (uint32_t *)(_buf + _used);
+    *h = need;
+    _used += need;
+    if(_used > _peak) _peak = _used;
+    _live++;
 
-    memset((void *)buf, 0, bufSize + 1);
+    return (void *)(h + 1);
+}
 
-    configFile.read((uint8_t *)buf, bufSize);
+void JsonArena::deallocate(void *ptr)
+{
+    if(!ptr) return;
 
-    #ifdef TC_DBG
-    Serial.println(buf);
-    #endif
+    if(inArena(ptr)) {
+        uint32_t *h = (uint32_t *)ptr - 1;
+        if((uint8_t *)h + *h == _buf + _used) {
+            _used -= *h;
+        }
+    } else {
+        free(ptr);
+    }
     
-    ret = deserializeJson(json, buf);
+    if(!--_live) {
+        if(_hold) _used = 0;
+        else      release();
+    }
+}
 
-    free((void *)buf);
+void *JsonArena::reallocate(void *ptr, size_t newSize)
+{
+    uint32_t *h;
+    size_t need, oldSize;
+    void *p;
 
-    return ret;
+    if(!ptr) return allocate(newSize);
+
+    if(!inArena(ptr)) return realloc(ptr, newSize);
+
+    h = (uint32_t *)ptr - 1;
+    need = (newSize + 4 + 3) & ~3;
+    oldSize = *h - 4;
+
+    // Topmost block: Resize in place if possible
+    if((uint8_t *)h + *h == _buf + _used && (uint8_t *)h - _buf + need <= JSON_ARENA_SIZE) {
+        _used = (uint8_t *)h - _buf + need;
+        if(_used > _peak) _peak = _used;
+        *h = need;
+        return ptr;
+    }
+
+    if(need <= *h) return ptr;
+
+    if(!(p = allocate(newSize))) return NULL;
+    memcpy(p, ptr, oldSize);
+    deallocate(ptr);
+
+    return p;
 }
+#endif
 
 static bool writeJSONCfgFile(const JsonDocument& json, const char *fn, bool useSD)
 {
@@ -1862,7 +2696,7 @@ static bool writeJSONCfgFile(const JsonDocument& json, const char *fn, bool useS
     size_t bufSize = measureJson(json);
     bool success = false;
 
-    if(!(buf = (char *)malloc(bufSize + 1))) {
+    if(!(buf = (char *)memBulkAlloc(bufSize + 1, MEM_BLK_JSON))) {
         Serial.printf("wJSON: malloc failed (%d) (%s)\n", bufSize, fn);
         return false;
     }
@@ -1903,6 +2737,8 @@ bool readFileFromSD(const char *fn, uint8_t *buf, int len)
     File myFile = SD.open(fn, FILE_READ);
     if(myFile) {
         bytesr = myFile.read(buf, len);
+        // Short read of a file large enough is an error
+        if(bytesr != len && myFile.size() >= len) sdReadErrs++;
         myFile.close();
         return (bytesr == len);
     } else
@@ -1960,25 +2796,255 @@ bool writeFileToFS(const char *fn, uint8_t *buf, int len)
         return false;
 }
 
-bool openACFile(File& file)
+/*
+ * Streamed upload writer
+ *
+ * Uploaded data is collected in one of two SD-sector-aligned buffers.
+ * Full buffers are handed to a writer task, which writes them to the 
+ * SD card while the web server fills the other one. This way, the SD
+ * sees a few large writes instead of one small write per HTTP buffer.
+ * The CRC32 of the received data is verified by re-reading the file 
+ * after closing it.
+ * If buffers or the task can't be allocated, data is written directly.
+ */
+
+#define UPL_BUFSIZE     (16 * 1024)     // Multiple of 512 (SD sector size)
+#define UPL_TASK_STACK  3072
+#define UPL_TASK_PRIO   2
+
+typedef struct {
+    int    idx;     // buffer index; -1 = stop task
+    size_t len;
+} uplChunk;
+
+static File              uplFile;
+static bool              uplOpen = false;
+static char              uplName[40];
+static uint8_t           *uplBuf[2] = { NULL, NULL };
+static int               uplCur = 0;
+static size_t            uplFill = 0;
+static size_t            uplSize = 0;
+static uint32_t          uplCRC = 0;
+static volatile bool     uplWriteErr = false;
+static TaskHandle_t      uplTaskHandle = NULL;
+static QueueHandle_t     uplFullQ = NULL;
+static QueueHandle_t     uplFreeQ = NULL;
+static SemaphoreHandle_t uplDoneSem = NULL;
+
+static void uplWriterTask(void *parameter)
 {
-    if(haveSD) {
-        if(file = SD.open(CONFN, FILE_WRITE)) {
-            return true;
+    uplChunk c;
+
+    for(;;) {
+        xQueueReceive(uplFullQ, &c, portMAX_DELAY);
+        if(c.idx < 0) break;
+        if(!uplWriteErr && uplFile.write(uplBuf[c.idx], c.len) != c.len) {
+            uplWriteErr = true;
         }
+        xQueueSend(uplFreeQ, &c.idx, portMAX_DELAY);
     }
 
-    return false;
+    memNoteStack("uplwr");
+    xSemaphoreGive(uplDoneSem);
+    vTaskDelete(NULL);
+}
+
+static void uplFreeRes()
+{
+    for(int i = 0; i < 2; i++) {
+        if(uplBuf[i]) free(uplBuf[i]);
+        uplBuf[i] = NULL;
+    }
+    if(uplFullQ)   vQueueDelete(uplFullQ);
+    if(uplFreeQ)   vQueueDelete(uplFreeQ);
+    if(uplDoneSem) vSemaphoreDelete(uplDoneSem);
+    uplFullQ = uplFreeQ = NULL;
+    uplDoneSem = NULL;
+    uplTaskHandle = NULL;
 }
 
-size_t writeACFile(File& file, uint8_t *buf, size_t len)
+static bool uplFlush()
 {
-    return file.write(buf, len);
+    if(!uplFill)
+        return !uplWriteErr;
+
+    if(uplTaskHandle) {
+        uplChunk c = { uplCur, uplFill };
+        xQueueSend(uplFullQ, &c, portMAX_DELAY);
+        // Wait for a free buffer; blocks only if SD is slower than WiFi
+        xQueueReceive(uplFreeQ, &uplCur, portMAX_DELAY);
+    } else if(uplFile.write(uplBuf[uplCur], uplFill) != uplFill) {
+        uplWriteErr = true;
+    }
+
+    uplFill = 0;
+
+    return !uplWriteErr;
 }
 
-void closeACFile(File& file)
+static bool uplVerify()
 {
+    File file;
+    uint32_t crc = 0;
+    size_t total = 0, r;
+    uint8_t tbuf[512];
+    uint8_t *buf = uplBuf[0] ? uplBuf[0] : tbuf;
+    size_t blen = uplBuf[0] ? UPL_BUFSIZE : sizeof(tbuf);
+
+    if(!(file = SD.open(uplName, FILE_READ)))
+        return false;
+
+    if(file.size() == uplSize) {
+        while((r = file.read(buf, blen)) > 0) {
+            crc = esp_rom_crc32_le(crc, buf, r);
+            total += r;
+        }
+    }
     file.close();
+
+    #ifdef TC_DBG
+    Serial.printf("Upload verify %s: %d/%d bytes, crc %08x/%08x\n", uplName, total, uplSize, crc, uplCRC);
+    #endif
+
+    return (total == uplSize && crc == uplCRC);
+}
+
+// Open file for upload; fn = NULL means audio container
+bool openUploadFile(const char *fn)
+{
+    char *t;
+    int i;
+    
+    if(!haveSD || uplOpen)
+        return false;
+
+    // Might replace a sound file kept open
+    flushOpenAudioFiles();
+
+    strncpy(uplName, fn ? fn : CONFN, sizeof(uplName) - 1);
+    uplName[sizeof(uplName) - 1] = 0;
+
+    // Create folder if file is in one
+    if((t = strrchr(uplName, '/')) && t != uplName) {
+        *t = 0;
+        if(!SD.exists(uplName)) SD.mkdir(uplName);
+        *t = '/';
+    }
+
+    if(!(uplFile = SD.open(uplName, FILE_WRITE)))
+        return false;
+
+    uplOpen = true;
+    uplFill = uplSize = 0;
+    uplCRC = 0;
+    uplWriteErr = false;
+    uplCur = 0;
+
+    for(i = 0; i < 2; i++) {
+        uplBuf[i] = (uint8_t *)malloc(UPL_BUFSIZE);
+    }
+
+    if(uplBuf[0] && uplBuf[1]) {
+        uplFullQ = xQueueCreate(2, sizeof(uplChunk));
+        uplFreeQ = xQueueCreate(2, sizeof(int));
+        uplDoneSem = xSemaphoreCreateBinary();
+        if(uplFullQ && uplFreeQ && uplDoneSem) {
+            i = 1;
+            xQueueSend(uplFreeQ, &i, 0);
+            if(xTaskCreatePinnedToCore(uplWriterTask, "uplwr", UPL_TASK_STACK, NULL,
+                                       UPL_TASK_PRIO, &uplTaskHandle, 0) != pdPASS) {
+                uplTaskHandle = NULL;
+            }
+        }
+        #ifdef TC_DBG
+        Serial.printf("Upload writer task %s\n", uplTaskHandle ? "started" : "failed");
+        #endif
+    }
+
+    // No task: Free second buffer and queues, write synchronously
+    if(!uplTaskHandle) {
+        uint8_t *b = uplBuf[0];
+        uplBuf[0] = NULL;
+        uplFreeRes();
+        uplBuf[0] = b;
+    }
+
+    return true;
+}
+
+bool writeUploadFile(const uint8_t *buf, size_t len)
+{
+    size_t n;
+    
+    if(!uplOpen || uplWriteErr)
+        return false;
+
+    uplCRC = esp_rom_crc32_le(uplCRC, buf, len);
+    uplSize += len;
+
+    if(!uplBuf[uplCur]) {
+        if(uplFile.write(buf, len) != len) uplWriteErr = true;
+        return !uplWriteErr;
+    }
+
+    while(len) {
+        n = UPL_BUFSIZE - uplFill;
+        if(n > len) n = len;
+        memcpy(uplBuf[uplCur] + uplFill, buf, n);
+        uplFill += n;
+        buf += n;
+        len -= n;
+        if(uplFill == UPL_BUFSIZE) {
+            if(!uplFlush()) return false;
+        }
+    }
+
+    return true;
+}
+
+// Close upload file; returns false if writing or verification
+// failed. Removes the file if doRemove is true or on failure.
+bool closeUploadFile(bool doRemove)
+{
+    bool ret;
+    
+    if(!uplOpen)
+        return false;
+
+    if(!doRemove) {
+        uplFlush();
+    }
+
+    if(uplTaskHandle) {
+        uplChunk c = { -1, 0 };
+        xQueueSend(uplFullQ, &c, portMAX_DELAY);
+        xSemaphoreTake(uplDoneSem, portMAX_DELAY);
+        uplTaskHandle = NULL;
+    }
+
+    uplFile.close();
+    uplOpen = false;
+
+    // Restart the delay for reloading cached sounds
+    flushOpenAudioFiles();
+
+    ret = !uplWriteErr && !doRemove;
+    if(ret) {
+        ret = uplVerify();
+    }
+
+    if(!ret) {
+        SD.remove(uplName);
+    }
+
+    uplFreeRes();
+
+    return ret;
+}
+
+size_t uploadFileSize()
+{
+    return uplSize;
 }
 
 void removeACFile()
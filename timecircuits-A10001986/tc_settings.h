@@ -61,6 +61,9 @@ extern bool haveAudioFiles;
 
 extern uint8_t musFolderNum;
 
+extern uint8_t  sdClockMHz;
+extern uint16_t sdKBps;
+
 #define MS(s) XMS(s)
 #define XMS(s) #s
 
@@ -111,7 +114,7 @@ extern uint8_t musFolderNum;
 #define DEF_SHUFFLE         0     // Music Player: 0: Do not shuffle by default, 1: Do
 #define DEF_CFG_ON_SD       1     // Default: 1: Save secondary settings on SD, 0: Do not (use internal Flash)
 #define DEF_TIMES_PERS      0     // Default: 0: Timetravels not persistent; 1: TT persistent
-#define DEF_SD_FREQ         0     // SD/SPI frequency: Default 16MHz
+#define DEF_SD_FREQ         0     // SD/SPI frequency: 0: Auto-tuned (default), 1: 4MHz
 
 struct Settings {
     char playIntro[4]       = MS(DEF_PLAY_INTRO);
@@ -194,6 +197,79 @@ struct Settings {
 #endif    
 };
 
+/*
+ * Typed copy of the numeric settings, checked and converted once by
+ * validateSettings() after reading the config file and after a
+ * Config Portal save. Runtime code reads these; the string form in
+ * Settings is only used for JSON and the Config Portal.
+ * (Brightness and time cycling interval are secondary settings and 
+ * kept elsewhere.)
+ */
+struct TypedSettings {
+    bool     playIntro;
+    bool     mode24;
+    uint8_t  beep;
+    bool     alarmRTC;
+    uint8_t  wifiConRetries;
+    uint8_t  wifiConTimeout;
+    uint8_t  wifiOffDelay;
+    uint8_t  wifiAPOffDelay;
+    bool     wifiPRetry;
+    uint8_t  autoNMPreset;
+    uint8_t  autoNMOn;
+    uint8_t  autoNMOff;
+    bool     dtNmOff;
+    bool     ptNmOff;
+    bool     ltNmOff;
+#ifdef FAKE_POWER_ON
+    bool     fakePwrOn;
+#endif
+#ifdef EXTERNAL_TIMETRAVEL_IN
+    uint16_t ettDelay;
+    bool     ettLong;
+#endif
+#ifdef TC_HAVETEMP
+    bool     tempUnit;
+    float    tempOffs;
+#endif
+#ifdef TC_HAVELIGHT
+    bool     useLight;
+    uint16_t luxLimit;
+#endif
+#ifdef TC_HAVESPEEDO
+    uint8_t  speedoType;
+    uint8_t  speedoBright;
+    bool     speedoAF;
+    float    speedoFact;
+#ifdef TC_HAVEGPS
+    bool     useGPSSpeed;
+    uint8_t  spdUpdRate;
+#endif
+#ifdef TC_HAVETEMP
+    bool     dispTemp;
+    uint8_t  tempBright;
+    bool     tempOffNM;
+#endif
+#endif // HAVESPEEDO 
+#ifdef EXTERNAL_TIMETRAVEL_OUT
+    bool     useETTO;
+    bool     noETTOLead;
+#endif
+#ifdef TC_HAVEGPS
+    bool     quickGPS;
+#endif
+    bool     playTTsnds;
+
+    bool     shuffle;
+    bool     CfgOnSD;
+    bool     timesPers;
+    uint8_t  sdFreq;
+#ifdef TC_HAVEMQTT  
+    bool     useMQTT;
+    bool     pubMQTT;
+#endif
+};
+
 // Maximum delay for incoming tt trigger
 #define ETT_MAX_DEL 60000
 
@@ -205,6 +281,7 @@ struct IPSettings {
 };
 
 extern struct Settings settings;
+extern struct TypedSettings cfg;
 extern struct IPSettings ipsettings;
 
 void settings_setup();
@@ -212,11 +289,14 @@ void settings_setup();
 void unmount_fs();
 
 void write_settings();
+void validateSettings();
 bool checkConfigExists();
 
-void saveBrightness(bool useCache = true);
+bool flushSecSettings(bool force = false);
+
+void saveBrightness();
 
-void saveAutoInterval(bool useCache = true);
+void saveAutoInterval();
 
 bool loadAlarm();
 void saveAlarm();
@@ -227,7 +307,7 @@ void saveReminder();
 void saveCarMode();
 
 bool loadCurVolume();
-void saveCurVolume(bool useCache = true);
+void saveCurVolume();
 
 bool loadMusFoldNum();
 void saveMusFoldNum();
@@ -251,6 +331,7 @@ void writeIpSettings();
 void deleteIpSettings();
 
 void copySettings();
+int  exportSecSettings(char *buf, int bufSize);
 
 bool check_if_default_audio_present();
 void doCopyAudioFiles();
@@ -270,10 +351,12 @@ bool writeFileToSD(const char *fn, uint8_t *buf, int len);
 bool readFileFromFS(const char *fn, uint8_t *buf, int len);
 bool writeFileToFS(const char *fn, uint8_t *buf, int len);
 
-#include <FS.h>
-bool   openACFile(File& file);
-size_t writeACFile(File& file, uint8_t *buf, size_t len);
-void   closeACFile(File& file);
+void sdHealthCheck();
+
+bool   openUploadFile(const char *fn);
+bool   writeUploadFile(const uint8_t *buf, size_t len);
+bool   closeUploadFile(bool doRemove);
+size_t uploadFileSize();
 void   removeACFile();
 
 #endif
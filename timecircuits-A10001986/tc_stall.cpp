@@ -0,0 +1,309 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Main loop stall monitor
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#ifdef TC_STALLMON
+
+#include <Arduino.h>
+#include <esp_rom_crc.h>
+
+#include "tc_stall.h"
+
+#define STALL_POLL          20          // ms
+#define STALL_TASK_CORE     0
+#define STALL_TASK_PRIO     1
+#define STALL_TASK_STACK    3072
+
+#define STALL_RTCM_MAGIC    0x53544c01  // "STL", version 1
+
+#define STALL_K_LOOP        0           // loop not serviced
+#define STALL_K_REGION      1           // region open too long
+
+#define STALL_F_ONGOING     0x01
+#define STALL_F_RESET       0x02        // device reset during stall
+
+typedef struct {
+    uint32_t upSecs;                    // uptime at begin of stall
+    uint32_t durMs;
+    uint16_t boot;
+    uint8_t  kind;
+    uint8_t  flags;
+    char     task[8];
+    char     region[12];
+} stallRec;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t total;                     // stalls since power-on
+    uint16_t boot;                      // boots since power-on
+    uint8_t  head;                      // next slot to write
+    uint8_t  num;
+    stallRec rec[STALL_NUM];
+    uint32_t crc;                       // over all of the above
+} stallRTCMem;
+
+static RTC_NOINIT_ATTR stallRTCMem rtcMem;
+static portMUX_TYPE stallMux = portMUX_INITIALIZER_UNLOCKED;
+
+volatile unsigned long stallBeatNow = 0;
+const char * volatile stallTaskName = NULL;
+
+static TaskHandle_t stallMainTask = NULL;
+static TaskHandle_t stallTaskHandle = NULL;
+
+// Region breadcrumb; written by main task only
+static const char * volatile rgnName = NULL;
+static const char * volatile rgnTask = NULL;
+static volatile unsigned long rgnStart = 0;
+static volatile uint32_t rgnSeq = 0;
+static int rgnDepth = 0;
+
+static volatile bool stallNew = false;
+
+static uint32_t rtcMemCRC()
+{
+    return esp_rom_crc32_le(0, (uint8_t *)&rtcMem, offsetof(stallRTCMem, crc));
+}
+
+static void rtcMemCheck()
+{
+    esp_reset_reason_t r = esp_reset_reason();
+
+    if(r == ESP_RST_POWERON || r == ESP_RST_BROWNOUT || r == ESP_RST_UNKNOWN ||
+       rtcMem.magic != STALL_RTCM_MAGIC || rtcMem.crc != rtcMemCRC()) {
+        memset(&rtcMem, 0, sizeof(rtcMem));
+        rtcMem.magic = STALL_RTCM_MAGIC;
+    } else {
+        // A stall still under way when we went down probably
+        // caused the reset (task watchdog, user pulling the plug)
+        for(int i = 0; i < STALL_NUM; i++) {
+            if(rtcMem.rec[i].flags & STALL_F_ONGOING) {
+                rtcMem.rec[i].flags &= ~STALL_F_ONGOING;
+                rtcMem.rec[i].flags |= STALL_F_RESET;
+            }
+        }
+        rtcMem.boot++;
+    }
+    rtcMem.crc = rtcMemCRC();
+}
+
+static stallRec *stallBegin(uint8_t kind, unsigned long start, const char *task, const char *region)
+{
+    stallRec *r;
+
+    portENTER_CRITICAL(&stallMux);
+    r = &rtcMem.rec[rtcMem.head];
+    rtcMem.head = (rtcMem.head + 1) % STALL_NUM;
+    if(rtcMem.num < STALL_NUM) rtcMem.num++;
+    rtcMem.total++;
+    memset(r, 0, sizeof(stallRec));
+    r->upSecs = start / 1000;
+    r->durMs = millis() - start;
+    r->boot = rtcMem.boot;
+    r->kind = kind;
+    r->flags = STALL_F_ONGOING;
+    if(task) strncpy(r->task, task, sizeof(r->task) - 1);
+    if(region) strncpy(r->region, region, sizeof(r->region) - 1);
+    rtcMem.crc = rtcMemCRC();
+    portEXIT_CRITICAL(&stallMux);
+
+    return r;
+}
+
+static void stallUpdate(stallRec *r, unsigned long start, bool over)
+{
+    portENTER_CRITICAL(&stallMux);
+    r->durMs = millis() - start;
+    if(over) r->flags &= ~STALL_F_ONGOING;
+    rtcMem.crc = rtcMemCRC();
+    portEXIT_CRITICAL(&stallMux);
+}
+
+static void stallTask(void *arg)
+{
+    stallRec *cur = NULL;
+    uint8_t  kind = 0;
+    unsigned long start = 0, beatAtStart = 0;
+    uint32_t seqAtStart = 0;
+    
+    for(;;) {
+        
+        vTaskDelay(pdMS_TO_TICKS(STALL_POLL));
+
+        unsigned long now = millis();
+        unsigned long beat = stallBeatNow;
+        const char *rgn = rgnName;
+        unsigned long rs = rgnStart;
+        uint32_t seq = rgnSeq;
+
+        if(!cur) {
+            if(now - beat > STALL_THRESHOLD) {
+                kind = STALL_K_LOOP;
+                start = beatAtStart = beat;
+                cur = stallBegin(kind, start, stallTaskName, rgn);
+            } else if(rgn && now - rs > STALL_THRESHOLD) {
+                kind = STALL_K_REGION;
+                start = rs;
+                seqAtStart = seq;
+                cur = stallBegin(kind, start, rgnTask, rgn);
+            }
+        } else {
+            bool over = (kind == STALL_K_LOOP) ? (beat != beatAtStart) : 
+                                                 (!rgn || seq != seqAtStart);
+            stallUpdate(cur, start, over);
+            if(over) {
+                #ifdef TC_DBG
+                Serial.printf("Stall: %ums in %s/%s\n", cur->durMs, 
+                          cur->task[0] ? cur->task : "-", cur->region[0] ? cur->region : "-");
+                #endif
+                cur = NULL;
+                stallNew = true;
+            }
+        }
+    }
+}
+
+/*
+ * Start the monitor. Called at the end of setup(), from the
+ * main task; boot phases are not monitored.
+ */
+void stall_setup()
+{
+    rtcMemCheck();
+
+    stallMainTask = xTaskGetCurrentTaskHandle();
+    stallBeatNow = millis();
+
+    if(xTaskCreatePinnedToCore(stallTask, "stall", STALL_TASK_STACK, NULL, 
+                               STALL_TASK_PRIO, &stallTaskHandle, STALL_TASK_CORE) != pdPASS) {
+        stallTaskHandle = NULL;
+    }
+    
+    #ifdef TC_DBG
+    Serial.printf("Stall monitor %s, %d stalls logged\n", stallTaskHandle ? "started" : "failed", rtcMem.num);
+    #endif
+}
+
+void stallEnter(const char *region)
+{
+    if(xTaskGetCurrentTaskHandle() != stallMainTask)
+        return;
+        
+    if(!rgnDepth++) {
+        rgnStart = millis();
+        rgnTask = stallTaskName;
+        rgnSeq++;
+        rgnName = region;
+    }
+}
+
+void stallLeave()
+{
+    if(xTaskGetCurrentTaskHandle() != stallMainTask)
+        return;
+
+    if(rgnDepth && !--rgnDepth) {
+        rgnName = NULL;
+    }
+}
+
+// True once after a stall has ended; for MQTT
+bool stallNewRecord()
+{
+    if(stallNew) {
+        stallNew = false;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Log as text, newest first; "boot" is relative to the current
+ * boot (0 = this one, -1 = the one before, etc). With header, 
+ * aligned columns for the Config Portal; otherwise one 
+ * comma-separated line per stall for MQTT:
+ * boot,uptime_s,duration_ms,task,region,kind
+ */
+int stallLogToText(char *buf, int bufSize, bool header)
+{
+    stallRTCMem m;
+    int len = 0;
+
+    portENTER_CRITICAL(&stallMux);
+    memcpy(&m, &rtcMem, sizeof(m));
+    portEXIT_CRITICAL(&stallMux);
+
+    buf[0] = 0;
+
+    if(header) {
+        len = snprintf(buf, bufSize, "threshold %dms, %u stalls since power-on, %u resets\n"
+                                     "%5s %10s %8s %-7s %-11s %s\n",
+                    STALL_THRESHOLD, m.total, m.boot,
+                    "boot", "uptime_s", "dur_ms", "task", "region", "kind");
+    }
+
+    for(int i = 1; i <= m.num && len < bufSize; i++) {
+        stallRec *r = &m.rec[(m.head + STALL_NUM - i) % STALL_NUM];
+        char kind[16];
+        strcpy(kind, (r->kind == STALL_K_LOOP) ? "loop" : "region");
+        if(r->flags & STALL_F_ONGOING) strcat(kind, "+ongoing");
+        if(r->flags & STALL_F_RESET)   strcat(kind, "+reset");
+        len += snprintf(buf + len, bufSize - len, 
+                    header ? "%5d %10u %8u %-7s %-11s %s\n" : "%d,%u,%u,%s,%s,%s\n",
+                    (int)r->boot - (int)m.boot, r->upSecs, r->durMs, 
+                    r->task[0] ? r->task : "-", r->region[0] ? r->region : "-", kind);
+    }
+
+    return (len < bufSize) ? len : bufSize - 1;
+}
+
+#endif  // TC_STALLMON
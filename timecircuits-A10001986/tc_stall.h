@@ -0,0 +1,109 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Main loop stall monitor
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_STALL_H
+#define _TC_STALL_H
+
+/*
+ * Stall monitor
+ *
+ * A low-priority task on core 0 watches the main loop's heartbeat 
+ * (every scheduler pass) and the breadcrumbs left by the scheduler 
+ * (name of the task being run) and by potentially blocking code 
+ * (STALL_ENTER/STALL_LEAVE regions). If the loop is not serviced for 
+ * more than STALL_THRESHOLD ms, or a region stays open for longer than 
+ * that (even if the loop is serviced from within through mydelay() 
+ * and friends), a stall is recorded along with the task and region.
+ *
+ * The last STALL_NUM stalls are kept in RTC memory, and therefore 
+ * survive software resets, panics and watchdog resets. A stall that 
+ * was still going on when the device reset is marked as such.
+ * The log is served by the Config Portal at /stalls, and published 
+ * to bttf/tcd/stalls through MQTT.
+ */
+
+#ifdef TC_STALLMON
+
+#define STALL_NUM       8
+
+extern volatile unsigned long stallBeatNow;
+extern const char * volatile stallTaskName;
+
+// Main loop heartbeat; called on every scheduler pass
+#define STALL_BEAT()        stallBeatNow = millis()
+
+// Scheduler: Name the task being run, restore afterwards
+#define STALL_TASK_SET(n)   const char *_stOldTask = stallTaskName; stallTaskName = (n)
+#define STALL_TASK_END()    stallTaskName = _stOldTask
+
+// Potentially blocking regions; the name must be a string 
+// constant of max 11 characters. Regions may nest; only
+// the outermost is tracked. Ignored outside the main task.
+#define STALL_ENTER(n)      stallEnter(n)
+#define STALL_LEAVE()       stallLeave()
+
+void stall_setup();
+void stallEnter(const char *region);
+void stallLeave();
+bool stallNewRecord();
+int  stallLogToText(char *buf, int bufSize, bool header);
+
+#else
+
+#define STALL_BEAT()
+#define STALL_TASK_SET(n)
+#define STALL_TASK_END()
+#define STALL_ENTER(n)
+#define STALL_LEAVE()
+
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Shared state snapshot and event bus
+ *
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "clockdisplay.h"
+#include "tc_keypad.h"
+#include "tc_time.h"
+
+#include "tc_state.h"
+
+#define EV_RING     16      // Power of 2
+
+// Snapshot; stSeq is odd while it is being written
+static tcState               stCur = { 0 };
+static std::atomic<uint32_t> stSeq(0);
+
+// Event ring; evSeq per slot is 2*index+1 while being 
+// written, 2*index+2 when complete
+static tcEvent               evRing[EV_RING];
+static std::atomic<uint32_t> evSeq[EV_RING];
+static std::atomic<uint32_t> evHead(0);
+
+/*
+ * Snapshot
+ */
+
+// Main loop only; cheap if nothing changed
+void statePublish()
+{
+    tcState n = stCur;
+    bool    oldNM = stCur.nightMode;
+    bool    oldOn = stCur.fpbOn;
+    bool    oldTT = (stCur.ttP0 || stCur.ttP1 || stCur.ttRE || stCur.ttP2);
+    bool    oldRE = stCur.ttRE;
+    uint32_t s;
+
+    n.ttP0 = timeTravelP0;
+    n.ttP1 = timeTravelP1;
+    n.ttP2 = timeTravelP2;
+    n.ttRE = timeTravelRE;
+    n.fpbOn = FPBUnitIsOn;
+    n.menuActive = menuActive;
+    n.startup = startup;
+    n.nightMode = presentTime.getNightMode();
+    n.specDisp = specDisp;
+    n.mqttDisp = mqttDisp;
+
+    // Compare state only
+    n.version = stCur.version;
+    n.stamp = stCur.stamp;
+    if(!memcmp(&n, &stCur, sizeof(n)))
+        return;
+
+    n.version++;
+    n.stamp = millis();
+
+    s = stSeq.load(std::memory_order_relaxed);
+    stSeq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    stCur = n;
+    stSeq.store(s + 2, std::memory_order_release);
+
+    // Derive transitions
+    if(!oldTT && (n.ttP0 || n.ttP1 || n.ttRE || n.ttP2)) {
+        evPost(EV_TT_START);
+    }
+    if(!oldRE && n.ttRE) {
+        evPost(EV_TT_REENTRY);
+    }
+    if(oldTT && !(n.ttP0 || n.ttP1 || n.ttRE || n.ttP2)) {
+        evPost(EV_TT_DONE);
+    }
+    if(oldNM != n.nightMode) {
+        evPost(EV_NIGHTMODE, n.nightMode ? 1 : 0);
+    }
+    if(oldOn != n.fpbOn) {
+        evPost(EV_POWER, n.fpbOn ? 1 : 0);
+    }
+}
+
+// Any task
+void stateGet(tcState& st)
+{
+    uint32_t s1, s2;
+    int tries = 0;
+
+    for(;;) {
+        s1 = stSeq.load(std::memory_order_acquire);
+        st = stCur;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s2 = stSeq.load(std::memory_order_relaxed);
+        if(!(s1 & 1) && s1 == s2)
+            break;
+        // Writer interrupted on our core? Let it finish.
+        if(++tries > 8) vTaskDelay(1);
+    }
+}
+
+// Device busy or not in normal operation
+bool stateBusy(const tcState& st)
+{
+    return (!st.fpbOn || st.menuActive || st.startup ||
+            st.ttP0 || st.ttP1 || st.ttRE);
+}
+
+/*
+ * Event bus
+ */
+
+// Main loop only
+void evPost(uint8_t type, uint8_t arg)
+{
+    uint32_t idx = evHead.load(std::memory_order_relaxed);
+    int      slot = idx & (EV_RING - 1);
+
+    evSeq[slot].store(2 * idx + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    evRing[slot].type = type;
+    evRing[slot].arg = arg;
+    evRing[slot].stamp = millis();
+    evSeq[slot].store(2 * idx + 2, std::memory_order_release);
+
+    evHead.store(idx + 1, std::memory_order_release);
+}
+
+// Cursor for a new reader: Only events posted from now on
+uint32_t evSubscribe()
+{
+    return evHead.load(std::memory_order_acquire);
+}
+
+// Next event for this reader; false if none. lost (if given)
+// is incremented by the number of events that were overwritten
+// before the reader got to them.
+bool evPoll(uint32_t& cursor, tcEvent& e, uint32_t *lost)
+{
+    uint32_t head, s1, s2;
+    int slot;
+
+    for(;;) {
+        head = evHead.load(std::memory_order_acquire);
+        if(cursor == head)
+            return false;
+
+        if(head - cursor > EV_RING) {
+            if(lost) *lost += head - cursor - EV_RING;
+            cursor = head - EV_RING;
+        }
+
+        slot = cursor & (EV_RING - 1);
+        s1 = evSeq[slot].load(std::memory_order_acquire);
+        e = evRing[slot];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s2 = evSeq[slot].load(std::memory_order_relaxed);
+
+        cursor++;
+
+        if(s1 == s2 && s1 == 2 * (cursor - 1) + 2)
+            return true;
+
+        // Overwritten while reading
+        if(lost) (*lost)++;
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Shared state snapshot and event bus
+ *
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_STATE_H
+#define _TC_STATE_H
+
+/*
+ * Shared state snapshot and event bus
+ *
+ * The main loop owns the state globals (timeTravelP0, FPBUnitIsOn,
+ * menuActive etc). statePublish(), run by the scheduler in every
+ * context, copies them into a versioned snapshot guarded by a 
+ * sequence counter (seqlock). Any task can stateGet() a consistent 
+ * copy without locking; the writer never waits for readers.
+ *
+ * Transitions (time travel started, re-entry, night mode, power, 
+ * alarm) are posted to a ring of events. Each reader keeps its own 
+ * cursor from evSubscribe(); a reader that falls more than EV_RING 
+ * events behind loses the oldest ones and is told how many.
+ * Events are only posted from the main loop.
+ */
+
+typedef struct {
+    uint32_t      version;      // Incremented on every change
+    unsigned long stamp;        // millis() of last change
+    int8_t        ttP0;         // timeTravelP0
+    int8_t        ttP1;         // timeTravelP1
+    int8_t        ttP2;         // timeTravelP2
+    bool          ttRE;         // timeTravelRE
+    bool          fpbOn;        // FPBUnitIsOn
+    bool          menuActive;
+    bool          startup;
+    bool          nightMode;
+    int8_t        specDisp;
+    uint8_t       mqttDisp;
+} tcState;
+
+// Event types
+#define EV_TT_START     1       // Time travel started
+#define EV_TT_REENTRY   2       // Re-entry
+#define EV_TT_DONE      3       // Sequence finished
+#define EV_NIGHTMODE    4       // arg: 1 = on, 0 = off
+#define EV_POWER        5       // arg: 1 = on, 0 = off (fake power)
+#define EV_ALARM        6       // Alarm fired
+
+typedef struct {
+    uint8_t       type;
+    uint8_t       arg;
+    unsigned long stamp;
+} tcEvent;
+
+void     statePublish();
+void     stateGet(tcState& st);
+bool     stateBusy(const tcState& st);
+
+void     evPost(uint8_t type, uint8_t arg = 0);
+uint32_t evSubscribe();
+bool     evPoll(uint32_t& cursor, tcEvent& ev, uint32_t *lost = NULL);
+
+#endif
@@ -56,14 +56,26 @@
 #include <time.h>
 #include <WiFi.h>
 #include <Wire.h>
-#include <Udp.h>
-#include <WiFiUdp.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#ifdef TC_PWR_NAP
+#include <esp_sleep.h>
+#endif
 
 #include "tc_keypad.h"
 #include "tc_menus.h"
 #include "tc_audio.h"
 #include "tc_wifi.h"
 #include "tc_settings.h"
+#include "tc_i2c.h"
+#include "tc_anim.h"
+#include "tc_udp.h"
+#include "tc_boot.h"
+#include "tc_sched.h"
+#include "tc_state.h"
+#include "tc_prof.h"
+#include "tc_stall.h"
+#include "tc_cmd.h"
 #if defined(FAKE_POWER_ON) || defined(TC_HAVE_RE) || defined(TC_HAVE_REMOTE)
 #include "input.h"
 #endif
@@ -85,6 +97,13 @@
 
 #define GPS_ADDR       0x10 // GPS receiver
 
+// A GPS on UART does not need any i2c bus time
+#ifdef TC_GPS_UART
+#define GPS_EST 0
+#else
+#define GPS_EST I2C_EST_GPS
+#endif
+
                             // temperature sensors
 #define MCP9808_ADDR   0x18 // [default]
 #define BMx280_ADDR    0x77 // [default]
@@ -157,6 +176,7 @@
 // Native NTP
 #define NTP_PACKET_SIZE 48
 #define NTP_DEFAULT_LOCAL_PORT 1337
+#define NTP_FILTER_SIZE 4       // Samples kept for min-delay filter
 
 #define SECS1900_1970 2208988800ULL
 
@@ -166,15 +186,12 @@
 
 unsigned long        powerupMillis = 0;
 
-// millis64
-static unsigned long lastMillis64 = 0;
-static uint64_t      millisEpoch = 0;
-
 static bool          couldHaveAuthTime = false;
 static bool          haveAuthTime = false;
 uint16_t             lastYear = 0;
 static uint16_t      lastHour = 23;
 static uint8_t       resyncInt = 5;
+static bool          bootNTPPending = false;
 bool                 syncTrigger = false;
 bool                 doAPretry = true;
 static bool          deferredCP = false;
@@ -183,6 +200,20 @@ static unsigned long deferredCPNow = 0;
 // For tracking second changes
 static bool          x = false;  
 static bool          y = false;
+static volatile bool     sqwLevel = false;
+static volatile uint32_t sqwEdges = 0;
+static volatile int64_t  sqwEdgeUs = 0;
+static uint32_t          sqwEdgesSeen = 0;
+
+// Cached RTC time (raw hardware values)
+#define RTC_CACHE_MAXAGE   600000   // us; SQW edges come every 500ms
+#define RTC_EXTRAP_MAXAGE  10000000 // us; how long to bridge bad reads
+static DateTime          rtcCache;
+static bool              rtcCacheValid = false;
+static uint32_t          rtcCacheEdges = 0;
+static uint32_t          rtcCacheAdj = 0;
+static int64_t           rtcCacheUs = 0;
+static bool              rtcCacheStale = false;
 
 // For beep-auto-modes
 uint8_t              beepMode = 0;
@@ -221,7 +252,6 @@ bool                 useSpeedo = false;
 static uint8_t       speedoStatus = SPST_NIL;
 static unsigned long timetravelP0Now = 0;
 static unsigned long timetravelP0Delay = 0;
-static unsigned long ttP0Now = 0;
 static uint8_t       timeTravelP0Speed = 0;
 static long          pointOfP1 = 0;
 static long          pointOfP1NoLead = 0;
@@ -252,6 +282,22 @@ static uint8_t       bttfnRemCurSpd   = 0;      // What is displayed on speedo
 static uint8_t       bttfnOldRemCurSpd = 255;
 static uint8_t       bttfnRemCurSpdOld = 255;
 static unsigned long lastRemSpdUpd = 0, remSpdCatchUpDelay = 80;
+// Remote speed jitter buffer: Speed is followed REM_SPD_PLAYOUT
+// behind reception, interpolated between samples. Beyond the newest 
+// sample, it is extrapolated for at most REM_SPD_EXTRAP, and by
+// no more than REM_SPD_EXTRAP_MAX (the remote might only send
+// on changes, so a missing sample can mean "constant").
+#define REM_SPD_SAMPLES       8     // power of 2
+#define REM_SPD_PLAYOUT   60000     // us
+#define REM_SPD_EXTRAP   150000     // us
+#define REM_SPD_EXTRAP_MAX    3     // mph
+#define REM_SPD_MIN_GAP   20000     // us; spread bursts
+typedef struct {
+    int64_t  us;
+    uint8_t  spd;
+} remSpdSample;
+static remSpdSample  remSpdHist[REM_SPD_SAMPLES];
+static uint8_t       remSpdIdx = 0, remSpdNum = 0;
 bool                 remoteAllowed = false;
 bool                 remoteKPAllowed = false;
 static int           remoteWasMaster = 0;
@@ -269,15 +315,12 @@ static bool          tempLock = false;
 static unsigned long tempLockNow = 0;
 static bool          spdreOldNM = false;
 #endif
-static bool          volChanged = false;
-static unsigned long volChangedNow = 0;
 
 bool                 useTemp = false;
 bool                 dispTemp = true;
 bool                 tempOffNM = true;
 #ifdef TC_HAVETEMP
 bool                 tempUnit = DEF_TEMP_UNIT;
-static unsigned long tempReadNow = 0;
 static unsigned long tempDispNow = 0;
 static unsigned long tempUpdInt = TEMP_UPD_INT_L;
 static bool          tempLastNan = true;
@@ -312,6 +355,23 @@ static long          origEttoLeadPoint = 0;
 static uint16_t      bttfnTTLeadTime = 0;
 static long          ettoBase;
 #endif
+#if defined(EXTERNAL_TIMETRAVEL_OUT) || defined(TC_HAVESPEEDO)
+// Start points of P1 and ETTO, played back by ttSeqTimer against 
+// esp_timer time. The timer raises the wired ETTO pulse itself and
+// records when each point fired; the main loop then starts P1 and 
+// notifies networked props, with the lead reduced by its latency.
+// All state is accessed under ttSeqMux.
+#define TT_HAVE_SEQ
+#define TTS_P1              0
+#define TTS_ETTO            1
+#define TTS_NUM             2
+static esp_timer_handle_t ttSeqTimer = NULL;
+static portMUX_TYPE       ttSeqMux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t            ttSeqDue[TTS_NUM];
+static bool               ttSeqArmed[TTS_NUM] = { false };
+static bool               ttSeqFired[TTS_NUM] = { false };
+static int64_t            ttSeqFiredAt[TTS_NUM];
+#endif
 #ifdef TC_HAVE_REMOTE
 static bool          remoteInducedTT = false;
 #endif
@@ -334,9 +394,31 @@ static const char *p1errStrs[4] = {
 static unsigned long timetravelNow = 0;
 bool                 timeTravelRE = false;
 
-// CPU power management
-static bool          pwrLow = false;
+// Power governor
+#define PWR_EVAL_INT    100           // Re-evaluate demand every 100ms
+#define PWR_INPUT_HOLD  (2*60*1000)   // Full speed for 2 mins after user input
+#define PWR_NAP_MAX     20            // ms; keypad, buttons are polled
+#define PWR_NAP_GUARD   30            // ms awake before next SQW edge
+
+#define PWR_DEM_INPUT   0x0001        // Demand sources
+#define PWR_DEM_AUDIO   0x0002
+#define PWR_DEM_ANIM    0x0004
+#define PWR_DEM_PORTAL  0x0008
+#define PWR_DEM_WIFI    0x0010
+#define PWR_DEM_BTTFN   0x0020
+#define PWR_DEM_GPS     0x0040
+#define PWR_DEM_MQTT    0x0080
+#define PWR_DEM_FULL    (PWR_DEM_INPUT|PWR_DEM_AUDIO|PWR_DEM_ANIM|PWR_DEM_PORTAL)
+
+static const uint16_t pwrMHz[PWR_NUM_ST] = { 240, 160, 80, 80 };
+static uint8_t       pwrState = PWR_FULL;
+static unsigned long pwrStateNow = 0;
 static unsigned long pwrFullNow = 0;
+static unsigned long pwrLastEval = 0;
+static uint64_t      pwrStateMs[PWR_NUM_ST] = { 0 };
+#ifdef TC_PWR_NAP
+static uint64_t      pwrSleptUs = 0;
+#endif
 
 // State flags & co
 static bool postSecChange = false;
@@ -358,22 +440,22 @@ int         specDisp = 0;
 
 // Used in time loop
 static DateTime gdtu, gdtl;
+static int64_t  gdtuEdgeUs = 0;     // SQW edge at which gdtu was read
+
+// RTC write scheduled for a second boundary (NTP/GPS re-sync)
+#define RTC_SET_SPIN_US  2000       // Busy-wait at most this long
+#define RTC_SET_LATE_US  10000      // Later than this: next second
+static bool     rtcSetPending = false;
+static uint64_t rtcSetAtUs;
+static uint32_t rtcSetAdjCnt;
+static int      rtcSetY, rtcSetM, rtcSetD, rtcSetH, rtcSetMin, rtcSetS;
 
 // For displaying times off the real time
 uint64_t    timeDifference = 0;
 bool        timeDiffUp = false;  // true = add difference, false = subtract difference
 
-// TZ/DST status & data
-bool        couldDST[3]     = { false, false, false };   // Could use own DST management (and DST is defined in TZ)
-static int  tzForYear[3]    = { 0, 0, 0 };               // Parsing done for this very year
-static int8_t tzIsValid[3]  = { -1, -1, -1 };
-static int8_t tzHasDST[3]   = { -1, -1, -1 };
-static char *tzDSTpart[3]   = { NULL, NULL, NULL };
-static int  tzDiffGMT[3]    = { 0, 0, 0 };               // Difference to UTC in nonDST time
-static int  tzDiffGMTDST[3] = { 0, 0, 0 };               // Difference to UTC in DST time
-static int  tzDiff[3]       = { 0, 0, 0 };               // difference between DST and non-DST in minutes
-static int  DSTonMins[3]    = { -1, -1, -1 };            // DST-on date/time in minutes since 1/1 00:00 (in non-DST time)
-static int  DSToffMins[3]   = { 600000, 600000, 600000}; // DST-off date/time in minutes since 1/1 00:00 (in DST time)
+// TZ/DST status & data (0=present, 1=destination, 2=departed)
+static tzZone tzZones[3];
 #ifdef TC_DBG
 static const char *badTZ = "Failed to parse TZ\n";
 #endif
@@ -397,22 +479,37 @@ uint8_t     mqttDisp = 0;
 #ifdef TC_HAVEMQTT
 uint8_t     mqttOldDisp = 0;
 char        mqttMsg[256];
+cdStrip     mqttStrip;
 uint16_t    mqttIdx = 0;
 int16_t     mqttMaxIdx = 0;
 bool        mqttST = false;
 static unsigned long mqttStartNow = 0;
+// Scrolling is paced by mqttScrlTimer, the display 
+// is written from the main loop (mqttScroll())
+#define MQTT_SCROLL_INT 300
+static esp_timer_handle_t mqttScrlTimer = NULL;
+static volatile uint8_t   mqttScrlTicks = 0;
 #endif
 
 // For NTP/GPS
 static struct        tm _timeinfo;
-static WiFiUDP       ntpUDP;
-static UDP*          myUDP;
+static bool          NTPFilter(const uint8_t *buf, size_t len);
+static tcUDP         ntpUDP(NTPFilter);
+static tcUDP*        myUDP;
 static byte          NTPUDPBuf[NTP_PACKET_SIZE];
 static unsigned long NTPUpdateNow = 0;
-static unsigned long NTPTSAge = 0;
 static unsigned long NTPTSRQAge = 0;
-static uint32_t      NTPsecsSinceTCepoch = 0;
-static uint32_t      NTPmsSinceSecond = 0;
+static uint64_t      NTPTSRQUs = 0;
+typedef struct {
+    uint64_t ntpUs;             // NTP time (us since 1/1/TCEPOCH) ...
+    uint64_t localUs;           // ... at this micros64() time
+    uint32_t delayUs;           // Round-trip delay of this sample
+} NTPSample;
+static NTPSample     NTPSamples[NTP_FILTER_SIZE];
+static uint8_t       NTPNumSamples = 0;
+static uint8_t       NTPSampleIdx = 0;
+static uint64_t      NTPrefNtpUs = 0;         // Best sample
+static uint64_t      NTPrefLocalUs = 0;
 static bool          NTPPacketDue = false;
 static bool          NTPWiFiUp = false;
 static uint8_t       NTPfailCount = 0;
@@ -432,7 +529,6 @@ static unsigned long OTPRStarted = 0;
 // The GPS object
 #ifdef TC_HAVEGPS
 tcGPS myGPS(GPS_ADDR);
-static uint64_t      lastLoopGPS   = 0;
 static unsigned long GPSupdateFreq = 1000;
 #endif
 
@@ -458,6 +554,15 @@ static TCRotEnc rotEncV(3,
                           });                          
 static TCRotEnc *rotEncVol;
 #endif
+sensHistory rtcTempHist;
+#ifdef TC_HAVETEMP
+sensHistory tempHist;
+sensHistory humHist;
+#endif
+#ifdef TC_HAVELIGHT
+sensHistory luxHist;
+#endif
+
 #ifdef TC_HAVETEMP
 tempSensor tempSens(9, 
             (uint8_t[9*2]){ MCP9808_ADDR, MCP9808,
@@ -552,6 +657,14 @@ static int8_t  sensorNightMode = -1;
 int8_t         manualNightMode = -1;
 unsigned long  manualNMNow = 0;
 int32_t        luxLimit = 3;
+#ifdef TC_HAVELIGHT
+// Light sensor NM: Hysteresis (percent of luxLimit, with 
+// minimum in lux) and minimum time a new state must last
+#define LUX_HYST_PCT   25
+#define LUX_HYST_MIN   2
+#define LUX_DWELL      6000
+static bool    lightNMEval = false;
+#endif
 static const uint32_t autoNMhomePreset[7] = {     // Mo-Th 5pm-11pm, Fr 1pm-1am, Sa 9am-1am, Su 9am-11pm
         0b011111111000000000000001,   //Sun
         0b111111111111111110000001,   //Mon
@@ -594,9 +707,6 @@ const uint32_t *autoNMPresets[AUTONM_NUM_PRESETS] = {
     autoNMoffice2Preset, autoNMshopPreset
 };
 bool useLight = false;
-#ifdef TC_HAVELIGHT
-static unsigned long lastLoopLight = 0;
-#endif
 
 // Count-down timer
 unsigned long ctDown = 0;
@@ -615,15 +725,6 @@ bool        waitForFakePowerButton = false;
 #endif
 
 // Date & time stuff
-static const uint8_t monthDays[] =
-{
-    31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-};
-static const unsigned int mon_yday[2][13] =
-{
-    { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
-    { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
-};
 static const unsigned int mon_ydayt24t60[2][13] =
 {
     { 0, 31*24*60,  59*24*60,  90*24*60, 120*24*60, 151*24*60, 181*24*60, 
@@ -746,27 +847,6 @@ static const uint32_t hours1kYears[] =
 
 #ifdef TC_JULIAN_CAL
 static uint64_t tdro = 5258967840;
-#ifndef JSWITCH_1582
-static int jCentStart   = 1700;      // Start of century when switch took place
-static int jCentEnd     = 1799;      // Last year of century when switch took place
-static int jSwitchYear  = 1752;      // Year in which switch to Gregorian Cal took place
-static int jSwitchMon   = 9;         // Month in which switch to Gregorian Cal took place
-static int jSwitchDay   = 2;         // Last day of Julian Cal
-static int jSwitchSkipD = 11;        // Number of days skipped
-static int jSwitchSkipH = 11 * 24;   // Num hours skipped
-#else
-static int jCentStart   = 1500;      // Start of century when switch took place
-static int jCentEnd     = 1599;      // Last year of century when switch took place
-static int jSwitchYear  = 1582;      // Year in which switch to Gregorian Cal took place
-static int jSwitchMon   = 10;        // Month in which switch to Gregorian Cal took place
-static int jSwitchDay   = 4;         // Last day of Julian Cal
-static int jSwitchSkipD = 10;        // Number of days skipped
-static int jSwitchSkipH = 10 * 24;   // Num hours skipped
-#endif
-static int mon_yday_jSwitch[13];     // Accumulated days per month in year of Switch
-static int mon_ydayt24t60J[13];      // Accumulated mins per month in year of Switch
-static int jSwitchYrHrs;
-static uint32_t jSwitchHash = 0;
 #else
 static uint64_t tdro = 5258964960;
 #endif
@@ -802,6 +882,16 @@ static const int16_t tt_p0_delays_movie[88] =
 static const int16_t *tt_p0_delays = tt_p0_delays_movie;
 static long tt_p0_totDelays[88];
 #endif
+#ifdef TC_HAVESPEEDO
+// P0 schedule in us, tt_p0_delays scaled by ttP0TimeFactor;
+// played back by p0Timer
+static uint32_t tt_p0_us[88];
+static esp_timer_handle_t p0Timer = NULL;
+static portMUX_TYPE     p0TimerMux = portMUX_INITIALIZER_UNLOCKED;
+static bool             p0TimerRun = false;
+static int64_t          p0TimerDue = 0;
+static volatile uint8_t p0TimerSpeed = 0;
+#endif
 
 // BTTF UDP
 bool bttfnHaveClients = false;
@@ -820,6 +910,7 @@ bool bttfnHaveClients = false;
 #define BTTFN_NOT_REM_CMD  13
 #define BTTFN_NOT_REM_SPD  14
 #define BTTFN_NOT_SPD      15
+#define BTTFN_NOT_TIME     16
 #define BTTFN_TYPE_ANY     0    // Any, unknown or no device
 #define BTTFN_TYPE_FLUX    1    // Flux Capacitor
 #define BTTFN_TYPE_SID     2    // SID
@@ -827,12 +918,6 @@ bool bttfnHaveClients = false;
 #define BTTFN_TYPE_VSR     4    // VSR
 #define BTTFN_TYPE_AUX     5    // Aux (user custom device)
 #define BTTFN_TYPE_REMOTE  6    // Futaba remote control
-#define BTTFN_REMCMD_PING       1   // Implicit "Register"/keep-alive
-#define BTTFN_REMCMD_BYE        2   // Forced unregister
-#define BTTFN_REMCMD_COMBINED   3   // All switches & speed combined
-#define BTTFN_REMCMD_KP_PING    4
-#define BTTFN_REMCMD_KP_KEY     5
-#define BTTFN_REMCMD_KP_BYE     6
 #define BTTFN_SSRC_NONE         0
 #define BTTFN_SSRC_GPS          1
 #define BTTFN_SSRC_ROTENC       2
@@ -840,39 +925,93 @@ bool bttfnHaveClients = false;
 #define BTTFN_SSRC_P0           4
 #define BTTFN_SSRC_P1           5
 #define BTTFN_SSRC_P2           6
-#define BTTFN_VERSION              1
+#define BTTFN_VERSION              2
+#define BTTFN_VERSION_AGGR         2    // First version supporting aggregated notifications
 #define BTTF_PACKET_SIZE          48
 #define BTTF_DEFAULT_LOCAL_PORT 1338
-#define BTTFN_MAX_CLIENTS          5
 static const uint8_t BTTFUDPHD[4] = { 'B', 'T', 'T', 'F'};
-static WiFiUDP       bttfUDP;
-static UDP*          tcdUDP;
+static bool          bttfnFilter(const uint8_t *buf, size_t len);
+static tcUDP         bttfUDP(bttfnFilter);
+static tcUDP*        tcdUDP;
 #ifdef TC_BTTFN_MC
-static WiFiUDP       bttfmcUDP;
-static UDP*          tcdmcUDP;
+static tcUDP         bttfmcUDP(bttfnFilter);
+static tcUDP*        tcdmcUDP;
+static bool          bttfnMcPending = false;
 #endif
 static byte          BTTFUDPBuf[BTTF_PACKET_SIZE];
-static uint8_t       bttfnClientIP[BTTFN_MAX_CLIENTS][4]  = { { 0 } };
-static char          bttfnClientID[BTTFN_MAX_CLIENTS][13] = { { 0 } };
-static uint8_t       bttfnClientType[BTTFN_MAX_CLIENTS] = { 0 };
-static unsigned long bttfnClientALIVE[BTTFN_MAX_CLIENTS] = { 0 };
-#ifdef TC_BTTFN_MC
-static uint8_t       bttfnClientMC[BTTFN_MAX_CLIENTS] = { 0 };
-#endif
-#ifdef TC_HAVE_REMOTE
-static uint32_t      bttfnRemID[BTTFN_MAX_CLIENTS] = { 0 };
+// Client table: Records are kept dense (0..bttfnNumCli-1); a 
+// hash table (open addressing, linear probing) maps the IP to 
+// the record index. BTTFN_HASH_SIZE must be a power of 2 and
+// at least twice BTTFN_MAX_CLIENTS.
+#if BTTFN_MAX_CLIENTS > 64
+#error "BTTFN_MAX_CLIENTS must be <= 64"
 #endif
+#define BTTFN_HASH_SIZE          128
+typedef struct {
+    uint8_t       ip[4];
+    char          id[13];
+    uint8_t       type;
+    uint8_t       ver;
+    #ifdef TC_BTTFN_MC
+    uint8_t       mc;
+    #endif
+    #ifdef TC_HAVE_REMOTE
+    uint32_t      remID;
+    #endif
+    uint16_t      rtt;          // Smoothed round trip time (ms); BTTFN_RTT_NONE if unknown
+    unsigned long alive;
+} bttfnClient;
+// RTT measurement (v2 clients): The TCD stamps replies with its 
+// millis() (bytes 45-46); the client echoes the last stamp in its 
+// next request (45-46), along with the time it held it (43-44).
+#define BTTFN_RTT_NONE      0xffff
+static bttfnClient   bttfnClients[BTTFN_MAX_CLIENTS];
+static int           bttfnNumCli = 0;
+static uint8_t       bttfnCliHash[BTTFN_HASH_SIZE] = { 0 };   // index + 1; 0 = empty
+static uint16_t      bttfnCliGen = 0;                         // changes when clients come or go
 static uint8_t       bttfnDateBuf[8];
 static uint32_t      bttfnSeqCnt = 1;
+static uint32_t      bttfnPktNum = 0;
+static uint64_t      bttfnPktCycles = 0;
+// Notifications to v2 clients are collected for BTTFN_AGGR_MS
+// and sent as one packet per client: 
+// 4: version + notify marker, 5: 0xff (aggr marker), 6: number of events,
+// 7-10: sequence, 11-46: events as TLV (event id, length, payload)
+#define BTTFN_AGGR_MS             10
+#define BTTFN_AGGR_MAX             6    // (46 - 11) / (2 + 4)
+#define BTTFN_AGGR_MARKER       0xff
+typedef struct {
+    uint8_t       target;
+    uint8_t       event;
+    uint16_t      payload;
+    uint16_t      payload2;
+} bttfnAggrEv;
+static bttfnAggrEv   bttfnAggr[BTTFN_AGGR_MAX];
+static int           bttfnNumAggr = 0;
+static unsigned long bttfnAggrNow = 0;
 static unsigned long bttfnlastExpire = 0;
 #ifdef TC_BTTFN_MC
 static uint32_t      hostNameHash = 0;
 static byte          BTTFMCBuf[BTTF_PACKET_SIZE];
 static uint8_t       bttfnNotAllSupportMC = 0;
 static uint8_t       bttfnAtLeastOneMC = 0;
+// Speed stream: Min interval between speed changes while moving,
+// keepalive while moving/standing, and keepalive if no speed available
+#define BTTFN_SPD_INTV          100
+#define BTTFN_SPD_KEEP         2775
+#define BTTFN_SPD_KEEP_IDLE   10000
 static int16_t       oldBTTFNSpd = -2;
 static uint16_t      oldBTTFNSSrc = 0xffff;
 static unsigned long bttfnLastSpeedNot = 0;
+static int16_t       bttfnSpdSlope = 0;
+static uint32_t      bttfnSpdStamp = 0;
+// Time beacon
+#define BTTFN_TIME_INTV   10000
+#define BTTFN_TIME_SRC_NTP    1
+#define BTTFN_TIME_SRC_RTC    2
+static unsigned long bttfnLastTimeNot = 0;
+static uint64_t      bttfnLastTimeTx = 0;
+static uint32_t      bttfnLastTimeSeq = 0;
 #endif
 #ifdef TC_HAVE_REMOTE
 static uint32_t      registeredRemID  = 0;
@@ -911,13 +1050,19 @@ static void myCustomDelay_Sens(unsigned long mydel);
 static void myCustomDelay_GPS(unsigned long mydel);
 static void myIntroDelay(unsigned int mydel, bool withGPS = true);
 static void waitAudioDoneIntro();
+#ifdef TC_HAVEMQTT
+static void mqttScrollStart();
+static void mqttScroll();
+#endif
 
 static void startDisplays();
+static void IRAM_ATTR sqwISR();
+static uint32_t sqwGetEdge(int64_t *edgeUs);
 
 static bool getNTPOrGPSTime(bool weHaveAuthTime, DateTime& dt);
-static bool getNTPTime(bool weHaveAuthTime, DateTime& dt);
+static bool getNTPTime(bool weHaveAuthTime, DateTime& dt, bool defer = false);
 #ifdef TC_HAVEGPS
-static bool getGPStime(DateTime& dt);
+static bool getGPStime(DateTime& dt, bool defer = false);
 static bool setGPStime();
 bool        gpsHaveFix();
 static bool gpsHaveTime();
@@ -927,6 +1072,8 @@ static void dispGPSSpeed(bool force = false);
 #endif
 #ifdef TC_HAVE_REMOTE
 static void updAndDispRemoteSpeed();
+static void remSpdAdd(int64_t us, uint8_t spd);
+static uint8_t remSpdPredict();
 #endif
 #ifdef TC_HAVETEMP
 static void updateTemperature(bool force = false);
@@ -938,6 +1085,14 @@ static bool dispTemperature(bool force = false);
 #ifdef SP_ALWAYS_ON
 static void dispIdleZero(bool force = false);
 #endif
+static void p0TimerCB(void *arg);
+static void p0TimerStart(uint8_t speed, unsigned long firstDelay);
+static void p0TimerStop();
+#endif
+#ifdef TT_HAVE_SEQ
+static void ttSeqStart();
+static void ttSeqStop();
+static bool ttSeqCheck(int idx, long& late);
 #endif
 #ifdef TC_HAVE_RE                
 static void re_init(bool zero = true);
@@ -952,42 +1107,46 @@ static void checkForSpeedTT(bool isFake, bool isRemote);
 static void copyPresentToDeparted(bool isReturn);
 
 #ifdef EXTERNAL_TIMETRAVEL_OUT
-static void ettoPulseStart();
 static void ettoPulseStartNoLead();
 static void ettoPulseEnd();
 static void sendNetWorkMsg(const char *pl, unsigned int len, uint8_t bttfnMsg, uint16_t bttfnPayload = 0, uint16_t bttfnPayload2 = 0);
 #endif
 
 // Time calculations
-static uint64_t  dateToMins(int year, int month, int day, int hour, int minute);
-static void      minsToDate(uint64_t total, int& year, int& month, int& day, int& hour, int& minute);
-#ifdef TC_JULIAN_CAL
-static void      calcJulianData();
-#endif
-static void      convTime(int diff, int& y, int& m, int& d, int& h, int& mm);
+static void      waitUntilUs(uint64_t target);
+static void      rtcSetAt(uint64_t atUs, bool defer, DateTime& dt,
+                          int year, int month, int day, int hour, int minute, int second);
+static void      rtcSetPoll();
+static void      setDatesTimesWCFrom(DateTime *dtls[3]);
 
 /// Native NTP
 static void ntp_setup();
 static bool NTPHaveTime();
+static uint64_t NTPTimeToUs(uint8_t *buf);
 static bool NTPTriggerUpdate();
 static void NTPSendPacket();
 static void NTPCheckPacket();
-static uint32_t NTPGetSecsSinceTCepoch();
+static uint64_t NTPGetCurrUsSinceTCepoch();
 static bool NTPHaveCurrentTime();
-static bool NTPGetUTC(int& year, int& month, int& day, int& hour, int& minute, int& second);
+static bool NTPGetUTC(int& year, int& month, int& day, int& hour, int& minute, int& second, uint64_t *alignUs = NULL);
 
 // Basic Telematics Transmission Framework
 static void bttfn_setup();
 static void bttfn_expire_clients();
 static uint8_t* bttfn_unrollPacket(uint8_t *d, uint32_t m, int b);
 static bool bttfn_handlePacket(uint8_t *buf, bool isMC);
+static bool bttfn_handlePacketTimed(uint8_t *buf, bool isMC);
 static void bttfn_notify(uint8_t targetType, uint8_t event, uint16_t payload = 0, uint16_t payload2 = 0);
+static void bttfn_flush_aggr();
 #ifdef TC_HAVE_REMOTE
 static void bttfnMakeRemoteSpeedMaster(bool doit);
 #endif
+static bool bttfn_checkuc();
 #ifdef TC_BTTFN_MC
 static bool bttfn_checkmc();
 static void bttfn_notify_of_speed();
+static bool bttfn_speed_due(int16_t spd, uint16_t ssrc, unsigned long now);
+static void bttfn_notify_of_time();
 #endif
 
 /*
@@ -1044,10 +1203,13 @@ void time_setup()
 
     // Pin for monitoring seconds from RTC
     pinMode(SECONDS_IN_PIN, INPUT_PULLDOWN);
+    sqwLevel = digitalRead(SECONDS_IN_PIN);
+    sqwEdgeUs = esp_timer_get_time();
+    attachInterrupt(SECONDS_IN_PIN, sqwISR, CHANGE);
 
     // Init fake power switch
     #ifdef FAKE_POWER_ON
-    waitForFakePowerButton = (atoi(settings.fakePwrOn) > 0);
+    waitForFakePowerButton = cfg.fakePwrOn;
     if(waitForFakePowerButton) {
         fakePowerOnKey.setTiming(50, 10, 50);
         fakePowerOnKey.attachLongPressStart(fpbKeyPressed);
@@ -1055,7 +1217,7 @@ void time_setup()
     }
     #endif
 
-    playIntro = (atoi(settings.playIntro) > 0);
+    playIntro = cfg.playIntro;
 
     // RTC setup
     if(!rtc.begin(powerupMillis)) {
@@ -1081,6 +1243,10 @@ void time_setup()
     RTCNeedsOTPR = rtc.NeedOTPRefresh();
     #endif
 
+    if(rtc.haveTemperature()) {
+        i2c_poll_register(I2C_POLL_RTCTEMP, 60*1000, 30*1000, I2C_EST_SENSOR);
+    }
+
     if(rtc.lostPower()) {
 
         // Lost power and battery didn't keep time, so set current time to 
@@ -1107,6 +1273,9 @@ void time_setup()
     // Turn on the RTC's 1Hz clock output
     rtc.clockOutEnable();
 
+    wifiBootPoll();
+    bootMark("rtc");
+
     // Calculate data for Julian Calendar
     #ifdef TC_JULIAN_CAL
     calcJulianData();
@@ -1116,7 +1285,7 @@ void time_setup()
     startDisplays();
 
     // Initialize clock mode: 12 hour vs 24 hour
-    bool mymode24 = (atoi(settings.mode24) > 0);
+    bool mymode24 = cfg.mode24;
     presentTime.set1224(mymode24);
     destinationTime.set1224(mymode24);
     departedTime.set1224(mymode24);
@@ -1125,9 +1294,9 @@ void time_setup()
     presentTime.setRTC(true);
 
     // Configure behavior in night mode
-    destinationTime.setNMOff((atoi(settings.dtNmOff) > 0));
-    presentTime.setNMOff((atoi(settings.ptNmOff) > 0));
-    departedTime.setNMOff((atoi(settings.ltNmOff) > 0));
+    destinationTime.setNMOff(cfg.dtNmOff);
+    presentTime.setNMOff(cfg.ptNmOff);
+    departedTime.setNMOff(cfg.ltNmOff);
 
     // Determine if user wanted Time Travels to be persistent
     // Requires SD card and "Save secondary settings to SD" to
@@ -1135,7 +1304,7 @@ void time_setup()
     #ifdef PERSISTENT_SD_ONLY
     if(presentTime._configOnSD) {
     #endif  
-        timetravelPersistent = (atoi(settings.timesPers) > 0);
+        timetravelPersistent = cfg.timesPers;
     #ifdef PERSISTENT_SD_ONLY
     } else {
         timetravelPersistent = false;
@@ -1186,7 +1355,7 @@ void time_setup()
     // See if speedo display is to be used
     #ifdef TC_HAVESPEEDO
     {
-        int temp = atoi(settings.speedoType);
+        int temp = cfg.speedoType;
         if(temp >= SP_NUM_TYPES) temp = 99;
         useSpeedo = (temp != 99);
         if(useSpeedo) {
@@ -1213,16 +1382,16 @@ void time_setup()
     if(useSpeedo) {
         // 'useGPSSpeed' strictly means "display GPS speed on speedo"
         // It is false if no GPS receiver found, or no speedo found, or option unchecked
-        useGPSSpeed = (atoi(settings.useGPSSpeed) > 0);
+        useGPSSpeed = cfg.useGPSSpeed;
 
         havePreTTSound = check_file_SD(preTTSound);
     }
     #endif
 
-    provGPS2BTTFN = (atoi(settings.quickGPS) > 0);
+    provGPS2BTTFN = cfg.quickGPS;
     quickGPSupdates = useGPSSpeed ? 1 : (provGPS2BTTFN ? 0 : -1);
     #ifdef TC_HAVESPEEDO
-    speedoUpdateRate = atoi(settings.spdUpdRate) & 3;
+    speedoUpdateRate = cfg.spdUpdRate & 3;
     #else
     speedoUpdateRate = 0;
     #endif
@@ -1243,7 +1412,6 @@ void time_setup()
         
         // Fetch data already in Receiver's buffer [120ms]
         for(int i = 0; i < 10; i++) myGPS.loop(true);
-        lastLoopGPS = millis64();
         
         #ifdef TC_DBG
         Serial.printf("%sGPS Receiver found\n", funcName);
@@ -1262,6 +1430,9 @@ void time_setup()
     }
     #endif
 
+    wifiBootPoll();
+    bootMark("sensors");
+
     // If a WiFi network and an NTP server are configured, we might
     // have a source for auth time.
     // (Do not involve WiFi connection status here; might change later)
@@ -1269,10 +1440,13 @@ void time_setup()
         couldHaveAuthTime = true;
     
     // Try to obtain initial authoritative time
+    // Only wait briefly if WiFi is already up; otherwise the
+    // displays come up with RTC time, and time_loop() adjusts 
+    // as soon as the first NTP response arrives (bootNTPPending).
 
     ntp_setup();
     if((settings.ntpServer[0] != 0) && (WiFi.status() == WL_CONNECTED)) {
-        int timeout = 50;
+        int timeout = 10;
         do {
             ntp_loop();
             delay(100);
@@ -1300,8 +1474,12 @@ void time_setup()
         #ifdef TC_DBG
         Serial.printf("%sRTC set through NTP\n", funcName);        
         #endif
+
+        bootMark("ntp");
         
     } else {
+
+        bootNTPPending = (settings.ntpServer[0] != 0) && wifiHaveSTAConf;
       
         // GPS might have a fix, so try fetching time from GPS
         #ifdef TC_HAVEGPS
@@ -1332,15 +1510,17 @@ void time_setup()
             // If we haven't managed to get time here, try
             // a sync in shorter intervals in time_loop.
             if(!haveAuthTimeGPS) resyncInt = 2;
-            lastLoopGPS = millis64();
         }
         #endif
     }
 
     // Start the Config Portal. Now is a good time, we had
     // our NTP access, so a WiFiScan does not disturb anything
-    // at this point.
-    if(WiFi.status() == WL_CONNECTED) {
+    // at this point. If WiFi is still connecting, start it
+    // from time_loop() later.
+    if(wifiIsConnecting()) {
+        deferredCP = true;
+    } else if(WiFi.status() == WL_CONNECTED) {
         if(playIntro
                      #ifdef FAKE_POWER_ON
                      || (waitForFakePowerButton && 
@@ -1521,6 +1701,8 @@ void time_setup()
                 break;
             }
         }
+
+        i2c_poll_register(I2C_POLL_GPS, GPSupdateFreq, GPSupdateFreq / 2, GPS_EST);
     }
     #endif
 
@@ -1558,12 +1740,12 @@ void time_setup()
     while(bttfn_loop()) {}
 
     // Auto-NightMode
-    autoNightModeMode = atoi(settings.autoNMPreset);
+    autoNightModeMode = cfg.autoNMPreset;
     if(autoNightModeMode > AUTONM_NUM_PRESETS) autoNightModeMode = 10;
     autoNightMode = (autoNightModeMode != 10);
-    autoNMOnHour = atoi(settings.autoNMOn);
+    autoNMOnHour = cfg.autoNMOn;
     if(autoNMOnHour > 23) autoNMOnHour = 0;
-    autoNMOffHour = atoi(settings.autoNMOff);
+    autoNMOffHour = cfg.autoNMOff;
     if(autoNMOffHour > 23) autoNMOffHour = 0;
     if(autoNightMode && (autoNightModeMode == 0)) {
         if((autoNightMode = (autoNMOnHour != autoNMOffHour))) {
@@ -1580,14 +1762,14 @@ void time_setup()
     if(autoNightMode) forceReEvalANM = true;
 
     // Set up alarm base: RTC or current "present time"
-    alarmRTC = (atoi(settings.alarmRTC) > 0);
+    alarmRTC = cfg.alarmRTC;
 
     // Set up option to play/mute time travel sounds
-    playTTsounds = (atoi(settings.playTTsnds) > 0);
+    playTTsounds = cfg.playTTsnds;
 
     // Set power-up setting for beep
     muteBeep = true;
-    beepMode = (uint8_t)atoi(settings.beep);
+    beepMode = cfg.beep;
     if(beepMode >= 3) {
         beepMode = 3;
         beepTimeout = BEEPM3_SECS*1000;
@@ -1596,12 +1778,12 @@ void time_setup()
 
     // Set up speedo display
     #ifdef TC_HAVESPEEDO
-    if(!useSpeedo || (!atoi(settings.speedoAF))) {
+    if(!useSpeedo || !cfg.speedoAF) {
         //tt_p0_delays = tt_p0_delays_movie;  // already initialized
         ttP0TimeFactor = 1.0;
     } else {
         tt_p0_delays = tt_p0_delays_rl;
-        ttP0TimeFactor = (float)strtof(settings.speedoFact, NULL);
+        ttP0TimeFactor = cfg.speedoFact;
     }
     #elif defined(TC_HAVE_REMOTE)
     //tt_p0_delays = tt_p0_delays_movie;  // already initialized
@@ -1609,7 +1791,7 @@ void time_setup()
     
     #ifdef TC_HAVESPEEDO
     if(useSpeedo) {
-        speedo.setBrightness(atoi(settings.speedoBright), true);
+        speedo.setBrightness(cfg.speedoBright, true);
         speedo.setDot(true);
 
         // No TT sounds to play -> no user-provided sound.
@@ -1619,9 +1801,16 @@ void time_setup()
         if(ttP0TimeFactor < 0.5) ttP0TimeFactor = 0.5;
         if(ttP0TimeFactor > 5.0) ttP0TimeFactor = 5.0;
 
-        // Calculate start point of P1 sequence
-        for(int i = 1; i < 88; i++) {
-            pointOfP1 += (unsigned long)(((float)(tt_p0_delays[i])) / ttP0TimeFactor);
+        // Calculate P0 schedule, and start point of P1 sequence
+        for(int i = 0; i < 88; i++) {
+            tt_p0_us[i] = (uint32_t)(((float)(tt_p0_delays[i]) * 1000.0) / ttP0TimeFactor);
+        }
+        {
+            int64_t totUs = 0;
+            for(int i = 1; i < 88; i++) {
+                totUs += tt_p0_us[i];
+            }
+            pointOfP1 = totUs / 1000;
         }
         #ifdef EXTERNAL_TIMETRAVEL_OUT
         ettoBase = pointOfP1;
@@ -1633,10 +1822,25 @@ void time_setup()
         {
             // Calculate total elapsed time for each mph value
             // (in order to time P0/P1 relative to current actual speed)
-            long totDelay = 0;
+            int64_t totUs = 0;
             for(int i = 0; i < 88; i++) {
-                totDelay += (long)(((float)(tt_p0_delays[i])) / ttP0TimeFactor);
-                tt_p0_totDelays[i] = totDelay;
+                totUs += tt_p0_us[i];
+                tt_p0_totDelays[i] = totUs / 1000;
+            }
+        }
+
+        if(!p0Timer) {
+            const esp_timer_create_args_t p0Args = {
+                .callback = &p0TimerCB,
+                .arg = NULL,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "p0"
+            };
+            if(esp_timer_create(&p0Args, &p0Timer) != ESP_OK) {
+                p0Timer = NULL;
+                #ifdef TC_DBG
+                Serial.println("time_setup: Failed to create P0 timer");
+                #endif
             }
         }
 
@@ -1718,18 +1922,19 @@ void time_setup()
     if(!useSpeedo || useGPSSpeed) {
         dispTemp = false;
     } else {
-        dispTemp = (atoi(settings.dispTemp) > 0);
+        dispTemp = cfg.dispTemp;
     }
     #else
     dispTemp = false;
     #endif
     if(tempSens.begin(powerupMillis, myCustomDelay_Sens)) {
-        tempUnit = (atoi(settings.tempUnit) > 0);
-        tempSens.setOffset((float)strtof(settings.tempOffs, NULL));
+        tempUnit = cfg.tempUnit;
+        tempSens.setOffset(cfg.tempOffs);
         haveRcMode = true;
+        i2c_poll_register(I2C_POLL_TEMP, tempUpdInt, 10*1000, I2C_EST_SENSOR);
         #ifdef TC_HAVESPEEDO
-        tempBrightness = atoi(settings.tempBright);
-        tempOffNM = (atoi(settings.tempOffNM) > 0);
+        tempBrightness = cfg.tempBright;
+        tempOffNM = cfg.tempOffNM;
         if(dispTemp) {
             #ifdef FAKE_POWER_ON
             if(!waitForFakePowerButton) {
@@ -1749,11 +1954,19 @@ void time_setup()
     #endif
 
     #ifdef TC_HAVELIGHT
-    useLight = (atoi(settings.useLight) > 0);
-    luxLimit = atoi(settings.luxLimit);
+    useLight = cfg.useLight;
+    luxLimit = cfg.luxLimit;
     if(useLight) {
+        #ifdef TC_GPS_UART
+        haveGPS = false;    // VEML7700's address not taken by GPS
+        #endif
         if(!lightSens.begin(haveGPS, powerupMillis, myCustomDelay_Sens)) {
             useLight = false;
+        } else {
+            lightSens.setThreshold(luxLimit, 
+                max((int32_t)LUX_HYST_MIN, luxLimit * LUX_HYST_PCT / 100),
+                LUX_DWELL);
+            i2c_poll_register(I2C_POLL_LIGHT, 3000, 1000, I2C_EST_SENSOR);
         }
     }
     #else
@@ -1765,9 +1978,9 @@ void time_setup()
     // When useETTO is false, no lead is needed.
     // Rest of flags determine parameters of wired signal.
     #ifdef EXTERNAL_TIMETRAVEL_OUT
-    useETTO = useETTOWired = (atoi(settings.useETTO) > 0);
+    useETTO = useETTOWired = cfg.useETTO;
     if(useETTOWired) {
-        useETTOWiredNoLead = (atoi(settings.noETTOLead) > 0);
+        useETTOWiredNoLead = cfg.noETTOLead;
         if(useETTOWiredNoLead) {
             useETTO = useETTOWired = false;
         }
@@ -1902,6 +2115,93 @@ void time_setup()
     if(deferredCP) deferredCPNow = millis();
 }
 
+#ifndef TT_NO_ANIM
+/*
+ * P1 glitch bursts, played as timelines
+ * so time_loop() is not blocked
+ */
+static void ttP1Glitch4(int step)
+{
+    int ii = 4 - step, tt;
+
+    if(timeTravelP1 != 4) return;
+
+    tt = rand() % 21;
+    if(tt < 5) destinationTime.show();
+    else {
+        destinationTime.showTextDirect(p1errStrs[(tt - 5) >> 2], CDT_COLON);
+    }
+    if(!(ii % 2)) destinationTime.setBrightnessDirect((1+(rand() % 10)) & 0x0a);
+    if(ii % 2) presentTime.setBrightnessDirect((1+(rand() % 10)) & 0x0b);
+    ((rand() % 10) < 3) ? departedTime.showTextDirect(">ACS2011GIDUW") : departedTime.show();
+    if(ii % 2) departedTime.setBrightnessDirect((1+(rand() % 10)) & 0x07);
+}
+
+static void ttP1Glitch5(int step)
+{
+    int ii = 4 - step, tt;
+
+    if(timeTravelP1 != 5) return;
+
+    tt = rand() % 10;
+    if(!(ii % 4))   presentTime.setBrightnessDirect(1+(rand() % 8));
+    if(tt < 3)      { presentTime.setBrightnessDirect(4); presentTime.lampTest(true); }
+    else if(tt < 7) { presentTime.show(); presentTime.on(); }
+    else            { presentTime.off(); }
+    tt = (rand() + millis()) % 10;
+    if(tt < 2)      { destinationTime.showTextDirect(p1errStrs[rand() % 4], CDT_COLON); }
+    else if(tt < 6) { destinationTime.show(); destinationTime.on(); }
+    else            { if(!(ii % 2)) destinationTime.setBrightnessDirect(1+(rand() % 8)); }
+    tt = (tt + (rand() + millis())) % 10;
+    if(tt < 4)      { departedTime.setBrightnessDirect(4); departedTime.lampTest(true); }
+    else if(tt < 7) { departedTime.showTextDirect("R 2 0 1 1 T R "); }
+    else            { departedTime.show(); }
+
+    #if 0 // Code of death for some red displays, seems they don't like realLampTest
+    tt = rand() % 10; 
+    presentTime.setBrightnessDirect(1+(rand() % 8));
+    if(tt < 3)      { presentTime.realLampTest(); }
+    else if(tt < 7) { presentTime.show(); presentTime.on(); }
+    else            { presentTime.off(); }
+    tt = (rand() + millis()) % 10;
+    if(tt < 2)      { destinationTime.realLampTest(); }
+    else if(tt < 6) { destinationTime.show(); destinationTime.on(); }
+    else            { destinationTime.setBrightnessDirect(1+(rand() % 8)); }  
+    tt = (rand() + millis()) % 10; 
+    if(tt < 4)      { departedTime.realLampTest(); }
+    else if(tt < 8) { departedTime.showTextDirect("00000000000000"); departedTime.on(); }
+    else            { departedTime.off(); }
+    #endif
+}
+#endif
+
+/*
+ * SQW monitor
+ * 
+ * The 1Hz edge is latched and time-stamped by the ISR;
+ * time_loop() picks it up from there.
+ */
+static void IRAM_ATTR sqwISR()
+{
+    sqwEdgeUs = esp_timer_get_time();
+    sqwLevel = digitalRead(SECONDS_IN_PIN);
+    sqwEdges++;
+}
+
+static uint32_t sqwGetEdge(int64_t *edgeUs)
+{
+    uint32_t e;
+
+    // 64-bit read is not atomic; retry if edge 
+    // happened in between
+    do {
+        e = sqwEdges;
+        *edgeUs = sqwEdgeUs;
+    } while(e != sqwEdges);
+
+    return e;
+}
+
 /*
  * time_loop()
  *
@@ -1914,6 +2214,12 @@ void time_loop()
     const char *funcName = "time_loop: ";
     #endif
 
+    rtcSetPoll();
+
+    i2c_pass();
+
+    anim_loop();
+
     #ifdef FAKE_POWER_ON
     if(waitForFakePowerButton) {
         fakePowerOnKey.scan();
@@ -1969,6 +2275,9 @@ void time_loop()
                     startup = false;
                     startupSound = false;
                     triggerP1 = false;
+                    #ifdef TT_HAVE_SEQ
+                    ttSeqStop();
+                    #endif
                     #ifdef EXTERNAL_TIMETRAVEL_OUT
                     triggerETTO = false;
                     ettoPulseEnd();
@@ -1988,6 +2297,9 @@ void time_loop()
                     #else
                     timeTravelP0 = 0;
                     #endif
+                    #ifdef TC_HAVESPEEDO
+                    p0TimerStop();
+                    #endif
                     timeTravelP1 = 0;
                     timeTravelRE = false;
                     timeTravelP2 = 0;
@@ -2016,7 +2328,7 @@ void time_loop()
     }
     #endif
 
-    if(deferredCP && (millis() - deferredCPNow > 4000)) {
+    if(deferredCP && !wifiIsConnecting() && (millis() - deferredCPNow > 4000)) {
         wifiStartCP();
         deferredCP = false;
     }
@@ -2035,6 +2347,7 @@ void time_loop()
     if(startup && (millis() - startupNow >= STARTUP_DELAY)) {
         animate(true);
         startup = false;
+        if(!bootMarked("shown")) bootMark("shown");
         #ifdef TC_HAVESPEEDO
         if(useSpeedo && !useGPSSpeed && !bttfnRemoteSpeedMaster) {
             #ifdef TC_HAVE_RE
@@ -2063,60 +2376,48 @@ void time_loop()
         #endif
     }
 
-    #if defined(EXTERNAL_TIMETRAVEL_OUT) || defined(TC_HAVESPEEDO)
-    // Timer for starting P1 if to be delayed
-    if(triggerP1 && (millis() - triggerP1Now >= triggerP1LeadTime)) {
-        triggerLongTT(triggerP1NoLead);
-        triggerP1 = false;
-    }
-    #endif
+    #ifdef TT_HAVE_SEQ
+    {
+        long late;
+    
+        // Start of P1 if to be delayed; P1's timing is
+        // kept relative to when it was due.
+        if(triggerP1 && ttSeqCheck(TTS_P1, late)) {
+            triggerLongTT(triggerP1NoLead);
+            timetravelP1Now -= late;
+            triggerP1 = false;
+        }
 
-    #ifdef EXTERNAL_TIMETRAVEL_OUT
-    // Timer for start of ETTO signal
-    if(triggerETTO && (millis() - triggerETTONow >= triggerETTOLeadTime)) {
-        sendNetWorkMsg("TIMETRAVEL\0", 11, BTTFN_NOT_TT, bttfnTTLeadTime, TT_P1_EXT);
-        ettoPulseStart();
-        triggerETTO = false;
-        #ifdef TC_DBG
-        Serial.println(F("ETTO triggered"));
+        #ifdef EXTERNAL_TIMETRAVEL_OUT
+        // Start of ETTO signal: The wired pulse is already up,
+        // networked props get the remaining lead.
+        if(triggerETTO && ttSeqCheck(TTS_ETTO, late)) {
+            sendNetWorkMsg("TIMETRAVEL\0", 11, BTTFN_NOT_TT, 
+                           (bttfnTTLeadTime > late) ? bttfnTTLeadTime - late : 0, TT_P1_EXT);
+            triggerETTO = false;
+            #ifdef TC_DBG
+            Serial.printf("ETTO triggered, net msg %ldms late\n", late);
+            #endif
+        }
         #endif
     }
     #endif
 
     // Time travel animation, phase 0: Speed counts up
+    // The speed is advanced by p0Timer; here we show it
+    // (the i2c bus belongs to the main loop), and follow
+    // it for fakeSpeed and BTTFN.
     #ifdef TC_HAVESPEEDO
-    if(timeTravelP0 && (millis() - timetravelP0Now >= timetravelP0Delay)) {
-
-        unsigned long univNow = millis();
-        long timetravelP0DelayT = 0;
-
-        timeTravelP0Speed++;
-
-        if(timeTravelP0Speed < 88) {
-            unsigned long ttP0NowT = univNow;
-            long ttP0LDOver = 0, ttP0LastDelay = ttP0NowT - ttP0Now;
-            ttP0Now = ttP0NowT;
-            ttP0LDOver = ttP0LastDelay - timetravelP0Delay;
-            timetravelP0DelayT = (long)(((float)(tt_p0_delays[timeTravelP0Speed])) / ttP0TimeFactor) - ttP0LDOver;
-            while(timetravelP0DelayT <= 0 && timeTravelP0Speed < 88) {
-                timeTravelP0Speed++;
-                timetravelP0DelayT += (long)(((float)(tt_p0_delays[timeTravelP0Speed])) / ttP0TimeFactor);
-            }
-        }
+    if(timeTravelP0 && (p0TimerSpeed != timeTravelP0Speed)) {
 
-        if(timeTravelP0Speed < 88) {
-
-            timetravelP0Delay = timetravelP0DelayT;
-            timetravelP0Now = univNow;
+        timeTravelP0Speed = p0TimerSpeed;
 
-        } else {
+        speedo.setSpeed(timeTravelP0Speed);
+        speedo.show();
 
+        if(timeTravelP0Speed >= 88) {
             timeTravelP0 = 0;
-
         }
-
-        speedo.setSpeed(timeTravelP0Speed);
-        speedo.show();
         //speedoStatus = SPST_TT;
 
         // Overwrite fakeSpeed/bttfnRemCurSpd for BTTFN clients who keep polling
@@ -2303,11 +2604,14 @@ void time_loop()
                     Serial.printf("Write lastYear to FS %d\n", millis());
                     #endif
                 }
-                if(volChanged && !postSecChangeBusy && (millis() - volChangedNow > 10*1000)) {
-                    volChanged = false;
-                    saveCurVolume();
+                // Secondary settings changed and quiet for a while?
+                if(!postSecChangeBusy && flushSecSettings()) {
                     postSecChangeBusy = true;
                 }
+                // Too many SD read errors?
+                if(!postSecChangeBusy) {
+                    sdHealthCheck();
+                }
                 // Slot was delayed, but is now taken
                 postSecChange = false;
             }
@@ -2326,7 +2630,7 @@ void time_loop()
         }
     }
 
-    y = digitalRead(SECONDS_IN_PIN);
+    y = sqwLevel;
     if((y == x) && !postSecChangeBusy) {
 
         #ifdef TC_HAVESPEEDO
@@ -2392,8 +2696,7 @@ void time_loop()
             int oldVol = curVolume;
             curVolume = rotEncVol->updateVolume(curVolume, false);
             if(oldVol != curVolume) {
-                volChanged = true;
-                volChangedNow = millis();
+                saveCurVolume();    // Only marked, written when knob rests
             }
         }
         #endif
@@ -2403,8 +2706,7 @@ void time_loop()
         // Read GPS, and display GPS speed
         #ifdef TC_HAVEGPS
         if(useGPS) {
-            if(millis64() >= lastLoopGPS) {
-                lastLoopGPS += (uint64_t)GPSupdateFreq;
+            if(i2c_poll(I2C_POLL_GPS)) {
                 // call loop with doDelay true; delay not needed but
                 // this causes a call of audio_loop() which is good
                 myGPS.loop(true);
@@ -2435,23 +2737,6 @@ void time_loop()
         }
         #endif
         
-        // Power management: CPU speed
-        // Can only reduce when GPS is not used, WiFi is off and no sound playing
-        if(!pwrLow &&
-           (wifiIsOff || wifiAPIsOff) && 
-           #ifdef TC_HAVEGPS
-           !useGPS &&
-           #endif
-           checkAudioDone() && 
-           (millisNow - pwrFullNow >= 5*60*1000)) {
-            
-            setCpuFrequencyMhz(80);
-            pwrLow = true;
-            #ifdef TC_DBG
-            Serial.printf("Reduced CPU speed to %d\n", getCpuFrequencyMhz());
-            #endif
-        }
-
         // Beep auto modes
         if(beepTimer && (millisNow - beepTimerNow > beepTimeout)) {
             muteBeep = true;
@@ -2474,12 +2759,20 @@ void time_loop()
         #endif
         
         #ifdef TC_HAVELIGHT
-        if(useLight && (millisNow - lastLoopLight >= 3000)) {
-            lastLoopLight = millisNow;
+        if(useLight && i2c_poll(I2C_POLL_LIGHT)) {
+            STALL_ENTER("lightsens");
             lightSens.loop();
+            STALL_LEAVE();
+            if(lightSens.readLux() >= 0) {
+                luxHist.add(lightSens.readLux());
+            }
         }
         #endif
 
+        if(i2c_poll(I2C_POLL_RTCTEMP)) {
+            rtcTempHist.add((int32_t)lroundf(rtc.getTemperature() * 100.0f));
+        }
+
         // End of OTPR for PCF2129
         #ifdef HAVE_PCF2129
         if(OTPRinProgress) {
@@ -2495,11 +2788,30 @@ void time_loop()
 
     #ifdef TC_BTTFN_MC
     bttfn_notify_of_speed();
+    bttfn_notify_of_time();
     #endif
     
-    y = digitalRead(SECONDS_IN_PIN);
+    int64_t  edgeUs;
+    uint32_t edges = sqwGetEdge(&edgeUs);
+    
+    y = sqwLevel;
+    if((y == x) && (edges - sqwEdgesSeen >= 2)) {
+        // Loop was stalled for a full SQW cycle;
+        // do not lose the second
+        x = true;
+        y = false;
+    }
     if(y != x) {
 
+        // Next display frame is due on the next SQW edge
+        i2c_due(I2C_DUE_DISPLAY, (unsigned long)(edgeUs / 1000) + 500);
+
+        #ifdef TC_DBG
+        if(esp_timer_get_time() - edgeUs > 100000) {
+            Serial.printf("%sSQW edge handled %d ms late\n", funcName, (int)((esp_timer_get_time() - edgeUs) / 1000));
+        }
+        #endif
+
         // Actual clock stuff
       
         if(y == 0) {
@@ -2531,6 +2843,7 @@ void time_loop()
 
             // Read RTC for UTC time
             myrtcnow(gdtu);
+            gdtuEdgeUs = edgeUs;
 
             // Re-adjust time periodically through NTP/GPS
             //
@@ -2541,15 +2854,15 @@ void time_loop()
             // - Try NTP via WiFi (doWiFi) when/if user configured a network AND
             //   -- WiFi is connected (duh!), or
             //   -- WiFi was connected and is now in power-save, but no authTime yet;
-            //      this triggers a re-connect (resulting in a frozen display).
-            //      This annoyance is kept to a minimum by setting the WiFi off-timer
+            //      this triggers a (non-blocking) re-connect. Reconnects are kept
+            //      to a minimum by setting the WiFi off-timer
             //      to a period longer than the period between two attempts; this in
             //      essence defeats WiFi power-save, but accurate time is more important.
             //   -- or if
             //          --- WiFi was connected and now off OR currently in AP-mode AND
             //          --- authTime has expired (after 7 days) AND
             //          --- it is night (0-6am)
-            //      This also triggers a re-connect (frozen display); in this case only
+            //      This also triggers a re-connect; in this case only
             //      once every 15/90 minutes (see wifiOn) during night time until a time
             //      sync succeeds or the number of attempts exceeds a certain amount.
             // - In any case, do not interrupt any running sequences.
@@ -2559,7 +2872,8 @@ void time_loop()
                              (!haveAuthTime && 
                               ( ((gdtu.minute() % resyncInt) == 1) || 
                                 ((gdtu.minute() % resyncInt) == 2) ||
-                                GPShasTime 
+                                GPShasTime                         ||
+                                (bootNTPPending && NTPHaveCurrentTime())
                               )
                              )                  ||
                              (syncTrigger &&
@@ -2609,6 +2923,10 @@ void time_loop()
 
                         bool updateTimeDiff = false;
 
+                        // RTC is written on the next second boundary;
+                        // no valid edge for gdtu until then
+                        gdtuEdgeUs = 0;
+
                         autoReadjust = true;
                         resyncInt = 5;
                         syncTrigger = false;
@@ -2625,6 +2943,11 @@ void time_loop()
                         Serial.printf("%sRTC re-adjusted using NTP or GPS\n", funcName);
                         #endif
 
+                        if(bootNTPPending) {
+                            bootNTPPending = false;
+                            bootMark("auth-time");
+                        }
+
                         // Correct timeDifference by adjustment delta
                         if(timeDifference) {
                             uint64_t newT = dateToMins(gdtu.year(), gdtu.month(), gdtu.day(), gdtu.hour(), gdtu.minute());
@@ -2663,9 +2986,10 @@ void time_loop()
 
                 // If GPS is used for time, resyncInt is possibly set to 2 during boot;
                 // reset it to 5 after 5 minutes since boot.
-                if(resyncInt != 5) {
+                if(resyncInt != 5 || bootNTPPending) {
                     if(millis() - powerupMillis > 5*60*1000) {
                         resyncInt = 5;
+                        bootNTPPending = false;
                     }
                 }
 
@@ -2734,8 +3058,26 @@ void time_loop()
             // Update "lastYear" (UTC) (saved to NVM in next loop iteration)
             lastYear = gdtu.year();
 
-            // Convert UTC to local (parses TZ in the process)
-            UTCtoLocal(gdtu, gdtl, 0);
+            // Convert UTC to local (parses TZ in the process);
+            // in WC mode, convert for WC time zones in the same 
+            // pass if the minute changed
+            {
+                DateTime wcdtl1, wcdtl2;
+                DateTime *dtls[3] = { &gdtl, NULL, NULL };
+
+                bool doWC = isWcMode() && ((gdtu.minute() != wcLastMin) || triggerWC);
+                if(doWC) {
+                    if(WcHaveTZ1) dtls[1] = &wcdtl1;
+                    if(WcHaveTZ2) dtls[2] = &wcdtl2;
+                }
+
+                UTCtoLocalBatch(gdtu, dtls);
+
+                if(doWC) {
+                    wcLastMin = gdtu.minute();
+                    setDatesTimesWCFrom(dtls);
+                }
+            }
             lastHour = gdtl.hour();
 
             // Write time to presentTime display
@@ -2746,13 +3088,9 @@ void time_loop()
             #endif
                 updatePresentTime(gdtu, gdtl);
             
-            // Handle WC mode (load dates/times for dest/dep display)
+            // Handle WC mode (dates/times for dest/dep display loaded above)
             // (Restoring not needed, done elsewhere)
             if(isWcMode()) {
-                if((gdtu.minute() != wcLastMin) || triggerWC) {
-                    wcLastMin = gdtu.minute();
-                    setDatesTimesWC(gdtu);
-                }
                 // Put city/loc name on for 3 seconds
                 if(gdtu.second() % 10 == 3) {
                     if(haveTZName1) destShowAlt = 3*2;
@@ -2863,6 +3201,7 @@ void time_loop()
                         if(!alarmDone) {
                             play_file("/alarm.mp3", PA_INTSPKR|PA_INTRMUS|PA_ALLOWSD|PA_DYNVOL);
                             alarmDone = true;
+                            evPost(EV_ALARM);
                             #ifdef EXTERNAL_TIMETRAVEL_OUT
                             sendNetWorkMsg("ALARM\0", 6, BTTFN_NOT_ALARM);
                             #endif
@@ -2911,21 +3250,21 @@ void time_loop()
                 }
                 #ifdef TC_HAVELIGHT
                 // Light sensor overrules scheduled NM only in non-NightMode periods
+                // Act only on a threshold crossing, or when the light
+                // sensor (re)gains control
                 if(useLight && (manualNightMode < 0) && (timedNightMode < 1)) {
-                    int32_t myLux = lightSens.readLux();
-                    if(myLux >= 0) {
-                        if(myLux > luxLimit) {
-                            sensorNightMode = 0;
-                            switchNMoff = true;
-                        } else {
-                            sensorNightMode = 1;
+                    if(lightSens.thresholdEvent() || !lightNMEval) {
+                        // Bad lux (probably by sensor overload): NM off
+                        sensorNightMode = lightSens.thresholdState();
+                        if(sensorNightMode == 1) {
                             nightModeOn();
+                        } else {
+                            switchNMoff = true;
                         }
-                    } else {
-                        // Bad lux (probably by sensor overload), switch NM off
-                        sensorNightMode = -1;
-                        switchNMoff = true;
+                        lightNMEval = true;
                     }
+                } else {
+                    lightNMEval = false;
                 }
                 if(switchNMoff) {
                     if(sensorNightMode < 1) nightModeOff();
@@ -3022,6 +3361,10 @@ void time_loop()
         }
 
         x = y;
+        sqwEdgesSeen = edges;
+
+        // Prepare all displays, then send in one burst
+        allHoldFrames();
 
         #ifndef TT_NO_ANIM
         if(timeTravelP1 > 1)
@@ -3030,7 +3373,6 @@ void time_loop()
         #endif    
         {
             
-            int ii = 5, tt;
             switch(timeTravelP1) {
             case 2:
                 ((rand() % 10) > 7) ? presentTime.off() : presentTime.on();
@@ -3049,55 +3391,12 @@ void time_loop()
                 destinationTime.on();
                 presentTime.on();
                 departedTime.on();
-                while(ii--) {
-                    tt = rand() % 21;
-                    if(tt < 5) destinationTime.show();
-                    else {
-                        destinationTime.showTextDirect(p1errStrs[(tt - 5) >> 2], CDT_COLON);
-                    }
-                    if(!(ii % 2)) destinationTime.setBrightnessDirect((1+(rand() % 10)) & 0x0a);
-                    if(ii % 2) presentTime.setBrightnessDirect((1+(rand() % 10)) & 0x0b);
-                    ((rand() % 10) < 3) ? departedTime.showTextDirect(">ACS2011GIDUW") : departedTime.show();
-                    if(ii % 2) departedTime.setBrightnessDirect((1+(rand() % 10)) & 0x07);
-                    mydelay(20);
-                }
+                anim_start(ttP1Glitch4, 5, 20);
                 break;
             case 5:
                 departedTime.setBrightness(255);
                 departedTime.on();
-                while(ii--) {
-                    tt = rand() % 10;
-                    if(!(ii % 4))   presentTime.setBrightnessDirect(1+(rand() % 8));
-                    if(tt < 3)      { presentTime.setBrightnessDirect(4); presentTime.lampTest(true); }
-                    else if(tt < 7) { presentTime.show(); presentTime.on(); }
-                    else            { presentTime.off(); }
-                    tt = (rand() + millis()) % 10;
-                    if(tt < 2)      { destinationTime.showTextDirect(p1errStrs[rand() % 4], CDT_COLON); }
-                    else if(tt < 6) { destinationTime.show(); destinationTime.on(); }
-                    else            { if(!(ii % 2)) destinationTime.setBrightnessDirect(1+(rand() % 8)); }
-                    tt = (tt + (rand() + millis())) % 10;
-                    if(tt < 4)      { departedTime.setBrightnessDirect(4); departedTime.lampTest(true); }
-                    else if(tt < 7) { departedTime.showTextDirect("R 2 0 1 1 T R "); }
-                    else            { departedTime.show(); }
-                    mydelay(10);
-                    
-                    #if 0 // Code of death for some red displays, seems they don't like realLampTest
-                    tt = rand() % 10; 
-                    presentTime.setBrightnessDirect(1+(rand() % 8));
-                    if(tt < 3)      { presentTime.realLampTest(); }
-                    else if(tt < 7) { presentTime.show(); presentTime.on(); }
-                    else            { presentTime.off(); }
-                    tt = (rand() + millis()) % 10;
-                    if(tt < 2)      { destinationTime.realLampTest(); }
-                    else if(tt < 6) { destinationTime.show(); destinationTime.on(); }
-                    else            { destinationTime.setBrightnessDirect(1+(rand() % 8)); }  
-                    tt = (rand() + millis()) % 10; 
-                    if(tt < 4)      { departedTime.realLampTest(); }
-                    else if(tt < 8) { departedTime.showTextDirect("00000000000000"); departedTime.on(); }
-                    else            { departedTime.off(); }
-                    mydelay(10);
-                    #endif
-                }
+                anim_start(ttP1Glitch5, 5, 10);
                 break;
             default:
                 allOff();
@@ -3115,7 +3414,7 @@ void time_loop()
             #ifdef TC_HAVEMQTT
             if(mqttDisp) {
                 if(!specDisp) {
-                    destinationTime.showTextDirect(mqttMsg + mqttIdx);
+                    destinationTime.showStripDirect(&mqttStrip, mqttIdx);
                     if(mqttST) {
                         if(!presentTime.getNightMode()) {
                             play_file(mqttAudioFile, PA_INTSPKR|PA_CHECKNM|PA_ALLOWSD);
@@ -3125,19 +3424,12 @@ void time_loop()
                     if(mqttOldDisp != mqttDisp) {
                         mqttStartNow = millis();
                         mqttOldDisp = mqttDisp;
+                        if(mqttMaxIdx >= 0) mqttScrollStart();
                     }
                     if(mqttMaxIdx < 0) {
                         if(millis() - mqttStartNow > 5000) {
                             mqttDisp = mqttOldDisp = 0;
                         }
-                    } else {
-                        if(millis() - mqttStartNow > 200) { // useless actually, we are in .5 second steps here
-                            mqttStartNow = millis();
-                            mqttIdx++;
-                            if(mqttIdx > mqttMaxIdx) {
-                                mqttDisp = mqttOldDisp = 0;
-                            }
-                        }
                     }
                 } else {
                     mqttOldDisp = mqttIdx = 0;
@@ -3177,10 +3469,78 @@ void time_loop()
             
         }
 
+        allCommitFrames();
+
         if(destShowAlt) destShowAlt--;
         if(depShowAlt) depShowAlt--;
-    } 
+    }
+
+    #ifdef TC_HAVEMQTT
+    mqttScroll();
+    #endif
+}
+
+#ifdef TC_HAVEMQTT
+static void mqttScrlTimerCB(void *arg)
+{
+    mqttScrlTicks++;
+}
+
+static void mqttScrollStart()
+{
+    if(!mqttScrlTimer) {
+        const esp_timer_create_args_t scrlArgs = {
+            .callback = &mqttScrlTimerCB,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "mqttscrl"
+        };
+        if(esp_timer_create(&scrlArgs, &mqttScrlTimer) != ESP_OK) {
+            mqttScrlTimer = NULL;
+            #ifdef TC_DBG
+            Serial.println("mqttScrollStart: Failed to create timer");
+            #endif
+            return;
+        }
+    }
+
+    esp_timer_stop(mqttScrlTimer);
+    mqttScrlTicks = 0;
+    esp_timer_start_periodic(mqttScrlTimer, MQTT_SCROLL_INT * 1000);
+}
+
+/*
+ * Advance a scrolling MQTT message by one character per
+ * timer tick; the message was rendered into mqttStrip
+ * on arrival, so this is a frame copy plus one i2c write.
+ * If the message is hidden (specDisp, time travel, etc), 
+ * scrolling pauses.
+ */
+static void mqttScroll()
+{
+    if(!mqttScrlTicks)
+        return;
+
+    mqttScrlTicks = 0;
+
+    if(!mqttDisp || mqttMaxIdx < 0) {
+        esp_timer_stop(mqttScrlTimer);
+        return;
+    }
+
+    if(mqttOldDisp != mqttDisp || specDisp || startup || timeTravelRE || 
+       !FPBUnitIsOn || autoIntAnimRunning || timeTravelP1 > 1)
+        return;
+
+    if(++mqttIdx > mqttMaxIdx) {
+        mqttDisp = mqttOldDisp = 0;
+        esp_timer_stop(mqttScrlTimer);
+        return;
+    }
+
+    destinationTime.showStripDirect(&mqttStrip, mqttIdx);
 }
+#endif
 
 
 /* Time Travel:
@@ -3264,6 +3624,9 @@ void timeTravel(bool doComplete, bool withSpeedo, bool forceNoLead)
         timeTravelP0Speed = 0;
         timetravelP0Delay = 2000;
         triggerP1 = false;
+        #ifdef TT_HAVE_SEQ
+        ttSeqStop();
+        #endif
         #ifdef EXTERNAL_TIMETRAVEL_OUT
         triggerETTO = false;
         ettoPulseEnd();
@@ -3413,14 +3776,16 @@ void timeTravel(bool doComplete, bool withSpeedo, bool forceNoLead)
 
             triggerP1 = true;
             triggerP1NoLead = doLeadLessP1;
+            ttSeqStart();
 
             speedo.setSpeed(timeTravelP0Speed);
             speedo.setBrightness(255);
             speedo.show();
             speedo.on();
-            timetravelP0Now = ttP0Now = ttUnivNow;
+            timetravelP0Now = ttUnivNow;
             timeTravelP0 = 1;
             timeTravelP2 = 0;
+            p0TimerStart(timeTravelP0Speed, timetravelP0Delay);
 
             #ifdef TC_HAVE_REMOTE
             // Set for polling BTTFN clients
@@ -3500,6 +3865,7 @@ void timeTravel(bool doComplete, bool withSpeedo, bool forceNoLead)
 
             ttUnivNow = millis();
             triggerETTONow = triggerP1Now = ttUnivNow;
+            ttSeqStart();
 
             // Set now to block input and other interfering actions.
             // Will be set to something valid in triggerLongTT().
@@ -3513,6 +3879,9 @@ void timeTravel(bool doComplete, bool withSpeedo, bool forceNoLead)
         #ifdef EXTERNAL_TIMETRAVEL_OUT
         triggerETTO = false;
         #endif
+        #ifdef TT_HAVE_SEQ
+        ttSeqStop();
+        #endif
         triggerLongTT(forceNoLead);
 
         return;
@@ -3638,68 +4007,277 @@ void timeTravel(bool doComplete, bool withSpeedo, bool forceNoLead)
     #endif
 }
 
-static void triggerLongTT(bool noLead)
+#ifdef TC_HAVESPEEDO
+/*
+ * P0 playback
+ *
+ * Runs in the esp_timer task and only advances p0TimerSpeed;
+ * time_loop() puts it on the speedo. Steps are due against 
+ * the start time; if we are late, steps are skipped rather 
+ * than delaying all following ones. 
+ * p0TimerRun is checked under p0TimerMux, so a callback 
+ * already running when the timer is stopped changes nothing.
+ */
+static void p0TimerCB(void *arg)
 {
-    if(playTTsounds) play_file( noLead ? "/travelstart2.mp3" : "/travelstart.mp3", 
-                                        PA_LINEOUT|PA_CHECKNM|PA_INTRMUS|PA_ALLOWSD|PA_DYNVOL,
-                                        TT_SOUND_FACT);
-    timetravelP1Now = millis();
-    timetravelP1Delay = noLead ? 0 : TT_P1_DELAY_P1;
-    timeTravelP1 = 1;
-    timeTravelP2 = 0;
+    int64_t now, toGo = 0;
+    uint8_t speed;
+
+    portENTER_CRITICAL(&p0TimerMux);
+
+    speed = p0TimerSpeed;
+    now = esp_timer_get_time();
+    
+    if(p0TimerRun && speed < 88 && now < p0TimerDue) {
+
+        // Early (stale arm from a previous run): Wait for due time
+        toGo = p0TimerDue - now;
+
+    } else if(p0TimerRun && speed < 88) {
+
+        speed++;
+        while(speed < 88) {
+            p0TimerDue += tt_p0_us[speed];
+            if(p0TimerDue > now) break;
+            speed++;
+        }
+
+        p0TimerSpeed = speed;
+
+        if(speed < 88) {
+            toGo = p0TimerDue - now;
+        }
+    }
+
+    portEXIT_CRITICAL(&p0TimerMux);
+
+    if(toGo) {
+        esp_timer_start_once(p0Timer, toGo);
+    }
 }
 
-#if (defined(TC_HAVEGPS) && defined(NOT_MY_RESPONSIBILITY)) || defined(TC_HAVE_RE) || defined(TC_HAVE_REMOTE)
-static void checkForSpeedTT(bool isFake, bool isRemote)
+static void p0TimerStart(uint8_t speed, unsigned long firstDelay)
 {
-    if(!GPSabove88) {
-        if(FPBUnitIsOn && !presentTime.getNightMode() &&
-           !startup && !timeTravelP0 && !timeTravelP1 && !timeTravelRE && !timeTravelP2) {
-            timeTravel(true, false, true);
-            GPSabove88 = true;
-            // If this is fake (ie using rotEnc+speedo), we 
-            // need to set this to trigger P2 at end of TT
-            #ifdef TC_HAVESPEEDO
-            if(isFake) timeTravelP0Speed = 88;
-            #ifdef TC_HAVE_REMOTE
-            remoteInducedTT = isRemote;
-            #endif
-            #endif
-        }
+    p0TimerStop();
+
+    portENTER_CRITICAL(&p0TimerMux);
+    p0TimerSpeed = speed;
+    p0TimerDue = esp_timer_get_time() + (int64_t)firstDelay * 1000;
+    p0TimerRun = !!p0Timer;
+    portEXIT_CRITICAL(&p0TimerMux);
+    
+    if(p0Timer) {
+        esp_timer_start_once(p0Timer, (uint64_t)firstDelay * 1000);
+    } else {
+        // No timer: Jump to 88
+        p0TimerSpeed = 88;
     }
 }
-#endif
 
-void send_refill_msg()
+static void p0TimerStop()
 {
-    #ifdef EXTERNAL_TIMETRAVEL_OUT
-    if(useETTO || bttfnHaveClients) {
-        sendNetWorkMsg("REFILL\0", 7, BTTFN_NOT_REFILL);
+    portENTER_CRITICAL(&p0TimerMux);
+    p0TimerRun = false;
+    portEXIT_CRITICAL(&p0TimerMux);
+    
+    if(p0Timer) {
+        esp_timer_stop(p0Timer);
     }
-    #endif
 }
+#endif
 
-void send_wakeup_msg()
+#ifdef TT_HAVE_SEQ
+/*
+ * Time travel sequence playback
+ *
+ * ttSeqStart() converts the lead times computed by timeTravel() 
+ * into absolute due times and arms ttSeqTimer for the earliest one.
+ * Without a timer, ttSeqCheck() fires the points when polled.
+ * 
+ * Firing a point, including raising the ETTO pulse, happens under 
+ * ttSeqMux, as does ttSeqStop(). So a callback that is running 
+ * while the sequence is cancelled either fires before (and the 
+ * caller's ettoPulseEnd() drops the pulse), or finds nothing armed.
+ */
+static void ttSeqFire(int idx, int64_t now)
 {
     #ifdef EXTERNAL_TIMETRAVEL_OUT
-    if(useETTO || bttfnHaveClients) {
-        sendNetWorkMsg("WAKEUP\0", 7, BTTFN_NOT_WAKEUP);
+    // Raise the wired ETTO pulse; gpio_set_level() is safe in a
+    // critical section (the debug output is in ttSeqCheck())
+    if(idx == TTS_ETTO && useETTOWired) {
+        gpio_set_level((gpio_num_t)EXTERNAL_TIMETRAVEL_OUT_PIN, 1);
     }
     #endif
+    ttSeqFiredAt[idx] = now;
+    ttSeqArmed[idx] = false;
+    ttSeqFired[idx] = true;
 }
 
-#ifdef EXTERNAL_TIMETRAVEL_OUT
-static void ettoPulseStart()
+// Returns time until the next armed point, 0 if none
+static int64_t ttSeqNext(int64_t now)
 {
-    if(useETTOWired) {
-        digitalWrite(EXTERNAL_TIMETRAVEL_OUT_PIN, HIGH);
-        #ifdef TC_DBG
+    int64_t next = 0;
+
+    for(int i = 0; i < TTS_NUM; i++) {
+        if(ttSeqArmed[i] && (!next || ttSeqDue[i] < next)) {
+            next = ttSeqDue[i];
+        }
+    }
+    if(!next) return 0;
+    
+    return (next > now + 50) ? next - now : 50;
+}
+
+// Runs in the esp_timer task
+static void ttSeqCB(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t toGo;
+
+    portENTER_CRITICAL(&ttSeqMux);
+    for(int i = 0; i < TTS_NUM; i++) {
+        if(ttSeqArmed[i] && ttSeqDue[i] <= now + 200) {
+            ttSeqFire(i, now);
+        }
+    }
+    toGo = ttSeqNext(now);
+    portEXIT_CRITICAL(&ttSeqMux);
+
+    if(toGo) {
+        esp_timer_start_once(ttSeqTimer, toGo);
+    }
+}
+
+static void ttSeqStart()
+{
+    int64_t now = esp_timer_get_time();
+    unsigned long mnow = millis();
+    int64_t toGo;
+
+    ttSeqStop();
+
+    if(!ttSeqTimer) {
+        const esp_timer_create_args_t seqArgs = {
+            .callback = &ttSeqCB,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "ttseq"
+        };
+        if(esp_timer_create(&seqArgs, &ttSeqTimer) != ESP_OK) {
+            ttSeqTimer = NULL;
+        }
+    }
+
+    portENTER_CRITICAL(&ttSeqMux);
+    ttSeqDue[TTS_P1] = now + (int64_t)(triggerP1LeadTime - (long)(mnow - triggerP1Now)) * 1000;
+    ttSeqArmed[TTS_P1] = triggerP1;
+    #ifdef EXTERNAL_TIMETRAVEL_OUT
+    ttSeqDue[TTS_ETTO] = now + (int64_t)(triggerETTOLeadTime - (long)(mnow - triggerETTONow)) * 1000;
+    ttSeqArmed[TTS_ETTO] = triggerETTO;
+    #endif
+    toGo = ttSeqNext(now);
+    portEXIT_CRITICAL(&ttSeqMux);
+
+    if(ttSeqTimer && toGo) {
+        // A callback left over from a previous sequence might 
+        // have re-armed the timer meanwhile
+        esp_timer_stop(ttSeqTimer);
+        esp_timer_start_once(ttSeqTimer, toGo);
+    }
+}
+
+static void ttSeqStop()
+{
+    portENTER_CRITICAL(&ttSeqMux);
+    for(int i = 0; i < TTS_NUM; i++) {
+        ttSeqArmed[i] = ttSeqFired[i] = false;
+    }
+    portEXIT_CRITICAL(&ttSeqMux);
+    
+    if(ttSeqTimer) {
+        esp_timer_stop(ttSeqTimer);
+    }
+}
+
+// True once the point has fired; late is the time since 
+// then (ms), ie our latency.
+static bool ttSeqCheck(int idx, long& late)
+{
+    int64_t now = esp_timer_get_time();
+    bool fired;
+
+    portENTER_CRITICAL(&ttSeqMux);
+    if(!ttSeqTimer && ttSeqArmed[idx] && ttSeqDue[idx] <= now) {
+        ttSeqFire(idx, now);
+    }
+    if((fired = ttSeqFired[idx])) {
+        ttSeqFired[idx] = false;
+        late = (long)((now - ttSeqFiredAt[idx]) / 1000);
+    }
+    portEXIT_CRITICAL(&ttSeqMux);
+
+    #if defined(EXTERNAL_TIMETRAVEL_OUT) && defined(TC_DBG)
+    if(fired && idx == TTS_ETTO && useETTOWired) {
         digitalWrite(WHITE_LED_PIN, HIGH);
-        Serial.printf("ETTO Start %d\n", millis());
-        #endif
+        Serial.printf("ETTO Start %d (%ldms ago)\n", millis(), late);
+    }
+    #endif
+    
+    return fired;
+}
+#endif
+
+static void triggerLongTT(bool noLead)
+{
+    if(playTTsounds) play_file( noLead ? "/travelstart2.mp3" : "/travelstart.mp3", 
+                                        PA_LINEOUT|PA_CHECKNM|PA_INTRMUS|PA_ALLOWSD|PA_DYNVOL,
+                                        TT_SOUND_FACT);
+    timetravelP1Now = millis();
+    timetravelP1Delay = noLead ? 0 : TT_P1_DELAY_P1;
+    timeTravelP1 = 1;
+    timeTravelP2 = 0;
+}
+
+#if (defined(TC_HAVEGPS) && defined(NOT_MY_RESPONSIBILITY)) || defined(TC_HAVE_RE) || defined(TC_HAVE_REMOTE)
+static void checkForSpeedTT(bool isFake, bool isRemote)
+{
+    if(!GPSabove88) {
+        if(FPBUnitIsOn && !presentTime.getNightMode() &&
+           !startup && !timeTravelP0 && !timeTravelP1 && !timeTravelRE && !timeTravelP2) {
+            timeTravel(true, false, true);
+            GPSabove88 = true;
+            // If this is fake (ie using rotEnc+speedo), we 
+            // need to set this to trigger P2 at end of TT
+            #ifdef TC_HAVESPEEDO
+            if(isFake) timeTravelP0Speed = 88;
+            #ifdef TC_HAVE_REMOTE
+            remoteInducedTT = isRemote;
+            #endif
+            #endif
+        }
+    }
+}
+#endif
+
+void send_refill_msg()
+{
+    #ifdef EXTERNAL_TIMETRAVEL_OUT
+    if(useETTO || bttfnHaveClients) {
+        sendNetWorkMsg("REFILL\0", 7, BTTFN_NOT_REFILL);
+    }
+    #endif
+}
+
+void send_wakeup_msg()
+{
+    #ifdef EXTERNAL_TIMETRAVEL_OUT
+    if(useETTO || bttfnHaveClients) {
+        sendNetWorkMsg("WAKEUP\0", 7, BTTFN_NOT_WAKEUP);
     }
+    #endif
 }
 
+#ifdef EXTERNAL_TIMETRAVEL_OUT
 static void ettoPulseStartNoLead()
 {
     if(useETTOWiredNoLead) {
@@ -3731,7 +4309,7 @@ static void sendNetWorkMsg(const char *pl, unsigned int len, uint8_t bttfnMsg, u
 {
     #ifdef TC_HAVEMQTT
     if(useMQTT && pubMQTT) {
-        mqttPublish("bttf/tcd/pub", pl, len);
+        mqttPublish("bttf/tcd/pub", pl, len, MQTT_PUB_QOS1);
         return;
     }
     #endif
@@ -3881,8 +4459,9 @@ bool currentlyOnTimeTravel()
  */
 void updatePresentTime(DateTime& dtu, DateTime& dtl)
 {
+    static uint64_t lastMins = UINT64_MAX;
+    static int year, month, day, hour, minute;
     uint64_t utcMins;
-    int year, month, day, hour, minute;
 
     if(!timeDifference) {
         presentTime.setDateTime(dtl);
@@ -3905,7 +4484,11 @@ void updatePresentTime(DateTime& dtu, DateTime& dtl)
         utcMins -= timeDifference;
     }
 
-    minsToDate(utcMins, year, month, day, hour, minute);
+    // Result only changes once per minute
+    if(utcMins != lastMins) {
+        minsToDate(utcMins, year, month, day, hour, minute);
+        lastMins = utcMins;
+    }
 
     presentTime.setFromParms(year, month, day, hour, minute);
 }
@@ -3962,17 +4545,8 @@ void fpbKeyLongPressStop()
  */
 static void myIntroDelay(unsigned int mydel, bool withGPS)
 {
-    unsigned long startNow = millis();
-    while(millis() - startNow < mydel) {
-        delay((mydel > 100) ? 10 : 5);    // delay(5) does not allow for UDP traffic
-        audio_loop();
-        ntp_short_loop();
-        bttfn_loop();
-        #if defined(TC_HAVEGPS) || defined(TC_HAVE_RE)
-        if(withGPS) gps_loop();
-        #endif
-        if(withGPS) wifi_loop();
-    }
+    // delay(5) does not allow for UDP traffic
+    schedWait(mydel, withGPS ? SC_INTRO : SC_INTNG, (mydel > 100) ? 10 : 5);
 }
 
 /*
@@ -3984,14 +4558,7 @@ static void waitAudioDoneIntro()
     int timeout = 100;
 
     while(!checkAudioDone() && timeout--) {
-        audio_loop();
-        ntp_short_loop();
-        bttfn_loop();
-        #if defined(TC_HAVEGPS) || defined(TC_HAVE_RE)
-        gps_loop();
-        #endif
-        wifi_loop();
-        audio_loop();
+        schedRun(SC_INTRO);
         delay(10);
     }
 }
@@ -4003,13 +4570,7 @@ static void waitAudioDoneIntro()
  */
 static void myCustomDelay_int(unsigned long mydel, uint32_t gran)
 {
-    unsigned long startNow = millis();
-    audio_loop();
-    while(millis() - startNow < mydel) {
-        delay(gran);
-        audio_loop();
-        ntp_short_loop();
-    }
+    schedWait(mydel, SC_SHORT, gran);
 }
 static void myCustomDelay_Sens(unsigned long mydel)
 {
@@ -4030,12 +4591,7 @@ void myCustomDelay_KP(unsigned long mydel)
  */
 void mydelay(unsigned long mydel)
 {
-    unsigned long startNow = millis();
-    myloops(false);
-    while(millis() - startNow < mydel) {
-        delay(5);
-        myloops(false);
-    }
+    schedWait(mydel, SC_DELAY);
 }
 
 void waitAudioDone()
@@ -4049,18 +4605,158 @@ void waitAudioDone()
     }
 }
 
+/*
+ * Power governor
+ *
+ * Demand is collected from the subsystems every PWR_EVAL_INT ms:
+ * User input (for PWR_INPUT_HOLD), audio, time travel/animations
+ * and an active web portal need full CPU speed (240MHz); WiFi, 
+ * BTTFN clients, GPS and MQTT are served at 160MHz; without any 
+ * demand, the CPU runs at 80MHz. With TC_PWR_NAP, the ESP is then 
+ * put to light sleep in short naps between SQW ticks.
+ * WiFi modem sleep is allowed while nobody expects quick network
+ * responses (portal, BTTFN, MQTT).
+ * Going up is immediate through pwrNeedFullNow().
+ */
+
+static void pwrSetState(uint8_t newState, unsigned long now, bool force = false)
+{
+    if(newState == pwrState && !force)
+        return;
+
+    pwrStateMs[pwrState] += now - pwrStateNow;
+    pwrStateNow = now;
+
+    if(force || pwrMHz[newState] != pwrMHz[pwrState]) {
+        setCpuFrequencyMhz(pwrMHz[newState]);
+    }
+    pwrState = newState;
+
+    #ifdef TC_DBG
+    Serial.printf("Power state %d, CPU speed %d\n", pwrState, getCpuFrequencyMhz());
+    #endif
+}
+
+static uint16_t pwrDemand(unsigned long now)
+{
+    uint16_t demand = 0;
+
+    if(now - pwrFullNow < PWR_INPUT_HOLD)
+        demand |= PWR_DEM_INPUT;
+    if(!checkAudioDone())
+        demand |= PWR_DEM_AUDIO;
+    if(startup || timeTravelP0 || timeTravelP1 || timeTravelRE || timeTravelP2 || anim_active())
+        demand |= PWR_DEM_ANIM;
+    if(wifiPortalBusy())
+        demand |= PWR_DEM_PORTAL;
+    if(!(wifiIsOff || wifiAPIsOff))
+        demand |= PWR_DEM_WIFI;
+    if(bttfnHaveClients)
+        demand |= PWR_DEM_BTTFN;
+    #ifdef TC_HAVEGPS
+    if(useGPS)
+        demand |= PWR_DEM_GPS;
+    #endif
+    #ifdef TC_HAVEMQTT
+    if(useMQTT)
+        demand |= PWR_DEM_MQTT;
+    #endif
+
+    return demand;
+}
+
+#ifdef TC_PWR_NAP
+// Light sleep until shortly before the next SQW edge
+// (they come every 500ms), or for PWR_NAP_MAX ms, 
+// whatever is shorter.
+static void pwrNap()
+{
+    int64_t edgeUs, nowUs = esp_timer_get_time();
+    int64_t left;
+
+    sqwGetEdge(&edgeUs);
+
+    if(nowUs - edgeUs > 1100000) {
+        // No SQW
+        left = PWR_NAP_MAX * 1000;
+    } else {
+        left = edgeUs + 500000 - PWR_NAP_GUARD * 1000 - nowUs;
+        if(left < 2000) return;
+        if(left > PWR_NAP_MAX * 1000) left = PWR_NAP_MAX * 1000;
+    }
+
+    esp_sleep_enable_timer_wakeup(left);
+    esp_light_sleep_start();
+
+    pwrSleptUs += esp_timer_get_time() - nowUs;
+}
+#endif
+
+void pwr_loop()
+{
+    unsigned long now = millis();
+    uint16_t demand;
+    uint8_t newState;
+
+    if(now - pwrLastEval < PWR_EVAL_INT) {
+        #ifdef TC_PWR_NAP
+        if(pwrState == PWR_NAP) pwrNap();
+        #endif
+        return;
+    }
+    pwrLastEval = now;
+
+    demand = pwrDemand(now);
+
+    if(demand & PWR_DEM_FULL) {
+        newState = PWR_FULL;
+    } else if(demand) {
+        newState = PWR_MID;
+    } else {
+        #ifdef TC_PWR_NAP
+        newState = PWR_NAP;
+        #else
+        newState = PWR_LOW;
+        #endif
+    }
+    
+    pwrSetState(newState, now);
+
+    wifiSetModemSleep(!(demand & (PWR_DEM_PORTAL|PWR_DEM_BTTFN|PWR_DEM_MQTT)));
+}
+
 // Call this to get full CPU speed
+// (If called from the audio task, the governor picks up
+// the demand with its next evaluation.)
 void pwrNeedFullNow(bool force)
 {
-    if(pwrLow || force) {
-        setCpuFrequencyMhz(240);
-        #ifdef TC_DBG
-        Serial.print("Setting CPU speed to ");
-        Serial.println(getCpuFrequencyMhz());
-        #endif
+    unsigned long now = millis();
+    
+    pwrFullNow = now;
+    if(xPortGetCoreID() == ARDUINO_RUNNING_CORE) {
+        pwrSetState(PWR_FULL, now, force);
+    }
+}
+
+uint8_t pwrGetState()
+{
+    return pwrState;
+}
+
+// Seconds spent in each state; slept: seconds
+// actually spent in light sleep
+void pwrGetStats(uint32_t *secs, uint32_t& slept)
+{
+    for(int i = 0; i < PWR_NUM_ST; i++) {
+        uint64_t ms = pwrStateMs[i];
+        if(i == pwrState) ms += millis() - pwrStateNow;
+        secs[i] = ms / 1000;
     }
-    pwrFullNow = millis();
-    pwrLow = false;
+    #ifdef TC_PWR_NAP
+    slept = pwrSleptUs / 1000000;
+    #else
+    slept = 0;
+    #endif
 }
 
 /*
@@ -4071,21 +4767,94 @@ void pwrNeedFullNow(bool force)
  * which is interpreted as 2165/165/165 etc
  * Check for this and retry in case.)
  */
+static bool rtcReadBad(DateTime& dt)
+{
+    return (dt.month() < 1 || dt.month() > 12 ||
+            dt.day()   < 1 || dt.day()   > 31 ||
+            dt.hour() > 23 ||
+            dt.minute() < 0 || dt.minute() > 59);
+}
+
+// Add secs seconds to the cached time
+static void rtcExtrapolate(DateTime& dt, int secs)
+{
+    int year, month, day, hour, minute;
+    uint64_t mins = dateToMins(dt.year(), dt.month(), dt.day(), dt.hour(), dt.minute());
+    
+    secs += dt.second();
+    mins += secs / 60;
+    minsToDate(mins, year, month, day, hour, minute);
+    dt.set(year, month, day, hour, minute, secs % 60);
+}
+
 void myrtcnow(DateTime& dt)
 {
     int retries = 0;
+    int64_t now = (int64_t)micros64();
+    uint32_t edges = sqwEdges;
+    int64_t age = now - rtcCacheUs;
+
+    // The RTC's time only changes at an SQW edge; as long as
+    // none came since the last read, skip the i2c transfer.
+    if(rtcCacheValid && !rtcCacheStale && 
+       edges == rtcCacheEdges && rtc.adjustCount() == rtcCacheAdj &&
+       age < RTC_CACHE_MAXAGE) {
+        dt = rtcCache;
+        dt.hwRTCYear = dt.year();
+        dt.setYear(dt.hwRTCYear - presentTime.getYearOffset());
+        return;
+    }
 
     rtc.now(dt);
 
-    while ((dt.month() < 1 || dt.month() > 12 ||
-            dt.day()   < 1 || dt.day()   > 31 ||
-            dt.hour() > 23 ||
-            dt.minute() < 0 || dt.minute() > 59) &&
-            retries < 30 ) {
-
+    if(rtcReadBad(dt)) {
+        // Bad read: If we have a recent good one, extrapolate
+        // from there and try again on the next call instead
+        // of stalling the loop here.
+        if(rtcCacheValid && rtc.adjustCount() == rtcCacheAdj && 
+           age < RTC_EXTRAP_MAXAGE) {
+            dt = rtcCache;
+            rtcExtrapolate(dt, (int)((age + 500000) / 1000000));
+            rtcCacheStale = true;
+            dt.hwRTCYear = dt.year();
+            dt.setYear(dt.hwRTCYear - presentTime.getYearOffset());
+            #ifdef TC_DBG
+            Serial.println(F("myrtcnow: Bad RTC read, extrapolating"));
+            #endif
+            return;
+        }
+        STALL_ENTER("rtcretry");
+        while(rtcReadBad(dt) && retries < 30) {
             mydelay((retries < 5) ? 50 : 100);
             rtc.now(dt);
             retries++;
+        }
+        STALL_LEAVE();
+    }
+
+    #ifdef TC_DBG
+    // Check that RTC and esp_timer agree
+    if(rtcCacheValid && !retries && rtc.adjustCount() == rtcCacheAdj && 
+       age < RTC_EXTRAP_MAXAGE) {
+        DateTime ex = rtcCache;
+        rtcExtrapolate(ex, (int)((age + 500000) / 1000000));
+        int dd = abs((dt.minute() * 60 + dt.second()) - (ex.minute() * 60 + ex.second()));
+        if(dd > 1 && dd < 3599) {
+            Serial.printf("myrtcnow: RTC drifted from timer: %d:%02d vs %d:%02d\n",
+                  dt.minute(), dt.second(), ex.minute(), ex.second());
+        }
+    }
+    #endif
+
+    if(!rtcReadBad(dt)) {
+        rtcCache = dt;
+        rtcCacheValid = true;
+        rtcCacheStale = false;
+        rtcCacheEdges = edges;
+        rtcCacheAdj = rtc.adjustCount();
+        rtcCacheUs = now;
+    } else {
+        rtcCacheValid = false;
     }
 
     dt.hwRTCYear = dt.year();
@@ -4097,19 +4866,119 @@ void myrtcnow(DateTime& dt)
 }
 
 /*
- * millis64() - 64bit millis()
- * 
+ * Wait until micros64() reaches target; used to hit 
+ * second boundaries when setting the RTC
  */
-uint64_t millis64()
+static void waitUntilUs(uint64_t target)
+{
+    uint64_t now = micros64();
+
+    // mydelay() may overshoot by a gps_loop() run
+    if(target > now + 25000) {
+        mydelay((target - now - 25000) / 1000);
+    }
+    while(micros64() < target) { }
+}
+
+/*
+ * Set the RTC to the given UTC time at micros64() time atUs, 
+ * which is a second boundary of the time source. Sets yearOffs
+ * (but does not save it to NVM). dt is set to the given time.
+ * If defer is false, this waits for atUs. Otherwise the write 
+ * is left to rtcSetPoll() from time_loop(); dt is then ahead 
+ * of the RTC by the rest of the current second.
+ */
+static void rtcSetAt(uint64_t atUs, bool defer, DateTime& dt,
+                     int year, int month, int day, int hour, int minute, int second)
+{
+    uint16_t rtcYear = year;
+    int16_t  rtcYOffs = 0;
+
+    // Get RTC-fit year & offs for given real year
+    correctYr4RTC(rtcYear, rtcYOffs);
+
+    dt.hwRTCYear = rtcYear;
+    dt.set(year, month, day, hour, minute, second);
+
+    rtcSetY = year;   rtcSetM = month;    rtcSetD = day;
+    rtcSetH = hour;   rtcSetMin = minute; rtcSetS = second;
+    rtcSetAtUs = atUs;
+    rtcSetAdjCnt = rtc.adjustCount();
+    rtcSetPending = true;
+
+    if(!defer) {
+        while(rtcSetPending) {
+            waitUntilUs(rtcSetAtUs);
+            rtcSetPoll();
+        }
+    }
+}
+
+/*
+ * Carry out a scheduled RTC write once its second boundary has
+ * (almost) arrived. If we are too late, the next boundary is used.
+ * A write is dropped if the RTC was adjusted otherwise meanwhile.
+ */
+static void rtcSetPoll()
 {
-    unsigned long millisNow64 = millis();
+    int64_t toGo;
     
-    if(millisNow64 < lastMillis64) {
-        millisEpoch += 0x100000000;
+    if(!rtcSetPending)
+        return;
+
+    if(rtc.adjustCount() != rtcSetAdjCnt) {
+        rtcSetPending = false;
+        return;
+    }
+    
+    toGo = (int64_t)(rtcSetAtUs - micros64());
+
+    if(toGo < -RTC_SET_LATE_US) {
+        int late = (int)((-toGo + 999999) / 1000000);
+        rtcSetAtUs += late * 1000000ULL;
+        rtcSetS += late;
+        convTime(-(rtcSetS / 60), rtcSetY, rtcSetM, rtcSetD, rtcSetH, rtcSetMin);
+        rtcSetS %= 60;
+        toGo = (int64_t)(rtcSetAtUs - micros64());
     }
-    lastMillis64 = millisNow64;
 
-    return millisEpoch | (uint64_t)millisNow64;
+    if(toGo > RTC_SET_SPIN_US)
+        return;
+
+    while(micros64() < rtcSetAtUs) { }
+
+    uint16_t rtcYear = rtcSetY;
+    int16_t  rtcYOffs = 0;
+    correctYr4RTC(rtcYear, rtcYOffs);
+
+    rtc.adjust(rtcSetS,
+               rtcSetMin,
+               rtcSetH,
+               dayOfWeek(rtcSetD, rtcSetM, rtcSetY),
+               rtcSetD,
+               rtcSetM,
+               rtcYear - 2000);
+
+    presentTime.setYearOffset(rtcYOffs);
+
+    rtcSetPending = false;
+}
+
+/*
+ * micros64(), millis64() - 64bit monotonic time
+ * 
+ * Both are derived from the 64bit esp_timer, so there 
+ * is no wrap-around to track (and no need to call 
+ * them regularly).
+ */
+uint64_t micros64()
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+uint64_t millis64()
+{
+    return (uint64_t)esp_timer_get_time() / 1000ULL;
 }
 
 /*
@@ -4143,15 +5012,23 @@ bool isWcMode()
  */
 void setDatesTimesWC(DateTime& dtu)
 {
-    DateTime dtl;
+    DateTime dtl1, dtl2;
+    DateTime *dtls[3] = { NULL, NULL, NULL };
 
-    if(WcHaveTZ1) {
-        UTCtoLocal(dtu, dtl, 1);
-        destinationTime.setFromParms(dtl.year(), dtl.month(), dtl.day(), dtl.hour(), dtl.minute());
+    if(WcHaveTZ1) dtls[1] = &dtl1;
+    if(WcHaveTZ2) dtls[2] = &dtl2;
+    
+    UTCtoLocalBatch(dtu, dtls);
+    setDatesTimesWCFrom(dtls);
+}
+
+static void setDatesTimesWCFrom(DateTime *dtls[3])
+{
+    if(dtls[1]) {
+        destinationTime.setFromParms(dtls[1]->year(), dtls[1]->month(), dtls[1]->day(), dtls[1]->hour(), dtls[1]->minute());
     }
-    if(WcHaveTZ2) {
-        UTCtoLocal(dtu, dtl, 2);
-        departedTime.setFromParms(dtl.year(), dtl.month(), dtl.day(), dtl.hour(), dtl.minute());
+    if(dtls[2]) {
+        departedTime.setFromParms(dtls[2]->year(), dtls[2]->month(), dtls[2]->day(), dtls[2]->hour(), dtls[2]->minute());
     }
 }
 
@@ -4205,9 +5082,25 @@ static void updateTemperature(bool force)
         tui = 5 * 1000;
     }
         
-    if(force || (now - tempReadNow >= tui)) {
-        tempSens.readTemp(tempUnit);
-        tempReadNow = now;
+    i2c_poll_period(I2C_POLL_TEMP, tui);
+
+    // Never wait for the sensor's conversion; if it isn't
+    // finished, retry in a later loop iteration.
+    if(force || (tempSens.poll() && i2c_poll(I2C_POLL_TEMP))) {
+        if(tempSens.poll()) {
+            STALL_ENTER("tempsens");
+            tempSens.collect(tempUnit);
+            STALL_LEAVE();
+            if(!tempSens.lastTempNan()) {
+                tempHist.add((int32_t)lroundf(tempSens.readLastTemp() * 100.0f));
+                if(tempSens.haveHum() && tempSens.readHum() >= 0) {
+                    humHist.add(tempSens.readHum());
+                }
+            }
+            if(force) i2c_poll_reset(I2C_POLL_TEMP, tui);
+        } else {
+            i2c_poll_reset(I2C_POLL_TEMP, 0);
+        }
     }
 }
 #endif
@@ -4244,7 +5137,7 @@ static void dispGPSSpeed(bool force)
             } else if(now - lastRemSpdUpd > remSpdCatchUpDelay) {
                 if(speedoSpeed < gpsSpeed) {
                     remSpdCatchUpDelay = (speedoSpeed < 88) ?
-                              (unsigned long)(((float)(tt_p0_delays[speedoSpeed])) / ttP0TimeFactor) : 40;
+                              tt_p0_us[speedoSpeed] / 1000 : 40;
                     speedoSpeed++;
                 } else {
                     remSpdCatchUpDelay = 40;
@@ -4376,15 +5269,71 @@ static void dispIdleZero(bool force)
 #endif
 #endif  // TC_HAVESPEEDO
 #ifdef TC_HAVE_REMOTE
-static void updAndDispRemoteSpeed()
+static void remSpdAdd(int64_t us, uint8_t spd)
 {
-    unsigned long now = millis();
+    if(remSpdNum) {
+        // Packets arriving in a burst were sent apart
+        int64_t prev = remSpdHist[(remSpdIdx - 1) & (REM_SPD_SAMPLES - 1)].us;
+        if(us - prev < REM_SPD_MIN_GAP) us = prev + REM_SPD_MIN_GAP;
+    }
     
-    // Look at bttfnRemCurSpd (curr. displayed) and bttfnRemoteSpeed (displayed on remote)
-    // and also bttfnRemStop (if true, the brake is on)
+    remSpdHist[remSpdIdx].us = us;
+    remSpdHist[remSpdIdx].spd = spd;
+    remSpdIdx = (remSpdIdx + 1) & (REM_SPD_SAMPLES - 1);
+    if(remSpdNum < REM_SPD_SAMPLES) remSpdNum++;
+}
 
-    if(!bttfnRemoteSpeedMaster)
-        return;
+// Speed at playout time
+static uint8_t remSpdPredict()
+{
+    int64_t t = esp_timer_get_time() - REM_SPD_PLAYOUT;
+    remSpdSample *n, *o;
+    int32_t s;
+
+    if(!remSpdNum)
+        return bttfnRemoteSpeed;
+
+    n = &remSpdHist[(remSpdIdx - 1) & (REM_SPD_SAMPLES - 1)];
+
+    if(t >= n->us) {
+        // Beyond newest sample: Extrapolate
+        if(remSpdNum < 2 || t - n->us > REM_SPD_EXTRAP)
+            return n->spd;
+        o = &remSpdHist[(remSpdIdx - 2) & (REM_SPD_SAMPLES - 1)];
+        s = (int32_t)(((int64_t)(n->spd - o->spd) * (t - n->us)) / (n->us - o->us));
+        if(s > REM_SPD_EXTRAP_MAX) s = REM_SPD_EXTRAP_MAX;
+        else if(s < -REM_SPD_EXTRAP_MAX) s = -REM_SPD_EXTRAP_MAX;
+        s += n->spd;
+    } else {
+        // Find samples around t and interpolate
+        for(int i = 2; ; i++) {
+            o = &remSpdHist[(remSpdIdx - i) & (REM_SPD_SAMPLES - 1)];
+            if(i > remSpdNum) {
+                return n->spd;
+            }
+            if(o->us <= t)
+                break;
+            n = o;
+        }
+        s = o->spd + (int32_t)(((int64_t)(n->spd - o->spd) * (t - o->us)) / (n->us - o->us));
+    }
+
+    if(s < 0) s = 0;
+    else if(s > 88) s = 88;
+
+    return (uint8_t)s;
+}
+
+static void updAndDispRemoteSpeed()
+{
+    unsigned long now = millis();
+    uint8_t targetSpd = remSpdPredict();
+    
+    // Look at bttfnRemCurSpd (curr. displayed) and bttfnRemoteSpeed (displayed on remote)
+    // and also bttfnRemStop (if true, the brake is on)
+
+    if(!bttfnRemoteSpeedMaster)
+        return;
 
     // To avoid speed-jumps after a tt (such as in the case of the remote's brake being
     // hit while the TCD performs a tt), we do not adapt the "car"-speed to the remote 
@@ -4405,17 +5354,17 @@ static void updAndDispRemoteSpeed()
                         lastRemSpdUpd = now;
                     }
                 }            
-            } else if(bttfnRemCurSpd != bttfnRemoteSpeed) {
+            } else if(bttfnRemCurSpd != targetSpd) {
                 if(now - lastRemSpdUpd > remSpdCatchUpDelay) {
-                    if(bttfnRemCurSpd < bttfnRemoteSpeed) {
+                    if(bttfnRemCurSpd < targetSpd) {
                         bttfnRemCurSpd++;
                         if(bttfnRemCurSpd < 88) {
-                            float nD = (float)tt_p0_delays[bttfnRemCurSpd]; // 4.2
-                            int sD = bttfnRemoteSpeed - bttfnRemCurSpd;
-                            if(sD > 4)      nD /= 4.2;
-                            else if(sD > 1) nD /= (float)sD;
-                            else            nD /= 2.0;
-                            remSpdCatchUpDelay = (unsigned long)nD;
+                            unsigned long nD = tt_p0_delays[bttfnRemCurSpd];
+                            int sD = targetSpd - bttfnRemCurSpd;
+                            if(sD > 4)      nD = (nD * 10) / 42;  // 4.2
+                            else if(sD > 1) nD /= sD;
+                            else            nD /= 2;
+                            remSpdCatchUpDelay = nD;
                         } else {
                             remSpdCatchUpDelay = 40;
                         }
@@ -4501,53 +5450,60 @@ void re_vol_reset()
 #endif
 
 // Called before reboot to save regardless of running delay
+// and checkpoint quiet period
 void flushDelayedSave()
 {
-    presentTime.saveClockStateData(lastYear);
+    presentTime.saveClockStateData(lastYear, true);
 
-    presentTime.saveFlush();
-    destinationTime.saveFlush();
-    departedTime.saveFlush();
-                
-    if(volChanged) {
-        volChanged = false;
-        saveCurVolume();
-    }
+    presentTime.saveFlush(true);
+    destinationTime.saveFlush(true);
+    departedTime.saveFlush(true);
+
+    flushSecSettings(true);
 }
 
 /*
  * Display helpers
  */
 // Show all, month after a short delay
-void animate(bool withLEDs)
+static bool animWithLEDs = false;
+
+static void animateStep(int step)
 {
-    #ifdef TC_HAVETEMP
-    if(isRcMode() && (!isWcMode() || !WcHaveTZ1)) {
-            destinationTime.showTempDirect(tempSens.readLastTemp(), tempUnit, true);
-    } else
-    #endif
-        destinationTime.showAnimate1();
+    allHoldFrames();
 
-    presentTime.showAnimate1();
+    if(!step) {
 
-    #ifdef TC_HAVETEMP
-    if(isRcMode()) {
-        if(isWcMode() && WcHaveTZ1) {
-            departedTime.showTempDirect(tempSens.readLastTemp(), tempUnit, true);
-        } else if(!isWcMode() && tempSens.haveHum()) {
-            departedTime.showHumDirect(tempSens.readHum(), true);
-        } else {
+        #ifdef TC_HAVETEMP
+        if(isRcMode() && (!isWcMode() || !WcHaveTZ1)) {
+                destinationTime.showTempDirect(tempSens.readLastTemp(), tempUnit, true);
+        } else
+        #endif
+            destinationTime.showAnimate1();
+
+        presentTime.showAnimate1();
+
+        #ifdef TC_HAVETEMP
+        if(isRcMode()) {
+            if(isWcMode() && WcHaveTZ1) {
+                departedTime.showTempDirect(tempSens.readLastTemp(), tempUnit, true);
+            } else if(!isWcMode() && tempSens.haveHum()) {
+                departedTime.showHumDirect(tempSens.readHum(), true);
+            } else {
+                departedTime.showAnimate1();
+            }
+        } else
+        #endif
             departedTime.showAnimate1();
+
+        allCommitFrames();
+
+        if(animWithLEDs) {
+            leds_on();
         }
-    } else
-    #endif
-        departedTime.showAnimate1();
 
-    if(withLEDs) {
-        leds_on();
+        return;
     }
-        
-    mydelay(80);
 
     #ifdef TC_HAVETEMP
     if(isRcMode() && (!isWcMode() || !WcHaveTZ1)) {
@@ -4570,6 +5526,20 @@ void animate(bool withLEDs)
     } else
     #endif
         departedTime.showAnimate2();
+
+    allCommitFrames();
+}
+
+// Runs as a timeline; returns after the first step
+// unless wait is set.
+void animate(bool withLEDs, bool wait)
+{
+    animWithLEDs = withLEDs;
+    anim_start(animateStep, 2, 80);
+
+    while(wait && anim_running(animateStep)) {
+        mydelay(5);
+    }
 }
 
 // Activate lamp test on all displays and turn on
@@ -4583,6 +5553,38 @@ void allLampTest()
     departedTime.lampTest();
 }
 
+// Hold back frames on all displays; allCommitFrames()
+// then sends them back-to-back
+#ifdef TC_HAVESPEEDO
+static bool speedoFrameHeld = false;
+#endif
+void allHoldFrames()
+{
+    destinationTime.holdFrame();
+    presentTime.holdFrame();
+    departedTime.holdFrame();
+    #ifdef TC_HAVESPEEDO
+    // Not during P0, speed steps are shown right away then
+    if(useSpeedo && !timeTravelP0) {
+        speedo.holdFrame();
+        speedoFrameHeld = true;
+    }
+    #endif
+}
+
+void allCommitFrames()
+{
+    destinationTime.commitFrame();
+    presentTime.commitFrame();
+    departedTime.commitFrame();
+    #ifdef TC_HAVESPEEDO
+    if(speedoFrameHeld) {
+        speedo.commitFrame();
+        speedoFrameHeld = false;
+    }
+    #endif
+}
+
 void allOff()
 {
     destinationTime.off();
@@ -4624,16 +5626,16 @@ static bool getNTPOrGPSTime(bool weHaveAuthTime, DateTime& dt)
     // This avoids a frozen display when WiFi reconnects.
     #ifdef TC_HAVEGPS
     if(gpsHaveTime() && wifiIsOff) {
-        if(getGPStime(dt)) return true;
+        if(getGPStime(dt, true)) return true;
     }
     #endif
 
     // Now try NTP
-    if(getNTPTime(weHaveAuthTime, dt)) return true;
+    if(getNTPTime(weHaveAuthTime, dt, true)) return true;
 
     // Again go for GPS, might have older timestamp
     #ifdef TC_HAVEGPS
-    return getGPStime(dt);
+    return getGPStime(dt, true);
     #else
     return false;
     #endif
@@ -4643,16 +5645,15 @@ static bool getNTPOrGPSTime(bool weHaveAuthTime, DateTime& dt)
  * Get UTC time from NTP
  * 
  * Saves time to RTC; sets yearOffs (but does not save it to NVM)
+ * If defer is true, the RTC is written by time_loop() on the next
+ * second boundary (see rtcSetAt()).
  * 
  * Does no re-tries in case NTPGetLocalTime() fails; this is
  * called repeatedly within a certain time window, so we can 
  * retry with a later call.
  */
-static bool getNTPTime(bool weHaveAuthTime, DateTime& dt)
+static bool getNTPTime(bool weHaveAuthTime, DateTime& dt, bool defer)
 {
-    uint16_t rtcYear;
-    int16_t  rtcYOffs = 0;
-
     if(settings.ntpServer[0] == 0) {
         return false;
     }
@@ -4662,7 +5663,7 @@ static bool getNTPTime(bool weHaveAuthTime, DateTime& dt)
     // Reconnect for only 3 mins, but only if the user configured
     // a WiFi network to connect to; do not start CP.
     // If we don't have authTime yet, connect for longer to avoid
-    // reconnects (aka frozen displays).
+    // frequent reconnects.
     // If WiFi is reconnected here, we won't have a valid time stamp
     // immediately. This will therefore fail the first time called.
     wifiOn(weHaveAuthTime ? 3*60*1000 : 21*60*1000, false, true);    
@@ -4670,26 +5671,13 @@ static bool getNTPTime(bool weHaveAuthTime, DateTime& dt)
     if(WiFi.status() == WL_CONNECTED) {
 
         int nyear, nmonth, nday, nhour, nmin, nsecond;
+        uint64_t atUs;
 
-        if(NTPGetUTC(nyear, nmonth, nday, nhour, nmin, nsecond)) {
-            
-            // Get RTC-fit year plus offs for given real year
-            rtcYear = nyear;
-            correctYr4RTC(rtcYear, rtcYOffs);
-    
-            rtc.adjust(nsecond,
-                       nmin,
-                       nhour,
-                       dayOfWeek(nday, nmonth, nyear),
-                       nday,
-                       nmonth,
-                       rtcYear - 2000);
-
-            presentTime.setYearOffset(rtcYOffs);
-
-            dt.hwRTCYear = rtcYear;
-            dt.set(nyear, nmonth, nday, 
-                   nhour, nmin,   nsecond);
+        // Set RTC on the next second boundary, so that 
+        // the RTC's second starts in phase with NTP
+        if(NTPGetUTC(nyear, nmonth, nday, nhour, nmin, nsecond, &atUs)) {
+
+            rtcSetAt(atUs, defer, dt, nyear, nmonth, nday, nhour, nmin, nsecond);
     
             #ifdef TC_DBG
             Serial.printf("getNTPTime: %d-%02d-%02d %02d:%02d:%02d UTC\n", 
@@ -4722,56 +5710,51 @@ static bool getNTPTime(bool weHaveAuthTime, DateTime& dt)
  * Get UTC time from GPS
  * 
  * Saves time to RTC; sets yearOffs (but does not save it to NVM)
- * 
+ * If defer is true, the RTC is written by time_loop() on the next
+ * second boundary (see rtcSetAt()).
  */
 #ifdef TC_HAVEGPS
-static bool getGPStime(DateTime& dt)
+static bool getGPStime(DateTime& dt, bool defer)
 {
     struct tm timeinfo;
-    unsigned long stampAge = 0;
+    int64_t secStart, stampAge;
     int nyear, nmonth, nday, nhour, nminute, nsecond;
-    uint16_t rtcYear;
-    int16_t  rtcYOffs = 0;
    
     if(!useGPS)
         return false;
 
-    if(!myGPS.getDateTime(&timeinfo, &stampAge, GPSupdateFreq))
+    if(!myGPS.getDateTime(&timeinfo, &secStart))
         return false;
-            
-    // Correct UTC by stampAge
+
+    stampAge = (int64_t)micros64() - secStart;
+    if(stampAge < 0) stampAge = 0;
+
+    #ifdef TC_DBG
+    {
+        // Residual between GPS second and RTC's SQW edges
+        // (both edges are seen, so this is modulo 500ms)
+        int64_t edgeUs;
+        sqwGetEdge(&edgeUs);
+        Serial.printf("getGPStime: SQW edge offset to GPS second %d ms\n", 
+              (int)(((edgeUs - secStart) % 500000 + 500000) % 500000) / 1000);
+    }
+    #endif
 
     nyear = timeinfo.tm_year + 1900;
     nmonth = timeinfo.tm_mon + 1;
     nday = timeinfo.tm_mday;
     nhour = timeinfo.tm_hour;
     nminute = timeinfo.tm_min;
-    nsecond = timeinfo.tm_sec + (stampAge / 1000);
-    
-    if((stampAge % 1000) > 500) nsecond++;
+    nsecond = timeinfo.tm_sec + (int)(stampAge / 1000000) + 1;
     
     convTime(-(nsecond / 60), nyear, nmonth, nday, nhour, nminute);
 
     nsecond %= 60;
 
-    // Get RTC-fit year & offs for given real year
-    rtcYOffs = 0;
-    rtcYear = nyear;
-    correctYr4RTC(rtcYear, rtcYOffs);   
-
-    rtc.adjust(nsecond,
-               nminute,
-               nhour,
-               dayOfWeek(nday, nmonth, nyear),
-               nday,
-               nmonth,
-               rtcYear - 2000);
-
-    presentTime.setYearOffset(rtcYOffs);
-
-    dt.hwRTCYear = rtcYear;
-    dt.set(nyear, nmonth,  nday, 
-           nhour, nminute, nsecond);
+    // Set RTC on the next GPS second boundary, so
+    // that the RTC's second starts in phase
+    rtcSetAt(secStart + ((stampAge / 1000000) + 1) * 1000000, defer, dt,
+             nyear, nmonth, nday, nhour, nminute, nsecond);
 
     #ifdef TC_DBG
     Serial.printf("getGPStime: %d-%02d-%02d %02d:%02d:%02d UTC\n", 
@@ -4837,8 +5820,7 @@ static bool gpsHaveTime()
 void gps_loop(bool withRotEnc)
 {
     #ifdef TC_HAVEGPS
-    if(useGPS && (millis64() >= lastLoopGPS)) {
-        lastLoopGPS += (uint64_t)GPSupdateFreq;
+    if(useGPS && i2c_poll(I2C_POLL_GPS)) {
         myGPS.loop(false);
         #ifdef TC_HAVESPEEDO
         if(useGPSSpeed) dispGPSSpeed(true);
@@ -4862,801 +5844,38 @@ void gps_loop(bool withRotEnc)
 }
 #endif
 
-/*
- * Return doW from given date (year=yyyy)
- */
-#ifndef TC_JULIAN_CAL
-uint8_t dayOfWeek(int d, int m, int y)
-{
-    // Sakamoto's method
-    const int t[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
-    if(y > 0) {
-        if(m < 3) y -= 1;
-        return (y + y/4 - y/100 + y/400 + t[m-1] + d) % 7;
-    }
-    return (mon_yday[1][m-1] + d + 5) % 7;
-}
-#else
-uint8_t dayOfWeek(int d, int m, int y)
-{
-    const int t[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
-    const int u[] = { 5, 1, 0, 3, 5, 1, 3, 6, 2, 4, 0, 2 };
-    
-    // Sakamoto's method
-    if(((y << 16) | (m << 8) | d) > jSwitchHash) {
-        if(m < 3) y -= 1;
-        return (y + y/4 - y/100 + y/400 + t[m-1] + d) % 7;
-    }
-    // For Julian Calendar
-    if(y > 0) {
-        if(m < 3) y -= 1;
-        return (y + y/4 + u[m-1] + d) % 7;
-    }
-    return (mon_yday[1][m-1] + d + 3) % 7;
-}
-#endif
-
-/* 
- * Find number of days in a month 
- */
-int daysInMonth(int month, int year)
-{
-    if(month == 2 && isLeapYear(year)) {
-        return 29;
-    }
-    return monthDays[month - 1];
-}
-
-/* 
- * Determine if provided year is a leap year 
- */
-#ifndef TC_JULIAN_CAL 
-bool isLeapYear(int year)
-{
-    if((year & 3) == 0) { 
-        if((year % 100) == 0) {
-            if((year % 400) == 0) {
-                return true;
-            } else {
-                return false;
-            }
-        } else {
-            return true;
-        }
-    } else {
-        return false;
-    }
-}
-#else
-bool isLeapYear(int year)
-{
-    if((year & 3) == 0) {
-        if((year > jSwitchYear) && ((year % 100) == 0)) {
-            if((year % 400) == 0) {
-                return true;
-            } else {
-                return false;
-            }
-        } else {
-            return true;
-        }
-    } else {
-        return false;
-    }
-}
-#endif
-
-/*
- *  Convert a date into "minutes since 1/1/0 0:0"
- */
-#ifndef TC_JULIAN_CAL 
-uint64_t dateToMins(int year, int month, int day, int hour, int minute)
-{
-    uint64_t total64 = 0;
-    uint32_t total32 = 0;
-    int c = year, d = 0;        // ny0: d=1
-
-    if(year < 11000) {
-        total32 = hours1kYears[year / 500];
-        if(total32) d = (year / 500) * 500;
-    } else {
-        total32 = hours1kYears[(sizeof(hours1kYears)/sizeof(hours1kYears[0]))-1];
-        d = ((sizeof(hours1kYears)/sizeof(hours1kYears[0]))-1) * 500;
-    }
-
-    while(c-- > d) {
-        total32 += (isLeapYear(c) ? (8760+24) : 8760);
-    }
-    total32 += (mon_yday[isLeapYear(year) ? 1 : 0][month - 1] * 24);
-    total32 += (day - 1) * 24;
-    total32 += hour;
-    total64 = (uint64_t)total32 * 60;
-    total64 += minute;
-    return total64;
-}
-#else
-uint64_t dateToMins(int year, int month, int day, int hour, int minute)
-{
-    uint64_t total64 = 0;
-    uint32_t total32 = 0;
-    int c = year, d = 0;        // ny0: d=1
-
-    if(year < 11000) {
-        total32 = hours1kYears[year / 100];
-        if(total32) d = (year / 100) * 100;
-    } else {
-        total32 = hours1kYears[(sizeof(hours1kYears)/sizeof(hours1kYears[0]))-1];
-        d = ((sizeof(hours1kYears)/sizeof(hours1kYears[0]))-1) * 100;
-    }
-
-    if(c < jCentStart || c > jCentEnd) {
-        while(c-- > d) {
-            total32 += (isLeapYear(c) ? (8760+24) : 8760);
-        }
-        total32 += (mon_yday[isLeapYear(year) ? 1 : 0][month - 1] * 24);
-        total32 += (day - 1) * 24;
-    } else {
-        while(c-- > d) {
-            total32 += ((c == jSwitchYear) ? jSwitchYrHrs : (isLeapYear(c) ? (8760+24) : 8760));
-        }
-        if(year == jSwitchYear) {
-            total32 += (mon_yday_jSwitch[month - 1] * 24);
-            if(month == jSwitchMon) {
-                if(day <= jSwitchDay) {
-                    total32 += (day - 1) * 24;
-                } else if(day > jSwitchDay + jSwitchSkipD) {
-                    total32 += (day - jSwitchSkipD - 1) * 24;
-                } else {
-                    Serial.printf("Bad date!\n");
-                }
-            } else {
-                total32 += (day - 1) * 24;
-            }
-        } else {
-            total32 += (mon_yday[isLeapYear(year) ? 1 : 0][month - 1] * 24);
-            total32 += (day - 1) * 24;
-        }
-    }
-
-    total32 += hour;
-    total64 = (uint64_t)total32 * 60;
-    total64 += minute;
-    return total64;
-}
-#endif
-
-/*
- *  Convert "minutes since 1/1/0 0:0" into date
- */
-#ifndef TC_JULIAN_CAL
-void minsToDate(uint64_t total64, int& year, int& month, int& day, int& hour, int& minute)
-{
-    int c = 0, d = (sizeof(mins1kYears)/sizeof(mins1kYears[0]))-1;  // ny0: c=1
-    int temp;
-    uint32_t total32;
-
-    year = 0;             // ny0: 1
-    month = day = 1;
-    hour = minute = 0;
-
-    while(d >= 0) {
-        if(total64 > mins1kYears[d]) break;
-        d--;
-    }
-    if(d > 0) {
-        total64 -= mins1kYears[d];
-        c = year = d * 500;
-    }
-
-    total32 = total64;
-
-    while(1) {
-        temp = isLeapYear(c++) ? ((8760+24)*60) : (8760*60);
-        if(total32 < temp) break;
-        year++;
-        total32 -= temp;
-    }
-
-    c = 1;
-    temp = isLeapYear(year) ? 1 : 0;
-    while(c < 12) {
-        if(total32 < (mon_ydayt24t60[temp][c])) break;
-        c++;
-    }
-    month = c;
-    total32 -= (mon_ydayt24t60[temp][c-1]);
-
-    temp = total32 / (24*60);
-    day = temp + 1;
-    total32 -= (temp * (24*60));
-
-    temp = total32 / 60;
-    hour = temp;
-
-    minute = total32 - (temp * 60);
-}
-#else
-void minsToDate(uint64_t total64, int& year, int& month, int& day, int& hour, int& minute)
-{
-    int c = 0, d = (sizeof(mins1kYears)/sizeof(mins1kYears[0]));    // ny0: c=1
-    int temp;
-    uint32_t total32;
-    
-    year = 0;             // ny0: 1
-    month = day = 1;
-    hour = minute = 0;
-  
-    d = (total64 < mins1kYears[d/2]) ? d / 2 : d - 1;
-
-    while(d >= 0) {
-        if(total64 > mins1kYears[d]) break;
-        d--;
-    }
-    if(d > 0) {
-        total64 -= mins1kYears[d];
-        c = year = d * 100;
-    }
-    
-    total32 = total64;
-
-    if(c < jCentStart || c > jCentEnd) {
-        while(1) {
-            temp = isLeapYear(c++) ? ((8760+24)*60) : (8760*60);
-            if(total32 < temp) break;
-            year++;
-            total32 -= temp;
-        }
-    } else {
-        while(1) {
-            temp = ((c == jSwitchYear) ? jSwitchYrHrs : (isLeapYear(c) ? (8760+24) : 8760)) * 60;
-            if(total32 < temp) break;
-            c++;
-            year++;
-            total32 -= temp;
-        }
-    }
-
-    c = 1;
-    if(year == jSwitchYear) {
-        while(c < 12) {
-            if(total32 < (mon_ydayt24t60J[c])) break;
-            c++;
-        }
-        month = c;
-        total32 -= (mon_ydayt24t60J[c-1]);
-  
-        temp = total32 / (24*60);
-        day = temp + 1;
-        if(month == jSwitchMon && day > jSwitchDay) {
-            day += jSwitchSkipD;
-        }
-    } else {      
-        temp = isLeapYear(year) ? 1 : 0;
-        while(c < 12) {
-            if(total32 < (mon_ydayt24t60[temp][c])) break;
-            c++;
-        }
-        month = c;
-        total32 -= (mon_ydayt24t60[temp][c-1]);
-
-        temp = total32 / (24*60);
-        day = temp + 1;
-    }
-    total32 -= (temp * (24*60));
-    
-    temp = total32 / 60;
-    hour = temp;
-
-    minute = total32 - (temp * 60);
-}
-#endif
-
 uint32_t getHrs1KYrs(int index)
 {
     return hours1kYears[index*2];
 }
 
-#ifdef TC_JULIAN_CAL
-static void calcJulianData()
-{
-    int l = isLeapYear(jSwitchYear) ? 1 : 0;
-  
-    for(int i = 0; i < 13; i++) {
-        mon_yday_jSwitch[i] = mon_yday[l][i];
-    }
-    for(int i = jSwitchMon; i < 13; i++) {
-        mon_yday_jSwitch[i] -= jSwitchSkipD;
-    }
-    for(int i = 0; i < 13; i++) {
-        mon_ydayt24t60J[i] = mon_yday_jSwitch[i] * 24 * 60;
-    }
-    
-    jSwitchYrHrs = (l ? (8760+24) : 8760) - jSwitchSkipH;
-
-    jSwitchHash = (jSwitchYear << 16) | (jSwitchMon << 8) | jSwitchDay;
-} 
-
-void correctNonExistingDate(int year, int month, int& day)
-{
-  if(year == jSwitchYear && month == jSwitchMon) {
-      if((day > jSwitchDay) && (day <= jSwitchDay + jSwitchSkipD)) {
-          day = jSwitchDay + jSwitchSkipD + 1;
-      }
-  }
-}
-#endif
-
-/*
- * Return RTC-fit year & offs for given real year
- */
-void correctYr4RTC(uint16_t& year, int16_t& offs)
-{
-    offs = 0;
-    if(year >= 2000 && year <= 2098) return;
-    
-    if(isLeapYear(year)) {
-        offs = 2000 - year;
-        year = 2000;
-    } else {
-        offs = 2001 - year;
-        year = 2001;
-    }
-}
-
 /**************************************************************
  ***                                                        ***
  ***               Timezone and DST handling                ***
  ***                                                        ***
  **************************************************************/
 
-/*
- * Parse integer
- */
-static char *parseInt(char *t, int& it)
-{
-    bool isNeg = false;
-    it = 0;
-    
-    if(*t == '-') {
-        t++;
-        isNeg = true;
-    } else if(*t == '+') {
-        t++;
-    }
-    
-    if(*t < '0' || *t > '9') return NULL;
-    
-    while(*t >= '0' && *t <= '9') {
-        it *= 10;
-        it += (*t++ - '0');
-    }
-    if(isNeg) it *= -1;
-
-    return t;
-}
-
-/*
- * Parse DST parts of TZ string
- */
-static char *parseDST(char *t, int& DSTyear, int& DSTmonth, int& DSTday, int& DSThour, int& DSTmin, int currYear, int correction)
+static const char *tzString(int index)
 {
-    char *u;
-    int it, tw, dow;
-
-    DSTyear = currYear;
-    DSTmin = 0;
-    
-    if(*t == 'M') {
-        t++;
-        u = parseInt(t, it);
-        if(!u) return NULL;
-        if(it >= 1 && it <= 12) DSTmonth = it;
-        else                    return NULL;
-            
-        t = u;
-        if(*t++ != '.') return NULL;
-        
-        u = parseInt(t, it);
-        if(!u) return NULL;
-        if(it < 1 || it > 5) return NULL;
-        tw = it;
-        
-        t = u;        
-        if(*t++ != '.') return NULL;
-        
-        u = parseInt(t, it);
-        if(!u) return NULL;
-        if(it < 0 || it > 6) return NULL;
-
-        t = u;
-        
-        // it = weekday (0=Su), tw = week (1,2,3,4=nth week; 5=last)
-        dow = dayOfWeek(1, DSTmonth, currYear);
-        if(dow == 0) dow = 7;
-        DSTday = (it+1) - dow;
-        if(DSTday < 1) DSTday += 7;
-        while(--tw) {
-             DSTday += 7;
-        }
-        if(DSTday > daysInMonth(DSTmonth, currYear)) DSTday -= 7;
-
-    } else if(*t == 'J') {
-
-        t++;
-        u = parseInt(t, it);
-        if(!u) return NULL;
-
-        if(it < 1 || it > 365) return NULL;
-        
-        t = u;
-
-        DSTmonth = 0;
-        while(it > monthDays[DSTmonth]) {
-            it -= monthDays[DSTmonth++];
-        }
-        DSTmonth++;
-        DSTday = it;
-      
-    } else if(*t >= '0' && *t <= '9') {
-
-        u = parseInt(t, it);
-        if(!u) return NULL;
-
-        if(it < 0 || it > 365) return NULL;
-        if((it > 364) && (!isLeapYear(currYear))) return NULL;
-        
-        t = u;
-
-        it++;
-        DSTmonth = 1;
-        while(it > daysInMonth(DSTmonth, currYear)) {
-            it -= daysInMonth(DSTmonth, currYear);
-            DSTmonth++;
-        }
-        DSTday = it;
-      
-    } else return NULL;
-
-    if(*t == '/') {
-        t++;
-        u = parseInt(t, it);
-        if(!u) return NULL;
-        
-        t = u;
-        if(it >= -167 && it <= 167) DSThour = it;
-        else return NULL;
-        
-        if(*t == ':') {
-            t++;
-            u = parseInt(t, it);
-            if(!u) return NULL;
-            
-            t = u;
-            if(it >= 0 && it <= 59) DSTmin = it;
-            else return NULL;
-            
-            if(*t == ':') {
-                t++;
-                u = parseInt(t, it);
-                if(!u) return NULL;
-                t = u;
-            }
-        }
-    } else {
-        DSThour = 2;    
-    }
-
-    // Correction used for converting DST-end to non-DST
-    if(correction > 0) {
-        DSTmin -= correction;
-        while(DSTmin < 0) {
-            DSTmin += 60;
-            DSThour--;
-        }
-    } else if(correction < 0) {
-        DSTmin -= correction;
-        while(DSTmin > 59) {
-            DSTmin -= 60;
-            DSThour++;
-        }
-    }
-
-    if(DSThour > 23) {
-        while(DSThour > 23) {
-            DSTday++;
-            DSThour -= 24;
-        }
-        while(DSTday > daysInMonth(DSTmonth, DSTyear)) {
-            DSTday -= daysInMonth(DSTmonth, DSTyear);
-            DSTmonth++;
-            if(DSTmonth > 12) {
-                DSTyear++;
-                DSTmonth = 1;
-            }
-        }
-    } else if(DSThour < 0) {
-        while(DSThour < 0) {
-            DSTday--;
-            DSThour += 24;
-        }
-        while(DSTday < 1) {
-            DSTmonth--;
-            if(DSTmonth < 1) {
-                DSTyear--;
-                DSTmonth = 12;
-            }
-            DSTday += daysInMonth(DSTmonth, DSTyear);
-        }
+    switch(index) {
+    case 0: return settings.timeZone;
+    case 1: return settings.timeZoneDest;
+    case 2: return settings.timeZoneDep;
     }
-    
-    return t;
-}
-
-/*
- * Convert date into minutes since 1/1 00:00 of given year
- */
-int mins2Date(int year, int month, int day, int hour, int mins)
-{
-    return ((((mon_yday[isLeapYear(year) ? 1 : 0][month - 1] + (day - 1)) * 24) + hour) * 60) + mins;
+    return NULL;
 }
 
 /*
  * Parse TZ string and setup DST data
- * 
- * If TZ-part is bad, always returns FALSE
- * If DST-part is bad, only returns FALSE once
- * (DST-part ignored if bad in later calls)
+ * (See tzParse() for return values)
  */
 bool parseTZ(int index, int currYear, bool doparseDST)
 {
-    char *tz, *t, *u, *v;
-    int diffNorm = 0;
-    int diffDST = 0;
-    int it;
-    int DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute;
-    int DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute;
-
-    switch(index) {
-    case 0: tz = settings.timeZone;     break;
-    case 1: tz = settings.timeZoneDest; break;
-    case 2: tz = settings.timeZoneDep;  break;
-    default:
-        return false;
-    }
-
-    couldDST[index] = false;
-    tzForYear[index] = 0;
-    if(!tzDSTpart[index]) {
-        tzDiffGMT[index] = tzDiffGMTDST[index] = 0;
-    }
-
-    // 0) Basic validity check
-
-    if(*tz == 0) {                                    // Empty string. OK, don't use TZ. So be it.
-        tzHasDST[index] = 0;
-        return true;
-    }
-
-    if(tzIsValid[index] < 1) {
-
-        // If previously determined to be invalid, bail.
-        if(!tzIsValid[index]) return false;
-
-        // Set TZ to "invalid" until verified
-        tzIsValid[index] = 0;
-
-        t = tz;
-        while((t = strchr(t, '>'))) { t++; diffNorm++; }
-        t = tz;
-        while((t = strchr(t, '<'))) { t++; diffDST++; }
-        if(diffNorm != diffDST) return false;         // Uneven < and >, string is bad.
-    }
-
-    // 1) Find difference between nonDST and DST time
-
-    if(!tzDSTpart[index]) {
-
-        diffNorm = diffDST = 0;
-
-        // a. Skip TZ name and parse GMT-diff
-        t = tz;
-        if(*t == '<') {
-           t = strchr(t, '>');
-           if(!t) return false;                       // if <, but no >, string is bad. Bad TZ.
-           t++;
-        } else {
-           while(*t && *t != '-' && (*t < '0' || *t > '9')) {
-              if(*t == ',') return false;
-              t++;
-           }
-        }
-        
-        // t = start of diff to GMT
-        if(*t != '-' && *t != '+' && (*t < '0' || *t > '9'))
-            return false;                             // No numerical difference after name -> bad string. Bad TZ.
-    
-        t = parseInt(t, it);
-        if(it >= -24 && it <= 24) diffNorm = it * 60;
-        else                      return false;       // Bad hr difference. No DST.
-        
-        if(*t == ':') {
-            t++;
-            u = parseInt(t, it);
-            if(!u) return false;                      // No number following ":". Bad string. Bad TZ.
-            t = u;
-            if(it >= 0 && it <= 59) {
-                if(diffNorm < 0)  diffNorm -= it;
-                else              diffNorm += it;
-            } else return false;                      // Bad min difference. Bad TZ.
-            if(*t == ':') {
-                t++;
-                u = parseInt(t, it);
-                if(u) t = u;
-                // Ignore seconds
-            }
-        }
-        
-        // b. Skip DST TZ name and parse GMT-diff
-        
-        if(*t == '<') {
-           t = strchr(t, '>');
-           if(!t) return false;                       // if <, but no >, string is bad. Bad TZ.
-           t++;
-        } else {
-           while(*t && *t != ',' && *t != '-' && (*t < '0' || *t > '9'))
-              t++;
-        }
-        
-        // t = assumed start of DST-diff to GMT
-        if(*t == 0) {
-            tzDiff[index] = 0;
-        } else if(*t != '-' && *t != '+' && (*t < '0' || *t > '9')) {
-            tzDiff[index] = 60;                       // No numerical difference after name -> Assume 1 hr
-        } else {
-            t = parseInt(t, it);
-            if(it >= -24 && it <= 24) diffDST = it * 60;
-            else                      return false;   // Bad hr difference. Bad TZ.
-            if(*t == ':') {
-                t++;
-                u = parseInt(t, it);
-                if(!u) return false;                  // No number following ":". Bad TZ.
-                t = u;
-                if(it >= 0 && it <= 59) {
-                    if(diffDST < 0)  diffDST -= it;
-                    else             diffDST += it;
-                } else return false;                  // Bad min difference. Bad TZ.
-                if(*t == ':') {
-                    t++;
-                    u = parseInt(t, it);
-                    if(u) t = u;
-                    // Ignore seconds
-                }
-            }
-            tzDiff[index] = -(diffDST - diffNorm); //abs(diffDST - diffNorm);
-        }
-    
-        tzDiffGMT[index] = diffNorm;
-        tzDiffGMTDST[index] = tzDiffGMT[index] - tzDiff[index];
-    
-        tzDSTpart[index] = t;
-
-        tzIsValid[index] = 1;   // TZ is valid
-
-    } else {
-
-        t = tzDSTpart[index];
-      
-    }
-
-    if(!tzHasDST[index] || !doparseDST) {
-        return true;
-    }
-    
-    if(*t == 0 || *t != ',') {                        // No DST definition. No DST.
-        tzHasDST[index] = 0;
-        return true;
-    }
+    const char *tz = tzString(index);
 
-    t++;
+    if(!tz) return false;
 
-    tzForYear[index] = currYear;
-
-    // Set to "no DST" until verified valid
-    tzHasDST[index] = 0;
-
-    // 2) parse DST start
-
-    v = t;
-    u = parseDST(t, DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute, currYear, 0);
-    if(!u) return false;
-
-    // If start crosses end year (due to hour numbers >= 24), need to calculate 
-    // for previous year (which then might be in current year). 
-    // The same goes for the other direction vice versa.
-    if(DSTonYear > currYear) {
-        u = parseDST(v, DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute, currYear-1, 0);
-        if(!u) return false;
-        // Trigger check below if still outside of current year
-        if(DSTonYear != currYear) DSTonYear = currYear + 1;
-    } else if(DSTonYear < currYear) {
-        u = parseDST(v, DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute, currYear+1, 0);
-        if(!u) return false;
-        // Trigger check below if still outside of current year
-        if(DSTonYear != currYear) DSTonYear = currYear - 1;
-    }
-    
-    t = u;
-
-    if(*t == 0 || *t != ',') return false;          // Have start, but no end. Bad string. No DST.
-    t++;
-
-    // 3) parse DST end
-
-    v = t;
-    u = parseDST(t, DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute, currYear, tzDiff[index]);
-    if(!u) return false;
-
-    // See above
-    if(DSToffYear > currYear) {
-        u = parseDST(v, DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute, currYear-1, tzDiff[index]);
-        if(!u) return false;
-        // Trigger check below if still outside of current year
-        if(DSToffYear != currYear) DSToffYear = currYear + 1;
-    } else if(DSToffYear < currYear) {
-        u = parseDST(v, DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute, currYear+1, tzDiff[index]);
-        if(!u) return false;
-        // Trigger check below if still outside of current year
-        if(DSToffYear != currYear) DSToffYear = currYear - 1;
-    }
-
-    // 4) Evaluate results
-
-    tzHasDST[index] = 1;  // TZ has valid DST definition
-
-    if((DSToffMonth == DSTonMonth) && (DSToffDay == DSTonDay)) {
-        couldDST[index] = false;
-        #ifdef TC_DBG
-        Serial.printf("parseTZ: (%d) DST not used\n", index);
-        #endif
-    } else {
-        couldDST[index] = true;
-
-        // If start or end still beyond our current year, set to impossible values
-        // to allow a valid comparison.
-        // Despire our cross-end-check for currYear above, this still can happen!
-        // Eg: "CRAZY-3:30<C3ACY>4:56,M1.1.0/-48,M12.5.0/48"
-        // For 2023, first calculated start is on 12/30/2022, so we do 2024 above, 
-        // but for 2024 start is on 1/5/2024. Nothing in 2023!
-        // Likewise 2023's first calculated end is on 1/2/2024, so we do 2022 above,
-        // but for 2022, it is on 12/27/2022. Again, outside of our current year!
-        // So with this somewhat challenging time zone definition, the entire year 
-        // 2023 is DST. Need to set -1/600000 to make comparison right.
-        if(DSTonYear < currYear)
-            DSTonMins[index] = -1;
-        else if(DSTonYear > currYear)
-            DSTonMins[index] = 600000;
-        else 
-            DSTonMins[index] = mins2Date(currYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute);
-    
-        if(DSToffYear < currYear)
-            DSToffMins[index] = -1;
-        else if(DSToffYear > currYear)
-            DSToffMins[index] = 600000;
-        else {
-            DSToffMins[index] = mins2Date(currYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute);
-        }
-
-        #ifdef TC_DBG
-        Serial.printf("parseTZ: (%d) %d/%d(%d) DST %d-%02d-%02d/%02d:%02d - %d-%02d-%02d/%02d:%02d\n",
-                    index,
-                    tzDiffGMT[index], tzDiffGMTDST[index], tzDiff[index],
-                    DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute,
-                    DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute);
-        #endif
-
-    }
-        
-    return true;
+    return tzParse(tzZones[index], tz, currYear, doparseDST);
 }
 
 /*
@@ -5665,126 +5884,49 @@ bool parseTZ(int index, int currYear, bool doparseDST)
  */
 int timeIsDST(int index, int year, int month, int day, int hour, int mins, int& currTimeMins)
 {
-    currTimeMins = mins2Date(year, month, day, hour, mins);
-
-    // DSTxxMins is in non-DST local time (End corrected from DST to non-DST in parseTZ)
-    if(DSTonMins[index] < DSToffMins[index]) {
-        if((currTimeMins >= DSTonMins[index]) && (currTimeMins < DSToffMins[index]))
-            return 1;
-        else 
-            return 0;
-    } else {
-        if((currTimeMins >= DSToffMins[index]) && (currTimeMins < DSTonMins[index]))
-            return 0;
-        else
-            return 1;
-    }
+    return tzIsDST(tzZones[index], year, month, day, hour, mins, currTimeMins);
 }
 
-/*
- * Conversion from/to UTC
- */
-static void convTime(int diff, int& y, int& m, int& d, int& h, int& mm)
+void UTCtoLocal(DateTime &dtu, DateTime& dtl, int index)
 {
-    
-    if(diff > 0) {
+    DateTime *dtls[3] = { NULL, NULL, NULL };
 
-        mm -= diff;
-        while(mm < 0) {
-            mm += 60;
-            h--;
-        }
-        while(h < 0) {
-            h += 24;
-            d--;
-        }
-        while(d < 1) {
-            m--;
-            if(m < 1) {
-                m = 12;
-                y--;
-                if(y < 1) y = 9999;
-            }
-            d += daysInMonth(m, y);
-        }
-        
-    } else if(diff < 0) {
-
-        mm -= diff;
-        while(mm > 59) {
-            mm -= 60;
-            h++;
-        }
-        while(h > 23) {
-            h -= 24;
-            d++;
-        }
-        while(d > daysInMonth(m, y)) {
-            d -= daysInMonth(m, y);
-            m++;
-            if(m > 12) {
-                m = 1;
-                y++;
-                if(y > 9999) y = 1;
-            }
-        }
-
-    }
+    dtls[index] = &dtl;
+    UTCtoLocalBatch(dtu, dtls);
 }
 
-void UTCtoLocal(DateTime &dtu, DateTime& dtl, int index)
+/*
+ * Convert one UTC time stamp for all time zones
+ * whose dtl[] entry is non-NULL
+ */
+void UTCtoLocalBatch(DateTime &dtu, DateTime *dtl[3])
 {
-    int y  = dtu.year();
-    int m  = dtu.month();
-    int d  = dtu.day();
-    int h  = dtu.hour();
-    int mm = dtu.minute();
-    int y2 = y, m2 = m, d2 = d, h2 = h, mm2 = mm;
-    int ctm = 0;
+    for(int index = 0; index < 3; index++) {
 
-    #ifdef TC_DBG
-    if(dtu.second() == 30) {
-        Serial.printf("UTCtoLocal: (%d) UTC:   %d-%d-%d %d:%d\n", index, y, m, d, h, mm, dtu.second());
-    }
-    #endif
+        if(!dtl[index]) continue;
 
-    convTime(tzDiffGMT[index], y, m, d, h, mm);
-    
-    if(couldDST[index]) {
-        if(tzForYear[index] != y) {
-            parseTZ(index, y);
-        }
-        if(timeIsDST(index, y, m, d, h, mm, ctm)) {
-            y = y2; m = m2; d = d2; h = h2; mm = mm2;
-            convTime(tzDiffGMTDST[index], y, m, d, h, mm);
-        }
-    }
+        int y = dtu.year(), m = dtu.month(), d = dtu.day(), h = dtu.hour(), mm = dtu.minute();
 
-    dtl.set(y, m, d, h, mm, dtu.second());
+        if(tzUTCtoLocal(tzZones[index], tzString(index), y, m, d, h, mm)) {
+            #ifdef TC_DBG
+            if(dtu.second() == 30) {
+                Serial.printf("UTCtoLocal: (%d) UTC:   %d-%d-%d %d:%d\n", index, dtu.year(), dtu.month(), dtu.day(), dtu.hour(), dtu.minute());
+                Serial.printf("UTCtoLocal: (%d) Local: %d-%d-%d %d:%d\n", index, y, m, d, h, mm);
+            }
+            #endif
+        }
 
-    #ifdef TC_DBG
-    if(dtu.second() == 30) {
-        Serial.printf("UTCtoLocal: (%d) Local: %d-%d-%d %d:%d\n", index, y, m, d, h, mm, dtu.second());
+        dtl[index]->set(y, m, d, h, mm, dtu.second());
     }
-    #endif
 }
 
 void LocalToUTC(int& ny, int& nm, int& nd, int& nh, int& nmm, int index)
 {
-    int ctm;
-    int diff = tzDiffGMT[index];
-
     #ifdef TC_DBG
     Serial.printf("LocalToUTC: (%d) Local: %d-%d-%d %d:%d\n", index, ny, nm, nd, nh, nmm);
     #endif
 
-    if(couldDST[index]) {
-        if(timeIsDST(index, ny, nm, nd, nh, nmm, ctm)) {
-            diff = tzDiffGMTDST[index];
-        }
-    }
-
-    convTime(-diff, ny, nm, nd, nh, nmm);
+    tzLocalToUTC(tzZones[index], ny, nm, nd, nh, nmm);
 
     #ifdef TC_DBG
     Serial.printf("LocalToUTC: (%d) UTC:   %d-%d-%d %d:%d\n", index, ny, nm, nd, nh, nmm);
@@ -5797,6 +5939,12 @@ void LocalToUTC(int& ny, int& nm, int& nd, int& nh, int& nmm, int index)
  ***                                                        ***
  **************************************************************/
 
+// Runs on the network task
+static bool NTPFilter(const uint8_t *buf, size_t len)
+{
+    return (len == NTP_PACKET_SIZE) && ((buf[0] & 0x3f) == 0x24);
+}
+
 static void ntp_setup()
 {
     myUDP = &ntpUDP;
@@ -5855,6 +6003,7 @@ static bool NTPTriggerUpdate()
     // Send new packet
     NTPSendPacket();
     NTPTSRQAge = millis();
+    NTPTSRQUs = micros64();
     
     NTPPacketDue = true;
     
@@ -5863,6 +6012,8 @@ static bool NTPTriggerUpdate()
 
 static void NTPSendPacket()
 {   
+    IPAddress ntpIP;
+
     memset(NTPUDPBuf, 0, NTP_PACKET_SIZE);
 
     NTPUDPBuf[0] = 0b11100011; // LI, Version, Mode
@@ -5877,7 +6028,11 @@ static void NTPSendPacket()
     NTPUDPID = (uint32_t)millis();
     SET32(NTPUDPBuf, 40, NTPUDPID);
 
-    myUDP->beginPacket(settings.ntpServer, 123);
+    // Not resolved yet: The request times out and is repeated
+    if(!wifiGetNTPServerIP(ntpIP))
+        return;
+
+    myUDP->beginPacket(ntpIP, 123);
     myUDP->write(NTPUDPBuf, NTP_PACKET_SIZE);
     myUDP->endPacket();
 }
@@ -5886,6 +6041,7 @@ static void NTPSendPacket()
 static void NTPCheckPacket()
 {
     unsigned long mymillis = millis();
+    uint64_t myUs = micros64();
     
     int psize = myUDP->parsePacket();
     if(!psize) {
@@ -5908,8 +6064,9 @@ static void NTPCheckPacket()
     
     myUDP->read(NTPUDPBuf, NTP_PACKET_SIZE);
 
-    // Basic validity check
-    if((NTPUDPBuf[0] & 0x3f) != 0x24) return;
+    // Use time of reception instead of time of fetching;
+    // basic validity check was done at reception
+    myUs = (uint64_t)myUDP->rxStamp();
 
     //if(*((uint32_t *)(NTPUDPBuf + 24)) != NTPUDPID) {
     if(GET32(NTPUDPBuf, 24) != NTPUDPID) {
@@ -5922,61 +6079,105 @@ static void NTPCheckPacket()
     // If it's our expected packet, no other is due for now
     NTPPacketDue = false;
 
-    // Baseline for round-trip correction
-    NTPTSAge = mymillis - ((mymillis - NTPTSRQAge) / 2);
+    // Evaluate data: Server receive (T2) and transmit (T3) time
+    uint64_t recvUs = NTPTimeToUs(NTPUDPBuf + 32);
+    uint64_t sendUs = NTPTimeToUs(NTPUDPBuf + 40);
+
+    // Round-trip delay, minus server processing time
+    uint64_t rtt = myUs - NTPTSRQUs;
+    uint64_t srvTime = (sendUs > recvUs) ? sendUs - recvUs : 0;
+    rtt = (rtt > srvTime) ? rtt - srvTime : 0;
+
+    // T3 was current half the delay ago
+    NTPSample *ns = &NTPSamples[NTPSampleIdx];
+    ns->ntpUs = sendUs;
+    ns->localUs = myUs - (rtt / 2);
+    ns->delayUs = (rtt > 0xffffffff) ? 0xffffffff : (uint32_t)rtt;
+    NTPSampleIdx = (NTPSampleIdx + 1) % NTP_FILTER_SIZE;
+    if(NTPNumSamples < NTP_FILTER_SIZE) NTPNumSamples++;
+
+    // Use the sample with the lowest delay; its offset is
+    // the least skewed by asymmetric paths. Skip samples 
+    // older than 5 minutes (timer drift).
+    for(int i = 0; i < NTPNumSamples; i++) {
+        if(myUs - NTPSamples[i].localUs > 5*60*1000000ULL)
+            continue;
+        if(NTPSamples[i].delayUs < ns->delayUs) {
+            ns = &NTPSamples[i];
+        }
+    }
+    NTPrefNtpUs = ns->ntpUs;
+    NTPrefLocalUs = ns->localUs;
+
+    #ifdef TC_DBG
+    Serial.printf("NTPCheckPacket: delay %u us, best %u us\n", 
+              NTPSamples[(NTPSampleIdx + NTP_FILTER_SIZE - 1) % NTP_FILTER_SIZE].delayUs, 
+              ns->delayUs);
+    #endif
+}
+
+// Convert NTP timestamp to us since 1/1/TCEPOCH
+static uint64_t NTPTimeToUs(uint8_t *buf)
+{
+    uint64_t secsSince1900 = ((uint32_t)buf[0] << 24) |
+                             ((uint32_t)buf[1] << 16) |
+                             ((uint32_t)buf[2] <<  8) |
+                             ((uint32_t)buf[3]);
 
-    // Evaluate data
-    uint64_t secsSince1900 = ((uint32_t)NTPUDPBuf[40] << 24) |
-                             ((uint32_t)NTPUDPBuf[41] << 16) |
-                             ((uint32_t)NTPUDPBuf[42] <<  8) |
-                             ((uint32_t)NTPUDPBuf[43]);
+    uint32_t fractSec = ((uint32_t)buf[4] << 24) |
+                        ((uint32_t)buf[5] << 16) |
+                        ((uint32_t)buf[6] <<  8) |
+                        ((uint32_t)buf[7]);
 
-    uint32_t fractSec = ((uint32_t)NTPUDPBuf[44] << 24) |
-                        ((uint32_t)NTPUDPBuf[45] << 16) |
-                        ((uint32_t)NTPUDPBuf[46] <<  8) |
-                        ((uint32_t)NTPUDPBuf[47]);
-                        
     // Correct era
     if(secsSince1900 < (SECS1900_1970 + TCEPOCH_SECS)) {
         secsSince1900 |= 0x100000000ULL;
-    }           
-
-    // Calculate seconds since 1/1/TCEPOCH (without round-trip correction)
-    NTPsecsSinceTCepoch = secsSince1900 - (SECS1900_1970 + TCEPOCH_SECS);
+    }
 
-    // Convert fraction into ms
-    NTPmsSinceSecond = (uint32_t)(((uint64_t)fractSec * 1000ULL) >> 32);
+    return ((secsSince1900 - (SECS1900_1970 + TCEPOCH_SECS)) * 1000000ULL) +
+           (((uint64_t)fractSec * 1000000ULL) >> 32);
 }
 
 static bool NTPHaveTime()
 {
-    return NTPsecsSinceTCepoch ? true : false;
+    return NTPrefNtpUs ? true : false;
 }
 
-// Get seconds since 1/1/TCEPOCH including round-trip correction
-static uint32_t NTPGetCurrSecsSinceTCepoch()
+// Get current NTP time in us since 1/1/TCEPOCH
+static uint64_t NTPGetCurrUsSinceTCepoch()
 {
-    return NTPsecsSinceTCepoch + ((NTPmsSinceSecond + (millis() - NTPTSAge)) / 1000UL);
+    return NTPrefNtpUs + (micros64() - NTPrefLocalUs);
 }
 
 static bool NTPHaveCurrentTime()
 {
     // Have no time if no time stamp received, or stamp is older than 10 mins
-    if((!NTPsecsSinceTCepoch) || ((millis() - NTPTSAge) > 10*60*1000)) 
+    if((!NTPrefNtpUs) || ((micros64() - NTPrefLocalUs) > 10*60*1000000ULL)) 
         return false;
 
     return true;
 }
 
 // Get UTC time from NTP response
-static bool NTPGetUTC(int& year, int& month, int& day, int& hour, int& minute, int& second)
+// If alignUs is given, return the next full second, and
+// in *alignUs the micros64() time at which it begins.
+static bool NTPGetUTC(int& year, int& month, int& day, int& hour, int& minute, int& second, uint64_t *alignUs)
 {
     uint32_t temp, c;
 
     // Fail if no time received, or stamp is older than 10 mins
     if(!NTPHaveCurrentTime()) return false;
     
-    uint32_t secsSinceTCepoch = NTPGetCurrSecsSinceTCepoch();
+    uint64_t nowUs = micros64();
+    uint64_t usSinceTCepoch = NTPrefNtpUs + (nowUs - NTPrefLocalUs);
+
+    if(alignUs) {
+        uint32_t toGo = 1000000UL - (usSinceTCepoch % 1000000ULL);
+        usSinceTCepoch += toGo;
+        *alignUs = nowUs + toGo;
+    }
+
+    uint32_t secsSinceTCepoch = (uint32_t)(usSinceTCepoch / 1000000ULL);
     
     second = secsSinceTCepoch % 60;
 
@@ -6007,100 +6208,182 @@ static bool NTPGetUTC(int& year, int& month, int& day, int& hour, int& minute, i
 
     hour = total32 / 60;
 
-    minute = total32 - (hour * 60);
+    minute = total32 - (hour * 60);
+
+    return true;
+}
+
+
+/**************************************************************
+ ***                                                        ***
+ ***     Basic Telematics Transmission Framework (BTTFN)    ***
+ ***                                                        ***
+ **************************************************************/
+
+int bttfnNumClients()
+{
+    return bttfnNumCli;
+}
+
+// Packets handled since boot, and average handling time
+void bttfnGetPktStats(uint32_t& num, uint32_t& avgNs)
+{
+    num = bttfnPktNum;
+    avgNs = num ? (uint32_t)(bttfnPktCycles * 1000ULL / ((uint64_t)num * getCpuFrequencyMhz())) : 0;
+}
+
+bool bttfnGetClientInfo(int c, char **id, uint8_t **ip, uint8_t *type)
+{
+    if(c < 0 || c >= bttfnNumCli)
+        return false;
+        
+    *id = bttfnClients[c].id;
+    *ip = bttfnClients[c].ip;
+
+    *type = bttfnClients[c].type;
+
+    return true;
+}
+
+// Changes whenever a client is added or removed
+uint16_t bttfnClientsGen()
+{
+    return bttfnCliGen;
+}
+
+// Returns round trip time in ms, or -1 if unknown
+int bttfnGetClientRTT(int c)
+{
+    if(c < 0 || c >= bttfnNumCli || bttfnClients[c].rtt == BTTFN_RTT_NONE)
+        return -1;
 
-    return true;
+    return bttfnClients[c].rtt;
 }
 
+static uint32_t bttfnIPKey(const uint8_t *ip)
+{
+    uint32_t k;
+    memcpy(&k, ip, 4);
+    return k;
+}
 
-/**************************************************************
- ***                                                        ***
- ***     Basic Telematics Transmission Framework (BTTFN)    ***
- ***                                                        ***
- **************************************************************/
+static int bttfnHashSlot(uint32_t key)
+{
+    // Host part of IP varies most; mix it down
+    key *= 2654435761UL;
+    return (key >> 24) & (BTTFN_HASH_SIZE - 1);
+}
 
-int bttfnNumClients()
+// Returns hash slot of client with given IP, or the
+// empty slot where it would be inserted
+static int bttfnFindSlot(uint32_t key)
 {
-    int i;
-    
-    for(i = 0; i < BTTFN_MAX_CLIENTS; i++) {
-      if(!bttfnClientIP[i][0])
-          break;
+    int h = bttfnHashSlot(key);
+
+    while(bttfnCliHash[h]) {
+        if(bttfnIPKey(bttfnClients[bttfnCliHash[h] - 1].ip) == key)
+            break;
+        h = (h + 1) & (BTTFN_HASH_SIZE - 1);
     }
-    return i;
+
+    return h;
 }
 
-bool bttfnGetClientInfo(int c, char **id, uint8_t **ip, uint8_t *type)
+// Remove hash slot h (backward-shift deletion)
+static void bttfnHashDel(int h)
 {
-    if(c > BTTFN_MAX_CLIENTS - 1)
-        return false;
-        
-    if(!bttfnClientIP[c][0])
-        return false;
-        
-    *id = bttfnClientID[c];
-    *ip = bttfnClientIP[c];
+    int j = h;
 
-    *type = bttfnClientType[c];
+    bttfnCliHash[h] = 0;
 
-    return true;
+    for(;;) {
+        j = (j + 1) & (BTTFN_HASH_SIZE - 1);
+        if(!bttfnCliHash[j])
+            break;
+        int home = bttfnHashSlot(bttfnIPKey(bttfnClients[bttfnCliHash[j] - 1].ip));
+        // Move entry up if its home is not in (h, j]
+        if(((j - home) & (BTTFN_HASH_SIZE - 1)) >= ((j - h) & (BTTFN_HASH_SIZE - 1))) {
+            bttfnCliHash[h] = bttfnCliHash[j];
+            bttfnCliHash[j] = 0;
+            h = j;
+        }
+    }
 }
 
-static bool bttfnipcmp(uint8_t *ip1, uint8_t *ip2)
+// Remove client i; the last record takes its place
+static void bttfnRemoveClient(int i)
 {
-    for(int i = 0; i < 4; i++) {
-        if(*ip1++ != *ip2++) return true;
+    int last = bttfnNumCli - 1;
+
+    bttfnHashDel(bttfnFindSlot(bttfnIPKey(bttfnClients[i].ip)));
+
+    if(i != last) {
+        bttfnClients[i] = bttfnClients[last];
+        bttfnCliHash[bttfnFindSlot(bttfnIPKey(bttfnClients[i].ip))] = i + 1;
     }
-    return false;
+
+    bttfnNumCli--;
+    bttfnCliGen++;
 }
 
-static uint32_t storeBTTFNClient(uint8_t *ip, uint8_t *buf, uint8_t type, uint8_t MCSupport)
+static uint32_t storeBTTFNClient(uint8_t *ip, uint8_t *buf, uint8_t type, uint8_t ver, uint8_t MCSupport)
 {
-    int     i;
-    uint8_t *pip;
+    uint32_t key = bttfnIPKey(ip);
+    int      h = bttfnFindSlot(key);
+    int      i;
+    bttfnClient *c;
 
-    // Check if already in list, search for free slot
-    for(i = 0; i < BTTFN_MAX_CLIENTS; i++) {
-        pip = bttfnClientIP[i];
-        if(!*pip)
-            break;
-        else if(!bttfnipcmp(pip, ip))
-            break;
+    if(bttfnCliHash[h]) {
+        i = bttfnCliHash[h] - 1;
+    } else {
+        // Bail if no slot available
+        if(bttfnNumCli >= BTTFN_MAX_CLIENTS)
+            return 0;
+        i = bttfnNumCli++;
+        memcpy(bttfnClients[i].ip, ip, 4);
+        bttfnClients[i].rtt = BTTFN_RTT_NONE;
+        bttfnCliHash[h] = i + 1;
+        bttfnCliGen++;
     }
 
-    // Bail if no slot available
-    if(i == BTTFN_MAX_CLIENTS)
-        return 0;
-
     bttfnHaveClients = true;
 
-    *pip++ = *ip++;
-    *pip++ = *ip++;
-    *pip++ = *ip++;
-    *pip = *ip;
+    c = &bttfnClients[i];
 
-    strncpy(bttfnClientID[i], (char *)buf + 10, 12);
-    bttfnClientID[i][12] = 0;
+    strncpy(c->id, (char *)buf + 10, 12);
+    c->id[12] = 0;
     
     #ifdef TC_BTTFN_MC
-    if((bttfnClientMC[i] = MCSupport)) {
+    if((c->mc = MCSupport)) {
         bttfnNotAllSupportMC = 1;
     } else {
         bttfnAtLeastOneMC = 1;
     }
     #endif
 
-    bttfnClientType[i] = type;
+    c->type = type;
+    c->ver = ver;
+
+    if(ver >= BTTFN_VERSION_AGGR) {
+        uint16_t echo = buf[45] | (buf[46] << 8);
+        uint16_t hold = buf[43] | (buf[44] << 8);
+        if(echo) {
+            uint16_t r = (uint16_t)millis() - echo - hold;
+            if(r < BTTFN_RTT_MAX) {
+                c->rtt = (c->rtt == BTTFN_RTT_NONE) ? r : (uint16_t)(((uint32_t)c->rtt * 7 + r) / 8);
+            }
+        }
+    }
     
     #ifdef TC_HAVE_REMOTE
-    //bttfnRemID[i] = GET32(buf, 35);
-    memcpy(&bttfnRemID[i], &buf[35], 4);
+    //c->remID = GET32(buf, 35);
+    memcpy(&c->remID, &buf[35], 4);
     #endif
     
-    bttfnClientALIVE[i] = millis();
+    c->alive = millis();
 
     #ifdef TC_HAVE_REMOTE
-    return bttfnRemID[i];
+    return c->remID;
     #else
     return 0;
     #endif
@@ -6109,89 +6392,52 @@ static uint32_t storeBTTFNClient(uint8_t *ip, uint8_t *buf, uint8_t type, uint8_
 static void bttfn_expire_clients()
 {
     bool didST = false;
-    int k, numClients = 0;
     unsigned long now = millis();
 
     if(now - bttfnlastExpire < 57*1000)
         return;
         
     bttfnlastExpire = now;
-    
-    for(int i = 0; i < BTTFN_MAX_CLIENTS; i++) {
-        uint8_t *pip = bttfnClientIP[i];
-        if(*pip) {
-            numClients++;
-            if(millis() - bttfnClientALIVE[i] > 5*60*1000) {
-                *pip = 0;
-                #ifdef TC_HAVE_REMOTE
+
+    // Iterate backwards; removal moves the last record into i
+    for(int i = bttfnNumCli - 1; i >= 0; i--) {
+        bttfnClient *c = &bttfnClients[i];
+        if(now - c->alive > 5*60*1000) {
+            #ifdef TC_HAVE_REMOTE
+            #ifdef TC_DBG
+            Serial.printf("Expiring device type %d\n", c->type);
+            #endif
+            if(c->type == BTTFN_TYPE_REMOTE) {
                 #ifdef TC_DBG
-                Serial.printf("Expiring device type %d\n", bttfnClientType[i]);
+                Serial.printf("Expiring remote id: %d %d\n", c->remID, registeredRemID);
                 #endif
-                if(bttfnClientType[i] == BTTFN_TYPE_REMOTE) {
-                    #ifdef TC_DBG
-                    Serial.printf("Expiring remote id: %d %d\n", bttfnRemID[i], registeredRemID);
-                    #endif
-                    if(bttfnRemID[i] == registeredRemID) {
-                        registeredRemID = 0;
-                        bttfnMakeRemoteSpeedMaster(false);
-                    }
-                } else if(bttfnRemID[i] == registeredRemKPID) {
-                    #ifdef TC_DBG
-                    Serial.printf("Expiring remote KP id: %d %d\n", bttfnRemID[i], registeredRemKPID);
-                    #endif
-                    registeredRemKPID = 0;
-                    bttfnLastSeq_ky = 0;    // seq cnt starts at 1 after every registration
+                if(c->remID == registeredRemID) {
+                    registeredRemID = 0;
+                    bttfnMakeRemoteSpeedMaster(false);
                 }
+            } else if(c->remID == registeredRemKPID) {
+                #ifdef TC_DBG
+                Serial.printf("Expiring remote KP id: %d %d\n", c->remID, registeredRemKPID);
                 #endif
-                numClients--;
-                didST = true;
+                registeredRemKPID = 0;
+                bttfnLastSeq_ky = 0;    // seq cnt starts at 1 after every registration
             }
+            #endif
+            bttfnRemoveClient(i);
+            didST = true;
         }
     }
 
-    bttfnHaveClients = (numClients > 0);
+    bttfnHaveClients = (bttfnNumCli > 0);
 
     if(!didST)
         return;
 
-    for(int j = 0; j < BTTFN_MAX_CLIENTS - 1; j++) {
-        if(!bttfnClientIP[j][0]) {
-            for(k = j + 1; k < BTTFN_MAX_CLIENTS; k++) {
-                if(bttfnClientIP[k][0]) {
-                    memcpy(bttfnClientIP[j], bttfnClientIP[k], 4);
-                    memcpy(bttfnClientID[j], bttfnClientID[k], 13);
-                    bttfnClientType[j] = bttfnClientType[k];
-                    bttfnClientALIVE[j] = bttfnClientALIVE[k];
-                    #ifdef TC_BTTFN_MC
-                    bttfnClientMC[j] = bttfnClientMC[k];
-                    #endif
-                    #ifdef TC_HAVE_REMOTE
-                    bttfnRemID[j] = bttfnRemID[k];
-                    #endif
-                    bttfnClientIP[k][0] = 0;
-                    bttfnClientID[k][0] = 0;
-                    bttfnClientType[k] = 0;
-                    #ifdef TC_HAVE_REMOTE
-                    bttfnRemID[k] = 0;
-                    #endif
-                    #ifdef TC_BTTFN_MC
-                    bttfnClientMC[k] = 0;
-                    #endif
-                    break;
-                }
-            }
-            if(k == BTTFN_MAX_CLIENTS) break;
-        }
-    }
-
     #ifdef TC_BTTFN_MC
     bttfnNotAllSupportMC = bttfnAtLeastOneMC = 0;
-    for(int i = 0; i < BTTFN_MAX_CLIENTS; i++) {
-        if(bttfnClientIP[i][0]) {
-            bttfnNotAllSupportMC |= bttfnClientMC[i];
-            bttfnAtLeastOneMC    |= (bttfnClientMC[i] ^ 1);
-        } else
-            break;
+    for(int i = 0; i < bttfnNumCli; i++) {
+        bttfnNotAllSupportMC |= bttfnClients[i].mc;
+        bttfnAtLeastOneMC    |= (bttfnClients[i].mc ^ 1);
     }
     #endif
 }
@@ -6212,6 +6458,7 @@ static void bttfnMakeRemoteSpeedMaster(bool doit)
     }
 
     bttfnOldRemCurSpd = 255;
+    remSpdNum = 0;
     
     if((bttfnRemoteSpeedMaster = doit)) {
       
@@ -6345,71 +6592,70 @@ static void bttfnMakeRemoteSpeedMaster(bool doit)
     }
 }
 
-static void bttfn_evalremotecommand(uint32_t seq, uint8_t cmd, uint8_t p1, uint8_t p2)
-{
-    #ifdef TC_DBG
-    Serial.printf("Remote command %d  p1 %d  (seq %d)\n", cmd, p1, seq);
-    #endif
-            
-    switch(cmd) {
-
-    case BTTFN_REMCMD_COMBINED: // Update status and speed from remote
-        // Skip outdated packets
-        if(seq == 1 || seq > bttfnLastSeq_co) {
-            bttfnMakeRemoteSpeedMaster(!!(p1 & 0x01));
-            bttfnRemStop = !!(p1 & 0x02);
-            if(p2 > 127) bttfnRemoteSpeed = 0;
-            else bttfnRemoteSpeed = p2;  // p2 = speed (0-88)
-            if(bttfnRemoteSpeed > 88) bttfnRemoteSpeed = 88;
-        } else {
-            #ifdef TC_DBG
-            Serial.printf("Command out of sequence seq:%d last:%d)\n", seq, bttfnLastSeq_co);
-            #endif
-        }
-        bttfnLastSeq_co = seq;
-        break;
-        
-    case BTTFN_REMCMD_PING:
-    case BTTFN_REMCMD_KP_PING:
-        // Do nothing, command only for registering or keep-alive
-        break;
+/*
+ * Remote commands; dispatched through the command
+ * registry (tc_cmd.cpp) by their code
+ */
 
-    case BTTFN_REMCMD_BYE:
-        // Remote wants to unregister. It should stop sending keep-alives afterwards.
-        bttfnMakeRemoteSpeedMaster(false);
-        bttfnRemStop = false;
-        bttfnRemoteSpeed = 0;
-        registeredRemID = 0;
+// Update status and speed from remote
+void bttfnRcCombined(const cmdCtx *c)
+{
+    uint8_t p1 = c->p1, p2 = c->p2;
+    
+    // Skip outdated packets
+    if(c->seq == 1 || c->seq > bttfnLastSeq_co) {
+        bttfnMakeRemoteSpeedMaster(!!(p1 & 0x01));
+        bttfnRemStop = !!(p1 & 0x02);
+        if(p2 > 127) bttfnRemoteSpeed = 0;
+        else bttfnRemoteSpeed = p2;  // p2 = speed (0-88)
+        if(bttfnRemoteSpeed > 88) bttfnRemoteSpeed = 88;
+        remSpdAdd(tcdUDP->rxStamp(), bttfnRemoteSpeed);
+    } else {
         #ifdef TC_DBG
-        Serial.printf("Remote unregistered)\n");
+        Serial.printf("Command out of sequence seq:%d last:%d)\n", c->seq, bttfnLastSeq_co);
         #endif
-        break;
+    }
+    bttfnLastSeq_co = c->seq;
+}
 
-    case BTTFN_REMCMD_KP_KEY:
-        // Skip outdated packets
-        if(seq == 1 || seq > bttfnLastSeq_ky) {
-            injectKeypadKey((char)p1, (int)p2);
-        } else {
-            #ifdef TC_DBG
-            Serial.printf("Command out of sequence seq:%d last:%d)\n", seq, bttfnLastSeq_ky);
-            #endif
-        }
-        bttfnLastSeq_ky = seq;
-        break;
+// PING, KP_PING
+void bttfnRcPing(const cmdCtx *c)
+{
+    // Do nothing, command only for registering or keep-alive
+}
+
+void bttfnRcBye(const cmdCtx *c)
+{
+    // Remote wants to unregister. It should stop sending keep-alives afterwards.
+    bttfnMakeRemoteSpeedMaster(false);
+    bttfnRemStop = false;
+    bttfnRemoteSpeed = 0;
+    registeredRemID = 0;
+    #ifdef TC_DBG
+    Serial.printf("Remote unregistered)\n");
+    #endif
+}
 
-    case BTTFN_REMCMD_KP_BYE:
-        bttfnLastSeq_ky = 0;    // seq cnt starts at 1 after every registration
-        registeredRemKPID = 0;
+void bttfnRcKpKey(const cmdCtx *c)
+{
+    // Skip outdated packets
+    if(c->seq == 1 || c->seq > bttfnLastSeq_ky) {
+        injectKeypadKey((char)c->p1, (int)c->p2);
+    } else {
         #ifdef TC_DBG
-        Serial.printf("Remote KP unregistered)\n");
+        Serial.printf("Command out of sequence seq:%d last:%d)\n", c->seq, bttfnLastSeq_ky);
         #endif
-        break;
+    }
+    bttfnLastSeq_ky = c->seq;
+}
 
+void bttfnRcKpBye(const cmdCtx *c)
+{
+    bttfnLastSeq_ky = 0;    // seq cnt starts at 1 after every registration
+    registeredRemKPID = 0;
     #ifdef TC_DBG
-    default:
-        Serial.printf("Unknown remote command: %d\n", cmd);
+    Serial.printf("Remote KP unregistered)\n");
     #endif
-    }
 }
 #endif
 
@@ -6430,28 +6676,71 @@ static void bttfn_setup()
 
     #ifdef TC_BTTFN_MC
     tcdmcUDP = &bttfmcUDP;
-    tcdmcUDP->beginMulticast(IPAddress(224, 0, 0, 224), BTTF_DEFAULT_LOCAL_PORT + 1);
+    // Group can only be joined once the interface is up
+    if(wifiIsConnecting()) {
+        bttfnMcPending = true;
+    } else {
+        tcdmcUDP->beginMulticast(IPAddress(224, 0, 0, 224), BTTF_DEFAULT_LOCAL_PORT + 1);
+    }
     #endif
 }
 
+// Handle up to BTTFN_MAX_BATCH packets per call, as long as
+// BTTFN_BATCH_US are not exceeded, so that a burst of requests 
+// from many clients is not answered one loop pass at a time.
+#define BTTFN_MAX_BATCH  8
+#define BTTFN_BATCH_US   3000
+
 bool bttfn_loop()
 {
-    bool resmc = false;
-    
+    int64_t start = esp_timer_get_time();
+    bool ret = false, haveuc = true, havemc = false;
+
+    // Delays in time_setup() (eg when setting the RTC from
+    // NTP) run the scheduler before bttfn_setup()
+    if(!tcdUDP)
+        return false;
+
     #ifdef TC_BTTFN_MC
-    resmc = bttfn_checkmc();
+    if(bttfnMcPending && !wifiIsConnecting()) {
+        tcdmcUDP->beginMulticast(IPAddress(224, 0, 0, 224), BTTF_DEFAULT_LOCAL_PORT + 1);
+        bttfnMcPending = false;
+    }
+    havemc = !bttfnMcPending;
     #endif
 
+    for(int i = 0; i < BTTFN_MAX_BATCH; i++) {
+        #ifdef TC_BTTFN_MC
+        if(havemc) havemc = bttfn_checkmc();
+        #endif
+        if(haveuc) haveuc = bttfn_checkuc();
+        if(!havemc && !haveuc) break;
+        ret = true;
+        if(esp_timer_get_time() - start >= BTTFN_BATCH_US) break;
+    }
+
+    if(!haveuc) {
+        bttfn_expire_clients();
+    }
+
+    if(bttfnNumAggr && (millis() - bttfnAggrNow >= BTTFN_AGGR_MS)) {
+        bttfn_flush_aggr();
+    }
+
+    return ret;
+}
+
+static bool bttfn_checkuc()
+{
     int psize = tcdUDP->parsePacket();
 
     if(!psize) {
-        bttfn_expire_clients();
-        return false | resmc;
+        return false;
     }
     
     tcdUDP->read(BTTFUDPBuf, BTTF_PACKET_SIZE);
 
-    if(bttfn_handlePacket(BTTFUDPBuf, false)) {
+    if(bttfn_handlePacketTimed(BTTFUDPBuf, false)) {
         tcdUDP->beginPacket(tcdUDP->remoteIP(), BTTF_DEFAULT_LOCAL_PORT); //tcdUDP->remotePort());
         tcdUDP->write(BTTFUDPBuf, BTTF_PACKET_SIZE);
         tcdUDP->endPacket();
@@ -6477,7 +6766,7 @@ static bool bttfn_checkmc()
     Serial.printf("Received multicast packet from %s\n", tcdmcUDP->remoteIP().toString());
     #endif
     
-    if(bttfn_handlePacket(BTTFMCBuf, true)) {
+    if(bttfn_handlePacketTimed(BTTFMCBuf, true)) {
         tcdUDP->beginPacket(tcdmcUDP->remoteIP(), BTTF_DEFAULT_LOCAL_PORT);
         tcdUDP->write(BTTFMCBuf, BTTF_PACKET_SIZE);
         tcdUDP->endPacket();
@@ -6500,23 +6789,45 @@ static uint8_t* bttfn_unrollPacket(uint8_t *d, uint32_t m, int b)
     return d;
 }
 
-static bool bttfn_handlePacket(uint8_t *buf, bool isMC)
+// Check header and checksum; runs on the network task
+static bool bttfnFilter(const uint8_t *buf, size_t len)
 {
-    uint8_t tip[4] = { 0 };
-    uint8_t a = 0, ctype = 0, parm = 0, supportsMC = 0;
-    int16_t temp = 0;
-    uint32_t receivedRemID;
+    uint8_t a = 0;
     
-    // Check header
-    if(memcmp(buf, BTTFUDPHD, 4))
+    if(len != BTTF_PACKET_SIZE || memcmp(buf, BTTFUDPHD, 4))
         return false;
 
-    // Check checksum
     for(int i = 4; i < BTTF_PACKET_SIZE - 1; i++) {
         a += buf[i] ^ 0x55;
     }
-    if(buf[BTTF_PACKET_SIZE - 1] != a)
-        return false;
+    
+    return (buf[BTTF_PACKET_SIZE - 1] == a);
+}
+
+// Cost of packet handling (see bttfnGetPktStats())
+static bool bttfn_handlePacketTimed(uint8_t *buf, bool isMC)
+{
+    uint32_t c = ESP.getCycleCount();
+    bool ret = bttfn_handlePacket(buf, isMC);
+
+    c = ESP.getCycleCount() - c;
+    bttfnPktNum++;
+    bttfnPktCycles += c;
+    #ifdef TC_CYCPROF
+    cycNote(CYC_BTTFNPKT, c);
+    #endif
+
+    return ret;
+}
+
+static bool TC_HOT bttfn_handlePacket(uint8_t *buf, bool isMC)
+{
+    uint8_t tip[4] = { 0 };
+    uint8_t a = 0, ctype = 0, parm = 0, supportsMC = 0;
+    int16_t temp = 0;
+    uint32_t receivedRemID;
+    
+    // Header and checksum were checked by bttfnFilter()
 
     // Check if device supports passive MC
     #ifdef TC_BTTFN_MC
@@ -6550,7 +6861,7 @@ static bool bttfn_handlePacket(uint8_t *buf, bool isMC)
 
     ctype = (uint8_t)buf[10+13];
     
-    receivedRemID = storeBTTFNClient(tip, buf, ctype, supportsMC);
+    receivedRemID = storeBTTFNClient(tip, buf, ctype, buf[4], supportsMC);
 
     // Remote time travel?
     if(!isMC && (buf[5] & 0x80)) {
@@ -6606,7 +6917,14 @@ static bool bttfn_handlePacket(uint8_t *buf, bool isMC)
         // Eval command from remote: 
         // 25: Command code
         // 26, 27: parameters
-        bttfn_evalremotecommand(seq, buf[25], buf[26], buf[27]);
+        #ifdef TC_DBG
+        Serial.printf("Remote command %d  p1 %d  (seq %d)\n", buf[25], buf[26], seq);
+        if(cmdExecCode(buf[25], seq, buf[26], buf[27], CMDT_BTTFN) == CMD_UNKNOWN) {
+            Serial.printf("Unknown remote command: %d\n", buf[25]);
+        }
+        #else
+        cmdExecCode(buf[25], seq, buf[26], buf[27], CMDT_BTTFN);
+        #endif
 
         // Send no response
         return false;
@@ -6714,10 +7032,10 @@ static bool bttfn_handlePacket(uint8_t *buf, bool isMC)
             buf[5] &= ~0x20;
             parm &= 0x0f;
             if(parm) {
-                for(int i = 0; i < BTTFN_MAX_CLIENTS; i++) {
-                    if(parm == bttfnClientType[i]) {
+                for(int i = 0; i < bttfnNumCli; i++) {
+                    if(parm == bttfnClients[i].type) {
                         for(int j = 0; j < 4; j++) {
-                            buf[27+j] = bttfnClientIP[i][j];
+                            buf[27+j] = bttfnClients[i].ip[j];
                         }
                         buf[5] |= 0x20;
                         break;
@@ -6738,6 +7056,14 @@ static bool bttfn_handlePacket(uint8_t *buf, bool isMC)
         }
         // 0x80 taken (TT)
 
+        // Stamp for RTT measurement
+        if((buf[4] & 0x0f) >= BTTFN_VERSION_AGGR) {
+            uint16_t stamp = (uint16_t)millis();
+            if(!stamp) stamp = 1;
+            buf[45] = stamp & 0xff;
+            buf[46] = stamp >> 8;
+        }
+
     #ifdef TC_HAVE_REMOTE
     }
     #endif
@@ -6792,74 +7118,297 @@ static void bttfn_notify_of_speed()
     }
 
     now = millis();
-    if(spd != oldBTTFNSpd || ssrc != oldBTTFNSSrc || (now - bttfnLastSpeedNot > 2775)) {
-        oldBTTFNSpd = spd;
-        oldBTTFNSSrc = ssrc;
-        bttfn_notify(BTTFN_TYPE_ANY, BTTFN_NOT_SPD, (uint16_t)spd, ssrc);
-        bttfnLastSpeedNot = now;
+    
+    if(ssrc != oldBTTFNSSrc || (spd != oldBTTFNSpd && bttfn_speed_due(spd, ssrc, now))) {
+        // Slope as hint for extrapolation, in 0.1mph/s
+        int32_t slope = 0;
+        if(ssrc == oldBTTFNSSrc && spd >= 0 && oldBTTFNSpd >= 0 && now != bttfnLastSpeedNot) {
+            slope = (int32_t)(spd - oldBTTFNSpd) * 10000 / (int32_t)(now - bttfnLastSpeedNot);
+            if(slope > 32767) slope = 32767;
+            else if(slope < -32767) slope = -32767;
+        }
+        bttfnSpdSlope = slope;
+        bttfnSpdStamp = now;
+    } else if(now - bttfnLastSpeedNot > ((spd < 0) ? BTTFN_SPD_KEEP_IDLE : BTTFN_SPD_KEEP)) {
+        // Keepalive, no slope
+        bttfnSpdSlope = 0;
+        bttfnSpdStamp = now;
+    } else {
+        return;
+    }
+
+    oldBTTFNSpd = spd;
+    oldBTTFNSSrc = ssrc;
+    bttfn_notify(BTTFN_TYPE_ANY, BTTFN_NOT_SPD, (uint16_t)spd, ssrc);
+    bttfnLastSpeedNot = now;
+}
+
+// Speed changes are rate-limited per source: GPS speed is sent at  
+// twice the GPS read rate, rotary encoder and remote at 10Hz. Time 
+// travel sequences are not limited; neither are stops, starts and
+// 88mph, so props never miss the interesting values.
+static bool bttfn_speed_due(int16_t spd, uint16_t ssrc, unsigned long now)
+{
+    unsigned long intv;
+    
+    if(spd <= 0 || oldBTTFNSpd <= 0 || spd == 88)
+        return true;
+
+    switch(ssrc) {
+    #ifdef TC_HAVEGPS
+    case BTTFN_SSRC_GPS:
+        intv = GPSupdateFreq ? GPSupdateFreq / 2 : BTTFN_SPD_INTV;
+        break;
+    #endif
+    case BTTFN_SSRC_ROTENC:
+    case BTTFN_SSRC_REM:
+        intv = BTTFN_SPD_INTV;
+        break;
+    default:
+        return true;
+    }
+
+    return (now - bttfnLastSpeedNot >= intv);
+}
+#endif
+
+static void bttfn_send(uint8_t *ip, uint16_t port)
+{
+    // Checksum
+    uint8_t a = 0;
+    for(int i = 4; i < BTTF_PACKET_SIZE - 1; i++) {
+        a += BTTFUDPBuf[i] ^ 0x55;
+    }
+    BTTFUDPBuf[BTTF_PACKET_SIZE - 1] = a;
+
+    tcdUDP->beginPacket(IPAddress(ip[0], ip[1], ip[2], ip[3]), port);
+    tcdUDP->write(BTTFUDPBuf, BTTF_PACKET_SIZE);
+    tcdUDP->endPacket();
+}
+
+static void bttfn_nextSeq()
+{
+    bttfnSeqCnt++;
+    if(!bttfnSeqCnt) bttfnSeqCnt = 1;
+}
+
+#ifdef TC_BTTFN_MC
+// Current UTC in us since 1/1/1970 and its source; 0 if
+// we have no authoritative time. NTP is used if current, 
+// otherwise the RTC second plus the time since its edge.
+static uint64_t bttfn_getUTCUs(uint8_t& src)
+{
+    if(NTPHaveCurrentTime()) {
+        src = BTTFN_TIME_SRC_NTP;
+        return NTPGetCurrUsSinceTCepoch() + (TCEPOCH_SECS * 1000000ULL);
     }
+    
+    if(!haveAuthTime || !gdtuEdgeUs)
+        return 0;
+
+    uint64_t secs = (dateToMins(gdtu.year(), gdtu.month(), gdtu.day(), gdtu.hour(), gdtu.minute()) -
+                     dateToMins(1970, 1, 1, 0, 0)) * 60ULL + gdtu.second();
+
+    src = BTTFN_TIME_SRC_RTC;
+    return (secs * 1000000ULL) + (uint64_t)(esp_timer_get_time() - gdtuEdgeUs);
+}
+
+// Multicast time beacon for props that have no NTP (or no
+// network time at all, as in car mode). 
+//  6:     Source (1 = NTP, 2 = RTC disciplined by NTP/GPS)
+//  12-15: Sequence
+//  16-23: UTC in us since 1/1/1970 at time of sending
+//  24-31: UTC at which sending the previous beacon was finished
+//  32-35: Sequence of the previous beacon
+// The follow-up stamp is not a transmit timestamp from the network
+// hardware; it is the clock read again after endPacket() returned,
+// ie after the packet was handed to the IP stack. It thereby covers
+// our own delay in building and sending the packet, but not what 
+// happens in the stack and the WiFi driver after that. Props should 
+// use the lowest-latency beacons and correct those by the follow-up 
+// stamp.
+static void bttfn_notify_of_time()
+{
+    uint8_t  mcip[4] = { 224, 0, 0, 224 };
+    uint8_t  src = 0, src2;
+    uint64_t utc;
+    unsigned long now = millis();
+
+    if(!bttfnAtLeastOneMC || (now - bttfnLastTimeNot < BTTFN_TIME_INTV))
+        return;
+
+    bttfnLastTimeNot = now;
+
+    // Check before touching the buffer, it is shared
+    if(!(utc = bttfn_getUTCUs(src)))
+        return;
+
+    memset(BTTFUDPBuf, 0, BTTF_PACKET_SIZE);
+    memcpy(BTTFUDPBuf, BTTFUDPHD, 4);
+
+    BTTFUDPBuf[4] = 1 + 0x40;
+    BTTFUDPBuf[5] = BTTFN_NOT_TIME;
+    SET32(BTTFUDPBuf, 12, bttfnSeqCnt);
+    SET32(BTTFUDPBuf, 24, (uint32_t)bttfnLastTimeTx);
+    SET32(BTTFUDPBuf, 28, (uint32_t)(bttfnLastTimeTx >> 32));
+    SET32(BTTFUDPBuf, 32, bttfnLastTimeSeq);
+
+    BTTFUDPBuf[6] = src;
+    SET32(BTTFUDPBuf, 16, (uint32_t)utc);
+    SET32(BTTFUDPBuf, 20, (uint32_t)(utc >> 32));
+
+    bttfn_send(mcip, BTTF_DEFAULT_LOCAL_PORT + 2);
+
+    // Follow-up stamp for the next beacon (see above)
+    bttfnLastTimeTx = bttfn_getUTCUs(src2);
+    bttfnLastTimeSeq = bttfnSeqCnt;
+    bttfn_nextSeq();
 }
 #endif
 
 // Send event notification to known clients
 static void bttfn_notify(uint8_t targetType, uint8_t event, uint16_t payload, uint16_t payload2)
 {
-    IPAddress ip(224, 0, 0, 224);
-    bool spdNot = false;
+    bool spdNot = (event == BTTFN_NOT_SPD || event == BTTFN_NOT_REM_SPD);
+    bool haveAggr = false;
+    bool compLead = false;
 
     // No clients?
-    if(!bttfnClientIP[0][0])
+    if(!bttfnNumCli)
         return;
+
+    // Time travel: If we know the latency of any client, send 
+    // to each client individually, with lead time reduced by
+    // half the client's RTT, so that all props reach P1 at
+    // the same time.
+    if(event == BTTFN_NOT_TT) {
+        for(int i = 0; i < bttfnNumCli; i++) {
+            if(bttfnClients[i].rtt != BTTFN_RTT_NONE) {
+                compLead = true;
+                break;
+            }
+        }
+    }
+
+    #ifdef TC_BTTFN_MC
+    bool useMC = ((!targetType && !bttfnNotAllSupportMC) || spdNot) && !compLead;
+    #else
+    bool useMC = false;
+    #endif
+
+    // Keep order: Send pending aggregated events first
+    if((useMC || compLead) && bttfnNumAggr) {
+        bttfn_flush_aggr();
+    }
     
     memset(BTTFUDPBuf, 0, BTTF_PACKET_SIZE);
 
     // ID
     memcpy(BTTFUDPBuf, BTTFUDPHD, 4);
 
-    BTTFUDPBuf[4] = BTTFN_VERSION + 0x40; // Version + notify marker
+    // Legacy (v1) packet
+    BTTFUDPBuf[4] = 1 + 0x40;             // Version + notify marker
     BTTFUDPBuf[5] = event;                // Store event id
     BTTFUDPBuf[6] = payload & 0xff;       // store payload
     BTTFUDPBuf[7] = payload >> 8;         //
     BTTFUDPBuf[8] = payload2 & 0xff;      // store payload 2
     BTTFUDPBuf[9] = payload2 >> 8;        //
 
-    if(event == BTTFN_NOT_SPD || event == BTTFN_NOT_REM_SPD) {
+    if(spdNot) {
         SET32(BTTFUDPBuf, 12, bttfnSeqCnt);
-        bttfnSeqCnt++;
-        if(!bttfnSeqCnt) bttfnSeqCnt = 1;
-        spdNot = true;
-    }
-    
-    // Checksum
-    uint8_t a = 0;
-    for(int i = 4; i < BTTF_PACKET_SIZE - 1; i++) {
-        a += BTTFUDPBuf[i] ^ 0x55;
+        bttfn_nextSeq();
+        #ifdef TC_BTTFN_MC
+        if(event == BTTFN_NOT_SPD) {
+            // Interpolation hints: Slope (0.1mph/s), timestamp (ms)
+            BTTFUDPBuf[16] = bttfnSpdSlope & 0xff;
+            BTTFUDPBuf[17] = (uint16_t)bttfnSpdSlope >> 8;
+            SET32(BTTFUDPBuf, 18, bttfnSpdStamp);
+        }
+        #endif
     }
-    BTTFUDPBuf[BTTF_PACKET_SIZE - 1] = a;
 
     #ifdef TC_BTTFN_MC
-    if((!targetType && !bttfnNotAllSupportMC) || spdNot) {
+    if(useMC) {
         // Send out through multicast
-        tcdUDP->beginPacket(ip, BTTF_DEFAULT_LOCAL_PORT + 2);
-        tcdUDP->write(BTTFUDPBuf, BTTF_PACKET_SIZE);
-        tcdUDP->endPacket();
-    } else {
+        uint8_t mcip[4] = { 224, 0, 0, 224 };
+        bttfn_send(mcip, BTTF_DEFAULT_LOCAL_PORT + 2);
+        return;
+    }
     #endif
-        // Send out to all known clients
-        for(int i = 0; i < BTTFN_MAX_CLIENTS; i++) {
-            if(!bttfnClientIP[i][0])
-                break;
-            if(!targetType || targetType == bttfnClientType[i]) {
-                ip[0] = bttfnClientIP[i][0];
-                ip[1] = bttfnClientIP[i][1];
-                ip[2] = bttfnClientIP[i][2];
-                ip[3] = bttfnClientIP[i][3];
-                tcdUDP->beginPacket(ip, BTTF_DEFAULT_LOCAL_PORT);
-                tcdUDP->write(BTTFUDPBuf, BTTF_PACKET_SIZE);
-                tcdUDP->endPacket();
+    
+    // Send out to all known v1 clients; v2 clients get
+    // the event as part of an aggregated packet
+    for(int i = 0; i < bttfnNumCli; i++) {
+        if(!targetType || targetType == bttfnClients[i].type) {
+            if(compLead) {
+                uint16_t half = (bttfnClients[i].rtt == BTTFN_RTT_NONE) ? 0 : bttfnClients[i].rtt / 2;
+                uint16_t lead = (payload > half) ? payload - half : 0;
+                BTTFUDPBuf[6] = lead & 0xff;
+                BTTFUDPBuf[7] = lead >> 8;
+                bttfn_send(bttfnClients[i].ip, BTTF_DEFAULT_LOCAL_PORT);
+            } else if(bttfnClients[i].ver >= BTTFN_VERSION_AGGR) {
+                haveAggr = true;
+            } else {
+                bttfn_send(bttfnClients[i].ip, BTTF_DEFAULT_LOCAL_PORT);
             }
         }
-    #ifdef TC_BTTFN_MC
     }
-    #endif
+
+    if(!haveAggr)
+        return;
+
+    if(bttfnNumAggr >= BTTFN_AGGR_MAX) {
+        bttfn_flush_aggr();
+    }
+    if(!bttfnNumAggr) {
+        bttfnAggrNow = millis();
+    }
+    bttfnAggr[bttfnNumAggr].target = targetType;
+    bttfnAggr[bttfnNumAggr].event = event;
+    bttfnAggr[bttfnNumAggr].payload = payload;
+    bttfnAggr[bttfnNumAggr].payload2 = payload2;
+    bttfnNumAggr++;
+}
+
+// Send collected events to v2 clients, one packet per client
+static void bttfn_flush_aggr()
+{
+    int num = bttfnNumAggr;
+
+    bttfnNumAggr = 0;
+
+    for(int i = 0; i < bttfnNumCli; i++) {
+        bttfnClient *c = &bttfnClients[i];
+        int n = 0, j = 11;
+        
+        if(c->ver < BTTFN_VERSION_AGGR)
+            continue;
+
+        memset(BTTFUDPBuf, 0, BTTF_PACKET_SIZE);
+        memcpy(BTTFUDPBuf, BTTFUDPHD, 4);
+        BTTFUDPBuf[4] = BTTFN_VERSION + 0x40;
+        BTTFUDPBuf[5] = BTTFN_AGGR_MARKER;
+
+        for(int k = 0; k < num; k++) {
+            bttfnAggrEv *e = &bttfnAggr[k];
+            if(e->target && e->target != c->type)
+                continue;
+            BTTFUDPBuf[j++] = e->event;
+            BTTFUDPBuf[j++] = 4;
+            BTTFUDPBuf[j++] = e->payload & 0xff;
+            BTTFUDPBuf[j++] = e->payload >> 8;
+            BTTFUDPBuf[j++] = e->payload2 & 0xff;
+            BTTFUDPBuf[j++] = e->payload2 >> 8;
+            n++;
+        }
+
+        if(!n)
+            continue;
+
+        BTTFUDPBuf[6] = n;
+        SET32(BTTFUDPBuf, 7, bttfnSeqCnt);
+        bttfn_nextSeq();
+
+        bttfn_send(c->ip, BTTF_DEFAULT_LOCAL_PORT);
+    }
 }
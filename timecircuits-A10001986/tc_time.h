@@ -54,6 +54,8 @@
 #define _TC_TIME_H
 
 #include "rtc.h"
+#include "tc_calendar.h"
+#include "tc_tz.h"
 #include "clockdisplay.h"
 #ifdef TC_HAVEGPS
 #include "gps.h"
@@ -64,6 +66,8 @@
 #if defined(TC_HAVELIGHT) || defined(TC_HAVETEMP)
 #include "sensors.h"
 #endif
+#include "tc_history.h"
+#include "tc_cmd.h"
 
 #define AUTONM_NUM_PRESETS 4
 
@@ -74,7 +78,6 @@ extern unsigned long powerupMillis;
 
 extern uint16_t lastYear;
 
-extern bool couldDST[3];
 extern bool haveWcMode;
 extern bool WcHaveTZ1;
 extern bool WcHaveTZ2;
@@ -105,10 +108,40 @@ extern lightSensor lightSens;
 #ifdef TC_HAVE_REMOTE
 extern bool remoteAllowed;
 extern bool remoteKPAllowed;
+
+// BTTFN remote command codes
+#define BTTFN_REMCMD_PING       1   // Implicit "Register"/keep-alive
+#define BTTFN_REMCMD_BYE        2   // Forced unregister
+#define BTTFN_REMCMD_COMBINED   3   // All switches & speed combined
+#define BTTFN_REMCMD_KP_PING    4
+#define BTTFN_REMCMD_KP_KEY     5
+#define BTTFN_REMCMD_KP_BYE     6
+
+// Handlers, for the command registry
+void bttfnRcCombined(const cmdCtx *c);
+void bttfnRcPing(const cmdCtx *c);
+void bttfnRcBye(const cmdCtx *c);
+void bttfnRcKpKey(const cmdCtx *c);
+void bttfnRcKpBye(const cmdCtx *c);
 #endif
 
 extern tcRTC rtc;
 
+#ifdef TC_HAVEGPS
+extern bool  useGPS;
+extern tcGPS myGPS;
+#endif
+
+// Sensor history (temperatures scaled by 100)
+extern sensHistory rtcTempHist;
+#ifdef TC_HAVETEMP
+extern sensHistory tempHist;
+extern sensHistory humHist;
+#endif
+#ifdef TC_HAVELIGHT
+extern sensHistory luxHist;
+#endif
+
 extern int8_t        manualNightMode;
 extern unsigned long manualNMNow;
 extern bool          forceReEvalANM;
@@ -139,6 +172,7 @@ extern uint8_t  mqttDisp;
 #ifdef TC_HAVEMQTT
 extern uint8_t  mqttOldDisp;
 extern char mqttMsg[256];
+extern cdStrip mqttStrip;
 extern uint16_t mqttIdx;
 extern int16_t  mqttMaxIdx;
 extern bool     mqttST;
@@ -193,10 +227,21 @@ void      fpbKeyLongPressStop();
 
 void      myCustomDelay_KP(unsigned long mydel);
 
+// Power governor states
+#define PWR_FULL    0   // 240MHz
+#define PWR_MID     1   // 160MHz
+#define PWR_LOW     2   // 80MHz
+#define PWR_NAP     3   // 80MHz, light sleep between SQW ticks
+#define PWR_NUM_ST  4
+
 void      pwrNeedFullNow(bool force = false);
+void      pwr_loop();
+uint8_t   pwrGetState();
+void      pwrGetStats(uint32_t *secs, uint32_t& slept);
 
 void      myrtcnow(DateTime& dt);
 
+uint64_t  micros64();
 uint64_t  millis64();
 
 void      enableWcMode(bool onOff);
@@ -214,9 +259,11 @@ void      re_vol_reset();
 
 void      flushDelayedSave();
 
-void      animate(bool withLEDs = false);
+void      animate(bool withLEDs = false, bool wait = false);
 void      allLampTest();
 void      allOff();
+void      allHoldFrames();
+void      allCommitFrames();
 
 #ifdef TC_HAVEGPS
 bool      gpsHaveFix();
@@ -228,26 +275,23 @@ void      gps_loop(bool withRotEnc = true);
 void      mydelay(unsigned long mydel);
 void      waitAudioDone();
 
-uint8_t   dayOfWeek(int d, int m, int y);
-int       daysInMonth(int month, int year);
-bool      isLeapYear(int year);
 uint32_t  getHrs1KYrs(int index);
-#ifdef TC_JULIAN_CAL
-void      correctNonExistingDate(int year, int month, int& day);
-#endif
 uint8_t*  e(uint8_t *, uint32_t, int);
-void      correctYr4RTC(uint16_t& year, int16_t& offs);
-int       mins2Date(int year, int month, int day, int hour, int mins);
 bool      parseTZ(int index, int currYear, bool doparseDST = true);
 int       timeIsDST(int index, int year, int month, int day, int hour, int mins, int& currTimeMins);
 void      UTCtoLocal(DateTime &dtu, DateTime& dtl, int index);
+void      UTCtoLocalBatch(DateTime &dtu, DateTime *dtl[3]);
 void      LocalToUTC(int& ny, int& nm, int& nd, int& nh, int& nmm, int index);
 
 void      ntp_loop();
 void      ntp_short_loop();
 
 int       bttfnNumClients();
+void      bttfnGetPktStats(uint32_t& num, uint32_t& avgNs);
 bool      bttfnGetClientInfo(int c, char **id, uint8_t **ip, uint8_t *type);
+#define BTTFN_RTT_MAX 5000    // RTTs above are discarded
+int       bttfnGetClientRTT(int c);
+uint16_t  bttfnClientsGen();
 bool      bttfn_loop();
 
 #endif
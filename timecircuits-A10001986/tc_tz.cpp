@@ -0,0 +1,727 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2021-2022 John deGlavina https://circuitsetup.us
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Time zone and DST handling
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Time zones are passed in as a tzZone (which holds all state
+ * derived from the TZ string) plus the TZ string itself.
+ * Apart from tc_global.h and debug output, nothing in here
+ * depends on the platform, so this can also be built on a host.
+ */
+
+#include "tc_global.h"
+
+#ifdef TC_DBG
+#include <Arduino.h>
+#endif
+#include <string.h>
+
+#include "tc_calendar.h"
+#include "tc_tz.h"
+
+/*
+ * Parse integer
+ */
+static const char *parseInt(const char *t, int& it)
+{
+    bool isNeg = false;
+    it = 0;
+    
+    if(*t == '-') {
+        t++;
+        isNeg = true;
+    } else if(*t == '+') {
+        t++;
+    }
+    
+    if(*t < '0' || *t > '9') return NULL;
+    
+    while(*t >= '0' && *t <= '9') {
+        it *= 10;
+        it += (*t++ - '0');
+    }
+    if(isNeg) it *= -1;
+
+    return t;
+}
+
+/*
+ * Parse DST parts of TZ string into rule
+ */
+static const char *parseDSTRule(const char *t, DSTRule& r)
+{
+    const char *u;
+    int it;
+
+    r.minute = 0;
+    
+    if(*t == 'M') {
+        t++;
+        u = parseInt(t, it);
+        if(!u) return NULL;
+        if(it >= 1 && it <= 12) r.month = it;
+        else                    return NULL;
+            
+        t = u;
+        if(*t++ != '.') return NULL;
+        
+        u = parseInt(t, it);
+        if(!u) return NULL;
+        if(it < 1 || it > 5) return NULL;
+        r.week = it;
+        
+        t = u;        
+        if(*t++ != '.') return NULL;
+        
+        u = parseInt(t, it);
+        if(!u) return NULL;
+        if(it < 0 || it > 6) return NULL;
+        r.wday = it;
+
+        t = u;
+
+        r.type = 'M';
+        
+    } else if(*t == 'J') {
+
+        t++;
+        u = parseInt(t, it);
+        if(!u) return NULL;
+
+        if(it < 1 || it > 365) return NULL;
+        
+        t = u;
+
+        r.type = 'J';
+        r.yday = it;
+      
+    } else if(*t >= '0' && *t <= '9') {
+
+        u = parseInt(t, it);
+        if(!u) return NULL;
+
+        if(it < 0 || it > 365) return NULL;
+        
+        t = u;
+
+        r.type = 'n';
+        r.yday = it;
+      
+    } else return NULL;
+
+    if(*t == '/') {
+        t++;
+        u = parseInt(t, it);
+        if(!u) return NULL;
+        
+        t = u;
+        if(it >= -167 && it <= 167) r.hour = it;
+        else return NULL;
+        
+        if(*t == ':') {
+            t++;
+            u = parseInt(t, it);
+            if(!u) return NULL;
+            
+            t = u;
+            if(it >= 0 && it <= 59) r.minute = it;
+            else return NULL;
+            
+            if(*t == ':') {
+                t++;
+                u = parseInt(t, it);
+                if(!u) return NULL;
+                t = u;
+            }
+        }
+    } else {
+        r.hour = 2;    
+    }
+
+    return t;
+}
+
+/*
+ * Calculate DST start/end for given year from rule
+ */
+static bool evalDSTRule(const DSTRule& r, int& DSTyear, int& DSTmonth, int& DSTday, int& DSThour, int& DSTmin, int currYear, int correction)
+{
+    int it, tw, dow;
+
+    DSTyear = currYear;
+    DSThour = r.hour;
+    DSTmin = r.minute;
+    
+    if(r.type == 'M') {
+
+        DSTmonth = r.month;
+        tw = r.week;
+        
+        // wday = weekday (0=Su), tw = week (1,2,3,4=nth week; 5=last)
+        dow = dayOfWeek(1, DSTmonth, currYear);
+        if(dow == 0) dow = 7;
+        DSTday = (r.wday+1) - dow;
+        if(DSTday < 1) DSTday += 7;
+        while(--tw) {
+             DSTday += 7;
+        }
+        if(DSTday > daysInMonth(DSTmonth, currYear)) DSTday -= 7;
+
+    } else if(r.type == 'J') {
+
+        it = r.yday;
+        DSTmonth = 0;
+        while(it > monthDays[DSTmonth]) {
+            it -= monthDays[DSTmonth++];
+        }
+        DSTmonth++;
+        DSTday = it;
+      
+    } else {
+
+        it = r.yday;
+        if((it > 364) && (!isLeapYear(currYear))) return false;
+
+        it++;
+        DSTmonth = 1;
+        while(it > daysInMonth(DSTmonth, currYear)) {
+            it -= daysInMonth(DSTmonth, currYear);
+            DSTmonth++;
+        }
+        DSTday = it;
+      
+    }
+
+    // Correction used for converting DST-end to non-DST
+    if(correction > 0) {
+        DSTmin -= correction;
+        while(DSTmin < 0) {
+            DSTmin += 60;
+            DSThour--;
+        }
+    } else if(correction < 0) {
+        DSTmin -= correction;
+        while(DSTmin > 59) {
+            DSTmin -= 60;
+            DSThour++;
+        }
+    }
+
+    if(DSThour > 23) {
+        while(DSThour > 23) {
+            DSTday++;
+            DSThour -= 24;
+        }
+        while(DSTday > daysInMonth(DSTmonth, DSTyear)) {
+            DSTday -= daysInMonth(DSTmonth, DSTyear);
+            DSTmonth++;
+            if(DSTmonth > 12) {
+                DSTyear++;
+                DSTmonth = 1;
+            }
+        }
+    } else if(DSThour < 0) {
+        while(DSThour < 0) {
+            DSTday--;
+            DSThour += 24;
+        }
+        while(DSTday < 1) {
+            DSTmonth--;
+            if(DSTmonth < 1) {
+                DSTyear--;
+                DSTmonth = 12;
+            }
+            DSTday += daysInMonth(DSTmonth, DSTyear);
+        }
+    }
+    
+    return true;
+}
+
+/*
+ * Drop everything parsed from a TZ string (on change)
+ */
+static void resetTZ(tzZone& z)
+{
+    z.isValid = -1;
+    z.hasDST = -1;
+    z.DSTpart = NULL;
+    z.DSTonMins = -1;
+    z.DSToffMins = 600000;
+    z.ruleValid = false;
+    z.cacheIdx = 0;
+}
+
+static uint32_t hashTZ(const char *tz)
+{
+    uint32_t h = 2166136261UL;      // FNV-1a
+
+    while(*tz) {
+        h ^= (uint8_t)*tz++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+/*
+ * Parse TZ string and setup DST data
+ * 
+ * If TZ-part is bad, always returns FALSE
+ * If DST-part is bad, only returns FALSE once
+ * (DST-part ignored if bad in later calls)
+ * (Until the TZ string is changed)
+ */
+bool tzParse(tzZone& z, const char *tz, int currYear, bool doparseDST)
+{
+    const char *t, *u;
+    int diffNorm = 0;
+    int diffDST = 0;
+    int it;
+    DSTCacheEntry *ce;
+    int DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute;
+    int DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute;
+
+    uint32_t h = hashTZ(tz);
+    if(h != z.strHash) {
+        resetTZ(z);
+        z.strHash = h;
+    }
+
+    z.couldDST = false;
+    z.forYear = 0;
+    z.utlKey = 0;
+    if(!z.DSTpart) {
+        z.diffGMT = z.diffGMTDST = 0;
+    }
+
+    // 0) Basic validity check
+
+    if(*tz == 0) {                                    // Empty string. OK, don't use TZ. So be it.
+        z.hasDST = 0;
+        return true;
+    }
+
+    if(z.isValid < 1) {
+
+        // If previously determined to be invalid, bail.
+        if(!z.isValid) return false;
+
+        // Set TZ to "invalid" until verified
+        z.isValid = 0;
+
+        t = tz;
+        while((t = strchr(t, '>'))) { t++; diffNorm++; }
+        t = tz;
+        while((t = strchr(t, '<'))) { t++; diffDST++; }
+        if(diffNorm != diffDST) return false;         // Uneven < and >, string is bad.
+    }
+
+    // 1) Find difference between nonDST and DST time
+
+    if(!z.DSTpart) {
+
+        diffNorm = diffDST = 0;
+
+        // a. Skip TZ name and parse GMT-diff
+        t = tz;
+        if(*t == '<') {
+           t = strchr(t, '>');
+           if(!t) return false;                       // if <, but no >, string is bad. Bad TZ.
+           t++;
+        } else {
+           while(*t && *t != '-' && (*t < '0' || *t > '9')) {
+              if(*t == ',') return false;
+              t++;
+           }
+        }
+        
+        // t = start of diff to GMT
+        if(*t != '-' && *t != '+' && (*t < '0' || *t > '9'))
+            return false;                             // No numerical difference after name -> bad string. Bad TZ.
+    
+        t = parseInt(t, it);
+        if(it >= -24 && it <= 24) diffNorm = it * 60;
+        else                      return false;       // Bad hr difference. No DST.
+        
+        if(*t == ':') {
+            t++;
+            u = parseInt(t, it);
+            if(!u) return false;                      // No number following ":". Bad string. Bad TZ.
+            t = u;
+            if(it >= 0 && it <= 59) {
+                if(diffNorm < 0)  diffNorm -= it;
+                else              diffNorm += it;
+            } else return false;                      // Bad min difference. Bad TZ.
+            if(*t == ':') {
+                t++;
+                u = parseInt(t, it);
+                if(u) t = u;
+                // Ignore seconds
+            }
+        }
+        
+        // b. Skip DST TZ name and parse GMT-diff
+        
+        if(*t == '<') {
+           t = strchr(t, '>');
+           if(!t) return false;                       // if <, but no >, string is bad. Bad TZ.
+           t++;
+        } else {
+           while(*t && *t != ',' && *t != '-' && (*t < '0' || *t > '9'))
+              t++;
+        }
+        
+        // t = assumed start of DST-diff to GMT
+        if(*t == 0) {
+            z.diff = 0;
+        } else if(*t != '-' && *t != '+' && (*t < '0' || *t > '9')) {
+            z.diff = 60;                       // No numerical difference after name -> Assume 1 hr
+        } else {
+            t = parseInt(t, it);
+            if(it >= -24 && it <= 24) diffDST = it * 60;
+            else                      return false;   // Bad hr difference. Bad TZ.
+            if(*t == ':') {
+                t++;
+                u = parseInt(t, it);
+                if(!u) return false;                  // No number following ":". Bad TZ.
+                t = u;
+                if(it >= 0 && it <= 59) {
+                    if(diffDST < 0)  diffDST -= it;
+                    else             diffDST += it;
+                } else return false;                  // Bad min difference. Bad TZ.
+                if(*t == ':') {
+                    t++;
+                    u = parseInt(t, it);
+                    if(u) t = u;
+                    // Ignore seconds
+                }
+            }
+            z.diff = -(diffDST - diffNorm); //abs(diffDST - diffNorm);
+        }
+    
+        z.diffGMT = diffNorm;
+        z.diffGMTDST = z.diffGMT - z.diff;
+    
+        z.DSTpart = t;
+
+        z.isValid = 1;   // TZ is valid
+
+    } else {
+
+        t = z.DSTpart;
+      
+    }
+
+    if(!z.hasDST || !doparseDST) {
+        return true;
+    }
+    
+    if(*t == 0 || *t != ',') {                        // No DST definition. No DST.
+        z.hasDST = 0;
+        return true;
+    }
+
+    t++;
+
+    z.forYear = currYear;
+
+    // Set to "no DST" until verified valid
+    z.hasDST = 0;
+
+    // 2) parse DST start and end rules (once)
+
+    if(!z.ruleValid) {
+        u = parseDSTRule(t, z.rule[0]);
+        if(!u) return false;
+        t = u;
+        if(*t == 0 || *t != ',') return false;      // Have start, but no end. Bad string. No DST.
+        t++;
+        if(!parseDSTRule(t, z.rule[1])) return false;
+        for(int i = 0; i < DST_CACHE_SIZE; i++) {
+            z.cache[i].year = -32768;
+        }
+        z.ruleValid = true;
+    }
+
+    // 3) Look up year in cache
+
+    for(int i = 0; i < DST_CACHE_SIZE; i++) {
+        ce = &z.cache[i];
+        if(ce->year == currYear) {
+            z.hasDST = 1;
+            z.couldDST = ce->couldDST;
+            z.DSTonMins = ce->onMins;
+            z.DSToffMins = ce->offMins;
+            return true;
+        }
+    }
+
+    // 4) Calculate DST start
+
+    if(!evalDSTRule(z.rule[0], DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute, currYear, 0))
+        return false;
+
+    // If start crosses end year (due to hour numbers >= 24), need to calculate 
+    // for previous year (which then might be in current year). 
+    // The same goes for the other direction vice versa.
+    if(DSTonYear > currYear) {
+        if(!evalDSTRule(z.rule[0], DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute, currYear-1, 0))
+            return false;
+        // Trigger check below if still outside of current year
+        if(DSTonYear != currYear) DSTonYear = currYear + 1;
+    } else if(DSTonYear < currYear) {
+        if(!evalDSTRule(z.rule[0], DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute, currYear+1, 0))
+            return false;
+        // Trigger check below if still outside of current year
+        if(DSTonYear != currYear) DSTonYear = currYear - 1;
+    }
+
+    // 5) Calculate DST end
+
+    if(!evalDSTRule(z.rule[1], DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute, currYear, z.diff))
+        return false;
+
+    // See above
+    if(DSToffYear > currYear) {
+        if(!evalDSTRule(z.rule[1], DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute, currYear-1, z.diff))
+            return false;
+        // Trigger check below if still outside of current year
+        if(DSToffYear != currYear) DSToffYear = currYear + 1;
+    } else if(DSToffYear < currYear) {
+        if(!evalDSTRule(z.rule[1], DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute, currYear+1, z.diff))
+            return false;
+        // Trigger check below if still outside of current year
+        if(DSToffYear != currYear) DSToffYear = currYear - 1;
+    }
+
+    // 6) Evaluate results
+
+    z.hasDST = 1;  // TZ has valid DST definition
+
+    if((DSToffMonth == DSTonMonth) && (DSToffDay == DSTonDay)) {
+        z.couldDST = false;
+        #ifdef TC_DBG
+        Serial.printf("parseTZ: (%s) DST not used\n", tz);
+        #endif
+    } else {
+        z.couldDST = true;
+
+        // If start or end still beyond our current year, set to impossible values
+        // to allow a valid comparison.
+        // Despire our cross-end-check for currYear above, this still can happen!
+        // Eg: "CRAZY-3:30<C3ACY>4:56,M1.1.0/-48,M12.5.0/48"
+        // For 2023, first calculated start is on 12/30/2022, so we do 2024 above, 
+        // but for 2024 start is on 1/5/2024. Nothing in 2023!
+        // Likewise 2023's first calculated end is on 1/2/2024, so we do 2022 above,
+        // but for 2022, it is on 12/27/2022. Again, outside of our current year!
+        // So with this somewhat challenging time zone definition, the entire year 
+        // 2023 is DST. Need to set -1/600000 to make comparison right.
+        if(DSTonYear < currYear)
+            z.DSTonMins = -1;
+        else if(DSTonYear > currYear)
+            z.DSTonMins = 600000;
+        else 
+            z.DSTonMins = mins2Date(currYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute);
+    
+        if(DSToffYear < currYear)
+            z.DSToffMins = -1;
+        else if(DSToffYear > currYear)
+            z.DSToffMins = 600000;
+        else {
+            z.DSToffMins = mins2Date(currYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute);
+        }
+
+        #ifdef TC_DBG
+        Serial.printf("parseTZ: (%s) %d/%d(%d) DST %d-%02d-%02d/%02d:%02d - %d-%02d-%02d/%02d:%02d\n",
+                    tz,
+                    z.diffGMT, z.diffGMTDST, z.diff,
+                    DSTonYear, DSTonMonth, DSTonDay, DSTonHour, DSTonMinute,
+                    DSToffYear, DSToffMonth, DSToffDay, DSToffHour, DSToffMinute);
+        #endif
+
+    }
+
+    // Store in cache (round robin)
+    ce = &z.cache[z.cacheIdx];
+    ce->year = currYear;
+    ce->couldDST = z.couldDST;
+    ce->onMins = z.DSTonMins;
+    ce->offMins = z.DSToffMins;
+    z.cacheIdx = (z.cacheIdx + 1) % DST_CACHE_SIZE;
+        
+    return true;
+}
+
+/*
+ * Check if given local date/time is within DST period.
+ * Given "Local" is assumed be be non-DST.
+ */
+int tzIsDST(const tzZone& z, int year, int month, int day, int hour, int mins, int& currTimeMins)
+{
+    currTimeMins = mins2Date(year, month, day, hour, mins);
+
+    // DSTxxMins is in non-DST local time (End corrected from DST to non-DST in parseTZ)
+    if(z.DSTonMins < z.DSToffMins) {
+        if((currTimeMins >= z.DSTonMins) && (currTimeMins < z.DSToffMins))
+            return 1;
+        else 
+            return 0;
+    } else {
+        if((currTimeMins >= z.DSToffMins) && (currTimeMins < z.DSTonMins))
+            return 0;
+        else
+            return 1;
+    }
+}
+
+/*
+ * Conversion from/to UTC
+ */
+void convTime(int diff, int& y, int& m, int& d, int& h, int& mm)
+{
+    
+    if(diff > 0) {
+
+        mm -= diff;
+        while(mm < 0) {
+            mm += 60;
+            h--;
+        }
+        while(h < 0) {
+            h += 24;
+            d--;
+        }
+        while(d < 1) {
+            m--;
+            if(m < 1) {
+                m = 12;
+                y--;
+                if(y < 1) y = 9999;
+            }
+            d += daysInMonth(m, y);
+        }
+        
+    } else if(diff < 0) {
+
+        mm -= diff;
+        while(mm > 59) {
+            mm -= 60;
+            h++;
+        }
+        while(h > 23) {
+            h -= 24;
+            d++;
+        }
+        while(d > daysInMonth(m, y)) {
+            d -= daysInMonth(m, y);
+            m++;
+            if(m > 12) {
+                m = 1;
+                y++;
+                if(y > 9999) y = 1;
+            }
+        }
+
+    }
+}
+
+/*
+ * Convert UTC to local time in zone z (TZ string tz)
+ * Local time only changes with the UTC minute, so the result
+ * is cached; returns true if a full conversion was done.
+ */
+bool tzUTCtoLocal(tzZone& z, const char *tz, int& y, int& m, int& d, int& h, int& mm)
+{
+    int uy = y, um = m, ud = d, uh = h, umm = mm;
+    uint64_t key = ((uint64_t)uy << 26) | (um << 21) | (ud << 16) | (uh << 8) | umm;
+    int ctm = 0;
+
+    if(key == z.utlKey) {
+        y = z.utlLocal[0]; m = z.utlLocal[1]; d = z.utlLocal[2];
+        h = z.utlLocal[3]; mm = z.utlLocal[4];
+        return false;
+    }
+
+    convTime(z.diffGMT, y, m, d, h, mm);
+    
+    if(z.couldDST) {
+        if(z.forYear != y) {
+            tzParse(z, tz, y);
+        }
+        if(tzIsDST(z, y, m, d, h, mm, ctm)) {
+            y = uy; m = um; d = ud; h = uh; mm = umm;
+            convTime(z.diffGMTDST, y, m, d, h, mm);
+        }
+    }
+
+    z.utlKey = key;
+    z.utlLocal[0] = y;  z.utlLocal[1] = m;  z.utlLocal[2] = d;
+    z.utlLocal[3] = h;  z.utlLocal[4] = mm;
+
+    return true;
+}
+
+/*
+ * Convert local time in zone z to UTC
+ */
+void tzLocalToUTC(const tzZone& z, int& y, int& m, int& d, int& h, int& mm)
+{
+    int ctm;
+    int diff = z.diffGMT;
+
+    if(z.couldDST) {
+        if(tzIsDST(z, y, m, d, h, mm, ctm)) {
+            diff = z.diffGMTDST;
+        }
+    }
+
+    convTime(-diff, y, m, d, h, mm);
+}
@@ -0,0 +1,109 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2021-2022 John deGlavina https://circuitsetup.us
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Time zone and DST handling
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_TZ_H
+#define _TC_TZ_H
+
+#include <stdint.h>
+
+// A DST rule (start or end) as parsed from a TZ string
+typedef struct {
+    char    type;       // 'M' (Mm.w.d), 'J' (Jn) or 'n' (zero-based day of year)
+    int8_t  month;
+    int8_t  week;
+    int8_t  wday;
+    int16_t yday;
+    int16_t hour;
+    int8_t  minute;
+} DSTRule;
+
+// DST start and end for one year
+typedef struct {
+    int     year;
+    int     onMins;
+    int     offMins;
+    bool    couldDST;
+} DSTCacheEntry;
+
+#define DST_CACHE_SIZE 4
+
+// State of a time zone. Zero-initialized is fine; everything
+// is set up from the TZ string on the first tzParse().
+typedef struct {
+    uint32_t    strHash;        // TZ string the data below is for
+    int         forYear;        // Parsing done for this very year
+    int8_t      isValid;
+    int8_t      hasDST;
+    bool        couldDST;       // Could use own DST management (and DST is defined in TZ)
+    const char  *DSTpart;
+    int         diffGMT;        // Difference to UTC in nonDST time
+    int         diffGMTDST;     // Difference to UTC in DST time
+    int         diff;           // difference between DST and non-DST in minutes
+    int         DSTonMins;      // DST-on date/time in minutes since 1/1 00:00 (in non-DST time)
+    int         DSToffMins;     // DST-off date/time in minutes since 1/1 00:00 (in DST time)
+    // DST rules are parsed once; results are cached per year
+    DSTRule     rule[2];        // Start, end
+    bool        ruleValid;
+    DSTCacheEntry cache[DST_CACHE_SIZE];
+    uint8_t     cacheIdx;
+    // Last UTC minute converted by tzUTCtoLocal(), and its local result
+    uint64_t    utlKey;
+    uint16_t    utlLocal[5];
+} tzZone;
+
+bool  tzParse(tzZone& z, const char *tz, int currYear, bool doparseDST = true);
+int   tzIsDST(const tzZone& z, int year, int month, int day, int hour, int mins, int& currTimeMins);
+bool  tzUTCtoLocal(tzZone& z, const char *tz, int& y, int& m, int& d, int& h, int& mm);
+void  tzLocalToUTC(const tzZone& z, int& y, int& m, int& d, int& h, int& mm);
+void  convTime(int diff, int& y, int& m, int& d, int& h, int& mm);
+
+#endif
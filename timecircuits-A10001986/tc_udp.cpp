@@ -0,0 +1,208 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Queued asynchronous UDP
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+
+#include "tc_udp.h"
+
+tcUDP::tcUDP(tcUDPFilter filter)
+{
+    _filter = filter;
+}
+
+uint8_t tcUDP::begin(uint16_t port)
+{
+    if(!_udp.listen(port))
+        return 0;
+
+    _udp.onPacket([this](AsyncUDPPacket& packet) {
+        onPacket(packet);
+    });
+    
+    return 1;
+}
+
+uint8_t tcUDP::beginMulticast(IPAddress ip, uint16_t port)
+{
+    if(!_udp.listenMulticast(ip, port))
+        return 0;
+
+    _udp.onPacket([this](AsyncUDPPacket& packet) {
+        onPacket(packet);
+    });
+    
+    return 1;
+}
+
+// Runs on the network task
+void tcUDP::onPacket(AsyncUDPPacket& packet)
+{
+    int64_t  us = esp_timer_get_time();
+    size_t   len = packet.length();
+    uint32_t head = __atomic_load_n(&_qHead, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&_qTail, __ATOMIC_ACQUIRE);
+
+    if(len > TCUDP_MAX_PKT) len = TCUDP_MAX_PKT;
+
+    if(_filter && !_filter(packet.data(), len))
+        return;
+
+    if(head - tail >= TCUDP_QUEUE) {
+        _dropped++;
+        return;
+    }
+
+    tcUDPPkt *p = &_q[head & (TCUDP_QUEUE - 1)];
+    memcpy(p->data, packet.data(), len);
+    p->len = len;
+    p->ip = (uint32_t)packet.remoteIP();
+    p->port = packet.remotePort();
+    p->us = us;
+
+    __atomic_store_n(&_qHead, head + 1, __ATOMIC_RELEASE);
+}
+
+// Fetch next packet from queue; returns its size, or 0 if none
+int tcUDP::parsePacket()
+{
+    uint32_t tail = __atomic_load_n(&_qTail, __ATOMIC_RELAXED);
+    
+    _haveCur = false;
+    
+    if(tail == __atomic_load_n(&_qHead, __ATOMIC_ACQUIRE))
+        return 0;
+
+    _cur = _q[tail & (TCUDP_QUEUE - 1)];
+    _haveCur = true;
+
+    __atomic_store_n(&_qTail, tail + 1, __ATOMIC_RELEASE);
+
+    return _cur.len;
+}
+
+int tcUDP::read(uint8_t *buf, size_t len)
+{
+    if(!_haveCur)
+        return 0;
+
+    if(len > _cur.len) len = _cur.len;
+    memcpy(buf, _cur.data, len);
+
+    return len;
+}
+
+void tcUDP::flush()
+{
+    _haveCur = false;
+}
+
+IPAddress tcUDP::remoteIP()
+{
+    return IPAddress(_cur.ip);
+}
+
+uint16_t tcUDP::remotePort()
+{
+    return _cur.port;
+}
+
+int64_t tcUDP::rxStamp()
+{
+    return _cur.us;
+}
+
+int tcUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    _txIP = ip;
+    _txPort = port;
+    _txLen = 0;
+    _txOk = true;
+    
+    return 1;
+}
+
+int tcUDP::beginPacket(const char *host, uint16_t port)
+{
+    IPAddress ip;
+
+    if(!WiFi.hostByName(host, ip)) {
+        _txOk = false;
+        return 0;
+    }
+
+    return beginPacket(ip, port);
+}
+
+size_t tcUDP::write(const uint8_t *buf, size_t len)
+{
+    if(!_txOk)
+        return 0;
+        
+    if(len > TCUDP_MAX_PKT - _txLen) len = TCUDP_MAX_PKT - _txLen;
+    memcpy(_tx + _txLen, buf, len);
+    _txLen += len;
+
+    return len;
+}
+
+int tcUDP::endPacket()
+{
+    if(!_txOk)
+        return 0;
+
+    _txOk = false;
+    
+    return (_udp.writeTo(_tx, _txLen, _txIP, _txPort) == _txLen) ? 1 : 0;
+}
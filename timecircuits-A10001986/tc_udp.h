@@ -0,0 +1,128 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * Queued asynchronous UDP
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_UDP_H
+#define _TC_UDP_H
+
+#include <AsyncUDP.h>
+
+/*
+ * Queued asynchronous UDP
+ *
+ * Packets are received by AsyncUDP's callback on the network
+ * task, checked by an optional filter there, time-stamped and 
+ * put in a small queue. The main loop fetches them through the 
+ * usual parsePacket()/read()/remoteIP() calls, so packets are
+ * not lost or delayed while the loop is busy.
+ * Sending goes through the same (bound) socket.
+ */
+
+#define TCUDP_MAX_PKT  48
+#define TCUDP_QUEUE     8    // power of 2
+
+// Filter runs on the network task: Must be quick, must not
+// touch any state of the main loop
+typedef bool (*tcUDPFilter)(const uint8_t *buf, size_t len);
+
+class tcUDP {
+
+    public:
+
+        tcUDP(tcUDPFilter filter = NULL);
+
+        uint8_t   begin(uint16_t port);
+        uint8_t   beginMulticast(IPAddress ip, uint16_t port);
+
+        int       parsePacket();
+        int       read(uint8_t *buf, size_t len);
+        void      flush();
+        IPAddress remoteIP();
+        uint16_t  remotePort();
+        int64_t   rxStamp();      // esp_timer time of reception
+
+        int       beginPacket(IPAddress ip, uint16_t port);
+        int       beginPacket(const char *host, uint16_t port);
+        size_t    write(const uint8_t *buf, size_t len);
+        int       endPacket();
+
+        uint32_t  dropped() { return _dropped; }
+
+    private:
+
+        void      onPacket(AsyncUDPPacket& packet);
+
+        typedef struct {
+            uint8_t   data[TCUDP_MAX_PKT];
+            uint8_t   len;
+            uint32_t  ip;
+            uint16_t  port;
+            int64_t   us;
+        } tcUDPPkt;
+
+        AsyncUDP      _udp;
+        tcUDPFilter   _filter;
+
+        tcUDPPkt      _q[TCUDP_QUEUE];
+        uint32_t      _qHead = 0;     // written by network task
+        uint32_t      _qTail = 0;     // written by main loop
+        uint32_t      _dropped = 0;
+
+        tcUDPPkt      _cur;
+        bool          _haveCur = false;
+
+        uint8_t       _tx[TCUDP_MAX_PKT];
+        size_t        _txLen = 0;
+        IPAddress     _txIP;
+        uint16_t      _txPort = 0;
+        bool          _txOk = false;
+};
+
+#endif
@@ -54,11 +54,21 @@
 
 #include <Arduino.h>
 
+#define ARDUINOJSON_USE_LONG_LONG 0
+#define ARDUINOJSON_USE_DOUBLE 0
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 0
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 0
+#define ARDUINOJSON_ENABLE_STD_STREAM 0
+#define ARDUINOJSON_ENABLE_STD_STRING 0
+#define ARDUINOJSON_ENABLE_NAN 0
+#include <ArduinoJson.h>  // https://github.com/bblanchon/ArduinoJson
+
 #ifdef TC_MDNS
 #include <ESPmDNS.h>
 #endif
 
 #include "src/WiFiManager/WiFiManager.h"
+#include "tc_assets.h"
 
 #include "clockdisplay.h"
 #include "tc_menus.h"
@@ -67,8 +77,22 @@
 #include "tc_settings.h"
 #include "tc_wifi.h"
 #include "tc_keypad.h"
+#include "tc_mem.h"
+#include "tc_prof.h"
+#include "tc_sched.h"
+#include "tc_boot.h"
+#include "tc_bench.h"
+#include "tc_stall.h"
+#include "tc_cmd.h"
+#include "tc_state.h"
+#ifdef TC_WEBSOCKET
+#include "tc_ws.h"
+#endif
 #ifdef TC_HAVEMQTT
 #include "mqtt.h"
+#ifdef TC_MQTT_TASK
+#include <freertos/ringbuf.h>
+#endif
 #endif
 
 // If undefined, use the checkbox/dropdown-hacks.
@@ -77,6 +101,45 @@
 
 #define STRLEN(x) (sizeof(x)-1)
 
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+#define DECLARE_S_JSON(x,n) JsonDocument n; memNoteJson(0);
+#else
+#define DECLARE_S_JSON(x,n) StaticJsonDocument<x> n;
+#endif
+
+// JSON status API: Snapshot, re-built only when state changes
+#define API_JSON_SIZE   2560
+#define API_BUF_SIZE    1664
+#define API_CHECK_INT   1000
+typedef struct {
+    uint16_t dtYear, ptYear, ltYear;
+    uint8_t  dtMon, dtDay, dtHour, dtMin;
+    uint8_t  ptMon, ptDay, ptHour, ptMin;
+    uint8_t  ltMon, ltDay, ltHour, ltMin;
+    int16_t  temp;          // * 10
+    int16_t  hum;
+    int32_t  lux;
+    int8_t   rssi;
+    uint8_t  wifiMode;
+    uint8_t  numClients;
+    uint16_t clientSum;     // Checksum over client info
+    uint16_t freeHeapK;
+    uint16_t minHeapK;
+    memStats mem;
+    uint16_t loopRate;
+    uint16_t loopMax;
+    uint8_t  pwrState;
+    uint32_t pwrSecs[PWR_NUM_ST];
+    uint32_t pwrSlept;
+} apiState;
+static apiState      apiCurState;
+static char          apiStatusBuf[API_BUF_SIZE] = "{}";
+static size_t        apiStatusLen = 2;
+static unsigned long apiLastCheck = 0;
+static unsigned long apiLoopCnt = 0;
+static unsigned long apiLoopLast = 0;
+static unsigned long apiLoopMax = 0;
+
 Settings settings;
 
 IPSettings ipsettings;
@@ -98,7 +161,7 @@ static const char acul_part5[]  = "</h1><h3>";
 static const char acul_part6[]  = "</h3><div class='msg";
 static const char acul_part7[]  = " S'><strong>Upload successful.</strong><br>Installation will proceed...";
 static const char acul_part71[] = " D'><strong>Upload failed.</strong><br>";
-static const char *acul_errs[]  = { "Can't open file on SD", "No SD card found", "Write error", "Aborted", "Bad file" };
+static const char *acul_errs[]  = { "Can't open file on SD", "No SD card found", "Write/verify error", "Aborted", "Bad file" };
 static const char acul_part8[]  = "</div></div></body></html>";
 
 static const char *osde = "</option></select></div>";
@@ -392,7 +455,7 @@ static const char* wifiMenu[TC_MENUSIZE] = {"wifi", "param", "sep", "update", "s
 
 static const char apName[]  = "TCD-AP";
 static const char myTitle[] = "Time Circuits";
-static const char myHead[]  = "<link rel='shortcut icon' type='image/png' href='data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAABAAAAAQCAMAAAAoLQ9TAAAAGXRFWHRTb2Z0d2FyZQBBZG9iZSBJbWFnZVJlYWR5ccllPAAAAA9QTFRFjpCRzMvH9tgx8iU9Q7YkHP8yywAAAC1JREFUeNpiYEQDDIwMKAAkwIwEiBTAMIMFCRApgGEGExIgUgDDDHQBNAAQYADhYgGBZLgAtAAAAABJRU5ErkJggg=='><script>function wlp(){return window.location.pathname;}function getn(x){return document.getElementsByTagName(x)}function ge(x){return document.getElementById(x)}function c(l){ge('s').value=l.getAttribute('data-ssid')||l.innerText||l.textContent;p=l.nextElementSibling.classList.contains('l');ge('p').disabled=!p;if(p){ge('p').placeholder='';ge('p').focus();}}uacs1=\"(function(el){document.getElementById('uacb').style.display = el.value=='' ? 'none' : 'initial';})(this)\";uacstr=\"Upload audio data (TCDA.bin)<br><form method='POST' action='uac' enctype='multipart/form-data' onchange=\\\"\"+uacs1+\"\\\"><input type='file' name='upac' accept='.bin,application/octet-stream'><button id='uacb' type='submit' class='h D'>Upload</button></form>\";window.onload=function(){xx=false;document.title='Time Circuits';if(ge('s')&&ge('dns')){xx=true;xxx=document.title;yyy='Configure WiFi';aa=ge('s').parentElement;bb=aa.innerHTML;dd=bb.search('<hr>');ee=bb.search('<button');cc='<div class=\"sects\">'+bb.substring(0,dd)+'</div><div class=\"sects\">'+bb.substring(dd+4,ee)+'</div>'+bb.substring(ee);aa.innerHTML=cc;document.querySelectorAll('a[href=\"#p\"]').forEach((userItem)=>{userItem.onclick=function(){c(this);return false;}});if(aa=ge('s')){aa.oninput=function(){if(this.placeholder.length>0&&this.value.length==0){ge('p').placeholder='********';}}}}if(ge('uploadbin')){aa=document.getElementsByClassName('wrap');if(aa.length>0){aa[0].insertAdjacentHTML('beforeend',uacstr);}}if(ge('uploadbin')||wlp()=='/u'||wlp()=='/uac'||wlp()=='/wifisave'||wlp()=='/paramsave'){xx=true;xxx=document.title;yyy=(wlp()=='/wifisave')?'Configure WiFi':(wlp()=='/paramsave'?'Setup':'Firmware update');aa=document.getElementsByClassName('wrap');if(aa.length>0){if((bb=ge('uploadbin'))){aa[0].style.textAlign='center';bb.parentElement.onsubmit=function(){aa=ge('uploadbin');if(aa){aa.disabled=true;aa.innerHTML='Please wait'}aa=ge('uacb');if(aa){aa.disabled=true}};if((bb=ge('uacb'))){aa[0].style.textAlign='center';bb.parentElement.onsubmit=function(){aa=ge('uacb');if(aa){aa.disabled=true;aa.innerHTML='Please wait'}aa=ge('uploadbin');if(aa){aa.disabled=true}}}}aa=getn('H3');if(aa.length>0){aa[0].remove()}aa=getn('H1');if(aa.length>0){aa[0].remove()}}}if(ge('ttrp')||wlp()=='/param'){xx=true;xxx=document.title;yyy='Setup';}if(ge('ebnew')){xx=true;bb=getn('H3');aa=getn('H1');xxx=aa[0].innerHTML;yyy=bb[0].innerHTML;ff=aa[0].parentNode;ff.style.position='relative';}if(xx){zz=(Math.random()>0.8);dd=document.createElement('div');dd.classList.add('tpm0');dd.innerHTML='<div class=\"tpm\" onClick=\"window.location=\\'/\\'\"><div class=\"tpm2\"><img src=\"data:image/png;base64,'+(zz?'iVBORw0KGgoAAAANSUhEUgAAAEAAAABACAMAAACdt4HsAAAAGXRFWHRTb2Z0d2FyZQBBZG9iZSBJbWFnZVJlYWR5ccllPAAAAAZQTFRFSp1tAAAA635cugAAAAJ0Uk5T/wDltzBKAAAAbUlEQVR42tzXwRGAQAwDMdF/09QQQ24MLkDj77oeTiPA1wFGQiHATOgDGAp1AFOhDWAslAHMhS6AQKgCSIQmgEgoAsiEHoBQqAFIhRaAWCgByIVXAMuAdcA6YBlwALAKePzgd71QAByP71uAAQC+xwvdcFg7UwAAAABJRU5ErkJggg==':'iVBORw0KGgoAAAANSUhEUgAAAEAAAABACAMAAACdt4HsAAAAGXRFWHRTb2Z0d2FyZQBBZG9iZSBJbWFnZVJlYWR5ccllPAAAAAZQTFRFSp1tAAAA635cugAAAAJ0Uk5T/wDltzBKAAAAgElEQVR42tzXQQqDABAEwcr/P50P2BBUdMhee6j7+lw8i4BCD8MiQAjHYRAghAh7ADWMMAcQww5jADHMsAYQwwxrADHMsAYQwwxrADHMsAYQwwxrgLgOPwKeAjgrrACcFkYAzgu3AN4C3AV4D3AP4E3AHcDF+8d/YQB4/Pn+CjAAMaIIJuYVQ04AAAAASUVORK5CYII=')+'\" class=\"tpm3\"></div><H1 class=\"tpmh1\"'+(zz?' style=\"margin-left:1.2em\"':'')+'>'+xxx+'</H1>'+'<H3 class=\"tpmh3\"'+(zz?' style=\"padding-left:4.5em\"':'')+'>'+yyy+'</div></div>';}if(ge('ebnew')){bb[0].remove();aa[0].replaceWith(dd);}if((ge('s')&&ge('dns'))||ge('uploadbin')||wlp()=='/u'||wlp()=='/uac'||wlp()=='/wifisave'||wlp()=='/paramsave'||ge('ttrp')||wlp()=='/param'){aa=document.getElementsByClassName('wrap');if(aa.length>0){aa[0].insertBefore(dd,aa[0].firstChild);aa[0].style.position='relative';}}}</script><style type='text/css'>body{font-family:-apple-system,BlinkMacSystemFont,system-ui,'Segoe UI',Roboto,'Helvetica Neue',Verdana,Helvetica}H1,H2{margin-top:0px;margin-bottom:0px;text-align:center;}H3{margin-top:0px;margin-bottom:5px;text-align:center;}div.msg{border:1px solid #ccc;border-left-width:15px;border-radius:20px;background:linear-gradient(320deg,rgb(255,255,255) 0%,rgb(235,234,233) 100%);}button{transition-delay:250ms;margin-top:10px;margin-bottom:10px;color:#fff;background-color:#225a98;font-variant-caps:all-small-caps;}button.DD{color:#000;border:4px ridge #999;border-radius:2px;background:#e0c942;background-image:url('data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAACAAAAAgCAMAAABEpIrGAAAAGXRFWHRTb2Z0d2FyZQBBZG9iZSBJbWFnZVJlYWR5ccllPAAAADBQTFRF////AAAAMyks8+AAuJYi3NHJo5aQAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAbP19EwAAAAh0Uk5T/////////wDeg71ZAAAA4ElEQVR42qSTyxLDIAhF7yChS/7/bwtoFLRNF2UmRr0H8IF4/TBsY6JnQFvTJ8D0ncChb0QGlDvA+hkw/yC4xED2Z2L35xwDRSdqLZpFIOU3gM2ox6mA3tnDPa8UZf02v3q6gKRH/Eyg6JZBqRUCRW++yFYIvCjNFIt9OSC4hol/ItH1FkKRQgAbi0ty9f/F7LM6FimQacPbAdG5zZVlWdfvg+oEpl0Y+jzqIJZ++6fLqlmmnq7biZ4o67lgjBhA0kvJyTww/VK0hJr/LHvBru8PR7Dpx9MT0f8e72lvAQYALlAX+Kfw0REAAAAASUVORK5CYII=');background-repeat:no-repeat;background-origin:content-box;background-size:contain;}br{display:block;font-size:1px;content:''}input[type='checkbox']{display:inline-block;margin-top:10px}input{border:thin inset}small{display:none}em > small{display:inline}form{margin-block-end:0;}.tpm{cursor:pointer;border:1px solid black;border-radius:5px;padding:0 0 0 0px;min-width:18em;}.tpm2{position:absolute;top:-0.7em;z-index:130;left:0.7em;}.tpm3{width:4em;height:4em;}.tpmh1{font-variant-caps:all-small-caps;font-weight:normal;margin-left:2em;}.tpmh3{background:#000;font-size:0.6em;color:#ffa;padding-left:7em;margin-left:0.5em;margin-right:0.5em;border-radius:5px}.sects{background-color:#eee;border-radius:7px;margin-bottom:20px;padding-bottom:7px;padding-top:7px}.tpm0{position:relative;width:20em;margin:0 auto 0 auto;}.headl{margin:0 0 5px 0;padding:0}.cmp0{margin:0;padding:0;}.sel0{font-size:90%;width:auto;margin-left:10px;vertical-align:baseline;}.mt5{margin-top:5px!important}</style>";
+static const char myHead[]  = "<link rel='shortcut icon' type='image/png' href='data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAABAAAAAQCAMAAAAoLQ9TAAAAGXRFWHRTb2Z0d2FyZQBBZG9iZSBJbWFnZVJlYWR5ccllPAAAAA9QTFRFjpCRzMvH9tgx8iU9Q7YkHP8yywAAAC1JREFUeNpiYEQDDIwMKAAkwIwEiBTAMIMFCRApgGEGExIgUgDDDHQBNAAQYADhYgGBZLgAtAAAAABJRU5ErkJggg=='><script src='/tcd.js?v=" TC_JS_ETAG "'></script><link rel='stylesheet' href='/tcd.css?v=" TC_CSS_ETAG "'>";
 static const char* myCustMenu = "<form action='/erase' method='get' onsubmit='return confirm(\"This erases the WiFi config and reboots. The TCD will restart in access point mode. Are you sure?\");'><button id='ebnew' class='DD'>Erase WiFi Config</button></form><br/><img style='display:block;margin:10px auto 10px auto;' src='data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAR8AAAAyCAYAAABlEt8RAAAAGXRFWHRTb2Z0d2FyZQBBZG9iZSBJbWFnZVJlYWR5ccllPAAADQ9JREFUeNrsXTFzG7sRhjTuReYPiGF+gJhhetEzTG2moFsrjVw+vYrufOqoKnyl1Zhq7SJ0Lc342EsT6gdIof+AefwFCuksnlerBbAA7ygeH3bmRvTxgF3sLnY/LMDzjlKqsbgGiqcJXEPD97a22eJKoW2mVqMB8HJRK7D/1DKG5fhH8NdHrim0Gzl4VxbXyeLqLK4DuDcGvXF6P4KLG3OF8JtA36a2J/AMvc/xTh3f22Q00QnSa0r03hGOO/Wws5Y7RD6brbWPpJ66SNHl41sTaDMSzMkTxndriysBHe/BvVs0XyeCuaEsfqblODHwGMD8+GHEB8c1AcfmJrurbSYMHK7g8CC4QknS9zBQrtSgO22gzJNnQp5pWOyROtqa7k8cOkoc+kyEOm1ZbNAQyv7gcSUryJcG+kiyZt9qWcagIBhkjn5PPPWbMgHX1eZoVzg5DzwzDKY9aFtT5aY3gknH0aEF/QxRVpDyTBnkxH3WvGmw0zR32Pu57XVUUh8ZrNm3hh7PVwQ+p1F7KNWEOpjuenR6wEArnwCUqPJT6IQ4ZDLQEVpm2eg9CQQZY2wuuJicD0NlG3WeWdedkvrILxak61rihbR75bGyOBIEHt+lLDcOEY8XzM0xYt4i2fPEEdV+RUu0I1BMEc70skDnuUVBtgWTX9M+GHrikEuvqffJ+FOiS6r3AYLqB6TtwBA0ahbko8eQMs9OBY46KNhetgDo0rWp76/o8wVBBlOH30rloz5CJ1zHgkg0rw4EKpygTe0wP11Lob41EdiBzsEvyMZ6HFNlrtFeGOTLLAnwC/hzBfGYmNaICWMAaY2h5WgbCuXTnGo7kppPyhT+pHUAGhRM/dYcNRbX95mhXpB61FUSQV2illPNJ7TulgT0KZEzcfitywdTZlJL5W5Z2g2E/BoW32p5+GuN8bvOCrU+zo4VhscPmSTLrgGTSaU0smTpslAoBLUhixZT+6Ftb8mS15SRJciH031IpoxLLxmCqwXOj0YgvxCaMz46Ve7dWd9VRMbwSKXBZxKooEhmkgSC1BKwpoaAc+DB0wStv+VQ48qLNqHwHZJoKiWQea+guTyX2i8k+Pg4Q8UDDWwqdQrIOjWBXjKhsx8wur5gkkVFiOj2Eep6rsn/pWTop1aAjxRBGYO48w5AEymPF2ucuPMcg08ivBfqSAnK/LiwN1byA5Mt4VLJFHxsQX/CBPmGAxn5OFmKglpL+W3nSu01tPjDlKCvQcF+emRYCk8DbS1tV8lhXvmUBpbPvSKJ6z+L6xR0nAnGmTBjHRIeeJPqEPFIQoLPNzIJXUasgIL2LevbVeh9gcFn39D/rSALJyhQvHGs732zVM3yXYM48hTZjAs6YwfvpTP9ghx9WIC9UsskzUDfB2tCX2885cMJqqWenqdKcw4itZx8a6D4Ix7v4f6Jo69DZqxj4h8DJmljHr/vzEmDzxR1VvE0okY9iSovzUFxWcAk08uINEd5uL4o8tE222Oys2scExS8Xj1TDWPp0P/a0KXXvsXWpw7k00D2OBEu12z8LjyXeXry7zE8hiDXKstG/dOY1MAjBR2IDxlWPByXQ02tktZ7NOlT2kcBbS9UMYXbOYHD9ADhxBCYpDWJ0TPXXUYEUZeBTgVJdhlQv0Iw2SPzxBcd/xagmyn4wxeDnw9z0MMEeIwNPEY+yOdgBUFSlX8BrshDhmOydEwQgvjogOOmDJ7lIFfGGPjQEGAy8nyFPDsVyo2XXmMGcq9ir4lgkuClV5FFXO6QYQi/VSZuyK8HQksZU7BpC2TeJ3O9Y+ibO2SYWXi00LJ9j/Bo7BZgxJck4r0pALanzJU3ZernL6CVMAsvx/4Pj+eVZSnbckyGzIB8bpnnG4xjSLKX3nZfdenF2SvznMxFHvGYeMp3C7b+1VHDkSLYfzoCye0KvuWyS0M9PlNm0/WU0ZMrSC/HVWN4tHYDJkYmMOIwB6NsCqVCw+hnR0TRXPD16dOmaw6dZobgFJLVRzmh3zx0f7BBPqFfFzMgy19JMLiA5dkpBJOaADFlBt/q5DSWZA36ojuWFUnwCXHc0RYFHwlKccHvjiOA15g+XHWaqUGmlJm4Pgkkr2VEXojk24b7Aw3QDYFOE7hGAUvyEamf5DG3pmvQ0xMekuATcqYgI0svCtv1j8z0Vct5oDXSf2XFvlZdi7t02GECHA763xR/TN2FCnRWxrWacckm/0htNo1yXgoVmdgrhrmQp8xiHruOThL1ePt87lFfsRllmR2+oitvgx2R/kPrBR0GLkrGPyXwmAbfCYHrr9TPX/5qGL7n4DkRLFUmWzD5hyUIPvM1onyaEDqe82IKfyvoXidHJITfjqksPFIu+Cy3AJe/Rp2pp2cLRis4bZ4BRvLmuVA6RP39Wz0+EepjGNfSa8jofanz/zI8BwZ0GQKnU099pAXaKwmYbEXQ1xXkozraV8X//jF06dVSP3dtZzDGj+rpgUDTPH+v3G8RbUF/H9F3H0kynZuCj7JAeJ/tQJr9y/IjQZcORoGTljpIouxvE9T0xYJgxg6+08CgZcvscen1/EuvYSA/SXL+Ta12NERyHGMgrfnoSdcKEMqV/ctGRx46oBmbLr0ygdPcOp7JDDUeW/CZlHDyl2HptU4/d/kWRw3lfsPgrVpt50sS3PTLxZzBZynMhZK9UW4TjFIEjUEHfw6YhK7xL7//q3p62nQOPF0B33Uwbipcim168Nn0Xa+M2HDdSy/J3Frq8CX41Zzxt9NAgEFRt4nHN+CxTTvfW0WNLViaRioH1VQxO81iHjsPDw/RDJEiRVo77UYVRIoUKQafSJEixeATKVKkSDH4RIoUKQafSJEiRYrBJ1KkSDH4RIoUKVIMPpEiRYrBJ1KkSJFi8IkUKVIMPpEiRYrBJ1KkSJFi8IkUKdIfg15s02B2dnaWf+qLq7u4qur/r4r8vLjuDU168PfM0fUx9Ef7ou17TNurxXUTMJwq4jtDY5kxz2hafncOn9uLqwm8r9C/OaLynxM+PdS3lomjG9BPFz2v7SF9ntO7MsjlIuoL96BDZRmHloPTF7YB1v2ZxV/qxA5UNqyLK6FsmE8d6eSHf5bmTRVLQbflAkNw75ftGgIPff+siS7huTZVH2lver/tB0+zLMfxnennGj3TNDxzR8bXY8Zrev/uA2mD718SXXBXD3SEn297Pq+D6jXz/HdLAKXUNfDsO8Zx6dAXluEO7tUJb32/ythBBw2bn7hkUwb9/OBZlvm6VcgHMpvOIFdg5C78/Uycu4cyWN70jvA5hux4L2yPM+c5fG6TrP8J7t+gsXUFKOuKZGCO+hbE+Bm178Mz5yh722xzziAfE/8mjPcMBdumB4rsIVvcIKRB25+Tcc4s+uqCDEv7vAVd9OA+lrMObWaGxPIB6fIGySuVrYt0cQb320hnEfk8A/JRTDDR2UqRiXuNslLeyEfSNoRfFTm4Rjl0vE0H8unZ3AGhqU8G5KMc903I59LAk/tey9A0jE3k2gbbVoV24fRFZe0yunLpvce00XLVV5Dt97FF5PN8NCNZhmbYNjjN3zwDgq/zr0I3INsnyGy6bjRDYzDVQFzIoE7GfU+yq67DHMNzVzmNqUr4zgyytuFZrlZ246nDJiSZc+jvntFXk2knRQ+fiT1wf1eWYKsYFDjzkO0eIcQqQmezUs3ULUQ+FOE8oMJgFdBCn2QQKRLxqZn0AF7TWo10ot4x6/2qB4qR1nx6DPLRNafrHJGPqX7hi5Sk1GZqYn2BTdtEX5fInndMDfETQWnfUd2Ns4MECbtkw3xxra8Zkc9mkF6Ln6MsI93dMhFdg/ctNQucHd8GoLe/QNBswjjaEMxer6gXWvO5YQLfPeiorx7vpq2KSG8CUUzoOKkOe6SOxNn0nglibTSG16R+eIPsU0W1ujzIJttrJFsXEsYyaP0pIp/nRT7HaF1dJZn6Dox0iTKZK8v61nzaJHOuSnXC61i5d9FCaz4PBH3drbnmU1ePd+3yomPF79q56iof4Jk7w/N1gpAoMqJ6/0DQuI+/2ZCy3v1ql2W+buMhw2Mw8Dlkh5mh5tFGNaF2zjJcQXbVtZtj4ow99XR7FlPXINOM1BOOSd/tnJHKmUPOIkjXoOokuNYdgZMLHnVHTVAqz1Lf71Dw4OTFCOnKUYvS6LhJ5JXWFKku8K5t3O16RuTjqstw2U1a8/Hd7WozWfxBkNWuCUr7ztQs+urx2ZPvSnbOByM/fTUN8uOxr3O3q8vUM/RnSTCsqsdno3ANpUvGdc3ow4QULw2opa/4szimfq4NY/sglK2P7I4R/HWs+USi9RW9DJPWms5RraKO6lS4/TvIcj2U9e4FPOrMBLaddTorABm66DOg1j6SVyMxaWZ/h3SIkRytx/jsYGpd6HNQM6Z+Jdkd/Duqp9VRO6lsV+rnuSWMtt6WaXJs1X8aCD+v2DaqK/nhxEh/PB0+GVtZ5vT/BBgARwZUDnOS4TkAAAAASUVORK5CYII='><div style='font-size:10px;margin-left:auto;margin-right:auto;text-align:center;'>Version " TC_VERSION " (" TC_VERSION_EXTRA ")<br>Powered by <a href='https://tcd.out-a-ti.me' target=_blank>A10001986 [Documentation]</a></div>";
 
 static int  shouldSaveConfig = 0;
@@ -407,6 +470,13 @@ bool carMode = false;
 static unsigned long lastConnect = 0;
 static unsigned long consecutiveAPmodeFB = 0;
 
+// Asynchronous connection state
+static bool          wifiConnecting = false;
+static bool          wifiFirstConDone = false;
+static bool          wifiConDeferCP = false;
+static bool          wifiConFromOn = false;
+static unsigned long wifiConNewDelay = 0;
+
 // WiFi power management in AP mode
 bool          wifiInAPMode = false;
 bool          wifiAPIsOff = false;
@@ -418,9 +488,24 @@ bool          wifiIsOff = false;
 unsigned long wifiOnNow = 0;
 unsigned long wifiOffDelay     = 0;   // default: never
 unsigned long origWiFiOffDelay = 0;
-
-static File acFile;
-static bool haveACFile = false;
+static int8_t wifiModemSleep = -1;    // Modem sleep as last set (-1 = unknown)
+
+// Web portal is "busy" while it was accessed recently
+#define WIFI_PORTAL_HOLD  (30*1000)
+
+// Firmware update: Keep-alive while receiving, scheduled reboot
+#define OTA_KEEPALIVE_INT 20                  // ms between keep-alive calls
+#define OTA_REBOOT_MAX    (12*60*60*1000UL)   // Reboot at the latest 12 hours after update
+static bool          otaInKeepAlive = false;
+static bool          otaRebootPending = false;
+static bool          otaRebootAsap = false;
+static unsigned long otaDoneNow = 0;
+
+static bool haveACFile = false;   // upload file open
+static bool uplHaveAC = false;    // audio container uploaded
+static int  uplNumFiles = 0;
+static size_t uplTotal = 0;
+static unsigned long uplDispNow = 0;
 static int ACULerr = 0;
 
 #ifdef TC_HAVEMQTT
@@ -445,15 +530,118 @@ static bool          mqttPingDone = false;
 static unsigned long mqttPingNow = 0;
 static unsigned long mqttPingInt = MQTT_SHORT_INT;
 static uint16_t      mqttPingsExpired = 0;
+static bool          mqttPubHist = false;
+static bool          mqttPubCli = false;
+static bool          mqttPubMem = false;
+static bool          mqttPubLoop = false;
+static bool          mqttPubStall = false;
+static unsigned long mqttMemNow = 0;
+#define MQTT_MEM_INT (15*60*1000)
+#ifdef TC_MQTT_TASK
+// The MQTT task runs on core 0. Received messages are queued for
+// the main loop (mqttInQueue), outgoing ones are put in a ring buffer
+// (flags, topic, 0, payload). The task moves them to its outbox, 
+// which holds them until sent (QoS 0) or acknowledged (QoS 1), also
+// across reconnects. Messages not sent within MQTT_OUTBOX_AGE are
+// dropped; QoS 1 messages are re-sent every MQTT_QOS1_RETRY, at most
+// MQTT_QOS1_TRIES times. A message the client refuses to publish 
+// MQTT_PUB_FAILS times in a row (eg because it is too large) is 
+// dropped so it doesn't block the outbox.
+#define MQTT_TASK_CORE    0
+#define MQTT_TASK_PRIO    1
+#define MQTT_TASK_STACK   4096
+#define MQTT_TASK_INT     10        // ms
+#define MQTT_IN_QUEUE     4
+#define MQTT_OUT_BUF      6144
+#define MQTT_OUTBOX       8
+#define MQTT_OUTBOX_AGE   (2*60*1000)
+#define MQTT_QOS1_RETRY   10000
+#define MQTT_QOS1_TRIES   5
+#define MQTT_PUB_FAILS    3
+#define MQTT_MSG_CMD      0
+#define MQTT_MSG_USER     1
+typedef struct {
+    uint8_t  kind;
+    uint8_t  len;
+    char     data[255];
+} mqttInMsg;
+static TaskHandle_t  mqttTaskHandle = NULL;
+static QueueHandle_t mqttInQueue = NULL;
+static RingbufHandle_t mqttOutBuf = NULL;
+static volatile bool mqttIsConnected = false;
+typedef struct {
+    uint8_t       *item;        // Ring buffer item
+    size_t        size;
+    uint16_t      msgId;        // QoS 1: 0 = not sent
+    uint8_t       tries;
+    uint8_t       fails;        // Consecutive publish() failures
+    unsigned long added;
+    unsigned long sent;
+} mqttOutMsg;
+static mqttOutMsg    mqttOutbox[MQTT_OUTBOX];
+static int           mqttOutNum = 0;
+#endif
+#endif
+
+#ifdef TC_NET_TASK
+// The net task runs the web server (WM) on core 0. netMutex guards WM
+// and the WiFi state machine; the main loop only try-locks it, so a
+// slow client no longer blocks the displays. Handlers that access
+// main loop state are run on the main loop through netRunOnMain().
+// The task also keeps the NTP server's address resolved, so that
+// ntp_loop() never waits for DNS.
+#define NET_TASK_CORE     0
+#define NET_TASK_PRIO     1
+#define NET_TASK_STACK    8192
+#define NET_TASK_INT      2         // ms
+#define NET_DNS_INT       (30*60*1000)
+#define NET_DNS_RETRY     10000
+static TaskHandle_t      netTaskHandle = NULL;
+static SemaphoreHandle_t netMutex = NULL;
+static QueueHandle_t     netCallQueue = NULL;
+static SemaphoreHandle_t netCallDone = NULL;
+static volatile bool     netParkMain = false;
+static volatile uint32_t netNTPIP = 0;
+static volatile bool     netNTPResolve = true;
+static unsigned long     netNTPNow = 0;
 #endif
 
 static void wifiOff(bool force);
 static void wifiConnect(bool deferConfigPortal = false);
+static void wifiConnectPoll();
+static void wifiConnectDone(bool connected);
+static void wifiOnDone();
 static void saveParamsCallback();
 static void saveConfigCallback();
 static void preUpdateCallback();
+static void uplStartUI();
+static void preOTACallback();
+static void otaProgressCallback();
+static void postOTACallback(bool rebootNow);
+static void otaRebootCheck();
 static void preSaveConfigCallback();
 static void waitConnectCallback();
+static void wifi_loop_int();
+
+static void netLock();
+static bool netTryLock();
+static void netUnlock();
+static void netServeMain();
+static void netRunOnMain(void (*func)());
+#ifdef TC_NET_TASK
+static void netTask(void *parm);
+static void netResolveNTP();
+
+// Holds netMutex until the end of the scope
+class netLockGuard {
+    public:
+        netLockGuard()  { netLock(); }
+        ~netLockGuard() { netUnlock(); }
+};
+#define NET_LOCK() netLockGuard netLockG
+#else
+#define NET_LOCK()
+#endif
 
 static void setupStaticIP();
 static bool isIp(char *str);
@@ -469,8 +657,21 @@ static void strcpyCB(char *sv, WiFiManagerParameter *el);
 static void setCBVal(WiFiManagerParameter *el, char *sv);
 #endif
 static void buildSelectMenu(char *target, const char **theHTML, int cnt, char *setting);
+static bool selMenuStale(char *cache, const char *setting, bool force);
+static void setParmVal(WiFiManagerParameter *el, const char *sv, int length);
 
 static void setupWebServerCallback();
+static void handleSensorHistory();
+static void handleSecSettings();
+static void handleBootLog();
+#ifdef TC_STALLMON
+static void handleStallLog();
+#endif
+static void handleApiBench();
+static void handleApiStatus();
+static void apiStatusLoop();
+static void handleAssetJS();
+static void handleAssetCSS();
 static void handleUploadDone();
 static void handleUploading();
 static void handleUploadDone();
@@ -482,6 +683,23 @@ static bool mqttReconnect(bool force = false);
 static void mqttLooper();
 static void mqttCallback(char *topic, byte *payload, unsigned int length);
 static void mqttSubscribe();
+static void mqttPublishHistory();
+static void mqttPublishClients();
+static void mqttPublishMem();
+#ifdef TC_LOOPPROF
+static void mqttPublishLoop();
+#endif
+#ifdef TC_STALLMON
+static void mqttPublishStall();
+#endif
+static void mqttService();
+static void mqttEvalMsg(bool isCmd, const byte *payload, unsigned int length);
+#ifdef TC_MQTT_TASK
+static void mqttTask(void *parm);
+static void mqttOutboxFill();
+static void mqttOutboxFlush();
+static void mqttPubAck(uint16_t msgId);
+#endif
 #endif
 
 
@@ -615,7 +833,9 @@ void wifi_setup()
     wm.setPreSaveConfigCallback(preSaveConfigCallback);
     wm.setSaveConfigCallback(saveConfigCallback);
     wm.setSaveParamsCallback(saveParamsCallback);
-    wm.setPreOtaUpdateCallback(preUpdateCallback);
+    wm.setPreOtaUpdateCallback(preOTACallback);
+    wm.setOtaProgressCallback(otaProgressCallback);
+    wm.setPostOtaUpdateCallback(postOTACallback);
     wm.setWebServerCallback(setupWebServerCallback);
     wm.setHostname(settings.hostName);
     wm.setCaptivePortalEnable(false);
@@ -633,12 +853,12 @@ void wifi_setup()
     wm.setShowStaticFields(true);
     wm.setShowDnsFields(true);
 
-    temp = atoi(settings.wifiConTimeout);
+    temp = cfg.wifiConTimeout;
     if(temp < 7) temp = 7;
     if(temp > 25) temp = 25;
     wm.setConnectTimeout(temp);
 
-    temp = atoi(settings.wifiConRetries);
+    temp = cfg.wifiConRetries;
     if(temp < 1) temp = 1;
     if(temp > 10) temp = 10;
     wm.setConnectRetries(temp);
@@ -668,13 +888,13 @@ void wifi_setup()
     #endif
 
     // Read settings for WiFi powersave countdown
-    wifiOffDelay = (unsigned long)atoi(settings.wifiOffDelay);
+    wifiOffDelay = (unsigned long)cfg.wifiOffDelay;
     if(wifiOffDelay > 0 && wifiOffDelay < 10) wifiOffDelay = 10;
     origWiFiOffDelay = wifiOffDelay *= (60 * 1000);
     #ifdef TC_DBG
     Serial.printf("wifiOffDelay is %d\n", wifiOffDelay);
     #endif
-    wifiAPOffDelay = (unsigned long)atoi(settings.wifiAPOffDelay);
+    wifiAPOffDelay = (unsigned long)cfg.wifiAPOffDelay;
     if(wifiAPOffDelay > 0 && wifiAPOffDelay < 10) wifiAPOffDelay = 10;
     wifiAPOffDelay *= (60 * 1000);
 
@@ -689,7 +909,7 @@ void wifi_setup()
     // This determines if, after a fall-back to AP mode,
     // the device should periodically retry to connect
     // to a configured WiFi network; see time_loop().
-    doAPretry = (atoi(settings.wifiPRetry) > 0);
+    doAPretry = cfg.wifiPRetry;
 
     // Configure static IP
     if(loadIpSettings()) {
@@ -712,87 +932,38 @@ void wifi_setup()
         }
     }
 
-    // Connect, but defer starting the CP
-    wifiConnect(true);
-    
 #ifdef TC_HAVEMQTT
-    useMQTT = (atoi(settings.useMQTT) > 0);
+    // Decided here already, time_setup() needs to know. If we
+    // end up in AP mode, mqttSetup() disables MQTT.
+    useMQTT = cfg.useMQTT;
     #ifdef EXTERNAL_TIMETRAVEL_OUT
-    pubMQTT = (atoi(settings.pubMQTT) > 0);
+    pubMQTT = cfg.pubMQTT;
     #endif
-    
-    if((!settings.mqttServer[0]) || // No server -> no MQTT
-       (wifiInAPMode))              // WiFi in AP mode -> no MQTT
-        useMQTT = false;  
-    
-    if(useMQTT) {
-
-        bool mqttRes = false;
-        char *t;
-        int tt;
-
-        // No WiFi power save if we're using MQTT
-        origWiFiOffDelay = wifiOffDelay = 0;
-
-        if((t = strchr(settings.mqttServer, ':'))) {
-            strncpy(mqttServer, settings.mqttServer, t - settings.mqttServer);
-            mqttServer[t - settings.mqttServer + 1] = 0;
-            tt = atoi(t+1);
-            if(tt > 0 && tt <= 65535) {
-                mqttPort = tt;
-            }
-        } else {
-            strcpy(mqttServer, settings.mqttServer);
-        }
-
-        if(isIp(mqttServer)) {
-            mqttClient.setServer(stringToIp(mqttServer), mqttPort);
-        } else {
-            IPAddress remote_addr;
-            if(WiFi.hostByName(mqttServer, remote_addr)) {
-                mqttClient.setServer(remote_addr, mqttPort);
-            } else {
-                mqttClient.setServer(mqttServer, mqttPort);
-                // Disable PING if we can't resolve domain
-                mqttDoPing = false;
-                Serial.printf("MQTT: Failed to resolve '%s'\n", mqttServer);
-            }
-        }
-        
-        mqttClient.setCallback(mqttCallback);
-        mqttClient.setLooper(mqttLooper);
+    if(!settings.mqttServer[0])     // No server -> no MQTT
+        useMQTT = false;
+#endif
 
-        if(settings.mqttUser[0] != 0) {
-            if((t = strchr(settings.mqttUser, ':'))) {
-                strncpy(mqttUser, settings.mqttUser, t - settings.mqttUser);
-                mqttUser[t - settings.mqttUser + 1] = 0;
-                strcpy(mqttPass, t + 1);
-            } else {
-                strcpy(mqttUser, settings.mqttUser);
-            }
+    // Connect, but defer starting the CP. This does not wait for
+    // the result; the connection is advanced by wifiBootPoll()
+    // during the remaining boot phases and by wifi_loop() 
+    // afterwards. MQTT is set up once the result is known.
+    wifiConnect(true);
+    wifiBootPoll();
+
+    #ifdef TC_NET_TASK
+    netMutex = xSemaphoreCreateRecursiveMutex();
+    netCallQueue = xQueueCreate(1, sizeof(void (*)()));
+    netCallDone = xSemaphoreCreateBinary();
+    if(netMutex && netCallQueue && netCallDone) {
+        if(xTaskCreatePinnedToCore(netTask, "net", NET_TASK_STACK, NULL, 
+                                   NET_TASK_PRIO, &netTaskHandle, NET_TASK_CORE) != pdPASS) {
+            netTaskHandle = NULL;
         }
-
-        #ifdef TC_DBG
-        Serial.printf("MQTT: server '%s' port %d user '%s' pass '%s'\n", mqttServer, mqttPort, mqttUser, mqttPass);
-        #endif
-
-        haveMQTTaudio = check_file_SD(mqttAudioFile);
-            
-        mqttReconnect(true);
-        // Rest done in loop
-            
-    } else {
-
-        #ifdef EXTERNAL_TIMETRAVEL_OUT
-        pubMQTT = false;
-        #endif
-
-        #ifdef TC_DBG
-        Serial.println("MQTT: Disabled");
-        #endif
-
     }
-#endif
+    #ifdef TC_DBG
+    Serial.printf("Net task %s\n", netTaskHandle ? "started" : "failed, using main loop");
+    #endif
+    #endif
 }
 
 /*
@@ -801,41 +972,94 @@ void wifi_setup()
  */
 void wifi_loop()
 {
-    char oldCfgOnSD = 0;
+    // Called from time_loop() during firmware update: 
+    // The web server is busy receiving, leave it alone
+    if(otaInKeepAlive)
+        return;
+
+    #ifdef TC_NET_TASK
+    netServeMain();
+    #endif
 
 #ifdef TC_HAVEMQTT
     if(useMQTT) {
-        if(mqttClient.state() != MQTT_CONNECTING) {
-            if(!mqttClient.connected()) {
-                if(mqttOldState || mqttRestartPing) {
-                    // Disconnection first detected:
-                    mqttPingDone = mqttDoPing ? false : true;
-                    mqttPingNow = mqttRestartPing ? millis() : 0;
-                    mqttOldState = false;
-                    mqttRestartPing = false;
-                    mqttSubAttempted = false;
-                }
-                if(mqttDoPing && !mqttPingDone) {
-                    audio_loop();
-                    mqttPing();
-                    audio_loop();
-                }
-                if(mqttPingDone) {
-                    audio_loop();
-                    mqttReconnect();
-                    audio_loop();
-                }
-            } else {
-                // Only call Subscribe() if connected
-                mqttSubscribe();
-                mqttOldState = true;
+        #ifdef TC_MQTT_TASK
+        if(mqttTaskHandle) {
+            mqttInMsg msg;
+            while(xQueueReceive(mqttInQueue, &msg, 0) == pdTRUE) {
+                mqttEvalMsg(msg.kind == MQTT_MSG_CMD, (const byte *)msg.data, msg.len);
+            }
+        } else
+        #endif
+            mqttService();
+        // Publish later, not from within callback
+        if(mqttPubHist) {
+            mqttPubHist = false;
+            if(mqttState()) mqttPublishHistory();
+        }
+        if(mqttPubCli) {
+            mqttPubCli = false;
+            if(mqttState()) mqttPublishClients();
+        }
+        if(mqttPubMem || millis() - mqttMemNow >= MQTT_MEM_INT) {
+            if(mqttState()) {
+                mqttPublishMem();
+                #ifdef TC_LOOPPROF
+                mqttPublishLoop();
+                #endif
+                mqttPubMem = false;
+                mqttMemNow = millis();
             }
         }
-        mqttClient.loop();
+        #ifdef TC_LOOPPROF
+        if(mqttPubLoop) {
+            mqttPubLoop = false;
+            profPrint();
+            if(mqttState()) mqttPublishLoop();
+        }
+        #endif
+        #ifdef TC_STALLMON
+        if(stallNewRecord() || mqttPubStall) {
+            mqttPubStall = false;
+            if(mqttState()) mqttPublishStall();
+        }
+        #endif
     }
 #endif
-    
-    wm.process();
+
+    #ifdef TC_NET_TASK
+    // The web server is busy with a request: Try again next time
+    if(!netTryLock())
+        return;
+    #endif
+
+    wifi_loop_int();
+
+    #ifdef TC_NET_TASK
+    netUnlock();
+    #endif
+}
+
+static void wifi_loop_int()
+{
+    char oldCfgOnSD = 0;
+
+    #ifdef TC_NET_TASK
+    if(!netTaskHandle)
+    #endif
+        wm.process();
+
+    wifiConnectPoll();
+
+    apiStatusLoop();
+
+    #ifdef TC_WEBSOCKET
+    ws_loop();
+    #endif
+
+    if(otaRebootPending) {
+        otaRebootCheck();
+    }
     
     if(shouldSaveIPConfig) {
 
@@ -1081,6 +1305,7 @@ void wifi_loop()
 
         // Write settings if requested, or no settings file exists
         if(shouldSaveConfig > 1 || !checkConfigExists()) {
+            validateSettings();
             write_settings();
         }
         
@@ -1107,6 +1332,10 @@ void wifi_loop()
     // NTP requests will - under some conditions - re-enable WiFi for a 
     // short while automatically if the user configured a WiFi network 
     // to connect to.
+
+    // Not while a connection attempt is in progress
+    if(wifiConnecting)
+        return;
     
     if(wifiInAPMode) {
         // Disable WiFi in AP mode after a configurable delay (if > 0)
@@ -1138,9 +1367,99 @@ void wifi_loop()
 
 }
 
+#ifdef TC_HAVEMQTT
+// Called once after the first connection attempt finished
+static void mqttSetup()
+{
+    if(wifiInAPMode)                // WiFi in AP mode -> no MQTT
+        useMQTT = false;  
+    
+    if(useMQTT) {
+
+        bool mqttRes = false;
+        char *t;
+        int tt;
+
+        // No WiFi power save if we're using MQTT
+        origWiFiOffDelay = wifiOffDelay = 0;
+
+        if((t = strchr(settings.mqttServer, ':'))) {
+            strncpy(mqttServer, settings.mqttServer, t - settings.mqttServer);
+            mqttServer[t - settings.mqttServer + 1] = 0;
+            tt = atoi(t+1);
+            if(tt > 0 && tt <= 65535) {
+                mqttPort = tt;
+            }
+        } else {
+            strcpy(mqttServer, settings.mqttServer);
+        }
+
+        if(isIp(mqttServer)) {
+            mqttClient.setServer(stringToIp(mqttServer), mqttPort);
+        } else {
+            IPAddress remote_addr;
+            if(WiFi.hostByName(mqttServer, remote_addr)) {
+                mqttClient.setServer(remote_addr, mqttPort);
+            } else {
+                mqttClient.setServer(mqttServer, mqttPort);
+                // Disable PING if we can't resolve domain
+                mqttDoPing = false;
+                Serial.printf("MQTT: Failed to resolve '%s'\n", mqttServer);
+            }
+        }
+        
+        mqttClient.setCallback(mqttCallback);
+        mqttClient.setLooper(mqttLooper);
+
+        if(settings.mqttUser[0] != 0) {
+            if((t = strchr(settings.mqttUser, ':'))) {
+                strncpy(mqttUser, settings.mqttUser, t - settings.mqttUser);
+                mqttUser[t - settings.mqttUser + 1] = 0;
+                strcpy(mqttPass, t + 1);
+            } else {
+                strcpy(mqttUser, settings.mqttUser);
+            }
+        }
+
+        #ifdef TC_DBG
+        Serial.printf("MQTT: server '%s' port %d user '%s' pass '%s'\n", mqttServer, mqttPort, mqttUser, mqttPass);
+        #endif
+
+        haveMQTTaudio = check_file_SD(mqttAudioFile);
+
+        #ifdef TC_MQTT_TASK
+        mqttInQueue = xQueueCreate(MQTT_IN_QUEUE, sizeof(mqttInMsg));
+        mqttOutBuf = xRingbufferCreate(MQTT_OUT_BUF, RINGBUF_TYPE_NOSPLIT);
+        if(mqttInQueue && mqttOutBuf) {
+            if(xTaskCreatePinnedToCore(mqttTask, "mqtt", MQTT_TASK_STACK, NULL, 
+                                       MQTT_TASK_PRIO, &mqttTaskHandle, MQTT_TASK_CORE) != pdPASS) {
+                mqttTaskHandle = NULL;
+            }
+        }
+        #ifdef TC_DBG
+        Serial.printf("MQTT task %s\n", mqttTaskHandle ? "started" : "failed, using main loop");
+        #endif
+        if(!mqttTaskHandle)
+        #endif
+            mqttReconnect(true);
+        // Rest done in loop (or task)
+            
+    } else {
+
+        #ifdef EXTERNAL_TIMETRAVEL_OUT
+        pubMQTT = false;
+        #endif
+
+        #ifdef TC_DBG
+        Serial.println("MQTT: Disabled");
+        #endif
+
+    }
+}
+#endif
+
 static void wifiConnect(bool deferConfigPortal)
 {     
-    bool doOnlyAP = false;
     char realAPName[16];
 
     strcpy(realAPName, apName);
@@ -1148,14 +1467,50 @@ static void wifiConnect(bool deferConfigPortal)
         strcat(realAPName, settings.systemID);
     }
     
+    wifiConDeferCP = deferConfigPortal;
+    
+    STALL_ENTER("wificonn");
+
     if(carMode) {
         wm.startConfigPortal(realAPName, settings.appw);
-        doOnlyAP = true;
+        STALL_LEAVE();
+        wifiConnectDone(false);
+        return;
     }
     
-    // Automatically connect using saved credentials if they exist
-    // If connection fails it starts an access point with the specified name
-    if(!doOnlyAP && wm.autoConnect(realAPName, settings.appw)) {
+    // Automatically connect using saved credentials if they exist.
+    // If connection fails, an access point with the specified name is
+    // started. This does not block; the connection is advanced by
+    // wifiConnectPoll() from wifi_loop(), wifiConnectDone() is called
+    // with the result.
+    wm.autoConnectStart(realAPName, settings.appw);
+    wifiConnecting = true;
+
+    STALL_LEAVE();
+}
+
+static void wifiConnectPoll()
+{
+    int8_t res;
+    
+    if(!wifiConnecting)
+        return;
+
+    STALL_ENTER("wifipoll");
+    res = wm.autoConnectPoll();
+    STALL_LEAVE();
+    
+    if(res == WM_AC_PENDING)
+        return;
+
+    wifiConnecting = false;
+
+    wifiConnectDone(res == WM_AC_CONNECTED);
+}
+
+static void wifiConnectDone(bool connected)
+{
+    if(connected) {
         #ifdef TC_DBG
         Serial.println(F("WiFi connected"));
         #endif
@@ -1164,7 +1519,7 @@ static void wifiConnect(bool deferConfigPortal)
         // WiFi scan. This interferes with network access for a 
         // few seconds after connecting. So, during boot, we start
         // the CP later, to allow a quick NTP update.
-        if(!deferConfigPortal) {
+        if(!wifiConDeferCP) {
             wm.startWebPortal();
         }
 
@@ -1176,8 +1531,10 @@ static void wifiConnect(bool deferConfigPortal)
         //WiFi.setSleep(true);
 
         // Disable modem sleep, don't want delays accessing the CP or
-        // with MQTT.
+        // with MQTT. The power governor re-enables it while nobody 
+        // expects quick responses (see wifiSetModemSleep()).
         WiFi.setSleep(false);
+        wifiModemSleep = 0;
 
         // Set transmit power to max; we might be connecting as STA after
         // a previous period in AP mode.
@@ -1243,6 +1600,39 @@ static void wifiConnect(bool deferConfigPortal)
     }
 
     lastConnect = millis();
+
+    if(wifiConFromOn) {
+        wifiConFromOn = false;
+        wifiOnDone();
+    }
+
+    // Result of the connection attempt started at boot
+    if(!wifiFirstConDone) {
+        wifiFirstConDone = true;
+        bootMark(connected ? "wifi" : "wifi-ap");
+        #ifdef TC_HAVEMQTT
+        mqttSetup();
+        #endif
+    }
+}
+
+/*
+ * Advance the connection attempt started in wifi_setup()
+ * while the other boot phases run.
+ */
+void wifiBootPoll()
+{
+    if(otaInKeepAlive)
+        return;
+
+    NET_LOCK();
+    
+    wifiConnectPoll();
+}
+
+bool wifiIsConnecting()
+{
+    return wifiConnecting;
 }
 
 // This must not be called if no power-saving
@@ -1256,30 +1646,85 @@ static void wifiOff(bool force)
         }
     }
 
+    #ifdef TC_WEBSOCKET
+    ws_stop();
+    #endif
     wm.stopWebPortal();
     wm.disconnect();
     WiFi.mode(WIFI_OFF);
 }
 
-void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferCP)
+// True if the web portal (or a WebSocket client) was
+// active recently
+bool wifiPortalBusy()
 {
-    unsigned long desiredDelay;
-    unsigned long Now = millis();
-    
-    // wifiON() is called when the user pressed (and held) "7" (with alsoInAPMode
-    // TRUE) and when a time sync via NTP is issued (with alsoInAPMode FALSE).
-    //
-    // Holding "7" serves two purposes: To re-enable WiFi if in power save mode,
-    // and to re-connect to a configured WiFi network if we failed to connect to 
-    // that network at the last connection attempt. In both cases, the Config Portal
-    // is started.
-    //
-    // The NTP-triggered call should only re-connect if we are in power-save mode
-    // after being connected to a user-configured network, or if we are in AP mode
-    // but the user had config'd a network. Should only be called when frozen 
-    // displays are feasible (eg night hours).
-    //    
-    // "wifiInAPMode" only tells us our latest mode; if the configured WiFi
+    if(wifiInAPMode ? wifiAPIsOff : wifiIsOff)
+        return false;
+
+    #ifdef TC_WEBSOCKET
+    if(ws_numClients())
+        return true;
+    #endif
+
+    unsigned long acc = wm.getWebPortalAccessed();
+    return (acc && (millis() - acc < WIFI_PORTAL_HOLD));
+}
+
+// Modem sleep is only available in STA mode
+void wifiSetModemSleep(bool doSleep)
+{
+    if(wifiInAPMode || wifiIsOff || wifiConnecting)
+        return;
+
+    if(wifiModemSleep == (int8_t)doSleep)
+        return;
+
+    if(WiFi.status() != WL_CONNECTED)
+        return;
+
+    WiFi.setSleep(doSleep);
+    wifiModemSleep = doSleep;
+
+    #ifdef TC_DBG
+    Serial.printf("WiFi: Modem sleep %s\n", doSleep ? "on" : "off");
+    #endif
+}
+
+// WiFiManager's share for memory telemetry
+void wifiGetMemStats(uint32_t& parmAllocs, uint32_t& pages, uint32_t& pageMinHeap, uint32_t& otaStack)
+{
+    parmAllocs = WiFiManagerParameter::getAllocCount();
+    pages = wm.getPagesServed();
+    pageMinHeap = wm.getPageMinHeap();
+    otaStack = wm.getOtaStackFree();
+}
+
+void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferCP)
+{
+    unsigned long Now = millis();
+
+    // If a connection attempt is in progress, or a firmware
+    // update is being received, there is nothing to do
+    if(wifiConnecting || otaInKeepAlive)
+        return;
+
+    NET_LOCK();
+    
+    // wifiON() is called when the user pressed (and held) "7" (with alsoInAPMode
+    // TRUE) and when a time sync via NTP is issued (with alsoInAPMode FALSE).
+    //
+    // Holding "7" serves two purposes: To re-enable WiFi if in power save mode,
+    // and to re-connect to a configured WiFi network if we failed to connect to 
+    // that network at the last connection attempt. In both cases, the Config Portal
+    // is started.
+    //
+    // The NTP-triggered call should only re-connect if we are in power-save mode
+    // after being connected to a user-configured network, or if we are in AP mode
+    // but the user had config'd a network. The connection attempt runs 
+    // asynchronously (see wifiConnectPoll()), the network is unavailable
+    // until it has finished.
+    //    
+    // "wifiInAPMode" only tells us our latest mode; if the configured WiFi
     // network was - for whatever reason - was not available when we
     // tried to (re)connect, "wifiInAPMode" is true.
 
@@ -1381,13 +1826,23 @@ void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferCP)
 
     }
 
-    // (Re)connect
+    // (Re)connect; timers are restarted in wifiOnDone()
+    // once the connection attempt has finished
+    wifiConNewDelay = newDelay;
+    wifiConFromOn = true;
     WiFi.mode(WIFI_MODE_STA);
     wifiConnect(deferCP);
+}
 
+static void wifiOnDone()
+{
+    unsigned long desiredDelay;
+    unsigned long Now = millis();
+    unsigned long newDelay = wifiConNewDelay;
+    
     // Restart timers
     // Note that wifiInAPMode now reflects the
-    // result of our above wifiConnect() call
+    // result of our connection attempt
 
     if(wifiInAPMode) {
 
@@ -1424,28 +1879,13 @@ void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferCP)
     }
 }
 
-// Check if a longer interruption due to a re-connect is to
-// be expected when calling wifiOn(true, xxx).
-bool wifiOnWillBlock()
-{
-    if(wifiInAPMode) {  // We are in AP mode
-        if(!wifiAPIsOff) {
-            if(!wifiHaveSTAConf) {
-                return false;
-            }
-        }
-    } else {            // We are in STA mode
-        if(!wifiIsOff) return false;
-    }
-
-    return true;
-}
-
 void wifiStartCP()
 {
-    if(wifiInAPMode || wifiIsOff)
+    if(wifiInAPMode || wifiIsOff || otaInKeepAlive)
         return;
 
+    NET_LOCK();
+
     #ifdef TC_DBG
     Serial.println("Starting CP");
     #endif
@@ -1492,6 +1932,94 @@ static void preUpdateCallback()
     destinationTime.on();
 }
 
+// Firmware update (OTA): The image is written to flash by WM's 
+// writer task, the clock and audio keep running. Only disable
+// the WiFi-off timers and save pending data now.
+static void preOTAMain()
+{
+    wifiAPOffDelay = 0;
+    origWiFiOffDelay = 0;
+
+    flushDelayedSave();
+}
+
+static void preOTACallback()
+{
+    netRunOnMain(preOTAMain);
+}
+
+// Called by WM for every chunk received. Keep the clock 
+// running; the main loop is blocked in the web server 
+// while the image is uploaded.
+static void otaProgressCallback()
+{
+    static unsigned long lastKA = 0;
+
+    #ifdef TC_NET_TASK
+    // The main loop keeps running by itself
+    if(netTaskHandle)
+        return;
+    #endif
+
+    if(otaInKeepAlive || millis() - lastKA < OTA_KEEPALIVE_INT)
+        return;
+
+    otaInKeepAlive = true;
+    audio_loop();
+    time_loop();
+    audio_loop();
+    otaInKeepAlive = false;
+
+    lastKA = millis();
+}
+
+// Called after a successful update instead of rebooting right away
+static void postOTACallback(bool rebootNow)
+{
+    otaRebootPending = true;
+    otaRebootAsap = rebootNow;
+    otaDoneNow = millis();
+
+    #ifdef TC_DBG
+    Serial.printf("OTA done, reboot %s\n", rebootNow ? "now" : "scheduled");
+    #endif
+}
+
+// Reboot into the new firmware when the device is idle and
+// in night mode (or fake-powered off), or after OTA_REBOOT_MAX.
+// Audio is muted only now.
+static void otaRebootCheck()
+{
+    unsigned long now = millis();
+    tcState st;
+
+    // Let the result page go out
+    if(now - otaDoneNow < 1000)
+        return;
+
+    if(!otaRebootAsap && now - otaDoneNow < OTA_REBOOT_MAX) {
+        stateGet(st);
+        if(!st.nightMode && st.fpbOn)
+            return;
+        if(!checkAudioDone() || st.menuActive || st.startup)
+            return;
+        if(st.ttP0 || st.ttP1 || st.ttRE || st.ttP2)
+            return;
+    }
+
+    mp_stop();
+    stopAudio();
+    flushDelayedSave();
+    allOff();
+
+    #ifdef TC_DBG
+    Serial.println(F("Rebooting into new firmware"));
+    #endif
+    
+    delay(200);
+    ESP.restart();
+}
+
 // Grab static IP parameters from WiFiManager's server.
 // Since there is no public method for this, we steal
 // the html form parameters in this callback.
@@ -1582,125 +2110,151 @@ static void setupStaticIP()
     }
 }
 
+/*
+ * Make sure the settings form has the correct values
+ *
+ * Only parameters whose value differs from the setting are
+ * rewritten; the generated select menus are cached along with
+ * the setting(s) they were built from and only regenerated
+ * when those change.
+ */
 void updateConfigPortalValues()
 {
-    int tnm = atoi(settings.autoNMPreset);
+    static bool cpvInit = false;
+    static char lastBeep[4], lastAint[4], lastANM[4];
     #ifdef TC_HAVESPEEDO
-    int tt = atoi(settings.speedoType);
-    char spTyBuf[8];
+    static char lastSpTy[4];
+    #ifdef TC_HAVEGPS
+    static char lastSpdRt[4];
     #endif
+    #endif
+    bool force = !cpvInit;
 
-    // Make sure the settings form has the correct values
-
-    beepaintCustHTML[0] = 0;
-    buildSelectMenu(beepaintCustHTML, beepCustHTMLSrc, 6, settings.beep);
-    buildSelectMenu(beepaintCustHTML, aintCustHTMLSrc, 8, settings.autoRotateTimes);
+    NET_LOCK();
 
-    custom_hostName.setValue(settings.hostName, 31);
-    custom_sysID.setValue(settings.systemID, 7);
-    custom_appw.setValue(settings.appw, 8);
-    custom_wifiConTimeout.setValue(settings.wifiConTimeout, 2);
-    custom_wifiConRetries.setValue(settings.wifiConRetries, 2);
-    custom_wifiOffDelay.setValue(settings.wifiOffDelay, 2);
-    custom_wifiAPOffDelay.setValue(settings.wifiAPOffDelay, 2);
-    custom_ntpServer.setValue(settings.ntpServer, 63);
-    custom_timeZone.setValue(settings.timeZone, 63);
+    cpvInit = true;
 
-    custom_timeZone1.setValue(settings.timeZoneDest, 63);
-    custom_timeZone2.setValue(settings.timeZoneDep, 63);
-    custom_timeZoneN1.setValue(settings.timeZoneNDest, DISP_LEN);
-    custom_timeZoneN2.setValue(settings.timeZoneNDep, DISP_LEN);
+    // Both menus share one buffer: Rebuild both if either changed
+    if(selMenuStale(lastBeep, settings.beep, force) | 
+       selMenuStale(lastAint, settings.autoRotateTimes, force)) {
+        beepaintCustHTML[0] = 0;
+        buildSelectMenu(beepaintCustHTML, beepCustHTMLSrc, 6, settings.beep);
+        buildSelectMenu(beepaintCustHTML, aintCustHTMLSrc, 8, settings.autoRotateTimes);
+    }
 
-    sprintf(anmCustHTML, anmCustHTML1, settings.autoNMPreset, (tnm == 10) ? custHTMLSel : "", ooe);
-    for(int i = 0; i < 5; i++) {
-        sprintf(anmCustHTML + strlen(anmCustHTML), anmCustHTMLSrc[i], (tnm == i) ? custHTMLSel : "", (i == 4) ? osde : ooe);
+    setParmVal(&custom_hostName, settings.hostName, 31);
+    setParmVal(&custom_sysID, settings.systemID, 7);
+    setParmVal(&custom_appw, settings.appw, 8);
+    setParmVal(&custom_wifiConTimeout, settings.wifiConTimeout, 2);
+    setParmVal(&custom_wifiConRetries, settings.wifiConRetries, 2);
+    setParmVal(&custom_wifiOffDelay, settings.wifiOffDelay, 2);
+    setParmVal(&custom_wifiAPOffDelay, settings.wifiAPOffDelay, 2);
+    setParmVal(&custom_ntpServer, settings.ntpServer, 63);
+    setParmVal(&custom_timeZone, settings.timeZone, 63);
+
+    setParmVal(&custom_timeZone1, settings.timeZoneDest, 63);
+    setParmVal(&custom_timeZone2, settings.timeZoneDep, 63);
+    setParmVal(&custom_timeZoneN1, settings.timeZoneNDest, DISP_LEN);
+    setParmVal(&custom_timeZoneN2, settings.timeZoneNDep, DISP_LEN);
+
+    if(selMenuStale(lastANM, settings.autoNMPreset, force)) {
+        int tnm = atoi(settings.autoNMPreset);
+        sprintf(anmCustHTML, anmCustHTML1, settings.autoNMPreset, (tnm == 10) ? custHTMLSel : "", ooe);
+        for(int i = 0; i < 5; i++) {
+            sprintf(anmCustHTML + strlen(anmCustHTML), anmCustHTMLSrc[i], (tnm == i) ? custHTMLSel : "", (i == 4) ? osde : ooe);
+        }
     }
 
-    custom_autoNMOn.setValue(settings.autoNMOn, 2);
-    custom_autoNMOff.setValue(settings.autoNMOff, 2);
+    setParmVal(&custom_autoNMOn, settings.autoNMOn, 2);
+    setParmVal(&custom_autoNMOff, settings.autoNMOff, 2);
     #ifdef TC_HAVELIGHT
-    custom_lxLim.setValue(settings.luxLimit, 6);
+    setParmVal(&custom_lxLim, settings.luxLimit, 6);
     #endif
     
     #ifdef EXTERNAL_TIMETRAVEL_IN
-    custom_ettDelay.setValue(settings.ettDelay, 5);
+    setParmVal(&custom_ettDelay, settings.ettDelay, 5);
     #endif
 
     #ifdef TC_HAVETEMP
-    custom_tempOffs.setValue(settings.tempOffs, 4);
+    setParmVal(&custom_tempOffs, settings.tempOffs, 4);
     #endif
 
     #ifdef TC_HAVESPEEDO
-    sprintf(spTyCustHTML, "%s%s%s%s%d'%s>%s%s", spTyCustHTML1, settings.speedoType, spTyCustHTML2, spTyOptP1, 99, (tt == 99) ? custHTMLSel : "", "None", spTyOptP3);
-    for (int i = SP_MIN_TYPE; i < SP_NUM_TYPES; i++) {
-        sprintf(spTyCustHTML + strlen(spTyCustHTML), "%s%d'%s>%s%s", spTyOptP1, i, (tt == i) ? custHTMLSel : "", dispTypeNames[i], spTyOptP3);
+    if(selMenuStale(lastSpTy, settings.speedoType, force)) {
+        int tt = atoi(settings.speedoType);
+        sprintf(spTyCustHTML, "%s%s%s%s%d'%s>%s%s", spTyCustHTML1, settings.speedoType, spTyCustHTML2, spTyOptP1, 99, (tt == 99) ? custHTMLSel : "", "None", spTyOptP3);
+        for (int i = SP_MIN_TYPE; i < SP_NUM_TYPES; i++) {
+            sprintf(spTyCustHTML + strlen(spTyCustHTML), "%s%d'%s>%s%s", spTyOptP1, i, (tt == i) ? custHTMLSel : "", dispTypeNames[i], spTyOptP3);
+        }
+        strcat(spTyCustHTML, spTyCustHTMLE);
     }
-    strcat(spTyCustHTML, spTyCustHTMLE);
-    custom_speedoBright.setValue(settings.speedoBright, 2);
-    custom_speedoFact.setValue(settings.speedoFact, 3);
+    setParmVal(&custom_speedoBright, settings.speedoBright, 2);
+    setParmVal(&custom_speedoFact, settings.speedoFact, 3);
     #ifdef TC_HAVEGPS
-    spdRateCustHTML[0] = 0;
-    buildSelectMenu(spdRateCustHTML, spdRateCustHTMLSrc, 6, settings.spdUpdRate);
+    if(selMenuStale(lastSpdRt, settings.spdUpdRate, force)) {
+        spdRateCustHTML[0] = 0;
+        buildSelectMenu(spdRateCustHTML, spdRateCustHTMLSrc, 6, settings.spdUpdRate);
+    }
     #endif
     #ifdef TC_HAVETEMP
-    custom_tempBright.setValue(settings.tempBright, 2);
+    setParmVal(&custom_tempBright, settings.tempBright, 2);
     #endif
     #endif
 
     #ifdef TC_HAVEMQTT
-    custom_mqttServer.setValue(settings.mqttServer, 79);
-    custom_mqttUser.setValue(settings.mqttUser, 63);
-    custom_mqttTopic.setValue(settings.mqttTopic, 63);
+    setParmVal(&custom_mqttServer, settings.mqttServer, 79);
+    setParmVal(&custom_mqttUser, settings.mqttUser, 63);
+    setParmVal(&custom_mqttTopic, settings.mqttTopic, 63);
     #endif
 
     #ifdef TC_NOCHECKBOXES  // Standard text boxes: -------
 
-    custom_ttrp.setValue(settings.timesPers, 1);
-    custom_alarmRTC.setValue(settings.alarmRTC, 1);
-    custom_playIntro.setValue(settings.playIntro, 1);
-    custom_mode24.setValue(settings.mode24, 1);
-    custom_wifiPRe.setValue(settings.wifiPRetry, 1);
-    custom_dtNmOff.setValue(settings.dtNmOff, 1);
-    custom_ptNmOff.setValue(settings.ptNmOff, 1);
-    custom_ltNmOff.setValue(settings.ltNmOff, 1);
+    setParmVal(&custom_ttrp, settings.timesPers, 1);
+    setParmVal(&custom_alarmRTC, settings.alarmRTC, 1);
+    setParmVal(&custom_playIntro, settings.playIntro, 1);
+    setParmVal(&custom_mode24, settings.mode24, 1);
+    setParmVal(&custom_wifiPRe, settings.wifiPRetry, 1);
+    setParmVal(&custom_dtNmOff, settings.dtNmOff, 1);
+    setParmVal(&custom_ptNmOff, settings.ptNmOff, 1);
+    setParmVal(&custom_ltNmOff, settings.ltNmOff, 1);
     #ifdef TC_HAVELIGHT
-    custom_uLS.setValue(settings.useLight, 1);
+    setParmVal(&custom_uLS, settings.useLight, 1);
     #endif
     #ifdef TC_HAVETEMP
-    custom_tempUnit.setValue(settings.tempUnit, 1);
+    setParmVal(&custom_tempUnit, settings.tempUnit, 1);
     #endif
     #ifdef TC_HAVESPEEDO
-    custom_sAF.setValue(settings.speedoAF, 1);
+    setParmVal(&custom_sAF, settings.speedoAF, 1);
     #ifdef TC_HAVEGPS
-    custom_useGPSS.setValue(settings.useGPSSpeed, 1);
+    setParmVal(&custom_useGPSS, settings.useGPSSpeed, 1);
     #endif
     #ifdef TC_HAVETEMP
-    custom_useDpTemp.setValue(settings.dispTemp, 1);
-    custom_tempOffNM.setValue(settings.tempOffNM, 1);
+    setParmVal(&custom_useDpTemp, settings.dispTemp, 1);
+    setParmVal(&custom_tempOffNM, settings.tempOffNM, 1);
     #endif
     #endif
     #ifdef FAKE_POWER_ON
-    custom_fakePwrOn.setValue(settings.fakePwrOn, 1);
+    setParmVal(&custom_fakePwrOn, settings.fakePwrOn, 1);
     #endif
     //#ifdef EXTERNAL_TIMETRAVEL_IN
     //custom_ettLong.setValue(settings.ettLong, 1);
     //#endif
     #ifdef EXTERNAL_TIMETRAVEL_OUT
-    custom_useETTO.setValue(settings.useETTO, 1);
-    custom_noETTOL.setValue(settings.noETTOLead, 1);
+    setParmVal(&custom_useETTO, settings.useETTO, 1);
+    setParmVal(&custom_noETTOL, settings.noETTOLead, 1);
     #endif
     #ifdef TC_HAVEGPS
-    custom_qGPS.setValue(settings.quickGPS, 1);
+    setParmVal(&custom_qGPS, settings.quickGPS, 1);
     #endif
-    custom_playTTSnd.setValue(settings.playTTsnds, 1);
+    setParmVal(&custom_playTTSnd, settings.playTTsnds, 1);
     #ifdef TC_HAVEMQTT
-    custom_useMQTT.setValue(settings.useMQTT, 1);
+    setParmVal(&custom_useMQTT, settings.useMQTT, 1);
     #ifdef EXTERNAL_TIMETRAVEL_OUT
-    custom_pubMQTT.setValue(settings.pubMQTT, 1);
+    setParmVal(&custom_pubMQTT, settings.pubMQTT, 1);
     #endif
     #endif
-    custom_shuffle.setValue(settings.shuffle, 1);
-    custom_CfgOnSD.setValue(settings.CfgOnSD, 1);
+    setParmVal(&custom_shuffle, settings.shuffle, 1);
+    setParmVal(&custom_CfgOnSD, settings.CfgOnSD, 1);
     //custom_sdFrq.setValue(settings.sdFreq, 1);
 
     #else   // For checkbox hack --------------------------
@@ -1770,42 +2324,452 @@ static void buildSelectMenu(char *target, const char **theHTML, int cnt, char *s
     }
 }
 
+static bool selMenuStale(char *cache, const char *setting, bool force)
+{
+    if(!force && !strcmp(cache, setting))
+        return false;
+
+    strcpy(cache, setting);
+    return true;
+}
+
+/*
+ * Sensor history
+ */
+#define NUM_HIST 4
+static int getHistList(const char **names, sensHistory **hists, int *scales)
+{
+    int num = 0;
+
+    names[num] = "rtctemp"; hists[num] = &rtcTempHist; scales[num++] = 100;
+    #ifdef TC_HAVETEMP
+    if(useTemp) {
+        names[num] = "temp"; hists[num] = &tempHist; scales[num++] = 100;
+        if(tempSens.haveHum()) {
+            names[num] = "hum"; hists[num] = &humHist; scales[num++] = 1;
+        }
+    }
+    #endif
+    #ifdef TC_HAVELIGHT
+    if(useLight) {
+        names[num] = "lux"; hists[num] = &luxHist; scales[num++] = 1;
+    }
+    #endif
+
+    return num;
+}
+
+// GET /sensors: All history as JSON, eg
+// {"temp":{"scale":100,"sample":[...],"minute":[...],"hour":[...]},...}
+// Oldest value first; null for periods without reading.
+/*
+ * JSON status API
+ *
+ * The response is a snapshot which is only re-serialized if
+ * the state (as collected in apiState) has changed since
+ * the last check; serving a request is a plain buffer send,
+ * no matter how often dashboards poll.
+ */
+static void apiCollectState(apiState& st)
+{
+    memset(&st, 0, sizeof(st));
+
+    st.dtYear = destinationTime.getYear();
+    st.dtMon  = destinationTime.getMonth();
+    st.dtDay  = destinationTime.getDay();
+    st.dtHour = destinationTime.getHour();
+    st.dtMin  = destinationTime.getMinute();
+    st.ptYear = presentTime.getYear();
+    st.ptMon  = presentTime.getMonth();
+    st.ptDay  = presentTime.getDay();
+    st.ptHour = presentTime.getHour();
+    st.ptMin  = presentTime.getMinute();
+    st.ltYear = departedTime.getYear();
+    st.ltMon  = departedTime.getMonth();
+    st.ltDay  = departedTime.getDay();
+    st.ltHour = departedTime.getHour();
+    st.ltMin  = departedTime.getMinute();
+
+    st.temp = INT16_MIN;
+    st.hum = -1;
+    st.lux = -1;
+    #ifdef TC_HAVETEMP
+    if(useTemp) {
+        if(!tempSens.lastTempNan()) st.temp = (int16_t)(tempSens.readLastTemp() * 10.0f);
+        if(tempSens.haveHum()) st.hum = tempSens.readHum();
+    }
+    #endif
+    #ifdef TC_HAVELIGHT
+    if(useLight) st.lux = lightSens.readLux();
+    #endif
+
+    st.wifiMode = (wifiInAPMode ? (wifiAPIsOff ? 0 : 2) : (wifiIsOff ? 0 : 1));
+    if(st.wifiMode == 1 && WiFi.status() == WL_CONNECTED) {
+        st.rssi = WiFi.RSSI();
+    }
+
+    st.numClients = bttfnNumClients();
+    for(int i = 0; i < st.numClients; i++) {
+        char *id;
+        uint8_t *ip, type;
+        if(bttfnGetClientInfo(i, &id, &ip, &type)) {
+            st.clientSum = (st.clientSum << 3) + (st.clientSum >> 13) + ip[3] + type + id[0];
+            st.clientSum += bttfnGetClientRTT(i);
+        }
+    }
+
+    st.freeHeapK = ESP.getFreeHeap() / 1024;
+    st.minHeapK  = ESP.getMinFreeHeap() / 1024;
+    memGetStats(st.mem);
+    st.loopRate  = apiLoopCnt;
+    st.loopMax   = apiLoopMax;
+
+    st.pwrState  = pwrGetState();
+    pwrGetStats(st.pwrSecs, st.pwrSlept);
+}
+
+static void apiBuildStatus(apiState& st)
+{
+    const char *modes[3] = { "off", "sta", "ap" };
+    char buf[20];
+    DECLARE_S_JSON(API_JSON_SIZE, json);
+
+    #define API_DATE(n, y, m, d, h, i) \
+        sprintf(buf, "%04d-%02d-%02dT%02d:%02d", y, m, d, h, i); \
+        json[n] = buf;
+    API_DATE("destination", st.dtYear, st.dtMon, st.dtDay, st.dtHour, st.dtMin);
+    API_DATE("present", st.ptYear, st.ptMon, st.ptDay, st.ptHour, st.ptMin);
+    API_DATE("departed", st.ltYear, st.ltMon, st.ltDay, st.ltHour, st.ltMin);
+    #undef API_DATE
+
+    JsonObject sens = json.createNestedObject("sensors");
+    if(st.temp != INT16_MIN) {
+        sens["temp"] = (float)st.temp / 10.0f;
+        #ifdef TC_HAVETEMP
+        sens["tempUnit"] = tempUnit ? "C" : "F";
+        #endif
+    }
+    if(st.hum >= 0) sens["hum"] = st.hum;
+    if(st.lux >= 0) sens["lux"] = st.lux;
+
+    JsonArray cli = json.createNestedArray("bttfn");
+    for(int i = 0; i < st.numClients; i++) {
+        char *id;
+        uint8_t *ip, type;
+        if(bttfnGetClientInfo(i, &id, &ip, &type)) {
+            JsonObject c = cli.createNestedObject();
+            char idbuf[16];
+            snprintf(idbuf, sizeof(idbuf), "%.12s", id);
+            c["id"] = idbuf;
+            c["type"] = type;
+            sprintf(buf, "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+            c["ip"] = buf;
+            int rtt = bttfnGetClientRTT(i);
+            if(rtt >= 0) c["rtt"] = rtt;
+        }
+    }
+
+    JsonObject wifi = json.createNestedObject("wifi");
+    wifi["mode"] = modes[st.wifiMode];
+    if(st.rssi) wifi["rssi"] = st.rssi;
+
+    JsonObject heap = json.createNestedObject("heap");
+    heap["free"] = st.freeHeapK;
+    heap["min"] = st.minHeapK;
+    heap["largest"] = st.mem.largest;
+    heap["minLargest"] = st.mem.minLargest;
+    heap["frag"] = st.mem.frag;
+    heap["maxFrag"] = st.mem.maxFrag;
+    JsonObject stk = heap.createNestedObject("stack");
+    for(int i = 0; i < MEM_NUM_TASKS; i++) {
+        if(st.mem.stackFree[i] != MEM_STK_UNKNOWN) {
+            stk[memTaskName(i)] = st.mem.stackFree[i];
+        }
+    }
+    JsonObject allocs = heap.createNestedObject("allocs");
+    allocs["mp3"] = st.mem.mp3Allocs;
+    allocs["mp3Fail"] = st.mem.mp3Fails;
+    allocs["json"] = st.mem.jsonDocs;
+    allocs["jsonMax"] = st.mem.jsonMax;
+    allocs["wmParm"] = st.mem.wmParmAllocs;
+    allocs["wmPages"] = st.mem.wmPages;
+    allocs["wmMinHeap"] = st.mem.wmPageMinHeap;
+    if(st.mem.psramSize) {
+        heap["psram"] = st.mem.psramSize;
+        heap["psramFree"] = st.mem.psramFree;
+    }
+
+    JsonObject lp = json.createNestedObject("loop");
+    lp["rate"] = st.loopRate;
+    lp["max"] = st.loopMax;
+
+    const char *pwrNames[PWR_NUM_ST] = { "full", "mid", "low", "nap" };
+    JsonObject pwr = json.createNestedObject("power");
+    pwr["state"] = pwrNames[st.pwrState];
+    for(int i = 0; i < PWR_NUM_ST; i++) {
+        pwr[pwrNames[i]] = st.pwrSecs[i];
+    }
+    if(st.pwrSlept) pwr["slept"] = st.pwrSlept;
+
+    apiStatusLen = serializeJson(json, apiStatusBuf, sizeof(apiStatusBuf));
+}
+
+// Called from wifi_loop(); collects loop statistics
+// (loops per second, max. loop time in ms), and checks
+// for state changes once per second.
+static void apiStatusLoop()
+{
+    unsigned long now = millis();
+    apiState st;
+
+    if(apiLoopLast && now - apiLoopLast > apiLoopMax) {
+        apiLoopMax = now - apiLoopLast;
+    }
+    apiLoopLast = now;
+    apiLoopCnt++;
+
+    if(now - apiLastCheck < API_CHECK_INT)
+        return;
+
+    apiCollectState(st);
+    if(!apiLastCheck || memcmp(&st, &apiCurState, sizeof(st))) {
+        apiBuildStatus(st);
+        apiCurState = st;
+    }
+
+    apiLastCheck = now;
+    apiLoopCnt = 0;
+    apiLoopMax = 0;
+}
+
+static void handleApiStatus()
+{
+    wm.server->sendHeader(F("Cache-Control"), F("no-cache"));
+    wm.server->send(200, F("application/json"), apiStatusBuf);
+}
+
+// Results of the last benchmark run (keypad menu)
+static void handleApiBench()
+{
+    char buf[640];
+
+    benchToJSON(buf, sizeof(buf));
+    wm.server->sendHeader(F("Cache-Control"), F("no-cache"));
+    wm.server->send(200, F("application/json"), buf);
+}
+
+// Secondary settings as JSON, for backups
+static void handleSecSettings()
+{
+    char buf[640];
+
+    exportSecSettings(buf, sizeof(buf));
+    wm.server->sendHeader(F("Cache-Control"), F("no-cache"));
+    wm.server->sendHeader(F("Content-Disposition"), F("attachment; filename=\"tcdsecsettings.json\""));
+    wm.server->send(200, F("application/json"), buf);
+}
+
+// Boot profile as plain text
+static void handleBootLog()
+{
+    char buf[(BOOT_MAX_MARKS + 1) * 44];
+
+    bootLogToText(buf, sizeof(buf));
+    wm.server->sendHeader(F("Cache-Control"), F("no-cache"));
+    wm.server->send(200, F("text/plain"), buf);
+}
+
+#ifdef TC_STALLMON
+static void handleStallLog()
+{
+    char buf[(STALL_NUM + 2) * 64];
+
+    stallLogToText(buf, sizeof(buf), true);
+    wm.server->sendHeader(F("Cache-Control"), F("no-cache"));
+    wm.server->send(200, F("text/plain"), buf);
+}
+#endif
+
+static void handleSensorHistory()
+{
+    const char *names[NUM_HIST];
+    sensHistory *hists[NUM_HIST];
+    int scales[NUM_HIST];
+    const char *resNames[3] = { "sample", "minute", "hour" };
+    char buf[800];
+    int num = getHistList(names, hists, scales);
+
+    wm.server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    wm.server->send(200, F("application/json"), "{");
+
+    for(int i = 0; i < num; i++) {
+        sprintf(buf, "%s\"%s\":{\"scale\":%d", i ? "," : "", names[i], scales[i]);
+        wm.server->sendContent(buf);
+        for(int j = SH_RES_SAMPLE; j <= SH_RES_HOUR; j++) {
+            sprintf(buf, ",\"%s\":[", resNames[j]);
+            wm.server->sendContent(buf);
+            hists[i]->toText(j, buf, sizeof(buf) - 1, "null");
+            strcat(buf, "]");
+            wm.server->sendContent(buf);
+        }
+        wm.server->sendContent("}");
+    }
+
+    wm.server->sendContent("}");
+    wm.server->sendContent("");
+}
+
 /*
  * Audio data uploader
  */
 static void setupWebServerCallback()
 {
     wm.server->on(WM_G(R_updateacdone), HTTP_POST, &handleUploadDone, &handleUploading);
+    // These read the main loop's data
+    wm.server->on("/sensors", HTTP_GET, []() { netRunOnMain(handleSensorHistory); });
+    wm.server->on("/secsettings.json", HTTP_GET, []() { netRunOnMain(handleSecSettings); });
+    wm.server->on("/bootlog", HTTP_GET, &handleBootLog);
+    #ifdef TC_STALLMON
+    wm.server->on("/stalls", HTTP_GET, &handleStallLog);
+    #endif
+    wm.server->on("/api/status", HTTP_GET, &handleApiStatus);
+    wm.server->on("/api/bench", HTTP_GET, []() { netRunOnMain(handleApiBench); });
+    wm.server->on("/tcd.js", HTTP_GET, &handleAssetJS);
+    wm.server->on("/tcd.css", HTTP_GET, &handleAssetCSS);
+
+    #ifdef TC_WEBSOCKET
+    ws_begin();
+    #endif
+}
+
+/*
+ * Our script and style overrides; generated from assets/ by
+ * assets/mkassets.py, served compressed and cacheable.
+ */
+static void handleAssetJS()
+{
+    wm.sendGzAsset("application/javascript", tcd_js_gz, sizeof(tcd_js_gz), TC_JS_ETAG);
+}
+
+static void handleAssetCSS()
+{
+    wm.sendGzAsset("text/css", tcd_css_gz, sizeof(tcd_css_gz), TC_CSS_ETAG);
 }
 
 static void doCloseACFile(bool doRemove)
 {
     if(haveACFile) {
-        closeACFile(acFile);
+        if(!closeUploadFile(doRemove) && !doRemove) {
+            if(!ACULerr) ACULerr = 3;
+        }
         haveACFile = false;
     }
-    if(doRemove) removeACFile();
+}
+
+// Map uploaded file name to SD file name: TCDA.bin is
+// the audio container, *.mp3 and *.wav go to the SD's
+// root folder, or to a music folder if they were uploaded
+// from one (folder upload; "musicX/nnn.mp3").
+// Returns false if the file is not accepted.
+static bool uploadTarget(const char *src, char *dst, bool& isAC)
+{
+    const char *base = strrchr(src, '/');
+    const char *dir = NULL;
+    const char *ext;
+    size_t blen;
+
+    isAC = false;
+    
+    if(base) {
+        for(dir = base - 1; dir > src && *(dir - 1) != '/'; dir--) ;
+        base++;
+    } else {
+        base = src;
+    }
+
+    if(!strcasecmp(base, "TCDA.bin")) {
+        isAC = true;
+        return true;
+    }
+
+    blen = strlen(base);
+    if(blen < 5 || blen > 24 || !(ext = strrchr(base, '.')))
+        return false;
+    if(strcasecmp(ext, ".mp3") && strcasecmp(ext, ".wav"))
+        return false;
+
+    if(dir && base - dir == 7 && !strncasecmp(dir, "music", 5) && 
+       dir[5] >= '0' && dir[5] <= '9') {
+        sprintf(dst, "/music%c/%s", dir[5], base);
+    } else {
+        sprintf(dst, "/%s", base);
+    }
+
+    // SD file names are lower case
+    for(char *t = dst; *t; t++) *t = tolower(*t);
+
+    return true;
+}
+
+// Stop audio and the clock for the upload. With the net task, the 
+// main loop is parked afterwards; handleUploadDone() reboots.
+static void uplStartUI()
+{
+    preUpdateCallback();
+    presentTime.on();
+
+    #ifdef TC_NET_TASK
+    if(netTaskHandle) netParkMain = true;
+    #endif
 }
 
 static void handleUploading()
 {
     HTTPUpload& upload = wm.server->upload();
+    char fnbuf[40];
+    bool isAC;
 
     if(upload.status == UPLOAD_FILE_START) {
 
-          preUpdateCallback();
-          
-          haveACFile = openACFile(acFile); 
-          ACULerr = haveACFile ? 0 : (haveSD ? 1 : 2);
+        // Skip empty file inputs
+        if(!upload.filename.length())
+            return;
+
+        if(!uplNumFiles) {
+            netRunOnMain(uplStartUI);
+        }
+        uplNumFiles++;
+
+        if(!haveSD) {
+            ACULerr = 2;
+        } else if(!uploadTarget(upload.filename.c_str(), fnbuf, isAC)) {
+            if(!ACULerr) ACULerr = 5;
+        } else {
+            if(!(haveACFile = openUploadFile(isAC ? NULL : fnbuf))) {
+                if(!ACULerr) ACULerr = 1;
+            } else if(isAC) {
+                uplHaveAC = true;
+            }
+        }
           
     } else if(upload.status == UPLOAD_FILE_WRITE) {
 
-          if(haveACFile) {
-              if(writeACFile(acFile, upload.buf, upload.currentSize) != upload.currentSize) {
-                  doCloseACFile(true);
-                  ACULerr = 3;
-              }
-          }
+        if(haveACFile) {
+            if(!writeUploadFile(upload.buf, upload.currentSize)) {
+                doCloseACFile(true);
+                if(!ACULerr) ACULerr = 3;
+            }
+        }
+
+        // Progress display: Number of file, KB received
+        // (With the net task, the main loop is parked now)
+        uplTotal += upload.currentSize;
+        if(millis() - uplDispNow > 250) {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%2d %6dK", uplNumFiles % 100, (int)(uplTotal / 1024));
+            presentTime.showTextDirect(buf);
+            uplDispNow = millis();
+        }
 
     } else if(upload.status == UPLOAD_FILE_END) {
 
@@ -1840,7 +2804,11 @@ static void handleUploadDone()
                   STRLEN(acul_part8) +
                   1;
 
-    if(!ACULerr) {
+    if(!uplNumFiles && !ACULerr) {
+        ACULerr = 5;
+    }
+
+    if(!ACULerr && uplHaveAC) {
         if(!check_if_default_audio_present()) {
             ACULerr = 5;
             removeACFile();
@@ -1849,7 +2817,7 @@ static void handleUploadDone()
 
     buflen += ACULerr ? (STRLEN(acul_part71) + strlen(acul_errs[ACULerr-1])) : STRLEN(acul_part7);
 
-    if(!(buf = (char *)malloc(buflen))) {
+    if(!(buf = (char *)memBulkAlloc(buflen, MEM_BLK_WEB))) {
         buf = (char *)(ACULerr ? ebuf : dbuf);
         //ownbuf = true;
     } else {
@@ -1882,6 +2850,135 @@ static void handleUploadDone()
     //if(!ownbuf) free(buf);
 }
 
+/*
+ * Net task
+ */
+#ifdef TC_NET_TASK
+static void netTask(void *parm)
+{
+    for(;;) {
+        if(xSemaphoreTakeRecursive(netMutex, portMAX_DELAY) == pdTRUE) {
+            wm.process();
+            xSemaphoreGiveRecursive(netMutex);
+        }
+        
+        netResolveNTP();
+        
+        vTaskDelay(pdMS_TO_TICKS(NET_TASK_INT));
+    }
+}
+
+// Resolve the NTP server on request, when unresolved every 
+// NET_DNS_RETRY, otherwise every NET_DNS_INT
+static void netResolveNTP()
+{
+    unsigned long now = millis();
+    IPAddress ip;
+
+    if(!settings.ntpServer[0] || WiFi.status() != WL_CONNECTED)
+        return;
+
+    if(!netNTPResolve && now - netNTPNow < (netNTPIP ? NET_DNS_INT : NET_DNS_RETRY))
+        return;
+
+    netNTPResolve = false;
+    netNTPNow = now;
+
+    if(WiFi.hostByName(settings.ntpServer, ip)) {
+        netNTPIP = (uint32_t)ip;
+    }
+
+    #ifdef TC_DBG
+    Serial.printf("Net task: NTP server %s\n", netNTPIP ? IPAddress((uint32_t)netNTPIP).toString().c_str() : "unresolved");
+    #endif
+}
+#endif
+
+// The main loop must hold netMutex when accessing WM or the
+// WiFi state. While waiting, calls from the net task are 
+// served, since the net task might be waiting for us.
+static void netLock()
+{
+    #ifdef TC_NET_TASK
+    if(!netTaskHandle)
+        return;
+    
+    while(xSemaphoreTakeRecursive(netMutex, pdMS_TO_TICKS(5)) != pdTRUE) {
+        netServeMain();
+    }
+    #endif
+}
+
+static bool netTryLock()
+{
+    #ifdef TC_NET_TASK
+    if(netTaskHandle)
+        return (xSemaphoreTakeRecursive(netMutex, 0) == pdTRUE);
+    #endif
+    return true;
+}
+
+static void netUnlock()
+{
+    #ifdef TC_NET_TASK
+    if(netTaskHandle)
+        xSemaphoreGiveRecursive(netMutex);
+    #endif
+}
+
+// Run calls posted by the net task, main loop side. Once
+// parked (audio upload), this does not return.
+static void netServeMain()
+{
+    #ifdef TC_NET_TASK
+    void (*func)();
+
+    if(!netTaskHandle)
+        return;
+
+    do {
+        while(xQueueReceive(netCallQueue, &func, 0) == pdTRUE) {
+            func();
+            xSemaphoreGive(netCallDone);
+        }
+        if(netParkMain) delay(5);
+    } while(netParkMain);
+    #endif
+}
+
+// Run func on the main loop and wait for it to finish.
+// Called from anywhere else, func is run directly.
+static void netRunOnMain(void (*func)())
+{
+    #ifdef TC_NET_TASK
+    if(netTaskHandle && xTaskGetCurrentTaskHandle() == netTaskHandle) {
+        xQueueSend(netCallQueue, &func, portMAX_DELAY);
+        xSemaphoreTake(netCallDone, portMAX_DELAY);
+        return;
+    }
+    #endif
+    
+    func();
+}
+
+// The NTP server's address. With the net task, this
+// never waits for DNS; false if not (yet) resolved.
+bool wifiGetNTPServerIP(IPAddress& ip)
+{
+    #ifdef TC_NET_TASK
+    if(netTaskHandle) {
+        if(!netNTPIP) {
+            netNTPResolve = true;
+            return false;
+        }
+        ip = IPAddress((uint32_t)netNTPIP);
+        return true;
+    }
+    #endif
+
+    return WiFi.hostByName(settings.ntpServer, ip);
+}
+
 /*
  * Helpers
  */
@@ -2049,6 +3146,17 @@ static void mystrcpy(char *sv, WiFiManagerParameter *el)
     strcpy(sv, el->getValue());
 }
 
+// Skip setValue() (and its re-alloc/copy) if the value is unchanged
+static void setParmVal(WiFiManagerParameter *el, const char *sv, int length)
+{
+    const char *cv = el->getValue();
+    
+    if(cv && el->getValueLength() == length && !strncmp(cv, sv, length))
+        return;
+
+    el->setValue(sv, length);
+}
+
 #ifndef TC_NOCHECKBOXES
 static void strcpyCB(char *sv, WiFiManagerParameter *el)
 {
@@ -2059,7 +3167,7 @@ static void setCBVal(WiFiManagerParameter *el, char *sv)
 {
     const char makeCheck[] = "1' checked a='";
     
-    el->setValue((atoi(sv) > 0) ? makeCheck : "1", 14);
+    setParmVal(el, (atoi(sv) > 0) ? makeCheck : "1", 14);
 }
 #endif
 
@@ -2129,8 +3237,204 @@ static void strcpyutf8(char *dst, const char *src, unsigned int len)
     truncateUTF8(dst);
 }
 
+#ifdef TC_MQTT_TASK
+static void mqttTask(void *parm)
+{
+    bool wasConnected = false;
+    
+    mqttClient.setPubAckCallback(mqttPubAck);
+    
+    mqttReconnect(true);
+    
+    for(;;) {
+        mqttService();
+
+        bool isConnected = mqttClient.connected();
+
+        if(wasConnected && !isConnected) {
+            // Connection lost: Unacknowledged QoS 1 messages
+            // are sent anew (new id) after reconnection
+            for(int i = 0; i < mqttOutNum; i++) {
+                mqttOutbox[i].msgId = 0;
+            }
+        }
+        wasConnected = isConnected;
+
+        mqttOutboxFill();
+        mqttOutboxFlush();
+        
+        mqttIsConnected = isConnected;
+        
+        vTaskDelay(pdMS_TO_TICKS(MQTT_TASK_INT));
+    }
+}
+
+static void mqttOutboxRemove(int i)
+{
+    vRingbufferReturnItem(mqttOutBuf, mqttOutbox[i].item);
+    mqttOutNum--;
+    for( ; i < mqttOutNum; i++) {
+        mqttOutbox[i] = mqttOutbox[i + 1];
+    }
+}
+
+// Move new messages from ring buffer to outbox
+static void mqttOutboxFill()
+{
+    size_t size;
+    uint8_t *item;
+    
+    while(mqttOutNum < MQTT_OUTBOX &&
+          (item = (uint8_t *)xRingbufferReceive(mqttOutBuf, &size, 0))) {
+
+        if(item[0] & MQTT_PUB_COALESCE) {
+            // Last value wins: drop pending message on same topic
+            for(int i = 0; i < mqttOutNum; i++) {
+                if((mqttOutbox[i].item[0] & MQTT_PUB_COALESCE) && 
+                   !mqttOutbox[i].msgId &&
+                   !strcmp((char *)item + 1, (char *)mqttOutbox[i].item + 1)) {
+                    mqttOutboxRemove(i);
+                    break;
+                }
+            }
+        }
+
+        mqttOutMsg *m = &mqttOutbox[mqttOutNum++];
+        m->item = item;
+        m->size = size;
+        m->msgId = 0;
+        m->tries = 0;
+        m->fails = 0;
+        m->added = millis();
+    }
+}
+
+static void mqttOutboxFlush()
+{
+    unsigned long now = millis();
+    
+    for(int i = 0; i < mqttOutNum; ) {
+        mqttOutMsg *m = &mqttOutbox[i];
+        uint8_t flags = m->item[0];
+        char *topic = (char *)m->item + 1;
+        int hl = strlen(topic) + 2;
+        bool retain = !!(flags & MQTT_PUB_RETAIN);
+
+        if(!m->msgId && !m->tries && (now - m->added > MQTT_OUTBOX_AGE)) {
+            mqttOutboxRemove(i);
+            continue;
+        }
+
+        if(!mqttClient.connected())
+            break;
+
+        if(!(flags & MQTT_PUB_QOS1)) {
+            if(!mqttClient.publish(topic, m->item + hl, m->size - hl, retain)) {
+                if(++m->fails >= MQTT_PUB_FAILS) {
+                    mqttOutboxRemove(i);
+                    continue;
+                }
+                break;
+            }
+            mqttOutboxRemove(i);
+            continue;
+        }
+
+        if(!m->msgId || (now - m->sent > MQTT_QOS1_RETRY)) {
+            if(m->tries >= MQTT_QOS1_TRIES) {
+                mqttOutboxRemove(i);
+                continue;
+            }
+            bool dup = !!m->msgId;
+            if(!dup) m->msgId = mqttClient.newMsgId();
+            if(!mqttClient.publish(topic, m->item + hl, m->size - hl, retain, m->msgId, dup)) {
+                // Never sent: Back to unsent, so it ages out
+                if(!dup) m->msgId = 0;
+                if(++m->fails >= MQTT_PUB_FAILS) {
+                    mqttOutboxRemove(i);
+                    continue;
+                }
+                break;
+            }
+            m->fails = 0;
+            m->tries++;
+            m->sent = now;
+        }
+        
+        i++;
+    }
+}
+
+// Called from mqttClient.loop() in the task
+static void mqttPubAck(uint16_t msgId)
+{
+    for(int i = 0; i < mqttOutNum; i++) {
+        if(mqttOutbox[i].msgId == msgId) {
+            mqttOutboxRemove(i);
+            break;
+        }
+    }
+}
+#endif
+
+// audio_loop() belongs to the main loop
+static void mqttAudioLoop()
+{
+    #ifdef TC_MQTT_TASK
+    if(mqttTaskHandle) return;
+    #endif
+    audio_loop();
+}
+
+// Connection state machine, receiving; in the task, or 
+// from the main loop if there is no task
+static void mqttService()
+{
+    if(mqttClient.state() != MQTT_CONNECTING) {
+        if(!mqttClient.connected()) {
+            if(mqttOldState || mqttRestartPing) {
+                // Disconnection first detected:
+                mqttPingDone = mqttDoPing ? false : true;
+                mqttPingNow = mqttRestartPing ? millis() : 0;
+                mqttOldState = false;
+                mqttRestartPing = false;
+                mqttSubAttempted = false;
+            }
+            if(mqttDoPing && !mqttPingDone) {
+                mqttAudioLoop();
+                STALL_ENTER("mqttping");
+                mqttPing();
+                STALL_LEAVE();
+                mqttAudioLoop();
+            }
+            if(mqttPingDone) {
+                mqttAudioLoop();
+                STALL_ENTER("mqttconn");
+                mqttReconnect();
+                STALL_LEAVE();
+                mqttAudioLoop();
+            }
+        } else {
+            // Only call Subscribe() if connected
+            mqttSubscribe();
+            mqttOldState = true;
+        }
+    }
+    STALL_ENTER("mqttloop");
+    mqttClient.loop();
+    STALL_LEAVE();
+}
+
 static void mqttLooper()
 {
+    #ifdef TC_MQTT_TASK
+    if(mqttTaskHandle) {
+        // Called while waiting for the socket; 
+        // the main loop is not affected
+        vTaskDelay(1);
+        return;
+    }
+    #endif
     ntp_loop();
     audio_loop();
     #if defined(TC_HAVEGPS) || defined(TC_HAVE_RE)
@@ -2143,111 +3447,58 @@ static void mqttLooper()
 
 static void mqttCallback(char *topic, byte *payload, unsigned int length)
 {
-    int i = 0, j, ml = (length <= 255) ? length : 255;
-    char tempBuf[256];
-    static const char *cmdList[] = {
-      "TIMETRAVEL",       // 0
-      "RETURN",           // 1
-      "ALARM_ON",         // 2
-      "ALARM_OFF",        // 3
-      "NIGHTMODE_ON",     // 4
-      "NIGHTMODE_OFF",    // 5
-      "MP_SHUFFLE_ON",    // 6
-      "MP_SHUFFLE_OFF",   // 7
-      "MP_PLAY",          // 8
-      "MP_STOP",          // 9
-      "MP_NEXT",          // 10
-      "MP_PREV",          // 11
-      "BEEP_OFF",         // 12
-      "BEEP_ON",          // 13
-      "BEEP_30",          // 14
-      "BEEP_60",          // 15
-      NULL
-    };
-
+    bool isCmd;
+    
     if(!length) return;
 
     if(!strcmp(topic, "bttf/tcd/cmd")) {
+        isCmd = true;
+    } else if(!strcmp(topic, settings.mqttTopic)) {
+        isCmd = false;
+    } else {
+        return;
+    }
 
-        // Not taking commands under these circumstances:
-        if(!FPBUnitIsOn || menuActive   || startup || 
-           timeTravelP0 || timeTravelP1 || timeTravelRE)
-            return;
+    #ifdef TC_MQTT_TASK
+    if(mqttTaskHandle) {
+        // In task: Evaluate in main loop
+        mqttInMsg msg;
+        msg.kind = isCmd ? MQTT_MSG_CMD : MQTT_MSG_USER;
+        msg.len = (length <= 255) ? length : 255;
+        memcpy(msg.data, payload, msg.len);
+        xQueueSend(mqttInQueue, &msg, 0);
+        return;
+    }
+    #endif
 
-        memcpy(tempBuf, (const char *)payload, ml);
-        tempBuf[ml] = 0;
+    mqttEvalMsg(isCmd, payload, length);
+}
 
-        for(j = 0; j < ml; j++) {
-            if(tempBuf[j] >= 'a' && tempBuf[j] <= 'z') tempBuf[j] &= ~0x20;
-        }
+static void mqttEvalMsg(bool isCmd, const byte *payload, unsigned int length)
+{
+    int j, ml = (length <= 255) ? length : 255;
+    char tempBuf[256];
 
-        while(cmdList[i]) {
-            j = strlen(cmdList[i]);
-            if((ml >= j) && !strncmp((const char *)tempBuf, cmdList[i], j)) {
-                break;
-            }
-            i++;          
-        }
+    if(!length) return;
 
-        if(!cmdList[i]) return;
+    if(isCmd) {
 
-        switch(i) {
-        case 0:
-            #ifdef EXTERNAL_TIMETRAVEL_IN
-            isEttKeyPressed = isEttKeyImmediate = true;
-            #endif
-            break;
-        case 1:
-            #ifdef EXTERNAL_TIMETRAVEL_IN
-            isEttKeyHeld = true;
-            #endif
-            break;
-        case 2:
-            alarmOn();
-            break;
-        case 3:
-            alarmOff();
-            break;
-        case 4:
-            nightModeOn();
-            manualNightMode = 1;
-            manualNMNow = millis();
-            break;
-        case 5:
-            nightModeOff();
-            manualNightMode = 0;
-            manualNMNow = millis();
-            break;
-        case 6:
-        case 7:
-            if(haveMusic) mp_makeShuffle((i == 6));
-            break;
-        case 8:    
-            if(haveMusic) mp_play();
-            break;
-        case 9:
-            if(haveMusic) mp_stop();
-            break;
-        case 10:
-            if(haveMusic) mp_next(mpActive);
-            break;
-        case 11:
-            if(haveMusic) mp_prev(mpActive);
-            break;
-        case 12:
-        case 13:
-        case 14:
-        case 15:
-            setBeepMode(i-12);
-            break;
+        // Validation (busy state etc) is up to the registry
+        j = cmdExecName((const char *)payload, ml, CMDT_MQTT);
+
+        #ifdef TC_DBG
+        if(j != CMD_OK) {
+            Serial.printf("MQTT: Command rejected (%d)\n", j);
         }
-            
-    } else if(!strcmp(topic, settings.mqttTopic)) {
+        #endif
+
+    } else {
 
         memcpy(tempBuf, (const char *)payload, ml);
         tempBuf[ml] = 0;
 
         j = filterOutUTF8(tempBuf, mqttMsg);
+        destinationTime.renderStrip(&mqttStrip, mqttMsg);
         
         mqttIdx = 0;
         mqttMaxIdx = (j > DISP_LEN) ? j : -1;
@@ -2256,7 +3507,7 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
         mqttST = haveMQTTaudio;
     
         #ifdef TC_DBG
-        Serial.printf("MQTT: Message about [%s]: %s\n", topic, mqttMsg);
+        Serial.printf("MQTT: Message about [%s]: %s\n", settings.mqttTopic, mqttMsg);
         #endif
     }
 }
@@ -2376,13 +3627,132 @@ static void mqttSubscribe()
 
 bool mqttState()
 {
+    #ifdef TC_MQTT_TASK
+    if(mqttTaskHandle) {
+        return (useMQTT && mqttIsConnected);
+    }
+    #endif
     return (useMQTT && mqttClient.connected());
 }
 
-void mqttPublish(const char *topic, const char *pl, unsigned int len)
+// Publish sensor history upon SENSOR_HISTORY command: One message
+// per sensor and resolution to bttf/tcd/hist/<sensor>/<res>, payload
+// is a comma-separated list of values (oldest first; empty for 
+// periods without reading; temperatures scaled by 100).
+static void mqttPublishHistory()
+{
+    const char *names[NUM_HIST];
+    sensHistory *hists[NUM_HIST];
+    int scales[NUM_HIST];
+    const char *resNames[3] = { "sample", "minute", "hour" };
+    char topic[40];
+    char buf[448];
+    int num = getHistList(names, hists, scales);
+
+    for(int i = 0; i < num; i++) {
+        for(int j = SH_RES_SAMPLE; j <= SH_RES_HOUR; j++) {
+            sprintf(topic, "bttf/tcd/hist/%s/%s", names[i], resNames[j]);
+            int len = hists[i]->toText(j, buf, sizeof(buf), "");
+            mqttPublish(topic, buf, len, MQTT_PUB_COALESCE);
+            audio_loop();
+        }
+    }
+}
+
+// Publish BTTFN client list upon BTTFN_CLIENTS command to
+// bttf/tcd/bttfn; one line per client: id,type,ip,rtt
+// (rtt in ms, empty if unknown)
+static void mqttPublishClients()
+{
+    char buf[448];      // Must fit in MQTT buffer
+    int len = 0;
+    int num = bttfnNumClients();
+
+    for(int i = 0; i < num && len < (int)sizeof(buf) - 48; i++) {
+        char *id;
+        uint8_t *ip, type;
+        if(bttfnGetClientInfo(i, &id, &ip, &type)) {
+            int rtt = bttfnGetClientRTT(i);
+            len += sprintf(buf + len, "%.12s,%d,%d.%d.%d.%d,", id, type, ip[0], ip[1], ip[2], ip[3]);
+            if(rtt >= 0) len += sprintf(buf + len, "%d", rtt);
+            buf[len++] = '\n';
+        }
+    }
+
+    mqttPublish("bttf/tcd/bttfn", buf, len, MQTT_PUB_COALESCE);
+}
+
+// Publish memory statistics to bttf/tcd/mem, every MQTT_MEM_INT
+// and upon MEM_STATS command; key=value pairs (see tc_mem.cpp)
+static void mqttPublishMem()
+{
+    char buf[448];      // Must fit in MQTT buffer
+    int len = memStatsToText(buf, sizeof(buf));
+
+    mqttPublish("bttf/tcd/mem", buf, len, MQTT_PUB_COALESCE);
+}
+
+#ifdef TC_LOOPPROF
+// Publish loop timing to bttf/tcd/loop, along with the memory
+// statistics and upon LOOP_STATS command (see tc_prof.cpp)
+static void mqttPublishLoop()
+{
+    char buf[448];      // Must fit in MQTT buffer
+    int len = profStatsToText(buf, sizeof(buf));
+
+    if(len < (int)sizeof(buf) - 2) {
+        if(len) buf[len++] = ',';
+        len += schedStatsToText(buf + len, sizeof(buf) - len);
+        if(len && buf[len - 1] == ',') buf[--len] = 0;
+    }
+
+    mqttPublish("bttf/tcd/loop", buf, len, MQTT_PUB_COALESCE);
+}
+#endif
+
+// Request publishing from outside (commands); done 
+// from wifi_loop(), not from within the MQTT callback
+void mqttRequestPub(int what)
+{
+    switch(what) {
+    case MQTT_REQ_HIST:    mqttPubHist = true;  break;
+    case MQTT_REQ_CLIENTS: mqttPubCli = true;   break;
+    case MQTT_REQ_MEM:     mqttPubMem = true;   break;
+    case MQTT_REQ_LOOP:    mqttPubLoop = true;  break;
+    case MQTT_REQ_STALL:   mqttPubStall = true; break;
+    }
+}
+
+#ifdef TC_STALLMON
+// Publish the stall log to bttf/tcd/stalls, whenever a stall
+// has ended and upon STALL_STATS command (see tc_stall.cpp)
+static void mqttPublishStall()
+{
+    char buf[448];      // Must fit in MQTT buffer
+    int len = stallLogToText(buf, sizeof(buf), false);
+
+    mqttPublish("bttf/tcd/stalls", buf, len, MQTT_PUB_COALESCE);
+}
+#endif
+
+void mqttPublish(const char *topic, const char *pl, unsigned int len, uint8_t flags)
 {
     if(useMQTT) {
-        mqttClient.publish(topic, (uint8_t *)pl, len, false);
+        #ifdef TC_MQTT_TASK
+        if(mqttTaskHandle) {
+            // Never wait; drop if the buffer is full
+            int tl = strlen(topic) + 1;
+            void *item;
+            if(xRingbufferSendAcquire(mqttOutBuf, &item, 1 + tl + len, 0) == pdTRUE) {
+                *(uint8_t *)item = flags;
+                memcpy((char *)item + 1, topic, tl);
+                memcpy((char *)item + 1 + tl, pl, len);
+                xRingbufferSendComplete(mqttOutBuf, item);
+            }
+            return;
+        }
+        #endif
+        mqttClient.publish(topic, (uint8_t *)pl, len, !!(flags & MQTT_PUB_RETAIN));
     }
 }
 
@@ -70,11 +70,17 @@ extern bool pubMQTT;
 void wifi_setup();
 void wifi_loop();
 void wifiOn(unsigned long newDelay = 0, bool alsoInAPMode = false, bool deferConfigPortal = false);
-bool wifiOnWillBlock();
 void wifiStartCP();
+void wifiBootPoll();
+bool wifiIsConnecting();
+bool wifiGetNTPServerIP(IPAddress& ip);
 
 void updateConfigPortalValues();
 
+bool wifiPortalBusy();
+void wifiSetModemSleep(bool doSleep);
+void wifiGetMemStats(uint32_t& parmAllocs, uint32_t& pages, uint32_t& pageMinHeap, uint32_t& otaStack);
+
 int  wifi_getStatus();
 bool wifi_getIP(uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d);
 void wifi_getMAC(char *buf);
@@ -84,7 +90,18 @@ int16_t filterOutUTF8(char *src, char *dst, int srcLen, int maxChars);
 
 #ifdef TC_HAVEMQTT
 bool mqttState();
-void mqttPublish(const char *topic, const char *pl, unsigned int len);
+// Flags for mqttPublish()
+#define MQTT_PUB_COALESCE 0x01  // Replace a pending message on the same topic
+#define MQTT_PUB_QOS1     0x02  // Deliver at least once
+#define MQTT_PUB_RETAIN   0x04
+void mqttPublish(const char *topic, const char *pl, unsigned int len, uint8_t flags = 0);
+// What to publish for mqttRequestPub()
+#define MQTT_REQ_HIST     0     // bttf/tcd/sensors
+#define MQTT_REQ_CLIENTS  1     // bttf/tcd/bttfn
+#define MQTT_REQ_MEM      2     // bttf/tcd/mem
+#define MQTT_REQ_LOOP     3     // bttf/tcd/loop
+#define MQTT_REQ_STALL    4     // bttf/tcd/stalls
+void mqttRequestPub(int what);
 #endif
 
 #endif
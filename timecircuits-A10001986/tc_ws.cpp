@@ -0,0 +1,583 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * WebSocket event push
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tc_global.h"
+
+#ifdef TC_WEBSOCKET
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <mbedtls/version.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/base64.h>
+
+#include "clockdisplay.h"
+#include "tc_time.h"
+#include "tc_state.h"
+#include "tc_ws.h"
+
+#define WS_MAX_CLIENTS    3
+#define WS_TXBUF_SIZE     1536
+#define WS_RXBUF_SIZE     512     // Handshake request, control frames
+#define WS_HS_TIMEOUT     3000    // Max time for handshake
+#define WS_STALL_TIMEOUT  10000   // Drop client if it takes nothing for this long
+#define WS_PING_INT       25000
+#define WS_FRAME_INT      50      // Min interval between frames of a display
+#define WS_NUM_DISP       3
+
+#define WS_OP_TEXT        0x01
+#define WS_OP_CLOSE       0x08
+#define WS_OP_PING        0x09
+#define WS_OP_PONG        0x0a
+
+enum {
+    WSC_FREE = 0,
+    WSC_HS,         // Waiting for handshake request
+    WSC_OPEN
+};
+
+typedef struct {
+    WiFiClient    client;
+    uint8_t       state;
+    unsigned long since;        // Time of accept
+    unsigned long lastTx;       // Last progress in sending (or empty buffer)
+    unsigned long lastPing;
+    uint8_t       rx[WS_RXBUF_SIZE + 1];
+    uint16_t      rxLen;
+    uint8_t       tx[WS_TXBUF_SIZE];
+    uint16_t      txOff;
+    uint16_t      txLen;
+    // What this client was last sent
+    uint8_t       dSent;        // Bit per display
+    uint16_t      dSeq[WS_NUM_DISP];
+    bool          ttSent;
+    int           tt[4];
+    bool          cliSent;
+    uint16_t      cliGen;
+    uint32_t      lost;
+} wsClient;
+
+static const char wsGUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static WiFiServer wsServer(TC_WS_PORT, WS_MAX_CLIENTS);
+static bool       wsRunning = false;
+static wsClient   wsClients[WS_MAX_CLIENTS];
+static int        wsNumOpen = 0;
+
+static clockDisplay * const wsDisplays[WS_NUM_DISP] = {
+    &destinationTime, &presentTime, &departedTime
+};
+static unsigned long wsLastFrame[WS_NUM_DISP] = { 0 };
+static uint32_t      wsEvCursor = 0;
+
+static void wsDrop(wsClient *c)
+{
+    if(c->state == WSC_OPEN) wsNumOpen--;
+    c->client.stop();
+    c->state = WSC_FREE;
+
+    #ifdef TC_DBG
+    Serial.printf("WS: Client dropped, %d open\n", wsNumOpen);
+    #endif
+}
+
+static uint16_t wsTxFree(wsClient *c)
+{
+    return WS_TXBUF_SIZE - (c->txLen - c->txOff);
+}
+
+// Append to tx buffer; all or nothing
+static bool wsQueueRaw(wsClient *c, const uint8_t *hdr, int hlen, const void *data, int len)
+{
+    if(wsTxFree(c) < hlen + len)
+        return false;
+
+    if(c->txLen + hlen + len > WS_TXBUF_SIZE) {
+        memmove(c->tx, c->tx + c->txOff, c->txLen - c->txOff);
+        c->txLen -= c->txOff;
+        c->txOff = 0;
+    }
+
+    if(hlen) {
+        memcpy(c->tx + c->txLen, hdr, hlen);
+        c->txLen += hlen;
+    }
+    if(len) {
+        memcpy(c->tx + c->txLen, data, len);
+        c->txLen += len;
+    }
+
+    return true;
+}
+
+// Queue a frame (server frames are not masked)
+static bool wsQueue(wsClient *c, uint8_t opcode, const void *data, int len)
+{
+    uint8_t hdr[4];
+    int hlen = 2;
+
+    hdr[0] = 0x80 | opcode;
+    if(len < 126) {
+        hdr[1] = len;
+    } else {
+        hdr[1] = 126;
+        hdr[2] = len >> 8;
+        hdr[3] = len & 0xff;
+        hlen = 4;
+    }
+
+    return wsQueueRaw(c, hdr, hlen, data, len);
+}
+
+// Write as much as the socket takes without blocking
+static void wsFlush(wsClient *c, unsigned long now)
+{
+    int pending = c->txLen - c->txOff;
+
+    if(!pending) {
+        c->txOff = c->txLen = 0;
+        c->lastTx = now;
+        return;
+    }
+
+    int n = send(c->client.fd(), c->tx + c->txOff, pending, MSG_DONTWAIT);
+    if(n > 0) {
+        c->txOff += n;
+        c->lastTx = now;
+    } else if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        wsDrop(c);
+    } else if(now - c->lastTx > WS_STALL_TIMEOUT) {
+        wsDrop(c);
+    }
+}
+
+// Find header value in request; returns false if not present
+static bool wsGetHeader(const char *req, const char *name, char *out, int maxLen)
+{
+    int nlen = strlen(name);
+    const char *p = req;
+
+    while((p = strstr(p, "\r\n"))) {
+        p += 2;
+        if(!strncasecmp(p, name, nlen) && p[nlen] == ':') {
+            p += nlen + 1;
+            while(*p == ' ') p++;
+            int i = 0;
+            while(*p && *p != '\r' && *p != ' ' && i < maxLen - 1) {
+                out[i++] = *p++;
+            }
+            out[i] = 0;
+            return i > 0;
+        }
+    }
+
+    return false;
+}
+
+static void wsHandshake(wsClient *c, unsigned long now)
+{
+    char key[32], buf[64 + sizeof(wsGUID)];
+    uint8_t sha[20];
+    uint8_t acc[32];
+    size_t olen;
+    int n;
+
+    if(now - c->since > WS_HS_TIMEOUT) {
+        wsDrop(c);
+        return;
+    }
+    
+    if((n = c->client.available()) <= 0)
+        return;
+
+    if(n > WS_RXBUF_SIZE - c->rxLen) n = WS_RXBUF_SIZE - c->rxLen;
+    if((n = c->client.read(c->rx + c->rxLen, n)) > 0) {
+        c->rxLen += n;
+    }
+    c->rx[c->rxLen] = 0;
+
+    if(!strstr((char *)c->rx, "\r\n\r\n")) {
+        if(c->rxLen >= WS_RXBUF_SIZE) wsDrop(c);
+        return;
+    }
+
+    if(!wsGetHeader((char *)c->rx, "Sec-WebSocket-Key", key, sizeof(key))) {
+        static const char bad[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+        c->client.write(bad, sizeof(bad) - 1);
+        wsDrop(c);
+        return;
+    }
+
+    strcpy(buf, key);
+    strcat(buf, wsGUID);
+    #if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_sha1((const unsigned char *)buf, strlen(buf), sha);
+    #else
+    mbedtls_sha1_ret((const unsigned char *)buf, strlen(buf), sha);
+    #endif
+    mbedtls_base64_encode(acc, sizeof(acc) - 1, &olen, sha, sizeof(sha));
+    acc[olen] = 0;
+
+    n = snprintf((char *)c->rx, WS_RXBUF_SIZE,
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: %s\r\n\r\n", (char *)acc);
+    wsQueueRaw(c, NULL, 0, c->rx, n);
+
+    c->rxLen = 0;
+    c->state = WSC_OPEN;
+    c->lastPing = now;
+    c->dSent = 0;
+    c->ttSent = c->cliSent = false;
+    c->lost = 0;
+    wsNumOpen++;
+
+    #ifdef TC_DBG
+    Serial.printf("WS: Client connected, %d open\n", wsNumOpen);
+    #endif
+}
+
+// Handle incoming frames: Answer ping and close,
+// ignore everything else
+static void wsReceive(wsClient *c)
+{
+    int n;
+
+    while((n = c->client.available()) > 0) {
+
+        if(n > WS_RXBUF_SIZE - c->rxLen) n = WS_RXBUF_SIZE - c->rxLen;
+        if((n = c->client.read(c->rx + c->rxLen, n)) <= 0)
+            return;
+        c->rxLen += n;
+
+        for(;;) {
+            if(c->rxLen < 2)
+                break;
+
+            uint8_t  opcode = c->rx[0] & 0x0f;
+            uint32_t plen = c->rx[1] & 0x7f;
+            int      hlen = 2;
+
+            if(plen == 127) {
+                wsDrop(c);
+                return;
+            } else if(plen == 126) {
+                if(c->rxLen < 4)
+                    break;
+                plen = (c->rx[2] << 8) | c->rx[3];
+                hlen = 4;
+            }
+            if(c->rx[1] & 0x80) hlen += 4;
+
+            if(hlen + plen > WS_RXBUF_SIZE) {
+                wsDrop(c);
+                return;
+            }
+            if(c->rxLen < hlen + plen)
+                break;
+
+            uint8_t *pl = c->rx + hlen;
+            if(c->rx[1] & 0x80) {
+                uint8_t *mask = pl - 4;
+                for(uint32_t i = 0; i < plen; i++) {
+                    pl[i] ^= mask[i & 3];
+                }
+            }
+
+            switch(opcode) {
+            case WS_OP_CLOSE:
+                wsQueue(c, WS_OP_CLOSE, pl, plen > 2 ? 2 : plen);
+                send(c->client.fd(), c->tx + c->txOff, c->txLen - c->txOff, MSG_DONTWAIT);
+                wsDrop(c);
+                return;
+            case WS_OP_PING:
+                wsQueue(c, WS_OP_PONG, pl, plen);
+                break;
+            }
+
+            c->rxLen -= hlen + plen;
+            memmove(c->rx, c->rx + hlen + plen, c->rxLen);
+        }
+    }
+}
+
+// Client IDs come from the network: Replace anything that
+// would need escaping in a JSON string
+static void wsSafeId(char *out, const char *id)
+{
+    int i;
+
+    for(i = 0; i < 12 && id[i]; i++) {
+        out[i] = (id[i] < 0x20 || id[i] > 0x7e || id[i] == '"' || id[i] == '\\') ? '?' : id[i];
+    }
+    out[i] = 0;
+}
+
+static void wsPushState(wsClient *c, unsigned long now, const int *tt, uint16_t cliGen, const uint16_t *dSeq)
+{
+    char buf[160];
+    int len;
+
+    if(c->lost) {
+        len = snprintf(buf, sizeof(buf), "{\"ev\":\"lost\",\"n\":%u}", c->lost);
+        if(wsQueue(c, WS_OP_TEXT, buf, len)) c->lost = 0;
+    }
+
+    if(!c->ttSent || memcmp(c->tt, tt, sizeof(c->tt))) {
+        len = snprintf(buf, sizeof(buf), "{\"ev\":\"tt\",\"p0\":%d,\"p1\":%d,\"re\":%d,\"p2\":%d}",
+                        tt[0], tt[1], tt[2], tt[3]);
+        if(wsQueue(c, WS_OP_TEXT, buf, len)) {
+            memcpy(c->tt, tt, sizeof(c->tt));
+            c->ttSent = true;
+        }
+    }
+
+    if(!c->cliSent || c->cliGen != cliGen) {
+        char msg[48 + BTTFN_MAX_CLIENTS * 40];
+        char *id, safeId[13];
+        uint8_t *ip, type;
+        len = sprintf(msg, "{\"ev\":\"bttfn\",\"c\":[");
+        for(int i = 0; bttfnGetClientInfo(i, &id, &ip, &type); i++) {
+            wsSafeId(safeId, id);
+            len += sprintf(msg + len, "%s[\"%s\",%d,\"%d.%d.%d.%d\"]", i ? "," : "", 
+                        safeId, type, ip[0], ip[1], ip[2], ip[3]);
+        }
+        len += sprintf(msg + len, "]}");
+        if(wsQueue(c, WS_OP_TEXT, msg, len)) {
+            c->cliGen = cliGen;
+            c->cliSent = true;
+        }
+    }
+
+    // Frames give way to other events: Only queue if
+    // at least half of the buffer is free
+    for(int d = 0; d < WS_NUM_DISP; d++) {
+        if((c->dSent & (1 << d)) && c->dSeq[d] == dSeq[d])
+            continue;
+        if(now - wsLastFrame[d] < WS_FRAME_INT || wsTxFree(c) < WS_TXBUF_SIZE / 2)
+            continue;
+        uint16_t frame[CD_BUF_SIZE];
+        bool isOn;
+        uint8_t bri;
+        uint16_t seq = wsDisplays[d]->getLiveFrame(frame, isOn, bri);
+        len = sprintf(buf, "{\"ev\":\"disp\",\"d\":%d,\"on\":%d,\"bri\":%d,\"seg\":\"", d, isOn ? 1 : 0, bri);
+        for(int i = 0; i < CD_BUF_SIZE; i++) {
+            len += sprintf(buf + len, "%04x", frame[i]);
+        }
+        len += sprintf(buf + len, "\"}");
+        if(wsQueue(c, WS_OP_TEXT, buf, len)) {
+            c->dSeq[d] = seq;
+            c->dSent |= (1 << d);
+        }
+    }
+
+    if(now - c->lastPing > WS_PING_INT) {
+        if(wsQueue(c, WS_OP_PING, NULL, 0)) c->lastPing = now;
+    }
+}
+
+// Not state: If a client has no room, the event is dropped and counted
+static void wsBroadcast(const char *buf, int len)
+{
+    for(int i = 0; i < WS_MAX_CLIENTS; i++) {
+        wsClient *c = &wsClients[i];
+        if(c->state == WSC_OPEN) {
+            if(!wsQueue(c, WS_OP_TEXT, buf, len)) c->lost++;
+        }
+    }
+}
+
+void ws_begin()
+{
+    if(wsRunning)
+        return;
+
+    wsServer.begin();
+    wsServer.setNoDelay(true);
+    wsEvCursor = evSubscribe();
+    wsRunning = true;
+}
+
+void ws_stop()
+{
+    if(!wsRunning)
+        return;
+
+    for(int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if(wsClients[i].state != WSC_FREE) wsDrop(&wsClients[i]);
+    }
+    wsServer.end();
+    wsRunning = false;
+}
+
+void ws_loop()
+{
+    unsigned long now;
+    int tt[4];
+    uint16_t dSeq[WS_NUM_DISP];
+    uint16_t cliGen;
+    tcState st;
+    tcEvent ev;
+    char buf[32];
+    int len;
+
+    if(!wsRunning)
+        return;
+
+    now = millis();
+
+    if(wsServer.hasClient()) {
+        WiFiClient nc = wsServer.available();
+        int i;
+        for(i = 0; i < WS_MAX_CLIENTS; i++) {
+            if(wsClients[i].state == WSC_FREE) break;
+        }
+        if(i < WS_MAX_CLIENTS) {
+            wsClient *c = &wsClients[i];
+            c->client = nc;
+            c->client.setNoDelay(true);
+            c->state = WSC_HS;
+            c->since = c->lastTx = now;
+            c->rxLen = c->txOff = c->txLen = 0;
+        } else {
+            static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+            nc.write(busy, sizeof(busy) - 1);
+            nc.stop();
+        }
+    }
+
+    // Drain the event bus even without clients
+    while(evPoll(wsEvCursor, ev)) {
+        if(!wsNumOpen)
+            continue;
+        switch(ev.type) {
+        case EV_NIGHTMODE:
+            len = sprintf(buf, "{\"ev\":\"nm\",\"on\":%d}", ev.arg);
+            break;
+        case EV_POWER:
+            len = sprintf(buf, "{\"ev\":\"pwr\",\"on\":%d}", ev.arg);
+            break;
+        case EV_ALARM:
+            len = sprintf(buf, "{\"ev\":\"alarm\"}");
+            break;
+        default:
+            continue;
+        }
+        wsBroadcast(buf, len);
+    }
+
+    if(wsNumOpen) {
+        stateGet(st);
+        tt[0] = st.ttP0;
+        tt[1] = st.ttP1;
+        tt[2] = st.ttRE ? 1 : 0;
+        tt[3] = st.ttP2;
+        cliGen = bttfnClientsGen();
+        for(int d = 0; d < WS_NUM_DISP; d++) {
+            uint16_t frame[CD_BUF_SIZE];
+            bool isOn;
+            uint8_t bri;
+            dSeq[d] = wsDisplays[d]->getLiveFrame(frame, isOn, bri);
+        }
+    }
+
+    for(int i = 0; i < WS_MAX_CLIENTS; i++) {
+        wsClient *c = &wsClients[i];
+        switch(c->state) {
+        case WSC_HS:
+            wsHandshake(c, now);
+            break;
+        case WSC_OPEN:
+            if(!c->client.connected()) {
+                wsDrop(c);
+                break;
+            }
+            wsReceive(c);
+            if(c->state == WSC_OPEN) {
+                wsPushState(c, now, tt, cliGen, dSeq);
+            }
+            break;
+        }
+        if(c->state != WSC_FREE) {
+            wsFlush(c, now);
+        }
+    }
+
+    if(wsNumOpen) {
+        for(int d = 0; d < WS_NUM_DISP; d++) {
+            if(now - wsLastFrame[d] >= WS_FRAME_INT) wsLastFrame[d] = now;
+        }
+    }
+}
+
+int ws_numClients()
+{
+    return wsNumOpen;
+}
+
+// Keypad events are not state; if a client has no
+// room, they are dropped and counted.
+void wsKeyEvent(char key, char how)
+{
+    char buf[40];
+    int len;
+
+    if(!wsNumOpen)
+        return;
+
+    len = sprintf(buf, "{\"ev\":\"key\",\"k\":\"%c\",\"s\":\"%c\"}", key, how);
+
+    wsBroadcast(buf, len);
+}
+
+#endif  // TC_WEBSOCKET
@@ -0,0 +1,86 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Time Circuits Display
+ * (C) 2022-2025 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/Time-Circuits-Display
+ * https://tcd.out-a-ti.me
+ *
+ * WebSocket event push
+ *
+ * -------------------------------------------------------------------
+ * License: MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TC_WS_H
+#define _TC_WS_H
+
+/*
+ * WebSocket event push
+ *
+ * A minimal WebSocket server (RFC 6455, text frames only) on
+ * TC_WS_PORT. Connected browsers receive compact JSON events:
+ *
+ * {"ev":"disp","d":0,"on":1,"bri":15,"seg":"..."}  display frame
+ *     (d: 0=dest, 1=present, 2=departed; seg: 8 segment words in hex)
+ * {"ev":"tt","p0":0,"p1":2,"re":0,"p2":0}          time travel phase
+ * {"ev":"key","k":"5","s":"p"}                     keypad (p/h/r)
+ * {"ev":"nm","on":1}                               night mode
+ * {"ev":"pwr","on":0}                              fake power
+ * {"ev":"alarm"}                                   alarm fired
+ * {"ev":"bttfn","c":[["FLUX",1,"192.168.4.2"],..]} BTTFN clients
+ * {"ev":"lost","n":3}                              events dropped
+ *
+ * Display, time travel and BTTFN events carry state; if a slow
+ * client's buffer is full, they are coalesced and the newest
+ * state is sent when there is room again. Everything runs
+ * from the main loop, sockets are never written blocking.
+ */
+
+#define TC_WS_PORT  81
+
+void ws_begin();
+void ws_stop();
+void ws_loop();
+int  ws_numClients();
+
+void wsKeyEvent(char key, char how);
+
+#endif
@@ -1406,6 +1406,11 @@
 #include "tc_settings.h"
 #include "tc_time.h"
 #include "tc_wifi.h"
+#include "tc_mem.h"
+#include "tc_boot.h"
+#include "tc_prof.h"
+#include "tc_sched.h"
+#include "tc_stall.h"
 
 void setup()
 {
@@ -1420,26 +1425,40 @@ void setup()
     // PCF8574 only supports 100kHz, can't go to 400 here.
     // Also, speedo cable is usually quite long, play it safe.
     Wire.begin(-1, -1, 100000);
+    #ifdef TC_FASTBUS
+    // Displays, RTC and sensors on the second bus
+    Wire1.begin(FASTBUS_SDA_PIN, FASTBUS_SCL_PIN, 400000);
+    #endif
+    bootMark("i2c");
 
     time_boot();
+    bootMark("time_boot");
     settings_setup();
+    bootMark("settings");
+    // WiFi connects in the background from here
     wifi_setup();
+    bootMark("wifi_setup");
     audio_setup();
+    wifiBootPoll();
+    bootMark("audio");
     keypad_setup();
+    wifiBootPoll();
+    bootMark("keypad");
     time_setup();
+    bootMark("time_setup");
+    memBulkReport();
+    #ifdef TC_STALLMON
+    stall_setup();
+    #endif
 }
 
 
 void loop()
 {
-    keypad_loop();
-    audio_loop();
-    scanKeypad();
-    ntp_loop();
-    audio_loop();
-    time_loop();
-    audio_loop();
-    wifi_loop();
-    audio_loop();
-    bttfn_loop();
+    #ifdef TC_LOOPPROF
+    profLoop();
+    #endif
+    // keypad, scanKeypad, ntp, time, wifi, bttfn, mem, pwr;
+    // audio in between. See task table in tc_sched.cpp.
+    schedRun(SC_MAIN);
 }